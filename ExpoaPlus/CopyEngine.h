@@ -0,0 +1,899 @@
+// CopyEngine.h — background copy jobs for paste / drop (replaces SHFileOperationW(FO_COPY) on the UI thread)
+// - Queue: Enqueue() returns at once; jobs run one after another on the engine's thread
+// - Plan: the sources are walked (DirEnum.h) into directories + files with sizes; directories are
+//   created first, then small files are copied in parallel (WorkPool, ioThreads) while the engine
+//   thread copies the large ones (>= largeMin) one at a time
+// - Copying: Win32 CopyFileExW (large files COPY_FILE_RESTARTABLE, very large ones unbuffered);
+//   Linux FICLONE (reflink on btrfs / xfs) -> copy_file_range -> pread/pwrite with page-aligned
+//   buffers; times and mode are kept. Every file is written to "<target>.partial" and renamed, so
+//   the target name never holds a truncated copy (large files also sync before the rename).
+// - Conflicts (CopyConflict): skip, overwrite, overwrite older, keep both ("name (2).ext", reserved
+//   with an exclusive create so parallel copies cannot pick the same name), fail. A folder that
+//   exists is merged into (the policy applies per file), with keep both it gets a new name.
+//   A file is never copied onto itself; a folder is never copied into itself.
+// - Pause() / Resume() between buffers and files, Cancel(id) for the running or a queued job
+// - Journal (SetJournalDir): each job appends its description and finished files to a checksummed
+//   log. A job cut short by a crash or by Stop() is returned by Interrupted() and continues when it is
+//   enqueued again: finished files are skipped, a large file continues from its .partial if the
+//   source is unchanged, a file with a recorded start (large files, reserved "keep both" names) is
+//   copied again to the same target, and a target identical in size + mtime counts as copied (the
+//   record may not have been written). Completed or cancelled jobs delete their journal.
+// - verify: source and copy are hashed (HashFile, Fast128) afterwards; a mismatch removes the copy.
+//   The copy is usually still in the page cache, so this checks the copy path, not the medium.
+// Callbacks run on engine threads (marshal to the UI yourself).
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "DirEnum.h"
+#include "FileIndex.h"
+#include "Hashing.h"
+#include "WorkPool.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+#endif
+
+enum class CopyConflict : uint8_t { Skip, Overwrite, OverwriteOlder, KeepBoth, Fail };
+
+struct CopyOptions {
+    CopyConflict conflict = CopyConflict::KeepBoth;
+    unsigned ioThreads = 8;                   // small files in flight
+    uint64_t largeMin = 16ull << 20;          // from here: one at a time, .partial, resumable
+    size_t bufferSize = 4 << 20;              // per read / copy_file_range call of a large file
+    bool fastPath = true;                     // CopyFileExW / FICLONE / copy_file_range
+    bool verify = false;
+    bool includeHidden = true;
+    std::chrono::milliseconds progressInterval{ 100 };
+};
+
+struct CopyProgress {
+    uint64_t files = 0, filesDone = 0, skipped = 0, failed = 0;
+    uint64_t bytes = 0, bytesDone = 0;        // skipped files count as done
+    bool planning = true;
+    bool paused = false;
+};
+
+struct CopyFailure {
+    std::filesystem::path source, target;
+    std::string what;
+};
+
+struct CopyResult {
+    uint64_t id = 0;
+    bool cancelled = false;
+    CopyProgress totals;
+    std::vector<CopyFailure> failures;
+};
+
+struct CopyJob {
+    std::vector<std::filesystem::path> sources;
+    std::filesystem::path target;             // directory the sources are copied into
+    CopyOptions options;
+    std::function<void(const CopyProgress&)> onProgress;
+    std::function<void(const CopyResult&)> onDone;
+    std::filesystem::path journal;            // set by Interrupted(): continue that journal
+};
+
+class CopyEngine {
+public:
+    CopyEngine() = default;
+    CopyEngine(const CopyEngine&) = delete;
+    CopyEngine& operator=(const CopyEngine&) = delete;
+    ~CopyEngine() { Stop(); }
+
+    // Journals go to dir (created); empty = jobs are not resumable
+    void SetJournalDir(const std::filesystem::path& dir) {
+        std::error_code ec;
+        if (!dir.empty()) std::filesystem::create_directories(dir, ec);
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_journalDir = dir;
+    }
+
+    // Jobs whose journal was left behind (crash, Stop()); set callbacks and Enqueue() them to continue
+    std::vector<CopyJob> Interrupted() {
+        std::vector<CopyJob> jobs;
+        std::error_code ec;
+        std::filesystem::path dir;
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            dir = m_journalDir;
+        }
+        if (dir.empty()) return jobs;
+        for (auto const& e : std::filesystem::directory_iterator(dir, ec)) {
+            if (e.path().extension() != ".copyjob") continue;
+            {
+                std::lock_guard<std::mutex> lg(m_mutex);
+                if (m_journalsInUse.count(e.path().native())) continue;
+            }
+            CopyJob job;
+            JournalState state;
+            if (!ReadJournal(e.path(), job, state)) {
+                std::filesystem::remove(e.path(), ec);
+                continue;
+            }
+            job.journal = e.path();
+            jobs.push_back(std::move(job));
+        }
+        return jobs;
+    }
+
+    uint64_t Enqueue(CopyJob job) {
+        auto r = std::make_shared<Running>();
+        r->job = std::move(job);
+        std::lock_guard<std::mutex> lg(m_mutex);
+        r->id = ++m_nextId;
+        if (!r->job.journal.empty()) m_journalsInUse.insert(r->job.journal.native());
+        m_queue.push_back(r);
+        if (!m_thread.joinable()) {
+            m_stop = false;
+            m_thread = std::thread([this]() { Loop(); });
+        }
+        m_wake.notify_all();
+        return r->id;
+    }
+
+    // The running job stops after the current buffers; a queued one is reported as cancelled when it comes up
+    void Cancel(uint64_t id) {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        if (m_current && m_current->id == id) m_current->cancel.store(true);
+        for (auto& r : m_queue) if (r->id == id) r->cancel.store(true);
+        m_wake.notify_all();
+    }
+    void CancelAll() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        if (m_current) m_current->cancel.store(true);
+        for (auto& r : m_queue) r->cancel.store(true);
+        m_wake.notify_all();
+    }
+
+    void Pause() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_paused = true;
+    }
+    void Resume() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_paused = false;
+        m_wake.notify_all();
+    }
+    bool Stopping() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        return m_stop;
+    }
+    bool Paused() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        return m_paused;
+    }
+    size_t Pending() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        return m_queue.size() + (m_current ? 1 : 0);
+    }
+
+    // Stops the running job without deleting its journal (it stays resumable); queued jobs are dropped
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            m_stop = true;
+            if (m_current) m_current->cancel.store(true);
+            m_queue.clear();
+            m_wake.notify_all();
+        }
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+private:
+    struct Item {
+        std::filesystem::path source, target;
+        uint64_t size = 0, mtime = 0;
+        enum Kind : uint8_t { File, Dir, Link } kind = File;
+    };
+
+    struct JournalState {
+        std::unordered_set<IndexString> done;                 // sources copied (or skipped)
+        std::unordered_map<IndexString, IndexString> tops;    // top-level source -> chosen target
+        struct Started { IndexString target; uint64_t size, mtime; };
+        std::unordered_map<IndexString, Started> started;     // large files / reserved names begun
+    };
+
+    struct Running {
+        uint64_t id = 0;
+        CopyJob job;
+        std::atomic<bool> cancel{ false };
+        std::atomic<uint64_t> files{ 0 }, filesDone{ 0 }, skipped{ 0 }, failed{ 0 }, bytes{ 0 }, bytesDone{ 0 };
+        std::atomic<bool> planning{ true };
+        JournalState state;
+        bool resumed = false;
+        std::mutex mutex;                                     // failures, journal
+        std::vector<CopyFailure> failures;
+        std::ofstream journal;
+        std::vector<uint8_t> pending;                         // journal records not written yet
+        size_t pendingDone = 0;
+    };
+
+    enum class Outcome { Copied, Skipped, Journaled, Failed, Cancelled };
+
+    static constexpr uint32_t kJournalMagic = 0x4a435058;     // "XPCJ"
+    static constexpr uint8_t kOpJob = 1, kOpTop = 2, kOpStart = 3, kOpDone = 4;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::shared_ptr<Running>> m_queue;
+    std::shared_ptr<Running> m_current;
+    std::thread m_thread;
+    bool m_stop = false;
+    bool m_paused = false;
+    uint64_t m_nextId = 0;
+    std::filesystem::path m_journalDir;
+    std::unordered_set<IndexString> m_journalsInUse;
+
+    void Loop() {
+        for (;;) {
+            std::shared_ptr<Running> r;
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                m_wake.wait(lk, [this]() { return m_stop || !m_queue.empty(); });
+                if (m_stop) return;
+                r = m_queue.front();
+                m_queue.pop_front();
+                m_current = r;
+            }
+            CopyResult result = Run(*r);
+            bool keepJournal;
+            {
+                std::lock_guard<std::mutex> lg(m_mutex);
+                m_current.reset();
+                keepJournal = m_stop;                          // Stop(): resumable, cancel by the user: done with it
+                if (!r->job.journal.empty()) m_journalsInUse.erase(r->job.journal.native());
+            }
+            if (r->journal.is_open()) r->journal.close();
+            std::error_code ec;
+            if (!keepJournal && !r->job.journal.empty()) std::filesystem::remove(r->job.journal, ec);
+            if (r->job.onDone) r->job.onDone(result);
+        }
+    }
+
+    // Blocks while paused; false once the job is cancelled
+    bool Proceed(Running& r) {
+        if (r.cancel.load(std::memory_order_relaxed)) return false;
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_wake.wait(lk, [&]() { return !m_paused || r.cancel.load(); });
+        return !r.cancel.load();
+    }
+
+    CopyProgress Snapshot(Running& r) {
+        CopyProgress p;
+        p.files = r.files.load(); p.filesDone = r.filesDone.load(); p.skipped = r.skipped.load(); p.failed = r.failed.load();
+        p.bytes = r.bytes.load(); p.bytesDone = r.bytesDone.load(); p.planning = r.planning.load();
+        std::lock_guard<std::mutex> lg(m_mutex);
+        p.paused = m_paused;
+        return p;
+    }
+
+    CopyResult Run(Running& r) {
+        CopyResult result;
+        result.id = r.id;
+        const CopyOptions& opt = r.job.options;
+        if (r.cancel.load()) {
+            result.cancelled = true;
+            return result;
+        }
+        OpenJournal(r);
+
+        std::mutex reportMutex;
+        std::condition_variable reportCv;
+        bool finished = false;
+        std::thread reporter([&]() {
+            std::unique_lock<std::mutex> lk(reportMutex);
+            while (!finished) {
+                reportCv.wait_for(lk, opt.progressInterval);
+                if (!finished && r.job.onProgress) r.job.onProgress(Snapshot(r));
+            }
+        });
+
+        std::vector<Item> items = Plan(r);
+        r.planning.store(false);
+        std::vector<const Item*> large;
+        {
+            WorkPool pool(std::max(1u, opt.ioThreads));
+            for (auto const& it : items) {
+                if (!Proceed(r)) break;
+                if (it.kind == Item::Dir) {
+                    std::error_code ec;
+                    std::filesystem::create_directory(it.target, ec);
+                    if (ec && !std::filesystem::is_directory(it.target)) Fail(r, it, ec.message());
+                }
+                else if (it.kind == Item::File && it.size >= opt.largeMin) large.push_back(&it);
+                else pool.Submit([this, &r, &it]() { Finish(r, it, CopyItem(r, it, false)); });
+            }
+            for (const Item* it : large) {
+                if (!Proceed(r)) break;
+                Finish(r, *it, CopyItem(r, *it, true));
+            }
+            pool.WaitIdle();
+        }
+        FlushJournal(r);
+
+        {
+            std::lock_guard<std::mutex> lg(reportMutex);
+            finished = true;
+        }
+        reportCv.notify_all();
+        reporter.join();
+        result.cancelled = r.cancel.load();
+        result.totals = Snapshot(r);
+        std::lock_guard<std::mutex> lg(r.mutex);
+        result.failures = std::move(r.failures);
+        return result;
+    }
+
+    // ---- plan ----
+
+    static bool Within(const std::filesystem::path& inner, const std::filesystem::path& outer) {
+        std::error_code ec;
+        auto a = std::filesystem::weakly_canonical(inner, ec);
+        auto b = std::filesystem::weakly_canonical(outer, ec);
+        auto ai = a.begin(), bi = b.begin();
+        for (; bi != b.end(); ++ai, ++bi) {
+            if (bi->empty() && std::next(bi) == b.end()) break;  // trailing separator
+            if (ai == a.end() || *ai != *bi) return false;
+        }
+        return true;
+    }
+
+    static std::filesystem::path Numbered(const std::filesystem::path& p, int n, bool isDir) {
+        auto stem = isDir ? p.filename().native() : p.stem().native();
+        auto ext = isDir ? std::filesystem::path::string_type() : p.extension().native();
+        std::filesystem::path name(stem);
+        name += " (" + std::to_string(n) + ")";
+        name += ext;
+        return p.parent_path() / name;
+    }
+
+    std::vector<Item> Plan(Running& r) {
+        std::vector<Item> items;
+        const CopyOptions& opt = r.job.options;
+        for (auto const& src : r.job.sources) {
+            if (r.cancel.load()) break;
+            DirEntry st;
+            if (!StatEntry(src, st)) {
+                Fail(r, Item{ src, r.job.target / src.filename() }, "source not found");
+                continue;
+            }
+            Item top = MakeItem(src, r.job.target / src.filename(), st);
+            auto known = r.state.tops.find(src.native());
+            if (known != r.state.tops.end()) top.target = known->second;
+            else if (top.kind == Item::Dir) {
+                if (Within(r.job.target, src)) {
+                    Fail(r, top, "target is inside the source folder");
+                    continue;
+                }
+                DirEntry existing;
+                if (StatEntry(top.target, existing)) {
+                    // a folder is merged into an existing one (skip / fail then apply per file),
+                    // except with "keep both" (and never into itself)
+                    std::error_code ec;
+                    if (opt.conflict == CopyConflict::KeepBoth || std::filesystem::equivalent(src, top.target, ec)) {
+                        for (int n = 2; StatEntry(top.target = Numbered(r.job.target / src.filename(), n, true), existing); ++n) {}
+                    }
+                }
+                Journal(r, kOpTop, { src.native(), top.target.native() }, {}, true);
+            }
+            if (top.kind != Item::Dir) {
+                Count(r, top);
+                items.push_back(std::move(top));
+                continue;
+            }
+            items.push_back(top);
+            Walk(r, src, top.target, items);
+        }
+        return items;
+    }
+
+    static Item MakeItem(std::filesystem::path source, std::filesystem::path target, const DirEntry& e) {
+        Item it{ std::move(source), std::move(target), e.size, e.mtime, e.isDir ? Item::Dir : Item::File };
+#ifdef _WIN32
+        if (e.isDir && (e.attributes & FILE_ATTRIBUTE_REPARSE_POINT)) it.kind = Item::Link;  // junctions: not followed
+#else
+        if (S_ISLNK(e.attributes)) it.kind = Item::Link;
+#endif
+        if (it.kind != Item::File) it.size = 0;
+        return it;
+    }
+
+    void Count(Running& r, const Item& it) {
+        if (it.kind == Item::Dir) return;
+        r.files.fetch_add(1, std::memory_order_relaxed);
+        r.bytes.fetch_add(it.size, std::memory_order_relaxed);
+    }
+
+    // Depth first, so a directory always comes before its content
+    void Walk(Running& r, const std::filesystem::path& dir, const std::filesystem::path& target, std::vector<Item>& items) {
+        DirEnumOptions dopt;
+        dopt.includeHidden = r.job.options.includeHidden;
+        dopt.wantStat = true;
+        std::vector<DirEntry> entries;
+        if (!EnumerateDirectory(dir, dopt, r.cancel, [&](std::vector<DirEntry>&& batch) {
+                for (auto& e : batch) entries.push_back(std::move(e));
+            }) && !r.cancel.load())
+            Fail(r, Item{ dir, target }, "folder could not be read");
+        for (auto& e : entries) {
+            Item it = MakeItem(dir / e.name, target / e.name, e);
+            Count(r, it);
+            bool sub = it.kind == Item::Dir;
+            items.push_back(it);
+            if (sub) Walk(r, it.source, it.target, items);
+        }
+    }
+
+    // ---- copy ----
+
+    void Finish(Running& r, const Item& it, Outcome o) {
+        switch (o) {
+        case Outcome::Copied:
+            r.filesDone.fetch_add(1, std::memory_order_relaxed);
+            Journal(r, kOpDone, { it.source.native() }, {}, false);
+            break;
+        case Outcome::Skipped:
+            r.skipped.fetch_add(1, std::memory_order_relaxed);
+            r.bytesDone.fetch_add(it.size, std::memory_order_relaxed);
+            Journal(r, kOpDone, { it.source.native() }, {}, false);
+            break;
+        case Outcome::Journaled:                              // finished before the interruption
+            r.filesDone.fetch_add(1, std::memory_order_relaxed);
+            r.bytesDone.fetch_add(it.size, std::memory_order_relaxed);
+            break;
+        case Outcome::Failed:
+        case Outcome::Cancelled:
+            break;
+        }
+    }
+
+    void Fail(Running& r, const Item& it, std::string what) {
+        r.failed.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lg(r.mutex);
+        r.failures.push_back(CopyFailure{ it.source, it.target, std::move(what) });
+    }
+
+    Outcome CopyItem(Running& r, const Item& it, bool large) {
+        if (!Proceed(r)) return Outcome::Cancelled;
+        if (r.state.done.count(it.source.native())) return Outcome::Journaled;
+        if (it.kind == Item::Link) return CopyLink(r, it);
+        const CopyOptions& opt = r.job.options;
+
+        std::filesystem::path target = it.target;
+        uint64_t resumeAt = 0;
+        bool exclusive = false;
+        auto started = r.state.started.find(it.source.native());
+        if (started != r.state.started.end() && started->second.size == it.size && started->second.mtime == it.mtime) {
+            // begun before the interruption: same target again, whatever is there now is ours
+            target = started->second.target;
+            DirEntry part;
+            if (large && StatEntry(Partial(target), part)) resumeAt = std::min(part.size, it.size) / (1 << 20) * (1 << 20);
+        }
+        else {
+            DirEntry existing;
+            if (StatEntry(target, existing)) {
+                std::error_code ec;
+                bool same = std::filesystem::equivalent(it.source, target, ec);
+                if (r.resumed && !same && !existing.isDir && existing.size == it.size && existing.mtime == it.mtime)
+                    return Outcome::Skipped;                   // copied before the journal record was written
+                CopyConflict c = same && opt.conflict != CopyConflict::KeepBoth ? CopyConflict::Skip : opt.conflict;
+                switch (c) {
+                case CopyConflict::Skip: return Outcome::Skipped;
+                case CopyConflict::Fail: Fail(r, it, "target exists"); return Outcome::Failed;
+                case CopyConflict::OverwriteOlder: if (existing.mtime >= it.mtime) return Outcome::Skipped; break;
+                case CopyConflict::Overwrite: break;
+                case CopyConflict::KeepBoth: exclusive = true; break;
+                }
+                if (existing.isDir) {
+                    Fail(r, it, "a folder with this name exists");
+                    return Outcome::Failed;
+                }
+            }
+            if (exclusive && !Reserve(it.target, target)) {
+                Fail(r, it, "no free name");
+                return Outcome::Failed;
+            }
+            // large files: resume point; reserved names: a resumed job must not reserve another one
+            if (large || exclusive) Journal(r, kOpStart, { it.source.native(), target.native() }, { it.size, it.mtime }, large);
+        }
+
+        std::string error;
+        bool ok = large ? CopyLarge(r, it, target, resumeAt, error) : CopySmall(r, it, target, error);
+        if (ok && opt.verify && !Verify(r, it.source, target)) {
+            ok = false;
+            error = r.cancel.load() ? "" : "verification failed";
+            std::error_code ec;
+            std::filesystem::remove(target, ec);
+        }
+        if (!ok) {
+            // a small file's .partial is dropped; a large one keeps it when the job stays resumable.
+            // A reserved name is released unless the job resumes it.
+            bool cancelled = r.cancel.load(), keep = large && cancelled && Stopping();
+            std::error_code ec;
+            if (!keep) {
+                std::filesystem::remove(Partial(target), ec);
+                if (exclusive) std::filesystem::remove(target, ec);
+            }
+            if (cancelled) return Outcome::Cancelled;
+            Fail(r, it, error);
+            return Outcome::Failed;
+        }
+        if (!large) r.bytesDone.fetch_add(it.size, std::memory_order_relaxed);   // large files report per buffer
+        return Outcome::Copied;
+    }
+
+    static std::filesystem::path Partial(const std::filesystem::path& target) {
+        std::filesystem::path p = target;
+        p += ".partial";
+        return p;
+    }
+
+    // "name (n).ext" for the first n whose exclusive create succeeds; the empty file holds the name
+    static bool Reserve(const std::filesystem::path& wanted, std::filesystem::path& got) {
+        for (int n = 2; n < 10000; ++n) {
+            got = Numbered(wanted, n, false);
+#ifdef _WIN32
+            HANDLE h = CreateFileW(got.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (h != INVALID_HANDLE_VALUE) { CloseHandle(h); return true; }
+            if (GetLastError() != ERROR_FILE_EXISTS && GetLastError() != ERROR_ALREADY_EXISTS) return false;
+#else
+            int fd = ::open(got.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            if (fd >= 0) { ::close(fd); return true; }
+            if (errno != EEXIST) return false;
+#endif
+        }
+        return false;
+    }
+
+    bool Verify(Running& r, const std::filesystem::path& a, const std::filesystem::path& b) {
+        HashDigest da, db;
+        return HashFile(a, HashAlgo::Fast128, da, &r.cancel) && HashFile(b, HashAlgo::Fast128, db, &r.cancel) && da == db;
+    }
+
+    Outcome CopyLink(Running& r, const Item& it) {
+        std::error_code ec;
+#ifdef _WIN32
+        (void)r; (void)it;
+        return Outcome::Skipped;                               // junction / directory link: not followed
+#else
+        if (std::filesystem::symlink_status(it.target, ec).type() != std::filesystem::file_type::not_found) return Outcome::Skipped;
+        std::filesystem::copy_symlink(it.source, it.target, ec);
+        if (ec) {
+            Fail(r, it, ec.message());
+            return Outcome::Failed;
+        }
+        return Outcome::Copied;
+#endif
+    }
+
+#ifdef _WIN32
+    struct ProgressContext {
+        CopyEngine* engine;
+        Running* r;
+        bool report;                                          // large files count their bytes as they go
+        uint64_t reported;
+    };
+
+    static DWORD CALLBACK CopyProgressRoutine(LARGE_INTEGER, LARGE_INTEGER done, LARGE_INTEGER, LARGE_INTEGER, DWORD, DWORD,
+                                              HANDLE, HANDLE, LPVOID ctx) {
+        auto* c = (ProgressContext*)ctx;
+        uint64_t d = (uint64_t)done.QuadPart;
+        if (c->report && d > c->reported) c->r->bytesDone.fetch_add(d - c->reported, std::memory_order_relaxed);
+        c->reported = d;
+        return c->engine->Proceed(*c->r) ? PROGRESS_CONTINUE : PROGRESS_CANCEL;
+    }
+
+    static std::string Win32Error(DWORD e) { return "error " + std::to_string(e); }
+
+    bool CopySmall(Running& r, const Item& it, const std::filesystem::path& target, std::string& error) {
+        std::filesystem::path part = Partial(target);
+        bool ok;
+        if (r.job.options.fastPath) {
+            ProgressContext ctx{ this, &r, false, 0 };
+            ok = CopyFileExW(it.source.c_str(), part.c_str(), CopyProgressRoutine, &ctx, nullptr, 0) != 0;
+            if (!ok) error = Win32Error(GetLastError());
+        }
+        else ok = CopyBuffered(r, it, part, 0, false, error);
+        // replaces the file Reserve() may have created
+        if (ok && !MoveFileExW(part.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            error = Win32Error(GetLastError());
+            return false;
+        }
+        return ok;
+    }
+
+    bool CopyLarge(Running& r, const Item& it, const std::filesystem::path& target, uint64_t resumeAt, std::string& error) {
+        std::filesystem::path part = Partial(target);
+        bool ok;
+        if (r.job.options.fastPath) {
+            // RESTARTABLE: Windows keeps its own restart data in the partial file and reports the
+            // restarted part as transferred; unbuffered past 256 MB
+            ProgressContext ctx{ this, &r, true, 0 };
+            DWORD flags = COPY_FILE_RESTARTABLE | (it.size >= (256ull << 20) ? COPY_FILE_NO_BUFFERING : 0);
+            ok = CopyFileExW(it.source.c_str(), part.c_str(), CopyProgressRoutine, &ctx, nullptr, flags) != 0;
+            if (!ok) error = Win32Error(GetLastError());
+        }
+        else ok = CopyBuffered(r, it, part, resumeAt, true, error);
+        if (!ok) return false;
+        if (!MoveFileExW(part.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            error = Win32Error(GetLastError());
+            return false;
+        }
+        return true;
+    }
+
+    bool CopyBuffered(Running& r, const Item& it, const std::filesystem::path& target, uint64_t offset, bool large, std::string& error) {
+        HANDLE in = CreateFileW(it.source.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (in == INVALID_HANDLE_VALUE) { error = Win32Error(GetLastError()); return false; }
+        HANDLE out = CreateFileW(target.c_str(), GENERIC_WRITE, 0, nullptr, large ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (out == INVALID_HANDLE_VALUE) { error = Win32Error(GetLastError()); CloseHandle(in); return false; }
+        LARGE_INTEGER pos; pos.QuadPart = (LONGLONG)offset;
+        SetFilePointerEx(in, pos, nullptr, FILE_BEGIN);
+        SetFilePointerEx(out, pos, nullptr, FILE_BEGIN);
+        SetEndOfFile(out);
+        if (large) r.bytesDone.fetch_add(offset, std::memory_order_relaxed);
+        HashBuffer buf(BufferFor(r, it.size));
+        bool ok = true;
+        for (;;) {
+            if (!Proceed(r)) { ok = false; break; }
+            DWORD got = 0, put = 0;
+            if (!ReadFile(in, buf.Data(), (DWORD)buf.Size(), &got, nullptr)) { ok = false; error = Win32Error(GetLastError()); break; }
+            if (got == 0) break;
+            if (!WriteFile(out, buf.Data(), got, &put, nullptr) || put != got) { ok = false; error = Win32Error(GetLastError()); break; }
+            if (large) r.bytesDone.fetch_add(got, std::memory_order_relaxed);
+        }
+        if (ok) {
+            FILETIME mt;
+            mt.dwLowDateTime = (DWORD)it.mtime;
+            mt.dwHighDateTime = (DWORD)(it.mtime >> 32);
+            SetFileTime(out, nullptr, nullptr, &mt);
+        }
+        CloseHandle(in);
+        CloseHandle(out);
+        return ok;
+    }
+#else
+    static std::string Errno() { return std::strerror(errno); }
+
+    // in -> out from offset on; FICLONE (whole file only), copy_file_range, then read/write
+    bool CopyFd(Running& r, int in, int out, uint64_t size, uint64_t offset, bool large, std::string& error) {
+        const CopyOptions& opt = r.job.options;
+#ifdef FICLONE
+        if (opt.fastPath && offset == 0 && ioctl(out, FICLONE, in) == 0) {
+            if (large) r.bytesDone.fetch_add(size, std::memory_order_relaxed);
+            return true;
+        }
+#endif
+        bool range = opt.fastPath;
+        HashBuffer* buf = nullptr;
+        std::unique_ptr<HashBuffer> owned;
+        while (offset < size) {
+            if (!Proceed(r)) return false;
+            size_t want = (size_t)std::min<uint64_t>(large ? opt.bufferSize : size - offset, size - offset);
+#ifdef __linux__
+            if (range) {
+                loff_t inOff = (loff_t)offset, outOff = (loff_t)offset;
+                ssize_t n = copy_file_range(in, &inOff, out, &outOff, want, 0);
+                if (n > 0) {
+                    offset += (uint64_t)n;
+                    if (large) r.bytesDone.fetch_add((uint64_t)n, std::memory_order_relaxed);
+                    continue;
+                }
+                if (n == 0) break;                             // source shrank
+                if (errno == EINTR) continue;
+                if (errno != EXDEV && errno != ENOSYS && errno != EOPNOTSUPP && errno != EINVAL) { error = Errno(); return false; }
+                range = false;                                 // other file system / old kernel: plain reads
+            }
+#endif
+            if (!buf) {
+                owned = std::make_unique<HashBuffer>(BufferFor(r, size));
+                buf = owned.get();
+            }
+            want = std::min(want, buf->Size());
+            ssize_t got = ::pread(in, buf->Data(), want, (off_t)offset);
+            if (got < 0) { if (errno == EINTR) continue; error = Errno(); return false; }
+            if (got == 0) break;
+            for (ssize_t put = 0; put < got;) {
+                ssize_t n = ::pwrite(out, buf->Data() + put, (size_t)(got - put), (off_t)(offset + put));
+                if (n < 0) { if (errno == EINTR) continue; error = Errno(); return false; }
+                put += n;
+            }
+            offset += (uint64_t)got;
+            if (large) r.bytesDone.fetch_add((uint64_t)got, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    static void KeepMetadata(int in, int out) {
+        struct stat st {};
+        if (fstat(in, &st) != 0) return;
+        struct timespec times[2] = { st.st_atim, st.st_mtim };
+        futimens(out, times);
+        fchmod(out, st.st_mode & 07777);
+    }
+
+    bool CopySmall(Running& r, const Item& it, const std::filesystem::path& target, std::string& error) {
+        std::filesystem::path part = Partial(target);
+        int in = ::open(it.source.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) { error = Errno(); return false; }
+        int out = ::open(part.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (out < 0) { error = Errno(); ::close(in); return false; }
+        bool ok = CopyFd(r, in, out, it.size, 0, false, error);
+        if (ok) KeepMetadata(in, out);
+        ::close(in);
+        if (::close(out) != 0 && ok) { ok = false; error = Errno(); }
+        if (ok && ::rename(part.c_str(), target.c_str()) != 0) { ok = false; error = Errno(); }
+        return ok;
+    }
+
+    bool CopyLarge(Running& r, const Item& it, const std::filesystem::path& target, uint64_t resumeAt, std::string& error) {
+        std::filesystem::path part = Partial(target);
+        int in = ::open(it.source.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) { error = Errno(); return false; }
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        int out = ::open(part.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (resumeAt ? 0 : O_TRUNC), 0644);
+        if (out < 0) { error = Errno(); ::close(in); return false; }
+        if (resumeAt && ftruncate(out, (off_t)resumeAt) != 0) resumeAt = 0;
+        r.bytesDone.fetch_add(resumeAt, std::memory_order_relaxed);
+        bool ok = CopyFd(r, in, out, it.size, resumeAt, true, error);
+        if (ok) {
+            KeepMetadata(in, out);
+            if (fdatasync(out) != 0) { ok = false; error = Errno(); }   // contents on disk before the rename
+        }
+        ::close(in);
+        if (::close(out) != 0 && ok) { ok = false; error = Errno(); }
+        if (ok && ::rename(part.c_str(), target.c_str()) != 0) { ok = false; error = Errno(); }
+        return ok;
+    }
+#endif
+
+    size_t BufferFor(Running& r, uint64_t size) const {
+        uint64_t page = 4096, want = std::max<uint64_t>(page, (size + page - 1) / page * page);
+        return (size_t)std::min<uint64_t>(r.job.options.bufferSize, want);
+    }
+
+    // ---- journal ----
+    // Records: magic, payload length, IndexFnv of the payload, payload = op + strings (u32 length +
+    // native units) + u64 values. A torn tail is ignored; the job record comes first.
+
+    static void Pack(std::vector<uint8_t>& b, const void* p, size_t n) { b.insert(b.end(), (const uint8_t*)p, (const uint8_t*)p + n); }
+
+    void OpenJournal(Running& r) {
+        std::filesystem::path dir;
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            dir = m_journalDir;
+        }
+        if (!r.job.journal.empty()) {
+            CopyJob stored;
+            r.resumed = ReadJournal(r.job.journal, stored, r.state);
+            r.journal.open(r.job.journal, std::ios::binary | std::ios::app);
+            return;
+        }
+        if (dir.empty()) return;
+        auto stamp = std::chrono::system_clock::now().time_since_epoch().count();
+        r.job.journal = dir / (std::to_string(stamp) + "-" + std::to_string(r.id) + ".copyjob");
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            m_journalsInUse.insert(r.job.journal.native());
+        }
+        r.journal.open(r.job.journal, std::ios::binary | std::ios::trunc);
+        const CopyOptions& o = r.job.options;
+        std::vector<IndexString> strings{ r.job.target.native() };
+        for (auto const& s : r.job.sources) strings.push_back(s.native());
+        Journal(r, kOpJob, strings, { (uint64_t)o.conflict, o.largeMin, o.bufferSize, (uint64_t)o.ioThreads,
+                                      (uint64_t)o.verify | (uint64_t)o.fastPath << 1 | (uint64_t)o.includeHidden << 2 }, true);
+    }
+
+    void Journal(Running& r, uint8_t op, const std::vector<IndexString>& strings, const std::vector<uint64_t>& values, bool flush) {
+        if (!r.journal.is_open()) return;
+        std::vector<uint8_t> payload;
+        Pack(payload, &op, 1);
+        uint32_t count = (uint32_t)strings.size();
+        Pack(payload, &count, 4);
+        for (auto const& s : strings) {
+            uint32_t len = (uint32_t)s.size();
+            Pack(payload, &len, 4);
+            Pack(payload, s.data(), s.size() * sizeof(IndexChar));
+        }
+        for (uint64_t v : values) Pack(payload, &v, 8);
+        uint32_t size = (uint32_t)payload.size();
+        uint64_t sum = IndexFnv(payload.data(), payload.size());
+        std::lock_guard<std::mutex> lg(r.mutex);
+        Pack(r.pending, &kJournalMagic, 4);
+        Pack(r.pending, &size, 4);
+        Pack(r.pending, &sum, 8);
+        r.pending.insert(r.pending.end(), payload.begin(), payload.end());
+        if (op == kOpDone) r.pendingDone++;
+        if (flush || r.pendingDone >= 64) WriteJournal(r);
+    }
+
+    void FlushJournal(Running& r) {
+        std::lock_guard<std::mutex> lg(r.mutex);
+        WriteJournal(r);
+    }
+
+    // r.mutex held
+    static void WriteJournal(Running& r) {
+        if (!r.journal.is_open() || r.pending.empty()) return;
+        r.journal.write((const char*)r.pending.data(), (std::streamsize)r.pending.size());
+        r.journal.flush();
+        r.pending.clear();
+        r.pendingDone = 0;
+    }
+
+    static bool ReadJournal(const std::filesystem::path& path, CopyJob& job, JournalState& state) {
+        std::ifstream f(path, std::ios::binary);
+        if (!f) return false;
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        bool haveJob = false;
+        for (size_t pos = 0; data.size() - pos >= 16;) {
+            uint32_t magic, len;
+            uint64_t sum;
+            memcpy(&magic, &data[pos], 4);
+            memcpy(&len, &data[pos + 4], 4);
+            memcpy(&sum, &data[pos + 8], 8);
+            size_t p = pos + 16, end = p + len;
+            if (magic != kJournalMagic || data.size() - p < len || IndexFnv(data.data() + p, len) != sum) break;
+            pos = end;
+            auto get = [&](void* out, size_t n) { if (end - p < n) return false; memcpy(out, &data[p], n); p += n; return true; };
+            uint8_t op = 0;
+            uint32_t count = 0;
+            if (!get(&op, 1) || !get(&count, 4)) break;
+            std::vector<IndexString> strings;
+            bool ok = true;
+            for (uint32_t i = 0; ok && i < count; ++i) {
+                uint32_t n = 0;
+                ok = get(&n, 4) && (end - p) / sizeof(IndexChar) >= n;
+                if (!ok) break;
+                strings.emplace_back((const IndexChar*)&data[p], n);
+                p += (size_t)n * sizeof(IndexChar);
+            }
+            std::vector<uint64_t> values;
+            for (uint64_t v; ok && get(&v, 8);) values.push_back(v);
+            if (!ok) break;
+            if (op == kOpJob && strings.size() >= 1 && values.size() >= 5) {
+                job.target = strings[0];
+                job.sources.assign(strings.begin() + 1, strings.end());
+                job.options.conflict = (CopyConflict)values[0];
+                job.options.largeMin = values[1];
+                job.options.bufferSize = (size_t)values[2];
+                job.options.ioThreads = (unsigned)values[3];
+                job.options.verify = values[4] & 1;
+                job.options.fastPath = (values[4] >> 1) & 1;
+                job.options.includeHidden = (values[4] >> 2) & 1;
+                haveJob = true;
+            }
+            else if (op == kOpTop && strings.size() == 2) state.tops[strings[0]] = strings[1];
+            else if (op == kOpStart && strings.size() == 2 && values.size() == 2)
+                state.started[strings[0]] = JournalState::Started{ strings[1], values[0], values[1] };
+            else if (op == kOpDone && strings.size() == 1) state.done.insert(strings[0]);
+        }
+        return haveJob;
+    }
+};
@@ -0,0 +1,430 @@
+// DiskUsage.h — folder sizes below a root ("what takes the space"), parallel and cached
+// - Walk on a WorkPool (one task per directory, DirEnum.h); every directory becomes a node with the
+//   totals of its own files and, once all subdirectories are done, of its whole subtree
+//   (bytes, bytes on disk, files, directories); children are sorted by size, largest first
+// - Partial totals (whole run and per subfolder of the root) are handed to onProgress while the walk
+//   runs; the n largest files are collected on the way
+// - DiskUsageCache: per directory (keyed by path) its mtime, the totals of its own files, its
+//   subdirectory names and its largest files. A directory whose mtime is unchanged is not listed
+//   again, only its subdirectories are stat'ed. A file that changed size without anything being
+//   added / removed / renamed next to it is only seen with useCache = false.
+// - Bytes on disk: POSIX st_blocks; Win32 size rounded up to the cluster size, compressed / sparse
+//   files via GetCompressedFileSizeW. Links / junctions are not followed, hard links count per name.
+// - DiskUsageTreemap(): squarified treemap rectangles for a finished tree
+// One analysis per object; Run() blocks, call it on a background thread. Cancel() from any thread.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DirEnum.h"
+#include "Hashing.h"
+#include "WorkPool.h"
+
+struct DiskUsageTotals {
+    uint64_t bytes = 0;
+    uint64_t allocated = 0;                   // bytes on disk
+    uint64_t files = 0;
+    uint64_t dirs = 0;                        // subdirectories
+    uint64_t errors = 0;                      // directories that could not be read
+
+    void Add(const DiskUsageTotals& o) {
+        bytes += o.bytes; allocated += o.allocated; files += o.files; dirs += o.dirs; errors += o.errors;
+    }
+};
+
+struct DiskUsageDir {
+    DirString name;                           // the root: its full path
+    DiskUsageDir* parent = nullptr;
+    uint64_t mtime = 0;                       // same units as DirEntry::mtime
+    DiskUsageTotals own;                      // files directly inside (dirs = direct subdirectories)
+    DiskUsageTotals total;                    // own + every subdirectory; valid once the run has finished
+    bool error = false;
+    bool cached = false;                      // own files taken from the cache
+    std::vector<std::unique_ptr<DiskUsageDir>> children; // largest total first
+
+    std::filesystem::path Path() const {
+        return parent ? parent->Path() / name : std::filesystem::path(name);
+    }
+
+private:
+    friend class DiskUsage;
+    std::atomic<uint32_t> m_pending{ 0 };     // unfinished children + this directory's own listing
+    int32_t m_top = -1;                       // index of the root's subfolder this one is below
+};
+
+struct DiskUsageFile {
+    DirString path;
+    uint64_t size = 0, allocated = 0, mtime = 0;
+};
+
+struct DiskUsageOptions {
+    unsigned threads = 0;                     // 0 = hardware threads
+    bool includeHidden = true;                // hidden files take space too
+    bool useCache = true;                     // false: list every directory again (and refresh the cache)
+    size_t largestFiles = 50;
+    std::chrono::milliseconds progressInterval{ 100 };
+};
+
+struct DiskUsageProgress {
+    DiskUsageTotals totals;                   // so far
+    std::vector<std::pair<DirString, uint64_t>> top; // bytes so far per subfolder of the root (listing order)
+    uint64_t cachedDirs = 0;                  // directories not listed thanks to the cache
+    bool done = false;
+};
+
+// Directory listings of earlier runs; shared between runs and threads
+class DiskUsageCache {
+public:
+    struct File { DirString name; uint64_t size, allocated, mtime; };
+    struct Dir {
+        uint64_t mtime = 0;
+        DiskUsageTotals own;
+        std::vector<DirString> subdirs;
+        std::vector<File> largest;            // largest first; as many as the listing run kept (>= kLargest or all)
+    };
+    static constexpr size_t kLargest = 16;
+
+    std::shared_ptr<const Dir> Find(const std::filesystem::path& dir) const {
+        std::shared_lock<std::shared_mutex> lk(m_mutex);
+        auto it = m_dirs.find(Key(dir));
+        return it == m_dirs.end() ? nullptr : it->second;
+    }
+    void Put(const std::filesystem::path& dir, std::shared_ptr<const Dir> d) {
+        std::unique_lock<std::shared_mutex> lk(m_mutex);
+        m_dirs[Key(dir)] = std::move(d);
+    }
+    void Clear() {
+        std::unique_lock<std::shared_mutex> lk(m_mutex);
+        m_dirs.clear();
+    }
+    size_t Size() const {
+        std::shared_lock<std::shared_mutex> lk(m_mutex);
+        return m_dirs.size();
+    }
+
+private:
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<const Dir>> m_dirs;
+
+    static uint64_t Key(const std::filesystem::path& dir) {
+        auto const& s = dir.native();
+        return FastHash64(s.data(), s.size() * sizeof(s[0]));
+    }
+};
+
+class DiskUsage {
+public:
+    using ProgressFn = std::function<void(const DiskUsageProgress&)>;
+
+    void Cancel() { m_cancel.store(true); }
+    bool Cancelled() const { return m_cancel.load(); }
+
+    // Analyse root; nullptr if it cannot be read or the run was cancelled. onProgress calls never
+    // overlap; the last one has done = true.
+    std::unique_ptr<DiskUsageDir> Run(const std::filesystem::path& root, const DiskUsageOptions& opt,
+                                      const ProgressFn& onProgress = nullptr, DiskUsageCache* cache = nullptr) {
+        m_opt = &opt;
+        m_onProgress = &onProgress;
+        m_cache = cache;
+        m_lastReport = std::chrono::steady_clock::now();
+        DirEntry st;
+        if (!StatEntry(root, st) || !st.isDir) return nullptr;
+        auto tree = std::make_unique<DiskUsageDir>();
+        tree->name = root.native();
+        tree->mtime = st.mtime;
+#ifdef _WIN32
+        m_cluster = ClusterSize(root);
+#endif
+        {
+            WorkPool pool(opt.threads);
+            m_pool = &pool;
+            pool.Submit([this, t = tree.get(), root]() { Scan(t, root); });
+            pool.WaitIdle();
+            m_pool = nullptr;
+        }
+        if (m_cancel.load()) return nullptr;
+        std::sort(m_largest.begin(), m_largest.end(), [](const DiskUsageFile& a, const DiskUsageFile& b) { return a.size > b.size; });
+        Report(true);
+        return tree;
+    }
+
+    // The largest files of the last run, largest first
+    const std::vector<DiskUsageFile>& Largest() const { return m_largest; }
+
+private:
+    const DiskUsageOptions* m_opt = nullptr;
+    const ProgressFn* m_onProgress = nullptr;
+    DiskUsageCache* m_cache = nullptr;
+    WorkPool* m_pool = nullptr;
+    std::atomic<bool> m_cancel{ false };
+#ifdef _WIN32
+    uint64_t m_cluster = 4096;
+#endif
+
+    // partial totals
+    std::atomic<uint64_t> m_bytes{ 0 }, m_allocated{ 0 }, m_files{ 0 }, m_dirs{ 0 }, m_errors{ 0 }, m_cachedDirs{ 0 };
+    std::vector<DirString> m_topNames;        // written by the root's task before any child task starts
+    std::unique_ptr<std::atomic<uint64_t>[]> m_topBytes;
+    std::mutex m_reportMutex;
+    std::chrono::steady_clock::time_point m_lastReport;
+
+    // largest files: min-heap of m_opt->largestFiles entries
+    std::mutex m_largestMutex;
+    std::vector<DiskUsageFile> m_largest;
+    std::atomic<uint64_t> m_largestFloor{ 0 }; // smallest size still worth the lock
+
+    static bool Smaller(const DiskUsageCache::File& a, const DiskUsageCache::File& b) { return a.size > b.size; }
+
+    void Scan(DiskUsageDir* d, std::filesystem::path dir) {
+        std::vector<DirString> subdirs;
+        std::vector<uint64_t> subMtimes;
+        std::vector<DiskUsageCache::File> largest; // min-heap, at most max(largestFiles, kLargest)
+        size_t keep = std::max(m_opt->largestFiles, DiskUsageCache::kLargest);
+        auto consider = [&](DiskUsageCache::File&& f) {
+            if (largest.size() < keep) { largest.push_back(std::move(f)); std::push_heap(largest.begin(), largest.end(), Smaller); }
+            else if (f.size > largest.front().size) {
+                std::pop_heap(largest.begin(), largest.end(), Smaller);
+                largest.back() = std::move(f);
+                std::push_heap(largest.begin(), largest.end(), Smaller);
+            }
+        };
+
+        std::shared_ptr<const DiskUsageCache::Dir> hit;
+        if (m_cache && m_opt->useCache && !m_cancel.load()) {
+            hit = m_cache->Find(dir);
+            if (hit && hit->mtime != d->mtime) hit.reset();
+            if (hit && hit->largest.size() < keep && hit->largest.size() < hit->own.files) hit.reset(); // listed for fewer largest files
+        }
+        if (hit) {
+            // listing unchanged: own files from the cache, subdirectories need their current mtime
+            d->own = hit->own;
+            d->cached = true;
+            m_cachedDirs.fetch_add(1, std::memory_order_relaxed);
+            for (auto const& f : hit->largest) consider(DiskUsageCache::File(f));
+            for (auto const& name : hit->subdirs) {
+                DirEntry st;
+                if (!StatEntry(dir / name, st) || !st.isDir) continue;
+                subdirs.push_back(name);
+                subMtimes.push_back(st.mtime);
+            }
+            d->own.dirs = subdirs.size();
+        }
+        else if (!m_cancel.load()) {
+            DirEnumOptions dopt;
+            dopt.includeHidden = m_opt->includeHidden;
+            dopt.wantStat = true;
+            dopt.firstBatch = 4096;
+            dopt.batchSize = 4096;
+            dopt.flushInterval = std::chrono::milliseconds(1000);
+            bool ok = EnumerateDirectory(dir, dopt, m_cancel, [&](std::vector<DirEntry>&& batch) {
+                for (auto& e : batch) {
+                    if (e.isDir) {
+#ifdef _WIN32
+                        if (e.attributes & FILE_ATTRIBUTE_REPARSE_POINT) continue; // junctions: no cycles, no double counting
+#endif
+                        subdirs.push_back(std::move(e.name));
+                        subMtimes.push_back(e.mtime);
+                        continue;
+                    }
+                    uint64_t alloc = Allocated(dir, e);
+                    d->own.bytes += e.size;
+                    d->own.allocated += alloc;
+                    d->own.files++;
+                    consider(DiskUsageCache::File{ std::move(e.name), e.size, alloc, e.mtime });
+                }
+            });
+            d->own.dirs = subdirs.size();
+            if (!ok && !m_cancel.load()) { d->error = true; d->own.errors = 1; }
+            if (ok && m_cache) {
+                auto c = std::make_shared<DiskUsageCache::Dir>();
+                c->mtime = d->mtime;
+                c->own = d->own;
+                c->subdirs = subdirs;
+                c->largest = largest;
+                std::sort_heap(c->largest.begin(), c->largest.end(), Smaller);
+                m_cache->Put(dir, std::move(c));
+            }
+        }
+
+        // children exist before any of them is scanned; the root's become the progress groups
+        d->children.reserve(subdirs.size());
+        for (size_t i = 0; i < subdirs.size(); ++i) {
+            auto c = std::make_unique<DiskUsageDir>();
+            c->name = std::move(subdirs[i]);
+            c->parent = d;
+            c->mtime = subMtimes[i];
+            c->m_top = d->parent ? d->m_top : (int32_t)i;
+            d->children.push_back(std::move(c));
+        }
+        if (!d->parent) {
+            m_topBytes.reset(new std::atomic<uint64_t>[d->children.size()]());
+            for (auto const& c : d->children) m_topNames.push_back(c->name);
+        }
+        Count(d, largest, dir);
+
+        d->m_pending.store((uint32_t)d->children.size() + 1);
+        if (!m_cancel.load())
+            for (auto const& c : d->children) m_pool->Submit([this, c = c.get(), sub = dir / c->name]() { Scan(c, sub); });
+        Finished(d);
+        Report(false);
+    }
+
+    void Count(DiskUsageDir* d, std::vector<DiskUsageCache::File>& largest, const std::filesystem::path& dir) {
+        m_bytes.fetch_add(d->own.bytes, std::memory_order_relaxed);
+        m_allocated.fetch_add(d->own.allocated, std::memory_order_relaxed);
+        m_files.fetch_add(d->own.files, std::memory_order_relaxed);
+        m_dirs.fetch_add(d->own.dirs, std::memory_order_relaxed);
+        m_errors.fetch_add(d->own.errors, std::memory_order_relaxed);
+        if (d->m_top >= 0) m_topBytes[d->m_top].fetch_add(d->own.bytes, std::memory_order_relaxed);
+
+        size_t want = m_opt->largestFiles;
+        if (!want) return;
+        uint64_t floor = m_largestFloor.load(std::memory_order_relaxed);
+        bool any = false;
+        for (auto const& f : largest) any |= f.size > floor;
+        if (!any) return;
+        auto smaller = [](const DiskUsageFile& a, const DiskUsageFile& b) { return a.size > b.size; };
+        std::lock_guard<std::mutex> lg(m_largestMutex);
+        for (auto& f : largest) {
+            if (m_largest.size() >= want && f.size <= m_largest.front().size) continue;
+            DiskUsageFile g{ (dir / f.name).native(), f.size, f.allocated, f.mtime };
+            if (m_largest.size() < want) { m_largest.push_back(std::move(g)); std::push_heap(m_largest.begin(), m_largest.end(), smaller); }
+            else {
+                std::pop_heap(m_largest.begin(), m_largest.end(), smaller);
+                m_largest.back() = std::move(g);
+                std::push_heap(m_largest.begin(), m_largest.end(), smaller);
+            }
+        }
+        if (m_largest.size() >= want) m_largestFloor.store(m_largest.front().size, std::memory_order_relaxed);
+    }
+
+    // One part of d is done (its listing or a child); the last one closes d and moves up
+    void Finished(DiskUsageDir* d) {
+        while (d && d->m_pending.fetch_sub(1) == 1) {
+            d->total = d->own;
+            for (auto const& c : d->children) d->total.Add(c->total);
+            std::sort(d->children.begin(), d->children.end(),
+                      [](const std::unique_ptr<DiskUsageDir>& a, const std::unique_ptr<DiskUsageDir>& b) { return a->total.bytes > b->total.bytes; });
+            d = d->parent;
+        }
+    }
+
+    uint64_t Allocated(const std::filesystem::path& dir, const DirEntry& e) const {
+#ifdef _WIN32
+        if (e.attributes & (FILE_ATTRIBUTE_COMPRESSED | FILE_ATTRIBUTE_SPARSE_FILE)) {
+            DWORD high = 0;
+            DWORD low = GetCompressedFileSizeW((dir / e.name).c_str(), &high);
+            if (low != INVALID_FILE_SIZE || GetLastError() == NO_ERROR) return (uint64_t)high << 32 | low;
+        }
+        return (e.size + m_cluster - 1) / m_cluster * m_cluster;
+#else
+        (void)dir;
+        return e.allocated;
+#endif
+    }
+
+#ifdef _WIN32
+    static uint64_t ClusterSize(const std::filesystem::path& root) {
+        wchar_t volume[MAX_PATH];
+        DWORD sectorsPerCluster = 0, bytesPerSector = 0, freeClusters = 0, clusters = 0;
+        if (!GetVolumePathNameW(root.c_str(), volume, MAX_PATH) ||
+            !GetDiskFreeSpaceW(volume, &sectorsPerCluster, &bytesPerSector, &freeClusters, &clusters) || !sectorsPerCluster)
+            return 4096;
+        return (uint64_t)sectorsPerCluster * bytesPerSector;
+    }
+#endif
+
+    void Report(bool done) {
+        if (!*m_onProgress) return;
+        std::unique_lock<std::mutex> lk(m_reportMutex, std::defer_lock);
+        if (done) lk.lock();
+        else if (!lk.try_lock()) return;      // someone else is reporting (m_lastReport is under the lock)
+        auto now = std::chrono::steady_clock::now();
+        if (!done && now - m_lastReport < m_opt->progressInterval) return;
+        m_lastReport = now;
+        DiskUsageProgress p;
+        p.totals.bytes = m_bytes.load();
+        p.totals.allocated = m_allocated.load();
+        p.totals.files = m_files.load();
+        p.totals.dirs = m_dirs.load();
+        p.totals.errors = m_errors.load();
+        p.cachedDirs = m_cachedDirs.load();
+        p.done = done;
+        if (m_topBytes)
+            for (size_t i = 0; i < m_topNames.size(); ++i) p.top.emplace_back(m_topNames[i], m_topBytes[i].load());
+        (*m_onProgress)(p);
+    }
+};
+
+// ---- treemap ----
+
+struct DiskUsageRect {
+    const DiskUsageDir* dir = nullptr;        // the folder; ownFiles: the files directly inside it
+    bool ownFiles = false;
+    int depth = 0;                            // 0 = children of the node passed in
+    double x = 0, y = 0, w = 0, h = 0;
+};
+
+// Squarified treemap (Bruls, Huizing, van Wijk) of node's subtree in the rectangle x/y/w/h: per
+// level its subfolders plus one block for its own files, nested down to maxDepth levels; blocks
+// whose shorter side is below minSide are not subdivided further.
+inline void DiskUsageTreemap(const DiskUsageDir& node, double x, double y, double w, double h, int maxDepth, double minSide,
+                             std::vector<DiskUsageRect>& out, int depth = 0) {
+    struct Item { const DiskUsageDir* dir; bool own; double area; };
+    std::vector<Item> items;
+    double total = (double)node.total.bytes;
+    if (total <= 0 || w <= 0 || h <= 0) return;
+    double scale = w * h / total;
+    for (auto const& c : node.children) if (c->total.bytes) items.push_back(Item{ c.get(), false, c->total.bytes * scale });
+    if (node.own.bytes) items.push_back(Item{ &node, true, node.own.bytes * scale });
+    std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.area > b.area; });
+
+    // worst aspect ratio of a row with the given area sum / extremes laid along a side of length side
+    auto worst = [](double sum, double mn, double mx, double side) {
+        double s2 = sum * sum, w2 = side * side;
+        return std::max(w2 * mx / s2, s2 / (w2 * mn));
+    };
+    size_t i = 0;
+    while (i < items.size()) {
+        double side = std::min(w, h);
+        size_t end = i;
+        double sum = 0, mn = 0, mx = 0;
+        while (end < items.size()) {
+            double a = items[end].area;
+            double nsum = sum + a, nmn = end == i ? a : std::min(mn, a), nmx = end == i ? a : std::max(mx, a);
+            if (end > i && worst(nsum, nmn, nmx, side) > worst(sum, mn, mx, side)) break;
+            sum = nsum; mn = nmn; mx = nmx;
+            ++end;
+        }
+        // lay the row along the shorter side, then shrink the free rectangle
+        double thick = side > 0 ? sum / side : 0;
+        double pos = 0;
+        for (size_t k = i; k < end; ++k) {
+            double len = thick > 0 ? items[k].area / thick : 0;
+            DiskUsageRect r;
+            r.dir = items[k].dir;
+            r.ownFiles = items[k].own;
+            r.depth = depth;
+            if (w >= h) { r.x = x; r.y = y + pos; r.w = thick; r.h = len; }
+            else { r.x = x + pos; r.y = y; r.w = len; r.h = thick; }
+            pos += len;
+            out.push_back(r);
+            if (!r.ownFiles && depth + 1 < maxDepth && std::min(r.w, r.h) >= minSide)
+                DiskUsageTreemap(*r.dir, r.x, r.y, r.w, r.h, maxDepth, minSide, out, depth + 1);
+        }
+        if (w >= h) { x += thick; w -= thick; }
+        else { y += thick; h -= thick; }
+        i = end;
+    }
+}
@@ -0,0 +1,363 @@
+// DuplicateFinder.h — finds files with identical content, reading as little as possible
+//   1. walk (WorkPool, DirEnum.h): bucket files by size; a size seen once cannot have a duplicate
+//   2. sample: hash the first and last sampleBytes of every file in a bucket (for small files this
+//      is the whole content); files with a unique sample drop out
+//   3. full: hash the survivors completely, or take a cached digest (e.g. from FileIndex) when the
+//      caller still trusts it for this size + mtime
+//   4. optional: byte-for-byte comparison inside each group
+// - Every stage fans out per file on one pool (ioThreads); the last file of a bucket to finish
+//   regroups it and schedules the next stage, so buckets move through the stages independently
+//   and groups are reported (onGroup, serialized) as soon as they are confirmed
+// - Cancel() stops reading; groups already reported stay valid
+// - Symlinks / reparse points are skipped; hard links to one file are reported as duplicates
+// Run() blocks; call it on a background thread.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "DirEnum.h"
+#include "FileIndex.h"
+#include "Hashing.h"
+#include "WorkPool.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+struct DupFile {
+    IndexString path;
+    uint64_t size = 0;
+    uint64_t mtime = 0;             // DirEnum units
+};
+
+struct DupGroup {
+    uint64_t size = 0;
+    std::vector<IndexString> paths; // sorted
+    uint64_t Wasted() const { return paths.empty() ? 0 : size * (paths.size() - 1); }
+};
+
+struct DupOptions {
+    uint64_t minSize = 1;           // empty files are all "equal" and usually not interesting
+    size_t sampleBytes = 4096;      // read from head and tail each
+    unsigned walkThreads = 0;       // 0 = hardware threads
+    unsigned ioThreads = 4;         // sample / full / verify reads
+    bool verifyBytes = false;       // compare contents after equal full hashes
+    bool includeHidden = true;
+    std::chrono::milliseconds progressInterval{ 250 };
+};
+
+struct DupProgress {
+    uint64_t files = 0;             // found by the walk
+    uint64_t sizeCandidates = 0;    // share their size with another file
+    uint64_t sampled = 0;
+    uint64_t fullCandidates = 0;    // share size + sample
+    uint64_t fullHashed = 0;
+    uint64_t cachedDigests = 0;     // full hash taken from the cache instead of reading
+    uint64_t bytesRead = 0;
+    uint64_t groups = 0;
+    uint64_t wastedBytes = 0;
+    bool walkDone = false;
+};
+
+struct DupStages {
+    // Full-content digest of a file; false = unreadable. Default: FastHash128 over the content.
+    // Not called for files of at most 2 * sampleBytes (the sample already covers them).
+    std::function<bool(const DupFile&, HashDigest&, const std::atomic<bool>& cancel)> fullHash;
+    // Digest known without reading (same algorithm as fullHash); false = unknown or stale
+    std::function<bool(const DupFile&, HashDigest&)> cachedHash;
+    std::function<void(DupGroup&&)> onGroup;
+    std::function<void(const DupProgress&)> onProgress;
+};
+
+class DuplicateFinder {
+public:
+    void Cancel() { m_cancel.store(true); }
+    bool Cancelled() const { return m_cancel.load(); }
+
+    // Returns false if cancelled.
+    bool Run(const std::vector<std::filesystem::path>& roots, const DupOptions& opt, const DupStages& stages) {
+        m_cancel.store(false);
+        m_opt = opt;
+        m_stages = stages;
+        m_c.Reset();
+
+        std::mutex progressMutex;
+        std::condition_variable progressCv;
+        bool finished = false;
+        std::thread reporter([&]() {
+            std::unique_lock<std::mutex> lk(progressMutex);
+            while (!finished) {
+                progressCv.wait_for(lk, opt.progressInterval);
+                if (stages.onProgress) stages.onProgress(m_c.Snapshot());
+            }
+        });
+
+        std::unordered_map<uint64_t, std::vector<DupFile>> bySize = Walk(roots);
+        m_c.walkDone.store(true);
+
+        // largest sizes first: they hold most of the wasted space
+        std::vector<std::shared_ptr<Bucket>> buckets;
+        for (auto& kv : bySize) {
+            if (kv.second.size() < 2) continue;
+            auto b = std::make_shared<Bucket>();
+            b->size = kv.first;
+            b->files = std::move(kv.second);
+            m_c.sizeCandidates.fetch_add(b->files.size(), std::memory_order_relaxed);
+            buckets.push_back(std::move(b));
+        }
+        bySize.clear();
+        std::sort(buckets.begin(), buckets.end(), [](auto const& a, auto const& b) { return a->size > b->size; });
+        {
+            WorkPool pool(std::max(1u, opt.ioThreads));
+            m_pool = &pool;
+            for (auto& b : buckets) Sample(b);
+            pool.WaitIdle();
+            m_pool = nullptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> lg(progressMutex);
+            finished = true;
+        }
+        progressCv.notify_all();
+        reporter.join();
+        if (stages.onProgress) stages.onProgress(m_c.Snapshot());
+        return !m_cancel.load();
+    }
+
+private:
+    // A set of files that are still indistinguishable; the last task to finish moves it on.
+    struct Bucket {
+        uint64_t size = 0;
+        std::vector<DupFile> files;
+        std::vector<HashDigest> keys;
+        std::vector<uint8_t> ok;
+        std::atomic<size_t> left{ 0 };
+        bool wholeContent = false;  // keys cover every byte of the files
+    };
+    using BucketPtr = std::shared_ptr<Bucket>;
+
+    struct Counters {
+        std::atomic<uint64_t> files{ 0 }, sizeCandidates{ 0 }, sampled{ 0 }, fullCandidates{ 0 }, fullHashed{ 0 },
+            cachedDigests{ 0 }, bytesRead{ 0 }, groups{ 0 }, wastedBytes{ 0 };
+        std::atomic<bool> walkDone{ false };
+        void Reset() {
+            files = 0; sizeCandidates = 0; sampled = 0; fullCandidates = 0; fullHashed = 0;
+            cachedDigests = 0; bytesRead = 0; groups = 0; wastedBytes = 0; walkDone = false;
+        }
+        DupProgress Snapshot() const {
+            DupProgress p;
+            p.files = files.load(); p.sizeCandidates = sizeCandidates.load(); p.sampled = sampled.load();
+            p.fullCandidates = fullCandidates.load(); p.fullHashed = fullHashed.load(); p.cachedDigests = cachedDigests.load();
+            p.bytesRead = bytesRead.load(); p.groups = groups.load(); p.wastedBytes = wastedBytes.load();
+            p.walkDone = walkDone.load();
+            return p;
+        }
+    };
+
+    std::atomic<bool> m_cancel{ false };
+    DupOptions m_opt;
+    DupStages m_stages;
+    Counters m_c;
+    WorkPool* m_pool = nullptr;
+    std::mutex m_emitMutex;
+
+    std::unordered_map<uint64_t, std::vector<DupFile>> Walk(const std::vector<std::filesystem::path>& roots) {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, std::vector<DupFile>> bySize;
+        WorkPool pool(m_opt.walkThreads);
+        DirEnumOptions dopt;
+        dopt.includeHidden = m_opt.includeHidden;
+        dopt.wantStat = true;
+        std::function<void(std::filesystem::path)> walk = [&](std::filesystem::path dir) {
+            if (m_cancel.load()) return;
+            std::vector<DupFile> found;
+            EnumerateDirectory(dir, dopt, m_cancel, [&](std::vector<DirEntry>&& batch) {
+                for (auto& d : batch) {
+#ifdef _WIN32
+                    if (d.attributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+#else
+                    if (S_ISLNK(d.attributes)) continue;
+#endif
+                    if (d.isDir) {
+                        pool.Submit([&walk, sub = dir / d.name]() { walk(sub); });
+                        continue;
+                    }
+                    if (d.size < m_opt.minSize) continue;
+                    found.push_back(DupFile{ (dir / d.name).native(), d.size, d.mtime });
+                }
+            });
+            m_c.files.fetch_add(found.size(), std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lg(mutex);
+            for (auto& f : found) bySize[f.size].push_back(std::move(f));
+        };
+        for (auto const& r : roots) pool.Submit([&walk, r]() { walk(r); });
+        pool.WaitIdle();
+        return bySize;
+    }
+
+    // Run fn(i) for every file of b on the pool, then next(b) once all are done
+    void ForEachFile(const BucketPtr& b, void (DuplicateFinder::*fn)(Bucket&, size_t), void (DuplicateFinder::*next)(const BucketPtr&)) {
+        b->keys.assign(b->files.size(), HashDigest());
+        b->ok.assign(b->files.size(), 0);
+        b->left.store(b->files.size());
+        for (size_t i = 0; i < b->files.size(); ++i) {
+            m_pool->Submit([this, b, i, fn, next]() {
+                if (!m_cancel.load()) (this->*fn)(*b, i);
+                if (b->left.fetch_sub(1) == 1 && !m_cancel.load()) (this->*next)(b);
+            });
+        }
+    }
+
+    void Sample(const BucketPtr& b) {
+        b->wholeContent = b->size <= 2 * (uint64_t)m_opt.sampleBytes;
+        ForEachFile(b, &DuplicateFinder::SampleOne, &DuplicateFinder::AfterSample);
+    }
+
+    void SampleOne(Bucket& b, size_t i) {
+        HashReader r;
+        if (!r.Open(b.files[i].path)) return;
+        size_t n = (size_t)std::min<uint64_t>(b.size, 2 * (uint64_t)m_opt.sampleBytes);
+        std::vector<uint8_t> buf(n);
+        size_t head = b.wholeContent ? n : m_opt.sampleBytes;
+        int64_t got = r.ReadAt(0, buf.data(), head);
+        if (got != (int64_t)head) return;                       // shrank since the walk
+        if (!b.wholeContent) {
+            got = r.ReadAt(b.size - m_opt.sampleBytes, buf.data() + head, m_opt.sampleBytes);
+            if (got != (int64_t)m_opt.sampleBytes) return;
+        }
+        FastHash128 h(b.size);
+        h.Update(buf.data(), buf.size());
+        b.keys[i] = h.Final();
+        b.ok[i] = 1;
+        m_c.sampled.fetch_add(1, std::memory_order_relaxed);
+        m_c.bytesRead.fetch_add(buf.size(), std::memory_order_relaxed);
+    }
+
+    void AfterSample(const BucketPtr& b) {
+        for (auto& g : Split(*b)) {
+            if (b->wholeContent) { Confirm(g); continue; } // the sample was the whole file
+            m_c.fullCandidates.fetch_add(g->files.size(), std::memory_order_relaxed);
+            ForEachFile(g, &DuplicateFinder::FullOne, &DuplicateFinder::AfterFull);
+        }
+    }
+
+    void FullOne(Bucket& b, size_t i) {
+        const DupFile& f = b.files[i];
+        if (m_stages.cachedHash && m_stages.cachedHash(f, b.keys[i])) {
+            m_c.cachedDigests.fetch_add(1, std::memory_order_relaxed);
+            b.ok[i] = 1;
+            return;
+        }
+        bool ok;
+        if (m_stages.fullHash) {
+            ok = m_stages.fullHash(f, b.keys[i], m_cancel);
+            if (ok) m_c.bytesRead.fetch_add(f.size, std::memory_order_relaxed);
+        }
+        else {
+            uint64_t read = 0;
+            ok = HashFile(f.path, HashAlgo::Fast128, b.keys[i], &m_cancel, HashFileOptions(), &read);
+            m_c.bytesRead.fetch_add(read, std::memory_order_relaxed);
+        }
+        if (!ok) return;
+        b.ok[i] = 1;
+        m_c.fullHashed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void AfterFull(const BucketPtr& b) {
+        for (auto& g : Split(*b)) Confirm(g);
+    }
+
+    // Groups of >= 2 files with equal keys (unreadable files drop out)
+    std::vector<BucketPtr> Split(const Bucket& b) {
+        std::map<HashDigest, std::vector<size_t>> groups;
+        for (size_t i = 0; i < b.files.size(); ++i) if (b.ok[i]) groups[b.keys[i]].push_back(i);
+        std::vector<BucketPtr> out;
+        for (auto& kv : groups) {
+            if (kv.second.size() < 2) continue;
+            auto g = std::make_shared<Bucket>();
+            g->size = b.size;
+            g->wholeContent = b.wholeContent;
+            for (size_t i : kv.second) g->files.push_back(b.files[i]);
+            out.push_back(std::move(g));
+        }
+        return out;
+    }
+
+    void Confirm(const BucketPtr& g) {
+        if (!m_opt.verifyBytes) { Emit(*g, std::vector<size_t>(g->files.size(), 0)); return; }
+        std::vector<size_t> cls;
+        if (!Compare(*g, cls)) return;
+        Emit(*g, cls);
+    }
+
+    // Byte comparison: cls[i] = index of the first file with the same content as file i
+    bool Compare(const Bucket& g, std::vector<size_t>& cls) {
+        size_t n = g.files.size();
+        std::vector<std::unique_ptr<HashReader>> readers(n);
+        std::vector<uint8_t> alive(n, 1);
+        for (size_t i = 0; i < n; ++i) {
+            readers[i] = std::make_unique<HashReader>();
+            if (!readers[i]->Open(g.files[i].path)) alive[i] = 0;
+        }
+        cls.assign(n, 0);
+        const size_t block = 256 * 1024;
+        std::vector<std::vector<uint8_t>> bufs(n, std::vector<uint8_t>(block));
+        for (uint64_t off = 0; off < g.size; off += block) {
+            if (m_cancel.load()) return false;
+            size_t want = (size_t)std::min<uint64_t>(block, g.size - off);
+            for (size_t i = 0; i < n; ++i) {
+                if (!alive[i]) continue;
+                if (readers[i]->ReadAt(off, bufs[i].data(), want) != (int64_t)want) { alive[i] = 0; continue; }
+                m_c.bytesRead.fetch_add(want, std::memory_order_relaxed);
+            }
+            // classes only split: file i joins the first new representative of its old class with equal bytes
+            std::vector<size_t> old = cls;
+            bool shared = false;
+            for (size_t i = 0; i < n; ++i) {
+                if (!alive[i]) continue;
+                cls[i] = i;
+                for (size_t j = 0; j < i; ++j) {
+                    if (alive[j] && cls[j] == j && old[j] == old[i] && memcmp(bufs[i].data(), bufs[j].data(), want) == 0) {
+                        cls[i] = j;
+                        shared = true;
+                        break;
+                    }
+                }
+            }
+            if (!shared) return false;                          // every file differs from the others
+        }
+        for (size_t i = 0; i < n; ++i) if (!alive[i]) cls[i] = SIZE_MAX;
+        return true;
+    }
+
+    void Emit(const Bucket& g, const std::vector<size_t>& cls) {
+        std::map<size_t, DupGroup> byClass;
+        for (size_t i = 0; i < g.files.size(); ++i) {
+            if (cls[i] == SIZE_MAX) continue;
+            DupGroup& out = byClass[cls[i]];
+            out.size = g.size;
+            out.paths.push_back(g.files[i].path);
+        }
+        for (auto& kv : byClass) {
+            DupGroup& out = kv.second;
+            if (out.paths.size() < 2) continue;
+            std::sort(out.paths.begin(), out.paths.end());
+            m_c.groups.fetch_add(1, std::memory_order_relaxed);
+            m_c.wastedBytes.fetch_add(out.Wasted(), std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lg(m_emitMutex);
+            if (m_stages.onGroup) m_stages.onGroup(std::move(out));
+        }
+    }
+};
@@ -20,7 +20,6 @@
 #include <winrt/Windows.UI.Xaml.Media.Imaging.h>
 #include <sstream>
 #include <iomanip>
-#include <wincrypt.h>
 #include <unordered_map>
 #include <set>
 #include <locale>
@@ -29,6 +28,33 @@
 #include <atomic>
 #include <condition_variable>
 #include <map>
+#include <numeric>
+#include <winrt/Microsoft.UI.Dispatching.h>
+#include <winrt/Microsoft.UI.Xaml.Markup.h>
+#include <winrt/Microsoft.UI.Xaml.Media.Imaging.h>
+#include <psapi.h>
+#include <wincodec.h>
+#include "CopyEngine.h"
+#include "DirEnum.h"
+#include "DiskUsage.h"
+#include "DuplicateFinder.h"
+#include "FileIndex.h"
+#include "IndexPipeline.h"
+#include "IndexSync.h"
+#include "ListingStore.h"
+#include "FsWatcher.h"
+#include "FullTextIndex.h"
+#include "FuzzySearch.h"
+#include "Hashing.h"
+#include "ParallelSearch.h"
+#include "RenamePlanner.h"
+#include "SearchSession.h"
+#include "SemanticIndex.h"
+#include "SortKeys.h"
+#include "TagExtractor.h"
+#include "ThumbnailCache.h"
+#include "ThumbnailScheduler.h"
+#include "VirtualItemSource.h"
 
 using namespace winrt;
 using namespace Microsoft::UI::Xaml;
@@ -36,13 +62,13 @@ using namespace Microsoft::UI::Xaml::Controls;
 using namespace Windows::ApplicationModel::DataTransfer;
 using namespace Windows::Storage;
 
+// Ein einzelnes Item zum Weiterreichen (Vorschau, Umbenennen, Thumbnail); Listen liegen spaltenweise im ListingStore
 struct FileItem {
     std::wstring name;
     std::wstring fullPath;
     bool isFolder;
     ULONGLONG size;
     FILETIME modifiedTime;
-    winrt::com_ptr<IShellItemImageFactory> imageFactory;
 };
 
 struct ExplorerFinal : ApplicationT<ExplorerFinal>
@@ -52,8 +78,17 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
     GridView m_fileGrid{ nullptr };
     TextBox m_addressBar{ nullptr };
     TextBox m_searchBox{ nullptr };
-    std::vector<FileItem> currentItems;
-    std::vector<FileItem> filteredItems;
+    ListingStore currentItems;             // Ordnerinhalt: Namen im Arena-Puffer, Ordner einmal, Spalten (ListingStore.h)
+    ListingStore filteredItems;            // Ergebnisse der rekursiven Suche (nicht in currentItems)
+    // Grid-Ansicht: Position -> Index in ViewSource(); nur diese Reihenfolge ändert sich bei Sortierung/Filter
+    std::vector<uint32_t> m_view;
+    bool m_viewRecursive = false;          // m_view indiziert filteredItems statt currentItems
+    bool m_viewRanked = false;             // m_view in Trefferreihenfolge (Fuzzy über den Index); Spaltenklick sortiert wieder
+    SortKeyTable m_itemKeys;               // Sortierschlüssel zu currentItems / filteredItems (wachsen mit, SortKeys.h)
+    SortKeyTable m_filteredKeys;
+    winrt::com_ptr<IndexItemSource> m_itemsSource;
+    std::chrono::steady_clock::time_point m_populateStart;
+    bool m_firstPaintLogged = true;
     bool sortAscending = true;
     int sortColumn = 0; // 0=Name,1=Type,2=Size,3=Date
     std::vector<std::wstring> favorites;
@@ -78,7 +113,6 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
     Button m_openTerminalButton{ nullptr };
     ToggleButton m_toggleHiddenButton{ nullptr };
     bool m_showHidden = false;
-    std::vector<std::wstring> searchHistory;
 
     // Neue UI / Funktionalitäts-Erweiterungen (zusätzlich)
     Button m_duplicateButton{ nullptr };
@@ -92,35 +126,92 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
     Button m_findDuplicatesButton{ nullptr };
     Button m_summarizeButton{ nullptr };
     ToggleButton m_useFuzzyToggle{ nullptr };
+    ToggleButton m_contentSearchToggle{ nullptr };
 
     // Indexer / AI infrastructure
-    std::thread m_indexThread;
+    std::thread m_indexThread; // BuildIndex; vor dem nächsten Lauf und beim Schließen (nach StopIndexing) gejoint
     std::atomic<bool> m_indexRunning{ false };
     std::mutex m_indexMutex;
     std::condition_variable m_indexCv;
-    std::map<std::wstring, Json::Value> m_index; // path -> metadata
+    IndexPipeline m_indexPipeline; // Walk -> Hash -> Tags (IndexPipeline.h); StopIndexing bricht ab
+    FileIndex m_index; // path -> Größe, Änderungszeit, Hash, Tags (index.bin + index.log, FileIndex.h)
+    IndexSync m_indexSync{ m_index, m_indexMutex }; // nur geänderte Dateien neu lesen (IndexSync.h)
+    FullTextIndex m_fullText; // Volltext über Dateiinhalte (fulltext\, FullTextIndex.h); eigene Sperren
+    SemanticIndex m_semantic; // Ähnlichkeitssuche über Name, Ordner, Textanfang (semantic.bin, SemanticIndex.h)
+    std::thread m_semanticThread; // Build() nach dem Laden; m_semantic.Close() bricht ihn ab, danach gejoint
+    FsWatcher m_fsWatcher; // hält den Index nach einem Lauf über Änderungsmeldungen aktuell
+    // Unscharfe Namenssuche über den ganzen Index (FuzzySearch.h); nach Pfadänderungen im Hintergrund neu gebaut
+    std::shared_ptr<const FuzzyIndex> m_fuzzyIndex; // nur UI-Thread
+    uint64_t m_fuzzyGeneration = ~0ull;             // PathGeneration() von m_index beim Aufbau
+    bool m_fuzzyBuilding = false;                   // nur UI-Thread
+    std::thread m_fuzzyThread;                      // Aufbau; vor dem nächsten und beim Schließen gejoint
+    WorkPool m_fuzzyPool;                           // teilt volle Scans einer Suche auf
+    // Rekursive Suche ohne Index (ParallelSearch.h): Treffer kommen batchweise über m_uiQueue
+    std::shared_ptr<ParallelSearch> m_recursiveSearch; // nur UI-Thread
+    std::thread m_recursiveSearchThread;               // vor der nächsten Suche und beim Schließen abgebrochen + gejoint
+    uint64_t m_searchGeneration = 0;                   // nur UI-Thread: Batches abgebrochener Suchen verwerfen
+    std::shared_ptr<std::atomic<bool>> m_contentSearch; // nur UI-Thread: Abbruch der laufenden Inhaltssuche
+    std::thread m_contentSearchThread;                  // Query() auf m_fullText; vor m_fullText.Close() gejoint
+    // Suchen beim Tippen (SearchSession.h): entprellt, eingrenzen statt neu suchen, Verlauf nur bei Enter / Suchen
+    SearchSession m_search;
+    Microsoft::UI::Dispatching::DispatcherQueueTimer m_searchTimer{ nullptr };
+    SliceFilter m_searchFilter;                        // filtert scheibchenweise, dazwischen kommt die UI dran
+    NameMatcher<wchar_t> m_searchFilterMatcher;
+    uint64_t m_searchFilterId = 0;                     // 0 = kein Filter aktiv
+    bool m_searchFilterRecursive = false, m_searchFilterSort = false, m_searchFilterComplete = false;
+    std::vector<std::wstring> m_searchExclude{ L".git", L"node_modules", L"$RECYCLE.BIN", L"System Volume Information" };
     ProgressBar m_progressBar{ nullptr };
     Button m_indexButton{ nullptr };
     Button m_semanticSearchButton{ nullptr };
     Button m_autoCategorizeButton{ nullptr };
     Button m_autoRenameAllButton{ nullptr };
     Button m_undoButton{ nullptr };
-    std::vector<std::tuple<std::wstring,std::wstring,std::wstring>> m_undoStack; // (type, src, dst): type="rename" etc.
+    struct UndoAction {
+        std::wstring type, src, dst;          // type="rename", "create" etc.
+        std::vector<RenameOp> renames;        // type="renames": eine Batch-Umbenennung, rückgängig als Ganzes
+    };
+    std::vector<UndoAction> m_undoStack;
+    RenamePlanner m_renamer; // Batch-Umbenennungen als Transaktion, Journal im Ordner renames
+    std::thread m_renamePlanThread, m_renameThread; // Planen / Ausführen; eine laufende Umbenennung wird zu Ende geführt
 
     std::wstring m_settingsPath;
     Json::Value m_settings;
 
     // Zusätzliche Member: Thumbnail-Cache, Settings, Buttons
-    std::unordered_map<std::wstring, winrt::Windows::UI::Xaml::Media::Imaging::BitmapImage> m_thumbnailCache;
+    // Thumbnails (ThumbnailCache.h): dekodierte Bitmaps im Speicher-LRU (nur UI-Thread), PNGs im Disk-Cache
+    ThumbnailLru<Media::Imaging::BitmapImage> m_thumbMemory;
+    ThumbnailDiskStore m_thumbDisk;
+    std::once_flag m_thumbDiskOnce;
+    unsigned int m_thumbMemoryMB = 64;
+    unsigned int m_thumbDiskMB = 512;
+    // Decode-Aufträge (ThumbnailScheduler.h): sichtbare Positionen zuerst; Position -> Ticket zum Abbrechen
+    ThumbnailScheduler m_thumbScheduler;
+    std::unordered_map<uint32_t, uint64_t> m_thumbTickets;
+    int32_t m_thumbFirstVisible = -1, m_thumbLastVisible = -1;
     unsigned int m_thumbnailSize = 128;
     int m_fuzzyThreshold = 3;
     Button m_settingsButton{ nullptr };
 
+    // Verzeichnis-Enumeration im Hintergrund (DirEnum.h); Batches werden über m_uiQueue angehängt
+    Microsoft::UI::Dispatching::DispatcherQueue m_uiQueue{ nullptr };
+    DirEnumerator m_dirEnum;
+    uint64_t m_enumGeneration = 0; // nur UI-Thread: veraltete Batches nach Navigation verwerfen
+    // Größenanalyse (DiskUsage.h): Ordnerlisten früherer Läufe, gültig solange sich die mtime nicht ändert
+    DiskUsageCache m_diskUsageCache;
+    std::shared_ptr<DiskUsage> m_diskUsage; // nur UI-Thread: laufende Analyse, zum Abbrechen
+    std::thread m_diskUsageThread;          // vor der nächsten Analyse und beim Schließen abgebrochen + gejoint
+    // Duplikatsuche (DuplicateFinder.h): die Stufen schreiben Hashes in m_index und melden über m_uiQueue
+    std::shared_ptr<DuplicateFinder> m_dupFinder; // nur UI-Thread: laufende Suche, zum Abbrechen
+    std::thread m_dupThread;                      // vor der nächsten Suche und beim Schließen abgebrochen + gejoint
+    // Kopieren (CopyEngine.h): Einfügen und Drop laufen als Aufträge im Hintergrund, Journal im Ordner copyjobs
+    CopyEngine m_copyEngine;
+    ToggleMenuFlyoutItem m_copyVerifyItem{ nullptr };
+    bool m_copyVerify = false; // Kopien nach dem Schreiben mit der Quelle vergleichen (Einstellung copyVerify)
+
     // Neue Methoden/Prototypen
     void UpdateBreadcrumb(std::wstring const& path);
     fire_and_forget ShowPreview(FileItem const& fi);
     void FileSelectionChanged(IInspectable const&, SelectionChangedEventArgs const&);
-    void RecursiveSearch(std::wstring const& path, std::wstring const& filter, std::vector<FileItem>& outItems);
     fire_and_forget BatchRename(IInspectable const&, RoutedEventArgs const&);
     fire_and_forget AnalyzeSizes(IInspectable const&, RoutedEventArgs const&);
     void LoadRecent();
@@ -140,18 +231,54 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
     void InvertSelection(IInspectable const&, RoutedEventArgs const&);
     void ToggleDetails(IInspectable const&, RoutedEventArgs const&);
     void SuggestRename(IInspectable const&, RoutedEventArgs const&);
-    void FindDuplicates(IInspectable const&, RoutedEventArgs const&);
     fire_and_forget SummarizeSelected(IInspectable const&, RoutedEventArgs const&);
-    std::vector<std::wstring> ExtractTagsFromTextFile(std::wstring const& path, size_t topN = 5);
-    int LevenshteinDistance(std::wstring const& a, std::wstring const& b);
-    bool FuzzyMatch(std::wstring const& hay, std::wstring const& needle, int maxDistance = 3);
-    std::string ComputeFileSHA1(std::wstring const& path);
+
+    ~ExplorerFinal() { JoinWorkers(); JoinWorker(m_semanticThread); }
+
+    // Worker-Threads, die auf this zugreifen: vor dem Neustart und beim Schließen joinen
+    // (wie m_indexPipeline / m_copyEngine)
+    static void JoinWorker(std::thread& t) {
+        if (t.joinable()) t.join();
+    }
+    void JoinWorkers() {
+        StopIndexing();
+        JoinWorker(m_indexThread);
+        CancelRecursiveSearch();
+        JoinWorker(m_recursiveSearchThread);
+        JoinWorker(m_contentSearchThread);
+        if (m_diskUsage) m_diskUsage->Cancel();
+        JoinWorker(m_diskUsageThread);
+        if (m_dupFinder) m_dupFinder->Cancel();
+        JoinWorker(m_dupThread);
+        JoinWorker(m_renamePlanThread);
+        JoinWorker(m_renameThread);
+        JoinWorker(m_fuzzyThread);
+    }
 
     // OnLaunched: Toolbar - AI buttons + Fuzzy toggle
     void OnLaunched(LaunchActivatedEventArgs const&)
     {
         m_window = Window();
         m_window.Title(L"Ultimate Explorer Final");
+        m_uiQueue = Microsoft::UI::Dispatching::DispatcherQueue::GetForCurrentThread();
+        m_searchTimer = m_uiQueue.CreateTimer();
+        m_searchTimer.IsRepeating(false);
+        m_searchTimer.Tick([this](auto const&, auto const&) { RunPendingSearch(); });
+        m_thumbMemory.SetBudget((size_t)m_thumbMemoryMB << 20);
+        LoadIndex(); // mmap, kein Parsen
+        ResumeCopyJobs(); // beim letzten Lauf unterbrochene Kopien
+        m_renamer.SetJournalDir(std::filesystem::path(GetFavoritesPath()).parent_path() / L"renames");
+        m_renamer.Recover(); // halb ausgeführte Batch-Umbenennung nach Absturz zurückrollen
+        m_thumbScheduler.Start(std::max(2u, std::thread::hardware_concurrency() / 2),
+            [this](ThumbRequest const& req, std::atomic<bool> const& cancel) { return DecodeThumbnail(req, cancel); });
+        // Erst alle Worker abbrechen und joinen, dann Disk-Caches sichern und schließen; laufende Kopie bleibt fortsetzbar
+        m_window.Closed([this](auto&&, auto&&) {
+            m_fsWatcher.Stop(); m_indexSync.Cancel(); m_thumbScheduler.Stop(); m_copyEngine.Stop();
+            JoinWorkers();
+            m_fsWatcher.Stop(); // ein eben fertiger Indexlauf kann ihn noch gestartet haben
+            m_thumbDisk.Close(); SaveIndex(); m_fullText.Close(); m_semantic.Close();
+            JoinWorker(m_semanticThread);
+        });
 
         // --- Theme: Dark gray palette ---
         auto darkBackgroundBrush = SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255, 30, 30, 30));   // main background
@@ -190,6 +317,11 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         m_searchBox = TextBox();
         m_searchBox.PlaceholderText(L"Suchen...");
         m_searchBox.TextChanged({ this, &ExplorerFinal::SearchTextChanged });
+        m_searchBox.KeyDown([this](auto const&, Microsoft::UI::Xaml::Input::KeyRoutedEventArgs const& e) {
+            if (e.Key() != winrt::Windows::System::VirtualKey::Enter) return;
+            PerformSearch();
+            e.Handled(true);
+        });
         Grid::SetRow(m_searchBox, 1);
         // NOTE: actual search UI stack appended later (searchStack). Do not append m_searchBox directly here.
 
@@ -241,6 +373,12 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         styleBtn(m_batchRenameButton);
         sortPanel.Children().Append(m_batchRenameButton);
 
+        m_undoButton = Button();
+        m_undoButton.Content(winrt::box_value(winrt::hstring(L"Undo")));
+        m_undoButton.Click([this](auto&&, auto&&) { UndoLast(); });
+        styleBtn(m_undoButton);
+        sortPanel.Children().Append(m_undoButton);
+
         // Selection and UI enhancement buttons
         m_selectAllButton = Button(); m_selectAllButton.Content(box_value(winrt::hstring(L"Select All"))); m_selectAllButton.Click({ this, &ExplorerFinal::SelectAllItems }); styleBtn(m_selectAllButton);
         m_invertSelectionButton = Button(); m_invertSelectionButton.Content(box_value(winrt::hstring(L"Invert Sel"))); m_invertSelectionButton.Click({ this, &ExplorerFinal::InvertSelection }); styleBtn(m_invertSelectionButton);
@@ -260,6 +398,8 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         sortPanel.Children().Append(m_findDuplicatesButton);
         sortPanel.Children().Append(m_summarizeButton);
         sortPanel.Children().Append(m_useFuzzyToggle);
+        m_contentSearchToggle = ToggleButton(); m_contentSearchToggle.Content(winrt::box_value(winrt::hstring(L"Inhalt"))); m_contentSearchToggle.Background(accentBrush); m_contentSearchToggle.Foreground(textBrush); m_contentSearchToggle.CornerRadius(Microsoft::UI::Xaml::CornerRadius{6});
+        sortPanel.Children().Append(m_contentSearchToggle);
 
         // Neue Buttons: Compress / Extract / Properties / CopyPath / OpenTerminal / ToggleHidden
         m_compressButton = Button(); m_compressButton.Content(winrt::box_value(winrt::hstring(L"Compress"))); m_compressButton.Click({ this, &ExplorerFinal::CompressSelected });
@@ -317,12 +457,19 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         // Datei-GridView (left)
         m_fileGrid = GridView();
         m_fileGrid.IsItemClickEnabled(true);
+        // virtualisiert: Karten kommen aus dem Template und werden recycelt, der Inhalt wird in
+        // FileGridContainerChanging gesetzt (Phase 0 Text, Phase 1 Thumbnail)
+        m_itemsSource = winrt::make_self<IndexItemSource>();
+        m_fileGrid.ItemTemplate(BuildCardTemplate());
+        m_fileGrid.ItemsSource(m_itemsSource.as<wfc::IObservableVector<IInspectable>>());
+        m_fileGrid.ContainerContentChanging({ this, &ExplorerFinal::FileGridContainerChanging });
         m_fileGrid.SelectionMode(Microsoft::UI::Xaml::Controls::ListViewSelectionMode::Multiple);
         m_fileGrid.IsMultiSelectCheckBoxEnabled(true);
         m_fileGrid.ItemClick({ this, &ExplorerFinal::FileItemClick });
         m_fileGrid.SelectionChanged({ this, &ExplorerFinal::FileSelectionChanged });
         m_fileGrid.AllowDrop(true);
         m_fileGrid.DragItemsStarting({ this, &ExplorerFinal::DragStart });
+        m_fileGrid.DragOver({ this, &ExplorerFinal::DragOverFiles });
         m_fileGrid.Drop({ this, &ExplorerFinal::DropFiles });
         m_fileGrid.Background(panelBrush);
         Grid::SetColumn(m_fileGrid, 0);
@@ -360,6 +507,8 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
 
         m_addFavItem = MenuFlyoutItem(); m_addFavItem.Text(L"Zu Favoriten hinzufügen"); m_addFavItem.Click({ this, &ExplorerFinal::AddToFavorites });
         m_remFavItem = MenuFlyoutItem(); m_remFavItem.Text(L"Aus Favoriten entfernen"); m_remFavItem.Click({ this, &ExplorerFinal::RemoveFromFavorites });
+        m_copyVerifyItem = ToggleMenuFlyoutItem(); m_copyVerifyItem.Text(L"Kopien prüfen");
+        m_copyVerifyItem.Click([this](auto const&, auto const&) { m_copyVerify = m_copyVerifyItem.IsChecked(); SaveSettings(); });
 
         flyout.Items().Append(copyItem);
         flyout.Items().Append(pasteItem);
@@ -367,6 +516,8 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         flyout.Items().Append(renameItem);
         flyout.Items().Append(m_addFavItem);
         flyout.Items().Append(m_remFavItem);
+        flyout.Items().Append(MenuFlyoutSeparator());
+        flyout.Items().Append(m_copyVerifyItem);
 
         // Opening-Handler: aktivieren/deaktivieren je nach Auswahl / Favoriten-Status
         flyout.Opening([this](auto const&, auto const&) {
@@ -374,9 +525,9 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
             bool enableAdd = false;
             bool enableRem = false;
             if (!selPath.empty()) {
-                auto it = FindItemByPath(selPath);
-                if (it != currentItems.end()) {
-                    std::wstring path = it->fullPath;
+                FileItem fi;
+                if (FindItemByPath(selPath, fi)) {
+                    std::wstring path = fi.fullPath;
                     bool isFav = (std::find(favorites.begin(), favorites.end(), path) != favorites.end());
                     enableAdd = !isFav;
                     enableRem = isFav;
@@ -384,6 +535,7 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
             }
             m_addFavItem.IsEnabled(enableAdd);
             m_remFavItem.IsEnabled(enableRem);
+            m_copyVerifyItem.IsChecked(m_copyVerify);
         });
 
         m_fileGrid.ContextFlyout(flyout);
@@ -435,138 +587,470 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         }
     }
 
-    // Dateien laden + Miniaturansichten
+    // Dateien laden: die Enumeration läuft im Hintergrund und liefert Batches, die hier angehängt werden.
+    // Shell-Items / Image-Factories werden nicht mehr pro Eintrag erzeugt, erst wenn ein Item angezeigt wird.
     void PopulateFiles(hstring path) {
-        currentItems.clear();
-        m_fileGrid.Items().Clear();
+        m_dirEnum.Cancel();
+        CancelRecursiveSearch();
+        m_searchFilterId = 0;
+        m_search.Invalidate();
+        CancelThumbnails();
+        uint64_t gen = ++m_enumGeneration;
+        currentItems.Clear();
+        filteredItems.Clear();
+        m_itemKeys.Clear();
+        m_filteredKeys.Clear();
+        m_view.clear();
+        m_viewRecursive = false;
+        m_itemsSource->Reset(0);
+        m_populateStart = std::chrono::steady_clock::now();
+        m_firstPaintLogged = false;
         std::wstring dir = path.c_str();
-        if (!std::filesystem::exists(dir) || !std::filesystem::is_directory(dir)) return;
-        WIN32_FIND_DATA fd;
-        HANDLE hFind = FindFirstFile((dir + L"\\*").c_str(), &fd);
-        if (hFind == INVALID_HANDLE_VALUE) return;
+        std::error_code ec;
+        if (!std::filesystem::is_directory(dir, ec)) return;
+        if (dir.size() > 1 && dir.back() == L'\\') dir.pop_back(); // "C:\\" -> "C:" (Pfade werden als dir + "\\" + name gebildet)
+
+        DirEnumOptions opt;
+        opt.includeHidden = m_showHidden;
+        m_dirEnum.Start(dir + L"\\", opt,
+            [this, dir, gen](std::vector<DirEntry>&& batch) {
+                auto entries = std::make_shared<std::vector<DirEntry>>(std::move(batch));
+                m_uiQueue.TryEnqueue([this, dir, gen, entries]() {
+                    if (gen == m_enumGeneration) AppendEntries(dir, *entries);
+                });
+            },
+            [this, gen](bool) {
+                m_uiQueue.TryEnqueue([this, gen]() {
+                    if (gen != m_enumGeneration) return;
+                    SearchRequest listing = CurrentSearchRequest(); // currentItems = ganzer Ordner
+                    listing.text.clear();
+                    listing.recursive = false;
+                    m_search.SetSource(listing);
+                    RunSearch(m_search.Run(CurrentSearchRequest()));
+                    LogViewMetrics(L"enumeration done");
+                });
+            });
+    }
 
-        do {
-            if (wcscmp(fd.cFileName, L".") != 0 && wcscmp(fd.cFileName, L"..") != 0) {
-                // Skip hidden files unless enabled
-                bool isHidden = (fd.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) != 0;
-                if (isHidden && !m_showHidden) continue;
+    // Ein Batch der Enumeration: Einträge in den Store übernehmen und in die Ansicht einsortieren (große Ordner: am Ende sortiert)
+    void AppendEntries(std::wstring const& dir, std::vector<DirEntry> const& entries) {
+        uint32_t first = (uint32_t)currentItems.Size();
+        uint32_t dirId = currentItems.AddDir(dir + L"\\");
+        for (auto const& e : entries) currentItems.Add(dirId, e.name, e.isDir, e.size, e.mtime, e.attributes);
+        AppendToView(first, (uint32_t)currentItems.Size(), !m_viewRecursive);
+    }
 
-                FileItem fi;
-                fi.name = fd.cFileName;
-                fi.fullPath = dir + L"\\" + fd.cFileName;
-                fi.isFolder = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
-                fi.size = ((ULONGLONG)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
-                fi.modifiedTime = fd.ftLastWriteTime;
-
-                // create image factory (if possible) for future thumbnail retrieval
-                IShellItem* psi = nullptr;
-                if (SUCCEEDED(SHCreateItemFromParsingName(fi.fullPath.c_str(), nullptr, IID_PPV_ARGS(&psi)))) {
-                    winrt::com_ptr<IShellItemImageFactory> factory;
-                    if (SUCCEEDED(psi->QueryInterface(IID_PPV_ARGS(&factory)))) {
-                        fi.imageFactory = factory;
-                    }
-                    psi->Release();
-                }
+    // Neue Items [first, end) an die Ansicht: sortiert einfügen (sorted = Items der Ansichtsquelle), solange die
+    // Liste klein ist (jeder Batch verschiebt sie einmal); danach anhängen, SortAndRefresh am Ende sortiert alles.
+    void AppendToView(uint32_t first, uint32_t end, bool sorted) {
+        constexpr size_t kSortedInsertMax = 1 << 16;
+        std::vector<uint32_t> fresh(end - first);
+        std::iota(fresh.begin(), fresh.end(), first);
+        if (sorted && !m_viewRanked && m_view.size() + fresh.size() <= kSortedInsertMax)
+            ViewKeys().Insert(m_view, std::move(fresh), ViewSortSpec());
+        else
+            m_view.insert(m_view.end(), fresh.begin(), fresh.end());
+        m_itemsSource->Reset((uint32_t)m_view.size());
+    }
 
-                currentItems.push_back(fi);
-
-                // Build a nicer rounded card for the GridView item (dark theme)
-                Border itemCard;
-                itemCard.CornerRadius(Microsoft::UI::Xaml::CornerRadius{ 8 });
-                itemCard.Padding(ThicknessHelper::FromUniformLength(8));
-                itemCard.Margin(ThicknessHelper::FromLengths(6, 6, 6, 6));
-                // dark card
-                itemCard.Background(SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255, 48, 48, 48)));
-
-                StackPanel cardStack;
-                cardStack.Orientation(Orientation::Vertical);
-
-                // Thumbnail image (async loaded)
-                Image thumbImg;
-                thumbImg.Width( (double) m_thumbnailSize );
-                thumbImg.Height( (double) (m_thumbnailSize * 0.75) );
-                thumbImg.Margin(ThicknessHelper::FromLengths(0, 0, 0, 6));
-                cardStack.Children().Append(thumbImg);
-                // start async thumbnail load (fire-and-forget)
-                LoadThumbnailAsync(fi, thumbImg);
-
-                TextBlock iconTb;
-                iconTb.FontSize(28);
-                iconTb.Margin(ThicknessHelper::FromLengths(0, 0, 0, 4));
-                iconTb.Text(winrt::hstring(fi.isFolder ? L"📁" : L"📄"));
-                iconTb.Foreground(SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255, 230, 230, 230)));
-
-                TextBlock nameTb;
-                nameTb.Text(winrt::hstring(fi.name));
-                nameTb.TextWrapping(TextWrapping::NoWrap);
-                nameTb.MaxWidth(220);
-                nameTb.FontSize(14);
-                nameTb.FontWeight(Windows::UI::Text::FontWeights::SemiBold());
-                nameTb.Foreground(SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255, 235, 235, 235)));
-
-                cardStack.Children().Append(iconTb);
-                cardStack.Children().Append(nameTb);
-
-                if (m_showDetails) {
-                    std::wstringstream ss;
-                    ss << L"Size: " << fi.size << L" bytes\n";
-                    SYSTEMTIME stUTC, stLocal;
-                    FileTimeToSystemTime(&fi.modifiedTime, &stUTC);
-                    SystemTimeToTzSpecificLocalTime(NULL, &stUTC, &stLocal);
-                    ss << L"Modified: " << stLocal.wDay << L"." << stLocal.wMonth << L"." << stLocal.wYear;
-                    TextBlock detailsTb;
-                    detailsTb.Text(winrt::hstring(ss.str()));
-                    detailsTb.FontSize(11);
-                    detailsTb.Opacity(0.9);
-                    detailsTb.TextWrapping(TextWrapping::Wrap);
-                    detailsTb.Margin(ThicknessHelper::FromLengths(0, 4, 0, 0));
-                    detailsTb.Foreground(SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255, 190, 190, 190)));
-                    cardStack.Children().Append(detailsTb);
-                }
+    // Messpunkt: Zeit seit PopulateFiles + Working Set (Debug-Ausgabe), z.B. für 100k/1M-Ordner
+    void LogViewMetrics(const wchar_t* what) {
+        PROCESS_MEMORY_COUNTERS pmc{ sizeof(pmc) };
+        GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_populateStart).count();
+        std::wstringstream ss;
+        ss << L"[ExporaPlus] " << what << L": " << ms << L" ms, " << currentItems.Size() << L" items ("
+           << (currentItems.MemoryBytes() >> 20) << L" MB), working set " << (pmc.WorkingSetSize >> 20) << L" MB\n";
+        auto tm = m_thumbScheduler.Metrics();
+        ss << L"[ExporaPlus]   thumbnails: " << tm.completed << L" decoded, " << tm.cancelled << L" cancelled, "
+           << tm.deduplicated << L" deduplicated, " << tm.queued << L" queued; wait visible " << tm.meanWaitMs[ThumbVisible]
+           << L" ms (max " << tm.maxWaitMs[ThumbVisible] << L"), near " << tm.meanWaitMs[ThumbNear] << L" ms\n";
+        OutputDebugStringW(ss.str().c_str());
+    }
+
+    ListingStore& ViewSource() { return m_viewRecursive ? filteredItems : currentItems; }
+    // Schlüssel der Ansichtsquelle; neue Items bekommen ihre Schlüssel beim ersten Sortieren
+    SortKeyTable& ViewKeys() {
+        auto& src = ViewSource();
+        auto& keys = m_viewRecursive ? m_filteredKeys : m_itemKeys;
+        for (uint32_t i = (uint32_t)keys.Size(); i < src.Size(); ++i) keys.Add(src.Name(i), src.IsFolder(i), src.FileSize(i), src.Mtime(i));
+        return keys;
+    }
+    // Spalte zuerst, gleiche Werte nach Name in derselben Richtung (wie bisher bei Typ), Rest stabil
+    SortSpec ViewSortSpec() const {
+        static const SortField columns[] = { SortField::Name, SortField::Type, SortField::Size, SortField::Date };
+        SortSpec spec;
+        spec.keys.push_back({ columns[sortColumn], sortAscending });
+        if (sortColumn != 0) spec.keys.push_back({ SortField::Name, sortAscending });
+        return spec;
+    }
+    static FileItem MakeFileItem(ListingStore const& store, uint32_t row) {
+        FileItem fi;
+        fi.name = store.Name(row);
+        fi.fullPath = store.Path(row);
+        fi.isFolder = store.IsFolder(row);
+        fi.size = store.FileSize(row);
+        fi.modifiedTime.dwLowDateTime = (DWORD)store.Mtime(row);
+        fi.modifiedTime.dwHighDateTime = (DWORD)(store.Mtime(row) >> 32);
+        return fi;
+    }
+    bool ViewItem(uint32_t pos, FileItem& fi) {
+        if (pos >= m_view.size()) return false;
+        auto& src = ViewSource();
+        if (m_view[pos] >= src.Size()) return false;
+        fi = MakeFileItem(src, m_view[pos]);
+        return true;
+    }
+    // Item hinter einem Eintrag aus SelectedItem()/SelectedItems() (geboxte Position)
+    bool ItemFromGridItem(IInspectable const& item, FileItem& fi) { return item && ViewItem(IndexItemSource::PositionOf(item), fi); }
+
+    // Disk-Cache beim ersten Zugriff öffnen (Worker-Thread; ein fehlender/alter Index wird aus dem Blob neu aufgebaut)
+    ThumbnailDiskStore& ThumbDisk() {
+        std::call_once(m_thumbDiskOnce, [this]() {
+            m_thumbDisk.Open(std::filesystem::path(GetFavoritesPath()).parent_path() / L"thumbs", (uint64_t)m_thumbDiskMB << 20);
+        });
+        return m_thumbDisk;
+    }
+
+    // Shell-Thumbnail als PNG rendern (Worker-Thread; eigene Image-Factory, nur bei Disk-Cache-Miss)
+    static std::vector<uint8_t> RenderThumbnailPng(std::wstring const& path, unsigned int size) {
+        std::vector<uint8_t> png;
+        winrt::com_ptr<IShellItemImageFactory> factory;
+        if (FAILED(SHCreateItemFromParsingName(path.c_str(), nullptr, IID_PPV_ARGS(factory.put())))) return png;
+        HBITMAP hbm = nullptr;
+        if (FAILED(factory->GetImage(SIZE{ (LONG)size, (LONG)size }, SIIGBF_BIGGERSIZEOK, &hbm))) return png;
+        winrt::com_ptr<IWICImagingFactory> wic;
+        winrt::com_ptr<IWICBitmap> bitmap;
+        winrt::com_ptr<IStream> stream;
+        winrt::com_ptr<IWICBitmapEncoder> encoder;
+        winrt::com_ptr<IWICBitmapFrameEncode> frame;
+        bool ok = SUCCEEDED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(wic.put())))
+            && SUCCEEDED(wic->CreateBitmapFromHBITMAP(hbm, nullptr, WICBitmapUsePremultipliedAlpha, bitmap.put()))
+            && SUCCEEDED(CreateStreamOnHGlobal(nullptr, TRUE, stream.put()))
+            && SUCCEEDED(wic->CreateEncoder(GUID_ContainerFormatPng, nullptr, encoder.put()))
+            && SUCCEEDED(encoder->Initialize(stream.get(), WICBitmapEncoderNoCache))
+            && SUCCEEDED(encoder->CreateNewFrame(frame.put(), nullptr))
+            && SUCCEEDED(frame->Initialize(nullptr))
+            && SUCCEEDED(frame->WriteSource(bitmap.get(), nullptr))
+            && SUCCEEDED(frame->Commit())
+            && SUCCEEDED(encoder->Commit());
+        DeleteObject(hbm);
+        STATSTG st{};
+        if (!ok || FAILED(stream->Stat(&st, STATFLAG_NONAME))) return png;
+        png.resize((size_t)st.cbSize.QuadPart);
+        LARGE_INTEGER zero{};
+        ULONG read = 0;
+        stream->Seek(zero, STREAM_SEEK_SET, nullptr);
+        if (FAILED(stream->Read(png.data(), (ULONG)png.size(), &read)) || read != png.size()) png.clear();
+        return png;
+    }
+
+    // Worker des Schedulers: Disk-Cache, sonst Shell-Rendering (nicht mehr, wenn der Auftrag abgebrochen wurde)
+    std::vector<uint8_t> DecodeThumbnail(ThumbRequest const& req, std::atomic<bool> const& cancel) {
+        static thread_local bool com = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+        (void)com;
+        std::vector<uint8_t> png;
+        if (ThumbDisk().Get(req.key, png) || cancel.load()) return png;
+        png = RenderThumbnailPng(req.path.wstring(), req.size);
+        if (!png.empty()) ThumbDisk().Put(req.key, png.data(), png.size());
+        return png;
+    }
+
+    int ThumbPriorityFor(uint32_t pos) const {
+        return m_thumbFirstVisible >= 0 && (int32_t)pos >= m_thumbFirstVisible && (int32_t)pos <= m_thumbLastVisible ? ThumbVisible : ThumbNear;
+    }
+
+    // Sichtbaren Bereich nachführen; hat er sich verschoben, offene Aufträge neu einordnen
+    void UpdateThumbnailPriorities() {
+        auto panel = m_fileGrid.ItemsPanelRoot().try_as<ItemsWrapGrid>();
+        if (!panel) return;
+        int32_t first = panel.FirstVisibleIndex(), last = panel.LastVisibleIndex();
+        if (first == m_thumbFirstVisible && last == m_thumbLastVisible) return;
+        m_thumbFirstVisible = first; m_thumbLastVisible = last;
+        for (auto const& t : m_thumbTickets) m_thumbScheduler.SetPriority(t.second, ThumbPriorityFor(t.first));
+    }
+
+    void CancelThumbnail(uint32_t pos) {
+        auto it = m_thumbTickets.find(pos);
+        if (it == m_thumbTickets.end()) return;
+        m_thumbScheduler.Cancel(it->second);
+        m_thumbTickets.erase(it);
+    }
+
+    // Navigation / neue Sortierung: Positionen sind ungültig, alle offenen Aufträge verwerfen
+    void CancelThumbnails() {
+        m_thumbScheduler.CancelAll();
+        m_thumbTickets.clear();
+        m_thumbFirstVisible = m_thumbLastVisible = -1;
+    }
+
+    // Thumbnail für Position pos: Speicher-LRU sofort, sonst Auftrag an den Scheduler.
+    // Der Schlüssel enthält Größe/Änderungszeit der Datei und m_thumbnailSize; target.Tag erkennt recycelte Container.
+    void LoadThumbnail(uint32_t pos, FileItem const& fi, Image const& target) {
+        std::wstring path = fi.fullPath;
+        unsigned int size = m_thumbnailSize;
+        uint64_t mtime = ((uint64_t)fi.modifiedTime.dwHighDateTime << 32) | fi.modifiedTime.dwLowDateTime;
+        uint64_t key = ThumbnailKey(path, fi.size, mtime, size);
+        target.Tag(winrt::box_value(winrt::hstring(path)));
+        CancelThumbnail(pos);
+        Media::Imaging::BitmapImage bmp{ nullptr };
+        if (m_thumbMemory.Get(key, bmp)) { target.Source(bmp); return; }
+
+        UpdateThumbnailPriorities();
+        auto agileTarget = winrt::make_agile(target);
+        m_thumbTickets[pos] = m_thumbScheduler.Submit({ key, path, size }, ThumbPriorityFor(pos),
+            [this, path, size, agileTarget](uint64_t key, std::vector<uint8_t> const& png) {
+                if (png.empty()) return;
+                auto data = std::make_shared<std::vector<uint8_t>>(png);
+                m_uiQueue.TryEnqueue([this, key, path, size, agileTarget, data]() {
+                    ShowThumbnailAsync(key, path, size, data, agileTarget.get());
+                });
+            });
+    }
 
-                itemCard.Child(cardStack);
+    // PNG aus dem Scheduler dekodieren (UI-Thread), in den Speicher-LRU legen und anzeigen, falls der Container noch passt
+    fire_and_forget ShowThumbnailAsync(uint64_t key, std::wstring path, unsigned int size, std::shared_ptr<std::vector<uint8_t>> png, Image target) {
+        auto lifetime = get_strong();
+        Windows::Storage::Streams::InMemoryRandomAccessStream stream;
+        Windows::Storage::Streams::DataWriter writer(stream);
+        writer.WriteBytes(*png);
+        co_await writer.StoreAsync();
+        writer.DetachStream();
+        stream.Seek(0);
+        Media::Imaging::BitmapImage bmp;
+        bmp.DecodePixelWidth((int32_t)size);
+        co_await bmp.SetSourceAsync(stream);
+        m_thumbMemory.Put(key, bmp, (size_t)size * (size * 3 / 4) * 4); // dekodierte BGRA-Pixel
+        if (winrt::unbox_value_or<winrt::hstring>(target.Tag(), L"") == path) target.Source(bmp);
+    }
 
-                // attach the full path in Tag for later retrieval on clicks
-                itemCard.Tag(winrt::box_value(winrt::hstring(fi.fullPath)));
+    // Karten-Template für das Grid: Border > StackPanel { Thumbnail, Icon, Name, Details }
+    DataTemplate BuildCardTemplate() {
+        std::wstringstream x;
+        x << L"<DataTemplate xmlns='http://schemas.microsoft.com/winfx/2006/xaml/presentation'>"
+          << L"<Border CornerRadius='8' Padding='8' Margin='6' Background='#FF303030'><StackPanel Orientation='Vertical'>"
+          << L"<Image Width='" << m_thumbnailSize << L"' Height='" << (m_thumbnailSize * 3 / 4) << L"' Margin='0,0,0,6'/>"
+          << L"<TextBlock FontSize='28' Margin='0,0,0,4' Foreground='#FFE6E6E6'/>"
+          << L"<TextBlock TextWrapping='NoWrap' MaxWidth='220' FontSize='14' FontWeight='SemiBold' Foreground='#FFEBEBEB'/>"
+          << L"<TextBlock FontSize='11' Opacity='0.9' TextWrapping='Wrap' Margin='0,4,0,0' Foreground='#FFBEBEBE'/>"
+          << L"</StackPanel></Border></DataTemplate>";
+        return Markup::XamlReader::Load(winrt::hstring(x.str())).as<DataTemplate>();
+    }
 
-                m_fileGrid.Items().Append(itemCard);
+    // Container wird (wieder)verwendet: Inhalt für die Position setzen, Thumbnail in Phase 1
+    void FileGridContainerChanging(ListViewBase const&, ContainerContentChangingEventArgs const& args) {
+        auto card = args.ItemContainer().ContentTemplateRoot().try_as<Border>();
+        if (!card) return;
+        auto parts = card.Child().as<StackPanel>().Children();
+        auto thumb = parts.GetAt(0).as<Image>();
+        if (args.InRecycleQueue()) {
+            CancelThumbnail(IndexItemSource::PositionOf(args.Item()));
+            thumb.Source(nullptr); thumb.Tag(nullptr);
+            return;
+        }
+        FileItem fi;
+        if (!ItemFromGridItem(args.Item(), fi)) return;
+        if (args.Phase() == 0) {
+            thumb.Source(nullptr);
+            parts.GetAt(1).as<TextBlock>().Text(winrt::hstring(fi.isFolder ? L"📁" : L"📄"));
+            parts.GetAt(2).as<TextBlock>().Text(winrt::hstring(fi.name));
+            auto details = parts.GetAt(3).as<TextBlock>();
+            details.Visibility(m_showDetails ? Visibility::Visible : Visibility::Collapsed);
+            if (m_showDetails) {
+                std::wstringstream ss;
+                ss << L"Size: " << fi.size << L" bytes\n";
+                SYSTEMTIME stUTC, stLocal;
+                FileTimeToSystemTime(&fi.modifiedTime, &stUTC);
+                SystemTimeToTzSpecificLocalTime(NULL, &stUTC, &stLocal);
+                ss << L"Modified: " << stLocal.wDay << L"." << stLocal.wMonth << L"." << stLocal.wYear;
+                details.Text(winrt::hstring(ss.str()));
             }
-        } while (FindNextFile(hFind, &fd));
-        FindClose(hFind);
-        filteredItems = currentItems;
-        SortAndRefresh();
+            card.Tag(winrt::box_value(winrt::hstring(fi.fullPath)));
+            args.RegisterUpdateCallback(1, { this, &ExplorerFinal::FileGridContainerChanging });
+            if (!m_firstPaintLogged) { m_firstPaintLogged = true; LogViewMetrics(L"first item realized"); }
+        }
+        else if (args.Phase() == 1) {
+            LoadThumbnail(IndexItemSource::PositionOf(args.Item()), fi, thumb);
+        }
+        args.Handled(true);
     }
 
-    // Suchleiste filter: delegiere an PerformSearch (unterstützt Fuzzy + Rekursion)
+    // Tippen: nur vormerken und laufende Suchen verwerfen; gesucht wird nach einer kurzen Pause (m_searchTimer)
     void SearchTextChanged(IInspectable const&, TextChangedEventArgs const&) {
-        PerformSearch();
+        auto now = SearchSession::Clock::now();
+        auto due = m_search.Input(CurrentSearchRequest(), now);
+        CancelRecursiveSearch();
+        m_searchTimer.Stop();
+        m_searchTimer.Interval(std::chrono::duration_cast<winrt::Windows::Foundation::TimeSpan>(due - now));
+        m_searchTimer.Start();
+    }
+
+    void RunPendingSearch() {
+        if (auto t = m_search.Take(SearchSession::Clock::now(), true)) RunSearch(*t);
     }
 
+    // Enter / Suchen-Button: sofort suchen, nur hier kommt der Text in den Verlauf
     void PerformSearch() {
-        std::wstring filter = m_searchBox.Text().c_str();
-        if (!filter.empty()) {
-            auto it = std::find(searchHistory.begin(), searchHistory.end(), filter);
-            if (it != searchHistory.end()) searchHistory.erase(it);
-            searchHistory.insert(searchHistory.begin(), filter);
-            if (searchHistory.size() > 25) searchHistory.resize(25);
-            m_searchHistoryCombo.Items().Clear();
-            for (auto const& s : searchHistory) m_searchHistoryCombo.Items().Append(box_value(winrt::hstring(s)));
+        m_searchTimer.Stop();
+        auto before = m_search.History();
+        RunSearch(m_search.Commit(CurrentSearchRequest()));
+        if (m_search.History() == before) return;
+        m_searchHistoryCombo.Items().Clear();
+        for (auto const& s : m_search.History()) m_searchHistoryCombo.Items().Append(box_value(winrt::hstring(s)));
+    }
+
+    SearchRequest CurrentSearchRequest() {
+        SearchRequest r;
+        r.text = m_searchBox.Text().c_str();
+        r.scope = m_addressBar.Text().c_str();
+        r.recursive = m_recursiveToggle && m_recursiveToggle.IsOn();
+        r.fuzzy = m_useFuzzyToggle && m_useFuzzyToggle.IsChecked().HasValue() && m_useFuzzyToggle.IsChecked().Value();
+        r.matchCase = true; // Teilstring wie bisher mit Groß-/Kleinschreibung
+        r.includeHidden = m_showHidden;
+        r.maxDistance = m_fuzzyThreshold;
+        r.content = m_contentSearchToggle && m_contentSearchToggle.IsChecked().HasValue() && m_contentSearchToggle.IsChecked().Value();
+        return r;
+    }
+
+    // Plan der Sitzung ausführen: was schon da ist eingrenzen, sonst neu suchen
+    void RunSearch(SearchTicket const& t) {
+        switch (t.kind) {
+        case SearchKind::Unchanged:
+            break;
+        case SearchKind::RefineShown:
+            StartSliceFilter(t, m_view, false, true);
+            break;
+        case SearchKind::RefineSource: {
+            std::vector<uint32_t> all(t.request.recursive ? filteredItems.Size() : currentItems.Size());
+            std::iota(all.begin(), all.end(), 0u);
+            StartSliceFilter(t, std::move(all), true, true);
+            break;
         }
+        case SearchKind::Full:
+            ApplyFilter(t);
+            break;
+        }
+    }
 
-        filteredItems.clear();
-        bool useFuzzy = m_useFuzzyToggle && m_useFuzzyToggle.IsChecked().HasValue() && m_useFuzzyToggle.IsChecked().Value();
-        if (m_recursiveToggle && m_recursiveToggle.IsOn()) {
-            RecursiveSearch(m_addressBar.Text().c_str(), filter, filteredItems);
-        } else {
-            for (auto& fi : currentItems) {
-                if (useFuzzy) {
-                    if (FuzzyMatch(fi.name, filter)) filteredItems.push_back(fi);
-                } else {
-                    if (fi.name.find(filter) != std::wstring::npos) filteredItems.push_back(fi);
-                }
+    // Positionen scheibchenweise filtern; die Ansicht wird erst am Ende ersetzt (bis dahin alte Treffer).
+    // sort = Eingabe ist nicht in Ansichtsreihenfolge; complete = Eingabe enthält alle Kandidaten.
+    void StartSliceFilter(SearchTicket const& t, std::vector<uint32_t> positions, bool sort, bool complete) {
+        auto const& r = t.request;
+        m_searchFilter.Start(std::move(positions));
+        m_searchFilterMatcher.Assign(r.text, r.fuzzy, r.matchCase, r.maxDistance);
+        m_searchFilterId = t.id;
+        m_searchFilterRecursive = r.recursive;
+        m_searchFilterSort = sort;
+        m_searchFilterComplete = complete;
+        FilterSlice(t.id);
+    }
+
+    void FilterSlice(uint64_t id) {
+        constexpr size_t kSlice = 16384; // ~1 ms Teilstring, wenige ms Fuzzy
+        if (id != m_searchFilterId || !m_search.Current(id)) return;
+        auto const& src = m_searchFilterRecursive ? filteredItems : currentItems;
+        bool done = m_searchFilter.Step(kSlice, [&](uint32_t i) { return m_searchFilterMatcher.Matches(src.Name(i)); });
+        if (!done) {
+            m_uiQueue.TryEnqueue(Microsoft::UI::Dispatching::DispatcherQueuePriority::Low, [this, id]() { FilterSlice(id); });
+            return;
+        }
+        m_searchFilterId = 0;
+        m_view = m_searchFilter.Take();
+        m_viewRecursive = m_searchFilterRecursive;
+        m_viewRanked = false;
+        if (m_searchFilterSort) SortAndRefresh();
+        else RefreshView();
+        m_search.Completed(id, m_searchFilterComplete);
+    }
+
+    // Neue Suche: Filter -> neue Positionsliste (Indizes), dann sortieren; es werden keine FileItems kopiert.
+    // Fuzzy: Muster einmal übersetzen (bitparallel, FuzzySearch.h); höchstens eine Änderung je drei Zeichen.
+    // Fuzzy + rekursiv: aus dem Namensindex, beste Treffer zuerst (ohne Index: rekursive Suche im Hintergrund).
+    void ApplyFilter(SearchTicket const& t) {
+        auto const& r = t.request;
+        CancelRecursiveSearch();
+        m_searchFilterId = 0;
+        m_view.clear();
+        m_viewRecursive = r.recursive;
+        m_viewRanked = false;
+        filteredItems.Clear();
+        m_filteredKeys.Clear();
+        if (r.recursive && r.fuzzy && !r.text.empty()) RefreshFuzzyIndex();
+        if (r.content && !r.text.empty()) {
+            RefreshView();
+            StartContentSearch(t);
+        } else if (r.recursive && r.fuzzy && !r.text.empty() && m_fuzzyIndex) {
+            FuzzyQueryOptions opt;
+            opt.maxDistance = r.maxDistance;
+            opt.topK = 1000;
+            opt.scope = r.scope;
+            auto hits = m_fuzzyIndex->Query(r.text, opt, nullptr, &m_fuzzyPool);
+            std::lock_guard<std::mutex> lg(m_indexMutex);
+            for (auto const& h : hits) {
+                // der Fuzzy-Index kann älter sein als m_index: entfernte Pfade nicht anzeigen
+                FileIndexEntry e;
+                std::wstring path = m_fuzzyIndex->Path(h.id);
+                if (!m_index.Find(path, e)) continue;
+                const bool isFolder = false; // m_index enthält nur Dateien (IndexPipeline / IndexSync nehmen keine Ordner auf)
+                filteredItems.Add(path, isFolder, e.size, e.mtime);
             }
+            for (uint32_t i = 0; i < (uint32_t)filteredItems.Size(); ++i) m_view.push_back(i);
+            m_viewRanked = true;
+            SortAndRefresh();
+            m_search.Completed(t.id, false); // nur die besten Treffer
+        } else if (r.recursive) {
+            SortAndRefresh();
+            StartRecursiveSearch(t);
+        } else {
+            // Ordner wird noch gelesen (sonst wäre es RefineSource): am Ende der Enumeration wird neu gefiltert
+            SortAndRefresh();
+            std::vector<uint32_t> all(currentItems.Size());
+            std::iota(all.begin(), all.end(), 0u);
+            StartSliceFilter(t, std::move(all), true, false);
         }
-        SortAndRefresh();
+    }
+
+    // Namensindex neu aufbauen, wenn sich die Pfadmenge von m_index geändert hat (Hintergrundthread).
+    // Bis er fertig ist, antwortet der alte; danach wird die Suche wiederholt.
+    void RefreshFuzzyIndex() {
+        uint64_t gen;
+        {
+            std::lock_guard<std::mutex> lg(m_indexMutex);
+            gen = m_index.PathGeneration();
+        }
+        if (gen == m_fuzzyGeneration || m_fuzzyBuilding) return;
+        m_fuzzyBuilding = true;
+        JoinWorker(m_fuzzyThread); // der vorige hat sein Ergebnis schon abgegeben
+        m_fuzzyThread = std::thread([this]() {
+            auto idx = std::make_shared<FuzzyIndex>();
+            uint64_t built;
+            {
+                std::lock_guard<std::mutex> lg(m_indexMutex);
+                built = m_index.PathGeneration();
+                m_index.ForEachPath([&](IndexStringView p) { idx->Add(p); });
+            }
+            idx->Build();
+            m_uiQueue.TryEnqueue([this, idx, built]() {
+                bool first = !m_fuzzyIndex;
+                m_fuzzyIndex = idx;
+                m_fuzzyGeneration = built;
+                m_fuzzyBuilding = false;
+                SearchRequest r = CurrentSearchRequest();
+                if (!m_viewRanked && !(first && r.recursive && r.fuzzy)) return;
+                m_search.Invalidate(); // Rangliste aus dem neuen Index statt eingrenzen
+                RunSearch(m_search.Run(r));
+            });
+        });
+    }
+
+    // Editierdistanz ohne Groß-/Kleinschreibung (bitparallel, FuzzySearch.h)
+    int LevenshteinDistance(std::wstring const& a, std::wstring const& b) {
+        return FuzzyLevenshtein<wchar_t>(a, b);
+    }
+
+    // needle kommt mit höchstens maxDistance Änderungen irgendwo in hay vor
+    bool FuzzyMatch(std::wstring const& hay, std::wstring const& needle, int maxDistance = 3) {
+        return FuzzyPattern<wchar_t>(needle).Search(hay.data(), hay.size()) <= maxDistance;
     }
 
     // Breadcrumb helper
@@ -599,108 +1083,187 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         }
     }
 
-    // Rekursive Suche
-    void RecursiveSearch(std::wstring const& path, std::wstring const& filter, std::vector<FileItem>& outItems) {
-        try {
-            for (auto const& entry : std::filesystem::directory_iterator(path)) {
-                try {
-                    auto name = entry.path().filename().wstring();
-                    WIN32_FIND_DATA fd;
-                    FileItem fi;
-                    fi.name = name;
-                    fi.fullPath = entry.path().wstring();
-                    fi.isFolder = entry.is_directory();
-                    if (!fi.isFolder) {
-                        auto f = std::filesystem::file_size(entry.path());
-                        fi.size = f;
-                    } else fi.size = 0;
-                    if (fi.name.find(filter) != std::wstring::npos) outItems.push_back(fi);
-                    if (entry.is_directory()) {
-                        RecursiveSearch(entry.path().wstring(), filter, outItems);
-                    }
-                } catch (...) { /* ignore individual errors */ }
-            }
-        } catch (...) { /* ignore access errors */ }
+    // Rekursive Suche: Unterordner parallel (ParallelSearch.h), Treffer werden batchweise angehängt,
+    // Ordner aus m_searchExclude nicht betreten. Am Ende einmal sortieren.
+    // Ist die Suche vollständig (nicht gekappt), wird ein längerer Suchtext nur noch daraus gefiltert.
+    void StartRecursiveSearch(SearchTicket const& t) {
+        CancelRecursiveSearch();
+        uint64_t gen = m_searchGeneration, id = t.id;
+        auto search = std::make_shared<ParallelSearch>();
+        m_recursiveSearch = search;
+        ParallelSearchOptions opt;
+        opt.includeHidden = t.request.includeHidden;
+        opt.matchCase = t.request.matchCase;
+        opt.fuzzy = t.request.fuzzy;
+        opt.maxDistance = t.request.maxDistance;
+        opt.maxResults = 500000;
+        opt.excludeNames = m_searchExclude;
+        JoinWorker(m_recursiveSearchThread); // eben abgebrochen, gibt schnell auf
+        m_recursiveSearchThread = std::thread([this, search, opt, root = t.request.scope, filter = t.request.text, gen, id]() {
+            ParallelSearchStats stats;
+            search->Run(root, filter, opt, [this, gen](std::vector<SearchHit>&& batch) {
+                auto hits = std::make_shared<std::vector<SearchHit>>(std::move(batch));
+                m_uiQueue.TryEnqueue([this, gen, hits]() {
+                    if (gen == m_searchGeneration) AppendSearchHits(*hits);
+                });
+            }, &stats);
+            if (search->Cancelled()) return;
+            m_uiQueue.TryEnqueue([this, gen, id, capped = stats.capped]() {
+                if (gen != m_searchGeneration) return;
+                m_recursiveSearch.reset();
+                SortAndRefresh();
+                m_search.Completed(id, !capped);
+            });
+        });
     }
 
-    // Batch-Rename: Pattern example: "File_{n}" where {n} replaced with index
-    fire_and_forget BatchRename(IInspectable const&, RoutedEventArgs const&) {
-        auto sel = m_fileGrid.SelectedItem();
-        if (!sel) co_return;
-        TextBox input;
-        input.PlaceholderText(L"Pattern, use {n} for index, e.g. Photo_{n}");
-        ContentDialog dlg;
-        dlg.Title(winrt::box_value(winrt::hstring(L"Batch-Rename")));
-        dlg.Content(input);
-        dlg.PrimaryButtonText(L"OK");
-        dlg.SecondaryButtonText(L"Cancel");
-        dlg.XamlRoot(m_fileGrid.XamlRoot());
-        auto res = co_await dlg.ShowAsync();
-        if (res != ContentDialogResult::Primary) co_return;
-        hstring pattern = input.Text();
-        std::vector<std::wstring> selectedNames;
-        for (auto const& s : m_fileGrid.SelectedItems()) {
-            selectedNames.push_back(std::wstring(unbox_value<hstring>(s).c_str()));
-        }
-        int idx = 1;
-        for (auto const& nm : selectedNames) {
-            auto it = std::find_if(currentItems.begin(), currentItems.end(),
-                [&nm](FileItem const& fi) { return fi.name == nm; });
-            if (it == currentItems.end()) continue;
-            std::wstring pat = pattern.c_str();
-            // replace {n}
-            size_t pos = pat.find(L"{n}");
-            std::wstringstream ss;
-            ss << idx++;
-            if (pos != std::wstring::npos) pat.replace(pos, 3, ss.str());
-            std::filesystem::path oldp(it->fullPath);
-            std::filesystem::path newp = oldp.parent_path() / pat;
-            try {
-                std::filesystem::rename(oldp, newp);
-            } catch (...) {}
-        }
-        PopulateFiles(m_addressBar.Text());
+    // Inhaltssuche (FullTextIndex.h): Wörter, "Phrasen", OR, -Ausschluss, Präfix*; beste Treffer zuerst,
+    // batchweise angehängt. Sucht immer unterhalb des aktuellen Ordners; nur was der Indexer gelesen hat.
+    void StartContentSearch(SearchTicket const& t) {
+        CancelRecursiveSearch();
+        uint64_t gen = m_searchGeneration, id = t.id;
+        auto cancel = std::make_shared<std::atomic<bool>>(false);
+        m_contentSearch = cancel;
+        m_viewRanked = true;
+        FullTextQueryOptions opt;
+        opt.topK = 5000;
+        opt.scope = t.request.scope;
+        JoinWorker(m_contentSearchThread); // über m_contentSearch abgebrochen
+        m_contentSearchThread = std::thread([this, cancel, opt, query = t.request.text, gen, id]() {
+            bool done = m_fullText.Query(query, opt, [this, gen](std::vector<FullTextHit>&& batch) {
+                auto hits = std::make_shared<std::vector<SearchHit>>();
+                for (auto& h : batch) {
+                    SearchHit s;
+                    s.path = std::move(h.path);
+                    s.size = h.size;
+                    s.mtime = h.mtime;
+                    hits->push_back(std::move(s));
+                }
+                m_uiQueue.TryEnqueue([this, gen, hits]() {
+                    if (gen == m_searchGeneration) AppendSearchHits(*hits);
+                });
+            }, nullptr, cancel.get());
+            if (!done) return;
+            m_uiQueue.TryEnqueue([this, gen, id]() {
+                if (gen != m_searchGeneration) return;
+                m_contentSearch.reset();
+                m_search.Completed(id, false); // Rangliste: nie eingrenzen
+            });
+        });
     }
 
-    // Größenanalyse: berechnet rekursiv Größen für Items in current directory
-    static ULONGLONG ComputeSizeRecursive(std::wstring const& path) {
-        ULONGLONG total = 0;
-        try {
-            for (auto const& e : std::filesystem::recursive_directory_iterator(path)) {
-                try {
-                    if (e.is_regular_file()) total += (ULONGLONG)std::filesystem::file_size(e.path());
-                } catch (...) {}
-            }
-        } catch (...) {}
-        return total;
+    // Laufende Suche abbrechen; schon eingereihte Batches werden über die Generation verworfen
+    void CancelRecursiveSearch() {
+        if (m_recursiveSearch) m_recursiveSearch->Cancel();
+        m_recursiveSearch.reset();
+        if (m_contentSearch) m_contentSearch->store(true);
+        m_contentSearch.reset();
+        ++m_searchGeneration;
+    }
+
+    void AppendSearchHits(std::vector<SearchHit> const& hits) {
+        uint32_t first = (uint32_t)filteredItems.Size();
+        for (auto const& h : hits) filteredItems.Add(h.path, h.isDir, h.size, h.mtime);
+        AppendToView(first, (uint32_t)filteredItems.Size(), m_viewRecursive);
     }
+
+    static std::wstring SizeText(uint64_t bytes) {
+        static const wchar_t* units[] = { L"B", L"KB", L"MB", L"GB", L"TB" };
+        double v = (double)bytes;
+        int u = 0;
+        while (v >= 1024 && u < 4) { v /= 1024; ++u; }
+        wchar_t buf[32];
+        swprintf(buf, 32, u ? L"%.1f %s" : L"%.0f %s", v, units[u]);
+        return buf;
+    }
+
+    // Größenanalyse (DiskUsage.h): paralleler Walk im Hintergrund, Zwischenstände je Unterordner live im
+    // Dialog, am Ende Treemap + größte Einträge / Dateien. Schließen des Dialogs bricht ab; Ordner mit
+    // unveränderter mtime kommen beim nächsten Mal aus m_diskUsageCache.
     fire_and_forget AnalyzeSizes(IInspectable const&, RoutedEventArgs const&) {
-        std::vector<std::pair<std::wstring, ULONGLONG>> sizes;
-        for (auto& fi : currentItems) {
-            if (fi.isFolder) {
-                ULONGLONG s = ComputeSizeRecursive(fi.fullPath);
-                sizes.push_back({ fi.name, s });
-            } else {
-                sizes.push_back({ fi.name, fi.size });
-            }
-        }
-        std::sort(sizes.begin(), sizes.end(), [](auto const& a, auto const& b) { return a.second > b.second; });
-        std::wstringstream ss;
-        ss << L"Top items by size:\n\n";
-        int count = 0;
-        for (auto const& p : sizes) {
-            ss << p.first << L" - " << p.second << L" bytes\n";
-            if (++count >= 15) break;
-        }
+        std::wstring root = m_addressBar.Text().c_str();
+        if (root.empty()) co_return;
+        std::vector<std::pair<std::wstring, uint64_t>> files; // Dateien direkt im Ordner, wie angezeigt
+        for (uint32_t i = 0; i < currentItems.Size(); ++i)
+            if (!currentItems.IsFolder(i)) files.push_back({ std::wstring(currentItems.Name(i)), currentItems.FileSize(i) });
+
+        auto usage = std::make_shared<DiskUsage>();
+        Canvas map; map.Width(640); map.Height(320);
+        TextBlock tb; tb.TextWrapping(TextWrapping::Wrap); tb.Text(L"Analysiere...");
+        StackPanel sp; sp.Orientation(Orientation::Vertical); sp.Spacing(8);
+        sp.Children().Append(map);
+        sp.Children().Append(tb);
+        ScrollViewer sv; sv.Content(sp);
         ContentDialog dlg;
         dlg.Title(winrt::box_value(winrt::hstring(L"Size Analysis")));
-        TextBlock tb;
-        tb.Text(winrt::hstring(ss.str()));
-        tb.TextWrapping(TextWrapping::Wrap);
-        dlg.Content(tb);
+        dlg.Content(sv);
         dlg.PrimaryButtonText(L"OK");
         dlg.XamlRoot(m_fileGrid.XamlRoot());
+
+        if (m_diskUsage) m_diskUsage->Cancel();
+        JoinWorker(m_diskUsageThread); // die vorige Analyse schreibt noch in m_diskUsageCache
+        m_diskUsage = usage;
+        m_diskUsageThread = std::thread([this, usage, root, files = std::move(files), tb, map]() {
+            DiskUsageOptions opt;
+            auto tree = usage->Run(std::filesystem::path(root), opt, [this, tb](DiskUsageProgress const& p) {
+                if (p.done) return;
+                auto top = p.top;
+                std::sort(top.begin(), top.end(), [](auto const& a, auto const& b) { return a.second > b.second; });
+                std::wstringstream ss;
+                ss << L"Bisher " << SizeText(p.totals.bytes) << L" in " << p.totals.files << L" Dateien, " << p.totals.dirs << L" Ordnern\n\n";
+                for (size_t i = 0; i < top.size() && i < 15; ++i) ss << top[i].first << L" - " << SizeText(top[i].second) << L"...\n";
+                m_uiQueue.TryEnqueue([tb, text = ss.str()]() { tb.Text(winrt::hstring(text)); });
+            }, &m_diskUsageCache);
+            if (!tree) {
+                if (!usage->Cancelled()) m_uiQueue.TryEnqueue([tb]() { tb.Text(L"Ordner nicht lesbar"); });
+                return;
+            }
+            std::shared_ptr<DiskUsageDir> result(std::move(tree));
+            m_uiQueue.TryEnqueue([tb, map, result, usage, files]() {
+                // Einträge des Ordners: Unterordner aus dem Baum, Dateien wie angezeigt
+                std::vector<std::pair<std::wstring, uint64_t>> sizes = files;
+                for (auto const& c : result->children) sizes.push_back({ c->name, c->total.bytes });
+                std::sort(sizes.begin(), sizes.end(), [](auto const& a, auto const& b) { return a.second > b.second; });
+                std::wstringstream ss;
+                auto const& t = result->total;
+                ss << SizeText(t.bytes) << L" (" << SizeText(t.allocated) << L" auf dem Datenträger) in " << t.files << L" Dateien, "
+                   << t.dirs << L" Ordnern";
+                if (t.errors) ss << L", " << t.errors << L" Ordner nicht lesbar";
+                ss << L"\n\nTop items by size:\n\n";
+                for (size_t i = 0; i < sizes.size() && i < 15; ++i) ss << sizes[i].first << L" - " << SizeText(sizes[i].second) << L"\n";
+                ss << L"\nLargest files:\n\n";
+                auto const& largest = usage->Largest();
+                for (size_t i = 0; i < largest.size() && i < 10; ++i) ss << largest[i].path << L" - " << SizeText(largest[i].size) << L"\n";
+                tb.Text(winrt::hstring(ss.str()));
+
+                // Treemap: zwei Ebenen, Farbe je Unterordner des Ordners, eigene Dateien grau
+                static const uint8_t palette[][3] = { {70,130,180}, {205,133,63}, {60,179,113}, {186,85,211}, {220,20,60},
+                                                      {218,165,32}, {72,209,204}, {244,164,96} };
+                std::vector<DiskUsageRect> rects;
+                DiskUsageTreemap(*result, 0, 0, map.Width(), map.Height(), 2, 24, rects);
+                for (auto const& r : rects) {
+                    const DiskUsageDir* top = r.dir;
+                    while (top->parent && top->parent != result.get()) top = top->parent;
+                    size_t index = 0;
+                    while (index < result->children.size() && result->children[index].get() != top) ++index;
+                    auto const* c = palette[index % 8];
+                    uint8_t shade = (uint8_t)(r.depth ? 200 : 255);
+                    Border b;
+                    b.Width(std::max(0.0, r.w - 1));
+                    b.Height(std::max(0.0, r.h - 1));
+                    b.Background(r.ownFiles ? SolidColorBrush(Windows::UI::ColorHelper::FromArgb(shade, 128, 128, 128))
+                                            : SolidColorBrush(Windows::UI::ColorHelper::FromArgb(shade, c[0], c[1], c[2])));
+                    uint64_t bytes = r.ownFiles ? r.dir->own.bytes : r.dir->total.bytes;
+                    std::wstring tip = (r.ownFiles ? r.dir->Path().wstring() + L" (Dateien)" : r.dir->Path().wstring()) + L" - " + SizeText(bytes);
+                    ToolTipService::SetToolTip(b, winrt::box_value(winrt::hstring(tip)));
+                    Canvas::SetLeft(b, r.x);
+                    Canvas::SetTop(b, r.y);
+                    map.Children().Append(b);
+                }
+            });
+        });
         co_await dlg.ShowAsync();
+        usage->Cancel();
     }
 
     // Recent handling (simple)
@@ -743,18 +1306,21 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         if (sortColumn == 0) sortAscending = !sortAscending;
         else sortAscending = true;
         sortColumn = 0;
+        m_viewRanked = false;
         SortAndRefresh();
     }
     void SortBySize(IInspectable const&, RoutedEventArgs const&) {
         if (sortColumn == 2) sortAscending = !sortAscending;
         else sortAscending = true;
         sortColumn = 2;
+        m_viewRanked = false;
         SortAndRefresh();
     }
     void SortByDate(IInspectable const&, RoutedEventArgs const&) {
         if (sortColumn == 3) sortAscending = !sortAscending;
         else sortAscending = true;
         sortColumn = 3;
+        m_viewRanked = false;
         SortAndRefresh();
     }
 
@@ -763,13 +1329,15 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         if (sortColumn == 1) sortAscending = !sortAscending;
         else sortAscending = true;
         sortColumn = 1;
+        m_viewRanked = false;
         SortAndRefresh();
     }
 
-    // New helper: get full path of first selected item (works with cards or legacy string items)
+    // New helper: get full path of first selected item (view positions, cards or legacy string items)
     std::wstring GetSelectedFullPath() {
         auto sel = m_fileGrid.SelectedItem();
         if (!sel) return {};
+        if (FileItem fi; ItemFromGridItem(sel, fi)) return fi.fullPath;
         auto fe = sel.try_as<FrameworkElement>();
         if (fe) {
             try {
@@ -786,59 +1354,23 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         return {};
     }
 
-    // Find FileItem by full path
-    std::vector<FileItem>::iterator FindItemByPath(std::wstring const& path) {
-        return std::find_if(currentItems.begin(), currentItems.end(), [&path](FileItem const& fi) { return fi.fullPath == path; });
+    // Item des aktuellen Ordners über den vollen Pfad (Hash-Index des ListingStore)
+    bool FindItemByPath(std::wstring const& path, FileItem& fi) {
+        uint32_t row = currentItems.Find(path);
+        if (row == ListingStore::kNone) return false;
+        fi = MakeFileItem(currentItems, row);
+        return true;
     }
 
-    // Create the Border card for GridView (used by PopulateFiles and SortAndRefresh)
-    Border CreateItemCard(FileItem const& fi) {
-        Border itemCard;
-        itemCard.CornerRadius(Microsoft::UI::Xaml::CornerRadius{ 8 });
-        itemCard.Padding(ThicknessHelper::FromUniformLength(8));
-        itemCard.Margin(ThicknessHelper::FromLengths(6, 6, 6, 6));
-        itemCard.Background(SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255, 48, 48, 48)));
-
-        StackPanel cardStack;
-        cardStack.Orientation(Orientation::Vertical);
-
-        TextBlock iconTb;
-        iconTb.FontSize(28);
-        iconTb.Margin(ThicknessHelper::FromLengths(0, 0, 0, 4));
-        iconTb.Text(winrt::hstring(fi.isFolder ? L"📁" : L"📄"));
-        iconTb.Foreground(SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255, 230, 230, 230)));
-
-        TextBlock nameTb;
-        nameTb.Text(winrt::hstring(fi.name));
-        nameTb.TextWrapping(TextWrapping::NoWrap);
-        nameTb.MaxWidth(220);
-        nameTb.FontSize(14);
-        nameTb.FontWeight(Windows::UI::Text::FontWeights::SemiBold());
-        nameTb.Foreground(SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255, 235, 235, 235)));
-
-        cardStack.Children().Append(iconTb);
-        cardStack.Children().Append(nameTb);
-
-        if (m_showDetails) {
-            std::wstringstream ss;
-            ss << L"Size: " << fi.size << L" bytes\n";
-            SYSTEMTIME stUTC, stLocal;
-            FileTimeToSystemTime(&fi.modifiedTime, &stUTC);
-            SystemTimeToTzSpecificLocalTime(NULL, &stUTC, &stLocal);
-            ss << L"Modified: " << stLocal.wDay << L"." << stLocal.wMonth << L"." << stLocal.wYear;
-            TextBlock detailsTb;
-            detailsTb.Text(winrt::hstring(ss.str()));
-            detailsTb.FontSize(11);
-            detailsTb.Opacity(0.9);
-            detailsTb.TextWrapping(TextWrapping::Wrap);
-            detailsTb.Margin(ThicknessHelper::FromLengths(0, 4, 0, 0));
-            detailsTb.Foreground(SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255, 190, 190, 190)));
-            cardStack.Children().Append(detailsTb);
-        }
-
-        itemCard.Child(cardStack);
-        itemCard.Tag(winrt::box_value(winrt::hstring(fi.fullPath)));
-        return itemCard;
+    // Schlagwörter einer Textdatei (TagExtractor.h): höchstens 1 MB in 64-KB-Blöcken, konstanter Speicher,
+    // Stoppwörter DE/EN/FR/ES; sobald der Volltextindex genug Dokumente hat, nach idf gewichtet.
+    // Ein Extraktor je Thread (Index-Pipeline, UI-Thread).
+    std::vector<std::wstring> ExtractTagsFromTextFile(std::wstring const& path, size_t topN = 5) {
+        thread_local TagExtractor extractor;
+        TagCorpusFn corpus = [this](std::vector<std::string_view> const& terms, uint32_t* df) { return m_fullText.DocFrequencies(terms, df); };
+        std::vector<std::wstring> tags;
+        for (auto const& t : extractor.File(path, topN, corpus)) tags.push_back(WStringFromUtf8(t.text));
+        return tags;
     }
 
     // Generate several rename suggestions (AI heuristics)
@@ -881,45 +1413,30 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         return uniq;
     }
 
+    // Sortiert nur die Positionsliste über vorberechnete Schlüssel (natürliche Zahlen im Namen, Typ-Rang,
+    // große Listen parallel); das Grid realisiert danach lediglich die sichtbaren Container neu
     void SortAndRefresh() {
-        std::sort(filteredItems.begin(), filteredItems.end(), [this](const FileItem& a, const FileItem& b) {
-            int comparison = 0;
-            switch (sortColumn) {
-            case 0: // Name
-                comparison = _wcsicmp(a.name.c_str(), b.name.c_str());
-                break;
-            case 1: { // Type (extension)
-                auto extA = std::filesystem::path(a.name).extension().wstring();
-                auto extB = std::filesystem::path(b.name).extension().wstring();
-                // case-insensitive
-                comparison = _wcsicmp(extA.c_str(), extB.c_str());
-                if (comparison == 0) comparison = _wcsicmp(a.name.c_str(), b.name.c_str());
-                break;
-            }
-            case 2: // Size
-                if (a.size < b.size) comparison = -1;
-                else if (a.size > b.size) comparison = 1;
-                else comparison = 0;
-                break;
-            case 3: // Date
-                comparison = CompareFileTime(&a.modifiedTime, &b.modifiedTime);
-                break;
-            }
-            return sortAscending ? (comparison < 0) : (comparison > 0);
-        });
-
-        m_fileGrid.Items().Clear();
-        for (auto const& fi : filteredItems) {
-            m_fileGrid.Items().Append(CreateItemCard(fi));
+        if (!m_viewRanked) {
+            auto& keys = ViewKeys();
+            SortSpec spec = ViewSortSpec();
+            if (!keys.IsSorted(m_view, spec)) keys.Sort(m_view, spec, &m_fuzzyPool);
         }
+        RefreshView();
+    }
+
+    // Positionen haben sich verschoben: alte Auswahl würde auf andere Dateien zeigen
+    void RefreshView() {
+        m_fileGrid.SelectedItems().Clear();
+        CancelThumbnails();
+        m_itemsSource->Reset((uint32_t)m_view.size());
     }
 
     void CopyItem(IInspectable const&, RoutedEventArgs const&) {
         std::wstring selPath = GetSelectedFullPath();
         if (selPath.empty()) return;
-        auto it = FindItemByPath(selPath);
-        if (it == currentItems.end()) return;
-        std::wstring path = it->fullPath;
+        FileItem fi;
+        if (!FindItemByPath(selPath, fi)) return;
+        std::wstring path = fi.fullPath;
         // Build CF_HDROP data (use double null termination)
         size_t len = sizeof(DROPFILES) + (path.length() + 2) * sizeof(wchar_t);
         HGLOBAL hg = GlobalAlloc(GHND, len);
@@ -943,55 +1460,149 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
     }
 
     void PasteItem(IInspectable const&, RoutedEventArgs const&) {
+        std::vector<std::filesystem::path> sources;
         if (OpenClipboard(nullptr)) {
             HANDLE hData = GetClipboardData(CF_HDROP);
             if (hData) {
                 HDROP hDrop = (HDROP)GlobalLock(hData);
                 if (hDrop) {
                     UINT fileCount = DragQueryFileW(hDrop, 0xFFFFFFFF, nullptr, 0);
-                    if (fileCount > 0) {
-                        UINT totalLen = 0;
-                        for (UINT i = 0; i < fileCount; ++i) {
-                            totalLen += DragQueryFileW(hDrop, i, nullptr, 0);
-                        }
-                        totalLen += fileCount + 1;
-
-                        std::vector<wchar_t> fromPath(totalLen);
-                        wchar_t* current = fromPath.data();
-                        for (UINT i = 0; i < fileCount; ++i) {
-                            UINT len = DragQueryFileW(hDrop, i, current, totalLen - (current - fromPath.data()));
-                            current += len + 1;
-                        }
-                        *current = L'\0';
-
-                        std::wstring toPathStr = m_addressBar.Text().c_str();
-                        std::vector<wchar_t> toPath(toPathStr.length() + 2, 0);
-                        wcscpy_s(toPath.data(), toPathStr.length() + 1, toPathStr.c_str());
-
-                        SHFILEOPSTRUCTW fileOp = { 0 };
-                        fileOp.wFunc = FO_COPY;
-                        fileOp.pFrom = fromPath.data();
-                        fileOp.pTo = toPath.data();
-                        fileOp.fFlags = FOF_ALLOWUNDO;
-
-                        if (SHFileOperationW(&fileOp) == 0 && !fileOp.fAnyOperationsAborted) {
-                            PopulateFiles(m_addressBar.Text());
-                        }
+                    for (UINT i = 0; i < fileCount; ++i) {
+                        std::wstring path(DragQueryFileW(hDrop, i, nullptr, 0), L'\0');
+                        DragQueryFileW(hDrop, i, path.data(), (UINT)path.size() + 1);
+                        sources.push_back(path);
                     }
                     GlobalUnlock(hData);
                 }
             }
             CloseClipboard();
         }
+        if (!sources.empty()) StartCopy(std::move(sources), m_addressBar.Text().c_str());
         m_fileGrid.SelectedItem(nullptr); // Auswahl zurücksetzen
     }
 
+    // Ziehen aus dem Raster: Pfade als Text (ein Pfad pro Zeile); DropFiles nimmt Dateien und solche Texte an
+    void DragStart(IInspectable const&, DragItemsStartingEventArgs const& args) {
+        std::wstring paths;
+        for (auto const& item : args.Items()) {
+            FileItem fi;
+            if (ItemFromGridItem(item, fi)) paths += fi.fullPath + L"\n";
+        }
+        if (paths.empty()) { args.Cancel(true); return; }
+        args.Data().SetText(winrt::hstring(paths));
+        args.Data().RequestedOperation(DataPackageOperation::Copy);
+    }
+
+    void DragOverFiles(IInspectable const&, DragEventArgs const& args) {
+        auto view = args.DataView();
+        if (view.Contains(StandardDataFormats::StorageItems()) || view.Contains(StandardDataFormats::Text()))
+            args.AcceptedOperation(DataPackageOperation::Copy);
+    }
+
+    fire_and_forget DropFiles(IInspectable const&, DragEventArgs const& e) {
+        auto args = e; // nach co_await ist die Referenz ungültig
+        std::wstring target = m_addressBar.Text().c_str();
+        if (target.empty()) co_return;
+        auto deferral = args.GetDeferral();
+        std::vector<std::filesystem::path> sources;
+        auto view = args.DataView();
+        if (view.Contains(StandardDataFormats::StorageItems())) {
+            auto items = co_await view.GetStorageItemsAsync();
+            for (auto const& item : items)
+                if (!item.Path().empty()) sources.push_back(item.Path().c_str()); // virtuelle Dateien ohne Pfad: nicht unterstützt
+        }
+        else if (view.Contains(StandardDataFormats::Text())) {
+            std::wstringstream ss((co_await view.GetTextAsync()).c_str());
+            for (std::wstring line; std::getline(ss, line);) {
+                if (!line.empty() && line.back() == L'\r') line.pop_back();
+                if (!line.empty() && std::filesystem::exists(line)) sources.push_back(line);
+            }
+        }
+        args.AcceptedOperation(sources.empty() ? DataPackageOperation::None : DataPackageOperation::Copy);
+        deferral.Complete();
+        if (!sources.empty()) StartCopy(std::move(sources), target);
+    }
+
+    // Kopierauftrag mit Fortschrittsdialog; "Ausblenden" schließt nur den Dialog, die Kopie läuft weiter
+    fire_and_forget StartCopy(std::vector<std::filesystem::path> sources, std::wstring target) {
+        TextBlock tb; tb.TextWrapping(TextWrapping::Wrap); tb.Text(L"Ermittle Dateien...");
+        ProgressBar bar; bar.Minimum(0); bar.Maximum(1000); bar.IsIndeterminate(true);
+        StackPanel sp; sp.Orientation(Orientation::Vertical); sp.Spacing(8);
+        sp.Children().Append(bar);
+        sp.Children().Append(tb);
+        ContentDialog dlg;
+        dlg.Title(winrt::box_value(winrt::hstring(L"Kopieren nach " + target)));
+        dlg.Content(sp);
+        dlg.PrimaryButtonText(m_copyEngine.Paused() ? L"Fortsetzen" : L"Pause");
+        dlg.SecondaryButtonText(L"Abbrechen");
+        dlg.CloseButtonText(L"Ausblenden");
+        dlg.XamlRoot(m_fileGrid.XamlRoot());
+        dlg.PrimaryButtonClick([this](ContentDialog const& d, ContentDialogButtonClickEventArgs const& a) {
+            a.Cancel(true); // Dialog bleibt offen
+            if (m_copyEngine.Paused()) { m_copyEngine.Resume(); d.PrimaryButtonText(L"Pause"); }
+            else { m_copyEngine.Pause(); d.PrimaryButtonText(L"Fortsetzen"); }
+        });
+
+        CopyJob job;
+        job.sources = std::move(sources);
+        job.target = target;
+        job.options.verify = m_copyVerify;
+        job.onProgress = [this, tb, bar](CopyProgress const& p) {
+            std::wstringstream ss;
+            if (p.planning) ss << L"Ermittle Dateien... " << p.files << L" Dateien, " << SizeText(p.bytes);
+            else ss << p.filesDone + p.skipped << L" von " << p.files << L" Dateien, " << SizeText(p.bytesDone) << L" von " << SizeText(p.bytes);
+            if (p.failed) ss << L", " << p.failed << L" Fehler";
+            if (p.paused) ss << L" (pausiert)";
+            double value = p.bytes ? 1000.0 * (double)p.bytesDone / (double)p.bytes : 0.0;
+            m_uiQueue.TryEnqueue([tb, bar, text = ss.str(), value, planning = p.planning]() {
+                tb.Text(winrt::hstring(text));
+                bar.IsIndeterminate(planning);
+                bar.Value(value);
+            });
+        };
+        job.onDone = [this, tb, bar, dlg, target](CopyResult const& r) {
+            std::wstringstream ss;
+            auto const& t = r.totals;
+            ss << (r.cancelled ? L"Abgebrochen: " : L"Fertig: ") << t.filesDone << L" Dateien kopiert (" << SizeText(t.bytesDone) << L")";
+            if (t.skipped) ss << L", " << t.skipped << L" übersprungen";
+            if (t.failed) ss << L", " << t.failed << L" Fehler";
+            for (size_t i = 0; i < r.failures.size() && i < 10; ++i)
+                ss << L"\n" << r.failures[i].source.wstring() << L" - " << winrt::to_hstring(r.failures[i].what).c_str();
+            m_uiQueue.TryEnqueue([this, tb, bar, dlg, target, text = ss.str()]() {
+                tb.Text(winrt::hstring(text));
+                bar.IsIndeterminate(false);
+                bar.Value(1000);
+                dlg.PrimaryButtonText(L"");
+                dlg.SecondaryButtonText(L"");
+                dlg.CloseButtonText(L"OK");
+                if (target == m_addressBar.Text().c_str()) PopulateFiles(m_addressBar.Text());
+            });
+        };
+        uint64_t id = m_copyEngine.Enqueue(std::move(job));
+        auto res = co_await dlg.ShowAsync();
+        if (res == ContentDialogResult::Secondary) m_copyEngine.Cancel(id);
+    }
+
+    // Aufträge, deren Journal ein Absturz oder das Schließen übrig gelassen hat, ohne Dialog fortsetzen
+    void ResumeCopyJobs() {
+        m_copyEngine.SetJournalDir(std::filesystem::path(GetFavoritesPath()).parent_path() / L"copyjobs");
+        for (auto& job : m_copyEngine.Interrupted()) {
+            std::wstring target = job.target.wstring();
+            job.onDone = [this, target](CopyResult const&) {
+                m_uiQueue.TryEnqueue([this, target]() {
+                    if (target == m_addressBar.Text().c_str()) PopulateFiles(m_addressBar.Text());
+                });
+            };
+            m_copyEngine.Enqueue(std::move(job));
+        }
+    }
+
     void DeleteItem(IInspectable const&, RoutedEventArgs const&) {
         std::wstring selPath = GetSelectedFullPath();
         if (selPath.empty()) return;
-        auto it = FindItemByPath(selPath);
-        if (it == currentItems.end()) return;
-        std::wstring path = it->fullPath;
+        FileItem fi;
+        if (!FindItemByPath(selPath, fi)) return;
+        std::wstring path = fi.fullPath;
         std::vector<wchar_t> doubleNullPath(path.length() + 2, 0);
         wcscpy_s(doubleNullPath.data(), path.length() + 1, path.c_str());
 
@@ -1009,10 +1620,9 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
     fire_and_forget RenameItem(IInspectable const&, RoutedEventArgs const&) {
         std::wstring selPath = GetSelectedFullPath();
         if (selPath.empty()) co_return;
-        auto it = FindItemByPath(selPath);
-        if (it == currentItems.end()) co_return;
+        FileItem fi;
+        if (!FindItemByPath(selPath, fi)) co_return;
 
-        FileItem fi = *it;
         // Build suggestions
         auto suggestions = GenerateRenameSuggestions(fi);
 
@@ -1046,11 +1656,11 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         auto result = co_await dialog.ShowAsync();
         if (result == ContentDialogResult::Primary) {
             std::wstring newName = input.Text().c_str();
-            if (!newName.empty() && newName != it->name) {
-                std::filesystem::path pold(it->fullPath);
+            if (!newName.empty() && newName != fi.name) {
+                std::filesystem::path pold(fi.fullPath);
                 std::wstring newPath = pold.parent_path().wstring() + L"\\" + newName;
                 // push undo entry
-                m_undoStack.emplace_back(std::wstring(L"rename"), it->fullPath, newPath);
+                m_undoStack.push_back({ L"rename", fi.fullPath, newPath, {} });
                 MoveFile(pold.wstring().c_str(), newPath.c_str());
                 PopulateFiles(m_addressBar.Text());
             }
@@ -1062,9 +1672,8 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
     fire_and_forget SuggestRename(IInspectable const&, RoutedEventArgs const&) {
         std::wstring selPath = GetSelectedFullPath();
         if (selPath.empty()) co_return;
-        auto it = FindItemByPath(selPath);
-        if (it == currentItems.end()) co_return;
-        FileItem fi = *it;
+        FileItem fi;
+        if (!FindItemByPath(selPath, fi)) co_return;
         auto suggestions = GenerateRenameSuggestions(fi);
         if (suggestions.empty()) {
             ContentDialog dlg; dlg.Title(box_value(winrt::hstring(L"AI Vorschläge"))); TextBlock tb; tb.Text(winrt::hstring(L"No suggestions")); dlg.Content(tb); dlg.PrimaryButtonText(L"OK"); dlg.XamlRoot(m_fileGrid.XamlRoot()); co_await dlg.ShowAsync(); co_return;
@@ -1088,15 +1697,79 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         }
     }
 
-    // BatchRename: use Tag-based selected items and optionally use AI suggestions pattern
+    // Duplikate unter dem aktuellen Ordner: Größe -> Stichprobe (Anfang/Ende) -> voller SHA-1 (DuplicateFinder.h).
+    // Gruppen erscheinen, sobald sie bestätigt sind; noch gültige Hashes aus m_index werden übernommen,
+    // neu berechnete in den Index zurückgeschrieben. Schließen des Dialogs bricht ab.
+    fire_and_forget FindDuplicates(IInspectable const&, RoutedEventArgs const&) {
+        std::wstring root = m_addressBar.Text().c_str();
+        if (root.empty()) co_return;
+        auto finder = std::make_shared<DuplicateFinder>();
+        auto textBrush = SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255,230,230,230));
+        StackPanel sp; sp.Orientation(Orientation::Vertical);
+        TextBlock status; status.Text(L"Searching..."); status.Foreground(SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255,190,190,190)));
+        StackPanel groups; groups.Orientation(Orientation::Vertical);
+        ScrollViewer scroll; scroll.Content(groups); scroll.MaxHeight(480);
+        sp.Children().Append(status);
+        sp.Children().Append(scroll);
+
+        DupOptions opt;
+        opt.includeHidden = m_showHidden;
+        DupStages stages;
+        stages.cachedHash = [this](DupFile const& f, HashDigest& d) {
+            FileIndexEntry e;
+            std::lock_guard<std::mutex> lg(m_indexMutex);
+            if (!m_index.Find(f.path, e) || e.size != f.size || e.mtime != f.mtime || e.hashLen == 0) return false;
+            memcpy(d.bytes, e.hash, e.hashLen);
+            d.len = e.hashLen;
+            return true;
+        };
+        stages.fullHash = [this](DupFile const& f, HashDigest& d, std::atomic<bool> const& cancel) {
+            if (!HashFile(f.path, HashAlgo::Sha1, d, &cancel)) return false;
+            FileIndexEntry e;
+            std::lock_guard<std::mutex> lg(m_indexMutex);
+            if (m_index.Find(f.path, e) && e.size == f.size && e.mtime == f.mtime) {
+                memcpy(e.hash, d.bytes, d.len);
+                e.hashLen = d.len;
+                m_index.Put(e);
+            }
+            return true;
+        };
+        auto shown = std::make_shared<std::atomic<int>>(0);
+        stages.onGroup = [this, groups, textBrush, shown](DupGroup&& g) {
+            if (shown->fetch_add(1) >= 500) return; // Zähler im Status laufen weiter
+            std::wstringstream ss;
+            ss << g.paths.size() << L" x " << g.size << L" bytes (" << g.Wasted() << L" bytes wasted)";
+            for (auto const& p : g.paths) ss << L"\n    " << p;
+            m_uiQueue.TryEnqueue([groups, textBrush, text = ss.str()]() {
+                TextBlock tb; tb.Text(winrt::hstring(text)); tb.Foreground(textBrush); tb.Margin(ThicknessHelper::FromLengths(0, 0, 0, 8));
+                groups.Children().Append(tb);
+            });
+        };
+        stages.onProgress = [this, status](DupProgress const& p) {
+            std::wstringstream ss;
+            ss << (p.walkDone ? L"" : L"Scanning... ") << p.files << L" files, " << p.fullCandidates << L" candidates, "
+               << p.groups << L" groups, " << (p.wastedBytes >> 20) << L" MB wasted";
+            m_uiQueue.TryEnqueue([status, text = ss.str()]() { status.Text(winrt::hstring(text)); });
+        };
+        if (m_dupFinder) m_dupFinder->Cancel();
+        JoinWorker(m_dupThread);
+        m_dupFinder = finder;
+        m_dupThread = std::thread([finder, root, opt, stages]() { finder->Run({ std::filesystem::path(root) }, opt, stages); });
+
+        ContentDialog dlg; dlg.Title(box_value(winrt::hstring(L"Duplicates"))); dlg.Content(sp); dlg.PrimaryButtonText(L"Close"); dlg.XamlRoot(m_fileGrid.XamlRoot());
+        co_await dlg.ShowAsync();
+        finder->Cancel();
+        SaveIndex();
+    }
+
+    // BatchRename: Pattern ({n} = laufende Nummer) oder AI-Vorschlag je Datei; alle Umbenennungen als eine
+    // Transaktion (RenamePlanner.h), auf dem Undo-Stack als eine Gruppe
     fire_and_forget BatchRename(IInspectable const&, RoutedEventArgs const&) {
         // Get selection as full paths
         std::vector<std::wstring> selPaths;
         for (uint32_t i = 0; i < m_fileGrid.SelectedItems().Size(); ++i) {
             auto item = m_fileGrid.SelectedItems().GetAt(i);
-            auto fe = item.try_as<FrameworkElement>();
-            if (!fe) continue;
-            try { selPaths.push_back(unbox_value<hstring>(fe.Tag()).c_str()); } catch (...) {}
+            if (FileItem fi; ItemFromGridItem(item, fi)) selPaths.push_back(fi.fullPath);
         }
         if (selPaths.empty()) co_return;
 
@@ -1109,10 +1782,11 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         if (res != ContentDialogResult::Primary) co_return;
         std::wstring pattern = patternBox.Text().c_str();
 
+        std::vector<RenameOp> renames;
         int idx = 1;
         for (auto const& path : selPaths) {
-            auto it = FindItemByPath(path);
-            if (it == currentItems.end()) continue;
+            FileItem fi;
+            if (!FindItemByPath(path, fi)) continue;
             std::wstring newName;
             if (!pattern.empty()) {
                 newName = pattern;
@@ -1122,16 +1796,62 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
                 }
             } else {
                 // AI suggestion for this item
-                auto sugg = GenerateRenameSuggestions(*it);
-                newName = sugg.empty() ? it->name : sugg.front();
+                auto sugg = GenerateRenameSuggestions(fi);
+                newName = sugg.empty() ? fi.name : sugg.front();
             }
-            std::filesystem::path oldp(it->fullPath);
-            std::filesystem::path newp = oldp.parent_path() / newName;
-            // record undo (src, dst)
-            m_undoStack.emplace_back(std::wstring(L"rename"), oldp.wstring(), newp.wstring());
-            try { std::filesystem::rename(oldp, newp); } catch (...) {}
+            std::filesystem::path oldp(fi.fullPath);
+            renames.push_back({ oldp, oldp.parent_path() / newName });
         }
-        PopulateFiles(m_addressBar.Text());
+        RunRenames(std::move(renames), {});
+    }
+
+    // Planen im Hintergrund (stat / Ordnerlisten), bei Konflikten nachfragen, dann ausführen. restore: beim
+    // Rückgängigmachen die Gruppe, die wieder auf den Stack kommt, wenn es nicht klappt
+    void RunRenames(std::vector<RenameOp> renames, std::vector<RenameOp> restore) {
+        if (renames.empty()) return;
+        JoinWorker(m_renamePlanThread);
+        m_renamePlanThread = std::thread([this, renames = std::move(renames), restore = std::move(restore)]() mutable {
+            auto plan = std::make_shared<RenamePlan>(RenamePlanner::Plan(renames));
+            m_uiQueue.TryEnqueue([this, plan, restore = std::move(restore)]() mutable { ApplyRenames(plan, std::move(restore)); });
+        });
+    }
+
+    fire_and_forget ApplyRenames(std::shared_ptr<RenamePlan> plan, std::vector<RenameOp> restore) {
+        if (!plan->problems.empty()) {
+            std::wstringstream ss;
+            ss << plan->problems.size() << L" von " << plan->problems.size() + plan->ops.size() << L" Umbenennungen nicht möglich:\n\n";
+            for (size_t i = 0; i < plan->problems.size() && i < 20; ++i) {
+                auto const& p = plan->problems[i];
+                ss << p.op.from.filename().wstring() << L" -> " << p.op.to.filename().wstring() << L": "
+                   << winrt::to_hstring(RenamePlanner::IssueText(p.issue)).c_str() << L"\n";
+            }
+            TextBlock tb; tb.TextWrapping(TextWrapping::Wrap); tb.Text(winrt::hstring(ss.str()));
+            ScrollViewer sv; sv.Content(tb);
+            ContentDialog dlg; dlg.Title(box_value(winrt::hstring(L"Batch-Rename"))); dlg.Content(sv); dlg.CloseButtonText(L"Abbrechen"); dlg.XamlRoot(m_fileGrid.XamlRoot());
+            if (!plan->ops.empty()) dlg.PrimaryButtonText(L"Übrige umbenennen");
+            if (co_await dlg.ShowAsync() != ContentDialogResult::Primary) {
+                if (!restore.empty()) m_undoStack.push_back({ L"renames", L"", L"", std::move(restore) });
+                co_return;
+            }
+        }
+        if (plan->ops.empty()) co_return;
+        JoinWorker(m_renameThread); // Umbenennungen nacheinander
+        m_renameThread = std::thread([this, plan, restore = std::move(restore)]() mutable {
+            RenameResult result = m_renamer.Execute(*plan);
+            m_uiQueue.TryEnqueue([this, plan, result, restore = std::move(restore)]() mutable {
+                if (result.ok && restore.empty()) m_undoStack.push_back({ L"renames", L"", L"", plan->ops });
+                if (!result.ok && !restore.empty()) m_undoStack.push_back({ L"renames", L"", L"", std::move(restore) });
+                PopulateFiles(m_addressBar.Text());
+                if (result.ok) return;
+                std::wstringstream ss;
+                ss << result.failed.from.filename().wstring() << L" -> " << result.failed.to.filename().wstring() << L": "
+                   << winrt::to_hstring(result.error).c_str() << L"\n\n";
+                if (result.notUndone.empty()) ss << L"Keine Datei wurde umbenannt (" << result.done << L" Umbenennungen zurückgenommen).";
+                else ss << result.notUndone.size() << L" Umbenennungen ließen sich nicht zurücknehmen, z. B. "
+                        << result.notUndone.front().to.wstring() << L".";
+                ContentDialog dlg; dlg.Title(box_value(winrt::hstring(L"Batch-Rename fehlgeschlagen"))); dlg.Content(box_value(winrt::hstring(ss.str()))); dlg.PrimaryButtonText(L"OK"); dlg.XamlRoot(m_fileGrid.XamlRoot()); dlg.ShowAsync();
+            });
+        });
     }
 
     // Settings load/save
@@ -1150,6 +1870,15 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
                 if (root.isMember("fuzzyThreshold")) m_fuzzyThreshold = root["fuzzyThreshold"].asInt();
                 if (root.isMember("showHidden")) m_showHidden = root["showHidden"].asBool();
                 if (root.isMember("showDetails")) m_showDetails = root["showDetails"].asBool();
+                if (root.isMember("thumbnailMemoryMB")) m_thumbMemoryMB = root["thumbnailMemoryMB"].asUInt();
+                if (root.isMember("thumbnailDiskMB")) m_thumbDiskMB = root["thumbnailDiskMB"].asUInt();
+                if (root.isMember("copyVerify")) m_copyVerify = root["copyVerify"].asBool();
+                if (root.isMember("searchExclude")) {
+                    m_searchExclude.clear();
+                    for (auto const& v : root["searchExclude"]) m_searchExclude.push_back(WStringFromUtf8(v.asString()));
+                }
+                m_thumbMemory.SetBudget((size_t)m_thumbMemoryMB << 20);
+                m_thumbDisk.SetBudget((uint64_t)m_thumbDiskMB << 20);
             }
         } catch (...) {}
     }
@@ -1162,6 +1891,11 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
             root["fuzzyThreshold"] = m_fuzzyThreshold;
             root["showHidden"] = m_showHidden;
             root["showDetails"] = m_showDetails;
+            root["thumbnailMemoryMB"] = m_thumbMemoryMB;
+            root["thumbnailDiskMB"] = m_thumbDiskMB;
+            root["copyVerify"] = m_copyVerify;
+            root["searchExclude"] = Json::Value(Json::arrayValue);
+            for (auto const& n : m_searchExclude) root["searchExclude"].append(Utf8FromWString(n));
             Json::StreamWriterBuilder w; w["indentation"] = "  ";
             auto out = Json::writeString(w, root);
             std::ofstream f(m_settingsPath, std::ios::binary);
@@ -1171,7 +1905,8 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
 
     // Clear thumbnail cache helper
     void ClearThumbnailCache() {
-        m_thumbnailCache.clear();
+        m_thumbMemory.Clear();
+        ThumbDisk().Clear();
     }
 
     // Indexer controls
@@ -1180,94 +1915,143 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         m_indexRunning = true;
         m_progressBar.Value(0);
         std::wstring root = m_addressBar.Text().c_str();
+        m_indexSync.Cancel();
+        JoinWorker(m_indexThread); // der vorige Lauf ist fertig oder abgebrochen
         m_indexThread = std::thread([this, root]() {
-            this->BuildIndex(root);
+            m_fsWatcher.Stop(); // der Lauf gleicht ohnehin alles ab
+            bool complete = this->BuildIndex(root);
+            if (complete) WatchIndexRoot(root);
             // update UI after done (post to UI thread)
-            DispatcherQueue::GetForCurrentThread().TryEnqueue([this]() {
+            m_uiQueue.TryEnqueue([this]() {
                 m_indexRunning = false;
                 m_progressBar.Value(100);
                 SaveIndex();
                 PopulateFiles(m_addressBar.Text());
             });
         });
-        m_indexThread.detach();
     }
 
     void StopIndexing() {
         if (!m_indexRunning) return;
-        m_indexRunning = false; // BuildIndex should check this flag
+        m_indexRunning = false;
+        m_indexPipeline.Cancel();
         m_indexCv.notify_all();
     }
 
-    void BuildIndex(std::wstring root) {
-        try {
+    // Inkrementeller Indexlauf: Dateien mit unveränderter Größe + Änderungszeit werden nicht neu gelesen,
+    // verschwundene Einträge unter root entfernt. Paralleler Walk, m_indexMutex nur je Batch.
+    // false = abgebrochen (dann wird nichts entfernt)
+    bool BuildIndex(std::wstring root) {
+        IndexPipelineStages stages;
+        stages.hash = [](FileIndexEntry& e) {
+            HashDigest d;
+            if (!HashFile(e.path, HashAlgo::Sha1, d)) return;
+            memcpy(e.hash, d.bytes, d.len);
+            e.hashLen = d.len;
+        };
+        stages.tags = [this](FileIndexEntry& e) {
+            try { e.tags = ExtractTagsFromTextFile(e.path, 5); } catch (...) {}
+            m_fullText.AddFile(e.path, e.size, e.mtime); // Datei liegt gerade ohnehin im Cache
+            m_semantic.AddFile(e.path, e.size, e.mtime);
+        };
+        stages.onProgress = [this](IndexProgress const& p) {
+            // solange der Walk läuft, ist die Gesamtzahl noch unbekannt: dann höchstens 90 %
+            uint64_t total = p.discovered - p.skipped;
+            int percent = total ? (int)(p.done * (p.walkDone ? 100 : 90) / total) : 0;
+            m_uiQueue.TryEnqueue([this, percent]() { m_progressBar.Value(percent); });
+        };
+        m_indexSync.SetStages(stages);
+        IndexPipelineOptions opt;
+        opt.includeHidden = m_showHidden;
+        if (!m_indexSync.Rescan(std::filesystem::path(root), opt, m_indexPipeline)) return false;
+        SyncContentIndexes();
+        return true;
+    }
+
+    // Volltext und Ähnlichkeitssuche an m_index angleichen: was dort fehlt, fliegt raus; was fehlt oder
+    // sich geändert hat (unveränderte Dateien laufen nicht durch die Tags-Stufe), wird parallel gelesen.
+    // Danach Commit bzw. Build + Save; im Hintergrund werden Volltext-Segmente zusammengeführt.
+    void SyncContentIndexes() {
+        std::vector<FileIndexEntry> missing;
+        std::vector<uint8_t> need; // Bit 0: Volltext, Bit 1: semantisch
+        {
             std::lock_guard<std::mutex> lg(m_indexMutex);
-            m_index.clear();
-            std::vector<std::wstring> files;
-            for (auto const& entry : std::filesystem::recursive_directory_iterator(root)) {
-                if (entry.is_regular_file()) files.push_back(entry.path().wstring());
-                if (!m_indexRunning) break;
-            }
-            size_t total = files.size();
-            for (size_t i = 0; i < files.size() && m_indexRunning; ++i) {
-                auto const& path = files[i];
-                Json::Value meta;
-                try {
-                    meta["path"] = Utf8FromWString(path);
-                    meta["sha1"] = ComputeFileSHA1(path);
-                    meta["size"] = (Json::UInt64)std::filesystem::file_size(path);
-                    auto tags = ExtractTagsFromTextFile(path, 5);
-                    for (auto const& t : tags) meta["tags"].append(Utf8FromWString(t));
-                } catch (...) {}
-                m_index[path] = meta;
-                // update progress on UI thread
-                int percent = total ? (int)((i * 100) / total) : 0;
-                DispatcherQueue::GetForCurrentThread().TryEnqueue([this, percent]() {
-                    m_progressBar.Value(percent);
-                });
-                // small pause to be responsive
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-        } catch (...) {}
+            auto gone = [this](IndexStringView p) { return !m_index.Contains(p); };
+            m_fullText.RemoveIf(gone);
+            m_semantic.RemoveIf(gone);
+            m_index.ForEach([&](FileIndexEntry const& e) {
+                uint8_t n = (m_fullText.Contains(e.path, e.size, e.mtime) ? 0 : 1) | (m_semantic.Contains(e.path, e.size, e.mtime) ? 0 : 2);
+                if (!n) return;
+                missing.push_back(e);
+                need.push_back(n);
+            });
+        }
+        if (!missing.empty()) {
+            WorkPool pool;
+            for (size_t i = 0; i < missing.size(); ++i) pool.Submit([this, &e = missing[i], n = need[i]]() {
+                if (n & 1) m_fullText.AddFile(e.path, e.size, e.mtime);
+                if (n & 2) m_semantic.AddFile(e.path, e.size, e.mtime);
+            });
+            pool.WaitIdle();
+        }
+        m_fullText.Commit();
+        m_semantic.Build();
+        m_semantic.Save();
+    }
+
+    // Nach einem vollständigen Lauf: Änderungen unter root gebündelt (200 ms Ruhe, spätestens 2 s) nachziehen
+    void WatchIndexRoot(std::wstring root) {
+        std::filesystem::path dir(root);
+        IndexPipelineOptions opt;
+        opt.includeHidden = m_showHidden;
+        m_fsWatcher.Start(dir, [this, dir, opt](std::vector<FsEvent>&& events) {
+            m_indexSync.Apply(events, dir, opt);
+            SyncContentIndexes();
+            SaveIndex();
+        });
+    }
+
+    // SHA-1 des Dateiinhalts als Hex (Hashing.h: SHA-NI, falls vorhanden); leer, wenn nicht lesbar.
+    // Bleibt SHA-1, damit die im Index gespeicherten Hashes vergleichbar bleiben.
+    std::string ComputeFileSHA1(std::wstring const& path) {
+        HashDigest d;
+        if (!HashFile(path, HashAlgo::Sha1, d)) return {};
+        return d.Hex();
     }
 
+    // Log auf die Platte bringen; ist es groß geworden, neuen Snapshot (index.bin) schreiben
     void SaveIndex() {
         try {
-            Json::Value root;
-            for (auto const& kv : m_index) {
-                Json::Value m = kv.second;
-                root[Utf8FromWString(kv.first)] = m;
-            }
-            Json::StreamWriterBuilder w;
-            w["indentation"] = "  ";
-            auto out = Json::writeString(w, root);
-            auto p = std::filesystem::path(GetFavoritesPath()).parent_path() / L"index.json";
-            std::ofstream f(p.wstring(), std::ios::binary);
-            if (f.is_open()) f << out;
+            std::lock_guard<std::mutex> lg(m_indexMutex);
+            m_index.Flush();
+            if (m_index.NeedsCompaction()) m_index.Compact();
         } catch (...) {}
     }
 
     void LoadIndex() {
         try {
-            auto p = std::filesystem::path(GetFavoritesPath()).parent_path() / L"index.json";
-            if (!std::filesystem::exists(p)) return;
-            std::ifstream f(p.wstring(), std::ios::binary);
-            if (!f.is_open()) return;
-            std::string content((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
-            Json::CharReaderBuilder rb;
-            std::unique_ptr<Json::CharReader> r(rb.newCharReader());
-            Json::Value root; std::string errs;
-            if (r->parse(content.c_str(), content.c_str() + content.size(), &root, &errs)) {
-                std::lock_guard<std::mutex> lg(m_indexMutex);
-                m_index.clear();
-                for (auto it = root.begin(); it != root.end(); ++it) {
-                    std::wstring key = WStringFromUtf8(it.memberName());
-                    m_index[key] = *it;
-                }
+            auto dir = std::filesystem::path(GetFavoritesPath()).parent_path();
+            std::lock_guard<std::mutex> lg(m_indexMutex);
+            m_index.Open(dir);
+            auto json = dir / L"index.json";
+            if (m_index.Size() == 0 && std::filesystem::exists(json)) MigrateJsonIndex(json);
+            m_fullText.Open(dir / L"fulltext");
+            if (m_semantic.Open(dir)) {
+                JoinWorker(m_semanticThread);
+                m_semanticThread = std::thread([this]() { m_semantic.Build(); }); // Graph liegt nicht auf der Platte
             }
         } catch (...) {}
     }
 
+    // Einmalige Übernahme eines alten index.json (bleibt als index.json.bak liegen). mtime ist dort
+    // nicht gespeichert und bleibt 0, solche Einträge gelten beim nächsten Indexlauf als geändert.
+    void MigrateJsonIndex(std::filesystem::path const& json) {
+        // direkt aus dem Mapping gelesen (IndexJsonImporter), ohne Json::Value-Baum
+        if (!IndexJsonImporter::Import(json, m_index)) return;
+        std::error_code ec;
+        if (m_index.Compact()) std::filesystem::rename(json, json.wstring() + L".bak", ec);
+    }
+
     // Semantic search: dialog to input query and show matching index entries
     void SemanticSearchDialog() {
         ContentDialog dlg;
@@ -1284,32 +2068,15 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         if (res != ContentDialogResult::Primary) return;
         std::wstring query = q.Text().c_str();
         if (query.empty()) return;
-        // simple semantic: compare tag overlap + name fuzzy
-        std::vector<std::pair<int,std::wstring>> scored;
-        std::vector<std::wstring> qtags = ExtractTagsFromTextFile(query, 8); // treat query as pseudo-file
-        for (auto const& kv : m_index) {
-            int score = 0;
-            auto const& meta = kv.second;
-            if (meta.isMember("tags")) {
-                for (auto const& qt : qtags) {
-                    std::string qt8 = Utf8FromWString(qt);
-                    for (auto const& mt : meta["tags"]) {
-                        if (mt.asString() == qt8) score += 3;
-                    }
-                }
-            }
-            // fuzzy name match
-            std::wstring name = WStringFromUtf8(meta.get("path", "").asString());
-            if (FuzzyMatch(name, query, 3)) score += 2;
-            if (score > 0) scored.emplace_back(score, kv.first);
-        }
-        std::sort(scored.begin(), scored.end(), [](auto const& a, auto const& b){ return a.first > b.first; });
-        // show results as simple dialog selecting top 10
+        // Ähnlichkeitssuche (SemanticIndex.h): exakter Scan bis 50k Dateien, darüber HNSW-Graph
+        SemanticQueryOptions opt;
+        opt.topK = 20;
+        auto scored = m_semantic.Query(query, opt, &m_fuzzyPool);
         StackPanel results; results.Orientation(Orientation::Vertical);
-        int count = 0;
-        for (auto const& p : scored) {
-            if (++count > 20) break;
-            TextBlock tb; tb.Text(winrt::hstring(p.second)); tb.Foreground(SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255,230,230,230)));
+        for (auto const& h : scored) {
+            wchar_t score[16];
+            swprintf(score, 16, L"%3.0f %%  ", h.score * 100);
+            TextBlock tb; tb.Text(winrt::hstring(score + std::wstring(h.path))); tb.Foreground(SolidColorBrush(Windows::UI::ColorHelper::FromArgb(255,230,230,230)));
             results.Children().Append(tb);
         }
         if (scored.empty()) {
@@ -1321,15 +2088,11 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
     // Auto-Categorize: buckets files by top tag
     void AutoCategorize() {
         std::unordered_map<std::wstring, std::vector<std::wstring>> cats;
-        for (auto const& kv : m_index) {
-            auto const& meta = kv.second;
-            if (meta.isMember("tags") && meta["tags"].size() > 0) {
-                std::string t = meta["tags"][0].asString();
-                std::wstring wt = WStringFromUtf8(t);
-                cats[wt].push_back(kv.first);
-            } else {
-                cats[L"uncategorized"].push_back(kv.first);
-            }
+        {
+            std::lock_guard<std::mutex> lg(m_indexMutex); // FsWatcher / IndexSync schreiben nebenher
+            m_index.ForEach([&](FileIndexEntry const& e) {
+                cats[e.tags.empty() ? std::wstring(L"uncategorized") : e.tags[0]].push_back(e.path);
+            });
         }
         // present categories in a dialog
         StackPanel sp; sp.Orientation(Orientation::Vertical);
@@ -1340,13 +2103,9 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
         ContentDialog dlg; dlg.Title(box_value(winrt::hstring(L"Auto-Categories"))); dlg.Content(sp); dlg.PrimaryButtonText(L"OK"); dlg.XamlRoot(m_fileGrid.XamlRoot()); dlg.ShowAsync();
     }
 
-    // AutoRenameAll button handler already wired to BatchRename for pattern/AI; provide Undo support
-	fire_and_forget AutoRenameAll(IInspectable const&, RoutedEventArgs const&) {
-		// reuse BatchRename UI but record actions into undo stack
-		// (this wrapper calls BatchRename which already applies renames)
-		co_await BatchRename(nullptr, {});
-		// Note: BatchRename currently performs renames without undo records;
-		// for full undo support you'd push rename pairs to m_undoStack during rename operations.
+    // AutoRenameAll: BatchRename UI (pattern/AI); the batch lands on the undo stack as one group
+	void AutoRenameAll(IInspectable const&, RoutedEventArgs const&) {
+		BatchRename(nullptr, nullptr);
 	}
 
 	// Undo: pop last rename and revert
@@ -1356,10 +2115,15 @@ struct ExplorerFinal : ApplicationT<ExplorerFinal>
 			return;
 		}
 		auto op = m_undoStack.back(); m_undoStack.pop_back();
-		auto type = std::get<0>(op);
-		auto src = std::get<1>(op);
-		auto dst = std::get<2>(op);
-		if (type == L"rename") {
+		auto type = op.type;
+		auto src = op.src;
+		auto dst = op.dst;
+		if (type == L"renames") {
+			// inverse batch through the planner (swaps / cycles again via temporary names)
+			std::vector<RenameOp> inverse;
+			for (auto const& r : op.renames) inverse.push_back({ r.to, r.from });
+			RunRenames(std::move(inverse), std::move(op.renames));
+		} else if (type == L"rename") {
 			try { std::filesystem::rename(dst, src); PopulateFiles(m_addressBar.Text()); } catch (...) {}
 		} else if (type == L"create") {
 			try {
@@ -0,0 +1,753 @@
+// FileIndex.h — persistent file index (path, size, mtime, content hash, tags) replacing index.json
+// - index.bin: immutable snapshot, opened with mmap and used in place (no parsing at open)
+//     * paths: directories interned as a tree (parent id + own segment), files = dir id + name
+//     * fixed-width columns per file: dir, name, size, mtime, hash (up to 32 bytes), tag list
+//     * tag dictionary (sorted) with posting lists of file ids; open-addressing path hash table
+//     * every section carries an FNV-1a checksum, the header its own (sections verified on request)
+// - index.log: appended Put/Remove records (checksummed), replayed into an in-memory overlay at
+//   Open; Compact() merges snapshot + overlay into a new index.bin and empties the log
+// - IndexJsonImporter: one-time migration of the old index.json without building a JSON tree
+// Strings are stored in native path code units (UTF-16 on Windows), so an index file is not
+// portable between platforms — it is a local cache. Not thread-safe: callers lock.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using IndexString = std::filesystem::path::string_type;
+using IndexChar = IndexString::value_type;
+using IndexStringView = std::basic_string_view<IndexChar>;
+
+struct FileIndexEntry {
+    IndexString path;
+    uint64_t size = 0;
+    uint64_t mtime = 0;                 // as delivered by DirEnum (FILETIME ticks on Windows)
+    uint8_t hash[32] = {};
+    uint8_t hashLen = 0;                // 0 = not hashed yet
+    std::vector<IndexString> tags;      // most relevant first
+
+    void SetHashHex(std::string_view hex) {
+        hashLen = 0;
+        auto nib = [](char c) { return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1; };
+        if (hex.size() % 2 || hex.size() > 64) return;
+        for (size_t i = 0; i < hex.size(); i += 2) {
+            int hi = nib(hex[i]), lo = nib(hex[i + 1]);
+            if (hi < 0 || lo < 0) { hashLen = 0; return; }
+            hash[hashLen++] = (uint8_t)(hi << 4 | lo);
+        }
+    }
+    std::string HashHex() const {
+        static const char* digits = "0123456789abcdef";
+        std::string s;
+        for (uint8_t i = 0; i < hashLen; ++i) { s += digits[hash[i] >> 4]; s += digits[hash[i] & 15]; }
+        return s;
+    }
+};
+
+inline uint64_t IndexFnv(const void* data, size_t n, uint64_t h = 1469598103934665603ull) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+// Read-only file mapping
+class IndexMapping {
+public:
+    ~IndexMapping() { Close(); }
+    bool Open(const std::filesystem::path& path) {
+        Close();
+#ifdef _WIN32
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(m_file, &sz) || sz.QuadPart == 0) { Close(); return false; }
+        m_map = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_map) { Close(); return false; }
+        m_data = (const uint8_t*)MapViewOfFile(m_map, FILE_MAP_READ, 0, 0, 0);
+        if (!m_data) { Close(); return false; }
+        m_size = (size_t)sz.QuadPart;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st {};
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        m_data = (const uint8_t*)p;
+        m_size = (size_t)st.st_size;
+#endif
+        return true;
+    }
+    void Close() {
+#ifdef _WIN32
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_map) CloseHandle(m_map);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_map = nullptr; m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data) munmap((void*)m_data, m_size);
+#endif
+        m_data = nullptr; m_size = 0;
+    }
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_map = nullptr;
+#endif
+};
+
+class FileIndex {
+public:
+    ~FileIndex() { Close(); }
+
+    // dir gets index.bin + index.log. A damaged snapshot is ignored (the index starts empty);
+    // verify also checks all section checksums (reads the whole file).
+    bool Open(const std::filesystem::path& dir, bool verify = false) {
+        Close();
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        m_binPath = dir / "index.bin";
+        m_logPath = dir / "index.log";
+        if (m_map.Open(m_binPath) && !MapSnapshot(verify)) m_map.Close();
+        m_count = BaseCount();
+        ReplayLog();
+        m_log.open(m_logPath, std::ios::binary | std::ios::app);
+        m_pathGeneration++;
+        return m_log.is_open();
+    }
+
+    void Close() {
+        Flush();
+        if (m_log.is_open()) m_log.close();
+        m_map.Close();
+        m_hdr = nullptr;
+        m_overlay.clear();
+        m_count = 0;
+    }
+
+    bool HasSnapshot() const { return m_hdr != nullptr; }
+    size_t Size() const { return m_count; }
+    // Changes whenever a path is added or removed (not on content updates); lets derived indexes
+    // (e.g. FuzzyIndex over the names) tell whether they are stale
+    uint64_t PathGeneration() const { return m_pathGeneration; }
+
+    bool Find(IndexStringView path, FileIndexEntry& out) const {
+        auto it = m_overlay.find(IndexString(path));
+        if (it != m_overlay.end()) {
+            if (!it->second) return false;
+            out = *it->second;
+            return true;
+        }
+        uint32_t row = FindRow(path);
+        if (row == kNone) return false;
+        Materialize(row, out);
+        return true;
+    }
+    bool Contains(IndexStringView path) const {
+        auto it = m_overlay.find(IndexString(path));
+        if (it != m_overlay.end()) return it->second.has_value();
+        return FindRow(path) != kNone;
+    }
+
+    void Put(const FileIndexEntry& e) {
+        bool existed = Contains(e.path);
+        AppendLog(kOpPut, e);
+        m_overlay[e.path] = e;
+        if (!existed) { m_count++; m_pathGeneration++; }
+    }
+    void Remove(IndexStringView path) {
+        if (!Contains(path)) return;
+        FileIndexEntry e;
+        e.path = IndexString(path);
+        AppendLog(kOpRemove, e);
+        m_overlay[e.path] = std::nullopt;
+        m_count--;
+        m_pathGeneration++;
+    }
+    // Drop everything (full rebuild); takes effect on disk with the next Compact()
+    void Clear() {
+        m_map.Close();
+        m_hdr = nullptr;
+        m_overlay.clear();
+        m_count = 0;
+        m_pathGeneration++;
+        m_cleared = true;
+        m_pending.clear();
+        if (m_log.is_open()) m_log.close();
+        m_log.open(m_logPath, std::ios::binary | std::ios::trunc);
+    }
+
+    // Visit every live entry (snapshot rows not shadowed by the log, then logged entries)
+    template <class F> void ForEach(F&& fn) const {
+        FileIndexEntry e;
+        for (uint32_t row = 0; row < BaseCount(); ++row) {
+            if (!m_overlay.empty()) {
+                IndexString p = RowPath(row);
+                if (m_overlay.count(p)) continue;
+            }
+            Materialize(row, e);
+            fn(e);
+        }
+        for (auto const& kv : m_overlay) if (kv.second) fn(*kv.second);
+    }
+
+    // Visit every live path only (no columns materialized); cheaper than ForEach for prefix scans
+    template <class F> void ForEachPath(F&& fn) const {
+        for (uint32_t row = 0; row < BaseCount(); ++row) {
+            IndexString p = RowPath(row);
+            if (!m_overlay.empty() && m_overlay.count(p)) continue;
+            fn(IndexStringView(p));
+        }
+        for (auto const& kv : m_overlay) if (kv.second) fn(IndexStringView(kv.first));
+    }
+
+    // Number of live files carrying tag (document frequency); snapshot postings + log entries
+    size_t TagCount(IndexStringView tag) const {
+        size_t n = 0;
+        ForEachWithTag(tag, [&n](const FileIndexEntry&) { n++; });
+        return n;
+    }
+    template <class F> void ForEachWithTag(IndexStringView tag, F&& fn) const {
+        FileIndexEntry e;
+        if (const TagEntry* t = FindTag(tag)) {
+            const uint32_t* post = Section<uint32_t>(kPostings) + t->postOff;
+            for (uint32_t i = 0; i < t->postCount; ++i) {
+                if (!m_overlay.empty() && m_overlay.count(RowPath(post[i]))) continue;
+                Materialize(post[i], e);
+                fn(e);
+            }
+        }
+        for (auto const& kv : m_overlay)
+            if (kv.second && std::find(kv.second->tags.begin(), kv.second->tags.end(), tag) != kv.second->tags.end()) fn(*kv.second);
+    }
+
+    void Flush() {
+        if (!m_log.is_open() || m_pending.empty()) return;
+        m_log.write((const char*)m_pending.data(), (std::streamsize)m_pending.size());
+        m_log.flush();
+        m_pending.clear();
+    }
+
+    // Worth compacting once the log holds a sizeable share of the index
+    bool NeedsCompaction() const { return m_cleared || m_overlay.size() > std::max<size_t>(4096, BaseCount() / 8); }
+
+    // Write a new snapshot from all live entries, swap it in, empty the log
+    bool Compact() {
+        std::vector<FileIndexEntry> all;
+        all.reserve(m_count);
+        ForEach([&all](const FileIndexEntry& e) { all.push_back(e); });
+        std::sort(all.begin(), all.end(), [](const FileIndexEntry& a, const FileIndexEntry& b) { return a.path < b.path; });
+        std::filesystem::path tmp = m_binPath;
+        tmp += ".tmp";
+        if (!WriteSnapshot(tmp, all)) return false;
+        m_map.Close();
+        m_hdr = nullptr;
+        std::error_code ec;
+        std::filesystem::rename(tmp, m_binPath, ec);
+        if (ec) return false;
+        if (!m_map.Open(m_binPath) || !MapSnapshot(false)) { m_map.Close(); return false; }
+        m_pending.clear();
+        if (m_log.is_open()) m_log.close();
+        m_log.open(m_logPath, std::ios::binary | std::ios::trunc);
+        m_overlay.clear();
+        m_cleared = false;
+        m_count = BaseCount();
+        return true;
+    }
+
+private:
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kNone = UINT32_MAX;
+    static constexpr uint32_t kLogMagic = 0x474c5058;  // "XPLG"
+    static constexpr uint8_t kOpPut = 1, kOpRemove = 2;
+
+    enum SectionId { kStrings, kDirs, kFileDir, kFileName, kFileSize, kFileMtime, kFileHash, kFileHashLen, kFileTags, kTagIds, kTagDict, kPostings, kPathHash, kSectionCount };
+
+#pragma pack(push, 1)
+    struct SectionRef { uint64_t offset, size, checksum; };
+    struct Header {
+        char magic[4];
+        uint32_t version, charSize, sectionCount;
+        uint64_t fileCount, dirCount, tagCount, hashSlots;
+        SectionRef sections[kSectionCount];
+        uint64_t checksum;              // over everything above
+    };
+    struct StrRef { uint32_t off, len; };                        // into kStrings (code units)
+    struct DirEntry { uint32_t parent; StrRef seg; };            // seg ends with the separator
+    struct ListRef { uint32_t off, count; };
+    struct TagEntry { StrRef str; uint32_t postOff, postCount; };
+    struct HashSlot { uint64_t hash; uint32_t row, pad; };
+#pragma pack(pop)
+
+    std::filesystem::path m_binPath, m_logPath;
+    IndexMapping m_map;
+    const Header* m_hdr = nullptr;
+    uint64_t m_pathGeneration = 0;
+    std::unordered_map<IndexString, std::optional<FileIndexEntry>> m_overlay; // nullopt = removed
+    std::ofstream m_log;
+    std::vector<uint8_t> m_pending;
+    size_t m_count = 0;
+    bool m_cleared = false;
+
+    template <class T> const T* Section(SectionId id) const { return (const T*)(m_map.Data() + m_hdr->sections[id].offset); }
+    uint32_t BaseCount() const { return m_hdr ? (uint32_t)m_hdr->fileCount : 0; }
+    IndexStringView Str(StrRef r) const { return IndexStringView(Section<IndexChar>(kStrings) + r.off, r.len); }
+
+    static bool IsSep(IndexChar c) {
+#ifdef _WIN32
+        return c == L'\\' || c == L'/';
+#else
+        return c == '/';
+#endif
+    }
+    static uint64_t PathHash(IndexStringView p) { return IndexFnv(p.data(), p.size() * sizeof(IndexChar)); }
+
+    bool MapSnapshot(bool verify) {
+        if (m_map.Size() < sizeof(Header)) return false;
+        const Header* h = (const Header*)m_map.Data();
+        if (memcmp(h->magic, "XPIX", 4) != 0 || h->version != kVersion || h->charSize != sizeof(IndexChar) || h->sectionCount != kSectionCount) return false;
+        if (IndexFnv(h, offsetof(Header, checksum)) != h->checksum) return false;
+        for (auto const& s : h->sections) {
+            if (s.offset > m_map.Size() || s.size > m_map.Size() - s.offset || s.offset % 8) return false;
+            if (verify && IndexFnv(m_map.Data() + s.offset, (size_t)s.size) != s.checksum) return false;
+        }
+        m_hdr = h;
+        return true;
+    }
+
+    void AppendDir(uint32_t dir, IndexString& out) const {
+        const DirEntry* dirs = Section<DirEntry>(kDirs);
+        uint32_t chain[256];
+        int n = 0;
+        for (uint32_t d = dir; d != kNone && n < 256; d = dirs[d].parent) chain[n++] = d;
+        while (n > 0) { auto s = Str(dirs[chain[--n]].seg); out.append(s.data(), s.size()); }
+    }
+    IndexString RowPath(uint32_t row) const {
+        IndexString p;
+        AppendDir(Section<uint32_t>(kFileDir)[row], p);
+        auto name = Str(Section<StrRef>(kFileName)[row]);
+        p.append(name.data(), name.size());
+        return p;
+    }
+
+    uint32_t FindRow(IndexStringView path) const {
+        if (!m_hdr || m_hdr->hashSlots == 0) return kNone;
+        const HashSlot* slots = Section<HashSlot>(kPathHash);
+        uint64_t h = PathHash(path), mask = m_hdr->hashSlots - 1;
+        for (uint64_t i = h & mask;; i = (i + 1) & mask) {
+            if (slots[i].row == kNone) return kNone;
+            if (slots[i].hash == h && RowPath(slots[i].row) == path) return slots[i].row;
+        }
+    }
+
+    void Materialize(uint32_t row, FileIndexEntry& e) const {
+        e.path = RowPath(row);
+        e.size = Section<uint64_t>(kFileSize)[row];
+        e.mtime = Section<uint64_t>(kFileMtime)[row];
+        e.hashLen = Section<uint8_t>(kFileHashLen)[row];
+        memcpy(e.hash, Section<uint8_t>(kFileHash) + (size_t)row * 32, 32);
+        ListRef tl = Section<ListRef>(kFileTags)[row];
+        const uint32_t* ids = Section<uint32_t>(kTagIds) + tl.off;
+        const TagEntry* dict = Section<TagEntry>(kTagDict);
+        e.tags.resize(tl.count);
+        for (uint32_t i = 0; i < tl.count; ++i) e.tags[i] = IndexString(Str(dict[ids[i]].str));
+    }
+
+    const TagEntry* FindTag(IndexStringView tag) const {
+        if (!m_hdr) return nullptr;
+        const TagEntry* dict = Section<TagEntry>(kTagDict);
+        const TagEntry* end = dict + m_hdr->tagCount;
+        const TagEntry* it = std::lower_bound(dict, end, tag, [this](const TagEntry& t, IndexStringView v) { return Str(t.str) < v; });
+        return it != end && Str(it->str) == tag ? it : nullptr;
+    }
+
+    // ---- log ----
+    template <class T> static void Pack(std::vector<uint8_t>& b, const T& v) { b.insert(b.end(), (const uint8_t*)&v, (const uint8_t*)&v + sizeof(T)); }
+    static void PackStr(std::vector<uint8_t>& b, const IndexString& s) {
+        Pack(b, (uint32_t)s.size());
+        b.insert(b.end(), (const uint8_t*)s.data(), (const uint8_t*)(s.data() + s.size()));
+    }
+
+    void AppendLog(uint8_t op, const FileIndexEntry& e) {
+        std::vector<uint8_t> payload;
+        Pack(payload, op);
+        PackStr(payload, e.path);
+        if (op == kOpPut) {
+            Pack(payload, e.size); Pack(payload, e.mtime); Pack(payload, e.hashLen);
+            payload.insert(payload.end(), e.hash, e.hash + e.hashLen);
+            Pack(payload, (uint32_t)e.tags.size());
+            for (auto const& t : e.tags) PackStr(payload, t);
+        }
+        Pack(m_pending, kLogMagic);
+        Pack(m_pending, (uint32_t)payload.size());
+        Pack(m_pending, IndexFnv(payload.data(), payload.size()));
+        m_pending.insert(m_pending.end(), payload.begin(), payload.end());
+        if (m_pending.size() >= (64u << 10)) Flush();
+    }
+
+    // Replay the log into the overlay; a torn or corrupt tail is cut off
+    void ReplayLog() {
+        std::ifstream f(m_logPath, std::ios::binary);
+        if (!f) return;
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        size_t pos = 0, good = 0;
+        auto get = [&](size_t& p, void* out, size_t n, size_t end) { if (end - p < n) return false; memcpy(out, data.data() + p, n); p += n; return true; };
+        auto getStr = [&](size_t& p, IndexString& s, size_t end) {
+            uint32_t len;
+            if (!get(p, &len, 4, end) || (end - p) / sizeof(IndexChar) < len) return false;
+            s.assign((const IndexChar*)(data.data() + p), len);
+            p += (size_t)len * sizeof(IndexChar);
+            return true;
+        };
+        while (data.size() - pos >= 16) {
+            uint32_t magic = 0, len = 0; uint64_t sum = 0;
+            size_t p = pos;
+            get(p, &magic, 4, data.size()); get(p, &len, 4, data.size()); get(p, &sum, 8, data.size());
+            if (magic != kLogMagic || data.size() - p < len || IndexFnv(data.data() + p, len) != sum) break;
+            size_t end = p + len;
+            uint8_t op = 0;
+            FileIndexEntry e;
+            bool ok = get(p, &op, 1, end) && getStr(p, e.path, end);
+            if (ok && op == kOpPut) {
+                uint32_t tags = 0;
+                ok = get(p, &e.size, 8, end) && get(p, &e.mtime, 8, end) && get(p, &e.hashLen, 1, end) && e.hashLen <= 32
+                    && get(p, e.hash, e.hashLen, end) && get(p, &tags, 4, end);
+                for (uint32_t i = 0; ok && i < tags; ++i) { e.tags.emplace_back(); ok = getStr(p, e.tags.back(), end); }
+            }
+            if (!ok || (op != kOpPut && op != kOpRemove)) break;
+            bool existed = Contains(e.path);
+            if (op == kOpPut) { if (!existed) m_count++; IndexString key = e.path; m_overlay[key] = std::move(e); }
+            else if (existed) { m_count--; m_overlay[e.path] = std::nullopt; }
+            pos = good = end;
+        }
+        f.close();
+        std::error_code ec;
+        if (good != data.size()) std::filesystem::resize_file(m_logPath, good, ec);
+    }
+
+    // ---- snapshot writer ----
+    static void Align(std::vector<uint8_t>& b) { while (b.size() % 8) b.push_back(0); }
+
+    static bool WriteSnapshot(const std::filesystem::path& path, const std::vector<FileIndexEntry>& files) {
+        std::vector<IndexChar> strings;
+        std::unordered_map<IndexString, uint32_t> dirIds;
+        std::vector<DirEntry> dirs;
+        auto addStr = [&strings](IndexStringView s) {
+            StrRef r{ (uint32_t)strings.size(), (uint32_t)s.size() };
+            strings.insert(strings.end(), s.begin(), s.end());
+            return r;
+        };
+        // intern a directory path (ending with a separator) and its missing ancestors
+        IndexString lastDir;
+        uint32_t lastDirId = kNone;
+        auto internDir = [&](IndexStringView d) {
+            if (d == lastDir) return lastDirId; // files arrive sorted: mostly the same directory
+            std::vector<size_t> missing;        // prefix lengths, longest first
+            uint32_t parent = kNone;
+            size_t len = d.size();
+            while (len > 0) {
+                auto it = dirIds.find(IndexString(d.substr(0, len)));
+                if (it != dirIds.end()) { parent = it->second; break; }
+                missing.push_back(len);
+                size_t cut = len - 1;           // step over the trailing separator
+                while (cut > 0 && !IsSep(d[cut - 1])) --cut;
+                len = cut;
+            }
+            for (auto l = missing.rbegin(); l != missing.rend(); ++l) {
+                uint32_t id = (uint32_t)dirs.size();
+                dirs.push_back(DirEntry{ parent, addStr(d.substr(len, *l - len)) });
+                dirIds.emplace(IndexString(d.substr(0, *l)), id);
+                parent = id;
+                len = *l;
+            }
+            lastDir = IndexString(d);
+            lastDirId = parent;
+            return parent;
+        };
+
+        size_t n = files.size();
+        std::vector<uint32_t> fileDir(n);
+        std::vector<StrRef> fileName(n);
+        std::vector<uint64_t> fileSize(n), fileMtime(n);
+        std::vector<uint8_t> fileHash(n * 32), fileHashLen(n);
+        std::vector<ListRef> fileTags(n);
+        std::vector<uint32_t> tagIds;
+        std::unordered_map<IndexString, uint32_t> tagTmp;        // tag -> provisional id
+        std::vector<std::vector<uint32_t>> tagRows;
+        for (size_t i = 0; i < n; ++i) {
+            const FileIndexEntry& e = files[i];
+            IndexStringView p(e.path);
+            size_t cut = p.size();
+            while (cut > 0 && !IsSep(p[cut - 1])) --cut;
+            fileDir[i] = cut ? internDir(p.substr(0, cut)) : kNone;
+            fileName[i] = addStr(p.substr(cut));
+            fileSize[i] = e.size;
+            fileMtime[i] = e.mtime;
+            fileHashLen[i] = e.hashLen;
+            memcpy(&fileHash[i * 32], e.hash, 32);
+            fileTags[i] = ListRef{ (uint32_t)tagIds.size(), (uint32_t)e.tags.size() };
+            for (auto const& t : e.tags) {
+                auto ins = tagTmp.emplace(t, (uint32_t)tagRows.size());
+                if (ins.second) tagRows.emplace_back();
+                if (tagRows[ins.first->second].empty() || tagRows[ins.first->second].back() != (uint32_t)i) tagRows[ins.first->second].push_back((uint32_t)i);
+                tagIds.push_back(ins.first->second);
+            }
+        }
+        // sorted dictionary: remap provisional ids
+        std::vector<std::pair<IndexString, uint32_t>> sortedTags(tagTmp.begin(), tagTmp.end());
+        std::sort(sortedTags.begin(), sortedTags.end());
+        std::vector<uint32_t> remap(sortedTags.size());
+        std::vector<TagEntry> dict;
+        std::vector<uint32_t> postings;
+        for (uint32_t i = 0; i < sortedTags.size(); ++i) {
+            remap[sortedTags[i].second] = i;
+            auto const& rows = tagRows[sortedTags[i].second];
+            dict.push_back(TagEntry{ addStr(sortedTags[i].first), (uint32_t)postings.size(), (uint32_t)rows.size() });
+            postings.insert(postings.end(), rows.begin(), rows.end());
+        }
+        for (auto& id : tagIds) id = remap[id];
+        // path hash table, load factor <= 0.5
+        uint64_t slots = 1;
+        while (slots < n * 2) slots <<= 1;
+        if (n == 0) slots = 0;
+        std::vector<HashSlot> table((size_t)slots, HashSlot{ 0, kNone, 0 });
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t h = PathHash(files[i].path);
+            uint64_t j = h & (slots - 1);
+            while (table[(size_t)j].row != kNone) j = (j + 1) & (slots - 1);
+            table[(size_t)j] = HashSlot{ h, (uint32_t)i, 0 };
+        }
+
+        Header hdr{};
+        memcpy(hdr.magic, "XPIX", 4);
+        hdr.version = kVersion;
+        hdr.charSize = sizeof(IndexChar);
+        hdr.sectionCount = kSectionCount;
+        hdr.fileCount = n;
+        hdr.dirCount = dirs.size();
+        hdr.tagCount = dict.size();
+        hdr.hashSlots = slots;
+
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        if (!f) return false;
+        uint64_t offset = (sizeof(Header) + 7) / 8 * 8;
+        f.write(std::string((size_t)offset, '\0').data(), (std::streamsize)offset);
+        auto emit = [&](SectionId id, const void* data, size_t bytes) {
+            hdr.sections[id] = SectionRef{ offset, bytes, IndexFnv(data, bytes) };
+            f.write((const char*)data, (std::streamsize)bytes);
+            size_t pad = (8 - bytes % 8) % 8;
+            if (pad) f.write("\0\0\0\0\0\0\0", (std::streamsize)pad);
+            offset += bytes + pad;
+        };
+        emit(kStrings, strings.data(), strings.size() * sizeof(IndexChar));
+        emit(kDirs, dirs.data(), dirs.size() * sizeof(DirEntry));
+        emit(kFileDir, fileDir.data(), n * sizeof(uint32_t));
+        emit(kFileName, fileName.data(), n * sizeof(StrRef));
+        emit(kFileSize, fileSize.data(), n * sizeof(uint64_t));
+        emit(kFileMtime, fileMtime.data(), n * sizeof(uint64_t));
+        emit(kFileHash, fileHash.data(), fileHash.size());
+        emit(kFileHashLen, fileHashLen.data(), n);
+        emit(kFileTags, fileTags.data(), n * sizeof(ListRef));
+        emit(kTagIds, tagIds.data(), tagIds.size() * sizeof(uint32_t));
+        emit(kTagDict, dict.data(), dict.size() * sizeof(TagEntry));
+        emit(kPostings, postings.data(), postings.size() * sizeof(uint32_t));
+        emit(kPathHash, table.data(), table.size() * sizeof(HashSlot));
+        hdr.checksum = IndexFnv(&hdr, offsetof(Header, checksum));
+        f.seekp(0);
+        f.write((const char*)&hdr, sizeof(hdr));
+        f.flush();
+        return (bool)f;
+    }
+};
+
+// One-time import of the old index.json ({ "<path>": { "sha1": hex, "size": n, "tags": [...] }, ... },
+// as written by JsonCpp: non-ASCII escaped as \uXXXX). Parsed in place from a mapping, entries go
+// straight into the index — no document tree. mtime was not stored and stays 0, so such entries count
+// as changed on the next index run. Members other than sha1/size/tags are skipped. Returns false on a
+// missing or malformed file; the entries read up to that point are dropped again (Clear).
+class IndexJsonImporter {
+public:
+    static bool Import(const std::filesystem::path& json, FileIndex& index) {
+        IndexMapping map;
+        if (!map.Open(json)) return false;
+        IndexJsonImporter r((const char*)map.Data(), (const char*)map.Data() + map.Size());
+        if (!r.ReadRoot(index)) { index.Clear(); return false; }
+        return true;
+    }
+
+private:
+    const char* m_p;
+    const char* m_end;
+    std::string m_str;
+
+    IndexJsonImporter(const char* p, const char* end) : m_p(p), m_end(end) {}
+
+    void Ws() { while (m_p < m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r')) ++m_p; }
+    bool Eat(char c) { Ws(); if (m_p < m_end && *m_p == c) { ++m_p; return true; } return false; }
+    bool Peek(char c) { Ws(); return m_p < m_end && *m_p == c; }
+
+    static IndexString FromUtf8(const std::string& s) {
+        return std::filesystem::path(std::u8string((const char8_t*)s.data(), s.size())).native();
+    }
+
+    static void PutUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) out += (char)cp;
+        else if (cp < 0x800) { out += (char)(0xC0 | cp >> 6); out += (char)(0x80 | (cp & 0x3F)); }
+        else if (cp < 0x10000) { out += (char)(0xE0 | cp >> 12); out += (char)(0x80 | (cp >> 6 & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+        else { out += (char)(0xF0 | cp >> 18); out += (char)(0x80 | (cp >> 12 & 0x3F)); out += (char)(0x80 | (cp >> 6 & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+    }
+    bool Hex4(uint32_t& v) {
+        if (m_end - m_p < 4) return false;
+        v = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = *m_p++;
+            int d = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (d < 0) return false;
+            v = v << 4 | (uint32_t)d;
+        }
+        return true;
+    }
+
+    // String into m_str (UTF-8, escapes resolved)
+    bool String() {
+        if (!Eat('"')) return false;
+        m_str.clear();
+        for (;;) {
+            const char* run = m_p;
+            while (m_p < m_end && *m_p != '"' && *m_p != '\\' && (unsigned char)*m_p >= 0x20) ++m_p;
+            m_str.append(run, m_p);
+            if (m_p >= m_end || (unsigned char)*m_p < 0x20) return false;
+            if (*m_p++ == '"') return true;
+            if (m_p >= m_end) return false;
+            switch (char c = *m_p++) {
+            case '"': case '\\': case '/': m_str += c; break;
+            case 'b': m_str += '\b'; break;
+            case 'f': m_str += '\f'; break;
+            case 'n': m_str += '\n'; break;
+            case 'r': m_str += '\r'; break;
+            case 't': m_str += '\t'; break;
+            case 'u': {
+                uint32_t cp, lo;
+                if (!Hex4(cp)) return false;
+                if (cp >= 0xD800 && cp < 0xDC00) {                // surrogate pair
+                    if (m_end - m_p < 2 || m_p[0] != '\\' || m_p[1] != 'u') return false;
+                    m_p += 2;
+                    if (!Hex4(lo) || lo < 0xDC00 || lo > 0xDFFF) return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                else if (cp >= 0xDC00 && cp <= 0xDFFF) return false;
+                PutUtf8(m_str, cp);
+                break;
+            }
+            default: return false;
+            }
+        }
+    }
+
+    bool Number(uint64_t& v) {
+        Ws();
+        const char* b = m_p;
+        if (m_p < m_end && *m_p == '-') ++m_p;
+        while (m_p < m_end && ((*m_p >= '0' && *m_p <= '9') || *m_p == '.' || *m_p == 'e' || *m_p == 'E' || *m_p == '+' || *m_p == '-')) ++m_p;
+        if (m_p == b) return false;
+        std::string tok(b, m_p);
+        char* e = nullptr;
+        if (tok.find_first_of("-.eE") == std::string::npos) v = strtoull(tok.c_str(), &e, 10);
+        else { double d = strtod(tok.c_str(), &e); v = d > 0 ? (uint64_t)d : 0; }
+        return e && *e == 0;
+    }
+
+    bool Literal(const char* word) {
+        Ws();
+        size_t n = strlen(word);
+        if ((size_t)(m_end - m_p) < n || memcmp(m_p, word, n) != 0) return false;
+        m_p += n;
+        return true;
+    }
+
+    bool Skip(int depth = 0) {
+        if (depth > 64) return false;
+        Ws();
+        if (m_p >= m_end) return false;
+        if (*m_p == '"') return String();
+        if (*m_p == 't') return Literal("true");
+        if (*m_p == 'f') return Literal("false");
+        if (*m_p == 'n') return Literal("null");
+        if (*m_p == '[' || *m_p == '{') {
+            bool obj = *m_p++ == '{';
+            char close = obj ? '}' : ']';
+            if (Eat(close)) return true;
+            do {
+                if (obj && (!String() || !Eat(':'))) return false;
+                if (!Skip(depth + 1)) return false;
+            } while (Eat(','));
+            return Eat(close);
+        }
+        uint64_t v;
+        return Number(v);
+    }
+
+    bool ReadMeta(FileIndexEntry& e) {
+        if (Literal("null")) return true;
+        if (!Eat('{')) return false;
+        if (Eat('}')) return true;
+        do {
+            if (!String() || !Eat(':')) return false;
+            if (m_str == "size") { if (!Number(e.size)) return false; }
+            else if (m_str == "sha1" && Peek('"')) { if (!String()) return false; e.SetHashHex(m_str); }
+            else if (m_str == "tags" && Peek('[')) {
+                Eat('[');
+                if (!Eat(']')) {
+                    do {
+                        if (!String()) return false;
+                        e.tags.push_back(FromUtf8(m_str));
+                    } while (Eat(','));
+                    if (!Eat(']')) return false;
+                }
+            }
+            else if (!Skip()) return false;
+        } while (Eat(','));
+        return Eat('}');
+    }
+
+    bool ReadRoot(FileIndex& index) {
+        if (m_end - m_p >= 3 && memcmp(m_p, "\xEF\xBB\xBF", 3) == 0) m_p += 3;
+        if (!Eat('{')) return false;
+        if (Eat('}')) { Ws(); return m_p == m_end; }
+        FileIndexEntry e;
+        do {
+            if (!String() || !Eat(':')) return false;
+            e = FileIndexEntry();
+            e.path = FromUtf8(m_str);
+            if (!ReadMeta(e)) return false;
+            index.Put(e);
+        } while (Eat(','));
+        if (!Eat('}')) return false;
+        Ws();
+        return m_p == m_end;
+    }
+};
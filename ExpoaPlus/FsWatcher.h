@@ -0,0 +1,280 @@
+// FsWatcher.h — recursive change notifications for one directory tree, one interface per platform
+// - Windows: ReadDirectoryChangesW (whole subtree, overlapped I/O, 64 KB buffer)
+// - Linux: inotify with one watch per directory; new directories are watched as they appear,
+//   rename pairs are matched by cookie
+// - Events are collected on a worker thread and delivered in batches once the tree has been quiet
+//   for the debounce interval (at most every maxDelay); repeated Modified events are merged
+// - Overflow means events were lost: the consumer should rescan the tree
+// Elsewhere Start() returns false and the consumer has to rely on rescans.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "DirEnum.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+enum class FsChange { Added, Removed, Modified, Renamed, Overflow };
+
+struct FsEvent {
+    FsChange kind = FsChange::Modified;
+    std::filesystem::path path;         // Renamed: the new path
+    std::filesystem::path oldPath;      // Renamed only
+    bool isDir = false;                 // best effort (Windows does not report it for removals)
+};
+
+using FsEventsFn = std::function<void(std::vector<FsEvent>&&)>;
+
+class FsWatcher {
+public:
+    ~FsWatcher() { Stop(); }
+
+    bool Start(const std::filesystem::path& root, FsEventsFn onEvents,
+               std::chrono::milliseconds debounce = std::chrono::milliseconds(200),
+               std::chrono::milliseconds maxDelay = std::chrono::milliseconds(2000)) {
+        Stop();
+        m_root = root;
+        m_onEvents = std::move(onEvents);
+        m_debounce = debounce;
+        m_maxDelay = maxDelay;
+        m_stop.store(false);
+#ifdef _WIN32
+        m_dir = CreateFileW(root.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (m_dir == INVALID_HANDLE_VALUE) return false;
+        m_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        m_thread = std::thread([this]() { RunWin32(); });
+        return true;
+#elif defined(__linux__)
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd < 0 || pipe(m_stopPipe) != 0) { CloseLinux(); return false; }
+        AddTree(root);
+        m_thread = std::thread([this]() { RunLinux(); });
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void Stop() {
+        m_stop.store(true);
+#ifdef _WIN32
+        if (m_stopEvent) SetEvent(m_stopEvent);
+        if (m_thread.joinable()) m_thread.join();
+        if (m_dir != INVALID_HANDLE_VALUE) CloseHandle(m_dir);
+        if (m_stopEvent) CloseHandle(m_stopEvent);
+        m_dir = INVALID_HANDLE_VALUE; m_stopEvent = nullptr;
+#elif defined(__linux__)
+        if (m_stopPipe[1] >= 0) { char c = 1; (void)!write(m_stopPipe[1], &c, 1); }
+        if (m_thread.joinable()) m_thread.join();
+        CloseLinux();
+#endif
+        m_pending.clear();
+        m_modified.clear();
+    }
+
+    const std::filesystem::path& Root() const { return m_root; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    std::filesystem::path m_root;
+    FsEventsFn m_onEvents;
+    std::chrono::milliseconds m_debounce{ 200 }, m_maxDelay{ 2000 };
+    std::atomic<bool> m_stop{ false };
+    std::thread m_thread;
+    std::vector<FsEvent> m_pending;                    // worker thread only
+    std::set<std::filesystem::path> m_modified;        // paths with a pending Modified event
+    Clock::time_point m_firstPending, m_lastEvent;
+
+    void Queue(FsChange kind, std::filesystem::path path, bool isDir, std::filesystem::path oldPath = {}) {
+        if (kind == FsChange::Modified && !m_modified.insert(path).second) { m_lastEvent = Clock::now(); return; }
+        if (m_pending.empty()) m_firstPending = Clock::now();
+        m_lastEvent = Clock::now();
+        FsEvent e;
+        e.kind = kind; e.path = std::move(path); e.oldPath = std::move(oldPath); e.isDir = isDir;
+        m_pending.push_back(std::move(e));
+    }
+
+    // Milliseconds until the pending batch is due (-1: nothing pending)
+    int DueInMs() const {
+        if (m_pending.empty()) return -1;
+        auto now = Clock::now();
+        auto due = std::min(m_lastEvent + m_debounce, m_firstPending + m_maxDelay);
+        return due <= now ? 0 : (int)std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count() + 1;
+    }
+
+    void FlushIfDue() {
+        if (m_pending.empty() || DueInMs() > 0) return;
+        std::vector<FsEvent> batch;
+        batch.swap(m_pending);
+        m_modified.clear();
+        if (m_onEvents && !m_stop.load()) m_onEvents(std::move(batch));
+    }
+
+#ifdef _WIN32
+    HANDLE m_dir = INVALID_HANDLE_VALUE;
+    HANDLE m_stopEvent = nullptr;
+
+    void RunWin32() {
+        std::vector<DWORD> buffer(64 * 1024 / sizeof(DWORD)); // DWORD-aligned as required
+        OVERLAPPED ov{};
+        ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+        std::filesystem::path renameOld;
+        while (!m_stop.load()) {
+            ResetEvent(ov.hEvent);
+            if (!ReadDirectoryChangesW(m_dir, buffer.data(), (DWORD)(buffer.size() * sizeof(DWORD)), TRUE, filter, nullptr, &ov, nullptr)) {
+                Queue(FsChange::Overflow, m_root, true);
+                break;
+            }
+            for (;;) {
+                HANDLE handles[2] = { ov.hEvent, m_stopEvent };
+                int wait = DueInMs();
+                DWORD r = WaitForMultipleObjects(2, handles, FALSE, wait < 0 ? INFINITE : (DWORD)wait);
+                if (r == WAIT_OBJECT_0 + 1) { CancelIoEx(m_dir, &ov); GetOverlappedResult(m_dir, &ov, &r, TRUE); CloseHandle(ov.hEvent); return; }
+                if (r == WAIT_TIMEOUT) { FlushIfDue(); continue; }
+                break;
+            }
+            DWORD bytes = 0;
+            if (!GetOverlappedResult(m_dir, &ov, &bytes, FALSE) || bytes == 0) {
+                Queue(FsChange::Overflow, m_root, true); // buffer overflow: changes were lost
+                FlushIfDue();
+                continue;
+            }
+            const uint8_t* p = (const uint8_t*)buffer.data();
+            for (;;) {
+                auto* info = (const FILE_NOTIFY_INFORMATION*)p;
+                std::filesystem::path path = m_root / std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                DWORD attr = info->Action == FILE_ACTION_REMOVED || info->Action == FILE_ACTION_RENAMED_OLD_NAME ? INVALID_FILE_ATTRIBUTES : GetFileAttributesW(path.c_str());
+                bool isDir = attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
+                switch (info->Action) {
+                case FILE_ACTION_ADDED: Queue(FsChange::Added, path, isDir); break;
+                case FILE_ACTION_REMOVED: Queue(FsChange::Removed, path, false); break;
+                case FILE_ACTION_MODIFIED: if (!isDir) Queue(FsChange::Modified, path, false); break;
+                case FILE_ACTION_RENAMED_OLD_NAME: renameOld = path; break;
+                case FILE_ACTION_RENAMED_NEW_NAME:
+                    if (renameOld.empty()) Queue(FsChange::Added, path, isDir);
+                    else Queue(FsChange::Renamed, path, isDir, renameOld);
+                    renameOld.clear();
+                    break;
+                }
+                if (!info->NextEntryOffset) break;
+                p += info->NextEntryOffset;
+            }
+            FlushIfDue();
+        }
+        CloseHandle(ov.hEvent);
+    }
+#elif defined(__linux__)
+    int m_fd = -1;
+    int m_stopPipe[2] = { -1, -1 };
+    std::unordered_map<int, std::filesystem::path> m_watches;          // wd -> directory
+    std::unordered_map<uint32_t, std::pair<std::filesystem::path, bool>> m_moveFrom; // cookie -> (path, isDir)
+
+    void CloseLinux() {
+        if (m_fd >= 0) close(m_fd);
+        for (int& f : m_stopPipe) { if (f >= 0) close(f); f = -1; }
+        m_fd = -1;
+        m_watches.clear();
+        m_moveFrom.clear();
+    }
+
+    void AddTree(const std::filesystem::path& dir) {
+        const uint32_t mask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW;
+        int wd = inotify_add_watch(m_fd, dir.c_str(), mask);
+        if (wd < 0) return;
+        m_watches[wd] = dir;
+        DirEnumOptions opt;
+        opt.includeHidden = true;
+        opt.wantStat = false;
+        std::atomic<bool> never{ false };
+        EnumerateDirectory(dir, opt, never, [&](std::vector<DirEntry>&& batch) {
+            for (auto const& e : batch) if (e.isDir) AddTree(dir / e.name);
+        });
+    }
+
+    // A watched directory moved inside the tree: its watches stay valid, only the paths change
+    void RekeyWatches(const std::filesystem::path& from, const std::filesystem::path& to) {
+        const auto& f = from.native();
+        for (auto& w : m_watches) {
+            const auto& p = w.second.native();
+            if (p == f) w.second = to;
+            else if (p.size() > f.size() && p.compare(0, f.size(), f) == 0 && p[f.size()] == '/') w.second = to.native() + p.substr(f.size());
+        }
+    }
+
+    // Unpaired IN_MOVED_FROM: moved out of the tree
+    void ExpireMoves() {
+        for (auto const& m : m_moveFrom) Queue(FsChange::Removed, m.second.first, m.second.second);
+        m_moveFrom.clear();
+    }
+
+    void RunLinux() {
+        std::vector<char> buf(64 * 1024);
+        pollfd fds[2] = { { m_fd, POLLIN, 0 }, { m_stopPipe[0], POLLIN, 0 } };
+        while (!m_stop.load()) {
+            int timeout = DueInMs();
+            if (!m_moveFrom.empty() && (timeout < 0 || timeout > 50)) timeout = 50; // give IN_MOVED_TO a moment
+            int r = poll(fds, 2, timeout);
+            if (r < 0 && errno != EINTR) break;
+            if (fds[1].revents) break;
+            if (r <= 0 || !(fds[0].revents & POLLIN)) {
+                if (r == 0) ExpireMoves();
+                FlushIfDue();
+                continue;
+            }
+            for (;;) {
+                ssize_t n = read(m_fd, buf.data(), buf.size());
+                if (n <= 0) break;
+                for (ssize_t off = 0; off < n;) {
+                    auto* ev = (const inotify_event*)(buf.data() + off);
+                    off += sizeof(inotify_event) + ev->len;
+                    if (ev->mask & IN_Q_OVERFLOW) { Queue(FsChange::Overflow, m_root, true); continue; }
+                    if (ev->mask & IN_IGNORED) { m_watches.erase(ev->wd); continue; }
+                    auto w = m_watches.find(ev->wd);
+                    if (w == m_watches.end() || ev->len == 0) continue;
+                    std::filesystem::path path = w->second / ev->name;
+                    bool isDir = (ev->mask & IN_ISDIR) != 0;
+                    if (ev->mask & IN_CREATE) {
+                        if (isDir) AddTree(path); // contents created before the watch existed are found by the consumer's scan
+                        Queue(FsChange::Added, path, isDir);
+                    }
+                    else if (ev->mask & IN_DELETE) Queue(FsChange::Removed, path, isDir);
+                    else if (ev->mask & (IN_MODIFY | IN_CLOSE_WRITE)) { if (!isDir) Queue(FsChange::Modified, path, false); }
+                    else if (ev->mask & IN_MOVED_FROM) m_moveFrom[ev->cookie] = { path, isDir };
+                    else if (ev->mask & IN_MOVED_TO) {
+                        auto from = m_moveFrom.find(ev->cookie);
+                        if (from != m_moveFrom.end()) {
+                            if (isDir) RekeyWatches(from->second.first, path);
+                            Queue(FsChange::Renamed, path, isDir, from->second.first);
+                            m_moveFrom.erase(from);
+                        }
+                        else {
+                            if (isDir) AddTree(path);
+                            Queue(FsChange::Added, path, isDir);
+                        }
+                    }
+                }
+            }
+            FlushIfDue();
+        }
+    }
+#endif
+};
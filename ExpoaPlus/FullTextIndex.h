@@ -0,0 +1,1448 @@
+// FullTextIndex.h — positional inverted index over file contents (search inside files)
+// - Tokens: runs of ASCII letters / digits (lower-cased) and non-ASCII UTF-8 sequences, everything
+//   else separates. UTF-16 files (BOM) are converted; binary files (NUL in the first 8 KB) and
+//   files outside the extension list are recorded without tokens, so they are not read again.
+// - Segments (ft_NNNNNN.seg): immutable, mmap'ed. Sorted term dictionary; per term one posting
+//   list: per document varint(doc delta), varint(tf), varint(position bytes), delta-coded positions,
+//   and a skip entry every 128 documents so intersections jump over long lists.
+// - New documents collect in memory and become a segment on Commit() (or when the buffer is full).
+//   Re-adding a path hides its older version through the old segment's deletion bitmap (.del).
+// - A background thread merges segments of similar size (and rewrites mostly-deleted ones), so a
+//   query touches few segments; queries keep the segments they started with until they finish.
+// - Queries: words (all must occur), "phrases", OR between groups, -exclusion, prefix*; ranked
+//   with BM25, top-k handed over in batches.
+// Files are little-endian with UTF-8 paths, so an index can be moved between platforms.
+// All public methods are thread-safe; AddFile() is meant to run on many threads at once.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "FileIndex.h"
+#include "Hashing.h"
+
+// ---- paths: stored as UTF-8 ----
+
+inline void FullTextPutUtf8(std::string& out, uint32_t c) {
+    if (c < 0x80) out += (char)c;
+    else if (c < 0x800) { out += (char)(0xC0 | c >> 6); out += (char)(0x80 | (c & 63)); }
+    else if (c < 0x10000) { out += (char)(0xE0 | c >> 12); out += (char)(0x80 | (c >> 6 & 63)); out += (char)(0x80 | (c & 63)); }
+    else { out += (char)(0xF0 | c >> 18); out += (char)(0x80 | (c >> 12 & 63)); out += (char)(0x80 | (c >> 6 & 63)); out += (char)(0x80 | (c & 63)); }
+}
+
+inline std::string FullTextUtf8(IndexStringView s) {
+#ifdef _WIN32
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        uint32_t c = s[i];
+        if (c >= 0xD800 && c < 0xDC00 && i + 1 < s.size() && s[i + 1] >= 0xDC00 && s[i + 1] < 0xE000) c = 0x10000 + ((c - 0xD800) << 10) + (s[++i] - 0xDC00);
+        FullTextPutUtf8(out, c);
+    }
+    return out;
+#else
+    return std::string(s);
+#endif
+}
+
+inline IndexString FullTextNative(std::string_view s) {
+#ifdef _WIN32
+    IndexString out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size();) {
+        uint32_t c = (unsigned char)s[i++];
+        int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+        if (extra) c &= 0x3F >> extra;
+        for (; extra > 0 && i < s.size(); --extra) c = c << 6 | ((unsigned char)s[i++] & 63);
+        if (c >= 0x10000) { out += (IndexChar)(0xD800 + ((c - 0x10000) >> 10)); out += (IndexChar)(0xDC00 + (c & 0x3FF)); }
+        else out += (IndexChar)c;
+    }
+    return out;
+#else
+    return IndexString(s);
+#endif
+}
+
+// ---- tokens ----
+
+// Splits UTF-8 text into lower-case tokens; chunks are fed in order, tokens may cross chunk borders.
+// Every token gets the next position, also the ones dropped for length (so phrases do not join
+// across them).
+class FullTextTokenizer {
+public:
+    static constexpr size_t kMaxToken = 64;   // longer runs (base64, minified code) are not indexed
+
+    template <class Fn>
+    void Feed(const char* p, size_t n, Fn&& onToken) {
+        const uint8_t* map = Map();
+        for (size_t i = 0; i < n; ++i) {
+            uint8_t c = map[(unsigned char)p[i]];
+            if (c) {
+                if (m_len < kMaxToken) m_buf[m_len] = (char)c;
+                ++m_len;
+            }
+            else if (m_len) Emit(onToken);
+        }
+    }
+    template <class Fn>
+    void Finish(Fn&& onToken) {
+        if (m_len) Emit(onToken);
+    }
+    uint32_t Count() const { return m_pos; }
+
+private:
+    char m_buf[kMaxToken];
+    size_t m_len = 0;
+    uint32_t m_pos = 0;
+
+    template <class Fn>
+    void Emit(Fn& onToken) {
+        if (m_len <= kMaxToken) onToken(std::string_view(m_buf, m_len), m_pos);
+        ++m_pos;
+        m_len = 0;
+    }
+    // byte -> lower-case byte, 0 = separator
+    static const uint8_t* Map() {
+        static const struct Table {
+            uint8_t t[256];
+            Table() {
+                for (int c = 0; c < 256; ++c)
+                    t[c] = (uint8_t)((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c >= 0x80 ? c : c >= 'A' && c <= 'Z' ? c + 32 : 0);
+            }
+        } table;
+        return table.t;
+    }
+};
+
+// ---- posting lists ----
+
+inline void FullTextPutVarint(std::vector<uint8_t>& b, uint32_t v) {
+    while (v >= 0x80) { b.push_back((uint8_t)(v | 0x80)); v >>= 7; }
+    b.push_back((uint8_t)v);
+}
+inline uint32_t FullTextGetVarint(const uint8_t*& p) {
+    uint32_t v = *p & 0x7F;
+    if (*p++ < 0x80) return v;
+    for (int shift = 7;; shift += 7) {
+        uint8_t c = *p++;
+        v |= (uint32_t)(c & 0x7F) << shift;
+        if (c < 0x80) return v;
+    }
+}
+
+#pragma pack(push, 1)
+struct FullTextSkip { uint32_t prevDoc; uint64_t offset; };   // block starts after prevDoc, at offset in the list
+struct FullTextDoc { uint64_t size, mtime, pathOff; uint32_t pathLen, tokens; };
+struct FullTextTerm { uint64_t strOff, postOff, postLen, skipOff; uint32_t strLen, df, skipCount, pad; };
+#pragma pack(pop)
+
+// Encodes one posting list: docs in increasing order, each with its positions
+class FullTextPostingWriter {
+public:
+    static constexpr uint32_t kSkipInterval = 128;
+
+    void Add(uint32_t doc, const uint32_t* pos, uint32_t tf) {
+        uint32_t posLen = 0, last = 0;
+        for (uint32_t i = 0; i < tf; ++i) { posLen += VarintSize(pos[i] - last); last = pos[i]; }
+        Begin(doc, tf, posLen);
+        last = 0;
+        for (uint32_t i = 0; i < tf; ++i) { FullTextPutVarint(bytes, pos[i] - last); last = pos[i]; }
+    }
+    // positions already encoded (copied from another list)
+    void AddRaw(uint32_t doc, uint32_t tf, const uint8_t* pos, uint32_t posLen) {
+        Begin(doc, tf, posLen);
+        bytes.insert(bytes.end(), pos, pos + posLen);
+    }
+    // the caller moved bytes out (to a file); offsets continue
+    void Drained(size_t n) { m_written += n; }
+    uint32_t Df() const { return m_df; }
+    uint64_t Length() const { return m_written + bytes.size(); }
+
+    std::vector<uint8_t> bytes;
+    std::vector<FullTextSkip> skips;
+
+private:
+    uint32_t m_last = UINT32_MAX;             // doc deltas start at doc + 1
+    uint32_t m_df = 0;
+    uint64_t m_written = 0;
+
+    static uint32_t VarintSize(uint32_t v) { return v < (1u << 7) ? 1 : v < (1u << 14) ? 2 : v < (1u << 21) ? 3 : v < (1u << 28) ? 4 : 5; }
+    void Begin(uint32_t doc, uint32_t tf, uint32_t posLen) {
+        if (m_df && m_df % kSkipInterval == 0) skips.push_back(FullTextSkip{ m_last, m_written + bytes.size() });
+        FullTextPutVarint(bytes, doc - m_last);
+        FullTextPutVarint(bytes, tf);
+        FullTextPutVarint(bytes, posLen);
+        m_last = doc;
+        ++m_df;
+    }
+};
+
+// term -> dense id; open addressing over one string arena (no allocation per term)
+class FullTextTermTable {
+public:
+    // id of term, added if new
+    uint32_t Intern(std::string_view term, uint64_t hash) {
+        if ((m_count + 1) * 4 > m_slots.size() * 3) Grow();
+        size_t mask = m_slots.size() - 1;
+        uint32_t tag = (uint32_t)(hash >> 32) | 1;          // 0 marks an empty slot
+        for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+            Slot& s = m_slots[i];
+            if (!s.tag) {
+                s.tag = tag;
+                s.id = m_count++;
+                m_terms.push_back(Ref{ m_arena.size(), (uint32_t)term.size(), hash });
+                m_arena.append(term);
+                return s.id;
+            }
+            if (s.tag == tag && Term(s.id) == term) return s.id;
+        }
+    }
+    std::string_view Term(uint32_t id) const { return std::string_view(m_arena.data() + m_terms[id].off, m_terms[id].len); }
+    uint64_t Hash(uint32_t id) const { return m_terms[id].hash; }
+    uint32_t Size() const { return m_count; }
+    size_t Bytes() const { return m_arena.size() + m_terms.size() * sizeof(Ref) + m_slots.size() * sizeof(Slot); }
+
+private:
+    struct Slot { uint32_t tag = 0, id = 0; };
+    struct Ref { size_t off; uint32_t len; uint64_t hash; };
+    std::vector<Slot> m_slots;
+    std::vector<Ref> m_terms;
+    std::string m_arena;
+    uint32_t m_count = 0;
+
+    void Grow() {
+        std::vector<Slot> old(std::max<size_t>(64, m_slots.size() * 2));
+        old.swap(m_slots);
+        size_t mask = m_slots.size() - 1;
+        for (uint32_t id = 0; id < m_count; ++id) {
+            size_t i = (size_t)m_terms[id].hash & mask;
+            while (m_slots[i].tag) i = (i + 1) & mask;
+            m_slots[i] = Slot{ (uint32_t)(m_terms[id].hash >> 32) | 1, id };
+        }
+    }
+};
+
+// Reads one posting list; Advance() uses the skip entries
+class FullTextCursor {
+public:
+    uint32_t doc = 0, tf = 0;
+
+    void Init(const uint8_t* data, uint64_t len, const FullTextSkip* skips, uint32_t skipCount) {
+        m_base = m_p = data;
+        m_end = data + len;
+        m_skips = skips;
+        m_skipCount = skipCount;
+        m_skip = 0;
+        m_last = UINT32_MAX;
+        m_valid = false;
+    }
+    // first doc >= target; false once the list is exhausted
+    bool Advance(uint32_t target) {
+        if (m_valid && doc >= target) return true;
+        const FullTextSkip* jump = nullptr;
+        while (m_skip < m_skipCount && m_skips[m_skip].prevDoc < target) {
+            if (m_base + m_skips[m_skip].offset > m_p) jump = &m_skips[m_skip];
+            ++m_skip;
+        }
+        if (jump) { m_p = m_base + jump->offset; m_last = jump->prevDoc; }
+        while (ReadNext()) if (doc >= target) return true;
+        return false;
+    }
+    bool Next() { return ReadNext(); }
+    // positions of the current doc (ascending)
+    void Positions(std::vector<uint32_t>& out) const {
+        out.resize(tf);
+        const uint8_t* p = m_pos;
+        uint32_t pos = 0;
+        for (uint32_t i = 0; i < tf; ++i) out[i] = pos += FullTextGetVarint(p);
+    }
+    const uint8_t* RawPositions(uint32_t& len) const { len = m_posLen; return m_pos; }
+
+private:
+    const uint8_t *m_base = nullptr, *m_p = nullptr, *m_end = nullptr, *m_pos = nullptr;
+    const FullTextSkip* m_skips = nullptr;
+    uint32_t m_skipCount = 0, m_skip = 0, m_last = UINT32_MAX, m_posLen = 0;
+    bool m_valid = false;
+
+    bool ReadNext() {
+        if (m_p >= m_end) { m_valid = false; return false; }
+        doc = m_last + FullTextGetVarint(m_p);
+        tf = FullTextGetVarint(m_p);
+        m_posLen = FullTextGetVarint(m_p);
+        m_pos = m_p;
+        m_p += m_posLen;
+        m_last = doc;
+        m_valid = true;
+        return true;
+    }
+};
+
+// ---- segments ----
+
+// Writes a segment file: documents first (in memory), then terms in sorted order (postings streamed)
+class FullTextSegmentWriter {
+public:
+    bool Open(const std::filesystem::path& path) {
+        m_path = path;
+        m_file.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_file) return false;
+        Header h{};
+        m_file.write((const char*)&h, sizeof(h));
+        m_offset = sizeof(Header);
+        return (bool)m_file;
+    }
+    void AddDoc(std::string_view path, uint64_t size, uint64_t mtime, uint32_t tokens) {
+        m_docs.push_back(FullTextDoc{ size, mtime, m_paths.size(), (uint32_t)path.size(), tokens });
+        m_paths.append(path);
+        m_totalTokens += tokens;
+    }
+    uint32_t DocCount() const { return (uint32_t)m_docs.size(); }
+
+    // Terms in strictly increasing byte order; Add() docs in increasing order in between
+    void BeginTerm(std::string_view term) {
+        m_term = FullTextTerm{};
+        m_term.strOff = m_strings.size();
+        m_term.strLen = (uint32_t)term.size();
+        m_term.postOff = m_offset;
+        m_strings.append(term);
+        m_post = FullTextPostingWriter();
+    }
+    void Add(uint32_t doc, uint32_t tf, const uint8_t* pos, uint32_t posLen) {
+        m_post.AddRaw(doc, tf, pos, posLen);
+        if (m_post.bytes.size() >= (1u << 20)) Drain();
+    }
+    void EndTerm() {
+        if (m_post.Df() == 0) { m_strings.resize(m_term.strOff); return; }
+        Drain();
+        m_term.postLen = m_post.Length();
+        m_term.df = m_post.Df();
+        m_term.skipOff = m_skips.size();
+        m_term.skipCount = (uint32_t)m_post.skips.size();
+        m_skips.insert(m_skips.end(), m_post.skips.begin(), m_post.skips.end());
+        m_terms.push_back(m_term);
+    }
+
+    bool Finish() {
+        Header h{};
+        memcpy(h.magic, "XPFT", 4);
+        h.version = kVersion;
+        h.docCount = (uint32_t)m_docs.size();
+        h.termCount = (uint32_t)m_terms.size();
+        h.totalTokens = m_totalTokens;
+        h.sections[kPostings] = Section{ sizeof(Header), m_offset - sizeof(Header) };
+        Emit(h, kSkips, m_skips.data(), m_skips.size() * sizeof(FullTextSkip));
+        Emit(h, kTermStrings, m_strings.data(), m_strings.size());
+        Emit(h, kTerms, m_terms.data(), m_terms.size() * sizeof(FullTextTerm));
+        Emit(h, kPaths, m_paths.data(), m_paths.size());
+        Emit(h, kDocs, m_docs.data(), m_docs.size() * sizeof(FullTextDoc));
+        h.checksum = IndexFnv(&h, offsetof(Header, checksum));
+        m_file.seekp(0);
+        m_file.write((const char*)&h, sizeof(h));
+        m_file.flush();
+        bool ok = (bool)m_file;
+        m_file.close();
+        return ok;
+    }
+    void Abort() {
+        m_file.close();
+        std::error_code ec;
+        std::filesystem::remove(m_path, ec);
+    }
+
+    // ---- file layout (shared with FullTextSegment) ----
+    static constexpr uint32_t kVersion = 1;
+    enum SectionId { kPostings, kSkips, kTermStrings, kTerms, kPaths, kDocs, kSectionCount };
+#pragma pack(push, 1)
+    struct Section { uint64_t offset, size; };
+    struct Header {
+        char magic[4];
+        uint32_t version, docCount, termCount;
+        uint64_t totalTokens;
+        Section sections[kSectionCount];
+        uint64_t checksum;                    // over everything above
+    };
+#pragma pack(pop)
+
+private:
+    std::filesystem::path m_path;
+    std::ofstream m_file;
+    uint64_t m_offset = 0, m_totalTokens = 0;
+    std::vector<FullTextDoc> m_docs;
+    std::string m_paths, m_strings;
+    std::vector<FullTextTerm> m_terms;
+    std::vector<FullTextSkip> m_skips;
+    FullTextTerm m_term{};
+    FullTextPostingWriter m_post;
+
+    void Drain() {
+        m_file.write((const char*)m_post.bytes.data(), (std::streamsize)m_post.bytes.size());
+        m_offset += m_post.bytes.size();
+        m_post.Drained(m_post.bytes.size());
+        m_post.bytes.clear();
+    }
+    void Emit(Header& h, SectionId id, const void* data, size_t bytes) {
+        size_t pad = (8 - m_offset % 8) % 8;
+        if (pad) { m_file.write("\0\0\0\0\0\0\0", (std::streamsize)pad); m_offset += pad; }
+        h.sections[id] = Section{ m_offset, bytes };
+        if (bytes) m_file.write((const char*)data, (std::streamsize)bytes);
+        m_offset += bytes;
+    }
+};
+
+// One mapped segment plus its deletion bitmap. Deletes may happen while queries read it.
+class FullTextSegment {
+public:
+    using W = FullTextSegmentWriter;
+
+    ~FullTextSegment() {
+        m_map.Close();
+        if (m_obsolete) { // merged away: files go once the last reader is done
+            std::error_code ec;
+            std::filesystem::remove(m_path, ec);
+            std::filesystem::remove(DelPath(m_path), ec);
+        }
+    }
+
+    bool Open(const std::filesystem::path& path, uint32_t id) {
+        m_path = path;
+        m_id = id;
+        if (!m_map.Open(path) || m_map.Size() < sizeof(W::Header)) return false;
+        m_hdr = (const W::Header*)m_map.Data();
+        if (memcmp(m_hdr->magic, "XPFT", 4) != 0 || m_hdr->version != W::kVersion ||
+            IndexFnv(m_hdr, offsetof(W::Header, checksum)) != m_hdr->checksum) return false;
+        for (auto const& s : m_hdr->sections) if (s.offset + s.size > m_map.Size()) return false;
+        m_docs = (const FullTextDoc*)Section(W::kDocs);
+        m_terms = (const FullTextTerm*)Section(W::kTerms);
+        m_skips = (const FullTextSkip*)Section(W::kSkips);
+        m_strings = (const char*)Section(W::kTermStrings);
+        m_paths = (const char*)Section(W::kPaths);
+        m_postings = m_map.Data();            // postOff is a file offset
+        m_words = ((size_t)DocCount() + 63) / 64;
+        m_deleted.reset(new std::atomic<uint64_t>[m_words]);
+        for (size_t i = 0; i < m_words; ++i) m_deleted[i].store(0, std::memory_order_relaxed);
+        LoadDeletes();
+        return true;
+    }
+
+    uint32_t Id() const { return m_id; }
+    uint32_t DocCount() const { return m_hdr->docCount; }
+    uint32_t TermCount() const { return m_hdr->termCount; }
+    uint64_t TotalTokens() const { return m_hdr->totalTokens; }
+    uint64_t Bytes() const { return m_map.Size(); }
+    const FullTextDoc& Doc(uint32_t d) const { return m_docs[d]; }
+    std::string_view Path(uint32_t d) const { return std::string_view(m_paths + m_docs[d].pathOff, m_docs[d].pathLen); }
+
+    const FullTextTerm& Term(uint32_t i) const { return m_terms[i]; }
+    std::string_view TermString(const FullTextTerm& t) const { return std::string_view(m_strings + t.strOff, t.strLen); }
+    // first term >= s
+    uint32_t LowerBound(std::string_view s) const {
+        uint32_t lo = 0, hi = TermCount();
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            if (TermString(m_terms[mid]) < s) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+    const FullTextTerm* Find(std::string_view s) const {
+        uint32_t i = LowerBound(s);
+        return i < TermCount() && TermString(m_terms[i]) == s ? &m_terms[i] : nullptr;
+    }
+    void Cursor(const FullTextTerm& t, FullTextCursor& c) const {
+        c.Init(m_postings + t.postOff, t.postLen, m_skips + t.skipOff, t.skipCount);
+    }
+
+    bool Deleted(uint32_t d) const { return (m_deleted[d / 64].load(std::memory_order_relaxed) >> (d % 64)) & 1; }
+    // true if it was live
+    bool Delete(uint32_t d) {
+        uint64_t bit = 1ull << (d % 64);
+        if (m_deleted[d / 64].fetch_or(bit) & bit) return false;
+        m_deletedCount.fetch_add(1);
+        m_dirty.store(true);
+        return true;
+    }
+    uint32_t DeletedCount() const { return m_deletedCount.load(); }
+    uint32_t LiveCount() const { return DocCount() - DeletedCount(); }
+    std::vector<uint64_t> DeletedBits() const {
+        std::vector<uint64_t> bits(m_words);
+        for (size_t i = 0; i < m_words; ++i) bits[i] = m_deleted[i].load();
+        return bits;
+    }
+
+    bool SaveDeletes() {
+        if (!m_dirty.exchange(false)) return true;
+        auto bits = DeletedBits();
+        std::filesystem::path tmp = DelPath(m_path);
+        tmp += ".tmp";
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            uint64_t sum = IndexFnv(bits.data(), bits.size() * 8);
+            f.write((const char*)bits.data(), (std::streamsize)(bits.size() * 8));
+            f.write((const char*)&sum, 8);
+            if (!f) { m_dirty.store(true); return false; }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, DelPath(m_path), ec);
+        if (ec) m_dirty.store(true);
+        return !ec;
+    }
+    void MarkObsolete() { m_obsolete = true; }
+    const std::filesystem::path& FilePath() const { return m_path; }
+    static std::filesystem::path DelPath(std::filesystem::path p) { return p.replace_extension(".del"); }
+
+private:
+    std::filesystem::path m_path;
+    uint32_t m_id = 0;
+    IndexMapping m_map;
+    const W::Header* m_hdr = nullptr;
+    const FullTextDoc* m_docs = nullptr;
+    const FullTextTerm* m_terms = nullptr;
+    const FullTextSkip* m_skips = nullptr;
+    const char *m_strings = nullptr, *m_paths = nullptr;
+    const uint8_t* m_postings = nullptr;
+    size_t m_words = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_deleted;
+    std::atomic<uint32_t> m_deletedCount{ 0 };
+    std::atomic<bool> m_dirty{ false };
+    bool m_obsolete = false;
+
+    const uint8_t* Section(int id) const { return m_map.Data() + m_hdr->sections[id].offset; }
+
+    void LoadDeletes() {
+        std::ifstream f(DelPath(m_path), std::ios::binary);
+        if (!f) return;
+        std::vector<uint64_t> bits(m_words);
+        uint64_t sum = 0;
+        f.read((char*)bits.data(), (std::streamsize)(bits.size() * 8));
+        f.read((char*)&sum, 8);
+        if (!f || IndexFnv(bits.data(), bits.size() * 8) != sum) return; // damaged: all live, re-adds fix it
+        uint32_t n = 0;
+        for (size_t i = 0; i < m_words; ++i) {
+            m_deleted[i].store(bits[i], std::memory_order_relaxed);
+            for (uint64_t b = bits[i]; b; b &= b - 1) ++n;
+        }
+        m_deletedCount.store(n);
+    }
+};
+
+// ---- queries ----
+
+struct FullTextClause {
+    std::vector<std::string> tokens;          // more than one = phrase
+    bool prefix = false;                      // single token: every term starting with it
+    bool negated = false;
+};
+using FullTextGroup = std::vector<FullTextClause>;  // all positive clauses must match, no negated one
+
+// words -> clauses; "a b" phrase, -word excludes, word* prefix, OR starts a new group
+inline std::vector<FullTextGroup> FullTextParse(std::string_view q) {
+    std::vector<FullTextGroup> groups(1);
+    auto tokens = [](std::string_view s) {
+        std::vector<std::string> out;
+        FullTextTokenizer t;
+        auto add = [&](std::string_view tok, uint32_t) { out.emplace_back(tok); };
+        t.Feed(s.data(), s.size(), add);
+        t.Finish(add);
+        return out;
+    };
+    size_t i = 0;
+    while (i < q.size()) {
+        if (q[i] == ' ' || q[i] == '\t') { ++i; continue; }
+        FullTextClause c;
+        if (q[i] == '-' && i + 1 < q.size() && q[i + 1] != ' ') { c.negated = true; ++i; }
+        std::string_view item;
+        bool quoted = q[i] == '"';
+        if (quoted) {
+            size_t end = q.find('"', i + 1);
+            if (end == std::string_view::npos) end = q.size();
+            item = q.substr(i + 1, end - i - 1);
+            i = end + 1;
+        } else {
+            size_t end = i;
+            while (end < q.size() && q[end] != ' ' && q[end] != '\t' && q[end] != '"') ++end;
+            item = q.substr(i, end - i);
+            i = end;
+            if (item == "OR" && !c.negated) {
+                if (!groups.back().empty()) groups.emplace_back();
+                continue;
+            }
+        }
+        c.tokens = tokens(item);
+        if (c.tokens.empty()) continue;
+        c.prefix = !quoted && c.tokens.size() == 1 && item.back() == '*';
+        groups.back().push_back(std::move(c));
+    }
+    if (groups.back().empty()) groups.pop_back();
+    return groups;
+}
+
+struct FullTextHit {
+    IndexString path;
+    uint64_t size = 0, mtime = 0;
+    float score = 0;
+    uint32_t matches = 0;                     // occurrences of the matched words / phrases
+};
+
+struct FullTextQueryOptions {
+    size_t topK = 1000;
+    size_t batchSize = 256;
+    IndexString scope;                        // non-empty: only files in this directory or below
+    size_t maxPrefixTerms = 256;              // expansions per prefix* and segment
+};
+
+struct FullTextQueryStats {
+    uint64_t matches = 0;                     // documents matching (before top-k)
+    uint32_t segments = 0;
+};
+
+struct FullTextOptions {
+    uint64_t maxFileBytes = 64ull << 20;      // longer files: only the beginning is indexed
+    size_t bufferBytes = 64u << 20;           // postings held in memory before a segment is written
+    bool backgroundMerge = true;
+    // lower-case, with dot; empty = look at every file (binary ones are still skipped)
+    std::vector<std::string> extensions = {
+        ".txt", ".md", ".rst", ".log", ".csv", ".tsv", ".json", ".xml", ".yaml", ".yml", ".toml", ".ini", ".cfg",
+        ".conf", ".c", ".cc", ".cpp", ".cxx", ".h", ".hh", ".hpp", ".hxx", ".inl", ".cs", ".java", ".kt", ".js",
+        ".jsx", ".ts", ".tsx", ".py", ".rb", ".go", ".rs", ".php", ".swift", ".m", ".mm", ".sql", ".sh", ".bat",
+        ".cmd", ".ps1", ".cmake", ".html", ".htm", ".css", ".scss", ".tex", ".idl", ".xaml", ".props", ".vcxproj",
+        ".sln", ".gradle", ".proto", ".lua", ".pl", ".r" };
+};
+
+struct FullTextStats {
+    size_t segments = 0;
+    uint64_t documents = 0;                   // live
+    uint64_t bytes = 0;                       // segment files
+    size_t bufferedDocs = 0;
+};
+
+class FullTextIndex {
+public:
+    FullTextIndex() = default;
+    FullTextIndex(const FullTextIndex&) = delete;
+    FullTextIndex& operator=(const FullTextIndex&) = delete;
+    ~FullTextIndex() { Close(); }
+
+    // dir holds fulltext.manifest and the segment files. Segments not in the manifest (a crash
+    // before Commit) are removed; their documents are simply missing until added again.
+    bool Open(const std::filesystem::path& dir, FullTextOptions opt = FullTextOptions()) {
+        Close();
+        std::lock_guard<std::mutex> cg(m_commitMutex);
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_dir = dir;
+        m_opt = std::move(opt);
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        std::vector<uint32_t> ids;
+        ReadManifest(ids);
+        for (uint32_t id : ids) {
+            auto seg = std::make_shared<FullTextSegment>();
+            if (seg->Open(SegmentPath(id), id)) m_segments.push_back(std::move(seg));
+            m_nextId = std::max(m_nextId, id + 1);
+        }
+        for (auto const& e : std::filesystem::directory_iterator(dir, ec)) {
+            auto name = e.path().filename().string();
+            if (name.rfind("ft_", 0) != 0) continue;
+            uint32_t id = (uint32_t)strtoul(name.c_str() + 3, nullptr, 10);
+            if (std::find(ids.begin(), ids.end(), id) == ids.end()) std::filesystem::remove(e.path(), ec);
+        }
+        for (auto const& seg : m_segments)
+            for (uint32_t d = 0; d < seg->DocCount(); ++d)
+                if (!seg->Deleted(d)) m_docs[PathKey(seg->Path(d))] = DocRef{ seg->Id(), d };
+        m_buffer = NewBuffer();
+        m_open = true;
+        if (m_opt.backgroundMerge) {
+            m_stopMerge = false;
+            m_merger = std::thread([this]() { MergeLoop(); });
+        }
+        return true;
+    }
+
+    void Close() {
+        if (m_merger.joinable()) {
+            {
+                std::lock_guard<std::mutex> lg(m_mergeMutex);
+                m_stopMerge = true;
+            }
+            m_mergeCv.notify_all();
+            m_merger.join();
+        }
+        if (m_open) Commit();
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_open = false;
+        m_segments.clear();
+        m_docs.clear();
+        m_buffer.reset();
+        m_flushing.clear();
+    }
+
+    // Read and tokenize one file (any thread) and replace what the index had for it.
+    // Returns false if the file could not be read (the old version is removed all the same).
+    bool AddFile(const std::filesystem::path& path, uint64_t size, uint64_t mtime, const std::atomic<bool>* cancel = nullptr) {
+        Parsed doc;
+        bool ok = true;
+        if (Wanted(path)) ok = ReadTokens(path, doc, cancel);
+        if (cancel && cancel->load()) return false;
+        AddParsed(FullTextUtf8(path.native()), size, mtime, doc);
+        return ok;
+    }
+    // Document from memory (text is UTF-8)
+    void AddText(IndexStringView path, uint64_t size, uint64_t mtime, std::string_view text) {
+        Parsed doc;
+        Tokenize(text.data(), text.size(), doc);
+        doc.Finish();
+        AddParsed(FullTextUtf8(path), size, mtime, doc);
+    }
+
+    void Remove(IndexStringView path) {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        auto it = m_docs.find(PathKey(FullTextUtf8(path)));
+        if (it == m_docs.end()) return;
+        MarkDeleted(it->second);
+        m_docs.erase(it);
+    }
+    // Does the index hold path with exactly this size / mtime (as given to AddFile)?
+    bool Contains(IndexStringView path, uint64_t size, uint64_t mtime) {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        auto it = m_docs.find(PathKey(FullTextUtf8(path)));
+        if (it == m_docs.end()) return false;
+        const FullTextDoc* d = DocOf(it->second);
+        return d && d->size == size && d->mtime == mtime;
+    }
+    // Remove every document for which gone(path) is true (e.g. no longer in the file index)
+    void RemoveIf(const std::function<bool(IndexStringView)>& gone) {
+        std::vector<std::pair<uint64_t, IndexString>> paths;
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            paths.reserve(m_docs.size());
+            for (auto const& kv : m_docs) paths.emplace_back(kv.first, FullTextNative(PathOf(kv.second)));
+        }
+        std::vector<uint64_t> drop;
+        for (auto const& p : paths) if (gone(p.second)) drop.push_back(p.first);
+        std::lock_guard<std::mutex> lg(m_mutex);
+        for (uint64_t key : drop) {
+            auto it = m_docs.find(key);
+            if (it == m_docs.end()) continue;
+            MarkDeleted(it->second);
+            m_docs.erase(it);
+        }
+    }
+
+    // Buffered documents -> new segment, deletions + manifest to disk; wakes the merger
+    bool Commit() {
+        bool ok = Flush();
+        {
+            std::lock_guard<std::mutex> cg(m_commitMutex);
+            ok = WriteState() && ok;
+        }
+        {
+            std::lock_guard<std::mutex> lg(m_mergeMutex);
+            m_mergeWanted = true;
+        }
+        m_mergeCv.notify_all();
+        return ok;
+    }
+
+    // Merge until the policy is satisfied (the background thread does the same)
+    void MergeAll() { while (MergeOnce()) {} }
+
+    FullTextStats Stats() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        FullTextStats s;
+        s.segments = m_segments.size();
+        for (auto const& seg : m_segments) { s.documents += seg->LiveCount(); s.bytes += seg->Bytes(); }
+        s.bufferedDocs = m_buffer ? m_buffer->docs.size() : 0;
+        return s;
+    }
+
+    // Document frequency of each term (tokens as FullTextTokenizer makes them) over the committed
+    // segments; replaced versions count until their segment is merged. Returns the live documents.
+    uint64_t DocFrequencies(const std::vector<std::string_view>& terms, uint32_t* df) {
+        std::vector<std::shared_ptr<FullTextSegment>> segs;
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            segs = m_segments;
+        }
+        uint64_t live = 0;
+        for (size_t i = 0; i < terms.size(); ++i) df[i] = 0;
+        for (auto const& s : segs) {
+            live += s->LiveCount();
+            for (size_t i = 0; i < terms.size(); ++i)
+                if (const FullTextTerm* t = s->Find(terms[i])) df[i] += t->df;
+        }
+        return live;
+    }
+
+    // Ranked search over the committed segments. onBatch gets the top-k, best first, in batches.
+    // false = cancelled.
+    bool Query(IndexStringView query, const FullTextQueryOptions& opt, const std::function<void(std::vector<FullTextHit>&&)>& onBatch,
+               FullTextQueryStats* stats = nullptr, const std::atomic<bool>* cancel = nullptr) {
+        auto groups = FullTextParse(FullTextUtf8(query));
+        std::vector<std::shared_ptr<FullTextSegment>> segs;
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            segs = m_segments;
+        }
+        if (stats) { *stats = FullTextQueryStats(); stats->segments = (uint32_t)segs.size(); }
+        if (groups.empty() || segs.empty()) return true;
+
+        // collection statistics for BM25
+        double live = 0, tokens = 0, docs = 0;
+        for (auto const& s : segs) { live += s->LiveCount(); tokens += (double)s->TotalTokens(); docs += s->DocCount(); }
+        double avgdl = docs ? std::max(1.0, tokens / docs) : 1.0;
+        std::vector<std::vector<double>> idf(groups.size());
+        for (size_t g = 0; g < groups.size(); ++g)
+            for (auto const& c : groups[g]) idf[g].push_back(c.negated ? 0.0 : Idf(segs, c, live, opt.maxPrefixTerms));
+
+        std::string scope = FullTextUtf8(opt.scope);
+        while (!scope.empty() && (scope.back() == '/' || scope.back() == '\\')) scope.pop_back();
+        TopK top(opt.topK);
+        uint64_t matches = 0;
+        for (size_t si = 0; si < segs.size(); ++si) {
+            if (cancel && cancel->load()) return false;
+            const FullTextSegment& seg = *segs[si];
+            auto accept = [&](uint32_t d) {
+                if (seg.Deleted(d)) return false;
+                if (scope.empty()) return true;
+                std::string_view p = seg.Path(d);
+                return p.size() > scope.size() && p.compare(0, scope.size(), scope) == 0 && (p[scope.size()] == '/' || p[scope.size()] == '\\');
+            };
+            if (groups.size() == 1) {
+                matches += MatchGroup(seg, groups[0], idf[0], avgdl, opt, accept, cancel, [&](uint32_t d, float score, uint32_t n) { top.Push(score, (uint32_t)si, d, n); });
+                continue;
+            }
+            // OR: a document counts once, with its best group
+            std::vector<Scored> all;
+            for (size_t g = 0; g < groups.size(); ++g)
+                MatchGroup(seg, groups[g], idf[g], avgdl, opt, accept, cancel, [&](uint32_t d, float score, uint32_t n) { all.push_back(Scored{ score, (uint32_t)si, d, n }); });
+            std::sort(all.begin(), all.end(), [](const Scored& a, const Scored& b) { return a.doc != b.doc ? a.doc < b.doc : a.score > b.score; });
+            for (size_t i = 0; i < all.size(); ++i) {
+                if (i && all[i].doc == all[i - 1].doc) continue;
+                top.Push(all[i].score, all[i].seg, all[i].doc, all[i].matches);
+                ++matches;
+            }
+        }
+        if (stats) stats->matches = matches;
+        if (cancel && cancel->load()) return false;
+
+        auto best = top.Sorted();
+        std::vector<FullTextHit> batch;
+        for (auto const& s : best) {
+            const FullTextSegment& seg = *segs[s.seg];
+            const FullTextDoc& d = seg.Doc(s.doc);
+            FullTextHit h;
+            h.path = FullTextNative(seg.Path(s.doc));
+            h.size = d.size;
+            h.mtime = d.mtime;
+            h.score = s.score;
+            h.matches = s.matches;
+            batch.push_back(std::move(h));
+            if (batch.size() >= std::max<size_t>(1, opt.batchSize)) { onBatch(std::move(batch)); batch = std::vector<FullTextHit>(); }
+        }
+        if (!batch.empty()) onBatch(std::move(batch));
+        return true;
+    }
+
+    std::vector<FullTextHit> Query(IndexStringView query, const FullTextQueryOptions& opt = FullTextQueryOptions(), FullTextQueryStats* stats = nullptr) {
+        std::vector<FullTextHit> out;
+        Query(query, opt, [&out](std::vector<FullTextHit>&& b) { out.insert(out.end(), std::make_move_iterator(b.begin()), std::make_move_iterator(b.end())); }, stats);
+        return out;
+    }
+
+private:
+    static constexpr size_t kMergeFactor = 4;      // segments of one size tier merged at once
+    static constexpr size_t kMaxSegments = 24;
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    struct DocRef { uint32_t seg, doc; };
+
+    // Documents not yet written: same shape as a segment, postings encoded in memory
+    struct Buffer {
+        uint32_t id = 0;                          // segment id it will be written as
+        std::vector<FullTextDoc> docs;
+        std::string paths;
+        std::vector<uint8_t> deleted;
+        FullTextTermTable terms;
+        std::vector<FullTextPostingWriter> postings;  // by term id
+        size_t bytes = 0;
+    };
+
+    // one document's tokens: term ids in position order, grouped per term by Finish()
+    struct Parsed {
+        FullTextTermTable terms;
+        std::vector<std::pair<uint32_t, uint32_t>> tokens;  // (term id, position)
+        std::vector<uint32_t> start, positions;             // term id -> its positions
+        FullTextTokenizer tokenizer;
+        uint32_t count = 0;
+        bool finished = false;
+        void Add(std::string_view tok, uint32_t pos) {
+            tokens.emplace_back(terms.Intern(tok, FastHash64(tok.data(), tok.size())), pos);
+        }
+        void Finish() {
+            if (finished) return;
+            finished = true;
+            tokenizer.Finish([this](std::string_view t, uint32_t p) { Add(t, p); });
+            count = tokenizer.Count();
+            // counting sort keeps each term's positions ascending
+            start.assign(terms.Size() + 1, 0);
+            for (auto const& t : tokens) ++start[t.first + 1];
+            for (size_t i = 1; i < start.size(); ++i) start[i] += start[i - 1];
+            positions.resize(tokens.size());
+            std::vector<uint32_t> at(start.begin(), start.end() - 1);
+            for (auto const& t : tokens) positions[at[t.first]++] = t.second;
+        }
+    };
+
+    struct Scored { float score; uint32_t seg, doc, matches; };
+    class TopK {
+    public:
+        explicit TopK(size_t k) : m_k(std::max<size_t>(1, k)) {}
+        void Push(float score, uint32_t seg, uint32_t doc, uint32_t matches) {
+            if (m_heap.size() == m_k && !(score > m_heap.front().score)) return;
+            m_heap.push_back(Scored{ score, seg, doc, matches });
+            std::push_heap(m_heap.begin(), m_heap.end(), Less);
+            if (m_heap.size() > m_k) { std::pop_heap(m_heap.begin(), m_heap.end(), Less); m_heap.pop_back(); }
+        }
+        std::vector<Scored> Sorted() {
+            std::sort(m_heap.begin(), m_heap.end(), [](const Scored& a, const Scored& b) { return a.score > b.score; });
+            return std::move(m_heap);
+        }
+    private:
+        static bool Less(const Scored& a, const Scored& b) { return a.score > b.score; } // min-heap
+        size_t m_k;
+        std::vector<Scored> m_heap;
+    };
+
+    std::filesystem::path m_dir;
+    FullTextOptions m_opt;
+    bool m_open = false;
+    std::mutex m_mutex;                           // segments, buffer, doc map, deletions
+    std::mutex m_commitMutex;                     // manifest / .del writes, segment swaps
+    std::vector<std::shared_ptr<FullTextSegment>> m_segments;
+    std::shared_ptr<Buffer> m_buffer;
+    std::vector<std::shared_ptr<Buffer>> m_flushing; // being written, still take deletes
+    std::unordered_map<uint64_t, DocRef> m_docs;  // path key -> live version
+    uint32_t m_nextId = 1;
+
+    std::thread m_merger;
+    std::mutex m_mergeMutex, m_mergeRunMutex;
+    std::condition_variable m_mergeCv;
+    bool m_stopMerge = false, m_mergeWanted = false;
+
+    static uint64_t PathKey(std::string_view utf8) { return FastHash64(utf8.data(), utf8.size()); }
+    std::filesystem::path SegmentPath(uint32_t id) const {
+        char name[32];
+        snprintf(name, sizeof(name), "ft_%06u.seg", id);
+        return m_dir / name;
+    }
+
+    // ---- adding ----
+
+    bool Wanted(const std::filesystem::path& path) const {
+        if (m_opt.extensions.empty()) return true;
+        std::string ext = FullTextUtf8(path.extension().native());
+        for (auto& c : ext) if (c >= 'A' && c <= 'Z') c += 32;
+        return std::find(m_opt.extensions.begin(), m_opt.extensions.end(), ext) != m_opt.extensions.end();
+    }
+
+    static void Tokenize(const char* p, size_t n, Parsed& doc) {
+        doc.tokenizer.Feed(p, n, [&doc](std::string_view t, uint32_t pos) { doc.Add(t, pos); });
+    }
+
+    bool ReadTokens(const std::filesystem::path& path, Parsed& doc, const std::atomic<bool>* cancel) {
+        HashReader r;
+        if (!r.Open(path)) return false;
+        std::vector<char> buf(256 * 1024);
+        std::string utf8;
+        uint64_t offset = 0;
+        bool utf16 = false;
+        uint8_t carry = 0;
+        bool hasCarry = false;
+        uint32_t pendingHigh = 0;
+        while (offset < m_opt.maxFileBytes) {
+            if (cancel && cancel->load()) return false;
+            size_t want = (size_t)std::min<uint64_t>(buf.size(), m_opt.maxFileBytes - offset);
+            int64_t got = r.ReadAt(offset, buf.data(), want);
+            if (got < 0) return false;
+            if (got == 0) break;
+            const char* p = buf.data();
+            size_t n = (size_t)got;
+            if (offset == 0) {
+                if (n >= 2 && (uint8_t)p[0] == 0xFF && (uint8_t)p[1] == 0xFE) { utf16 = true; p += 2; n -= 2; }
+                else {
+                    if (n >= 3 && (uint8_t)p[0] == 0xEF && (uint8_t)p[1] == 0xBB && (uint8_t)p[2] == 0xBF) { p += 3; n -= 3; }
+                    if (memchr(p, 0, std::min<size_t>(n, 8192))) return true; // binary: no tokens
+                }
+            }
+            offset += (uint64_t)got;
+            if (!utf16) { Tokenize(p, n, doc); continue; }
+            // UTF-16LE -> UTF-8 (a code unit or surrogate pair may straddle two reads)
+            utf8.clear();
+            for (size_t i = 0; i < n; ++i) {
+                if (!hasCarry) { carry = (uint8_t)p[i]; hasCarry = true; continue; }
+                hasCarry = false;
+                uint32_t u = carry | (uint32_t)(uint8_t)p[i] << 8;
+                if (u >= 0xD800 && u < 0xDC00) { pendingHigh = u; continue; }
+                if (u >= 0xDC00 && u < 0xE000 && pendingHigh) u = 0x10000 + ((pendingHigh - 0xD800) << 10) + (u - 0xDC00);
+                pendingHigh = 0;
+                FullTextPutUtf8(utf8, u);
+            }
+            Tokenize(utf8.data(), utf8.size(), doc);
+            if ((uint64_t)got < want) break;
+        }
+        doc.Finish();
+        return true;
+    }
+
+    void AddParsed(const std::string& path, uint64_t size, uint64_t mtime, Parsed& doc) {
+        doc.Finish();
+        std::shared_ptr<Buffer> full;
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            if (!m_open) return;
+            uint64_t key = PathKey(path);
+            auto it = m_docs.find(key);
+            if (it != m_docs.end()) MarkDeleted(it->second);
+            Buffer& b = *m_buffer;
+            uint32_t id = (uint32_t)b.docs.size();
+            b.docs.push_back(FullTextDoc{ size, mtime, b.paths.size(), (uint32_t)path.size(), doc.count });
+            b.paths += path;
+            b.deleted.push_back(0);
+            m_docs[key] = DocRef{ b.id, id };
+            size_t tableBytes = b.terms.Bytes();
+            for (uint32_t t = 0; t < doc.terms.Size(); ++t) {
+                uint32_t gt = b.terms.Intern(doc.terms.Term(t), doc.terms.Hash(t));
+                if (gt == b.postings.size()) b.postings.emplace_back();
+                auto& post = b.postings[gt];
+                size_t before = post.bytes.capacity();
+                post.Add(id, doc.positions.data() + doc.start[t], doc.start[t + 1] - doc.start[t]);
+                b.bytes += post.bytes.capacity() - before;
+            }
+            b.bytes += b.terms.Bytes() - tableBytes + path.size() + sizeof(FullTextDoc);
+            if (b.bytes >= m_opt.bufferBytes) full = SwapBuffer();
+        }
+        if (full) WriteBuffer(full);
+    }
+
+    // under m_mutex
+    std::shared_ptr<Buffer> NewBuffer() {
+        auto b = std::make_shared<Buffer>();
+        b->id = NextId();
+        return b;
+    }
+    uint32_t NextId() { return m_nextId++; }
+    std::shared_ptr<Buffer> SwapBuffer() {
+        auto full = m_buffer;
+        m_flushing.push_back(full);
+        m_buffer = NewBuffer();
+        return full;
+    }
+
+    bool Flush() {
+        std::shared_ptr<Buffer> full;
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            if (!m_buffer || m_buffer->docs.empty()) return true;
+            full = SwapBuffer();
+        }
+        return WriteBuffer(full);
+    }
+
+    // Buffer -> segment file -> searchable
+    bool WriteBuffer(const std::shared_ptr<Buffer>& b) {
+        std::vector<uint32_t> order(b->terms.Size());
+        for (uint32_t t = 0; t < order.size(); ++t) order[t] = t;
+        std::sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) { return b->terms.Term(x) < b->terms.Term(y); });
+        FullTextSegmentWriter w;
+        bool ok = w.Open(SegmentPath(b->id));
+        if (ok) {
+            for (auto const& d : b->docs) w.AddDoc(std::string_view(b->paths).substr(d.pathOff, d.pathLen), d.size, d.mtime, d.tokens);
+            FullTextCursor c;
+            for (uint32_t t : order) {
+                w.BeginTerm(b->terms.Term(t));
+                c.Init(b->postings[t].bytes.data(), b->postings[t].bytes.size(), nullptr, 0);
+                uint32_t posLen;
+                while (c.Next()) {
+                    const uint8_t* pos = c.RawPositions(posLen);
+                    w.Add(c.doc, c.tf, pos, posLen);
+                }
+                w.EndTerm();
+            }
+            ok = w.Finish();
+        }
+        auto seg = std::make_shared<FullTextSegment>();
+        ok = ok && seg->Open(SegmentPath(b->id), b->id);
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_flushing.erase(std::remove(m_flushing.begin(), m_flushing.end(), b), m_flushing.end());
+        if (!ok) {
+            w.Abort();
+            for (auto it = m_docs.begin(); it != m_docs.end();) { // its documents are gone; re-adding restores them
+                if (it->second.seg == b->id) it = m_docs.erase(it); else ++it;
+            }
+            return false;
+        }
+        for (uint32_t d = 0; d < b->deleted.size(); ++d) if (b->deleted[d]) seg->Delete(d); // deleted while writing
+        m_segments.push_back(seg);
+        return true;
+    }
+
+    // under m_mutex
+    void MarkDeleted(DocRef r) {
+        for (auto const& s : m_segments) if (s->Id() == r.seg) { s->Delete(r.doc); return; }
+        if (m_buffer && m_buffer->id == r.seg) { m_buffer->deleted[r.doc] = 1; return; }
+        for (auto const& b : m_flushing) if (b->id == r.seg) { b->deleted[r.doc] = 1; return; }
+    }
+    const FullTextDoc* DocOf(DocRef r) const {
+        for (auto const& s : m_segments) if (s->Id() == r.seg) return &s->Doc(r.doc);
+        if (m_buffer && m_buffer->id == r.seg) return &m_buffer->docs[r.doc];
+        for (auto const& b : m_flushing) if (b->id == r.seg) return &b->docs[r.doc];
+        return nullptr;
+    }
+    std::string_view PathOf(DocRef r) const {
+        for (auto const& s : m_segments) if (s->Id() == r.seg) return s->Path(r.doc);
+        auto fromBuffer = [&](const Buffer& b) { return std::string_view(b.paths).substr(b.docs[r.doc].pathOff, b.docs[r.doc].pathLen); };
+        if (m_buffer && m_buffer->id == r.seg) return fromBuffer(*m_buffer);
+        for (auto const& b : m_flushing) if (b->id == r.seg) return fromBuffer(*b);
+        return {};
+    }
+
+    // ---- manifest ----
+
+    void ReadManifest(std::vector<uint32_t>& ids) {
+        std::ifstream f(m_dir / "fulltext.manifest");
+        std::string word;
+        uint32_t v = 0;
+        if (!(f >> word >> v) || word != "XPFT" || v != FullTextSegmentWriter::kVersion) return;
+        while (f >> word >> v) {
+            if (word == "next") m_nextId = std::max(m_nextId, v);
+            else if (word == "seg") ids.push_back(v);
+        }
+    }
+    // under m_commitMutex
+    bool WriteState() {
+        std::vector<std::shared_ptr<FullTextSegment>> segs;
+        uint32_t next;
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            if (!m_open) return true;
+            segs = m_segments;
+            next = m_nextId;
+        }
+        bool ok = true;
+        for (auto const& s : segs) ok = s->SaveDeletes() && ok;
+        std::filesystem::path tmp = m_dir / "fulltext.manifest.tmp";
+        {
+            std::ofstream f(tmp, std::ios::trunc);
+            f << "XPFT " << FullTextSegmentWriter::kVersion << "\nnext " << next << "\n";
+            for (auto const& s : segs) f << "seg " << s->Id() << "\n";
+            if (!f) return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, m_dir / "fulltext.manifest", ec);
+        return ok && !ec;
+    }
+
+    // ---- merging ----
+
+    void MergeLoop() {
+        std::unique_lock<std::mutex> lk(m_mergeMutex);
+        while (!m_stopMerge) {
+            m_mergeCv.wait(lk, [this]() { return m_stopMerge || m_mergeWanted; });
+            m_mergeWanted = false;
+            lk.unlock();
+            while (!StopRequested() && MergeOnce()) {}
+            lk.lock();
+        }
+    }
+    bool StopRequested() {
+        std::lock_guard<std::mutex> lg(m_mergeMutex);
+        return m_stopMerge;
+    }
+
+    // Tiers by file size (factor 4): kMergeFactor segments of one tier are merged; a segment that is
+    // mostly deleted is rewritten alone; past kMaxSegments the smallest ones are merged.
+    std::vector<std::shared_ptr<FullTextSegment>> PickMerge() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        std::vector<std::shared_ptr<FullTextSegment>> segs = m_segments;
+        std::sort(segs.begin(), segs.end(), [](auto const& a, auto const& b) { return a->Bytes() < b->Bytes(); });
+        auto tier = [](uint64_t bytes) { int t = 0; for (bytes >>= 20; bytes; bytes >>= 2) ++t; return t; }; // 1 MB, 4 MB, 16 MB, ...
+        for (size_t i = 0; i + kMergeFactor <= segs.size(); ++i)
+            if (tier(segs[i]->Bytes()) == tier(segs[i + kMergeFactor - 1]->Bytes()))
+                return std::vector<std::shared_ptr<FullTextSegment>>(segs.begin() + i, segs.begin() + i + kMergeFactor);
+        for (auto const& s : segs)
+            if (s->DocCount() && s->DeletedCount() * 3 > s->DocCount()) return { s };
+        if (segs.size() > kMaxSegments) return std::vector<std::shared_ptr<FullTextSegment>>(segs.begin(), segs.begin() + kMergeFactor);
+        return {};
+    }
+
+    bool MergeOnce() {
+        std::lock_guard<std::mutex> rg(m_mergeRunMutex); // MergeAll() and the merger thread pick in turn
+        if (!m_open) return false;
+        auto inputs = PickMerge();
+        if (inputs.empty()) return false;
+        std::sort(inputs.begin(), inputs.end(), [](auto const& a, auto const& b) { return a->Id() < b->Id(); });
+        uint32_t id;
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            id = NextId();
+        }
+        // live documents at the start, renumbered in input order (keeps every posting list sorted)
+        std::vector<std::vector<uint64_t>> deletedAtStart;
+        std::vector<std::vector<uint32_t>> remap;
+        FullTextSegmentWriter w;
+        if (!w.Open(SegmentPath(id))) return false;
+        uint32_t next = 0;
+        for (auto const& s : inputs) {
+            deletedAtStart.push_back(s->DeletedBits());
+            auto const& del = deletedAtStart.back();
+            remap.emplace_back(s->DocCount(), kNone);
+            for (uint32_t d = 0; d < s->DocCount(); ++d) {
+                if ((del[d / 64] >> (d % 64)) & 1) continue;
+                remap.back()[d] = next++;
+                w.AddDoc(s->Path(d), s->Doc(d).size, s->Doc(d).mtime, s->Doc(d).tokens);
+            }
+        }
+        // k-way merge of the sorted dictionaries
+        std::vector<uint32_t> at(inputs.size(), 0);
+        FullTextCursor c;
+        size_t steps = 0;
+        for (;;) {
+            std::string_view term;
+            bool any = false;
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                if (at[i] >= inputs[i]->TermCount()) continue;
+                std::string_view t = inputs[i]->TermString(inputs[i]->Term(at[i]));
+                if (!any || t < term) { term = t; any = true; }
+            }
+            if (!any) break;
+            if ((++steps & 4095) == 0 && StopRequested()) { w.Abort(); return false; }
+            w.BeginTerm(term);
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                if (at[i] >= inputs[i]->TermCount()) continue;
+                const FullTextTerm& t = inputs[i]->Term(at[i]);
+                if (inputs[i]->TermString(t) != term) continue;
+                ++at[i];
+                inputs[i]->Cursor(t, c);
+                uint32_t posLen;
+                while (c.Next()) {
+                    uint32_t nd = remap[i][c.doc];
+                    if (nd == kNone) continue;
+                    const uint8_t* pos = c.RawPositions(posLen);
+                    w.Add(nd, c.tf, pos, posLen);
+                }
+            }
+            w.EndTerm();
+        }
+        std::shared_ptr<FullTextSegment> merged;
+        if (next == 0) w.Abort();                 // nothing live: the inputs just go
+        else {
+            merged = std::make_shared<FullTextSegment>();
+            if (!w.Finish() || !merged->Open(SegmentPath(id), id)) { w.Abort(); return false; }
+        }
+
+        std::lock_guard<std::mutex> cg(m_commitMutex);
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            if (!m_open) { if (merged) merged->MarkObsolete(); return false; }
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                auto const& s = inputs[i];
+                for (uint32_t d = 0; d < s->DocCount(); ++d) {
+                    uint32_t nd = remap[i][d];
+                    if (nd == kNone) continue;
+                    if (s->Deleted(d)) { merged->Delete(nd); continue; } // deleted during the merge
+                    auto it = m_docs.find(PathKey(s->Path(d)));
+                    if (it != m_docs.end() && it->second.seg == s->Id() && it->second.doc == d) it->second = DocRef{ id, nd };
+                }
+                s->MarkObsolete();
+            }
+            auto& segs = m_segments;
+            segs.erase(std::remove_if(segs.begin(), segs.end(), [&](auto const& s) { return std::find(inputs.begin(), inputs.end(), s) != inputs.end(); }), segs.end());
+            if (merged) segs.push_back(merged);
+        }
+        WriteState();                             // inputs' files are removed once the last query lets go
+        return true;
+    }
+
+    // ---- query evaluation ----
+
+    double Idf(const std::vector<std::shared_ptr<FullTextSegment>>& segs, const FullTextClause& c, double live, size_t maxPrefix) const {
+        double df = 0;
+        if (c.prefix) {
+            for (auto const& s : segs) {
+                size_t n = 0;
+                for (uint32_t i = s->LowerBound(c.tokens[0]); i < s->TermCount() && n < maxPrefix; ++i, ++n) {
+                    const FullTextTerm& t = s->Term(i);
+                    if (s->TermString(t).substr(0, c.tokens[0].size()) != c.tokens[0]) break;
+                    df += t.df;
+                }
+            }
+            df = std::min(df, live);
+        } else {
+            df = live;
+            for (auto const& tok : c.tokens) {
+                double d = 0;
+                for (auto const& s : segs) if (auto* t = s->Find(tok)) d += t->df;
+                df = std::min(df, d);             // a phrase is at most as common as its rarest word
+            }
+        }
+        return std::log(1.0 + (live - df + 0.5) / (df + 0.5));
+    }
+
+    // Documents of one clause in one segment, in order; Next(target) = first doc >= target
+    class ClauseIter {
+    public:
+        uint32_t doc = 0, freq = 0;
+        uint64_t cost = 0;                        // df of the rarest term
+
+        bool Init(const FullTextSegment& seg, const FullTextClause& c, size_t maxPrefix) {
+            if (c.prefix) {
+                // union of the expansions, materialized (doc, tf)
+                std::vector<std::pair<uint32_t, uint32_t>> all;
+                FullTextCursor cur;
+                size_t n = 0;
+                for (uint32_t i = seg.LowerBound(c.tokens[0]); i < seg.TermCount() && n < maxPrefix; ++i, ++n) {
+                    const FullTextTerm& t = seg.Term(i);
+                    if (seg.TermString(t).substr(0, c.tokens[0].size()) != c.tokens[0]) break;
+                    seg.Cursor(t, cur);
+                    while (cur.Next()) all.emplace_back(cur.doc, cur.tf);
+                }
+                std::sort(all.begin(), all.end());
+                for (auto const& p : all) {
+                    if (!m_list.empty() && m_list.back().first == p.first) m_list.back().second += p.second;
+                    else m_list.push_back(p);
+                }
+                m_prefix = true;
+                cost = m_list.size();
+                return !m_list.empty();
+            }
+            m_cursors.resize(c.tokens.size());
+            cost = UINT64_MAX;
+            for (size_t i = 0; i < c.tokens.size(); ++i) {
+                const FullTextTerm* t = seg.Find(c.tokens[i]);
+                if (!t) return false;
+                seg.Cursor(*t, m_cursors[i]);
+                cost = std::min<uint64_t>(cost, t->df);
+            }
+            return true;
+        }
+
+        bool Next(uint32_t target) {
+            if (m_valid && doc >= target) return true;
+            m_valid = false;
+            if (m_prefix) {
+                while (m_at < m_list.size() && m_list[m_at].first < target) ++m_at;
+                if (m_at >= m_list.size()) return false;
+                doc = m_list[m_at].first;
+                freq = m_list[m_at].second;
+                return m_valid = true;
+            }
+            for (;;) {
+                // leapfrog: all cursors on the same document
+                uint32_t d = target;
+                for (size_t i = 0; i < m_cursors.size();) {
+                    if (!m_cursors[i].Advance(d)) return false;
+                    if (m_cursors[i].doc != d) { d = m_cursors[i].doc; i = 0; continue; }
+                    ++i;
+                }
+                uint32_t f = m_cursors.size() == 1 ? m_cursors[0].tf : PhraseCount();
+                if (f) { doc = d; freq = f; return m_valid = true; }
+                target = d + 1;
+            }
+        }
+
+    private:
+        std::vector<FullTextCursor> m_cursors;
+        std::vector<std::pair<uint32_t, uint32_t>> m_list;
+        size_t m_at = 0;
+        bool m_prefix = false, m_valid = false;
+        std::vector<std::vector<uint32_t>> m_pos;
+
+        // occurrences of the words at consecutive positions
+        uint32_t PhraseCount() {
+            m_pos.resize(m_cursors.size());
+            for (size_t i = 0; i < m_cursors.size(); ++i) m_cursors[i].Positions(m_pos[i]);
+            std::vector<size_t> at(m_cursors.size(), 0);
+            uint32_t n = 0;
+            for (uint32_t p0 : m_pos[0]) {
+                bool ok = true;
+                for (size_t i = 1; i < m_pos.size() && ok; ++i) {
+                    auto const& v = m_pos[i];
+                    while (at[i] < v.size() && v[at[i]] < p0 + i) ++at[i];
+                    ok = at[i] < v.size() && v[at[i]] == p0 + i;
+                }
+                n += ok;
+            }
+            return n;
+        }
+    };
+
+    template <class Accept, class Emit>
+    uint64_t MatchGroup(const FullTextSegment& seg, const FullTextGroup& g, const std::vector<double>& idf, double avgdl,
+                        const FullTextQueryOptions& opt, Accept&& accept, const std::atomic<bool>* cancel, Emit&& emit) const {
+        std::vector<ClauseIter> pos, neg;
+        std::vector<double> weight;
+        for (size_t i = 0; i < g.size(); ++i) {
+            ClauseIter it;
+            bool found = it.Init(seg, g[i], opt.maxPrefixTerms);
+            if (g[i].negated) { if (found) neg.push_back(std::move(it)); continue; }
+            if (!found) return 0;                 // a required word is not in this segment
+            pos.push_back(std::move(it));
+            weight.push_back(idf[i]);
+        }
+        if (pos.empty()) return 0;                // only exclusions: nothing to rank
+        // rarest clause drives the intersection
+        std::vector<size_t> order(pos.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return pos[a].cost < pos[b].cost; });
+
+        const double k1 = 1.2, b = 0.75;
+        uint64_t n = 0, steps = 0;
+        uint32_t target = 0;
+        for (;;) {
+            if ((++steps & 4095) == 0 && cancel && cancel->load()) break;
+            bool done = false, all = true;
+            for (size_t k = 0; k < order.size(); ++k) {
+                ClauseIter& it = pos[order[k]];
+                if (!it.Next(target)) { done = true; break; }
+                if (it.doc != target) {
+                    target = it.doc;
+                    all = k == 0;                 // the driver only sets the target
+                    if (!all) break;
+                }
+            }
+            if (done) break;
+            if (!all) continue;
+            uint32_t d = target++;
+            bool excluded = false;
+            for (auto& it : neg) if (it.Next(d) && it.doc == d) { excluded = true; break; }
+            if (excluded || !accept(d)) continue;
+            double norm = k1 * (1 - b + b * seg.Doc(d).tokens / avgdl);
+            double score = 0;
+            uint32_t occurrences = 0;
+            for (size_t i = 0; i < pos.size(); ++i) {
+                double f = pos[i].freq;
+                score += weight[i] * f * (k1 + 1) / (f + norm);
+                occurrences += pos[i].freq;
+            }
+            emit(d, (float)score, occurrences);
+            ++n;
+            if (target == 0) break;               // wrapped past the last doc id
+        }
+        return n;
+    }
+};
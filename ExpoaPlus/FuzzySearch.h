@@ -0,0 +1,570 @@
+// FuzzySearch.h — approximate name matching for the search box and the file index
+// - FuzzyPattern: Myers' bit-parallel edit distance (one 64-bit word per 64 pattern characters,
+//   blocks chained for longer patterns); Search() = best match of the pattern anywhere in a text,
+//   Distance() = plain Levenshtein distance. Case-insensitive (ASCII fast path, towlower otherwise).
+// - NameMatcher: the search box's test for one name (substring or fuzzy, same limits everywhere)
+// - FuzzyIndex: file names (folded) in one arena, directories interned. Candidates come from a
+//   trigram index (q-gram lemma: a match with k edits shares at least m - 2 - 3k of the pattern's
+//   trigrams) or, when that bound is useless for short patterns, from a scan of per-name character
+//   masks; only survivors run the bit-parallel kernel.
+// - Query(): top-k by score (distance, prefix / word-boundary bonuses, shorter names first),
+//   optionally restricted to one directory tree.
+// Build once (Add..., Build()), then Query() is const and may run on several threads.
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <cwctype>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "FileIndex.h"
+#include "WorkPool.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+inline int FuzzyPopcount(uint64_t x) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    return (int)__popcnt64(x);
+#elif defined(__POPCNT__) || defined(__aarch64__)
+    return __builtin_popcountll(x);
+#else
+    // SWAR: without -mpopcnt the builtin is a library call, this is a dozen inlined operations
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (int)((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// Case folding used for matching (UTF-16 on Windows; bytes of UTF-8 names elsewhere: ASCII only)
+template <class Ch>
+inline Ch FuzzyFold(Ch c) {
+    if (c < 0x80) return (c >= 'A' && c <= 'Z') ? (Ch)(c + 32) : c;
+    if constexpr (sizeof(Ch) > 1) return (Ch)std::towlower((wint_t)c);
+    else return c;
+}
+
+template <class Ch>
+class FuzzyPattern {
+public:
+    using View = std::basic_string_view<Ch>;
+
+    FuzzyPattern() = default;
+    explicit FuzzyPattern(View needle) { Assign(needle); }
+
+    void Assign(View needle) {
+        m_folded.resize(needle.size());
+        for (size_t i = 0; i < needle.size(); ++i) m_folded[i] = FuzzyFold(needle[i]);
+        m_blocks = (m_folded.size() + 63) / 64;
+        m_ascii.assign(128 * m_blocks, 0);
+        m_zero.assign(m_blocks, 0);
+        m_otherChars.clear();
+        m_otherMasks.clear();
+        for (size_t i = 0; i < m_folded.size(); ++i) {
+            Ch c = m_folded[i];
+            uint64_t* peq;
+            if ((size_t)(std::make_unsigned_t<Ch>)c < 128) peq = &m_ascii[(size_t)c * m_blocks];
+            else {
+                size_t k = std::find(m_otherChars.begin(), m_otherChars.end(), c) - m_otherChars.begin();
+                if (k == m_otherChars.size()) { m_otherChars.push_back(c); m_otherMasks.resize(m_otherMasks.size() + m_blocks, 0); }
+                peq = &m_otherMasks[k * m_blocks];
+            }
+            peq[i / 64] |= 1ull << (i % 64);
+        }
+        m_last = m_folded.empty() ? 0 : 1ull << ((m_folded.size() - 1) % 64);
+    }
+
+    size_t Length() const { return m_folded.size(); }
+    const std::vector<Ch>& Folded() const { return m_folded; }
+
+    // Fewest edits turning the pattern into some substring of text; end = one past that substring.
+    // Stops early (returning the best so far) once a distance of 0 is found.
+    // Folded = text is already folded with FuzzyFold.
+    template <bool Folded = false>
+    int Search(const Ch* text, size_t n, size_t* end = nullptr) const {
+        return Run<Folded, false>(text, n, end);
+    }
+    // Same, scanning text backwards: start = first character of the best match ending before n
+    template <bool Folded = false>
+    int SearchBackward(const Ch* text, size_t n, size_t* start = nullptr) const {
+        return Run<Folded, true>(text, n, start);
+    }
+
+    // Levenshtein distance between the pattern and the whole text
+    template <bool Folded = false>
+    int Distance(const Ch* text, size_t n) const {
+        if (m_folded.empty()) return (int)n;
+        std::vector<uint64_t> pv(m_blocks, ~0ull), mv(m_blocks, 0);
+        int score = (int)m_folded.size();
+        for (size_t j = 0; j < n; ++j) {
+            const uint64_t* eq = Peq(Folded ? text[j] : FuzzyFold(text[j]));
+            int h = 1;                                              // first row: D[0][j] = j
+            for (size_t b = 0; b < m_blocks; ++b) h = Advance(pv[b], mv[b], eq[b], h, b + 1 == m_blocks ? m_last : 1ull << 63);
+            score += h;
+        }
+        return score;
+    }
+
+private:
+    std::vector<Ch> m_folded;
+    size_t m_blocks = 0;
+    uint64_t m_last = 0;                    // bit of the last pattern row in the last block
+    std::vector<uint64_t> m_ascii;          // 128 x blocks
+    std::vector<Ch> m_otherChars;           // non-ASCII pattern characters
+    std::vector<uint64_t> m_otherMasks;     // their masks, blocks each
+    std::vector<uint64_t> m_zero;
+
+    const uint64_t* Peq(Ch c) const {
+        if ((size_t)(std::make_unsigned_t<Ch>)c < 128) return &m_ascii[(size_t)c * m_blocks];
+        for (size_t k = 0; k < m_otherChars.size(); ++k) if (m_otherChars[k] == c) return &m_otherMasks[k * m_blocks];
+        return m_zero.data();
+    }
+
+    // One column step of one block (Hyyrö's formulation); hin / return = horizontal delta in / out
+    static int Advance(uint64_t& pv, uint64_t& mv, uint64_t eq, int hin, uint64_t high) {
+        uint64_t xv = eq | mv;
+        if (hin < 0) eq |= 1;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        int hout = (ph & high) ? 1 : (mh & high) ? -1 : 0;
+        ph <<= 1;
+        mh <<= 1;
+        if (hin < 0) mh |= 1;
+        else if (hin > 0) ph |= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        return hout;
+    }
+
+    template <bool Folded, bool Backward>
+    int Run(const Ch* text, size_t n, size_t* pos) const {
+        int m = (int)m_folded.size();
+        int best = m;
+        size_t bestPos = Backward ? n : 0;
+        if (m == 0) { if (pos) *pos = bestPos; return 0; }
+        auto at = [&](size_t j) { Ch c = text[Backward ? n - 1 - j : j]; return Folded ? c : FuzzyFold(c); };
+        if (m_blocks == 1) {
+            // hot loop: locals only, branch-free score update
+            const uint64_t* ascii = m_ascii.data();
+            const uint64_t last = m_last;
+            uint64_t pv = ~0ull, mv = 0;
+            int score = m;
+            for (size_t j = 0; j < n && best > 0; ++j) {
+                Ch c = at(j);
+                uint64_t eq = (size_t)(std::make_unsigned_t<Ch>)c < 128 ? ascii[(size_t)c] : Peq(c)[0];
+                uint64_t xv = eq | mv;
+                uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+                uint64_t ph = mv | ~(xh | pv);
+                uint64_t mh = pv & xh;
+                score += (int)((ph & last) != 0) - (int)((mh & last) != 0);
+                ph <<= 1;
+                mh <<= 1;
+                pv = mh | ~(xv | ph);
+                mv = ph & xv;
+                if (score < best) { best = score; bestPos = Backward ? n - 1 - j : j + 1; }
+            }
+        }
+        else {
+            std::vector<uint64_t> pv(m_blocks, ~0ull), mv(m_blocks, 0);
+            int score = m;
+            for (size_t j = 0; j < n && best > 0; ++j) {
+                const uint64_t* eq = Peq(at(j));
+                int h = 0;                                          // first row: D[0][j] = 0
+                for (size_t b = 0; b < m_blocks; ++b) h = Advance(pv[b], mv[b], eq[b], h, b + 1 == m_blocks ? m_last : 1ull << 63);
+                score += h;
+                if (score < best) { best = score; bestPos = Backward ? n - 1 - j : j + 1; }
+            }
+        }
+        if (pos) *pos = bestPos;
+        return best;
+    }
+};
+
+// Levenshtein distance, case-insensitive
+template <class Ch>
+inline int FuzzyLevenshtein(std::basic_string_view<Ch> a, std::basic_string_view<Ch> b) {
+    if (a.size() > b.size()) std::swap(a, b);                      // the shorter one becomes the bit vector
+    return FuzzyPattern<Ch>(a).Distance(b.data(), b.size());
+}
+
+// One search-box needle against single names: substring (optionally case-insensitive) or fuzzy.
+// Fuzzy allows maxDistance edits but at most one per three needle characters. An empty needle
+// matches everything.
+template <class Ch>
+class NameMatcher {
+public:
+    using View = std::basic_string_view<Ch>;
+
+    NameMatcher() = default;
+    NameMatcher(View needle, bool fuzzy, bool matchCase, int maxDistance) { Assign(needle, fuzzy, matchCase, maxDistance); }
+
+    void Assign(View needle, bool fuzzy, bool matchCase, int maxDistance) {
+        m_fuzzy = fuzzy && !needle.empty();
+        m_matchCase = matchCase && !m_fuzzy;
+        m_needle.assign(needle.begin(), needle.end());
+        if (!m_matchCase) for (auto& c : m_needle) c = FuzzyFold(c);
+        if (m_fuzzy) {
+            m_pattern.Assign(needle);
+            m_maxDistance = AllowedDistance(needle.size(), maxDistance);
+        }
+    }
+
+    static int AllowedDistance(size_t needleLength, int maxDistance) { return std::min(maxDistance, (int)(needleLength / 3)); }
+
+    bool Matches(View name, int* distance = nullptr) const {
+        if (distance) *distance = 0;
+        if (m_needle.empty()) return true;
+        if (m_fuzzy) {
+            if (name.size() + m_maxDistance < m_needle.size()) return false;
+            int d = m_pattern.Search(name.data(), name.size());
+            if (distance) *distance = d;
+            return d <= m_maxDistance;
+        }
+        if (m_matchCase) return name.find(View(m_needle)) != View::npos;
+        // folded substring: look for the first character, compare the rest folded
+        size_t m = m_needle.size();
+        if (name.size() < m) return false;
+        Ch first = m_needle[0];
+        for (size_t i = 0, last = name.size() - m; i <= last; ++i) {
+            if (FuzzyFold(name[i]) != first) continue;
+            size_t j = 1;
+            while (j < m && FuzzyFold(name[i + j]) == m_needle[j]) ++j;
+            if (j == m) return true;
+        }
+        return false;
+    }
+
+private:
+    std::basic_string<Ch> m_needle;           // folded unless matchCase
+    FuzzyPattern<Ch> m_pattern;
+    bool m_fuzzy = false, m_matchCase = false;
+    int m_maxDistance = 0;
+};
+
+struct FuzzyHit {
+    uint32_t id = 0;
+    int distance = 0;
+    int score = 0;
+    uint32_t matchStart = 0, matchEnd = 0;  // span of the match in the name
+};
+
+struct FuzzyQueryOptions {
+    int maxDistance = 2;                    // also at most one edit per three query characters
+    size_t topK = 500;
+    IndexString scope;                      // non-empty: only names in this directory or below
+};
+
+struct FuzzyQueryStats {
+    size_t candidates = 0;                  // names that reached the edit-distance kernel
+    size_t matches = 0;
+    int tiers = 0;                          // distances tried (0, 1, ...) before top-k was full
+    bool scanned = false;                   // some tier had to look at every name's masks
+};
+
+class FuzzyIndex {
+public:
+    static constexpr uint32_t kBuckets = 1u << 20;  // trigram hash buckets; collisions only add candidates
+
+    void Clear() { *this = FuzzyIndex(); }
+
+    // Add one path (split into directory + name); returns its id. Call Build() after the last Add.
+    uint32_t Add(IndexStringView path) {
+        size_t cut = path.size();
+        while (cut > 0 && !IsSep(path[cut - 1])) --cut;
+        IndexStringView dir = path.substr(0, cut), name = path.substr(cut);
+        while (dir.size() > 1 && IsSep(dir.back())) dir.remove_suffix(1);  // keep a lone root separator
+        if (m_dirs.empty() || m_dirs[m_lastDir] != dir) {        // paths usually arrive directory by directory
+            auto it = m_dirIds.find(IndexString(dir));
+            if (it != m_dirIds.end()) m_lastDir = it->second;
+            else { m_lastDir = (uint32_t)m_dirs.size(); m_dirs.emplace_back(dir); m_dirIds.emplace(m_dirs.back(), m_lastDir); }
+        }
+        m_dir.push_back(m_lastDir);
+        if (m_nameOff.empty()) m_nameOff.push_back(0);
+        m_names.insert(m_names.end(), name.begin(), name.end());
+        for (IndexChar c : name) m_folded.push_back(FuzzyFold(c));
+        m_nameOff.push_back((uint32_t)m_names.size());
+        return (uint32_t)m_dir.size() - 1;
+    }
+
+    // Character / bigram masks + trigram posting lists (counting sort into one array)
+    void Build() {
+        uint32_t n = (uint32_t)Size();
+        m_mask.assign(n, 0);
+        m_bigrams.assign(2 * (size_t)n, 0);
+        m_postOff.assign(kBuckets + 1, 0);
+        std::vector<uint32_t> keys, keyOff(n + 1, 0);
+        for (uint32_t id = 0; id < n; ++id) {
+            const IndexChar* s = &m_folded[m_nameOff[id]];
+            uint32_t len = m_nameOff[id + 1] - m_nameOff[id];
+            for (uint32_t i = 0; i < len; ++i) m_mask[id] |= CharBit(s[i]);
+            for (uint32_t i = 0; i + 2 <= len; ++i) { uint32_t b = BigramSlot(s + i); m_bigrams[2 * id + (b >> 6)] |= 1ull << (b & 63); }
+            size_t first = keys.size();
+            for (uint32_t i = 0; i + 3 <= len; ++i) keys.push_back(Bucket(s + i));
+            std::sort(keys.begin() + first, keys.end());
+            keys.erase(std::unique(keys.begin() + first, keys.end()), keys.end());
+            for (size_t i = first; i < keys.size(); ++i) m_postOff[keys[i] + 1]++;
+            keyOff[id + 1] = (uint32_t)keys.size();
+        }
+        for (uint32_t b = 0; b < kBuckets; ++b) m_postOff[b + 1] += m_postOff[b];
+        m_post.resize(m_postOff[kBuckets]);
+        std::vector<uint32_t> fill(m_postOff.begin(), m_postOff.end() - 1);
+        for (uint32_t id = 0; id < n; ++id)
+            for (uint32_t i = keyOff[id]; i < keyOff[id + 1]; ++i) m_post[fill[keys[i]]++] = id; // ids ascending per list
+        m_dirIds.clear();
+        m_dirIds.rehash(0);
+    }
+
+    size_t Size() const { return m_dir.size(); }
+    IndexStringView Name(uint32_t id) const { return IndexStringView(m_names.data() + m_nameOff[id], m_nameOff[id + 1] - m_nameOff[id]); }
+    IndexString Path(uint32_t id) const {
+        IndexString p = m_dirs[m_dir[id]];
+        if (!p.empty() && !IsSep(p.back())) p += Sep();
+        p += Name(id);
+        return p;
+    }
+
+    // Best topK names containing query with few edits. Scores are distance-major, so the distances
+    // are tried in tiers (0, 1, ...) and the search stops as soon as a tier fills the top-k.
+    // pool (optional, not shared with other work while the query runs) splits full scans into slices.
+    std::vector<FuzzyHit> Query(IndexStringView query, const FuzzyQueryOptions& opt, FuzzyQueryStats* stats = nullptr,
+                                WorkPool* pool = nullptr) const {
+        Top top(opt.topK);
+        FuzzyQueryStats st;
+        QueryState q(*this, query, opt.scope);
+        int m = q.m;
+        if (m == 0 || Size() == 0 || opt.topK == 0) { if (stats) *stats = st; return {}; }
+        int kMax = std::max(0, std::min(opt.maxDistance, m / 3));
+        std::vector<uint8_t> count;
+        std::vector<uint32_t> cand;
+        for (int k = 0; k <= kMax && !top.Full(); ++k) {
+            st.tiers++;
+            int need = m - 2 - 3 * k;                               // q-gram lemma with q = 3
+            if (need < 1) {
+                st.scanned = true;
+                Scan(q, k, top, st, pool);
+                continue;
+            }
+            // count, per name, how many of the pattern's trigram positions it contains
+            count.assign(Size(), 0);
+            cand.clear();
+            for (size_t i = 0; i < q.buckets.size();) {
+                size_t j = i;
+                while (j < q.buckets.size() && q.buckets[j] == q.buckets[i]) ++j;
+                int weight = (int)(j - i);                          // repeated trigram: credit every position
+                for (uint32_t p = m_postOff[q.buckets[i]]; p < m_postOff[q.buckets[i] + 1]; ++p) {
+                    uint32_t id = m_post[p];
+                    int before = count[id], after = std::min(255, before + weight);
+                    count[id] = (uint8_t)after;
+                    if (before < need && after >= need) cand.push_back(id);
+                }
+                i = j;
+            }
+            std::sort(cand.begin(), cand.end());                   // visit the per-name arrays in order
+            for (uint32_t id : cand) Consider(q, id, k, top, st);
+        }
+        if (stats) *stats = st;
+        return top.Sorted();
+    }
+
+private:
+    std::vector<IndexString> m_dirs;
+    std::unordered_map<IndexString, uint32_t> m_dirIds;    // only while adding
+    uint32_t m_lastDir = 0;
+    std::vector<uint32_t> m_dir;            // per name: directory id
+    std::vector<uint32_t> m_nameOff;        // name i = [m_nameOff[i], m_nameOff[i + 1])
+    std::vector<IndexChar> m_names, m_folded;
+    std::vector<uint64_t> m_mask;           // per name: CharBit of every character
+    std::vector<uint64_t> m_bigrams;        // per name: 128-bit set of BigramSlot over its bigrams
+    std::vector<uint32_t> m_postOff;        // bucket b = m_post[m_postOff[b] .. m_postOff[b + 1])
+    std::vector<uint32_t> m_post;
+
+    static bool Better(const FuzzyHit& a, const FuzzyHit& b) { return a.score != b.score ? a.score > b.score : a.id < b.id; }
+
+    // Bounded heap of the best hits; front() = the worst one kept
+    struct Top {
+        explicit Top(size_t k) : limit(k) {}
+        size_t limit;
+        std::vector<FuzzyHit> hits;
+        bool Full() const { return hits.size() >= limit; }
+        int Floor() const { return Full() ? hits.front().score : INT_MIN; }
+        void Push(const FuzzyHit& h) {
+            if (!Full()) { hits.push_back(h); std::push_heap(hits.begin(), hits.end(), Better); }
+            else if (Better(h, hits.front())) {
+                std::pop_heap(hits.begin(), hits.end(), Better);
+                hits.back() = h;
+                std::push_heap(hits.begin(), hits.end(), Better);
+            }
+        }
+        std::vector<FuzzyHit> Sorted() { std::sort(hits.begin(), hits.end(), Better); return std::move(hits); }
+    };
+
+    // Everything derived from the query once
+    struct QueryState {
+        QueryState(const FuzzyIndex& index, IndexStringView query, IndexStringView scope) : fwd(query) {
+            m = (int)fwd.Length();
+            pat = fwd.Folded().data();
+            std::vector<IndexChar> rev(fwd.Folded().rbegin(), fwd.Folded().rend());
+            bwd.Assign(IndexStringView(rev.data(), rev.size()));
+            for (int i = 0; i < m; ++i) mask |= CharBit(pat[i]);
+            for (int i = 0; i + 2 <= m; ++i) bigrams.push_back(BigramSlot(pat + i));
+            for (uint32_t b : bigrams) {
+                distinctBigrams &= !(bigramMask[b >> 6] >> (b & 63) & 1);
+                bigramMask[b >> 6] |= 1ull << (b & 63);
+            }
+            for (int i = 0; i + 3 <= m; ++i) buckets.push_back(Bucket(pat + i));
+            std::sort(buckets.begin(), buckets.end());
+            while (!scope.empty() && IsSep(scope.back())) scope.remove_suffix(1);
+            if (scope.empty()) return;
+            inScope.resize(index.m_dirs.size());
+            for (size_t d = 0; d < index.m_dirs.size(); ++d) {
+                IndexStringView p = index.m_dirs[d];
+                inScope[d] = p.size() >= scope.size() && p.compare(0, scope.size(), scope) == 0 &&
+                             (p.size() == scope.size() || IsSep(p[scope.size()]));
+            }
+        }
+        FuzzyPattern<IndexChar> fwd, bwd;   // bwd = reversed pattern, finds where a match starts
+        int m = 0;
+        const IndexChar* pat = nullptr;
+        uint64_t mask = 0;
+        std::vector<uint32_t> bigrams, buckets;
+        uint64_t bigramMask[2] = {};
+        bool distinctBigrams = true;        // every bigram position has its own slot: count with popcount
+        std::vector<uint8_t> inScope;       // per directory; empty = no scope
+    };
+
+    // Tier k: report name id if its best match has exactly k edits (fewer were reported by earlier tiers)
+    void Consider(const QueryState& q, uint32_t id, int k, Top& top, FuzzyQueryStats& st, int floor = INT_MIN) const {
+        int m = q.m;
+        uint32_t len = m_nameOff[id + 1] - m_nameOff[id];
+        if ((int)len < m - k) return;
+        floor = std::max(floor, top.Floor());
+        if (ScoreBound(len, k, m, true) < floor) return;
+        // necessary conditions, cheapest first: every missing distinct character and every missing
+        // bigram position needs an edit (q-gram lemma with q = 2: m - 1 - 2k must remain)
+        if (FuzzyPopcount(q.mask & ~m_mask[id]) > k) return;
+        int needBigrams = m - 1 - 2 * k;
+        if (needBigrams > 0) {
+            const uint64_t* bits = &m_bigrams[2 * (size_t)id];
+            int have = 0;
+            if (q.distinctBigrams) have = FuzzyPopcount(bits[0] & q.bigramMask[0]) + FuzzyPopcount(bits[1] & q.bigramMask[1]);
+            else for (uint32_t b : q.bigrams) have += (int)(bits[b >> 6] >> (b & 63) & 1);
+            if (have < needBigrams) return;
+        }
+        if (!q.inScope.empty() && !q.inScope[m_dir[id]]) return;
+        const IndexChar* s = &m_folded[m_nameOff[id]];
+        if (k == 0 && s[0] != q.pat[0] && ScoreBound(len, k, m, false) < floor) return;
+        st.candidates++;
+        size_t start = 0, end = 0;
+        int d = 0;
+        if (k == 0) {                                               // exact tier: a plain substring search
+            size_t at = IndexStringView(s, len).find(IndexStringView(q.pat, m));
+            if (at == IndexStringView::npos) return;
+            start = at;
+            end = at + m;
+        }
+        else {
+            d = q.fwd.Search<true>(s, len, &end);
+            if (d != k) return;
+            q.bwd.SearchBackward<true>(s, end, &start);
+        }
+        st.matches++;
+        FuzzyHit h;
+        h.id = id;
+        h.distance = d;
+        h.matchStart = (uint32_t)start;
+        h.matchEnd = (uint32_t)end;
+        h.score = Score(Name(id), d, h.matchStart, m);
+        top.Push(h);
+    }
+
+    // Tier k over every name; with a pool, slices of kSlice names run in parallel into their own heaps
+    void Scan(const QueryState& q, int k, Top& top, FuzzyQueryStats& st, WorkPool* pool) const {
+        static constexpr uint32_t kSlice = 1u << 16;
+        uint32_t n = (uint32_t)Size();
+        if (!pool || pool->Size() < 2 || n <= kSlice) {
+            for (uint32_t id = 0; id < n; ++id) Consider(q, id, k, top, st);
+            return;
+        }
+        int floor = top.Floor();
+        size_t slices = (n + kSlice - 1) / kSlice;
+        std::vector<Top> tops(slices, Top(top.limit));
+        std::vector<FuzzyQueryStats> stats(slices);
+        for (size_t i = 0; i < slices; ++i) {
+            pool->Submit([&, i]() {
+                uint32_t first = (uint32_t)(i * kSlice), last = std::min(n, first + kSlice);
+                for (uint32_t id = first; id < last; ++id) Consider(q, id, k, tops[i], stats[i], floor);
+            });
+        }
+        pool->WaitIdle();
+        for (size_t i = 0; i < slices; ++i) {
+            for (auto const& h : tops[i].hits) top.Push(h);
+            st.candidates += stats[i].candidates;
+            st.matches += stats[i].matches;
+        }
+    }
+
+    static bool IsSep(IndexChar c) {
+#ifdef _WIN32
+        return c == L'\\' || c == L'/';
+#else
+        return c == '/';
+#endif
+    }
+    static IndexChar Sep() {
+#ifdef _WIN32
+        return L'\\';
+#else
+        return '/';
+#endif
+    }
+
+    // Letters and digits get their own bit, everything else shares the remaining 28
+    static uint64_t CharBit(IndexChar c) {
+        uint32_t u = (uint32_t)c;
+        if (u >= 'a' && u <= 'z') return 1ull << (u - 'a');
+        if (u >= '0' && u <= '9') return 1ull << (26 + u - '0');
+        return 1ull << (36 + u % 28);
+    }
+    static uint32_t BigramSlot(const IndexChar* s) {
+        uint64_t h = (((uint64_t)(uint32_t)s[0] << 21) ^ (uint32_t)s[1]) * 0x9E3779B97F4A7C15ull;
+        return (uint32_t)(h >> 57);                                 // 0..127
+    }
+    static uint32_t Bucket(const IndexChar* s) {
+        uint64_t h = ((uint64_t)(uint32_t)s[0] << 42) ^ ((uint64_t)(uint32_t)s[1] << 21) ^ (uint32_t)s[2];
+        h *= 0x9E3779B97F4A7C15ull;
+        return (uint32_t)(h >> 44);                                 // 20 bits = kBuckets
+    }
+
+    static bool WordStart(IndexStringView name, size_t i) {
+        if (i == 0) return true;
+        IndexChar p = name[i - 1], c = name[i];
+        if (p == ' ' || p == '_' || p == '-' || p == '.' || p == '(' || p == '[') return true;
+        return (p >= 'a' && p <= 'z') && (c >= 'A' && c <= 'Z');  // camelCase
+    }
+
+    // Distance-major: one edit (400) outweighs every bonus and penalty together (at most 250 / 115)
+    static int Score(IndexStringView name, int distance, uint32_t start, int m) {
+        int s = 1000 - 400 * distance;
+        if (start == 0) s += 100;
+        else if (WordStart(name, start)) s += 60;
+        if (distance == 0 && (int)name.size() == m) s += 150;     // the whole name
+        s -= (int)std::min<size_t>(name.size(), 200) / 2;
+        s -= (int)std::min<uint32_t>(start, 60) / 4;
+        return s;
+    }
+    // Highest Score a name of this length can reach at this distance (lets a full top-k skip the kernel)
+    static int ScoreBound(uint32_t len, int distance, int m, bool canBePrefix) {
+        int s = 1000 - 400 * distance + (canBePrefix ? 100 : 60);
+        if (distance == 0 && (int)len == m) s += 150;
+        return s - (int)std::min<uint32_t>(len, 200) / 2;
+    }
+};
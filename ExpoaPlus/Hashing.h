@@ -0,0 +1,977 @@
+// Hashing.h — content hashing for the indexer, duplicate finder and caches
+// - SHA-1 / SHA-256: portable, or SHA-NI when the CPU has it
+// - BLAKE3: tree hash over 1 KiB chunks; 4 (SSE4.1) or 8 (AVX2) chunks are compressed side by side,
+//   large files are split into subtrees that several threads read and hash in parallel
+// - FastHash128 / FastHash64: non-cryptographic (xxHash64-style lanes), only to tell data apart
+// - HashFile(): large aligned positioned reads, sequential-scan hint, cancellable
+// - HashCpu::Get() is detected once; clear its flags to force the portable code paths
+// Digests are byte-for-byte the standard ones (SHA-1, SHA-256, BLAKE3 with 32-byte output).
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HASH_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(HASH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define HASH_TARGET(t) __attribute__((target(t)))
+#else
+#define HASH_TARGET(t)
+#endif
+
+struct HashCpu {
+    bool sse41 = false;
+    bool avx = false;       // AVX usable (CPU + OS)
+    bool avx2 = false;
+    bool shaNi = false;
+
+    static HashCpu& Get() {
+        static HashCpu cpu = Detect();
+        return cpu;
+    }
+
+private:
+    static HashCpu Detect() {
+        HashCpu c;
+#ifdef HASH_X86
+        uint32_t r1[4] = {}, r7[4] = {};
+#ifdef _MSC_VER
+        int a[4];
+        __cpuid(a, 0);
+        int maxLeaf = a[0];
+        __cpuidex(a, 1, 0); memcpy(r1, a, sizeof(r1));
+        if (maxLeaf >= 7) { __cpuidex(a, 7, 0); memcpy(r7, a, sizeof(r7)); }
+#else
+        unsigned maxLeaf = __get_cpuid_max(0, nullptr);
+        __get_cpuid_count(1, 0, &r1[0], &r1[1], &r1[2], &r1[3]);
+        if (maxLeaf >= 7) __get_cpuid_count(7, 0, &r7[0], &r7[1], &r7[2], &r7[3]);
+#endif
+        bool ssse3 = (r1[2] >> 9) & 1;
+        c.sse41 = ssse3 && ((r1[2] >> 19) & 1);
+        bool osAvx = false;
+        if (((r1[2] >> 27) & 1) && ((r1[2] >> 28) & 1)) { // OSXSAVE + AVX: the OS must save the YMM state
+#ifdef _MSC_VER
+            uint64_t xcr0 = _xgetbv(0);
+#else
+            uint32_t lo, hi;
+            __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            uint64_t xcr0 = ((uint64_t)hi << 32) | lo;
+#endif
+            osAvx = (xcr0 & 6) == 6;
+        }
+        c.avx = osAvx;
+        c.avx2 = osAvx && ((r7[1] >> 5) & 1);
+        c.shaNi = c.sse41 && ((r7[1] >> 29) & 1);
+#endif
+        return c;
+    }
+};
+
+enum class HashAlgo { Sha1, Sha256, Blake3, Fast128 };
+
+struct HashDigest {
+    uint8_t bytes[32] = {};
+    uint8_t len = 0;
+
+    std::string Hex() const {
+        static const char digits[] = "0123456789abcdef";
+        std::string s;
+        s.reserve(len * 2);
+        for (uint8_t i = 0; i < len; ++i) { s += digits[bytes[i] >> 4]; s += digits[bytes[i] & 15]; }
+        return s;
+    }
+    bool operator==(const HashDigest& o) const { return len == o.len && memcmp(bytes, o.bytes, len) == 0; }
+    bool operator!=(const HashDigest& o) const { return !(*this == o); }
+    bool operator<(const HashDigest& o) const {
+        if (len != o.len) return len < o.len;
+        return memcmp(bytes, o.bytes, len) < 0;
+    }
+};
+
+#ifdef HASH_X86
+// SHA-NI only has legacy SSE encodings. After AVX code has left the upper YMM halves dirty, every
+// switch between the two encodings costs a state transition on some CPUs; clear them first.
+HASH_TARGET("avx") inline void HashZeroUpper() { _mm256_zeroupper(); }
+#endif
+
+inline uint32_t HashLoadBe32(const uint8_t* p) { return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]; }
+inline void HashStoreBe32(uint8_t* p, uint32_t v) { p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16); p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v; }
+inline uint32_t HashLoadLe32(const uint8_t* p) { return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+inline void HashStoreLe32(uint8_t* p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24); }
+inline uint32_t HashRotl32(uint32_t x, int r) { return (x << r) | (x >> (32 - r)); }
+inline uint32_t HashRotr32(uint32_t x, int r) { return (x >> r) | (x << (32 - r)); }
+
+// 64-byte block buffering + big-endian length padding shared by SHA-1 and SHA-256.
+// Derived provides Compress(const uint8_t* blocks, size_t count).
+template <class Derived>
+class HashMd64 {
+public:
+    void Update(const void* data, size_t len) {
+        auto p = static_cast<const uint8_t*>(data);
+        m_total += len;
+        if (m_bufLen) {
+            size_t n = std::min(len, sizeof(m_buf) - m_bufLen);
+            memcpy(m_buf + m_bufLen, p, n);
+            m_bufLen += n; p += n; len -= n;
+            if (m_bufLen < sizeof(m_buf)) return;
+            static_cast<Derived*>(this)->Compress(m_buf, 1);
+            m_bufLen = 0;
+        }
+        if (len >= 64) {
+            static_cast<Derived*>(this)->Compress(p, len / 64);
+            p += len / 64 * 64;
+            len %= 64;
+        }
+        memcpy(m_buf, p, len);
+        m_bufLen = len;
+    }
+
+protected:
+    void Pad() {
+        uint64_t bits = m_total * 8;
+        uint8_t tail[128] = {};
+        memcpy(tail, m_buf, m_bufLen);
+        tail[m_bufLen] = 0x80;
+        size_t n = m_bufLen < 56 ? 64 : 128;
+        for (int i = 0; i < 8; ++i) tail[n - 1 - i] = (uint8_t)(bits >> (8 * i));
+        static_cast<Derived*>(this)->Compress(tail, n / 64);
+        m_bufLen = 0;
+    }
+
+private:
+    uint8_t m_buf[64];
+    size_t m_bufLen = 0;
+    uint64_t m_total = 0;
+};
+
+// ---------------------------------------------------------------------------------------------
+// SHA-1
+
+class Sha1 : public HashMd64<Sha1> {
+public:
+    HashDigest Final() {
+        Pad();
+        HashDigest d;
+        for (int i = 0; i < 5; ++i) HashStoreBe32(d.bytes + 4 * i, m_state[i]);
+        d.len = 20;
+        return d;
+    }
+
+    void Compress(const uint8_t* p, size_t blocks) {
+#ifdef HASH_X86
+        const HashCpu& cpu = HashCpu::Get();
+        if (cpu.shaNi) {
+            if (cpu.avx) HashZeroUpper();
+            CompressNi(m_state, p, blocks);
+            return;
+        }
+#endif
+        CompressPortable(m_state, p, blocks);
+    }
+
+    static void CompressPortable(uint32_t st[5], const uint8_t* p, size_t blocks) {
+        for (; blocks--; p += 64) {
+            uint32_t w[80];
+            for (int i = 0; i < 16; ++i) w[i] = HashLoadBe32(p + 4 * i);
+            for (int i = 16; i < 80; ++i) w[i] = HashRotl32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+            uint32_t a = st[0], b = st[1], c = st[2], d = st[3], e = st[4];
+            auto step = [&](uint32_t f, uint32_t k, uint32_t wi) {
+                uint32_t t = HashRotl32(a, 5) + f + e + k + wi;
+                e = d; d = c; c = HashRotl32(b, 30); b = a; a = t;
+            };
+            int i = 0;
+            for (; i < 20; ++i) step(d ^ (b & (c ^ d)), 0x5A827999, w[i]);
+            for (; i < 40; ++i) step(b ^ c ^ d, 0x6ED9EBA1, w[i]);
+            for (; i < 60; ++i) step((b & c) | (d & (b | c)), 0x8F1BBCDC, w[i]);
+            for (; i < 80; ++i) step(b ^ c ^ d, 0xCA62C1D6, w[i]);
+            st[0] += a; st[1] += b; st[2] += c; st[3] += d; st[4] += e;
+        }
+    }
+
+#ifdef HASH_X86
+    // Four rounds per group G; W[G] sits in msg[G % 4]. W[G+1..G+3] are finished stepwise
+    // (msg1 -> xor -> msg2) while the rounds of group G run.
+    template <int G>
+    HASH_TARGET("sha,sse4.1") static inline void NiGroup(__m128i& abcd, __m128i& e0, __m128i& eSave, __m128i* msg, const uint8_t* p, __m128i mask) {
+        if constexpr (G < 4) msg[G] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16 * G)), mask);
+        __m128i e = G == 0 ? _mm_add_epi32(e0, msg[0]) : _mm_sha1nexte_epu32(eSave, msg[G % 4]);
+        eSave = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e, G / 5);
+        if constexpr (G + 1 >= 4 && G + 1 < 20) msg[(G + 1) % 4] = _mm_sha1msg2_epu32(msg[(G + 1) % 4], msg[G % 4]);
+        if constexpr (G + 2 >= 4 && G + 2 < 20) msg[(G + 2) % 4] = _mm_xor_si128(msg[(G + 2) % 4], msg[G % 4]);
+        if constexpr (G >= 1 && G + 3 < 20) msg[(G + 3) % 4] = _mm_sha1msg1_epu32(msg[(G + 3) % 4], msg[G % 4]);
+    }
+    template <int... G>
+    HASH_TARGET("sha,sse4.1") static inline void NiGroups(std::integer_sequence<int, G...>, __m128i& abcd, __m128i& e0, __m128i& eSave, __m128i* msg, const uint8_t* p, __m128i mask) {
+        (NiGroup<G>(abcd, e0, eSave, msg, p, mask), ...);
+    }
+
+    HASH_TARGET("sha,sse4.1") static void CompressNi(uint32_t st[5], const uint8_t* p, size_t blocks) {
+        const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+        __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)st), 0x1B);
+        __m128i e0 = _mm_set_epi32((int)st[4], 0, 0, 0);
+        for (; blocks--; p += 64) {
+            __m128i abcdSave = abcd, e0Save = e0, eSave = _mm_setzero_si128(), msg[4];
+            NiGroups(std::make_integer_sequence<int, 20>(), abcd, e0, eSave, msg, p, mask);
+            e0 = _mm_sha1nexte_epu32(eSave, e0Save);
+            abcd = _mm_add_epi32(abcd, abcdSave);
+        }
+        _mm_storeu_si128((__m128i*)st, _mm_shuffle_epi32(abcd, 0x1B));
+        st[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+    }
+#endif
+
+private:
+    uint32_t m_state[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+};
+
+// ---------------------------------------------------------------------------------------------
+// SHA-256
+
+class Sha256 : public HashMd64<Sha256> {
+public:
+    HashDigest Final() {
+        Pad();
+        HashDigest d;
+        for (int i = 0; i < 8; ++i) HashStoreBe32(d.bytes + 4 * i, m_state[i]);
+        d.len = 32;
+        return d;
+    }
+
+    void Compress(const uint8_t* p, size_t blocks) {
+#ifdef HASH_X86
+        const HashCpu& cpu = HashCpu::Get();
+        if (cpu.shaNi) {
+            if (cpu.avx) HashZeroUpper();
+            CompressNi(m_state, p, blocks);
+            return;
+        }
+#endif
+        CompressPortable(m_state, p, blocks);
+    }
+
+    static void CompressPortable(uint32_t st[8], const uint8_t* p, size_t blocks) {
+        for (; blocks--; p += 64) {
+            uint32_t w[64];
+            for (int i = 0; i < 16; ++i) w[i] = HashLoadBe32(p + 4 * i);
+            for (int i = 16; i < 64; ++i) {
+                uint32_t s0 = HashRotr32(w[i - 15], 7) ^ HashRotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = HashRotr32(w[i - 2], 17) ^ HashRotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            uint32_t a = st[0], b = st[1], c = st[2], d = st[3], e = st[4], f = st[5], g = st[6], h = st[7];
+            for (int i = 0; i < 64; ++i) {
+                uint32_t t1 = h + (HashRotr32(e, 6) ^ HashRotr32(e, 11) ^ HashRotr32(e, 25)) + ((e & f) ^ (~e & g)) + K()[i] + w[i];
+                uint32_t t2 = (HashRotr32(a, 2) ^ HashRotr32(a, 13) ^ HashRotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+            }
+            st[0] += a; st[1] += b; st[2] += c; st[3] += d; st[4] += e; st[5] += f; st[6] += g; st[7] += h;
+        }
+    }
+
+#ifdef HASH_X86
+    // Four rounds per group G; W[G] sits in msg[G % 4], W[G+1] is completed and W[G+3] started
+    // while the rounds of group G run.
+    template <int G>
+    HASH_TARGET("sha,sse4.1") static inline void NiGroup(__m128i& s0, __m128i& s1, __m128i* msg, const uint8_t* p, __m128i mask) {
+        if constexpr (G < 4) msg[G] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16 * G)), mask);
+        __m128i m = _mm_add_epi32(msg[G % 4], _mm_loadu_si128((const __m128i*)(K() + 4 * G)));
+        s1 = _mm_sha256rnds2_epu32(s1, s0, m);
+        if constexpr (G >= 3 && G + 1 < 16) {
+            __m128i t = _mm_alignr_epi8(msg[G % 4], msg[(G + 3) % 4], 4);
+            msg[(G + 1) % 4] = _mm_sha256msg2_epu32(_mm_add_epi32(msg[(G + 1) % 4], t), msg[G % 4]);
+        }
+        s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(m, 0x0E));
+        if constexpr (G >= 1 && G + 3 < 16) msg[(G + 3) % 4] = _mm_sha256msg1_epu32(msg[(G + 3) % 4], msg[G % 4]);
+    }
+    template <int... G>
+    HASH_TARGET("sha,sse4.1") static inline void NiGroups(std::integer_sequence<int, G...>, __m128i& s0, __m128i& s1, __m128i* msg, const uint8_t* p, __m128i mask) {
+        (NiGroup<G>(s0, s1, msg, p, mask), ...);
+    }
+
+    HASH_TARGET("sha,sse4.1") static void CompressNi(uint32_t st[8], const uint8_t* p, size_t blocks) {
+        const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+        __m128i t = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)st), 0xB1);       // CDAB
+        __m128i s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(st + 4)), 0x1B); // EFGH
+        __m128i s0 = _mm_alignr_epi8(t, s1, 8);                                          // ABEF
+        s1 = _mm_blend_epi16(s1, t, 0xF0);                                                // CDGH
+        for (; blocks--; p += 64) {
+            __m128i s0Save = s0, s1Save = s1, msg[4];
+            NiGroups(std::make_integer_sequence<int, 16>(), s0, s1, msg, p, mask);
+            s0 = _mm_add_epi32(s0, s0Save);
+            s1 = _mm_add_epi32(s1, s1Save);
+        }
+        t = _mm_shuffle_epi32(s0, 0x1B);                                                 // FEBA
+        s1 = _mm_shuffle_epi32(s1, 0xB1);                                                // DCHG
+        _mm_storeu_si128((__m128i*)st, _mm_blend_epi16(t, s1, 0xF0));                    // DCBA
+        _mm_storeu_si128((__m128i*)(st + 4), _mm_alignr_epi8(s1, t, 8));                 // HGFE
+    }
+#endif
+
+private:
+    static const uint32_t* K() {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2 };
+        return k;
+    }
+
+    uint32_t m_state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+};
+
+// ---------------------------------------------------------------------------------------------
+// BLAKE3 (unkeyed, 32-byte output)
+
+class Blake3 {
+public:
+    static constexpr size_t kChunkLen = 1024;
+    static constexpr size_t kBlockLen = 64;
+
+    Blake3() { memcpy(m_key, IV(), sizeof(m_key)); }
+
+    void Update(const void* data, size_t len) {
+        auto p = static_cast<const uint8_t*>(data);
+        while (len) {
+            if (m_bufLen == 0 && len > kChunkLen) {
+                // whole chunks that are certainly followed by more input go straight to the lanes
+                size_t chunks = (len - 1) / kChunkLen;
+                HashChunks(p, chunks);
+                p += chunks * kChunkLen;
+                len -= chunks * kChunkLen;
+                continue;
+            }
+            if (m_bufLen == sizeof(m_buf)) { HashChunks(m_buf, kBufChunks); m_bufLen = 0; continue; } // more input follows
+            size_t n = std::min(len, sizeof(m_buf) - m_bufLen);
+            memcpy(m_buf + m_bufLen, p, n);
+            m_bufLen += n; p += n; len -= n;
+        }
+    }
+
+    HashDigest Final() const {
+        // the buffer holds the last chunk (and maybe whole chunks before it)
+        uint32_t stack[kMaxDepth][8];
+        size_t depth = m_depth;
+        memcpy(stack, m_stack, sizeof(uint32_t) * 8 * depth);
+        uint64_t counter = m_chunkCounter;
+        size_t last = m_bufLen ? (m_bufLen - 1) / kChunkLen * kChunkLen : 0;
+        for (size_t off = 0; off < last; off += kChunkLen) {
+            uint32_t cv[8];
+            ChunkOutput(m_buf + off, kChunkLen, counter).ChainingValue(cv);
+            PushCv(stack, depth, cv, ++counter);
+        }
+        Output out = ChunkOutput(m_buf + last, m_bufLen - last, counter);
+        while (depth) {
+            uint32_t cv[8];
+            out.ChainingValue(cv);
+            out = ParentOutput(stack[--depth], cv, m_key);
+        }
+        uint32_t words[16];
+        Compress(out.cv, out.block, out.blockLen, 0, out.flags | kRoot, words);
+        HashDigest d;
+        for (int i = 0; i < 8; ++i) HashStoreLe32(d.bytes + 4 * i, words[i]);
+        d.len = 32;
+        return d;
+    }
+
+    // Chaining value of the complete subtree over `chunks` (a power of two) whole chunks starting at
+    // chunk `counter`; used to hash parts of a large input independently.
+    static void SubtreeCv(const uint8_t* data, size_t chunks, uint64_t counter, uint8_t out[32]) {
+        std::vector<uint8_t> a(chunks * 32), b(chunks * 32 / 2 + 32);
+        HashManyChunks(data, chunks, counter, IV(), a.data());
+        for (size_t n = chunks; n > 1; n /= 2) {
+            std::vector<const uint8_t*> in(n / 2);
+            for (size_t i = 0; i < n / 2; ++i) in[i] = a.data() + 64 * i;
+            HashMany(in.data(), n / 2, 1, IV(), 0, false, kParent, 0, 0, b.data());
+            std::swap(a, b);
+        }
+        memcpy(out, a.data(), 32);
+    }
+    // Append a subtree computed by SubtreeCv. Only before any Update(), in order, and the input
+    // must continue after it (the root is always formed in Final()).
+    void PushSubtree(const uint8_t cv[32], size_t chunks) {
+        uint32_t w[8];
+        for (int i = 0; i < 8; ++i) w[i] = HashLoadLe32(cv + 4 * i);
+        m_chunkCounter += chunks;
+        uint64_t total = m_chunkCounter;
+        while (chunks > 1) { total >>= 1; chunks >>= 1; }
+        MergePush(m_stack, m_depth, w, total, m_key);
+    }
+
+private:
+    static constexpr uint8_t kChunkStart = 1, kChunkEnd = 2, kParent = 4, kRoot = 8;
+    static constexpr size_t kBufChunks = 16;
+    static constexpr size_t kMaxDepth = 54;
+
+    struct Output {
+        uint32_t cv[8];
+        uint8_t block[64];
+        uint8_t blockLen;
+        uint64_t counter;
+        uint8_t flags;
+        void ChainingValue(uint32_t out[8]) const {
+            uint32_t words[16];
+            Compress(cv, block, blockLen, counter, flags, words);
+            memcpy(out, words, 32);
+        }
+    };
+
+    uint32_t m_key[8];
+    uint32_t m_stack[kMaxDepth][8];
+    size_t m_depth = 0;
+    uint64_t m_chunkCounter = 0;   // chunks already pushed
+    uint8_t m_buf[kBufChunks * kChunkLen];
+    size_t m_bufLen = 0;
+
+    static const uint32_t* IV() {
+        static const uint32_t iv[8] = { 0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19 };
+        return iv;
+    }
+    static constexpr uint8_t kSchedule[7][16] = {
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+        { 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+        { 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+        { 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+        { 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+        { 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+        { 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 } };
+
+    static void G(uint32_t* v, int a, int b, int c, int d, uint32_t x, uint32_t y) {
+        v[a] += v[b] + x; v[d] = HashRotr32(v[d] ^ v[a], 16);
+        v[c] += v[d];     v[b] = HashRotr32(v[b] ^ v[c], 12);
+        v[a] += v[b] + y; v[d] = HashRotr32(v[d] ^ v[a], 8);
+        v[c] += v[d];     v[b] = HashRotr32(v[b] ^ v[c], 7);
+    }
+
+    // Portable compression; out[0..7] is the new chaining value
+    static void Compress(const uint32_t cv[8], const uint8_t block[64], uint8_t blockLen, uint64_t counter, uint8_t flags, uint32_t out[16]) {
+        uint32_t m[16], v[16];
+        for (int i = 0; i < 16; ++i) m[i] = HashLoadLe32(block + 4 * i);
+        memcpy(v, cv, 32);
+        memcpy(v + 8, IV(), 16);
+        v[12] = (uint32_t)counter; v[13] = (uint32_t)(counter >> 32); v[14] = blockLen; v[15] = flags;
+        for (int r = 0; r < 7; ++r) {
+            const uint8_t* s = kSchedule[r];
+            G(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);   G(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+            G(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);  G(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+            G(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);  G(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+            G(v, 2, 7, 8, 13, m[s[12]], m[s[13]]); G(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+        }
+        for (int i = 0; i < 8; ++i) { out[i] = v[i] ^ v[i + 8]; out[i + 8] = v[i + 8] ^ cv[i]; }
+    }
+
+    // Everything of a chunk but its last block; the last block stays open as Output
+    Output ChunkOutput(const uint8_t* p, size_t len, uint64_t counter) const {
+        Output o;
+        memcpy(o.cv, m_key, 32);
+        size_t blocks = len ? (len - 1) / kBlockLen : 0;
+        for (size_t i = 0; i < blocks; ++i) {
+            uint32_t words[16];
+            Compress(o.cv, p + i * kBlockLen, kBlockLen, counter, i == 0 ? kChunkStart : 0, words);
+            memcpy(o.cv, words, 32);
+        }
+        size_t rest = len - blocks * kBlockLen;
+        memset(o.block, 0, sizeof(o.block));
+        memcpy(o.block, p + blocks * kBlockLen, rest);
+        o.blockLen = (uint8_t)rest;
+        o.counter = counter;
+        o.flags = (blocks == 0 ? kChunkStart : 0) | kChunkEnd;
+        return o;
+    }
+
+    static Output ParentOutput(const uint32_t left[8], const uint32_t right[8], const uint32_t key[8]) {
+        Output o;
+        memcpy(o.cv, key, 32);
+        for (int i = 0; i < 8; ++i) { HashStoreLe32(o.block + 4 * i, left[i]); HashStoreLe32(o.block + 32 + 4 * i, right[i]); }
+        o.blockLen = 64;
+        o.counter = 0;
+        o.flags = kParent;
+        return o;
+    }
+
+    // Push a finished subtree; `total` counts finished subtrees of its size so far. Completed
+    // pairs are merged right away (safe because more input follows).
+    static void MergePush(uint32_t (*stack)[8], size_t& depth, uint32_t cv[8], uint64_t total, const uint32_t key[8]) {
+        while ((total & 1) == 0) {
+            ParentOutput(stack[--depth], cv, key).ChainingValue(cv);
+            total >>= 1;
+        }
+        memcpy(stack[depth++], cv, 32);
+    }
+    void PushCv(uint32_t (*stack)[8], size_t& depth, uint32_t cv[8], uint64_t total) const { MergePush(stack, depth, cv, total, m_key); }
+
+    void HashChunks(const uint8_t* p, size_t chunks) {
+        uint8_t cvs[8 * 32];
+        while (chunks) {
+            size_t n = std::min<size_t>(chunks, 8);
+            HashManyChunks(p, n, m_chunkCounter, m_key, cvs);
+            for (size_t i = 0; i < n; ++i) {
+                uint32_t w[8];
+                for (int k = 0; k < 8; ++k) w[k] = HashLoadLe32(cvs + 32 * i + 4 * k);
+                MergePush(m_stack, m_depth, w, ++m_chunkCounter, m_key);
+            }
+            p += n * kChunkLen;
+            chunks -= n;
+        }
+    }
+
+    static void HashManyChunks(const uint8_t* p, size_t chunks, uint64_t counter, const uint32_t key[8], uint8_t* out) {
+        const uint8_t* in[64];
+        while (chunks) {
+            size_t n = std::min<size_t>(chunks, 64);
+            for (size_t i = 0; i < n; ++i) in[i] = p + i * kChunkLen;
+            HashMany(in, n, kChunkLen / kBlockLen, key, counter, true, 0, kChunkStart, kChunkEnd, out);
+            p += n * kChunkLen; out += n * 32; counter += n; chunks -= n;
+        }
+    }
+
+    // Same-length inputs of `blocks` whole blocks each -> 32-byte chaining values, several at once
+    static void HashMany(const uint8_t* const* in, size_t n, size_t blocks, const uint32_t key[8], uint64_t counter, bool increment,
+                         uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t* out) {
+#ifdef HASH_X86
+        const HashCpu& cpu = HashCpu::Get();
+        if (cpu.avx2) {
+            for (; n >= 8; n -= 8, in += 8, out += 256, counter += increment ? 8 : 0)
+                Hash8Avx2(in, blocks, key, counter, increment, flags, flagsStart, flagsEnd, out);
+        }
+        if (cpu.sse41) {
+            for (; n >= 4; n -= 4, in += 4, out += 128, counter += increment ? 4 : 0)
+                Hash4Sse41(in, blocks, key, counter, increment, flags, flagsStart, flagsEnd, out);
+        }
+#endif
+        for (; n; --n, ++in, out += 32, counter += increment ? 1 : 0) {
+            uint32_t cv[8];
+            memcpy(cv, key, 32);
+            for (size_t b = 0; b < blocks; ++b) {
+                uint8_t f = flags | (b == 0 ? flagsStart : 0) | (b + 1 == blocks ? flagsEnd : 0);
+                uint32_t words[16];
+                Compress(cv, *in + b * kBlockLen, kBlockLen, counter, f, words);
+                memcpy(cv, words, 32);
+            }
+            for (int i = 0; i < 8; ++i) HashStoreLe32(out + 4 * i, cv[i]);
+        }
+    }
+
+#ifdef HASH_X86
+    // One lane per input: v[i] holds state word i of every input
+    HASH_TARGET("sse4.1") static inline __m128i Rot16x4(__m128i x) { return _mm_shuffle_epi8(x, _mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2)); }
+    HASH_TARGET("sse4.1") static inline __m128i Rot8x4(__m128i x) { return _mm_shuffle_epi8(x, _mm_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1)); }
+    HASH_TARGET("sse4.1") static inline __m128i Rot12x4(__m128i x) { return _mm_or_si128(_mm_srli_epi32(x, 12), _mm_slli_epi32(x, 20)); }
+    HASH_TARGET("sse4.1") static inline __m128i Rot7x4(__m128i x) { return _mm_or_si128(_mm_srli_epi32(x, 7), _mm_slli_epi32(x, 25)); }
+    HASH_TARGET("sse4.1") static inline void Gx4(__m128i* v, int a, int b, int c, int d, __m128i x, __m128i y) {
+        v[a] = _mm_add_epi32(_mm_add_epi32(v[a], v[b]), x); v[d] = Rot16x4(_mm_xor_si128(v[d], v[a]));
+        v[c] = _mm_add_epi32(v[c], v[d]);                   v[b] = Rot12x4(_mm_xor_si128(v[b], v[c]));
+        v[a] = _mm_add_epi32(_mm_add_epi32(v[a], v[b]), y); v[d] = Rot8x4(_mm_xor_si128(v[d], v[a]));
+        v[c] = _mm_add_epi32(v[c], v[d]);                   v[b] = Rot7x4(_mm_xor_si128(v[b], v[c]));
+    }
+    HASH_TARGET("sse4.1") static inline void Transpose4(__m128i* r) {
+        __m128i ab01 = _mm_unpacklo_epi32(r[0], r[1]), ab23 = _mm_unpackhi_epi32(r[0], r[1]);
+        __m128i cd01 = _mm_unpacklo_epi32(r[2], r[3]), cd23 = _mm_unpackhi_epi32(r[2], r[3]);
+        r[0] = _mm_unpacklo_epi64(ab01, cd01); r[1] = _mm_unpackhi_epi64(ab01, cd01);
+        r[2] = _mm_unpacklo_epi64(ab23, cd23); r[3] = _mm_unpackhi_epi64(ab23, cd23);
+    }
+    HASH_TARGET("sse4.1") static void Hash4Sse41(const uint8_t* const* in, size_t blocks, const uint32_t key[8], uint64_t counter, bool increment,
+                                                 uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t* out) {
+        __m128i h[8];
+        for (int i = 0; i < 8; ++i) h[i] = _mm_set1_epi32((int)key[i]);
+        uint32_t lo[4], hi[4];
+        for (int j = 0; j < 4; ++j) { uint64_t c = counter + (increment ? j : 0); lo[j] = (uint32_t)c; hi[j] = (uint32_t)(c >> 32); }
+        const __m128i ctrLo = _mm_loadu_si128((const __m128i*)lo), ctrHi = _mm_loadu_si128((const __m128i*)hi);
+        for (size_t b = 0; b < blocks; ++b) {
+            __m128i m[16];
+            for (int q = 0; q < 4; ++q) {
+                for (int j = 0; j < 4; ++j) m[4 * q + j] = _mm_loadu_si128((const __m128i*)(in[j] + b * kBlockLen + 16 * q));
+                Transpose4(m + 4 * q);
+            }
+            uint8_t f = flags | (b == 0 ? flagsStart : 0) | (b + 1 == blocks ? flagsEnd : 0);
+            __m128i v[16];
+            for (int i = 0; i < 8; ++i) v[i] = h[i];
+            for (int i = 0; i < 4; ++i) v[8 + i] = _mm_set1_epi32((int)IV()[i]);
+            v[12] = ctrLo; v[13] = ctrHi; v[14] = _mm_set1_epi32((int)kBlockLen); v[15] = _mm_set1_epi32(f);
+            for (int r = 0; r < 7; ++r) {
+                const uint8_t* s = kSchedule[r];
+                Gx4(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);   Gx4(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+                Gx4(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);  Gx4(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+                Gx4(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);  Gx4(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+                Gx4(v, 2, 7, 8, 13, m[s[12]], m[s[13]]); Gx4(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+            }
+            for (int i = 0; i < 8; ++i) h[i] = _mm_xor_si128(v[i], v[i + 8]);
+        }
+        Transpose4(h);
+        Transpose4(h + 4);
+        for (int j = 0; j < 4; ++j) {
+            _mm_storeu_si128((__m128i*)(out + 32 * j), h[j]);
+            _mm_storeu_si128((__m128i*)(out + 32 * j + 16), h[4 + j]);
+        }
+    }
+
+    HASH_TARGET("avx2") static inline __m256i Rot16x8(__m256i x) {
+        return _mm256_shuffle_epi8(x, _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2, 13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+    }
+    HASH_TARGET("avx2") static inline __m256i Rot8x8(__m256i x) {
+        return _mm256_shuffle_epi8(x, _mm256_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1, 12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1));
+    }
+    HASH_TARGET("avx2") static inline __m256i Rot12x8(__m256i x) { return _mm256_or_si256(_mm256_srli_epi32(x, 12), _mm256_slli_epi32(x, 20)); }
+    HASH_TARGET("avx2") static inline __m256i Rot7x8(__m256i x) { return _mm256_or_si256(_mm256_srli_epi32(x, 7), _mm256_slli_epi32(x, 25)); }
+    HASH_TARGET("avx2") static inline void Gx8(__m256i* v, int a, int b, int c, int d, __m256i x, __m256i y) {
+        v[a] = _mm256_add_epi32(_mm256_add_epi32(v[a], v[b]), x); v[d] = Rot16x8(_mm256_xor_si256(v[d], v[a]));
+        v[c] = _mm256_add_epi32(v[c], v[d]);                      v[b] = Rot12x8(_mm256_xor_si256(v[b], v[c]));
+        v[a] = _mm256_add_epi32(_mm256_add_epi32(v[a], v[b]), y); v[d] = Rot8x8(_mm256_xor_si256(v[d], v[a]));
+        v[c] = _mm256_add_epi32(v[c], v[d]);                      v[b] = Rot7x8(_mm256_xor_si256(v[b], v[c]));
+    }
+    HASH_TARGET("avx2") static inline void Transpose8(__m256i* r) {
+        __m256i ab0145 = _mm256_unpacklo_epi32(r[0], r[1]), ab2367 = _mm256_unpackhi_epi32(r[0], r[1]);
+        __m256i cd0145 = _mm256_unpacklo_epi32(r[2], r[3]), cd2367 = _mm256_unpackhi_epi32(r[2], r[3]);
+        __m256i ef0145 = _mm256_unpacklo_epi32(r[4], r[5]), ef2367 = _mm256_unpackhi_epi32(r[4], r[5]);
+        __m256i gh0145 = _mm256_unpacklo_epi32(r[6], r[7]), gh2367 = _mm256_unpackhi_epi32(r[6], r[7]);
+        __m256i abcd04 = _mm256_unpacklo_epi64(ab0145, cd0145), abcd15 = _mm256_unpackhi_epi64(ab0145, cd0145);
+        __m256i abcd26 = _mm256_unpacklo_epi64(ab2367, cd2367), abcd37 = _mm256_unpackhi_epi64(ab2367, cd2367);
+        __m256i efgh04 = _mm256_unpacklo_epi64(ef0145, gh0145), efgh15 = _mm256_unpackhi_epi64(ef0145, gh0145);
+        __m256i efgh26 = _mm256_unpacklo_epi64(ef2367, gh2367), efgh37 = _mm256_unpackhi_epi64(ef2367, gh2367);
+        r[0] = _mm256_permute2x128_si256(abcd04, efgh04, 0x20); r[4] = _mm256_permute2x128_si256(abcd04, efgh04, 0x31);
+        r[1] = _mm256_permute2x128_si256(abcd15, efgh15, 0x20); r[5] = _mm256_permute2x128_si256(abcd15, efgh15, 0x31);
+        r[2] = _mm256_permute2x128_si256(abcd26, efgh26, 0x20); r[6] = _mm256_permute2x128_si256(abcd26, efgh26, 0x31);
+        r[3] = _mm256_permute2x128_si256(abcd37, efgh37, 0x20); r[7] = _mm256_permute2x128_si256(abcd37, efgh37, 0x31);
+    }
+    HASH_TARGET("avx2") static void Hash8Avx2(const uint8_t* const* in, size_t blocks, const uint32_t key[8], uint64_t counter, bool increment,
+                                              uint8_t flags, uint8_t flagsStart, uint8_t flagsEnd, uint8_t* out) {
+        __m256i h[8];
+        for (int i = 0; i < 8; ++i) h[i] = _mm256_set1_epi32((int)key[i]);
+        uint32_t lo[8], hi[8];
+        for (int j = 0; j < 8; ++j) { uint64_t c = counter + (increment ? j : 0); lo[j] = (uint32_t)c; hi[j] = (uint32_t)(c >> 32); }
+        const __m256i ctrLo = _mm256_loadu_si256((const __m256i*)lo), ctrHi = _mm256_loadu_si256((const __m256i*)hi);
+        for (size_t b = 0; b < blocks; ++b) {
+            __m256i m[16];
+            for (int half = 0; half < 2; ++half) {
+                for (int j = 0; j < 8; ++j) m[8 * half + j] = _mm256_loadu_si256((const __m256i*)(in[j] + b * kBlockLen + 32 * half));
+                Transpose8(m + 8 * half);
+            }
+            uint8_t f = flags | (b == 0 ? flagsStart : 0) | (b + 1 == blocks ? flagsEnd : 0);
+            __m256i v[16];
+            for (int i = 0; i < 8; ++i) v[i] = h[i];
+            for (int i = 0; i < 4; ++i) v[8 + i] = _mm256_set1_epi32((int)IV()[i]);
+            v[12] = ctrLo; v[13] = ctrHi; v[14] = _mm256_set1_epi32((int)kBlockLen); v[15] = _mm256_set1_epi32(f);
+            for (int r = 0; r < 7; ++r) {
+                const uint8_t* s = kSchedule[r];
+                Gx8(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);   Gx8(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+                Gx8(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);  Gx8(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+                Gx8(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);  Gx8(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+                Gx8(v, 2, 7, 8, 13, m[s[12]], m[s[13]]); Gx8(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+            }
+            for (int i = 0; i < 8; ++i) h[i] = _mm256_xor_si256(v[i], v[i + 8]);
+        }
+        Transpose8(h);
+        for (int j = 0; j < 8; ++j) _mm256_storeu_si256((__m256i*)(out + 32 * j), h[j]);
+    }
+#endif
+};
+
+// ---------------------------------------------------------------------------------------------
+// Fast non-cryptographic hashes: four 64-bit lanes over 32-byte stripes (xxHash64 rounds), two
+// differently mixed outputs. Stable across runs and platforms (little-endian), not for integrity.
+
+class FastHash128 {
+public:
+    explicit FastHash128(uint64_t seed = 0) {
+        m_v[0] = seed + P1 + P2; m_v[1] = seed + P2; m_v[2] = seed; m_v[3] = seed - P1;
+    }
+    void Update(const void* data, size_t len) {
+        auto p = static_cast<const uint8_t*>(data);
+        m_total += len;
+        if (m_bufLen) {
+            size_t n = std::min(len, sizeof(m_buf) - m_bufLen);
+            memcpy(m_buf + m_bufLen, p, n);
+            m_bufLen += n; p += n; len -= n;
+            if (m_bufLen < sizeof(m_buf)) return;
+            Stripe(m_buf);
+            m_bufLen = 0;
+        }
+        for (; len >= 32; p += 32, len -= 32) Stripe(p);
+        memcpy(m_buf, p, len);
+        m_bufLen = len;
+    }
+    HashDigest Final() const {
+        uint64_t h = m_total >= 32 ? Rotl(m_v[0], 1) + Rotl(m_v[1], 7) + Rotl(m_v[2], 12) + Rotl(m_v[3], 18) : m_v[2] + P5;
+        if (m_total >= 32) for (int i = 0; i < 4; ++i) h = (h ^ Round(0, m_v[i])) * P1 + P4;
+        h += m_total;
+        uint64_t g = h ^ P3;
+        size_t i = 0;
+        for (; i + 8 <= m_bufLen; i += 8) {
+            uint64_t w;
+            memcpy(&w, m_buf + i, 8);
+            h = Rotl(h ^ Round(0, w), 27) * P1 + P4;
+            g = Rotl(g + w * P3, 31) * P2;
+        }
+        for (; i < m_bufLen; ++i) {
+            h = Rotl(h ^ (m_buf[i] * P5), 11) * P1;
+            g = Rotl(g + m_buf[i] * P3, 17) * P2;
+        }
+        uint64_t lo = Avalanche(h), hi = Avalanche(g ^ lo ^ Rotl(m_v[1] * P3, 29));
+        HashDigest d;
+        memcpy(d.bytes, &lo, 8);
+        memcpy(d.bytes + 8, &hi, 8);
+        d.len = 16;
+        return d;
+    }
+
+private:
+    static constexpr uint64_t P1 = 11400714785074694791ULL, P2 = 14029467366897019727ULL, P3 = 1609587929392839161ULL,
+                              P4 = 9650029242287828579ULL, P5 = 2870177450012600261ULL;
+    uint64_t m_v[4];
+    uint64_t m_total = 0;
+    uint8_t m_buf[32];
+    size_t m_bufLen = 0;
+
+    static uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    static uint64_t Round(uint64_t acc, uint64_t in) { return Rotl(acc + in * P2, 31) * P1; }
+    static uint64_t Avalanche(uint64_t h) {
+        h ^= h >> 33; h *= P2; h ^= h >> 29; h *= P3; h ^= h >> 32;
+        return h;
+    }
+    void Stripe(const uint8_t* p) {
+        for (int i = 0; i < 4; ++i) {
+            uint64_t w;
+            memcpy(&w, p + i * 8, 8);
+            m_v[i] = Round(m_v[i], w);
+        }
+    }
+};
+
+inline uint64_t FastHash64(const void* data, size_t len, uint64_t seed = 0) {
+    FastHash128 h(seed);
+    h.Update(data, len);
+    HashDigest d = h.Final();
+    uint64_t v;
+    memcpy(&v, d.bytes, 8);
+    return v;
+}
+
+// ---------------------------------------------------------------------------------------------
+// One interface over the algorithms
+
+class Hasher {
+public:
+    explicit Hasher(HashAlgo algo) : m_algo(algo) {}
+    void Update(const void* data, size_t len) {
+        switch (m_algo) {
+        case HashAlgo::Sha1: m_sha1.Update(data, len); break;
+        case HashAlgo::Sha256: m_sha256.Update(data, len); break;
+        case HashAlgo::Blake3: m_blake3.Update(data, len); break;
+        case HashAlgo::Fast128: m_fast.Update(data, len); break;
+        }
+    }
+    HashDigest Final() {
+        switch (m_algo) {
+        case HashAlgo::Sha1: return m_sha1.Final();
+        case HashAlgo::Sha256: return m_sha256.Final();
+        case HashAlgo::Blake3: return m_blake3.Final();
+        default: return m_fast.Final();
+        }
+    }
+    Blake3& Blake() { return m_blake3; }
+
+private:
+    HashAlgo m_algo;
+    Sha1 m_sha1;
+    Sha256 m_sha256;
+    Blake3 m_blake3;
+    FastHash128 m_fast;
+};
+
+inline HashDigest HashBytes(HashAlgo algo, const void* data, size_t len) {
+    Hasher h(algo);
+    h.Update(data, len);
+    return h.Final();
+}
+
+// ---------------------------------------------------------------------------------------------
+// File input
+
+// Read-only file handle with positioned reads (sequential-scan hint where the OS has one)
+class HashReader {
+public:
+    HashReader() = default;
+    HashReader(const HashReader&) = delete;
+    HashReader& operator=(const HashReader&) = delete;
+    ~HashReader() { Close(); }
+
+    bool Open(const std::filesystem::path& path) {
+        Close();
+#ifdef _WIN32
+        m_h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                          OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        return m_h != INVALID_HANDLE_VALUE;
+#else
+        m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#ifdef POSIX_FADV_SEQUENTIAL
+        if (m_fd >= 0) posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        return m_fd >= 0;
+#endif
+    }
+    void Close() {
+#ifdef _WIN32
+        if (m_h != INVALID_HANDLE_VALUE) CloseHandle(m_h);
+        m_h = INVALID_HANDLE_VALUE;
+#else
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+    }
+    // -1 if unknown
+    int64_t Size() const {
+#ifdef _WIN32
+        LARGE_INTEGER sz;
+        return GetFileSizeEx(m_h, &sz) ? (int64_t)sz.QuadPart : -1;
+#else
+        struct stat st {};
+        return fstat(m_fd, &st) == 0 ? (int64_t)st.st_size : -1;
+#endif
+    }
+    // bytes read (short only at end of file), -1 on error
+    int64_t ReadAt(uint64_t offset, void* buf, size_t len) {
+        size_t done = 0;
+        while (done < len) {
+#ifdef _WIN32
+            OVERLAPPED ov = {};
+            ov.Offset = (DWORD)(offset + done);
+            ov.OffsetHigh = (DWORD)((offset + done) >> 32);
+            DWORD got = 0;
+            DWORD want = (DWORD)std::min<size_t>(len - done, 1u << 30);
+            if (!ReadFile(m_h, (uint8_t*)buf + done, want, &got, &ov)) return GetLastError() == ERROR_HANDLE_EOF ? (int64_t)done : -1;
+#else
+            ssize_t got = ::pread(m_fd, (uint8_t*)buf + done, len - done, (off_t)(offset + done));
+            if (got < 0) { if (errno == EINTR) continue; return -1; }
+#endif
+            if (got == 0) break;
+            done += (size_t)got;
+        }
+        return (int64_t)done;
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE m_h = INVALID_HANDLE_VALUE;
+#else
+    int m_fd = -1;
+#endif
+};
+
+// Page-aligned read buffer
+class HashBuffer {
+public:
+    explicit HashBuffer(size_t size) : m_size(size), m_data(static_cast<uint8_t*>(::operator new(size, std::align_val_t(kAlign)))) {}
+    HashBuffer(const HashBuffer&) = delete;
+    HashBuffer& operator=(const HashBuffer&) = delete;
+    ~HashBuffer() { ::operator delete(m_data, std::align_val_t(kAlign)); }
+    uint8_t* Data() { return m_data; }
+    size_t Size() const { return m_size; }
+private:
+    static constexpr size_t kAlign = 4096;
+    size_t m_size;
+    uint8_t* m_data;
+};
+
+struct HashFileOptions {
+    size_t readSize = 1 << 20;          // bytes per read
+    unsigned threads = 0;               // BLAKE3 on large files; 0 = hardware threads
+    uint64_t parallelMin = 64ull << 20; // smaller files are hashed by the calling thread alone
+};
+
+// BLAKE3 over a large file: aligned subtrees of kSegment bytes are read and hashed by several
+// threads, the segment holding the last chunk goes through the normal update path.
+inline bool HashFileBlake3Parallel(const std::filesystem::path& path, uint64_t size, unsigned threads, const std::atomic<bool>* cancel,
+                                   HashDigest& out, uint64_t* bytesRead) {
+    constexpr size_t kSegment = 2 << 20;
+    constexpr size_t kSegChunks = kSegment / Blake3::kChunkLen;
+    uint64_t lastChunk = (size - 1) / Blake3::kChunkLen;
+    size_t fullSegments = (size_t)(lastChunk / kSegChunks);
+    std::vector<uint8_t> cvs(fullSegments * 32);
+    std::atomic<size_t> next{ 0 };
+    std::atomic<bool> failed{ false };
+    std::atomic<uint64_t> read{ 0 };
+    auto worker = [&]() {
+        HashReader r;
+        if (!r.Open(path)) { failed = true; return; }
+        HashBuffer buf(kSegment);
+        for (size_t s; !failed.load() && (s = next.fetch_add(1)) < fullSegments;) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) { failed = true; return; }
+            if (r.ReadAt((uint64_t)s * kSegment, buf.Data(), kSegment) != (int64_t)kSegment) { failed = true; return; }
+            Blake3::SubtreeCv(buf.Data(), kSegChunks, (uint64_t)s * kSegChunks, cvs.data() + 32 * s);
+            read.fetch_add(kSegment, std::memory_order_relaxed);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    if (failed.load()) return false;
+
+    Blake3 h;
+    for (size_t s = 0; s < fullSegments; ++s) h.PushSubtree(cvs.data() + 32 * s, kSegChunks);
+    uint64_t off = (uint64_t)fullSegments * kSegment;
+    HashReader r;
+    if (!r.Open(path)) return false;
+    HashBuffer buf(kSegment);
+    int64_t n = r.ReadAt(off, buf.Data(), (size_t)(size - off));
+    if (n != (int64_t)(size - off)) return false;
+    h.Update(buf.Data(), (size_t)n);
+    if (bytesRead) *bytesRead += read.load() + (uint64_t)n;
+    out = h.Final();
+    return true;
+}
+
+// Hash a file's content. false if it could not be read (or cancel was set).
+inline bool HashFile(const std::filesystem::path& path, HashAlgo algo, HashDigest& out, const std::atomic<bool>* cancel = nullptr,
+                     const HashFileOptions& opt = HashFileOptions(), uint64_t* bytesRead = nullptr) {
+    HashReader r;
+    if (!r.Open(path)) return false;
+    int64_t size = r.Size();
+    unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    if (algo == HashAlgo::Blake3 && threads > 1 && size > 0 && (uint64_t)size >= opt.parallelMin) {
+        r.Close();
+        return HashFileBlake3Parallel(path, (uint64_t)size, threads, cancel, out, bytesRead);
+    }
+    HashBuffer buf(opt.readSize);
+    Hasher h(algo);
+    for (uint64_t off = 0;;) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+        int64_t n = r.ReadAt(off, buf.Data(), buf.Size());
+        if (n < 0) return false;
+        h.Update(buf.Data(), (size_t)n);
+        off += (uint64_t)n;
+        if (bytesRead) *bytesRead += (uint64_t)n;
+        if ((size_t)n < buf.Size()) break;
+    }
+    out = h.Final();
+    return true;
+}
@@ -0,0 +1,277 @@
+// IndexPipeline.h — staged, parallel indexer feeding FileIndex
+//   walk (WorkPool, one task per directory; size/mtime come with the enumeration, DirEnum.h)
+//   -> bounded queue -> hash workers (I/O bound: a few per disk, optional byte-rate throttle)
+//   -> bounded queue -> tag workers (CPU bound) -> batches to onBatch
+// - Bounded queues give backpressure: a fast walk cannot buffer the whole tree in memory
+// - Progress counters are atomics; onProgress is called from one reporter thread at a fixed
+//   interval (coalesced), not per file
+// - Cancel() (any thread) stops all stages; batches already delivered stay valid
+// - stages.filter lets the caller skip unchanged files before any content is read
+// Run() blocks; call it on a background thread.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DirEnum.h"
+#include "FileIndex.h"
+#include "WorkPool.h"
+
+// Multi-producer / multi-consumer queue with a capacity; Close() lets consumers drain and finish.
+template <class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity ? capacity : 1) {}
+
+    // false if the queue was closed (item dropped)
+    bool Push(T&& item) {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_notFull.wait(lk, [this]() { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) return false;
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+        return true;
+    }
+    // nullopt once closed and drained
+    std::optional<T> Pop() {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_notEmpty.wait(lk, [this]() { return m_closed || !m_items.empty(); });
+        if (m_items.empty()) return std::nullopt;
+        T item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return item;
+    }
+    void Close() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+    // Close and drop whatever is still queued
+    void Abort() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_closed = true;
+        m_items.clear();
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty, m_notFull;
+    std::deque<T> m_items;
+    size_t m_capacity;
+    bool m_closed = false;
+};
+
+// Token bucket over bytes; Acquire sleeps just long enough to stay under the rate (0 = unlimited).
+class ByteThrottle {
+public:
+    explicit ByteThrottle(uint64_t bytesPerSec) : m_rate(bytesPerSec) {}
+    void Acquire(uint64_t bytes, const std::atomic<bool>& cancel) {
+        if (m_rate == 0) return;
+        std::chrono::steady_clock::time_point due;
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            auto now = std::chrono::steady_clock::now();
+            if (m_next < now - std::chrono::seconds(1)) m_next = now - std::chrono::seconds(1); // at most 1 s burst
+            m_next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>((double)bytes / (double)m_rate));
+            due = m_next;
+        }
+        while (!cancel.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() < due)
+            std::this_thread::sleep_until(std::min(due, std::chrono::steady_clock::now() + std::chrono::milliseconds(50)));
+    }
+private:
+    uint64_t m_rate;
+    std::mutex m_mutex;
+    std::chrono::steady_clock::time_point m_next{};
+};
+
+struct IndexPipelineOptions {
+    unsigned walkThreads = 0;                 // 0 = hardware threads
+    unsigned hashThreads = 2;                 // per disk being indexed; reads are the bottleneck
+    unsigned tagThreads = 0;                  // 0 = hardware threads
+    size_t queueDepth = 4096;                 // entries buffered between two stages
+    size_t batchSize = 256;                   // entries per onBatch call
+    uint64_t maxReadBytesPerSec = 0;          // hash stage throttle, 0 = unlimited
+    bool includeHidden = true;
+    std::chrono::milliseconds progressInterval{ 250 };
+};
+
+struct IndexProgress {
+    uint64_t discovered = 0;                  // files found by the walk so far
+    uint64_t skipped = 0;                     // rejected by stages.filter (unchanged)
+    uint64_t hashed = 0;
+    uint64_t done = 0;                        // delivered through onBatch
+    uint64_t bytesHashed = 0;
+    uint64_t dirErrors = 0;                   // directories that could not be opened
+    bool walkDone = false;
+};
+
+struct IndexPipelineStages {
+    std::function<bool(const FileIndexEntry&)> filter;          // false = skip (size/mtime already known)
+    std::function<void(FileIndexEntry&)> hash;                  // fills hash / hashLen
+    std::function<void(FileIndexEntry&)> tags;                  // fills tags
+    std::function<void(std::vector<FileIndexEntry>&&)> onBatch; // concurrent calls from tag workers
+    std::function<void(const std::filesystem::path& dir)> onDirectory; // every directory the walk entered
+    std::function<void(const std::filesystem::path& dir)> onDirectoryError; // could not be read (its files are unknown, not gone)
+    std::function<void(const IndexProgress&)> onProgress;
+};
+
+class IndexPipeline {
+public:
+    void Cancel() { m_cancel.store(true); }
+    bool Cancelled() const { return m_cancel.load(); }
+
+    // Index every file below roots. Returns false if cancelled.
+    bool Run(const std::vector<std::filesystem::path>& roots, const IndexPipelineOptions& opt, const IndexPipelineStages& stages) {
+        m_cancel.store(false);
+        Counters c;
+        // stages hand over chunks of entries: one queue operation per kChunk files, not per file
+        using Chunk = std::vector<FileIndexEntry>;
+        size_t depth = std::max<size_t>(2, opt.queueDepth / kChunk);
+        BoundedQueue<Chunk> toHash(depth), toTag(depth);
+        ByteThrottle throttle(opt.maxReadBytesPerSec);
+        unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+
+        // progress reporter
+        std::mutex progressMutex;
+        std::condition_variable progressCv;
+        bool finished = false;
+        std::thread reporter([&]() {
+            std::unique_lock<std::mutex> lk(progressMutex);
+            while (!finished) {
+                progressCv.wait_for(lk, opt.progressInterval);
+                if (stages.onProgress) stages.onProgress(c.Snapshot());
+            }
+        });
+
+        // tag stage
+        std::vector<std::thread> tagWorkers;
+        for (unsigned i = 0; i < (opt.tagThreads ? opt.tagThreads : hw); ++i) {
+            tagWorkers.emplace_back([&]() {
+                Chunk batch;
+                while (auto chunk = toTag.Pop()) {
+                    if (m_cancel.load()) continue; // keep draining so producers never block
+                    for (auto& e : *chunk) {
+                        if (stages.tags) stages.tags(e);
+                        batch.push_back(std::move(e));
+                        if (batch.size() >= opt.batchSize) Deliver(stages, batch, c);
+                    }
+                }
+                if (!m_cancel.load()) Deliver(stages, batch, c);
+            });
+        }
+
+        // hash stage
+        std::vector<std::thread> hashWorkers;
+        for (unsigned i = 0; i < std::max(1u, opt.hashThreads); ++i) {
+            hashWorkers.emplace_back([&]() {
+                while (auto chunk = toHash.Pop()) {
+                    if (m_cancel.load()) continue;
+                    for (auto& e : *chunk) {
+                        if (m_cancel.load()) break;
+                        if (stages.hash) {
+                            throttle.Acquire(e.size, m_cancel);
+                            stages.hash(e);
+                            c.bytesHashed.fetch_add(e.size, std::memory_order_relaxed);
+                        }
+                        c.hashed.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    toTag.Push(std::move(*chunk));
+                }
+            });
+        }
+
+        // walk stage
+        {
+            WorkPool pool(opt.walkThreads ? opt.walkThreads : hw);
+            DirEnumOptions dopt;
+            dopt.includeHidden = opt.includeHidden;
+            dopt.wantStat = true;
+            dopt.firstBatch = 512;
+            std::function<void(std::filesystem::path)> walk = [&](std::filesystem::path dir) {
+                if (m_cancel.load()) return;
+                if (stages.onDirectory) stages.onDirectory(dir);
+                Chunk chunk;
+                bool ok = EnumerateDirectory(dir, dopt, m_cancel, [&](std::vector<DirEntry>&& batch) {
+                    for (auto& d : batch) {
+                        if (d.isDir) {
+#ifdef _WIN32
+                            if (d.attributes & FILE_ATTRIBUTE_REPARSE_POINT) continue; // junctions / links: no cycles
+#endif
+                            pool.Submit([&walk, sub = dir / d.name]() { walk(sub); });
+                            continue;
+                        }
+                        FileIndexEntry e;
+                        e.path = (dir / d.name).native();
+                        e.size = d.size;
+                        e.mtime = d.mtime;
+                        c.discovered.fetch_add(1, std::memory_order_relaxed);
+                        if (stages.filter && !stages.filter(e)) { c.skipped.fetch_add(1, std::memory_order_relaxed); continue; }
+                        chunk.push_back(std::move(e));
+                        if (chunk.size() >= kChunk) { toHash.Push(std::move(chunk)); chunk = Chunk(); }
+                    }
+                });
+                if (!chunk.empty()) toHash.Push(std::move(chunk));
+                if (!ok && !m_cancel.load()) {
+                    c.dirErrors.fetch_add(1, std::memory_order_relaxed);
+                    if (stages.onDirectoryError) stages.onDirectoryError(dir);
+                }
+            };
+            for (auto const& r : roots) pool.Submit([&walk, r]() { walk(r); });
+            pool.WaitIdle();
+        }
+        c.walkDone.store(true);
+
+        // drain (or abort) the later stages in order
+        if (m_cancel.load()) { toHash.Abort(); toTag.Abort(); }
+        toHash.Close();
+        for (auto& t : hashWorkers) t.join();
+        if (m_cancel.load()) toTag.Abort();
+        toTag.Close();
+        for (auto& t : tagWorkers) t.join();
+
+        {
+            std::lock_guard<std::mutex> lg(progressMutex);
+            finished = true;
+        }
+        progressCv.notify_all();
+        reporter.join();
+        if (stages.onProgress) stages.onProgress(c.Snapshot());
+        return !m_cancel.load();
+    }
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> discovered{ 0 }, skipped{ 0 }, hashed{ 0 }, done{ 0 }, bytesHashed{ 0 }, dirErrors{ 0 };
+        std::atomic<bool> walkDone{ false };
+        IndexProgress Snapshot() const {
+            IndexProgress p;
+            p.discovered = discovered.load(); p.skipped = skipped.load(); p.hashed = hashed.load();
+            p.done = done.load(); p.bytesHashed = bytesHashed.load(); p.dirErrors = dirErrors.load();
+            p.walkDone = walkDone.load();
+            return p;
+        }
+    };
+
+    static constexpr size_t kChunk = 64;
+    std::atomic<bool> m_cancel{ false };
+
+    static void Deliver(const IndexPipelineStages& stages, std::vector<FileIndexEntry>& batch, Counters& c) {
+        if (batch.empty()) return;
+        size_t n = batch.size();
+        if (stages.onBatch) stages.onBatch(std::move(batch));
+        batch.clear();
+        c.done.fetch_add(n, std::memory_order_relaxed);
+    }
+};
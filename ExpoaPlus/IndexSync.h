@@ -0,0 +1,171 @@
+// IndexSync.h — keeps a FileIndex in step with the file system without re-reading unchanged files
+// - Rescan(root): pipeline walk where files with the stored size + mtime (and a hash) are skipped
+//   before any content is read; afterwards entries below root that the walk did not see are
+//   removed (except below directories that could not be read)
+// - Apply(events): FsWatcher batches; only the affected paths are looked at. File renames keep the
+//   stored hash/tags when size + mtime still match, directory renames re-key the whole subtree,
+//   new directories are rescanned, Overflow falls back to Rescan(root)
+// A full rescan sees a move as remove + add; moves are only recognised from watcher events.
+// All index access goes through the caller's mutex (also used by the UI).
+#pragma once
+
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "FileIndex.h"
+#include "FsWatcher.h"
+#include "Hashing.h"
+#include "IndexPipeline.h"
+
+class IndexSync {
+public:
+    IndexSync(FileIndex& index, std::mutex& mutex) : m_index(index), m_mutex(mutex) {}
+
+    // hash / tags (and optionally onProgress) used for new or changed files; filter and onBatch are set here
+    void SetStages(IndexPipelineStages stages) { m_stages = std::move(stages); }
+
+    // Walk root, re-read only new/changed files, drop entries that are gone. false = cancelled (nothing removed)
+    bool Rescan(const std::filesystem::path& root, const IndexPipelineOptions& opt, IndexPipeline& pipeline) {
+        return Rescan(root, opt, pipeline, true);
+    }
+
+    // Watcher batch (call on a background thread; may run hash/tag stages and sub-rescans)
+    void Apply(const std::vector<FsEvent>& events, const std::filesystem::path& root, const IndexPipelineOptions& opt) {
+        for (auto const& ev : events) {
+            if (ev.kind == FsChange::Overflow) { Rescan(root, opt, m_watchPipeline, false); return; }
+        }
+        for (auto const& ev : events) {
+            switch (ev.kind) {
+            case FsChange::Added:
+            case FsChange::Modified:
+                Refresh(ev.path, opt);
+                break;
+            case FsChange::Removed:
+                RemoveTree(ev.path.native());
+                break;
+            case FsChange::Renamed:
+                Move(ev.oldPath, ev.path, opt);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    void Cancel() { m_watchPipeline.Cancel(); }
+
+private:
+    FileIndex& m_index;
+    std::mutex& m_mutex;
+    IndexPipelineStages m_stages;
+    IndexPipeline m_watchPipeline;
+
+    bool Rescan(const std::filesystem::path& root, const IndexPipelineOptions& opt, IndexPipeline& pipeline, bool progress) {
+        std::mutex seenMutex;
+        std::unordered_set<uint64_t> seen;                     // path hashes; a collision only delays a removal
+        std::vector<IndexString> unreadable;
+        IndexPipelineStages st = m_stages;
+        if (!progress) st.onProgress = nullptr;                // watcher updates run silently
+        st.filter = [&](const FileIndexEntry& e) {
+            {
+                std::lock_guard<std::mutex> lg(seenMutex);
+                seen.insert(PathKey(e.path));
+            }
+            return !Unchanged(e);
+        };
+        st.onBatch = [this](std::vector<FileIndexEntry>&& batch) {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            for (auto const& e : batch) m_index.Put(e);
+        };
+        st.onDirectoryError = [&](const std::filesystem::path& dir) {
+            std::lock_guard<std::mutex> lg(seenMutex);
+            unreadable.push_back(dir.native());
+        };
+        if (!pipeline.Run({ root }, opt, st)) return false; // cancelled: what was not seen is not gone
+
+        std::lock_guard<std::mutex> lg(m_mutex);
+        std::vector<IndexString> gone;
+        m_index.ForEachPath([&](IndexStringView p) {
+            if (!Below(p, root.native()) || seen.count(PathKey(p))) return;
+            for (auto const& u : unreadable) if (Below(p, u)) return;
+            gone.emplace_back(p);
+        });
+        for (auto const& p : gone) m_index.Remove(p);
+        return true;
+    }
+
+    static uint64_t PathKey(IndexStringView p) { return FastHash64(p.data(), p.size() * sizeof(IndexChar)); }
+
+    static bool IsSep(IndexChar c) {
+#ifdef _WIN32
+        return c == L'\\' || c == L'/';
+#else
+        return c == '/';
+#endif
+    }
+    // p is dir itself or lies below it
+    static bool Below(IndexStringView p, IndexStringView dir) {
+        while (!dir.empty() && IsSep(dir.back())) dir.remove_suffix(1);
+        if (p.size() < dir.size() || p.compare(0, dir.size(), dir) != 0) return false;
+        return p.size() == dir.size() || IsSep(p[dir.size()]);
+    }
+
+    bool Unchanged(const FileIndexEntry& e) {
+        FileIndexEntry old;
+        std::lock_guard<std::mutex> lg(m_mutex);
+        return m_index.Find(e.path, old) && old.size == e.size && old.mtime == e.mtime && old.hashLen > 0;
+    }
+
+    // Re-read one path: directory -> rescan below it, file -> hash/tags if it changed, gone -> remove
+    void Refresh(const std::filesystem::path& path, const IndexPipelineOptions& opt) {
+        DirEntry st;
+        if (!StatEntry(path, st)) { RemoveTree(path.native()); return; }
+        if (st.isDir) { Rescan(path, opt, m_watchPipeline, false); return; }
+        FileIndexEntry e;
+        e.path = path.native();
+        e.size = st.size;
+        e.mtime = st.mtime;
+        if (Unchanged(e)) return;
+        if (m_stages.hash) m_stages.hash(e);
+        if (m_stages.tags) m_stages.tags(e);
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_index.Put(e);
+    }
+
+    void RemoveTree(IndexStringView path) {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        if (m_index.Contains(path)) { m_index.Remove(path); return; } // a file: no subtree to look for
+        std::vector<IndexString> gone;
+        m_index.ForEachPath([&](IndexStringView p) { if (Below(p, path)) gone.emplace_back(p); });
+        for (auto const& p : gone) m_index.Remove(p);
+    }
+
+    void Move(const std::filesystem::path& from, const std::filesystem::path& to, const IndexPipelineOptions& opt) {
+        DirEntry st;
+        if (!StatEntry(to, st)) { RemoveTree(from.native()); return; }
+        IndexStringView f = from.native();
+        IndexString t = to.native();
+        std::vector<FileIndexEntry> moved;
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            std::vector<IndexString> old;
+            m_index.ForEachPath([&](IndexStringView p) { if (Below(p, f)) old.emplace_back(p); });
+            for (auto const& p : old) {
+                FileIndexEntry e;
+                if (!m_index.Find(p, e)) continue;
+                m_index.Remove(p);
+                e.path = t + p.substr(f.size());
+                moved.push_back(std::move(e));
+            }
+            if (!st.isDir) {
+                // a file keeps its content data only if it did not change on the way
+                for (auto const& e : moved) if (e.size == st.size && e.mtime == st.mtime) m_index.Put(e);
+                if (!moved.empty() && moved[0].size == st.size && moved[0].mtime == st.mtime) return;
+            }
+            else for (auto const& e : moved) m_index.Put(e);
+        }
+        // a directory: pick up anything that changed while it moved; a file: treat as new
+        Refresh(to, opt);
+    }
+};
@@ -0,0 +1,180 @@
+// ListingStore.h — the items of a folder listing / search result as columns instead of FileItem objects
+// - Names live back to back in one character arena; every directory is stored once (with its trailing
+//   separator) and items refer to it by id, so the full path is never kept per item
+// - size / mtime / attributes / folder flag in their own arrays (about 31 bytes per item plus the name)
+// - Views (filter, sort) are position lists into the store; nothing is copied to narrow a listing
+// - Find(path): open-addressing hash table over the full path, built on the first lookup and kept
+//   up to date by Add() afterwards. The hash runs over code units and is continued from the
+//   directory's hash over the name, so the path never has to be assembled to hash or to compare it.
+// Strings are wchar_t (UTF-16 on Windows). Not thread-safe; owned by the UI thread.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class ListingStore {
+public:
+    static constexpr uint32_t kNone = ~0u;
+
+    void Clear() {
+        m_chars.clear();
+        m_dirs.clear();
+        m_dirIds.clear();
+        m_lastDir = kNone;
+        m_dir.clear();
+        m_nameOff.clear();
+        m_nameLen.clear();
+        m_size.clear();
+        m_mtime.clear();
+        m_attributes.clear();
+        m_folder.clear();
+        m_slots.clear();
+        m_used = 0;
+    }
+
+    size_t Size() const { return m_dir.size(); }
+    bool Empty() const { return m_dir.empty(); }
+
+    // Directory including its trailing separator ("C:\\Users\\a\\"); the same text always gets the same id
+    uint32_t AddDir(std::wstring_view dir) {
+        if (m_lastDir != kNone && Text(m_dirs[m_lastDir].off, m_dirs[m_lastDir].len) == dir) return m_lastDir;
+        uint64_t h = HashUnits(dir, kSeed);
+        auto range = m_dirIds.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it)
+            if (Text(m_dirs[it->second].off, m_dirs[it->second].len) == dir) return m_lastDir = it->second;
+        uint32_t id = (uint32_t)m_dirs.size();
+        m_dirs.push_back({ AppendText(dir), (uint32_t)dir.size(), h });
+        m_dirIds.emplace(h, id);
+        return m_lastDir = id;
+    }
+
+    uint32_t Add(uint32_t dir, std::wstring_view name, bool isFolder, uint64_t size, uint64_t mtime, uint32_t attributes = 0) {
+        uint32_t row = (uint32_t)m_dir.size();
+        m_dir.push_back(dir);
+        m_nameOff.push_back(AppendText(name));
+        m_nameLen.push_back((uint16_t)std::min<size_t>(name.size(), 0xFFFF));
+        m_size.push_back(size);
+        m_mtime.push_back(mtime);
+        m_attributes.push_back(attributes);
+        m_folder.push_back(isFolder ? 1 : 0);
+        if (!m_slots.empty()) Index(row);
+        return row;
+    }
+
+    // Full path: split after the last '\\' or '/'
+    uint32_t Add(std::wstring_view path, bool isFolder, uint64_t size, uint64_t mtime, uint32_t attributes = 0) {
+        size_t sep = path.find_last_of(L"\\/");
+        size_t cut = sep == std::wstring_view::npos ? 0 : sep + 1;
+        return Add(AddDir(path.substr(0, cut)), path.substr(cut), isFolder, size, mtime, attributes);
+    }
+
+    std::wstring_view Name(uint32_t i) const { return Text(m_nameOff[i], m_nameLen[i]); }
+    std::wstring_view Dir(uint32_t i) const { return Text(m_dirs[m_dir[i]].off, m_dirs[m_dir[i]].len); }
+    std::wstring Path(uint32_t i) const {
+        std::wstring p;
+        p.reserve(Dir(i).size() + Name(i).size());
+        p.append(Dir(i));
+        p.append(Name(i));
+        return p;
+    }
+    bool IsFolder(uint32_t i) const { return m_folder[i] != 0; }
+    uint64_t FileSize(uint32_t i) const { return m_size[i]; }
+    uint64_t Mtime(uint32_t i) const { return m_mtime[i]; }
+    uint32_t Attributes(uint32_t i) const { return m_attributes[i]; }
+
+    // Row of an exact (case-sensitive) full path, kNone if it is not in the store
+    uint32_t Find(std::wstring_view path) {
+        if (m_dir.empty()) return kNone;
+        if (m_slots.empty()) Rehash(Size() * 2);
+        uint64_t h = HashUnits(path, kSeed);
+        size_t mask = m_slots.size() - 1;
+        for (size_t j = (size_t)h & mask;; j = (j + 1) & mask) {
+            Slot const& s = m_slots[j];
+            if (s.row == kNone) return kNone;
+            if (s.tag != (uint32_t)(h >> 32)) continue;
+            std::wstring_view dir = Dir(s.row), name = Name(s.row);
+            if (path.size() == dir.size() + name.size() && path.substr(0, dir.size()) == dir && path.substr(dir.size()) == name)
+                return s.row;
+        }
+    }
+
+    // Bytes held by the store (capacity), for the metrics log and benchmarks/listing_bench.cpp
+    size_t MemoryBytes() const {
+        size_t b = m_chars.capacity() * sizeof(wchar_t) + m_dirs.capacity() * sizeof(DirInfo) + m_dirIds.size() * 32;
+        b += m_dir.capacity() * 4 + m_nameOff.capacity() * 4 + m_nameLen.capacity() * 2;
+        b += m_size.capacity() * 8 + m_mtime.capacity() * 8 + m_attributes.capacity() * 4 + m_folder.capacity();
+        return b + m_slots.capacity() * sizeof(Slot);
+    }
+
+private:
+    static constexpr uint64_t kSeed = 0x2545F4914F6CDD1Dull;
+
+    // One multiply per code unit; hashing a + b continues from the state after a
+    static uint64_t HashUnits(std::wstring_view s, uint64_t h) {
+        for (wchar_t c : s) {
+            h = (h ^ (uint64_t)c) * 0x9E3779B97F4A7C15ull;
+            h ^= h >> 32;
+        }
+        return h;
+    }
+
+    struct DirInfo {
+        uint32_t off, len;
+        uint64_t hash;                        // HashUnits state after the directory text
+    };
+    struct Slot {
+        uint32_t row = kNone;
+        uint32_t tag = 0;                     // upper half of the path hash
+    };
+
+    std::vector<wchar_t> m_chars;             // directory texts and names
+    std::vector<DirInfo> m_dirs;
+    std::unordered_multimap<uint64_t, uint32_t> m_dirIds;
+    uint32_t m_lastDir = kNone;               // enumeration adds a whole directory in a row
+    std::vector<uint32_t> m_dir, m_nameOff;
+    std::vector<uint16_t> m_nameLen;
+    std::vector<uint64_t> m_size, m_mtime;
+    std::vector<uint32_t> m_attributes;
+    std::vector<uint8_t> m_folder;
+    std::vector<Slot> m_slots;                // empty until the first Find()
+    size_t m_used = 0;
+
+    std::wstring_view Text(uint32_t off, uint32_t len) const { return std::wstring_view(m_chars.data() + off, len); }
+
+    uint32_t AppendText(std::wstring_view s) {
+        uint32_t off = (uint32_t)m_chars.size();
+        m_chars.insert(m_chars.end(), s.begin(), s.end());
+        return off;
+    }
+
+    uint64_t RowHash(uint32_t row) const {
+        return HashUnits(Name(row), m_dirs[m_dir[row]].hash);
+    }
+
+    void Index(uint32_t row) {
+        if ((m_used + 1) * 4 > m_slots.size() * 3) {
+            Rehash(m_slots.size() * 2);
+            return;                           // Rehash placed every row, this one included
+        }
+        Place(row, RowHash(row));
+    }
+
+    void Place(uint32_t row, uint64_t h) {
+        size_t mask = m_slots.size() - 1, j = (size_t)h & mask;
+        while (m_slots[j].row != kNone) j = (j + 1) & mask;
+        m_slots[j] = Slot{ row, (uint32_t)(h >> 32) };
+        ++m_used;
+    }
+
+    void Rehash(size_t want) {
+        size_t slots = 16;
+        while (slots < want) slots <<= 1;
+        m_slots.assign(slots, Slot{});
+        m_used = 0;
+        for (uint32_t row = 0; row < (uint32_t)m_dir.size(); ++row) Place(row, RowHash(row));
+    }
+};
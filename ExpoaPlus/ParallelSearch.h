@@ -0,0 +1,195 @@
+// ParallelSearch.h — recursive name search below one folder, results streamed while the walk runs
+// - Walk on a WorkPool (one task per directory, work stealing: big subtrees are split up by idle
+//   workers); names, types and — on Win32 — size/mtime come from the enumeration itself (DirEnum.h)
+// - POSIX: no stat during the walk (getdents d_type); only matches are stat'ed for size/mtime
+// - Matching: substring (optionally case-insensitive) or fuzzy (FuzzyPattern, bit-parallel)
+// - Excluded directory names / paths are not entered at all (.git, node_modules, ...)
+// - Matches are handed over in batches (small first batch, then batchSize or flushInterval);
+//   onBatch calls never overlap. maxResults stops the walk once reached; Cancel() from any thread.
+// One search per object; Run() blocks, call it on a background thread.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "DirEnum.h"
+#include "FuzzySearch.h"
+#include "WorkPool.h"
+
+struct SearchHit {
+    DirString path;
+    uint64_t size = 0;
+    uint64_t mtime = 0;       // same units as DirEntry::mtime
+    bool isDir = false;
+    int distance = 0;         // fuzzy: edits needed, substring: 0
+};
+
+struct ParallelSearchOptions {
+    unsigned threads = 0;                     // 0 = hardware threads
+    bool includeHidden = false;
+    bool matchDirectories = true;             // directory names can be hits too
+    bool matchCase = false;                   // substring mode only; fuzzy is always case-insensitive
+    bool fuzzy = false;
+    int maxDistance = 2;                      // fuzzy: also at most one edit per three needle characters
+    size_t maxResults = 0;                    // 0 = unlimited
+    bool statMatches = true;                  // POSIX: size/mtime for hits (one lstat each)
+    std::vector<DirString> excludeNames;      // directory names skipped with their subtree (any case)
+    std::vector<DirString> excludePaths;      // full directory paths skipped with their subtree
+    size_t firstBatch = 64;
+    size_t batchSize = 1024;
+    std::chrono::milliseconds flushInterval{ 100 };
+};
+
+struct ParallelSearchStats {
+    uint64_t dirs = 0;                        // directories enumerated
+    uint64_t entries = 0;                     // names looked at
+    uint64_t matches = 0;                     // hits delivered
+    uint64_t dirErrors = 0;                   // directories that could not be opened
+    uint64_t excluded = 0;                    // subtrees pruned by excludeNames / excludePaths
+    bool capped = false;                      // stopped at maxResults
+    bool cancelled = false;
+};
+
+class ParallelSearch {
+public:
+    using Ch = DirString::value_type;
+    using BatchFn = std::function<void(std::vector<SearchHit>&&)>;
+
+    void Cancel() {
+        m_cancelled.store(true);
+        m_stop.store(true);
+    }
+    bool Cancelled() const { return m_cancelled.load(); }
+
+    // Search below root (root itself is not a hit). false = cancelled; batches delivered so far stay valid.
+    bool Run(const std::filesystem::path& root, std::basic_string_view<Ch> needle, const ParallelSearchOptions& opt,
+             const BatchFn& onBatch, ParallelSearchStats* stats = nullptr) {
+        m_opt = &opt;
+        m_onBatch = &onBatch;
+        m_limit = opt.firstBatch ? opt.firstBatch : 1;
+        m_lastFlush = std::chrono::steady_clock::now();
+        m_matcher.Assign(needle, opt.fuzzy, opt.matchCase, opt.maxDistance);
+        m_excludeNames.clear();
+        m_excludePaths.clear();
+        for (auto const& n : opt.excludeNames) m_excludeNames.insert(Folded(n));
+        for (auto const& p : opt.excludePaths) {
+            auto n = std::filesystem::path(p).lexically_normal();
+            if (!n.has_filename()) n = n.parent_path();      // no trailing separator, as built from dir / name
+            m_excludePaths.insert(Folded(n.native()));
+        }
+
+        if (!m_stop.load()) {
+            WorkPool pool(opt.threads);
+            DirEnumOptions dopt;
+            dopt.includeHidden = opt.includeHidden;
+            dopt.wantStat = false;
+            dopt.firstBatch = 512;
+            std::function<void(std::filesystem::path)> walk = [&](std::filesystem::path dir) {
+                if (m_stop.load(std::memory_order_relaxed)) return;
+                m_dirs.fetch_add(1, std::memory_order_relaxed);
+                bool ok = EnumerateDirectory(dir, dopt, m_stop, [&](std::vector<DirEntry>&& batch) {
+                    std::vector<SearchHit> hits;
+                    m_entries.fetch_add(batch.size(), std::memory_order_relaxed);
+                    for (auto& d : batch) {
+                        if (m_stop.load(std::memory_order_relaxed)) break;
+                        if (d.isDir) {
+#ifdef _WIN32
+                            if (d.attributes & FILE_ATTRIBUTE_REPARSE_POINT) continue; // junctions / links: no cycles
+#endif
+                            if (Excluded(dir, d.name)) { m_excluded.fetch_add(1, std::memory_order_relaxed); continue; }
+                            pool.Submit([&walk, sub = dir / d.name]() { walk(sub); });
+                            if (!opt.matchDirectories) continue;
+                        }
+                        int distance = 0;
+                        if (!m_matcher.Matches(d.name, &distance)) continue;
+                        if (opt.maxResults && m_matches.fetch_add(1, std::memory_order_relaxed) >= opt.maxResults) {
+                            m_capped.store(true);
+                            m_stop.store(true);
+                            break;
+                        }
+                        SearchHit h;
+                        h.path = (dir / d.name).native();
+                        h.isDir = d.isDir;
+                        h.size = d.size;
+                        h.mtime = d.mtime;
+                        h.distance = distance;
+#ifndef _WIN32
+                        DirEntry st;
+                        if (opt.statMatches && !d.attributes && StatEntry(h.path, st)) { h.size = st.size; h.mtime = st.mtime; }
+#endif
+                        hits.push_back(std::move(h));
+                    }
+                    Hand(std::move(hits), false);
+                });
+                if (!ok && !m_stop.load()) m_dirErrors.fetch_add(1, std::memory_order_relaxed);
+            };
+            pool.Submit([&walk, root]() { walk(root); });
+            pool.WaitIdle();
+        }
+        if (!m_cancelled.load()) Hand({}, true);
+
+        if (stats) {
+            stats->dirs = m_dirs.load();
+            stats->entries = m_entries.load();
+            stats->matches = m_delivered;
+            stats->dirErrors = m_dirErrors.load();
+            stats->excluded = m_excluded.load();
+            stats->capped = m_capped.load();
+            stats->cancelled = m_cancelled.load();
+        }
+        return !m_cancelled.load();
+    }
+
+private:
+    const ParallelSearchOptions* m_opt = nullptr;
+    const BatchFn* m_onBatch = nullptr;
+    std::atomic<bool> m_stop{ false }, m_cancelled{ false }, m_capped{ false };
+    std::atomic<uint64_t> m_dirs{ 0 }, m_entries{ 0 }, m_matches{ 0 }, m_dirErrors{ 0 }, m_excluded{ 0 };
+
+    // matching (read-only during the walk)
+    NameMatcher<Ch> m_matcher;
+    std::unordered_set<DirString> m_excludeNames, m_excludePaths; // folded
+
+    // hits waiting for the next batch
+    std::mutex m_pendingMutex, m_deliverMutex;
+    std::vector<SearchHit> m_pending;
+    size_t m_limit = 0;
+    std::chrono::steady_clock::time_point m_lastFlush;
+    uint64_t m_delivered = 0;                 // under m_deliverMutex
+
+    static DirString Folded(DirString s) {
+        for (auto& c : s) c = FuzzyFold(c);
+        return s;
+    }
+
+    bool Excluded(const std::filesystem::path& dir, const DirString& name) const {
+        if (!m_excludeNames.empty() && m_excludeNames.count(Folded(name))) return true;
+        return !m_excludePaths.empty() && m_excludePaths.count(Folded((dir / name).native()));
+    }
+
+    // Collect hits; hand them on once a batch is full or due (or at the end). onBatch runs outside
+    // the pending lock so workers are not held up by the receiver, but never twice at once.
+    void Hand(std::vector<SearchHit>&& hits, bool final) {
+        std::vector<SearchHit> out;
+        {
+            std::lock_guard<std::mutex> lg(m_pendingMutex);
+            if (m_pending.empty()) m_pending = std::move(hits);
+            else m_pending.insert(m_pending.end(), std::make_move_iterator(hits.begin()), std::make_move_iterator(hits.end()));
+            auto now = std::chrono::steady_clock::now();
+            if (m_pending.empty() || (!final && m_pending.size() < m_limit && now - m_lastFlush < m_opt->flushInterval)) return;
+            out.swap(m_pending);
+            m_limit = m_opt->batchSize ? m_opt->batchSize : 1;
+            m_lastFlush = now;
+        }
+        std::lock_guard<std::mutex> lg(m_deliverMutex);
+        if (m_cancelled.load()) return;
+        m_delivered += out.size();
+        (*m_onBatch)(std::move(out));
+    }
+};
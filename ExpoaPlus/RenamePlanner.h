@@ -0,0 +1,526 @@
+// RenamePlanner.h — batch renames as one transaction (batch rename, undo of a batch)
+// - Plan(): the whole mapping up front. Drops no-ops; reports missing sources, invalid names, two
+//   renames of one file, two files onto one name and targets taken by files outside the batch
+//   (also when a rename is blocked because the rename that would free its target was dropped) and
+//   paths inside a folder the same batch renames
+// - Order: a rename whose target is the source of another rename runs after it. The renames form
+//   chains and cycles (swaps a<->b, rotations); a cycle is opened with a temporary name in the same
+//   folder ("a -> tmp, b -> a, tmp -> b"). Each chain / cycle is a unit of steps that run in order.
+// - Execute(): units run in parallel, one lane per folder (WorkPool). Every step is a rename that
+//   never replaces (renameat2 RENAME_NOREPLACE / MoveFileExW without REPLACE_EXISTING), so a file
+//   that appears after planning is not overwritten. The first failure stops all lanes and the steps
+//   done so far are undone in reverse.
+// - Journal (SetJournalDir): the plan is written before the first rename, then one record per step
+//   done / undone. Recover() rolls back batches a crash left half done: per unit the steps are a
+//   prefix, and the one step after the last record is checked on disk (it may have happened without
+//   its record).
+// Paths are compared exactly on POSIX and case-insensitively on Windows.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "DirEnum.h"
+#include "FileIndex.h"
+#include "WorkPool.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+struct RenameOp {
+    std::filesystem::path from, to;
+};
+
+enum class RenameIssue : uint8_t { SourceMissing, InvalidName, DuplicateSource, DuplicateTarget, TargetExists, Nested, Blocked };
+
+struct RenameProblem {
+    RenameOp op;
+    RenameIssue issue;
+};
+
+struct RenameStep {
+    std::filesystem::path from, to;
+};
+
+struct RenamePlan {
+    std::vector<RenameOp> ops;                // accepted renames (what an undo reverses)
+    std::vector<RenameProblem> problems;      // left out of the plan
+    std::vector<RenameStep> steps;            // ops in order, plus temporary names for cycles
+    struct Unit { uint32_t first, count; };
+    std::vector<Unit> units;                  // steps[first, first + count) run in order; units are independent
+    size_t cycles = 0;
+};
+
+struct RenameOptions {
+    unsigned threads = 4;                     // folders renamed at the same time
+};
+
+struct RenameResult {
+    bool ok = true;                           // every step done (false: rolled back as far as possible)
+    size_t done = 0;                          // steps done (ok) or done before the failure
+    std::string error;                        // first failure
+    RenameStep failed;
+    std::vector<RenameStep> notUndone;        // rollback failures: these steps stay done
+};
+
+class RenamePlanner {
+public:
+    // Journals go to dir (created); empty = no journal, a crash leaves a half-done batch
+    void SetJournalDir(const std::filesystem::path& dir) {
+        std::error_code ec;
+        if (!dir.empty()) std::filesystem::create_directories(dir, ec);
+        m_journalDir = dir;
+    }
+
+    static const char* IssueText(RenameIssue i) {
+        switch (i) {
+        case RenameIssue::SourceMissing: return "source not found";
+        case RenameIssue::InvalidName: return "invalid name";
+        case RenameIssue::DuplicateSource: return "renamed twice";
+        case RenameIssue::DuplicateTarget: return "several files get this name";
+        case RenameIssue::TargetExists: return "target exists";
+        case RenameIssue::Nested: return "inside a folder that is renamed too";
+        case RenameIssue::Blocked: return "target is not freed";
+        }
+        return "";
+    }
+
+    static RenamePlan Plan(const std::vector<RenameOp>& requests) {
+        RenamePlan plan;
+        struct Op {
+            RenameOp op;
+            IndexString fromKey, toKey, fromDir, toDir;
+            bool bad = false;
+        };
+        std::vector<Op> ops;
+        ops.reserve(requests.size());
+        for (auto const& r : requests) {
+            Op o;
+            o.op = { r.from.lexically_normal(), r.to.lexically_normal() };
+            if (o.op.from == o.op.to) continue;
+            o.fromKey = Key(o.op.from);
+            o.toKey = Key(o.op.to);
+            o.fromDir = Key(o.op.from.parent_path());
+            o.toDir = Key(o.op.to.parent_path());
+            ops.push_back(std::move(o));
+        }
+        auto drop = [&](Op& o, RenameIssue issue) {
+            if (o.bad) return;
+            o.bad = true;
+            plan.problems.push_back({ o.op, issue });
+        };
+
+        std::unordered_map<IndexString, uint32_t> bySource, byTarget;
+        std::unordered_set<IndexString> twiceSource, twiceTarget;
+        bySource.reserve(ops.size());
+        byTarget.reserve(ops.size());
+        for (uint32_t i = 0; i < (uint32_t)ops.size(); ++i) {
+            if (!bySource.emplace(ops[i].fromKey, i).second) twiceSource.insert(ops[i].fromKey);
+            if (!byTarget.emplace(ops[i].toKey, i).second) twiceTarget.insert(ops[i].toKey);
+        }
+        // Existence: a folder with many renames is listed once instead of two stats per rename
+        std::unordered_map<IndexString, uint32_t> perDir;
+        for (auto const& o : ops) {
+            ++perDir[o.fromDir];
+            ++perDir[o.toDir];
+        }
+        std::unordered_map<IndexString, std::unique_ptr<std::unordered_set<IndexString>>> listings;
+        auto exists = [&](const std::filesystem::path& p, const IndexString& dir) {
+            DirEntry st;
+            if (perDir[dir] < kListMin) return StatEntry(p, st);
+            auto it = listings.find(dir);
+            if (it == listings.end()) it = listings.emplace(dir, List(p.parent_path())).first;
+            return it->second ? it->second->count(Key(p.filename())) != 0 : StatEntry(p, st);   // null: not listable
+        };
+        for (auto& o : ops) {
+            if (!ValidName(o.op.to)) drop(o, RenameIssue::InvalidName);
+            else if (twiceSource.count(o.fromKey)) drop(o, RenameIssue::DuplicateSource);
+            else if (twiceTarget.count(o.toKey)) drop(o, RenameIssue::DuplicateTarget);
+            else if (!exists(o.op.from, o.fromDir)) drop(o, RenameIssue::SourceMissing);
+            else if (!bySource.count(o.toKey) && exists(o.op.to, o.toDir)) drop(o, RenameIssue::TargetExists);
+        }
+        // paths inside a folder that is renamed in the same batch would be stale by the time they run
+        std::unordered_map<IndexString, bool> inside;                   // per parent folder
+        auto insideRenamed = [&](const std::filesystem::path& p, const IndexString& dirKey) {
+            auto it = inside.find(dirKey);
+            if (it != inside.end()) return it->second;
+            bool found = false;
+            for (auto dir = p.parent_path(); !found && dir.has_relative_path(); dir = dir.parent_path()) found = bySource.count(Key(dir)) != 0;
+            return inside[dirKey] = found;
+        };
+        for (auto& o : ops)
+            if (!o.bad && (insideRenamed(o.op.from, o.fromDir) || insideRenamed(o.op.to, o.toDir))) drop(o, RenameIssue::Nested);
+        // a rename onto a name that a dropped rename was to free stays blocked (a -> b while b -> c was dropped)
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (auto& o : ops) {
+                if (o.bad) continue;
+                auto j = bySource.find(o.toKey);
+                if (j != bySource.end() && ops[j->second].bad) {
+                    drop(o, RenameIssue::Blocked);
+                    changed = true;
+                }
+            }
+        }
+
+        // next[i]: the rename that has to run before i because it frees i's target; prev is the inverse.
+        // Sources and targets are unique, so every component is a chain or a cycle.
+        const uint32_t none = ~0u;
+        std::vector<uint32_t> next(ops.size(), none), prev(ops.size(), none);
+        for (uint32_t i = 0; i < (uint32_t)ops.size(); ++i) {
+            if (ops[i].bad) continue;
+            plan.ops.push_back(ops[i].op);
+            auto j = bySource.find(ops[i].toKey);
+            if (j == bySource.end()) continue;
+            next[i] = j->second;
+            prev[j->second] = i;
+        }
+        std::vector<uint8_t> placed(ops.size(), 0);
+        auto unit = [&](uint32_t head) {
+            uint32_t first = (uint32_t)plan.steps.size();
+            for (uint32_t i = head; i != none && !placed[i]; i = prev[i]) {
+                placed[i] = 1;
+                plan.steps.push_back({ ops[i].op.from, ops[i].op.to });
+            }
+            plan.units.push_back({ first, (uint32_t)plan.steps.size() - first });
+        };
+        // chains: start at the rename whose target is free
+        for (uint32_t i = 0; i < (uint32_t)ops.size(); ++i)
+            if (!ops[i].bad && next[i] == none) unit(i);
+        // what is left are cycles: c -> tmp, then the chain that ends at c, then tmp -> target of c
+        uint64_t tag = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+        for (uint32_t c = 0; c < (uint32_t)ops.size(); ++c) {
+            if (ops[c].bad || placed[c]) continue;
+            std::filesystem::path tmp = TempName(ops[c].op.from, tag, plan.cycles++);
+            uint32_t first = (uint32_t)plan.steps.size();
+            placed[c] = 1;
+            plan.steps.push_back({ ops[c].op.from, tmp });
+            for (uint32_t i = prev[c]; i != c; i = prev[i]) {
+                placed[i] = 1;
+                plan.steps.push_back({ ops[i].op.from, ops[i].op.to });
+            }
+            plan.steps.push_back({ tmp, ops[c].op.to });
+            plan.units.push_back({ first, (uint32_t)plan.steps.size() - first });
+        }
+        return plan;
+    }
+
+    RenameResult Execute(const RenamePlan& plan, const RenameOptions& opt = RenameOptions()) {
+        RenameResult result;
+        Journal journal;
+        OpenJournal(journal, plan);
+
+        // one lane per folder of the unit's first source
+        std::unordered_map<IndexString, std::vector<uint32_t>> lanes;
+        for (uint32_t u = 0; u < (uint32_t)plan.units.size(); ++u)
+            lanes[Key(plan.steps[plan.units[u].first].from.parent_path())].push_back(u);
+
+        std::vector<uint32_t> doneCount(plan.units.size(), 0);   // each written by its lane only
+        std::atomic<bool> failed{ false };
+        std::mutex failMutex;
+        auto runLane = [&](const std::vector<uint32_t>& units) {
+            for (uint32_t u : units) {
+                auto const& unit = plan.units[u];
+                for (uint32_t k = 0; k < unit.count; ++k) {
+                    if (failed.load(std::memory_order_relaxed)) return;
+                    auto const& s = plan.steps[unit.first + k];
+                    std::string error;
+                    if (!RenameNoReplace(s.from, s.to, error)) {
+                        std::lock_guard<std::mutex> lg(failMutex);
+                        if (!failed.exchange(true)) {
+                            result.error = std::move(error);
+                            result.failed = s;
+                        }
+                        return;
+                    }
+                    doneCount[u] = k + 1;
+                    Record(journal, kOpDone, unit.first + k);
+                }
+            }
+        };
+        if (lanes.size() == 1 || opt.threads <= 1) {
+            for (auto const& lane : lanes) runLane(lane.second);
+        }
+        else {
+            WorkPool pool(std::min<unsigned>(opt.threads, (unsigned)lanes.size()));
+            for (auto const& lane : lanes) pool.Submit([&runLane, &lane]() { runLane(lane.second); });
+            pool.WaitIdle();
+        }
+
+        for (uint32_t n : doneCount) result.done += n;
+        if (failed.load()) {
+            result.ok = false;
+            for (uint32_t u = 0; u < (uint32_t)plan.units.size(); ++u)
+                Undo(plan, u, doneCount[u], journal, result.notUndone);
+        }
+        else Record(journal, kOpCommit, 0);
+        CloseJournal(journal, result.notUndone.empty());
+        return result;
+    }
+
+    // Rolls back the batches of interrupted runs; returns how many journals were handled. Journals whose
+    // rollback failed stay for the next call.
+    size_t Recover(std::vector<RenameStep>* notUndone = nullptr) {
+        size_t handled = 0;
+        std::error_code ec;
+        if (m_journalDir.empty()) return 0;
+        std::vector<std::filesystem::path> files;
+        for (auto const& e : std::filesystem::directory_iterator(m_journalDir, ec))
+            if (e.path().extension() == ".renames") files.push_back(e.path());
+        for (auto const& file : files) {
+            RenamePlan plan;
+            std::vector<uint8_t> state;                           // per step: 1 done, 2 undone
+            bool committed = false;
+            if (ReadJournal(file, plan, state, committed) && !committed) {
+                Journal journal;
+                journal.path = file;
+                journal.out.open(file, std::ios::binary | std::ios::app);
+                std::vector<RenameStep> failures;
+                for (uint32_t u = 0; u < (uint32_t)plan.units.size(); ++u) {
+                    auto const& unit = plan.units[u];
+                    uint32_t done = 0;
+                    while (done < unit.count && state[unit.first + done] != 0) ++done;
+                    // the step after the last record may have happened (source gone, target there)
+                    if (done < unit.count) {
+                        auto const& s = plan.steps[unit.first + done];
+                        DirEntry st;
+                        if (!StatEntry(s.from, st) && StatEntry(s.to, st)) state[unit.first + done++] = 1;
+                    }
+                    uint32_t left = done;
+                    while (left > 0 && state[unit.first + left - 1] == 2) --left;
+                    // the last undo may have happened without its record (target gone, source back)
+                    if (left > 0) {
+                        auto const& s = plan.steps[unit.first + left - 1];
+                        DirEntry st;
+                        if (!StatEntry(s.to, st) && StatEntry(s.from, st)) --left;
+                    }
+                    Undo(plan, u, left, journal, failures);
+                }
+                journal.out.close();
+                if (notUndone) notUndone->insert(notUndone->end(), failures.begin(), failures.end());
+                if (!failures.empty()) continue;
+            }
+            std::filesystem::remove(file, ec);
+            ++handled;
+        }
+        return handled;
+    }
+
+    // Rename that fails instead of replacing an existing target
+    static bool RenameNoReplace(const std::filesystem::path& from, const std::filesystem::path& to, std::string& error) {
+#ifdef _WIN32
+        if (MoveFileExW(from.c_str(), to.c_str(), 0)) return true;
+        error = "error " + std::to_string(GetLastError());
+        return false;
+#else
+#if defined(__linux__) && defined(SYS_renameat2)
+        if (syscall(SYS_renameat2, AT_FDCWD, from.c_str(), AT_FDCWD, to.c_str(), 1u /* RENAME_NOREPLACE */) == 0) return true;
+        if (errno != ENOSYS && errno != EINVAL) {
+            error = std::strerror(errno);
+            return false;
+        }
+#endif
+        // file system without RENAME_NOREPLACE: check first (not atomic)
+        DirEntry st;
+        if (StatEntry(to, st)) {
+            error = std::strerror(EEXIST);
+            return false;
+        }
+        if (::rename(from.c_str(), to.c_str()) == 0) return true;
+        error = std::strerror(errno);
+        return false;
+#endif
+    }
+
+private:
+    static constexpr uint32_t kJournalMagic = 0x4e525058;      // "XPRN"
+    static constexpr uint32_t kListMin = 32;                   // renames in a folder (sources + targets) from which it is listed
+    static constexpr uint8_t kOpPlan = 1, kOpDone = 2, kOpUndone = 3, kOpCommit = 4;
+
+    struct Journal {
+        std::filesystem::path path;
+        std::ofstream out;
+        std::mutex mutex;
+    };
+
+    std::filesystem::path m_journalDir;
+
+    static IndexString Key(const std::filesystem::path& p) {
+        IndexString k = p.native();
+#ifdef _WIN32
+        if (!k.empty()) CharUpperBuffW(k.data(), (DWORD)k.size());
+#endif
+        return k;
+    }
+
+    // Names in dir as keys; null if it cannot be listed
+    static std::unique_ptr<std::unordered_set<IndexString>> List(const std::filesystem::path& dir) {
+        auto names = std::make_unique<std::unordered_set<IndexString>>();
+        DirEnumOptions opt;
+        opt.includeHidden = true;
+        opt.wantStat = false;
+        std::atomic<bool> cancel{ false };
+        if (!EnumerateDirectory(dir, opt, cancel, [&](std::vector<DirEntry>&& batch) {
+                for (auto const& e : batch) names->insert(Key(e.name));
+            }))
+            return nullptr;
+        return names;
+    }
+
+    static bool ValidName(const std::filesystem::path& to) {
+        auto name = to.filename().native();
+        if (name.empty() || name == std::filesystem::path(".").native() || name == std::filesystem::path("..").native()) return false;
+#ifdef _WIN32
+        if (name.find_first_of(L"<>:\"/\\|?*") != std::wstring::npos) return false;
+        if (name.back() == L' ' || name.back() == L'.') return false;
+        for (wchar_t c : name) if (c < 32) return false;
+#endif
+        return true;
+    }
+
+    static std::filesystem::path TempName(const std::filesystem::path& from, uint64_t tag, size_t n) {
+        return from.parent_path() / (".~ren" + std::to_string(tag) + "-" + std::to_string(n));
+    }
+
+    // Undo steps [first, first + count) of a unit, last one first
+    static void Undo(const RenamePlan& plan, uint32_t u, uint32_t count, Journal& journal, std::vector<RenameStep>& failures) {
+        auto const& unit = plan.units[u];
+        for (uint32_t k = count; k-- > 0;) {
+            auto const& s = plan.steps[unit.first + k];
+            std::string error;
+            if (!RenameNoReplace(s.to, s.from, error)) {
+                // an earlier step cannot be undone while this one stands
+                for (uint32_t j = k + 1; j-- > 0;) failures.push_back(plan.steps[unit.first + j]);
+                return;
+            }
+            Record(journal, kOpUndone, unit.first + k);
+        }
+    }
+
+    static void Pack(std::vector<uint8_t>& b, const void* p, size_t n) { b.insert(b.end(), (const uint8_t*)p, (const uint8_t*)p + n); }
+    static void PackStr(std::vector<uint8_t>& b, const IndexString& s) {
+        uint32_t n = (uint32_t)s.size();
+        Pack(b, &n, 4);
+        Pack(b, s.data(), s.size() * sizeof(IndexChar));
+    }
+
+    // Record: magic, payload length, IndexFnv of the payload, payload (op + data)
+    static void WriteRecord(Journal& j, const std::vector<uint8_t>& payload) {
+        uint32_t size = (uint32_t)payload.size();
+        uint64_t sum = IndexFnv(payload.data(), payload.size());
+        std::vector<uint8_t> rec;
+        rec.reserve(16 + payload.size());
+        Pack(rec, &kJournalMagic, 4);
+        Pack(rec, &size, 4);
+        Pack(rec, &sum, 8);
+        rec.insert(rec.end(), payload.begin(), payload.end());
+        std::lock_guard<std::mutex> lg(j.mutex);
+        j.out.write((const char*)rec.data(), (std::streamsize)rec.size());
+        j.out.flush();
+    }
+
+    static void Record(Journal& j, uint8_t op, uint32_t step) {
+        if (!j.out.is_open()) return;
+        std::vector<uint8_t> payload;
+        Pack(payload, &op, 1);
+        Pack(payload, &step, 4);
+        WriteRecord(j, payload);
+    }
+
+    void OpenJournal(Journal& j, const RenamePlan& plan) {
+        if (m_journalDir.empty() || plan.steps.empty()) return;
+        static std::atomic<uint32_t> serial{ 0 };
+        auto stamp = std::chrono::system_clock::now().time_since_epoch().count();
+        j.path = m_journalDir / (std::to_string(stamp) + "-" + std::to_string(++serial) + ".renames");
+        j.out.open(j.path, std::ios::binary | std::ios::trunc);
+        std::vector<uint8_t> payload;
+        uint8_t op = kOpPlan;
+        uint32_t units = (uint32_t)plan.units.size();
+        Pack(payload, &op, 1);
+        Pack(payload, &units, 4);
+        for (auto const& u : plan.units) {
+            Pack(payload, &u.count, 4);
+            for (uint32_t k = 0; k < u.count; ++k) {
+                PackStr(payload, plan.steps[u.first + k].from.native());
+                PackStr(payload, plan.steps[u.first + k].to.native());
+            }
+        }
+        if (j.out) WriteRecord(j, payload);
+    }
+
+    static void CloseJournal(Journal& j, bool remove) {
+        if (!j.out.is_open()) return;
+        j.out.close();
+        std::error_code ec;
+        if (remove) std::filesystem::remove(j.path, ec);
+    }
+
+    static bool ReadJournal(const std::filesystem::path& path, RenamePlan& plan, std::vector<uint8_t>& state, bool& committed) {
+        std::ifstream f(path, std::ios::binary);
+        if (!f) return false;
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        bool havePlan = false;
+        for (size_t pos = 0; data.size() - pos >= 16;) {
+            uint32_t magic, len;
+            uint64_t sum;
+            memcpy(&magic, &data[pos], 4);
+            memcpy(&len, &data[pos + 4], 4);
+            memcpy(&sum, &data[pos + 8], 8);
+            size_t p = pos + 16, end = p + len;
+            if (magic != kJournalMagic || data.size() - p < len || IndexFnv(data.data() + p, len) != sum) break;
+            pos = end;
+            auto get = [&](void* out, size_t n) { if (end - p < n) return false; memcpy(out, &data[p], n); p += n; return true; };
+            auto getStr = [&](std::filesystem::path& out) {
+                uint32_t n = 0;
+                if (!get(&n, 4) || (end - p) / sizeof(IndexChar) < n) return false;
+                out = IndexString((const IndexChar*)&data[p], n);
+                p += (size_t)n * sizeof(IndexChar);
+                return true;
+            };
+            uint8_t op = 0;
+            if (!get(&op, 1)) break;
+            if (op == kOpPlan && !havePlan) {
+                uint32_t units = 0;
+                if (!get(&units, 4)) break;
+                bool ok = true;
+                for (uint32_t u = 0; ok && u < units; ++u) {
+                    uint32_t count = 0;
+                    ok = get(&count, 4);
+                    RenamePlan::Unit unit{ (uint32_t)plan.steps.size(), count };
+                    for (uint32_t k = 0; ok && k < count; ++k) {
+                        RenameStep s;
+                        ok = getStr(s.from) && getStr(s.to);
+                        plan.steps.push_back(std::move(s));
+                    }
+                    plan.units.push_back(unit);
+                }
+                if (!ok) return false;
+                state.assign(plan.steps.size(), 0);
+                havePlan = true;
+            }
+            else if (havePlan && (op == kOpDone || op == kOpUndone)) {
+                uint32_t step = 0;
+                if (!get(&step, 4) || step >= state.size()) break;
+                state[step] = op == kOpDone ? 1 : 2;
+            }
+            else if (op == kOpCommit) committed = true;
+        }
+        return havePlan;
+    }
+};
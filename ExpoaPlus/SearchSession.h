@@ -0,0 +1,195 @@
+// SearchSession.h — search-as-you-type state for the search box (no UI types, testable anywhere)
+// - Input(): every keystroke replaces the pending request and makes the running one stale
+//   (Current(id) turns false, so its batches / slices can be dropped); Take() hands the request
+//   out once the input has been quiet for the debounce interval
+// - Commit(): Enter / search button — runs at once and is the only way into the history
+// - Each run is planned against what is already in memory: a query that narrows the displayed
+//   results filters them (RefineShown), one that narrows the complete source set (e.g. after a
+//   backspace) filters that (RefineSource); anything else is a Full search
+// - SliceFilter: filters a position list a slice at a time so a long list never blocks the caller
+// Narrowing: same folder / flags and the new text contains the old one; with fuzzy matching the
+// allowed distance must not grow (a longer needle may otherwise match names the shorter did not).
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FuzzySearch.h"
+
+// Everything that decides a result set
+struct SearchRequest {
+    std::wstring text;
+    std::wstring scope;                       // folder searched
+    bool recursive = false;
+    bool fuzzy = false;
+    bool matchCase = true;                    // substring mode
+    bool includeHidden = false;
+    int maxDistance = 0;                      // fuzzy threshold before the one-per-three-characters limit
+    bool content = false;                     // text is a full-text query over file contents (ranked)
+};
+
+enum class SearchKind {
+    Full,                                     // search from scratch
+    RefineSource,                             // filter the complete source set
+    RefineShown,                              // filter the displayed results (their order is kept)
+    Unchanged                                 // same request as the displayed results
+};
+
+struct SearchTicket {
+    uint64_t id = 0;
+    SearchKind kind = SearchKind::Full;
+    SearchRequest request;
+};
+
+class SearchSession {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit SearchSession(std::chrono::milliseconds debounce = std::chrono::milliseconds(150), size_t historySize = 25)
+        : m_debounce(debounce), m_historySize(historySize) {}
+
+    void SetDebounce(std::chrono::milliseconds d) { m_debounce = d; }
+
+    // A keystroke. Returns when the request becomes due (the UI restarts its timer for that).
+    Clock::time_point Input(SearchRequest r, Clock::time_point now) {
+        ++m_current;
+        m_pending = std::move(r);
+        m_dueAt = now + m_debounce;
+        return m_dueAt;
+    }
+
+    bool Pending() const { return m_pending.has_value(); }
+    Clock::time_point DueAt() const { return m_dueAt; }
+
+    // The pending request once it is due (or right away with force)
+    std::optional<SearchTicket> Take(Clock::time_point now, bool force = false) {
+        if (!m_pending || (!force && now < m_dueAt)) return std::nullopt;
+        SearchRequest r = std::move(*m_pending);
+        m_pending.reset();
+        return Plan(std::move(r));
+    }
+
+    // Run immediately (new folder, finished index, ...): pending input is dropped, history untouched
+    SearchTicket Run(SearchRequest r) {
+        m_pending.reset();
+        return Plan(std::move(r));
+    }
+
+    // Enter / search button: like Run, and the text goes to the front of the history
+    SearchTicket Commit(SearchRequest r) {
+        Remember(r.text);
+        return Run(std::move(r));
+    }
+
+    // Results / slices of id are still wanted
+    bool Current(uint64_t id) const { return id == m_current && !m_pending; }
+
+    // Run id has finished and its results are displayed. complete = nothing was left out (not capped,
+    // no ranking cut-off); only complete results can be narrowed later. Stale runs are ignored.
+    void Completed(uint64_t id, bool complete) {
+        if (id != m_running || id != m_current) return;
+        if (!complete) { m_shown.reset(); return; }
+        m_shown = m_runningRequest;
+        if (m_runningKind == SearchKind::Full) m_source = m_runningRequest;
+    }
+
+    // The caller holds every item for r (e.g. a finished folder listing: text empty)
+    void SetSource(SearchRequest r) { m_source = std::move(r); }
+
+    // Items changed underneath (new folder, file operations): nothing may be narrowed any more
+    void Invalidate() {
+        m_shown.reset();
+        m_source.reset();
+    }
+
+    const std::vector<std::wstring>& History() const { return m_history; }
+
+    // Does every name matching `to` also match `from`?
+    static bool Narrows(const SearchRequest& from, const SearchRequest& to) {
+        if (from.scope != to.scope || from.recursive != to.recursive || from.includeHidden != to.includeHidden) return false;
+        if (from.content || to.content) return false;   // contents are not in memory, names say nothing about them
+        if (from.text.empty()) return true;   // matches everything, whatever the mode
+        if (from.fuzzy != to.fuzzy) return false;
+        if (!from.fuzzy && from.matchCase != to.matchCase) return false;
+        if (from.fuzzy && NameMatcher<wchar_t>::AllowedDistance(to.text.size(), to.maxDistance) >
+                          NameMatcher<wchar_t>::AllowedDistance(from.text.size(), from.maxDistance)) return false;
+        if (!from.fuzzy && from.matchCase) return to.text.find(from.text) != std::wstring::npos;
+        return NameMatcher<wchar_t>(from.text, false, false, 0).Matches(to.text);
+    }
+
+private:
+    std::chrono::milliseconds m_debounce;
+    size_t m_historySize;
+    uint64_t m_current = 0;                   // id of the newest request (pending or running)
+    std::optional<SearchRequest> m_pending;
+    Clock::time_point m_dueAt{};
+    uint64_t m_running = 0;
+    SearchKind m_runningKind = SearchKind::Full;
+    SearchRequest m_runningRequest;
+    std::optional<SearchRequest> m_shown;     // complete results currently displayed
+    std::optional<SearchRequest> m_source;    // complete item set held in memory
+    std::vector<std::wstring> m_history;
+
+    static bool Same(const SearchRequest& a, const SearchRequest& b) {
+        return a.text == b.text && a.scope == b.scope && a.recursive == b.recursive && a.fuzzy == b.fuzzy &&
+               a.matchCase == b.matchCase && a.includeHidden == b.includeHidden && a.maxDistance == b.maxDistance &&
+               a.content == b.content;
+    }
+
+    SearchTicket Plan(SearchRequest r) {
+        SearchTicket t;
+        t.id = ++m_current;
+        if (m_shown && Same(*m_shown, r)) t.kind = SearchKind::Unchanged;
+        else if (m_shown && Narrows(*m_shown, r)) t.kind = SearchKind::RefineShown;
+        else if (m_source && Narrows(*m_source, r)) t.kind = SearchKind::RefineSource;
+        else t.kind = SearchKind::Full;
+        if (t.kind == SearchKind::Full) Invalidate(); // the caller is about to clear its items
+        t.request = r;
+        m_running = t.id;
+        m_runningKind = t.kind;
+        m_runningRequest = std::move(r);
+        return t;
+    }
+
+    void Remember(const std::wstring& text) {
+        if (text.empty()) return;
+        auto it = std::find(m_history.begin(), m_history.end(), text);
+        if (it != m_history.end()) m_history.erase(it);
+        m_history.insert(m_history.begin(), text);
+        if (m_history.size() > m_historySize) m_history.resize(m_historySize);
+    }
+};
+
+// Filters positions a slice at a time (keep(pos) decides); the order of the input is kept.
+class SliceFilter {
+public:
+    void Start(std::vector<uint32_t> positions) {
+        m_in = std::move(positions);
+        m_out.clear();
+        m_next = 0;
+    }
+
+    // Look at up to count more positions; true once all are done
+    template <class Keep>
+    bool Step(size_t count, Keep&& keep) {
+        size_t end = std::min(m_in.size(), m_next + count);
+        for (; m_next < end; ++m_next) if (keep(m_in[m_next])) m_out.push_back(m_in[m_next]);
+        return Done();
+    }
+
+    bool Done() const { return m_next >= m_in.size(); }
+    std::vector<uint32_t> Take() {
+        m_in.clear();
+        m_next = 0;
+        return std::move(m_out);
+    }
+
+private:
+    std::vector<uint32_t> m_in, m_out;
+    size_t m_next = 0;
+};
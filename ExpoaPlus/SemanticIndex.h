@@ -0,0 +1,695 @@
+// SemanticIndex.h — "files about X": local similarity search, no network, no GPU, no model files
+// - Features per file: words and character trigrams of the name (split at case / digit changes,
+//   weighted highest), of the parent folder and of the first 64 KB of text files; the strongest
+//   kMaxFeatures are kept (sparse, semantic.bin)
+// - Embedding: features hashed into kDim signed dimensions, sublinear tf x idf, L2-normalised,
+//   stored as int8 with one scale per file; similarity = int8 dot product (AVX2 / SSE4.1 / portable)
+// - Up to kExactLimit files every vector is scanned; above that an HNSW graph answers (top-k via heaps)
+// - Build() turns the features into matrix + graph: new files are inserted into a copy of the current
+//   graph with its idf; once the collection has drifted by a quarter it is rebuilt from scratch
+// Queries run against the last Build(); files added since are found after the next one.
+// Thread-safe; Build() is meant for a background thread and does not block queries.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "FileIndex.h"
+#include "FullTextIndex.h"
+#include "Hashing.h"
+#include "WorkPool.h"
+
+// ---- int8 dot products ----
+
+constexpr int kSemanticDim = 256;
+
+inline int32_t SemanticDotPortable(const int8_t* a, const int8_t* b) {
+    int32_t s = 0;
+    for (int i = 0; i < kSemanticDim; ++i) s += a[i] * b[i];
+    return s;
+}
+
+// Vectors hold -127..127 (never -128): |a| * sign(b, a) fits maddubs' int16 pairs without saturating
+#ifdef HASH_X86
+HASH_TARGET("avx2") inline int32_t SemanticDotAvx2(const int8_t* a, const int8_t* b) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i acc = _mm256_setzero_si256();
+    for (int i = 0; i < kSemanticDim; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i pairs = _mm256_maddubs_epi16(_mm256_abs_epi8(x), _mm256_sign_epi8(y, x));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, ones));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+HASH_TARGET("sse4.1") inline int32_t SemanticDotSse41(const int8_t* a, const int8_t* b) {
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i acc = _mm_setzero_si128();
+    for (int i = 0; i < kSemanticDim; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i pairs = _mm_maddubs_epi16(_mm_abs_epi8(x), _mm_sign_epi8(y, x));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(pairs, ones));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+    return _mm_cvtsi128_si32(acc);
+}
+#endif
+
+using SemanticDotFn = int32_t (*)(const int8_t*, const int8_t*);
+
+// Best kernel for this CPU (HashCpu flags; clear them to force the portable one)
+inline SemanticDotFn SemanticDot() {
+#ifdef HASH_X86
+    const HashCpu& cpu = HashCpu::Get();
+    if (cpu.avx2) return SemanticDotAvx2;
+    if (cpu.sse41) return SemanticDotSse41;
+#endif
+    return SemanticDotPortable;
+}
+
+// ---- features ----
+
+struct SemanticFeature {
+    uint32_t id;
+    uint16_t weight;                          // fixed point, 1/256
+};
+
+// Collects weighted features of one file or query
+class SemanticFeatures {
+public:
+    static constexpr size_t kMaxFeatures = 48;
+
+    // One word (lower-case UTF-8): the word itself plus its trigrams ("^ab", "abc", "bc$")
+    void Word(std::string_view w, float weight) {
+        if (w.empty()) return;
+        m_acc[Id(w, 1)] += weight;
+        if (w.size() < 3) return;
+        char g[3];
+        for (size_t i = 0; i < w.size(); ++i) {
+            g[0] = i ? w[i - 1] : '^';
+            g[1] = w[i];
+            g[2] = i + 1 < w.size() ? w[i + 1] : '$';
+            m_acc[Id(std::string_view(g, 3), 2)] += weight * 0.3f;
+        }
+    }
+
+    // Names: "InvoiceScan2023_final.pdf" -> invoice, scan, 2023, final (+ the extension as its own feature)
+    void Name(std::string_view name, float weight, bool withExtension) {
+        size_t dot = withExtension ? name.rfind('.') : std::string_view::npos;
+        if (dot != std::string_view::npos && dot > 0) {
+            std::string ext(name.substr(dot + 1));
+            for (auto& c : ext) if (c >= 'A' && c <= 'Z') c += 32;
+            m_acc[Id(ext, 3)] += 1.0f;
+            name = name.substr(0, dot);
+        }
+        std::string w;
+        auto flush = [&]() { Word(w, weight); w.clear(); };
+        for (size_t i = 0; i < name.size(); ++i) {
+            unsigned char c = (unsigned char)name[i], prev = i ? (unsigned char)name[i - 1] : 0;
+            bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80, digit = c >= '0' && c <= '9';
+            if (!alpha && !digit) { flush(); continue; }
+            bool upper = c >= 'A' && c <= 'Z';
+            bool prevLower = prev >= 'a' && prev <= 'z', prevDigit = prev >= '0' && prev <= '9', prevAlpha = prevLower || (prev >= 'A' && prev <= 'Z') || prev >= 0x80;
+            if ((upper && prevLower) || (digit && prevAlpha) || (alpha && c < 0x80 && prevDigit)) flush();
+            w += (char)(upper ? c + 32 : c);
+        }
+        flush();
+    }
+
+    // Running text (tf is collected, weight per occurrence)
+    void Text(const char* p, size_t n, float weight) {
+        auto add = [&](std::string_view t, uint32_t) { if (t.size() > 1 && t.size() <= 24) Word(t, weight); };
+        m_tok.Feed(p, n, add);
+        m_tok.Finish(add);
+        m_tok = FullTextTokenizer();
+    }
+
+    // Sublinear weights, strongest first, at most kMaxFeatures
+    std::vector<SemanticFeature> Take() {
+        std::vector<std::pair<float, uint32_t>> all;
+        all.reserve(m_acc.size());
+        for (auto const& kv : m_acc) all.emplace_back(kv.second > 1 ? 1 + std::log(kv.second) : kv.second, kv.first);
+        size_t n = std::min(all.size(), kMaxFeatures);
+        std::partial_sort(all.begin(), all.begin() + n, all.end(), [](auto const& a, auto const& b) { return a.first != b.first ? a.first > b.first : a.second < b.second; });
+        std::vector<SemanticFeature> out(n);
+        for (size_t i = 0; i < n; ++i) out[i] = SemanticFeature{ all[i].second, (uint16_t)std::min(65535.0f, all[i].first * 256 + 0.5f) };
+        m_acc.clear();
+        return out;
+    }
+
+private:
+    std::unordered_map<uint32_t, float> m_acc;
+    FullTextTokenizer m_tok;
+
+    static uint32_t Id(std::string_view s, uint64_t kind) { return (uint32_t)FastHash64(s.data(), s.size(), kind); }
+};
+
+// ---- HNSW graph over the rows of a matrix ----
+
+class SemanticGraph {
+public:
+    static constexpr uint32_t kM = 16, kM0 = 32;   // links per node above / on level 0
+    static constexpr size_t kEfConstruction = 100;
+
+    using Scored = std::pair<float, uint32_t>;  // similarity, row
+
+    void Reserve(uint32_t rows) {
+        m_level0.reserve((size_t)rows * (kM0 + 1));
+        m_level.reserve(rows);
+        m_upper.reserve(rows);
+    }
+    uint32_t Size() const { return (uint32_t)m_level.size(); }
+    bool Empty() const { return m_level.empty(); }
+
+    // Add row Size(); sim(a, b) between rows
+    template <class Sim>
+    void Insert(Sim&& sim) {
+        uint32_t row = Size();
+        int level = RandomLevel();
+        m_level.push_back((uint8_t)level);
+        m_level0.resize(m_level0.size() + kM0 + 1, 0);
+        m_upper.emplace_back((size_t)level * (kM + 1), 0);
+        if (m_maxLevel < 0) { m_entry = row; m_maxLevel = level; return; }
+
+        auto toRow = [&](uint32_t r) { return sim(row, r); };
+        uint32_t ep = m_entry;
+        float epSim = toRow(ep);
+        for (int l = m_maxLevel; l > level; --l) Greedy(toRow, ep, epSim, l);
+        std::vector<uint8_t> visited;
+        for (int l = std::min(level, m_maxLevel); l >= 0; --l) {
+            auto found = SearchLayer(toRow, ep, epSim, kEfConstruction, l, visited);
+            auto chosen = Select(found, l ? kM : kM0, sim);
+            Set(row, l, chosen);
+            for (auto const& c : chosen) Link(c.second, row, c.first, l, sim);
+            ep = found.front().second;
+            epSim = found.front().first;
+        }
+        if (level > m_maxLevel) { m_maxLevel = level; m_entry = row; }
+    }
+
+    // Best ef candidates for a query (simq(row)), best first
+    template <class SimQ>
+    std::vector<Scored> Search(SimQ&& simq, size_t ef) const {
+        if (m_maxLevel < 0) return {};
+        uint32_t ep = m_entry;
+        float epSim = simq(ep);
+        for (int l = m_maxLevel; l > 0; --l) Greedy(simq, ep, epSim, l);
+        std::vector<uint8_t> visited;
+        return SearchLayer(simq, ep, epSim, ef, 0, visited);
+    }
+
+private:
+    std::vector<uint32_t> m_level0;             // per row: count, kM0 links
+    std::vector<std::vector<uint32_t>> m_upper; // per row: levels 1.. (count, kM links each)
+    std::vector<uint8_t> m_level;
+    uint32_t m_entry = 0;
+    int m_maxLevel = -1;
+    std::mt19937 m_rng{ 42 };
+
+    int RandomLevel() {
+        double u = std::uniform_real_distribution<double>(1e-12, 1.0)(m_rng);
+        return std::min(15, (int)(-std::log(u) / std::log((double)kM)));
+    }
+    const uint32_t* Links(uint32_t row, int level) const {
+        return level == 0 ? &m_level0[(size_t)row * (kM0 + 1)] : &m_upper[row][(size_t)(level - 1) * (kM + 1)];
+    }
+    uint32_t* Links(uint32_t row, int level) {
+        return level == 0 ? &m_level0[(size_t)row * (kM0 + 1)] : &m_upper[row][(size_t)(level - 1) * (kM + 1)];
+    }
+    void Set(uint32_t row, int level, const std::vector<Scored>& to) {
+        uint32_t* l = Links(row, level);
+        l[0] = (uint32_t)to.size();
+        for (size_t i = 0; i < to.size(); ++i) l[i + 1] = to[i].second;
+    }
+
+    template <class SimQ>
+    void Greedy(SimQ& simq, uint32_t& ep, float& epSim, int level) const {
+        for (bool moved = true; moved;) {
+            moved = false;
+            const uint32_t* l = Links(ep, level);
+            for (uint32_t i = 1; i <= l[0]; ++i) {
+                float s = simq(l[i]);
+                if (s > epSim) { epSim = s; ep = l[i]; moved = true; }
+            }
+        }
+    }
+
+    template <class SimQ>
+    std::vector<Scored> SearchLayer(SimQ& simq, uint32_t ep, float epSim, size_t ef, int level, std::vector<uint8_t>& visited) const {
+        visited.assign(Size(), 0);
+        std::priority_queue<Scored> candidates;                                       // best on top
+        std::priority_queue<Scored, std::vector<Scored>, std::greater<Scored>> best;  // worst on top
+        visited[ep] = 1;
+        candidates.push({ epSim, ep });
+        best.push({ epSim, ep });
+        while (!candidates.empty()) {
+            Scored c = candidates.top();
+            if (best.size() >= ef && c.first < best.top().first) break;
+            candidates.pop();
+            const uint32_t* l = Links(c.second, level);
+            for (uint32_t i = 1; i <= l[0]; ++i) {
+                uint32_t n = l[i];
+                if (visited[n]) continue;
+                visited[n] = 1;
+                float s = simq(n);
+                if (best.size() < ef || s > best.top().first) {
+                    candidates.push({ s, n });
+                    best.push({ s, n });
+                    if (best.size() > ef) best.pop();
+                }
+            }
+        }
+        std::vector<Scored> out;
+        out.reserve(best.size());
+        for (; !best.empty(); best.pop()) out.push_back(best.top());
+        std::reverse(out.begin(), out.end());
+        return out;
+    }
+
+    // Keep a candidate only if it is closer to the base than to every one already kept (spreads the
+    // links over directions instead of one dense cluster)
+    template <class Sim>
+    static std::vector<Scored> Select(const std::vector<Scored>& sorted, uint32_t m, Sim& sim) {
+        std::vector<Scored> kept;
+        for (auto const& c : sorted) {
+            if (kept.size() >= m) break;
+            bool good = true;
+            for (auto const& k : kept) if (sim(c.second, k.second) > c.first) { good = false; break; }
+            if (good) kept.push_back(c);
+        }
+        return kept;
+    }
+
+    template <class Sim>
+    void Link(uint32_t from, uint32_t to, float s, int level, Sim& sim) {
+        uint32_t* l = Links(from, level);
+        uint32_t cap = level ? kM : kM0;
+        if (l[0] < cap) { l[++l[0]] = to; return; }
+        std::vector<Scored> all{ { s, to } };
+        for (uint32_t i = 1; i <= l[0]; ++i) all.push_back({ sim(from, l[i]), l[i] });
+        std::sort(all.begin(), all.end(), std::greater<Scored>());
+        Set(from, level, Select(all, cap, sim));
+    }
+};
+
+// ---- index ----
+
+struct SemanticHit {
+    IndexString path;
+    uint64_t size = 0, mtime = 0;
+    float score = 0;                          // cosine similarity, 0..1
+};
+
+struct SemanticQueryOptions {
+    size_t topK = 20;
+    size_t ef = 96;                           // HNSW candidate list (recall vs. time)
+    bool exact = false;                       // scan every vector even if a graph exists
+    float minScore = 0.05f;
+};
+
+struct SemanticStats {
+    uint64_t files = 0;                       // live files with features
+    uint64_t rows = 0;                        // vectors in the last build
+    bool graph = false;
+};
+
+class SemanticIndex {
+public:
+    static constexpr uint32_t kExactLimit = 50000;  // below: scanning all vectors takes about a millisecond
+    static constexpr size_t kTextBytes = 64 * 1024;
+
+    ~SemanticIndex() { Close(); }
+
+    bool Open(const std::filesystem::path& dir) {
+        std::unique_lock<std::shared_mutex> lk(m_mutex);
+        m_file = dir / "semantic.bin";
+        m_docs.clear();
+        m_slots.clear();
+        m_df.clear();
+        m_live = 0;
+        m_space.reset();
+        m_dirty = false;
+        std::ifstream f(m_file, std::ios::binary);
+        if (!f) return true;
+        char magic[4];
+        uint32_t version = 0, count = 0;
+        f.read(magic, 4);
+        f.read((char*)&version, 4);
+        f.read((char*)&count, 4);
+        if (!f || memcmp(magic, "XPSE", 4) != 0 || version != kVersion) return false;
+        for (uint32_t i = 0; i < count && f; ++i) {
+            Doc d;
+            uint32_t pathLen = 0, n = 0;
+            f.read((char*)&pathLen, 4);
+            d.path.resize(pathLen);
+            f.read(&d.path[0], pathLen);
+            f.read((char*)&d.size, 8);
+            f.read((char*)&d.mtime, 8);
+            f.read((char*)&n, 4);
+            if (!f || n > SemanticFeatures::kMaxFeatures) break;
+            d.features.resize(n);
+            for (auto& ft : d.features) { f.read((char*)&ft.id, 4); f.read((char*)&ft.weight, 2); }
+            if (!f) break;
+            Insert(std::move(d));
+        }
+        m_dirty = false;
+        return true;
+    }
+
+    bool Save() {
+        std::vector<char> buf;
+        {
+            std::shared_lock<std::shared_mutex> lk(m_mutex);
+            if (!m_dirty || m_file.empty()) return true;
+            auto put = [&](const void* p, size_t n) { buf.insert(buf.end(), (const char*)p, (const char*)p + n); };
+            uint32_t version = kVersion, count = (uint32_t)m_live;
+            put("XPSE", 4);
+            put(&version, 4);
+            put(&count, 4);
+            for (auto const& d : m_docs) {
+                if (!d.live) continue;
+                uint32_t pathLen = (uint32_t)d.path.size(), n = (uint32_t)d.features.size();
+                put(&pathLen, 4);
+                put(d.path.data(), pathLen);
+                put(&d.size, 8);
+                put(&d.mtime, 8);
+                put(&n, 4);
+                for (auto const& ft : d.features) { put(&ft.id, 4); put(&ft.weight, 2); }
+            }
+        }
+        std::filesystem::path tmp = m_file;
+        tmp += ".tmp";
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            f.write(buf.data(), (std::streamsize)buf.size());
+            if (!f) return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, m_file, ec);
+        if (ec) return false;
+        std::unique_lock<std::shared_mutex> lk(m_mutex);
+        m_dirty = false;                      // changes made while writing are lost until the next Save
+        return true;
+    }
+
+    void Close() {
+        m_stopBuild.store(true);
+        std::lock_guard<std::mutex> bg(m_buildMutex); // a running Build() gives up
+        m_stopBuild.store(false);
+        Save();
+        std::unique_lock<std::shared_mutex> lk(m_mutex);
+        m_docs.clear();
+        m_slots.clear();
+        m_df.clear();
+        m_space.reset();
+        m_file.clear();
+    }
+
+    // Name features for every file, content features for text files (any thread)
+    void AddFile(const std::filesystem::path& path, uint64_t size, uint64_t mtime) {
+        SemanticFeatures f;
+        f.Name(FullTextUtf8(path.filename().native()), 3.0f, true);
+        f.Name(FullTextUtf8(path.parent_path().filename().native()), 1.5f, false);
+        if (Text(path)) {
+            HashReader r;
+            std::vector<char> buf(kTextBytes);
+            int64_t got = r.Open(path) ? r.ReadAt(0, buf.data(), buf.size()) : -1;
+            if (got > 0 && !memchr(buf.data(), 0, (size_t)std::min<int64_t>(got, 8192))) f.Text(buf.data(), (size_t)got, 1.0f);
+        }
+        Add(FullTextUtf8(path.native()), size, mtime, f.Take());
+    }
+    void AddText(IndexStringView path, uint64_t size, uint64_t mtime, std::string_view text) {
+        SemanticFeatures f;
+        std::filesystem::path p(path);
+        f.Name(FullTextUtf8(p.filename().native()), 3.0f, true);
+        f.Name(FullTextUtf8(p.parent_path().filename().native()), 1.5f, false);
+        f.Text(text.data(), text.size(), 1.0f);
+        Add(FullTextUtf8(path), size, mtime, f.Take());
+    }
+
+    void Remove(IndexStringView path) {
+        std::unique_lock<std::shared_mutex> lk(m_mutex);
+        auto it = m_slots.find(Key(FullTextUtf8(path)));
+        if (it == m_slots.end()) return;
+        Kill(it->second);
+        m_slots.erase(it);
+    }
+    bool Contains(IndexStringView path, uint64_t size, uint64_t mtime) const {
+        std::shared_lock<std::shared_mutex> lk(m_mutex);
+        auto it = m_slots.find(Key(FullTextUtf8(path)));
+        return it != m_slots.end() && m_docs[it->second].size == size && m_docs[it->second].mtime == mtime;
+    }
+    void RemoveIf(const std::function<bool(IndexStringView)>& gone) {
+        std::vector<std::pair<uint64_t, IndexString>> paths;
+        {
+            std::shared_lock<std::shared_mutex> lk(m_mutex);
+            for (auto const& kv : m_slots) paths.emplace_back(kv.first, FullTextNative(m_docs[kv.second].path));
+        }
+        std::unique_lock<std::shared_mutex> lk(m_mutex);
+        for (auto const& p : paths) {
+            if (!gone(p.second)) continue;
+            auto it = m_slots.find(p.first);
+            if (it == m_slots.end()) continue;
+            Kill(it->second);
+            m_slots.erase(it);
+        }
+    }
+
+    // Bring matrix (and graph) up to date. Cheap when nothing changed; call on a background thread.
+    void Build() {
+        std::lock_guard<std::mutex> bg(m_buildMutex);
+        std::shared_ptr<const Space> old;
+        std::vector<uint32_t> fresh;
+        auto space = std::make_shared<Space>();
+        {
+            std::shared_lock<std::shared_mutex> lk(m_mutex);
+            old = m_space;
+            if (old && old->slotCount == m_docs.size()) {
+                if ((double)(old->rows - Covered(*old)) <= 0.25 * old->rows) return; // nothing new, few removed
+                old.reset();
+            }
+            if (old && ((double)(m_docs.size() - old->slotCount) > 0.25 * old->rows || (double)(old->rows - Covered(*old)) > 0.25 * old->rows ||
+                        (!old->useGraph && m_live > kExactLimit))) old.reset();
+            if (old) *space = *old;           // copy, then insert the new files with its idf
+            else {
+                space->df = m_df;
+                space->docCount = m_live;
+                space->useGraph = m_live > kExactLimit;
+            }
+            for (size_t s = old ? old->slotCount : 0; s < m_docs.size(); ++s) if (m_docs[s].live) fresh.push_back((uint32_t)s);
+            space->slotCount = m_docs.size();
+        }
+        SemanticDotFn dot = SemanticDot();
+        auto sim = [&](uint32_t a, uint32_t b) { return dot(space->Row(a), space->Row(b)) * space->scale[a] * space->scale[b]; };
+        if (space->useGraph) space->graph.Reserve((uint32_t)(space->rows + fresh.size()));
+        for (uint32_t s : fresh) {
+            if (m_stopBuild.load(std::memory_order_relaxed)) return;
+            std::vector<SemanticFeature> features;
+            {
+                std::shared_lock<std::shared_mutex> lk(m_mutex);
+                if (!m_docs[s].live) continue;
+                features = m_docs[s].features;
+            }
+            space->Append(s, features);
+            if (space->useGraph) space->graph.Insert(sim);
+        }
+        std::unique_lock<std::shared_mutex> lk(m_mutex);
+        m_space = std::move(space);
+    }
+
+    std::vector<SemanticHit> Query(IndexStringView text, const SemanticQueryOptions& opt = SemanticQueryOptions(), WorkPool* pool = nullptr) const {
+        std::shared_lock<std::shared_mutex> lk(m_mutex);
+        std::vector<SemanticHit> out;
+        if (!m_space || m_space->rows == 0) return out;
+        const Space& sp = *m_space;
+        SemanticFeatures f;
+        std::string q = FullTextUtf8(text);
+        f.Name(q, 1.0f, false);
+        std::vector<int8_t> qv(kSemanticDim);
+        float qs = 0;
+        if (!sp.Embed(f.Take(), qv.data(), qs)) return out;
+        SemanticDotFn dot = SemanticDot();
+        auto simq = [&](uint32_t row) { return dot(qv.data(), sp.Row(row)) * qs * sp.scale[row]; };
+        size_t want = opt.topK + 16;          // room for files removed since the build
+
+        std::vector<SemanticGraph::Scored> best;
+        if (sp.graph.Empty() || opt.exact) best = Scan(sp, simq, want, pool);
+        else best = sp.graph.Search(simq, std::max(opt.ef, want));
+        for (auto const& b : best) {
+            if (out.size() >= opt.topK || b.first < opt.minScore) break;
+            const Doc& d = m_docs[sp.slot[b.second]];
+            if (!d.live) continue;
+            out.push_back(SemanticHit{ FullTextNative(d.path), d.size, d.mtime, b.first });
+        }
+        return out;
+    }
+
+    SemanticStats Stats() const {
+        std::shared_lock<std::shared_mutex> lk(m_mutex);
+        SemanticStats s;
+        s.files = m_live;
+        s.rows = m_space ? m_space->rows : 0;
+        s.graph = m_space && !m_space->graph.Empty();
+        return s;
+    }
+
+private:
+    static constexpr uint32_t kVersion = 1;
+
+    struct Doc {
+        std::string path;                     // UTF-8
+        uint64_t size = 0, mtime = 0;
+        std::vector<SemanticFeature> features;
+        bool live = true;
+    };
+
+    // Matrix + graph of one build; immutable once published
+    struct Space {
+        std::unordered_map<uint32_t, uint32_t> df; // idf snapshot the vectors were made with
+        uint64_t docCount = 0;
+        std::vector<int8_t> vectors;          // rows x kSemanticDim
+        std::vector<float> scale;
+        std::vector<uint32_t> slot;           // row -> doc slot
+        uint32_t rows = 0;
+        size_t slotCount = 0;                 // doc slots looked at
+        bool useGraph = false;
+        SemanticGraph graph;
+
+        const int8_t* Row(uint32_t r) const { return &vectors[(size_t)r * kSemanticDim]; }
+
+        // tf x idf into signed hashed dimensions, L2-normalised, int8; false = nothing to compare
+        bool Embed(const std::vector<SemanticFeature>& features, int8_t* out, float& outScale) const {
+            float v[kSemanticDim] = {};
+            for (auto const& ft : features) {
+                auto it = df.find(ft.id);
+                double idf = std::log((docCount + 1.0) / ((it == df.end() ? 0 : it->second) + 1.0)) + 1.0;
+                float w = (float)(ft.weight / 256.0 * idf);
+                v[ft.id % kSemanticDim] += (ft.id >> 31) ? -w : w;
+            }
+            float norm = 0, peak = 0;
+            for (float x : v) { norm += x * x; peak = std::max(peak, std::fabs(x)); }
+            if (norm <= 0) { memset(out, 0, kSemanticDim); outScale = 0; return false; }
+            norm = std::sqrt(norm);
+            float q = 127.0f / peak;
+            for (int i = 0; i < kSemanticDim; ++i) out[i] = (int8_t)std::lround(v[i] * q);
+            outScale = 1.0f / (q * norm);
+            return true;
+        }
+        void Append(uint32_t docSlot, const std::vector<SemanticFeature>& features) {
+            vectors.resize(vectors.size() + kSemanticDim);
+            float s = 0;
+            Embed(features, &vectors[(size_t)rows * kSemanticDim], s);
+            scale.push_back(s);
+            slot.push_back(docSlot);
+            ++rows;
+        }
+    };
+
+    mutable std::shared_mutex m_mutex;        // docs, slots, df, m_space pointer
+    std::mutex m_buildMutex;                  // one Build() at a time
+    std::atomic<bool> m_stopBuild{ false };
+    std::filesystem::path m_file;
+    std::vector<Doc> m_docs;                  // slots are never reused while open
+    std::unordered_map<uint64_t, uint32_t> m_slots; // path key -> live slot
+    std::unordered_map<uint32_t, uint32_t> m_df;
+    uint64_t m_live = 0;
+    bool m_dirty = false;
+    std::shared_ptr<const Space> m_space;
+
+    static uint64_t Key(std::string_view utf8) { return FastHash64(utf8.data(), utf8.size()); }
+
+    static bool Text(const std::filesystem::path& path) {
+        static const std::vector<std::string> exts = FullTextOptions().extensions;
+        std::string ext = FullTextUtf8(path.extension().native());
+        for (auto& c : ext) if (c >= 'A' && c <= 'Z') c += 32;
+        return std::find(exts.begin(), exts.end(), ext) != exts.end();
+    }
+
+    void Add(std::string path, uint64_t size, uint64_t mtime, std::vector<SemanticFeature> features) {
+        Doc d;
+        d.path = std::move(path);
+        d.size = size;
+        d.mtime = mtime;
+        d.features = std::move(features);
+        std::unique_lock<std::shared_mutex> lk(m_mutex);
+        Insert(std::move(d));
+        m_dirty = true;
+    }
+    // under the exclusive lock
+    void Insert(Doc d) {
+        uint64_t key = Key(d.path);
+        auto it = m_slots.find(key);
+        if (it != m_slots.end()) Kill(it->second);
+        for (auto const& ft : d.features) ++m_df[ft.id];
+        m_slots[key] = (uint32_t)m_docs.size();
+        m_docs.push_back(std::move(d));
+        ++m_live;
+    }
+    void Kill(uint32_t slot) {
+        Doc& d = m_docs[slot];
+        if (!d.live) return;
+        for (auto const& ft : d.features) {
+            auto it = m_df.find(ft.id);
+            if (it != m_df.end() && --it->second == 0) m_df.erase(it);
+        }
+        d.live = false;
+        d.features = std::vector<SemanticFeature>();
+        --m_live;
+        m_dirty = true;
+    }
+    // rows of a build whose file is still there (shared lock held)
+    uint64_t Covered(const Space& sp) const {
+        uint64_t n = 0;
+        for (uint32_t r = 0; r < sp.rows; ++r) n += m_docs[sp.slot[r]].live;
+        return n;
+    }
+
+    template <class SimQ>
+    static std::vector<SemanticGraph::Scored> Scan(const Space& sp, SimQ& simq, size_t k, WorkPool* pool) {
+        using Scored = SemanticGraph::Scored;
+        auto range = [&](uint32_t from, uint32_t to, std::vector<Scored>& heap) {
+            for (uint32_t r = from; r < to; ++r) {
+                float s = simq(r);
+                if (heap.size() < k) { heap.push_back({ s, r }); std::push_heap(heap.begin(), heap.end(), std::greater<Scored>()); }
+                else if (s > heap.front().first) {
+                    std::pop_heap(heap.begin(), heap.end(), std::greater<Scored>());
+                    heap.back() = { s, r };
+                    std::push_heap(heap.begin(), heap.end(), std::greater<Scored>());
+                }
+            }
+        };
+        std::vector<Scored> best;
+        if (!pool || pool->Size() < 2 || sp.rows < 50000) range(0, sp.rows, best);
+        else {
+            uint32_t parts = pool->Size() * 4, step = (sp.rows + parts - 1) / parts;
+            std::vector<std::vector<Scored>> heaps(parts);
+            for (uint32_t p = 0; p < parts; ++p)
+                pool->Submit([&, p]() { range(std::min(sp.rows, p * step), std::min(sp.rows, (p + 1) * step), heaps[p]); });
+            pool->WaitIdle();
+            for (auto& h : heaps) best.insert(best.end(), h.begin(), h.end());
+        }
+        std::sort(best.begin(), best.end(), std::greater<Scored>());
+        if (best.size() > k) best.resize(k);
+        return best;
+    }
+};
@@ -0,0 +1,321 @@
+// SortKeys.h — ordering of file lists by collation keys computed once per item
+// - Name key: case-folded (FuzzyFold) with natural numbers: a run of ASCII digits becomes
+//   marker, digit count, digits without leading zeros — "file2" < "file10", "a 7" < "a 07x";
+//   compared as UTF-16 code units
+// - Type: id of the folded extension; ids are ranked alphabetically when needed, so a comparison
+//   is two array reads. Size / date / folder flag sit in their own arrays (no FileItem is touched)
+// - Sorting permutes a position list. Keys are compared in SortSpec order, the position breaks the
+//   remaining ties, so every order is stable and the same input always gives the same output.
+// - Sort(): the first key and the first name units are packed next to each position (16 bytes of
+//   key per entry) and sorted on their own; runs that still tie are refined with the next eight
+//   name units, and only what ties after that reads the tables
+// - Large lists: chunks sorted on a WorkPool, merged pairwise in parallel, tied runs refined in parallel
+// - Insert(): merges new positions into a sorted list (binary search per new item, one pass of
+//   copies), so a list that grows batch by batch stays sorted without sorting it again
+// Not thread-safe; owned by the UI thread next to the item vector it describes.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "FuzzySearch.h"
+#include "WorkPool.h"
+
+enum class SortField : uint8_t { Name, Type, Size, Date };
+
+struct SortOrder {
+    SortField field = SortField::Name;
+    bool ascending = true;
+};
+
+struct SortSpec {
+    std::vector<SortOrder> keys;              // compared in this order
+    bool foldersFirst = false;
+};
+
+class SortKeyTable {
+public:
+    static constexpr size_t kParallelMin = 1 << 16;   // smaller lists: one std::sort
+    static constexpr wchar_t kDigits = L'0';          // marker of a number run (sorts between punctuation and letters)
+
+    void Clear() {
+        m_units.clear();
+        m_off.clear();
+        m_len.clear();
+        m_prefix.clear();
+        m_ext.clear();
+        m_size.clear();
+        m_mtime.clear();
+        m_folder.clear();
+        m_extIds.clear();
+        m_extNames.clear();
+        m_extRank.clear();
+    }
+    size_t Size() const { return m_off.size(); }
+
+    // Keys of the next item (position Size())
+    void Add(std::wstring_view name, bool isFolder, uint64_t size, uint64_t mtime) {
+        uint32_t off = (uint32_t)m_units.size();
+        AppendKey(name);
+        m_off.push_back(off);
+        m_len.push_back((uint32_t)(m_units.size() - off));
+        m_prefix.push_back(Units((uint32_t)m_off.size() - 1, 0));
+        m_ext.push_back(ExtensionId(name));
+        m_size.push_back(size);
+        m_mtime.push_back(mtime);
+        m_folder.push_back(isFolder ? 1 : 0);
+    }
+
+    bool Less(uint32_t a, uint32_t b, const SortSpec& spec) const {
+        if (spec.foldersFirst && m_folder[a] != m_folder[b]) return m_folder[a] > m_folder[b];
+        for (auto const& k : spec.keys) {
+            int c = Compare(a, b, k.field);
+            if (c) return k.ascending ? c < 0 : c > 0;
+        }
+        return a < b;
+    }
+
+    bool IsSorted(const std::vector<uint32_t>& view, const SortSpec& spec) {
+        RankExtensions();
+        for (size_t i = 1; i < view.size(); ++i)
+            if (Less(view[i], view[i - 1], spec)) return false;
+        return true;
+    }
+
+    // Sort positions (all < Size()); pool: split large lists across its workers
+    void Sort(std::vector<uint32_t>& view, const SortSpec& spec, WorkPool* pool = nullptr) {
+        RankExtensions();
+        // The first key and the start of the name are copied next to each position and sorted on
+        // their own, so comparisons stay inside the array being sorted. Runs that tie on them are
+        // then ordered by the next name units (Refine) and finally by the tables.
+        std::vector<Entry> entries(view.size());
+        for (size_t i = 0; i < view.size(); ++i) entries[i] = MakeEntry(view[i], spec);
+        size_t n = entries.size();
+        size_t parts = pool ? std::min<size_t>(pool->Size(), n / (kParallelMin / 4)) : 1;
+        if (n < kParallelMin || parts < 2) {
+            std::sort(entries.begin(), entries.end(), KeyLess);
+            Refine(entries.data(), entries.data() + n, NameFrom(spec), spec);
+        }
+        else {
+            std::vector<size_t> bounds;
+            for (size_t p = 0; p <= parts; ++p) bounds.push_back(n * p / parts);
+            for (size_t p = 0; p < parts; ++p)
+                pool->Submit([&, p]() { std::sort(entries.begin() + bounds[p], entries.begin() + bounds[p + 1], KeyLess); });
+            pool->WaitIdle();
+            // merge neighbouring runs until one is left
+            std::vector<Entry> buf(n);
+            while (bounds.size() > 2) {
+                std::vector<size_t> next;
+                for (size_t p = 0; p + 1 < bounds.size(); p += 2) {
+                    next.push_back(bounds[p]);
+                    size_t lo = bounds[p], mid = bounds[p + 1], hi = p + 2 < bounds.size() ? bounds[p + 2] : mid;
+                    pool->Submit([&, lo, mid, hi]() {   // odd run out (mid == hi): copied as it is
+                        std::merge(entries.begin() + lo, entries.begin() + mid, entries.begin() + mid, entries.begin() + hi, buf.begin() + lo, KeyLess);
+                    });
+                }
+                next.push_back(n);
+                pool->WaitIdle();
+                entries.swap(buf);
+                bounds.swap(next);
+            }
+            // ties never cross a cut placed between two different keys
+            size_t lo = 0;
+            for (size_t p = 1; p <= parts; ++p) {
+                size_t hi = p == parts ? n : n * p / parts;
+                while (hi < n && hi > lo && !KeyLess(entries[hi - 1], entries[hi])) ++hi;
+                if (hi <= lo) continue;
+                pool->Submit([&, lo, hi]() { Refine(entries.data() + lo, entries.data() + hi, NameFrom(spec), spec); });
+                lo = hi;
+            }
+            pool->WaitIdle();
+        }
+        for (size_t i = 0; i < n; ++i) view[i] = entries[i].pos;
+    }
+
+    // view is sorted by spec; add fresh (positions not in view) at their places
+    void Insert(std::vector<uint32_t>& view, std::vector<uint32_t> fresh, const SortSpec& spec) {
+        if (fresh.empty()) return;
+        RankExtensions();
+        auto less = [this, &spec](uint32_t a, uint32_t b) { return Less(a, b, spec); };
+        std::sort(fresh.begin(), fresh.end(), less);
+        if (view.empty() || !less(fresh.front(), view.back())) {       // typical for a sorted enumeration: append
+            view.insert(view.end(), fresh.begin(), fresh.end());
+            return;
+        }
+        std::vector<uint32_t> out;
+        out.reserve(view.size() + fresh.size());
+        auto from = view.begin();
+        for (uint32_t f : fresh) {
+            auto at = std::upper_bound(from, view.end(), f, less);
+            out.insert(out.end(), from, at);
+            out.push_back(f);
+            from = at;
+        }
+        out.insert(out.end(), from, view.end());
+        view.swap(out);
+    }
+
+private:
+    struct Entry {
+        uint64_t key, key2;                   // first sort key (and start of the name), already in sort direction
+        uint32_t pos;
+        uint32_t group;                       // 0 = folder when folders come first
+    };
+
+    std::vector<wchar_t> m_units;             // all name keys back to back
+    std::vector<uint32_t> m_off, m_len;
+    std::vector<uint64_t> m_prefix;           // first four key units, 16 bits each
+    std::vector<uint32_t> m_ext;              // extension id
+    std::vector<uint64_t> m_size, m_mtime;
+    std::vector<uint8_t> m_folder;
+    std::unordered_map<std::wstring, uint32_t> m_extIds;
+    std::vector<std::wstring> m_extNames;
+    std::vector<uint32_t> m_extRank;          // id -> alphabetical rank; shorter than m_extNames = stale
+
+    void AppendKey(std::wstring_view name) {
+        for (size_t i = 0; i < name.size();) {
+            wchar_t c = name[i];
+            if (c < L'0' || c > L'9') {
+                uint32_t u = (uint32_t)FuzzyFold(c);
+                if (u > 0xFFFF) {                     // 32-bit wchar_t: as UTF-16, so keys fit 16 bits and order as on Windows
+                    m_units.push_back((wchar_t)(0xD800 + ((u - 0x10000) >> 10)));
+                    u = 0xDC00 + ((u - 0x10000) & 0x3FF);
+                }
+                m_units.push_back((wchar_t)u);
+                ++i;
+                continue;
+            }
+            size_t start = i;
+            while (i < name.size() && name[i] >= L'0' && name[i] <= L'9') ++i;
+            size_t first = start;
+            while (first + 1 < i && name[first] == L'0') ++first;  // "007" -> "7", "000" -> "0"
+            m_units.push_back(kDigits);
+            m_units.push_back((wchar_t)(i - first));
+            m_units.insert(m_units.end(), name.begin() + first, name.begin() + i);
+        }
+    }
+
+    uint32_t ExtensionId(std::wstring_view name) {
+        size_t dot = name.find_last_of(L'.');
+        std::wstring ext;
+        if (dot != std::wstring_view::npos && dot > 0)
+            for (wchar_t c : name.substr(dot + 1)) ext.push_back(FuzzyFold(c));
+        auto it = m_extIds.find(ext);
+        if (it != m_extIds.end()) return it->second;
+        uint32_t id = (uint32_t)m_extNames.size();
+        m_extIds.emplace(ext, id);
+        m_extNames.push_back(std::move(ext));
+        return id;
+    }
+
+    void RankExtensions() {
+        if (m_extRank.size() == m_extNames.size()) return;
+        std::vector<uint32_t> ids(m_extNames.size());
+        for (uint32_t i = 0; i < ids.size(); ++i) ids[i] = i;
+        std::sort(ids.begin(), ids.end(), [this](uint32_t a, uint32_t b) { return m_extNames[a] < m_extNames[b]; });
+        m_extRank.assign(ids.size(), 0);
+        for (uint32_t r = 0; r < ids.size(); ++r) m_extRank[ids[r]] = r;
+    }
+
+    // Four key units from unit `from` on, 16 bits each (zero past the end)
+    uint64_t Units(uint32_t pos, uint32_t from) const {
+        uint64_t v = 0;
+        for (uint32_t i = from; i < from + 4; ++i) {
+            uint64_t u = i < m_len[pos] ? (uint64_t)std::min<uint32_t>((uint32_t)m_units[m_off[pos] + i], 0xFFFF) : 0;
+            v = v << 16 | u;
+        }
+        return v;
+    }
+
+    Entry MakeEntry(uint32_t pos, const SortSpec& spec) const {
+        Entry e{ 0, 0, pos, spec.foldersFirst && !m_folder[pos] ? 1u : 0u };
+        if (spec.keys.empty()) return e;
+        auto const& k = spec.keys[0];
+        bool nameNext = spec.keys.size() > 1 && spec.keys[1].field == SortField::Name && spec.keys[1].ascending == k.ascending;
+        switch (k.field) {
+        case SortField::Name: e.key = m_prefix[pos]; e.key2 = Units(pos, 4); break;
+        case SortField::Size: e.key = m_size[pos]; e.key2 = nameNext ? m_prefix[pos] : 0; break;
+        case SortField::Date: e.key = m_mtime[pos]; e.key2 = nameNext ? m_prefix[pos] : 0; break;
+        case SortField::Type:
+            // rank in the upper half, the name continues below it when it is the next key
+            e.key = (uint64_t)m_extRank[m_ext[pos]] << 32;
+            if (nameNext) {
+                e.key |= m_prefix[pos] >> 32;
+                e.key2 = Units(pos, 2);
+            }
+            break;
+        }
+        if (!k.ascending) {
+            e.key = ~e.key;
+            e.key2 = ~e.key2;
+        }
+        return e;
+    }
+
+    static bool KeyLess(const Entry& a, const Entry& b) {
+        if (a.group != b.group) return a.group < b.group;
+        if (a.key != b.key) return a.key < b.key;
+        return a.key2 < b.key2;
+    }
+
+    // First name unit not yet held in key / key2; kNoName: the name does not continue them
+    static constexpr uint32_t kNoName = ~0u;
+    static uint32_t NameFrom(const SortSpec& spec) {
+        if (spec.keys.empty()) return kNoName;
+        auto const& k = spec.keys[0];
+        if (k.field == SortField::Name) return 8;
+        if (spec.keys.size() < 2 || spec.keys[1].field != SortField::Name || spec.keys[1].ascending != k.ascending) return kNoName;
+        return k.field == SortField::Type ? 6 : 4;
+    }
+
+    // [first, last) is sorted by KeyLess; order each run of equal keys by the name from unit `from` on
+    void Refine(Entry* first, Entry* last, uint32_t from, const SortSpec& spec) {
+        auto full = [this, &spec](const Entry& a, const Entry& b) { return Less(a.pos, b.pos, spec); };
+        bool ascending = spec.keys.empty() || spec.keys[0].ascending;
+        for (Entry* run = first; run != last;) {
+            Entry* end = run + 1;
+            while (end != last && !KeyLess(*run, *end)) ++end;
+            size_t count = (size_t)(end - run);
+            if (count > 16 && from != kNoName) {
+                bool more = false;
+                for (Entry* e = run; e != end; ++e) {
+                    more |= m_len[e->pos] > from;
+                    e->key = Units(e->pos, from);
+                    e->key2 = Units(e->pos, from + 4);
+                    if (!ascending) {
+                        e->key = ~e->key;
+                        e->key2 = ~e->key2;
+                    }
+                }
+                if (more) {
+                    std::sort(run, end, KeyLess);
+                    Refine(run, end, from + 8, spec);
+                }
+                else std::sort(run, end, full);             // same name up to case / leading zeros
+            }
+            else if (count > 1) std::sort(run, end, full);
+            run = end;
+        }
+    }
+
+    int CompareNames(uint32_t a, uint32_t b) const {
+        if (m_prefix[a] != m_prefix[b]) return m_prefix[a] < m_prefix[b] ? -1 : 1;
+        std::wstring_view x(m_units.data() + m_off[a], m_len[a]), y(m_units.data() + m_off[b], m_len[b]);
+        int c = x.compare(y);
+        return c < 0 ? -1 : c > 0;
+    }
+
+    int Compare(uint32_t a, uint32_t b, SortField f) const {
+        switch (f) {
+        case SortField::Name: return CompareNames(a, b);
+        case SortField::Type: return m_extRank[m_ext[a]] < m_extRank[m_ext[b]] ? -1 : m_extRank[m_ext[a]] > m_extRank[m_ext[b]];
+        case SortField::Size: return m_size[a] < m_size[b] ? -1 : m_size[a] > m_size[b];
+        case SortField::Date: return m_mtime[a] < m_mtime[b] ? -1 : m_mtime[a] > m_mtime[b];
+        }
+        return 0;
+    }
+};
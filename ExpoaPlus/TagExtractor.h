@@ -0,0 +1,488 @@
+// TagExtractor.h — keywords ("tags") of a text file, read as a stream with constant memory
+// - Reads at most maxBytes in chunks of kChunk into one reused buffer; UTF-8 (BOM optional) and
+//   UTF-16 LE/BE (BOM) text, binary files (NUL in the first 8 KB) give no tags
+// - Tokens: SSE2 fast path over 16 ASCII bytes at a time (letters / digits, lower-cased); any chunk
+//   with non-ASCII bytes goes through a UTF-8 decoder (Latin-1 / Latin Extended-A / Greek / Cyrillic
+//   lower-cased, Unicode punctuation and spaces separate)
+// - Stopwords (English, German, French, Spanish), tokens without letters and tokens shorter than
+//   minChars are dropped; a stopword is looked up once per file, then it sits in the table
+// - Counts in a fixed table of kMaxTerms terms; when it is full, Misra-Gries: every count drops by
+//   one and terms at zero leave, so frequent terms survive any amount of text
+// - Ranking: a bounded min-heap keeps the kCandidates most frequent terms; with a corpus (document
+//   frequencies, e.g. FullTextIndex::DocFrequencies) they are re-ranked by (1 + ln tf) x idf
+// One object per thread; reuse it, the table and buffers are allocated once.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FullTextIndex.h"
+#include "Hashing.h"
+
+// Corpus statistics for idf: fills df[i] = documents containing terms[i] (tokens as FullTextTokenizer
+// makes them), returns the number of documents (0 = no corpus yet)
+using TagCorpusFn = std::function<uint64_t(const std::vector<std::string_view>& terms, uint32_t* df)>;
+
+struct TagOptions {
+    uint64_t maxBytes = 1 << 20;              // prefix read per file; later text rarely changes the tags
+    size_t minChars = 3;
+    uint64_t minCorpusDocs = 50;              // fewer documents: idf is noise, rank by frequency only
+    std::vector<std::string> extensions = FullTextOptions().extensions; // empty = every file
+};
+
+struct TagTerm {
+    std::string text;                         // UTF-8, lower case
+    uint32_t count = 0;                       // occurrences (lower bound once the table overflowed)
+    float score = 0;
+};
+
+class TagExtractor {
+public:
+    static constexpr size_t kChunk = 64 * 1024;
+    static constexpr size_t kMaxTermBytes = 32;   // longer tokens (hashes, base64) are no tags
+    static constexpr uint32_t kMaxTerms = 4096;
+    static constexpr size_t kCandidates = 64;
+
+    explicit TagExtractor(TagOptions opt = TagOptions())
+        : m_opt(std::move(opt)), m_slots(new Slot[kBuckets]()), m_text(new char[kMaxTerms * kMaxTermBytes]),
+          m_chunk(new char[kChunk]), m_utf8(new char[kChunk / 2 * 3 + 4]) {
+        m_used.reserve(kBuckets);
+        m_free.reserve(kMaxTerms);
+        Begin();
+    }
+
+    // Tags of a file (empty: unreadable, binary or not a text extension)
+    std::vector<TagTerm> File(const std::filesystem::path& path, size_t topN, const TagCorpusFn& corpus = nullptr) {
+        Begin();
+        if (!Wanted(path)) return {};
+        HashReader r;
+        if (!r.Open(path)) return {};
+        enum { Utf8, Utf16Le, Utf16Be } enc = Utf8;
+        for (uint64_t offset = 0; offset < m_opt.maxBytes;) {
+            size_t want = (size_t)std::min<uint64_t>(kChunk, m_opt.maxBytes - offset);
+            int64_t got = r.ReadAt(offset, m_chunk.get(), want);
+            if (got <= 0) break;
+            const char* p = m_chunk.get();
+            size_t n = (size_t)got;
+            if (offset == 0) {
+                if (n >= 2 && (uint8_t)p[0] == 0xFF && (uint8_t)p[1] == 0xFE) { enc = Utf16Le; p += 2; n -= 2; }
+                else if (n >= 2 && (uint8_t)p[0] == 0xFE && (uint8_t)p[1] == 0xFF) { enc = Utf16Be; p += 2; n -= 2; }
+                else {
+                    if (n >= 3 && (uint8_t)p[0] == 0xEF && (uint8_t)p[1] == 0xBB && (uint8_t)p[2] == 0xBF) { p += 3; n -= 3; }
+                    if (memchr(p, 0, std::min<size_t>(n, 8192))) return {};
+                }
+            }
+            offset += (uint64_t)got;
+            if (enc == Utf8) Feed(p, n);
+            else {
+                // a high surrogate at the end of a full chunk is read again with its low half
+                if ((size_t)got == want && n > 2 && (n & 1) == 0) {
+                    uint8_t hi = (uint8_t)p[enc == Utf16Be ? n - 2 : n - 1];
+                    if (hi >= 0xD8 && hi < 0xDC) { n -= 2; offset -= 2; }
+                }
+                Feed(m_utf8.get(), FromUtf16(p, n, enc == Utf16Be));
+            }
+            if ((size_t)got < want) break;
+        }
+        return Finish(topN, corpus);
+    }
+
+    std::vector<TagTerm> Text(std::string_view utf8, size_t topN, const TagCorpusFn& corpus = nullptr) {
+        Begin();
+        Feed(utf8.data(), utf8.size());
+        return Finish(topN, corpus);
+    }
+
+    // Streaming: Begin(), Feed() any number of UTF-8 pieces (split anywhere), Finish()
+    void Begin() {
+        for (uint32_t b : m_used) m_slots[b] = Slot();
+        m_used.clear();
+        m_free.clear();
+        m_terms = 0;
+        m_tokLen = m_tokChars = 0;
+        m_tokLetter = false;
+        m_need = 0;
+        m_tokens = 0;
+    }
+
+    void Feed(const char* p, size_t n) {
+        size_t i = 0;
+#ifdef HASH_X86
+        const __m128i k20 = _mm_set1_epi8(0x20), kA = _mm_set1_epi8('a' - 1), kZ = _mm_set1_epi8('z' + 1);
+        const __m128i k0 = _mm_set1_epi8('0' - 1), k9 = _mm_set1_epi8('9' + 1);
+        alignas(16) char lowered[32];        // upper half: slack for the fixed-size copies below
+        while (i + 16 <= n) {
+            if (m_need) { Byte((uint8_t)p[i++]); continue; }    // finish a UTF-8 sequence first
+            __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+            if (_mm_movemask_epi8(v)) {                      // non-ASCII: decoder for these 16 bytes
+                for (size_t e = i + 16; i < e; ++i) Byte((uint8_t)p[i]);
+                continue;
+            }
+            __m128i lower = _mm_or_si128(v, k20);
+            __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, kA), _mm_cmplt_epi8(lower, kZ));
+            __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, k0), _mm_cmplt_epi8(v, k9));
+            uint32_t letters = (uint32_t)_mm_movemask_epi8(alpha);
+            uint32_t word = letters | (uint32_t)_mm_movemask_epi8(digit);
+            if (!word) {
+                if (m_tokLen) Emit();
+                i += 16;
+                continue;
+            }
+            _mm_store_si128((__m128i*)lowered, _mm_or_si128(v, _mm_and_si128(alpha, k20)));
+            for (uint32_t pos = 0; pos < 16;) {
+                uint32_t rest = word >> pos;
+                if (rest & 1) {
+                    uint32_t run = Ctz(~rest);
+                    if (m_tokLen <= kMaxTermBytes) memcpy(m_tok + m_tokLen, lowered + pos, 16); // run <= 16
+                    m_tokLen += run;
+                    m_tokChars += run;
+                    m_tokLetter |= ((letters >> pos) & ((1u << run) - 1)) != 0;
+                    pos += run;
+                }
+                else {
+                    if (m_tokLen) Emit();
+                    if (!rest) break;
+                    pos += Ctz(rest);
+                }
+            }
+            i += 16;
+        }
+#endif
+        for (; i < n; ++i) Byte((uint8_t)p[i]);
+    }
+
+    std::vector<TagTerm> Finish(size_t topN, const TagCorpusFn& corpus = nullptr) {
+        if (m_tokLen) Emit();
+        m_need = 0;
+        // most frequent terms (min-heap on count, ties: longer term first)
+        struct Cand { uint32_t count; uint32_t slot; uint8_t len; };
+        auto worse = [](const Cand& a, const Cand& b) { return a.count != b.count ? a.count > b.count : a.len > b.len; };
+        std::vector<Cand> heap;
+        heap.reserve(kCandidates);
+        size_t keep = std::max(kCandidates, topN);
+        for (uint32_t b : m_used) {
+            const Slot& s = m_slots[b];
+            if (s.stop || !s.count) continue;
+            Cand c{ s.count, b, s.len };
+            if (heap.size() < keep) { heap.push_back(c); std::push_heap(heap.begin(), heap.end(), worse); }
+            else if (worse(c, heap.front())) { std::pop_heap(heap.begin(), heap.end(), worse); heap.back() = c; std::push_heap(heap.begin(), heap.end(), worse); }
+        }
+        std::vector<TagTerm> out(heap.size());
+        std::vector<std::string_view> terms(heap.size());
+        for (size_t k = 0; k < heap.size(); ++k) {
+            const Slot& s = m_slots[heap[k].slot];
+            terms[k] = std::string_view(m_text.get() + (size_t)s.text * kMaxTermBytes, s.len);
+            out[k].text.assign(terms[k]);
+            out[k].count = s.count;
+            out[k].score = 1.0f + std::log((float)s.count);
+        }
+        if (corpus && !out.empty()) {
+            std::vector<uint32_t> df(out.size(), 0);
+            uint64_t docs = corpus(terms, df.data());
+            if (docs >= m_opt.minCorpusDocs)
+                for (size_t k = 0; k < out.size(); ++k)
+                    out[k].score *= (float)std::log(1.0 + ((double)docs - df[k] + 0.5) / (df[k] + 0.5));
+        }
+        std::sort(out.begin(), out.end(), [](const TagTerm& a, const TagTerm& b) {
+            if (a.score != b.score) return a.score > b.score;
+            return a.text.size() != b.text.size() ? a.text.size() > b.text.size() : a.text < b.text;
+        });
+        if (out.size() > topN) out.resize(topN);
+        return out;
+    }
+
+    uint64_t Tokens() const { return m_tokens; }   // tokens seen since Begin()
+
+    static bool Stopword(std::string_view w) { return Stopwords().Contains(PaddedHash(w.data(), w.size())); }
+
+private:
+    static constexpr uint32_t kBuckets = kMaxTerms * 2;  // load <= 1/2 (+ stopwords)
+    struct Slot {
+        uint64_t hash = 0;
+        uint32_t count = 0;
+        uint16_t text = 0;                    // index into m_text
+        uint8_t len = 0;                      // 0 = empty
+        uint8_t stop = 0;
+    };
+
+    TagOptions m_opt;
+    std::unique_ptr<Slot[]> m_slots;
+    std::unique_ptr<char[]> m_text;           // kMaxTerms x kMaxTermBytes
+    std::unique_ptr<char[]> m_chunk, m_utf8;
+    std::vector<uint32_t> m_used;             // occupied buckets
+    std::vector<uint16_t> m_free;             // text slots freed by Decrement()
+    uint32_t m_terms = 0;                     // counted (non-stopword) terms in the table
+    uint64_t m_tokens = 0;
+
+    // token being built (UTF-8, lower case); + 16: the SIMD path copies whole vectors
+    char m_tok[kMaxTermBytes + 16] = {};
+    size_t m_tokLen = 0, m_tokChars = 0;
+    bool m_tokLetter = false;
+    // UTF-8 decoder state
+    uint32_t m_cp = 0;
+    int m_need = 0;
+
+    static uint32_t Ctz(uint32_t v) {
+#ifdef _MSC_VER
+        unsigned long i;
+        _BitScanForward(&i, v);
+        return (uint32_t)i;
+#else
+        return (uint32_t)__builtin_ctz(v);
+#endif
+    }
+
+    // Terms are told apart by this 64-bit hash alone. 8 bytes at a time, multiply-xorshift;
+    // p must stay readable up to the next multiple of 8 (the bytes past n are masked off).
+    static uint64_t Hash(const char* p, size_t n) {
+        uint64_t h = 0x9E3779B97F4A7C15ull ^ n;
+        for (size_t i = 0; i < n; i += 8) {
+            uint64_t w;
+            memcpy(&w, p + i, 8);
+            if (n - i < 8) w &= ~0ull >> (64 - 8 * (n - i));
+            h = (h ^ w) * 0xBF58476D1CE4E5B9ull;
+            h ^= h >> 31;
+        }
+        h *= 0x94D049BB133111EBull;
+        return (h ^ (h >> 29)) | 1;           // never 0
+    }
+
+    static uint64_t PaddedHash(const char* p, size_t n) {
+        char buf[kMaxTermBytes + 8] = {};
+        if (n > kMaxTermBytes) return 0;      // matches nothing
+        memcpy(buf, p, n);
+        return Hash(buf, n);
+    }
+
+    bool Wanted(const std::filesystem::path& path) const {
+        if (m_opt.extensions.empty()) return true;
+        std::string ext = FullTextUtf8(path.extension().native());
+        for (auto& c : ext) if (c >= 'A' && c <= 'Z') c += 32;
+        return std::find(m_opt.extensions.begin(), m_opt.extensions.end(), ext) != m_opt.extensions.end();
+    }
+
+    // UTF-16 chunk -> m_utf8 (chunks have even length except at the end; an unpaired surrogate separates)
+    size_t FromUtf16(const char* p, size_t n, bool bigEndian) {
+        char* out = m_utf8.get();
+        size_t o = 0;
+        for (size_t i = 0; i + 1 < n; i += 2) {
+            uint32_t u = bigEndian ? (uint32_t)(uint8_t)p[i] << 8 | (uint8_t)p[i + 1] : (uint8_t)p[i] | (uint32_t)(uint8_t)p[i + 1] << 8;
+            if (u >= 0xD800 && u < 0xDC00 && i + 3 < n) {
+                uint32_t lo = bigEndian ? (uint32_t)(uint8_t)p[i + 2] << 8 | (uint8_t)p[i + 3] : (uint8_t)p[i + 2] | (uint32_t)(uint8_t)p[i + 3] << 8;
+                if (lo >= 0xDC00 && lo < 0xE000) { u = 0x10000 + ((u - 0xD800) << 10) + (lo - 0xDC00); i += 2; }
+            }
+            if (u >= 0xD800 && u < 0xE000) u = ' ';
+            o += PutUtf8(out + o, u);
+        }
+        return o;
+    }
+    static size_t PutUtf8(char* o, uint32_t u) {
+        if (u < 0x80) { o[0] = (char)u; return 1; }
+        if (u < 0x800) { o[0] = (char)(0xC0 | u >> 6); o[1] = (char)(0x80 | (u & 0x3F)); return 2; }
+        if (u < 0x10000) { o[0] = (char)(0xE0 | u >> 12); o[1] = (char)(0x80 | (u >> 6 & 0x3F)); o[2] = (char)(0x80 | (u & 0x3F)); return 3; }
+        o[0] = (char)(0xF0 | u >> 18); o[1] = (char)(0x80 | (u >> 12 & 0x3F)); o[2] = (char)(0x80 | (u >> 6 & 0x3F)); o[3] = (char)(0x80 | (u & 0x3F));
+        return 4;
+    }
+
+    void AppendAscii(const char* s, size_t n, uint32_t letters) {
+        if (m_tokLen + n <= kMaxTermBytes) memcpy(m_tok + m_tokLen, s, n);
+        m_tokLen += n;
+        m_tokChars += n;
+        m_tokLetter |= letters != 0;
+    }
+
+    // one byte of UTF-8
+    void Byte(uint8_t b) {
+        if (m_need) {
+            if ((b & 0xC0) == 0x80) {
+                m_cp = m_cp << 6 | (b & 0x3F);
+                if (--m_need == 0) CodePoint(m_cp);
+                return;
+            }
+            m_need = 0;                       // broken sequence: separator, b starts afresh
+            if (m_tokLen) Emit();
+        }
+        if (b < 0x80) {
+            char c = (char)b;
+            if (c >= 'A' && c <= 'Z') c += 32;
+            if (c >= 'a' && c <= 'z') AppendAscii(&c, 1, 1);
+            else if (c >= '0' && c <= '9') AppendAscii(&c, 1, 0);
+            else if (m_tokLen) Emit();
+        }
+        else if (b >= 0xC2 && b <= 0xDF) { m_cp = b & 0x1F; m_need = 1; }
+        else if (b >= 0xE0 && b <= 0xEF) { m_cp = b & 0x0F; m_need = 2; }
+        else if (b >= 0xF0 && b <= 0xF4) { m_cp = b & 0x07; m_need = 3; }
+        else if (m_tokLen) Emit();
+    }
+
+    void CodePoint(uint32_t u) {
+        if (Separator(u)) {
+            if (m_tokLen) Emit();
+            return;
+        }
+        u = Lower(u);
+        char tmp[4];
+        size_t n = PutUtf8(tmp, u);
+        if (m_tokLen + n <= kMaxTermBytes) memcpy(m_tok + m_tokLen, tmp, n);
+        m_tokLen += n;
+        ++m_tokChars;
+        m_tokLetter = true;
+    }
+
+    static bool Separator(uint32_t u) {
+        return u < 0xC0 || u == 0xD7 || u == 0xF7 ||                  // Latin-1 symbols, NBSP, « », × ÷
+               (u >= 0x2000 && u <= 0x206F) ||                        // general punctuation, typographic spaces / quotes
+               (u >= 0x20A0 && u <= 0x2BFF) ||                        // currency, arrows, math, boxes
+               (u >= 0x3000 && u <= 0x303F) || u == 0xFEFF ||          // CJK punctuation, BOM
+               (u >= 0xFF00 && u <= 0xFF0F) || (u >= 0x1F000 && u <= 0x1FAFF); // fullwidth punctuation, emoji
+    }
+    static uint32_t Lower(uint32_t u) {
+        if (u >= 0xC0 && u <= 0xDE) return u + 0x20;                           // À..Þ (× excluded above)
+        if (u >= 0x100 && u <= 0x17F) {
+            if ((u >= 0x139 && u <= 0x148) || (u >= 0x179 && u <= 0x17E)) return (u & 1) ? u + 1 : u;
+            if (u != 0x130 && u != 0x138 && u != 0x149 && u != 0x178) return u | 1;
+            return u == 0x178 ? 0xFF : u;
+        }
+        if (u >= 0x391 && u <= 0x3AB && u != 0x3A2) return u + 0x20;          // Greek
+        if (u >= 0x410 && u <= 0x42F) return u + 0x20;                           // Cyrillic
+        if (u >= 0x400 && u <= 0x40F) return u + 0x50;
+        return u;
+    }
+
+    void Emit() {
+        size_t len = m_tokLen, chars = m_tokChars;
+        bool letter = m_tokLetter;
+        m_tokLen = m_tokChars = 0;
+        m_tokLetter = false;
+        ++m_tokens;
+        if (!letter || chars < m_opt.minChars || len > kMaxTermBytes) return;
+        uint64_t h = Hash(m_tok, len);
+        uint32_t mask = kBuckets - 1;
+        uint32_t b = (uint32_t)h & mask;
+        for (; m_slots[b].len; b = (b + 1) & mask) {
+            Slot& s = m_slots[b];
+            if (s.hash != h) continue;
+            if (!s.stop) ++s.count;
+            return;
+        }
+        if (Stopwords().Contains(h)) {
+            Put(b, h, (uint8_t)len, 0, true);
+            return;
+        }
+        if (m_terms == kMaxTerms) { Decrement(); return; }  // the new term is one of the decremented ones
+        uint16_t t = (uint16_t)m_terms;   // text slots below m_terms are taken unless freed by Decrement()
+        if (!m_free.empty()) { t = m_free.back(); m_free.pop_back(); }
+        memcpy(m_text.get() + (size_t)t * kMaxTermBytes, m_tok, len);
+        Put(b, h, (uint8_t)len, t, false);
+        ++m_terms;
+    }
+
+    void Put(uint32_t b, uint64_t h, uint8_t len, uint16_t text, bool stop) {
+        Slot& s = m_slots[b];
+        s.hash = h;
+        s.len = len;
+        s.text = text;
+        s.stop = stop;
+        s.count = stop ? 0 : 1;
+        m_used.push_back(b);
+    }
+
+    // Misra-Gries step: all counts - 1, terms at zero are dropped, the table is rebuilt without them
+    void Decrement() {
+        std::vector<Slot> keep;
+        keep.reserve(m_used.size());
+        for (uint32_t b : m_used) {
+            Slot s = m_slots[b];
+            m_slots[b] = Slot();
+            if (!s.stop && --s.count == 0) { m_free.push_back(s.text); --m_terms; continue; }
+            keep.push_back(s);
+        }
+        m_used.clear();
+        uint32_t mask = kBuckets - 1;
+        for (auto const& s : keep) {
+            uint32_t b = (uint32_t)s.hash & mask;
+            while (m_slots[b].len) b = (b + 1) & mask;
+            m_slots[b] = s;
+            m_used.push_back(b);
+        }
+    }
+
+    class StopSet {
+    public:
+        StopSet() {
+            static const char* const words[] = {   // UTF-8, escaped so the source encoding does not matter
+                // English
+                "a", "about", "above", "after", "again", "against", "all", "also", "am", "an", "and", "any", "are", "aren",
+                "as", "at", "be", "because", "been", "before", "being", "below", "between", "both", "but", "by", "can",
+                "cannot", "could", "couldn", "did", "didn", "do", "does", "doesn", "doing", "don", "down", "during", "each",
+                "etc", "few", "for", "from", "further", "get", "got", "had", "hadn", "has", "hasn", "have", "haven", "having",
+                "he", "her", "here", "hers", "herself", "him", "himself", "his", "how", "however", "i", "if", "in", "into",
+                "is", "isn", "it", "its", "itself", "just", "let", "like", "may", "me", "might", "more", "most", "must",
+                "my", "myself", "new", "no", "nor", "not", "now", "of", "off", "on", "once", "one", "only", "or", "other",
+                "ought", "our", "ours", "ourselves", "out", "over", "own", "per", "same", "shall", "she", "should",
+                "shouldn", "since", "so", "some", "such", "than", "that", "the", "their", "theirs", "them", "themselves",
+                "then", "there", "these", "they", "this", "those", "through", "thus", "to", "too", "two", "under", "until",
+                "up", "upon", "use", "used", "using", "very", "via", "was", "wasn", "we", "well", "were", "weren", "what",
+                "when", "where", "whether", "which", "while", "who", "whom", "why", "will", "with", "within", "without",
+                "won", "would", "wouldn", "yet", "you", "your", "yours", "yourself", "yourselves",
+                "http", "https", "www", "com", "html",
+                // Deutsch
+                "ab", "aber", "alle", "allem", "allen", "aller", "alles", "als", "also", "am", "an", "ander", "andere",
+                "anderem", "anderen", "anderer", "anderes", "anders", "auch", "auf", "aus", "bei", "beim", "bin", "bis",
+                "bist", "bzw", "da", "dabei", "daher", "damit", "dann", "darauf", "das", "dass", "da\xC3\x9F", "dazu", "dein",
+                "deine", "deinem", "deinen", "deiner", "deines", "dem", "den", "denn", "der", "derer", "des", "dessen",
+                "dich", "die", "dies", "diese", "diesem", "diesen", "dieser", "dieses", "dir", "doch", "dort", "du",
+                "durch", "eben", "ein", "eine", "einem", "einen", "einer", "eines", "einige", "einigen", "einiger",
+                "einiges", "einmal", "er", "es", "etwas", "euch", "euer", "eure", "eurem", "euren", "eurer", "eures",
+                "f\xC3\xBCr", "ganz", "gegen", "gewesen", "gibt", "hab", "habe", "haben", "hat", "hatte", "hatten", "hier",
+                "hin", "hinter", "ich", "ihm", "ihn", "ihnen", "ihr", "ihre", "ihrem", "ihren", "ihrer", "ihres", "im",
+                "in", "indem", "ins", "ist", "jede", "jedem", "jeden", "jeder", "jedes", "jene", "jenem", "jenen",
+                "jener", "jenes", "jetzt", "kann", "kein", "keine", "keinem", "keinen", "keiner", "keines", "k\xC3\xB6nnen",
+                "k\xC3\xB6nnte", "man", "manche", "manchem", "manchen", "mancher", "manches", "mehr", "mein", "meine", "meinem",
+                "meinen", "meiner", "meines", "mich", "mir", "mit", "muss", "musste", "nach", "nicht", "nichts", "noch",
+                "nun", "nur", "ob", "oder", "ohne", "schon", "sehr", "sei", "sein", "seine", "seinem", "seinen", "seiner",
+                "seines", "seit", "selbst", "sich", "sie", "sind", "so", "solche", "solchem", "solchen", "solcher",
+                "solches", "soll", "sollte", "sondern", "sonst", "sowie", "\xC3\xBC" "ber", "um", "und", "uns", "unser", "unsere",
+                "unserem", "unseren", "unseres", "unter", "usw", "viel", "vom", "von", "vor", "w\xC3\xA4hrend", "war", "waren",
+                "warst", "was", "weg", "weil", "weiter", "welche", "welchem", "welchen", "welcher", "welches", "wenn",
+                "werde", "werden", "wie", "wieder", "will", "wir", "wird", "wirst", "wo", "wollen", "wollte", "w\xC3\xBCrde",
+                "w\xC3\xBCrden", "wurde", "wurden", "zu", "zum", "zur", "zwar", "zwischen",
+                // Français
+                "aux", "avec", "avoir", "bien", "ces", "cette", "comme", "dans", "des", "donc", "dont", "elle", "encore",
+                "entre", "est", "\xC3\xA9t\xC3\xA9", "\xC3\xAAtre", "fait", "ils", "les", "leur", "mais", "m\xC3\xAAme", "nous", "ont", "par", "pas",
+                "peut", "plus", "pour", "que", "qui", "sans", "ses", "son", "sont", "sur", "tous", "tout", "tr\xC3\xA8s", "une",
+                "vous",
+                // Español
+                "ante", "como", "con", "cuando", "del", "desde", "durante", "ellos", "entre", "esta", "est\xC3\xA1", "ese",
+                "eso", "este", "fue", "hab\xC3\xAD" "a", "hasta", "hay", "las", "les", "los", "m\xC3\xA1s", "muy", "nos", "otra", "otro",
+                "para", "pero", "por", "que", "ser", "sin", "sobre", "son", "sus", "tambi\xC3\xA9n", "todo", "una", "uno" };
+            for (const char* w : words) {
+                uint64_t h = PaddedHash(w, strlen(w));
+                uint32_t b = (uint32_t)h & (kSize - 1);
+                while (m_table[b] && m_table[b] != h) b = (b + 1) & (kSize - 1);
+                m_table[b] = h;
+            }
+        }
+        bool Contains(uint64_t h) const {
+            for (uint32_t b = (uint32_t)h & (kSize - 1); m_table[b]; b = (b + 1) & (kSize - 1))
+                if (m_table[b] == h) return true;
+            return false;
+        }
+    private:
+        static constexpr uint32_t kSize = 2048;
+        std::array<uint64_t, kSize> m_table{};
+    };
+    static const StopSet& Stopwords() {
+        static const StopSet set;
+        return set;
+    }
+};
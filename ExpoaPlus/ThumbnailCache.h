@@ -0,0 +1,324 @@
+// ThumbnailCache.h — two-tier thumbnail cache: byte-budgeted memory LRU + persistent packed disk store
+// - Keys cover (path, file size, mtime, thumbnail size): a changed file or a new size simply misses
+// - ThumbnailLru<V>: any value type with an explicit cost (decoded bitmap bytes); not thread-safe
+// - ThumbnailDiskStore: one append-only blob file (self-describing records) + an index file loaded
+//   into a hash map at Open; LRU eviction to a byte budget, compaction once half the blob is dead
+//   records. Thread-safe; the index is saved every few hundred puts and on Close, a missing or stale
+//   one is rebuilt by scanning the blob.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Hashing.h"
+
+// 64-bit key of one thumbnail (FastHash128 over the path bytes, then the numeric fields)
+inline uint64_t ThumbnailKey(const std::filesystem::path& path, uint64_t fileSize, uint64_t mtime, uint32_t thumbSize) {
+    FastHash128 h;
+    const auto& native = path.native();
+    h.Update(native.data(), native.size() * sizeof(native[0]));
+    h.Update(&fileSize, sizeof(fileSize));
+    h.Update(&mtime, sizeof(mtime));
+    h.Update(&thumbSize, sizeof(thumbSize));
+    HashDigest d = h.Final();
+    uint64_t key;
+    memcpy(&key, d.bytes, sizeof(key));
+    return key;
+}
+
+template <class V>
+class ThumbnailLru {
+public:
+    explicit ThumbnailLru(size_t budgetBytes = 64u << 20) : m_budget(budgetBytes) {}
+
+    bool Get(uint64_t key, V& out) {
+        auto it = m_map.find(key);
+        if (it == m_map.end()) return false;
+        m_list.splice(m_list.begin(), m_list, it->second); // most recently used first
+        out = it->second->value;
+        return true;
+    }
+
+    void Put(uint64_t key, V value, size_t cost) {
+        auto it = m_map.find(key);
+        if (it != m_map.end()) {
+            m_bytes -= it->second->cost;
+            m_list.erase(it->second);
+            m_map.erase(it);
+        }
+        if (cost > m_budget) return;
+        m_list.push_front(Entry{ key, std::move(value), cost });
+        m_map[key] = m_list.begin();
+        m_bytes += cost;
+        Trim();
+    }
+
+    void SetBudget(size_t bytes) { m_budget = bytes; Trim(); }
+    size_t Budget() const { return m_budget; }
+    size_t Bytes() const { return m_bytes; }
+    size_t Count() const { return m_map.size(); }
+    void Clear() { m_list.clear(); m_map.clear(); m_bytes = 0; }
+
+private:
+    struct Entry { uint64_t key; V value; size_t cost; };
+    std::list<Entry> m_list;
+    std::unordered_map<uint64_t, typename std::list<Entry>::iterator> m_map;
+    size_t m_budget;
+    size_t m_bytes = 0;
+
+    void Trim() {
+        while (m_bytes > m_budget && !m_list.empty()) {
+            m_bytes -= m_list.back().cost;
+            m_map.erase(m_list.back().key);
+            m_list.pop_back();
+        }
+    }
+};
+
+class ThumbnailDiskStore {
+public:
+    ~ThumbnailDiskStore() { Close(); }
+
+    // dir gets thumbs.blob + thumbs.idx
+    bool Open(const std::filesystem::path& dir, uint64_t budgetBytes) {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        CloseLocked();
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        m_blobPath = dir / "thumbs.blob";
+        m_indexPath = dir / "thumbs.idx";
+        m_budget = budgetBytes;
+        if (!LoadIndex()) RebuildIndex();
+        m_out.open(m_blobPath, std::ios::binary | std::ios::app);
+        m_in.open(m_blobPath, std::ios::binary);
+        m_open = m_out.is_open() && m_in.is_open();
+        if (m_open && m_live > m_budget) { EvictLocked(m_budget); CompactLocked(); } // rebuilt index resurrects evicted records
+        return m_open;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        CloseLocked();
+    }
+
+    bool Get(uint64_t key, std::vector<uint8_t>& out) {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        if (!m_open) return false;
+        auto it = m_index.find(key);
+        if (it == m_index.end()) return false;
+        m_out.flush();
+        m_in.clear();
+        m_in.seekg((std::streamoff)(it->second.offset + kRecordHeader));
+        out.resize(it->second.length);
+        if (!m_in.read((char*)out.data(), out.size())) { out.clear(); return false; }
+        it->second.lastUse = ++m_clock;
+        m_dirty = true;
+        return true;
+    }
+
+    void Put(uint64_t key, const uint8_t* data, size_t n) {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        if (!m_open || n == 0 || n > m_budget) return;
+        auto old = m_index.find(key);
+        if (old != m_index.end()) { m_dead += kRecordHeader + old->second.length; m_live -= kRecordHeader + old->second.length; m_index.erase(old); }
+        RecordHeader h{ kRecordMagic, (uint32_t)n, key };
+        m_out.write((const char*)&h, sizeof(h));
+        m_out.write((const char*)data, (std::streamsize)n);
+        if (!m_out) return;
+        m_index[key] = Slot{ m_blobSize, (uint32_t)n, ++m_clock };
+        m_blobSize += kRecordHeader + n;
+        m_live += kRecordHeader + n;
+        m_dirty = true;
+        if (m_live > m_budget) EvictLocked(m_budget - m_budget / 10);
+        if (m_dead > kMinCompact && m_dead > m_live) CompactLocked();
+        else if (++m_unsaved >= kSaveEvery) SaveIndex();
+    }
+
+    void SetBudget(uint64_t bytes) {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_budget = bytes;
+        if (m_live > m_budget) { EvictLocked(m_budget); CompactLocked(); }
+    }
+
+    // Persist the index (also done by Close)
+    void Flush() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        if (m_open) { m_out.flush(); SaveIndex(); }
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_index.clear();
+        m_dead += m_live; m_live = 0; m_dirty = true;
+        CompactLocked();
+    }
+
+    size_t Count() { std::lock_guard<std::mutex> lg(m_mutex); return m_index.size(); }
+    uint64_t LiveBytes() { std::lock_guard<std::mutex> lg(m_mutex); return m_live; }
+    uint64_t FileBytes() { std::lock_guard<std::mutex> lg(m_mutex); return m_blobSize; }
+
+private:
+    static const uint32_t kRecordMagic = 0x31424854;  // "THB1"
+    static const uint32_t kIndexMagic = 0x31584954;   // "TIX1"
+    static const uint64_t kMinCompact = 4u << 20;
+    static const uint32_t kSaveEvery = 256;          // puts between index saves (a stale index is rebuilt)
+#pragma pack(push, 1)
+    struct RecordHeader { uint32_t magic; uint32_t length; uint64_t key; };
+    struct IndexRecord { uint64_t key; uint64_t offset; uint32_t length; uint32_t pad; uint64_t lastUse; };
+#pragma pack(pop)
+    static const uint64_t kRecordHeader = sizeof(RecordHeader);
+
+    struct Slot { uint64_t offset; uint32_t length; uint64_t lastUse; };
+
+    std::mutex m_mutex;
+    std::filesystem::path m_blobPath, m_indexPath;
+    std::ofstream m_out;
+    std::ifstream m_in;
+    std::unordered_map<uint64_t, Slot> m_index;
+    uint64_t m_budget = 0, m_blobSize = 0, m_live = 0, m_dead = 0, m_clock = 0;
+    uint32_t m_unsaved = 0;
+    bool m_open = false, m_dirty = false;
+
+    void CloseLocked() {
+        if (m_open) { m_out.flush(); SaveIndex(); }
+        if (m_out.is_open()) m_out.close();
+        if (m_in.is_open()) m_in.close();
+        m_index.clear();
+        m_blobSize = m_live = m_dead = m_clock = 0;
+        m_open = m_dirty = false;
+    }
+
+    // Index file: magic, blob size it describes, record count, records. Stale if the blob size differs.
+    bool LoadIndex() {
+        std::error_code ec;
+        uint64_t blobSize = std::filesystem::exists(m_blobPath, ec) ? std::filesystem::file_size(m_blobPath, ec) : 0;
+        std::ifstream f(m_indexPath, std::ios::binary);
+        if (!f) return blobSize == 0;
+        uint32_t magic = 0; uint64_t size = 0, count = 0;
+        f.read((char*)&magic, sizeof(magic)); f.read((char*)&size, sizeof(size)); f.read((char*)&count, sizeof(count));
+        if (!f || magic != kIndexMagic || size != blobSize) return false;
+        std::vector<IndexRecord> recs((size_t)count);
+        if (count && !f.read((char*)recs.data(), (std::streamsize)(count * sizeof(IndexRecord)))) return false;
+        m_index.reserve((size_t)count);
+        for (auto const& r : recs) {
+            if (r.offset + kRecordHeader + r.length > blobSize) return false;
+            m_index[r.key] = Slot{ r.offset, r.length, r.lastUse };
+            m_live += kRecordHeader + r.length;
+            m_clock = std::max(m_clock, r.lastUse);
+        }
+        m_blobSize = blobSize;
+        m_dead = blobSize - m_live;
+        return true;
+    }
+
+    // Records are self-describing: scan the blob, later records win, stop at the first torn record.
+    void RebuildIndex() {
+        m_index.clear();
+        m_live = m_dead = m_blobSize = 0;
+        std::error_code ec;
+        uint64_t fileSize = std::filesystem::exists(m_blobPath, ec) ? std::filesystem::file_size(m_blobPath, ec) : 0;
+        std::ifstream f(m_blobPath, std::ios::binary);
+        uint64_t off = 0;
+        RecordHeader h;
+        while (f.read((char*)&h, sizeof(h)) && h.magic == kRecordMagic) {
+            if (off + kRecordHeader + h.length > fileSize) break; // seekg past the end would not fail
+            f.seekg((std::streamoff)h.length, std::ios::cur);
+            if (!f) break;
+            auto old = m_index.find(h.key);
+            if (old != m_index.end()) { m_live -= kRecordHeader + old->second.length; m_dead += kRecordHeader + old->second.length; }
+            m_index[h.key] = Slot{ off, h.length, ++m_clock };
+            m_live += kRecordHeader + h.length;
+            off += kRecordHeader + h.length;
+        }
+        m_blobSize = off;
+        if (fileSize != off)
+            std::filesystem::resize_file(m_blobPath, off, ec); // drop a torn tail
+        m_dirty = true;
+    }
+
+    void SaveIndex() {
+        if (!m_dirty) return;
+        m_out.flush();
+        m_unsaved = 0;
+        std::filesystem::path tmp = m_indexPath; tmp += ".tmp";
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            uint32_t magic = kIndexMagic; uint64_t count = m_index.size();
+            f.write((const char*)&magic, sizeof(magic)); f.write((const char*)&m_blobSize, sizeof(m_blobSize)); f.write((const char*)&count, sizeof(count));
+            for (auto const& kv : m_index) {
+                IndexRecord r{ kv.first, kv.second.offset, kv.second.length, 0, kv.second.lastUse };
+                f.write((const char*)&r, sizeof(r));
+            }
+            if (!f) return;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, m_indexPath, ec);
+        if (!ec) m_dirty = false;
+    }
+
+    // Drop least recently used entries until live bytes <= target (space is reclaimed by compaction)
+    void EvictLocked(uint64_t target) {
+        std::vector<std::pair<uint64_t, uint64_t>> byAge; // (lastUse, key)
+        byAge.reserve(m_index.size());
+        for (auto const& kv : m_index) byAge.emplace_back(kv.second.lastUse, kv.first);
+        std::sort(byAge.begin(), byAge.end());
+        for (auto const& a : byAge) {
+            if (m_live <= target) break;
+            auto it = m_index.find(a.second);
+            m_live -= kRecordHeader + it->second.length;
+            m_dead += kRecordHeader + it->second.length;
+            m_index.erase(it);
+        }
+        m_dirty = true;
+    }
+
+    // Copy live records (in file order) into a new blob and swap it in
+    void CompactLocked() {
+        if (!m_open) return;
+        m_out.flush();
+        std::vector<std::pair<uint64_t, uint64_t>> order; // (offset, key)
+        order.reserve(m_index.size());
+        for (auto const& kv : m_index) order.emplace_back(kv.second.offset, kv.first);
+        std::sort(order.begin(), order.end());
+        std::filesystem::path tmp = m_blobPath; tmp += ".tmp";
+        std::unordered_map<uint64_t, Slot> fresh;
+        fresh.reserve(m_index.size());
+        uint64_t off = 0;
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            std::vector<char> buf;
+            for (auto const& o : order) {
+                Slot s = m_index[o.second];
+                buf.resize(kRecordHeader + s.length);
+                m_in.clear();
+                m_in.seekg((std::streamoff)s.offset);
+                if (!m_in.read(buf.data(), (std::streamsize)buf.size())) continue;
+                f.write(buf.data(), (std::streamsize)buf.size());
+                fresh[o.second] = Slot{ off, s.length, s.lastUse };
+                off += buf.size();
+            }
+            if (!f) return;
+        }
+        m_out.close(); m_in.close();
+        std::error_code ec;
+        std::filesystem::rename(tmp, m_blobPath, ec);
+        if (!ec) {
+            m_index.swap(fresh);
+            m_blobSize = m_live = off;
+            m_dead = 0;
+        }
+        m_out.open(m_blobPath, std::ios::binary | std::ios::app);
+        m_in.open(m_blobPath, std::ios::binary);
+        m_open = m_out.is_open() && m_in.is_open();
+        m_dirty = true;
+        SaveIndex();
+    }
+};
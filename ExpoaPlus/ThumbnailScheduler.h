@@ -0,0 +1,248 @@
+// ThumbnailScheduler.h — bounded worker pool for thumbnail decodes with a priority queue
+// - Lower priority value runs first (ThumbPriority: visible, near the viewport, background);
+//   equal priorities run in submission order. Priorities can be changed while queued.
+// - One job per key: a second Submit for a queued/running key only adds a listener (and may
+//   raise the priority). Every Submit returns a ticket; Cancel(ticket) removes that listener and
+//   drops the job once nobody waits for it. CancelAll() is for navigation. A key submitted again
+//   while its cancelled decode winds down is queued afresh once that decode returns.
+// - The decoder runs on a worker with a cancel flag it may poll; listeners are called on the
+//   worker thread (marshal to the UI yourself); a Cancel racing with completion can still see its
+//   listener run, so the UI re-checks that the target still wants the image
+// - Metrics: queue wait (submit -> decode start) per priority, completed / cancelled / deduplicated
+// No platform code: a fake decoder is enough to drive it headlessly.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum ThumbPriority : int { ThumbVisible = 0, ThumbNear = 1, ThumbBackground = 2, ThumbPriorityCount = 3 };
+
+struct ThumbRequest {
+    uint64_t key = 0;                         // ThumbnailKey(...) of the file
+    std::filesystem::path path;
+    uint32_t size = 0;                        // edge length in pixels
+};
+
+using ThumbDecodeFn = std::function<std::vector<uint8_t>(const ThumbRequest&, const std::atomic<bool>& cancel)>;
+using ThumbDoneFn = std::function<void(uint64_t key, const std::vector<uint8_t>& data)>;
+
+struct ThumbSchedulerMetrics {
+    uint64_t submitted = 0, deduplicated = 0, completed = 0, cancelled = 0;
+    uint64_t waits[ThumbPriorityCount] = {};            // decodes started per priority
+    double meanWaitMs[ThumbPriorityCount] = {};
+    double maxWaitMs[ThumbPriorityCount] = {};
+    size_t queued = 0, running = 0;
+};
+
+class ThumbnailScheduler {
+public:
+    ~ThumbnailScheduler() { Stop(); }
+
+    void Start(unsigned workers, ThumbDecodeFn decode) {
+        Stop();
+        std::lock_guard<std::mutex> lg(m_mutex);
+        m_decode = std::move(decode);
+        m_stop = false;
+        if (workers == 0) workers = 1;
+        for (unsigned i = 0; i < workers; ++i) m_workers.emplace_back([this]() { Run(); });
+    }
+
+    // Cancels everything and joins the workers.
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            m_stop = true;
+            CancelAllLocked();
+        }
+        m_cv.notify_all();
+        for (auto& t : m_workers) t.join();
+        m_workers.clear();
+    }
+
+    uint64_t Submit(const ThumbRequest& req, int priority, ThumbDoneFn onDone) {
+        priority = std::clamp(priority, 0, ThumbPriorityCount - 1);
+        std::lock_guard<std::mutex> lg(m_mutex);
+        uint64_t ticket = ++m_nextTicket;
+        m_metrics.submitted++;
+        auto it = m_jobs.find(req.key);
+        if (it == m_jobs.end()) {
+            Job& j = m_jobs[req.key];
+            j.req = req;
+            j.priority = priority;
+            j.seq = ++m_nextSeq;
+            j.cancel = std::make_shared<std::atomic<bool>>(false);
+            j.enqueued = Clock::now();
+            m_queue.insert({ j.priority, j.seq, req.key });
+            it = m_jobs.find(req.key);
+            m_cv.notify_one();
+        }
+        else if (it->second.running && it->second.cancel->load()) {
+            // dropped, decode still winding down: the worker queues it again for these listeners
+            Job& j = it->second;
+            j.priority = j.listeners.empty() ? priority : std::min(j.priority, priority);
+        }
+        else {
+            m_metrics.deduplicated++;
+            if (!it->second.running && priority < it->second.priority) Requeue(it->second, priority);
+        }
+        it->second.listeners.push_back({ ticket, std::move(onDone) });
+        m_tickets[ticket] = req.key;
+        return ticket;
+    }
+
+    // Re-rank a queued job (e.g. its item scrolled into view). No effect once the decode started.
+    void SetPriority(uint64_t ticket, int priority) {
+        priority = std::clamp(priority, 0, ThumbPriorityCount - 1);
+        std::lock_guard<std::mutex> lg(m_mutex);
+        auto t = m_tickets.find(ticket);
+        if (t == m_tickets.end()) return;
+        Job& j = m_jobs[t->second];
+        if (!j.running && j.priority != priority) Requeue(j, priority);
+    }
+
+    void Cancel(uint64_t ticket) {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        auto t = m_tickets.find(ticket);
+        if (t == m_tickets.end()) return;
+        uint64_t key = t->second;
+        m_tickets.erase(t);
+        auto it = m_jobs.find(key);
+        auto& ls = it->second.listeners;
+        ls.erase(std::remove_if(ls.begin(), ls.end(), [ticket](const Listener& l) { return l.ticket == ticket; }), ls.end());
+        if (ls.empty()) DropJob(it);
+    }
+
+    void CancelAll() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        CancelAllLocked();
+    }
+
+    // Block until nothing is queued or running (tests / shutdown).
+    void WaitIdle() {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_idleCv.wait(lk, [this]() { return m_queue.empty() && m_running == 0; });
+    }
+
+    ThumbSchedulerMetrics Metrics() {
+        std::lock_guard<std::mutex> lg(m_mutex);
+        ThumbSchedulerMetrics m = m_metrics;
+        for (int p = 0; p < ThumbPriorityCount; ++p)
+            m.meanWaitMs[p] = m.waits[p] ? m_waitSumMs[p] / (double)m.waits[p] : 0.0;
+        m.queued = m_queue.size();
+        m.running = m_running;
+        return m;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Listener { uint64_t ticket; ThumbDoneFn fn; };
+    struct QueueKey {
+        int priority; uint64_t seq; uint64_t key;
+        bool operator<(const QueueKey& o) const { return priority != o.priority ? priority < o.priority : seq < o.seq; }
+    };
+    struct Job {
+        ThumbRequest req;
+        int priority = 0;
+        uint64_t seq = 0;
+        bool running = false;
+        std::shared_ptr<std::atomic<bool>> cancel;
+        Clock::time_point enqueued;
+        std::vector<Listener> listeners;
+    };
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv, m_idleCv;
+    std::vector<std::thread> m_workers;
+    ThumbDecodeFn m_decode;
+    std::set<QueueKey> m_queue;
+    std::unordered_map<uint64_t, Job> m_jobs;          // key -> queued or running job
+    std::unordered_map<uint64_t, uint64_t> m_tickets;  // ticket -> key
+    uint64_t m_nextTicket = 0, m_nextSeq = 0;
+    size_t m_running = 0;
+    bool m_stop = false;
+    ThumbSchedulerMetrics m_metrics;
+    double m_waitSumMs[ThumbPriorityCount] = {};
+
+    void Requeue(Job& j, int priority) {
+        m_queue.erase({ j.priority, j.seq, j.req.key });
+        j.priority = priority;
+        m_queue.insert({ j.priority, j.seq, j.req.key });
+    }
+
+    void DropJob(std::unordered_map<uint64_t, Job>::iterator it) {
+        Job& j = it->second;
+        if (j.running && j.cancel->load() && j.listeners.empty()) return; // already dropped, decode still winding down
+        for (auto const& l : j.listeners) m_tickets.erase(l.ticket);
+        j.listeners.clear();
+        m_metrics.cancelled++;
+        if (j.running) { j.cancel->store(true); return; } // the worker erases it when the decode returns
+        m_queue.erase({ j.priority, j.seq, j.req.key });
+        m_jobs.erase(it);
+        if (m_queue.empty() && m_running == 0) m_idleCv.notify_all();
+    }
+
+    void CancelAllLocked() {
+        for (auto it = m_jobs.begin(); it != m_jobs.end();) {
+            auto next = std::next(it);
+            DropJob(it);
+            it = next;
+        }
+    }
+
+    void Run() {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        for (;;) {
+            m_cv.wait(lk, [this]() { return m_stop || !m_queue.empty(); });
+            if (m_stop) return;
+            QueueKey top = *m_queue.begin();
+            m_queue.erase(m_queue.begin());
+            Job& job = m_jobs[top.key];
+            job.running = true;
+            m_running++;
+            double waitMs = std::chrono::duration<double, std::milli>(Clock::now() - job.enqueued).count();
+            m_metrics.waits[top.priority]++;
+            m_waitSumMs[top.priority] += waitMs;
+            m_metrics.maxWaitMs[top.priority] = std::max(m_metrics.maxWaitMs[top.priority], waitMs);
+            ThumbRequest req = job.req;
+            auto cancel = job.cancel;
+
+            lk.unlock();
+            std::vector<uint8_t> data;
+            if (!cancel->load()) data = m_decode(req, *cancel);
+            lk.lock();
+
+            // Submits for this key during the decode only added listeners; only this worker erases it
+            auto it = m_jobs.find(top.key);
+            if (cancel->load() && !it->second.listeners.empty()) {
+                Job& j = it->second;                   // cancelled, then wanted again: a fresh decode
+                j.running = false;
+                j.cancel = std::make_shared<std::atomic<bool>>(false);
+                j.seq = ++m_nextSeq;
+                j.enqueued = Clock::now();
+                m_queue.insert({ j.priority, j.seq, top.key });
+                m_running--;
+                continue;
+            }
+            std::vector<Listener> listeners = std::move(it->second.listeners);
+            for (auto const& l : listeners) m_tickets.erase(l.ticket);
+            m_jobs.erase(it);
+            if (!cancel->load()) m_metrics.completed++;
+            lk.unlock();
+            if (!cancel->load()) for (auto const& l : listeners) l.fn(top.key, data);
+            lk.lock();
+            m_running--;
+            if (m_queue.empty() && m_running == 0) m_idleCv.notify_all();
+        }
+    }
+};
@@ -0,0 +1,86 @@
+// VirtualItemSource.h — ItemsSource for the file grid that materializes nothing up front
+// - The vector only knows its Count; GetAt(i) boxes the view position i on demand, so with the
+//   GridView's UI virtualization only realized (visible + cache) containers ever touch an item
+// - The owner keeps the position -> item mapping (an index array); sorting/filtering reorder that
+//   array and call Reset(count), which re-realizes just the visible containers
+// Read-only: the modifying IVector members throw.
+#pragma once
+
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Foundation.Collections.h>
+
+namespace wfc = winrt::Windows::Foundation::Collections;
+using winrt::Windows::Foundation::IInspectable;
+
+struct IndexChangedArgs : winrt::implements<IndexChangedArgs, wfc::IVectorChangedEventArgs> {
+    IndexChangedArgs(wfc::CollectionChange change, uint32_t index) : m_change(change), m_index(index) {}
+    wfc::CollectionChange CollectionChange() const { return m_change; }
+    uint32_t Index() const { return m_index; }
+private:
+    wfc::CollectionChange m_change;
+    uint32_t m_index;
+};
+
+struct IndexItemIterator : winrt::implements<IndexItemIterator, wfc::IIterator<IInspectable>> {
+    explicit IndexItemIterator(uint32_t size) : m_size(size) {}
+    IInspectable Current() const {
+        if (m_pos >= m_size) throw winrt::hresult_out_of_bounds();
+        return winrt::box_value(m_pos);
+    }
+    bool HasCurrent() const { return m_pos < m_size; }
+    bool MoveNext() { if (m_pos < m_size) ++m_pos; return m_pos < m_size; }
+    uint32_t GetMany(winrt::array_view<IInspectable> items) {
+        uint32_t n = 0;
+        while (n < items.size() && m_pos < m_size) items[n++] = winrt::box_value(m_pos++);
+        return n;
+    }
+private:
+    uint32_t m_size;
+    uint32_t m_pos = 0;
+};
+
+struct IndexItemSource : winrt::implements<IndexItemSource, wfc::IObservableVector<IInspectable>, wfc::IVector<IInspectable>, wfc::IIterable<IInspectable>> {
+    // Owner side: the view now has count positions (contents may all have changed)
+    void Reset(uint32_t count) {
+        m_size = count;
+        m_changed(*this, winrt::make<IndexChangedArgs>(wfc::CollectionChange::Reset, 0u));
+    }
+
+    // Position of a boxed item handed out by GetAt (SelectedItem etc.), or UINT32_MAX
+    static uint32_t PositionOf(IInspectable const& item) { return winrt::unbox_value_or<uint32_t>(item, UINT32_MAX); }
+
+    // IVector (read side)
+    IInspectable GetAt(uint32_t index) const {
+        if (index >= m_size) throw winrt::hresult_out_of_bounds();
+        return winrt::box_value(index);
+    }
+    uint32_t Size() const { return m_size; }
+    bool IndexOf(IInspectable const& value, uint32_t& index) const {
+        index = PositionOf(value);
+        return index < m_size;
+    }
+    uint32_t GetMany(uint32_t start, winrt::array_view<IInspectable> items) const {
+        uint32_t n = 0;
+        while (n < items.size() && start + n < m_size) { items[n] = winrt::box_value(start + n); ++n; }
+        return n;
+    }
+    wfc::IVectorView<IInspectable> GetView() const { throw winrt::hresult_not_implemented(); }
+    wfc::IIterator<IInspectable> First() const { return winrt::make<IndexItemIterator>(m_size); }
+
+    // IVector (write side): the grid never edits its source
+    void SetAt(uint32_t, IInspectable const&) { throw winrt::hresult_illegal_method_call(); }
+    void InsertAt(uint32_t, IInspectable const&) { throw winrt::hresult_illegal_method_call(); }
+    void RemoveAt(uint32_t) { throw winrt::hresult_illegal_method_call(); }
+    void Append(IInspectable const&) { throw winrt::hresult_illegal_method_call(); }
+    void RemoveAtEnd() { throw winrt::hresult_illegal_method_call(); }
+    void Clear() { throw winrt::hresult_illegal_method_call(); }
+    void ReplaceAll(winrt::array_view<IInspectable const>) { throw winrt::hresult_illegal_method_call(); }
+
+    // IObservableVector
+    winrt::event_token VectorChanged(wfc::VectorChangedEventHandler<IInspectable> const& handler) { return m_changed.add(handler); }
+    void VectorChanged(winrt::event_token const& token) noexcept { m_changed.remove(token); }
+
+private:
+    uint32_t m_size = 0;
+    winrt::event<wfc::VectorChangedEventHandler<IInspectable>> m_changed;
+};
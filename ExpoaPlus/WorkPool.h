@@ -0,0 +1,125 @@
+// WorkPool.h — small work-stealing thread pool for recursive, fan-out work (tree walks etc.)
+// - Each worker owns a deque: tasks submitted from a worker go to its own deque (LIFO, cache-warm),
+//   idle workers steal the oldest task from the others (FIFO, large subtrees first)
+// - Tasks submitted from outside are spread round-robin
+// - Submit / Take only touch one deque's lock and an atomic task count; the pool-wide mutex is taken
+//   by workers going to sleep and by Submit only when one is asleep (m_sleepers)
+// - WaitIdle() returns once every submitted task (including tasks they submitted) has finished
+// Tasks must not throw.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; ++i) m_queues.push_back(std::make_unique<Queue>());
+        for (unsigned i = 0; i < threads; ++i) m_threads.emplace_back([this, i]() { Run(i); });
+    }
+
+    ~WorkPool() {
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            m_stop.store(true);
+        }
+        m_wake.notify_all();
+        for (auto& t : m_threads) t.join();
+    }
+
+    unsigned Size() const { return (unsigned)m_threads.size(); }
+
+    void Submit(Task task) {
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        size_t q = Current().pool == this ? Current().index : m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+        {
+            std::lock_guard<std::mutex> lg(m_queues[q]->mutex);
+            m_queues[q]->tasks.push_back(std::move(task));
+        }
+        // seq_cst pair with Sleep(): either a sleeper sees the count or we see the sleeper
+        m_queued.fetch_add(1);
+        if (m_sleepers.load() > 0) {
+            { std::lock_guard<std::mutex> lg(m_mutex); }
+            m_wake.notify_one();
+        }
+    }
+
+    void WaitIdle() {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_idle.wait(lk, [this]() { return m_pending.load() == 0; });
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    struct WorkerId { WorkPool* pool; size_t index; };
+    static WorkerId& Current() { static thread_local WorkerId id{ nullptr, 0 }; return id; }
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;                    // sleeping / waking and WaitIdle only
+    std::condition_variable m_wake, m_idle;
+    std::atomic<size_t> m_queued{ 0 };     // tasks sitting in any deque (may briefly run ahead of Take)
+    std::atomic<size_t> m_sleepers{ 0 };   // workers blocked in m_wake; changed under m_mutex
+    std::atomic<size_t> m_pending{ 0 };    // submitted and not yet finished
+    std::atomic<size_t> m_next{ 0 };
+    std::atomic<bool> m_stop{ false };
+
+    bool Take(size_t self, Task& out) {
+        {
+            Queue& q = *m_queues[self];
+            std::lock_guard<std::mutex> lg(q.mutex);
+            if (!q.tasks.empty()) { out = std::move(q.tasks.back()); q.tasks.pop_back(); return true; }
+        }
+        for (size_t i = 1; i < m_queues.size(); ++i) {
+            Queue& q = *m_queues[(self + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lg(q.mutex);
+            if (!q.tasks.empty()) { out = std::move(q.tasks.front()); q.tasks.pop_front(); return true; }
+        }
+        return false;
+    }
+
+    // Block until a task may be available or the pool stops
+    void Sleep() {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_sleepers.fetch_add(1);
+        m_wake.wait(lk, [this]() { return m_stop.load() || m_queued.load() > 0; });
+        m_sleepers.fetch_sub(1);
+    }
+
+    void Run(size_t self) {
+        Current() = WorkerId{ this, self };
+        Task task;
+        for (;;) {
+            if (m_stop.load(std::memory_order_relaxed)) return;
+            if (!Take(self, task)) {
+                // a few quick retries before sleeping: fan-out work refills the deques constantly
+                bool got = false;
+                for (int spin = 0; spin < 16 && !got; ++spin) {
+                    std::this_thread::yield();
+                    got = m_queued.load(std::memory_order_relaxed) > 0 && Take(self, task);
+                }
+                if (!got) { Sleep(); continue; }
+            }
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            task = nullptr;
+            if (m_pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lg(m_mutex);
+                m_idle.notify_all();
+            }
+        }
+    }
+};
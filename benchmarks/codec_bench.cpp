@@ -0,0 +1,160 @@
+// Opening and saving a compressed log of 192 MB of generated text (.log.gz): the previous way
+// (decompress to a file on disk with gzread, then read that file into memory) against CodecReader
+// streaming 1 MB pieces, in MB/s of decoded text. Then the editor's loading pipeline: a worker
+// decodes while the UI thread appends from a queue of at most 16 pieces (as txtPlus does with its
+// TextQueue) — total time and the longest the UI thread is busy at once, against decoding inside
+// one synchronous EM_STREAMIN (the whole decode). Saving: CodecWriter at gzip levels 1 / 6 / 9, MB/s
+// and ratio (zstd too when compiled in). Page cache warm. Best of three. Optional argument: work directory.
+#include "Codec.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+static double Seconds(Clock::time_point since) { return std::chrono::duration<double>(Clock::now() - since).count(); }
+
+static bool Save(const fs::path& p, Compression kind, int level, const std::string& s) {
+    CodecWriter w;
+    if (!w.Open(p, kind, level)) return false;
+    for (size_t i = 0; i < s.size(); i += 65536)                      // EM_STREAMOUT sized pieces
+        if (!w.Write((const unsigned char*)s.data() + i, std::min<size_t>(65536, s.size() - i))) return false;
+    return w.Finish();
+}
+
+#if TXT_HAVE_ZLIB
+// Before Codec.h: the log was unpacked next to itself and the result opened as a plain file
+static size_t DecompressToDiskAndRead(const fs::path& gz, const fs::path& plain) {
+    gzFile in = gzopen(gz.string().c_str(), "rb");
+    std::ofstream out(plain, std::ios::binary | std::ios::trunc);
+    std::vector<char> buf(1 << 20);
+    for (int n; (n = gzread(in, buf.data(), (unsigned)buf.size())) > 0;) out.write(buf.data(), n);
+    gzclose(in);
+    out.close();
+    return ReadFile(plain).size();
+}
+#endif
+
+// CodecReader in the worker's 1 MB pieces; sink gets every piece
+static size_t Stream(const fs::path& p, const std::function<void(const unsigned char*, size_t)>& sink) {
+    CodecReader r;
+    if (!r.Open(p)) return 0;
+    std::vector<unsigned char> buf(1 << 20);
+    size_t total = 0;
+    for (size_t n; (n = r.Read(buf.data(), buf.size())) > 0; total += n) sink(buf.data(), n);
+    return r.Failed() ? 0 : total;
+}
+
+// Worker decodes into a bounded queue, this thread appends what is queued (the UI side of txtPlus).
+// Returns the longest single drain in seconds.
+static double Pipeline(const fs::path& p, std::string& text) {
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<std::string> queue;
+    bool done = false;
+    std::thread worker([&]() {
+        Stream(p, [&](const unsigned char* d, size_t n) {
+            std::unique_lock<std::mutex> lk(m);
+            cv.wait(lk, [&]() { return queue.size() < 16; });
+            queue.emplace_back((const char*)d, n);
+            cv.notify_all();
+        });
+        std::lock_guard<std::mutex> lk(m);
+        done = true;
+        cv.notify_all();
+    });
+    double longest = 0;
+    for (;;) {
+        std::deque<std::string> take;
+        {
+            std::unique_lock<std::mutex> lk(m);
+            cv.wait(lk, [&]() { return !queue.empty() || done; });
+            if (queue.empty()) break;
+            take.swap(queue);
+            cv.notify_all();
+        }
+        auto t = Clock::now();
+        for (auto const& s : take) text += s;
+        longest = std::max(longest, Seconds(t));
+    }
+    worker.join();
+    return longest;
+}
+
+int main(int argc, char** argv) {
+    if (!CompressionAvailable(Compression::Gzip)) { std::printf("gzip not compiled in\n"); return 0; }
+    fs::path base = argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path();
+    TestDir dir((base / "codec_bench").string());
+
+    std::mt19937 g(29);
+    const char* levels[] = { "INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR" };
+    const char* paths[] = { "/api/v1/items", "/api/v1/users", "/static/app.js", "/health", "/api/v2/search?q=" };
+    std::string text;
+    text.reserve(200u << 20);
+    for (uint64_t ms = 0; text.size() < (192u << 20); ms += g() % 40) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "2026-10-%02u %02u:%02u:%02u.%03u %-5s [worker-%u] GET %s/%u took %u ms status=%u\n",
+                      (unsigned)(1 + ms / 86400000 % 28), (unsigned)(ms / 3600000 % 24), (unsigned)(ms / 60000 % 60), (unsigned)(ms / 1000 % 60),
+                      (unsigned)(ms % 1000), levels[g() % 6], (unsigned)(g() % 16), paths[g() % 5], (unsigned)(g() % 100000),
+                      (unsigned)(g() % 900), g() % 20 ? 200u : 500u);
+        text += line;
+    }
+    const double mb = text.size() / 1e6;
+    fs::path gz = dir / "app.log.gz";
+    if (!Save(gz, Compression::Gzip, 0, text)) { std::printf("cannot write %s\n", gz.string().c_str()); return 1; }
+    std::printf("%.0f MB of log text, %.1f MB as gzip\n", mb, fs::file_size(gz) / 1e6);
+    std::printf("  %-34s %10s %10s\n", "open", "MB/s", "ms");
+
+#if TXT_HAVE_ZLIB
+    size_t got = 0;
+    double t = Best([&]() { got = DecompressToDiskAndRead(gz, dir / "app.log"); });
+    std::printf("  %-34s %10.0f %10.0f\n", "unpack to disk, then read (old)", mb / t, t * 1e3);
+    if (got != text.size()) std::printf("  size mismatch: %zu\n", got);
+    fs::remove(dir / "app.log");
+#endif
+    size_t sink = 0;
+    t = Best([&]() { sink += Stream(gz, [](const unsigned char*, size_t) {}); });
+    std::printf("  %-34s %10.0f %10.0f\n", "CodecReader, 1 MB pieces", mb / t, t * 1e3);
+
+    std::string loaded;
+    double longest = 0;
+    t = Best([&]() {
+        loaded.clear();
+        longest = Pipeline(gz, loaded);
+    });
+    std::printf("  %-34s %10.0f %10.0f  (UI busy at most %.1f ms at once)\n", "worker + UI queue", mb / t, t * 1e3, longest * 1e3);
+    if (loaded != text) std::printf("  pipeline text differs\n");
+    t = Best([&]() {
+        loaded.clear();
+        Stream(gz, [&](const unsigned char* d, size_t n) { loaded.append((const char*)d, n); });
+    });
+    std::printf("  %-34s %10.0f %10.0f  (UI busy %.0f ms at once)\n", "synchronous EM_STREAMIN (old)", mb / t, t * 1e3, t * 1e3);
+
+    std::printf("  %-34s %10s %10s\n", "save", "MB/s", "ratio");
+    std::vector<std::pair<Compression, int>> saves = { { Compression::Gzip, 1 }, { Compression::Gzip, 6 }, { Compression::Gzip, 9 } };
+    if (CompressionAvailable(Compression::Zstd))
+        for (int level : { 1, 3, 19 }) saves.push_back({ Compression::Zstd, level });
+    for (auto [kind, level] : saves) {
+        fs::path out = dir / (kind == Compression::Gzip ? "out.log.gz" : "out.log.zst");
+        t = Best([&]() { Save(out, kind, level, text); });
+        char label[48];
+        std::snprintf(label, sizeof(label), "CodecWriter %s -%d", kind == Compression::Gzip ? "gzip" : "zstd", level);
+        std::printf("  %-34s %10.0f %10.1f\n", label, mb / t, (double)text.size() / fs::file_size(out));
+    }
+    return sink == 0;
+}
@@ -0,0 +1,97 @@
+// CopyEngine against a naive copy (one file after another, 64 KB ifstream/ofstream loop) and
+// std::filesystem::copy, on 5000 small files (4-64 KB in 50 folders) and one 1 GB file.
+// Best of three rounds each, sync() included; pass a work directory on the disk to measure
+// (default: system temp dir). Needs ~1.5 GB free space twice.
+#include "CopyEngine.h"
+#include "TestUtil.h"
+
+#include <sys/resource.h>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static void NaiveCopy(const fs::path& src, const fs::path& dst) {
+    std::vector<char> buf(64 << 10);
+    for (auto const& e : fs::recursive_directory_iterator(src)) {
+        fs::path t = dst / fs::relative(e.path(), src.parent_path());
+        if (e.is_directory()) { fs::create_directories(t); continue; }
+        fs::create_directories(t.parent_path());
+        std::ifstream in(e.path(), std::ios::binary);
+        std::ofstream out(t, std::ios::binary);
+        while (in.read(buf.data(), (std::streamsize)buf.size()) || in.gcount()) out.write(buf.data(), in.gcount());
+    }
+}
+
+static void EngineCopy(const fs::path& src, const fs::path& dst, bool fastPath, bool verify) {
+    CopyEngine e;
+    CopyJob j;
+    j.sources = { src };
+    j.target = dst;
+    j.options.fastPath = fastPath;
+    j.options.verify = verify;
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = false;
+    j.onDone = [&](const CopyResult& r) {
+        if (!r.failures.empty()) std::printf("  %zu failures\n", r.failures.size());
+        std::lock_guard<std::mutex> lg(m);
+        done = true;
+        cv.notify_all();
+    };
+    e.Enqueue(std::move(j));
+    std::unique_lock<std::mutex> lk(m);
+    cv.wait(lk, [&]() { return done; });
+}
+
+static double CpuSeconds() {
+    rusage u;
+    getrusage(RUSAGE_SELF, &u);
+    return (double)(u.ru_utime.tv_sec + u.ru_stime.tv_sec) + (double)(u.ru_utime.tv_usec + u.ru_stime.tv_usec) / 1e6;
+}
+
+struct Method {
+    const char* name;
+    std::function<void(const fs::path& src, const fs::path& dst)> run;
+    double best = 1e9, cpu = 0;
+};
+
+// Round robin with a warm-up round that is not counted: deleting the previous copy (discard, journal
+// commits) slows whatever runs next, so every method gets the same predecessor once
+static void Measure(const fs::path& src, const fs::path& dst, std::vector<Method>& methods) {
+    for (int round = 0; round < 4; ++round) {
+        for (auto& m : methods) {
+            fs::remove_all(dst);
+            fs::create_directories(dst);
+            sync();
+            double c0 = CpuSeconds();
+            auto t = Clock::now();
+            m.run(src, dst);
+            sync();
+            double s = std::chrono::duration<double>(Clock::now() - t).count();
+            if (round > 0 && s < m.best) { m.best = s; m.cpu = CpuSeconds() - c0; }
+        }
+    }
+    for (auto const& m : methods) std::printf("  %-28s %7.2f s  (cpu %.2f s)\n", m.name, m.best, m.cpu);
+    std::fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    fs::path root = (argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path()) / ("copy_bench-" + std::to_string(getpid()));
+    std::mt19937 g(1);
+    for (int i = 0; i < 5000; ++i) WriteRandom(root / "small" / ("d" + std::to_string(i % 50)) / ("f" + std::to_string(i)), 4096 + g() % 61440, i);
+    WriteRandom(root / "large" / "big.bin", 1ull << 30, 5);
+    fs::path dst = root / "out";
+    for (const char* set : { "small", "large" }) {
+        std::vector<Method> methods{
+            { "naive (64 KB streams)", NaiveCopy },
+            { "std::filesystem::copy", [](const fs::path& s, const fs::path& d) { fs::copy(s, d / s.filename(), fs::copy_options::recursive); } },
+            { "engine, read/write", [](const fs::path& s, const fs::path& d) { EngineCopy(s, d, false, false); } },
+            { "engine, fast path", [](const fs::path& s, const fs::path& d) { EngineCopy(s, d, true, false); } },
+            { "engine, fast path + verify", [](const fs::path& s, const fs::path& d) { EngineCopy(s, d, true, true); } },
+        };
+        std::printf("%s:\n", set);
+        Measure(root / set, dst, methods);
+    }
+    fs::remove_all(root);
+    return 0;
+}
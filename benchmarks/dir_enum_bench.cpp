@@ -0,0 +1,85 @@
+// EnumerateDirectory on one folder of 1M files against std::filesystem::directory_iterator (with a
+// status() per entry, as the listing did before) and plain readdir: entries/s for the whole folder and
+// time to the first entry or batch. getdents64 with and without fstatat. The folder is created once (empty
+// files, ~1 min) and is warm in the dentry cache; best of three. Optional argument: work directory.
+#include "DirEnum.h"
+#include "TestUtil.h"
+
+#include <fcntl.h>
+#include <functional>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+struct Timing {
+    double total = 1e9, first = 1e9;
+    size_t entries = 0;
+};
+
+// fn(onEntry) enumerates; onEntry(count) is called per entry or batch
+static Timing Best(const std::function<void(const std::function<void(size_t)>&)>& fn) {
+    Timing best;
+    for (int i = 0; i < 3; ++i) {
+        size_t n = 0;
+        double first = -1;
+        auto t = Clock::now();
+        fn([&](size_t k) {
+            if (first < 0) first = std::chrono::duration<double>(Clock::now() - t).count();
+            n += k;
+        });
+        best.total = std::min(best.total, std::chrono::duration<double>(Clock::now() - t).count());
+        best.first = std::min(best.first, first);
+        best.entries = n;
+    }
+    return best;
+}
+
+static void Print(const char* name, const Timing& t) {
+    std::printf("  %-30s %8.0f ms %10.0f k entries/s   first result %6.2f ms%s\n", name, t.total * 1e3, t.entries / t.total / 1e3,
+                t.first * 1e3, t.entries == 1000000 ? "" : "  COUNT MISMATCH");
+}
+
+int main(int argc, char** argv) {
+    fs::path root = (argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path()) / ("dir_enum_bench-" + std::to_string(getpid()));
+    fs::path dir = root / "many";
+    fs::create_directories(dir);
+    const int n = 1000000;
+    for (int i = 0; i < n; ++i) {
+        std::string name = (dir / ("file_" + std::to_string(i) + ".dat")).string();
+        int fd = ::open(name.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd < 0) { std::printf("create failed at %d\n", i); return 1; }
+        ::close(fd);
+    }
+    std::printf("1M files in one folder:\n");
+
+    Print("directory_iterator + status", Best([&](const std::function<void(size_t)>& on) {
+        for (auto const& e : fs::directory_iterator(dir)) {
+            std::error_code ec;
+            auto st = fs::status(e.path(), ec);
+            auto size = st.type() == fs::file_type::regular ? fs::file_size(e.path(), ec) : 0;
+            (void)size;
+            on(1);
+        }
+    }));
+    Print("directory_iterator", Best([&](const std::function<void(size_t)>& on) {
+        for (auto const& e : fs::directory_iterator(dir)) { (void)e; on(1); }
+    }));
+    Print("readdir", Best([&](const std::function<void(size_t)>& on) {
+        DIR* d = opendir(dir.c_str());
+        while (const dirent* e = readdir(d))
+            if (strcmp(e->d_name, ".") && strcmp(e->d_name, "..")) on(1);
+        closedir(d);
+    }));
+    std::atomic<bool> cancel{ false };
+    for (bool stat : { true, false }) {
+        DirEnumOptions opt;
+        opt.wantStat = stat;
+        Print(stat ? "EnumerateDirectory (fstatat)" : "EnumerateDirectory (names)", Best([&](const std::function<void(size_t)>& on) {
+            EnumerateDirectory(dir, opt, cancel, [&](std::vector<DirEntry>&& b) { on(b.size()); });
+        }));
+    }
+
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Folder sizes below a generated tree of 200k files in 10k folders (20 subfolders of the root, three
+// levels; sparse files of random size): the previous AnalyzeSizes loop (ComputeSizeRecursive, one
+// recursive_directory_iterator walk per subfolder of the root, on one thread) against DiskUsage at
+// 1/2/4/8 threads; DiskUsage again with a filled cache, with 1% of the folders changed, and the
+// treemap of the result. Page cache warm. Best of three. Optional argument: work directory.
+#include "DiskUsage.h"
+#include "TestUtil.h"
+
+#include <chrono>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+// The analysis before DiskUsage, minus the Win32 types and the dialog
+static uint64_t ComputeSizeRecursive(const fs::path& path) {
+    uint64_t total = 0;
+    try {
+        for (auto const& e : fs::recursive_directory_iterator(path)) {
+            try {
+                if (e.is_regular_file()) total += (uint64_t)fs::file_size(e.path());
+            } catch (...) {}
+        }
+    } catch (...) {}
+    return total;
+}
+
+static std::vector<std::pair<std::string, uint64_t>> AnalyzeSizes(const fs::path& root) {
+    std::vector<std::pair<std::string, uint64_t>> sizes;
+    for (auto const& e : fs::directory_iterator(root)) {
+        if (e.is_directory()) sizes.push_back({ e.path().filename().string(), ComputeSizeRecursive(e.path()) });
+        else sizes.push_back({ e.path().filename().string(), (uint64_t)e.file_size() });
+    }
+    std::sort(sizes.begin(), sizes.end(), [](auto const& a, auto const& b) { return a.second > b.second; });
+    return sizes;
+}
+
+int main(int argc, char** argv) {
+    fs::path base = argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path();
+    TestDir dir((base / "disk_usage_bench").string());
+    fs::path root = dir / "tree";
+    std::mt19937 g(49);
+    std::vector<fs::path> leaves;
+    size_t files = 0;
+    for (int a = 0; a < 20; ++a)
+        for (int b = 0; b < 25; ++b)
+            for (int c = 0; c < 20; ++c) {
+                fs::path d = root / ("area" + std::to_string(a)) / ("group" + std::to_string(b)) / ("folder" + std::to_string(c));
+                fs::create_directories(d);
+                leaves.push_back(d);
+                for (int f = 0; f < 20; ++f, ++files) {
+                    fs::path p = d / ("file" + std::to_string(f) + ".dat");
+                    std::ofstream(p).close();
+                    fs::resize_file(p, (uint64_t)std::exp((g() % 2000) / 100.0));   // 1 B .. 485 MB, sparse
+                }
+            }
+    std::printf("%zu files in %zu folders\n", files, leaves.size() + 20 * 25 + 20 + 1);
+    std::printf("  %-26s %10s %14s\n", "analysis", "ms", "bytes");
+
+    uint64_t serialBytes = 0;
+    double t = Best([&]() {
+        serialBytes = 0;
+        for (auto const& s : AnalyzeSizes(root)) serialBytes += s.second;
+    });
+    std::printf("  %-26s %10.0f %14llu\n", "serial (old)", t * 1e3, (unsigned long long)serialBytes);
+
+    DiskUsageOptions opt;
+    for (unsigned threads : { 1u, 2u, 4u, 8u }) {
+        opt.threads = threads;
+        uint64_t bytes = 0;
+        t = Best([&]() { bytes = DiskUsage().Run(root, opt)->total.bytes; });
+        char label[32];
+        std::snprintf(label, sizeof(label), "DiskUsage x%u", threads);
+        std::printf("  %-26s %10.0f %14llu\n", label, t * 1e3, (unsigned long long)bytes);
+    }
+
+    opt.threads = 4;
+    DiskUsageCache cache;
+    DiskUsage().Run(root, opt, nullptr, &cache);
+    uint64_t cachedDirs = 0;
+    std::unique_ptr<DiskUsageDir> tree;
+    t = Best([&]() {
+        tree = DiskUsage().Run(root, opt, [&](const DiskUsageProgress& p) { cachedDirs = p.cachedDirs; }, &cache);
+    });
+    std::printf("  %-26s %10.0f %14llu  (%llu folders not listed)\n", "repeat, cached x4", t * 1e3, (unsigned long long)tree->total.bytes,
+                (unsigned long long)cachedDirs);
+    // each round adds a file to 1% of the leaf folders, so those are listed again every time
+    int round = 0;
+    t = Best([&]() {
+        for (size_t i = 0; i < leaves.size(); i += 100) WriteFile(leaves[i] / ("new" + std::to_string(round)), "x");
+        ++round;
+        tree = DiskUsage().Run(root, opt, [&](const DiskUsageProgress& p) { cachedDirs = p.cachedDirs; }, &cache);
+    });
+    std::printf("  %-26s %10.0f %14llu  (%llu folders not listed)\n", "1% changed, cached x4", t * 1e3, (unsigned long long)tree->total.bytes,
+                (unsigned long long)cachedDirs);
+
+    std::vector<DiskUsageRect> rects;
+    t = Best([&]() {
+        rects.clear();
+        DiskUsageTreemap(*tree, 0, 0, 1600, 900, 3, 4, rects);
+    });
+    std::printf("treemap, 3 levels: %zu rectangles in %.2f ms\n", rects.size(), t * 1e3);
+    return 0;
+}
@@ -0,0 +1,95 @@
+// DuplicateFinder against the naive approach (walk, hash every file completely, group by digest) with
+// SHA-1 (what ComputeFileSHA1 did) and with FastHash128: time and bytes read on a generated tree of
+// 20k files, ~1.2 GB: mostly small files, 2000 equal-sized 64 KB files that differ (bitmaps of one
+// dimension), a few hundred large ones, ~10% of all files copied elsewhere. Page cache warm, so this
+// is the CPU + syscall side; on a cold disk the bytes-read column is what counts. Best of three.
+// Optional argument: work directory.
+#include "DuplicateFinder.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <functional>
+#include <map>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+struct Result { size_t groups = 0; uint64_t wasted = 0, bytesRead = 0; };
+
+static Result Naive(const fs::path& root, HashAlgo algo) {
+    std::map<std::pair<uint64_t, HashDigest>, size_t> seen;
+    Result r;
+    for (auto const& e : fs::recursive_directory_iterator(root)) {
+        if (!e.is_regular_file() || e.file_size() == 0) continue;
+        HashDigest d;
+        if (!HashFile(e.path(), algo, d, nullptr, HashFileOptions(), &r.bytesRead)) continue;
+        size_t n = ++seen[{ e.file_size(), d }];
+        if (n == 2) r.groups++;
+        if (n >= 2) r.wasted += e.file_size();
+    }
+    return r;
+}
+
+static Result Finder(const fs::path& root, bool verify) {
+    DuplicateFinder f;
+    DupOptions opt;
+    opt.verifyBytes = verify;
+    DupStages st;
+    DupProgress last;
+    st.onProgress = [&](const DupProgress& p) { last = p; };
+    f.Run({ root }, opt, st);
+    return Result{ (size_t)last.groups, last.wastedBytes, last.bytesRead };
+}
+
+int main(int argc, char** argv) {
+    fs::path base = argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path();
+    TestDir dir((base / "dup_bench").string());
+    fs::path root = dir / "tree";
+    {
+        std::mt19937 g(38);
+        std::vector<std::string> originals;
+        auto content = [&](size_t n) {
+            std::string s(n, '\0');
+            for (size_t i = 0; i < n; i += 4) { uint32_t v = g(); memcpy(&s[i], &v, std::min<size_t>(4, n - i)); }
+            return s;
+        };
+        int made = 0;
+        auto put = [&](const std::string& c) {
+            WriteFile(root / ("d" + std::to_string(made % 97)) / ("s" + std::to_string(made % 13)) / ("f" + std::to_string(made) + ".bin"), c);
+            made++;
+        };
+        for (int i = 0; i < 15700; ++i) { std::string c = content(1 + g() % 32768); put(c); if (g() % 10 == 0) originals.push_back(c); }
+        for (int i = 0; i < 2000; ++i) { std::string c = content(65536); put(c); if (g() % 10 == 0) originals.push_back(c); }
+        for (int i = 0; i < 300; ++i) { std::string c = content((1u << 20) + g() % (3u << 20)); put(c); if (g() % 10 == 0) originals.push_back(c); }
+        for (auto const& c : originals) put(c);
+    }
+    uint64_t total = 0;
+    size_t files = 0;
+    for (auto const& e : fs::recursive_directory_iterator(root)) if (e.is_regular_file()) { total += e.file_size(); files++; }
+    std::printf("%zu files, %.0f MB\n", files, total / 1048576.0);
+
+    auto row = [](const char* name, double t, const Result& r) {
+        std::printf("  %-26s %8.0f ms   %8.1f MB read   %5zu groups, %.1f MB wasted\n", name, t * 1e3, r.bytesRead / 1048576.0, r.groups,
+                    r.wasted / 1048576.0);
+    };
+    Result r;
+    double t = Best([&]() { r = Naive(root, HashAlgo::Sha1); });
+    row("naive SHA-1", t, r);
+    t = Best([&]() { r = Naive(root, HashAlgo::Fast128); });
+    row("naive FastHash128", t, r);
+    t = Best([&]() { r = Finder(root, false); });
+    row("DuplicateFinder", t, r);
+    t = Best([&]() { r = Finder(root, true); });
+    row("DuplicateFinder + verify", t, r);
+    return 0;
+}
@@ -0,0 +1,106 @@
+// FileIndex load time and memory for 2M files (2-5 folder levels, 0-3 tags, SHA-1 hashes):
+// one-time migration from a JsonCpp-style index.json (IndexJsonImporter + Compact), then the mapped
+// index.bin: Open time and heap bytes after Open (glibc mallinfo2), random Find, a full ForEach, and a
+// tag posting scan; Open with all checksums verified for comparison. Page cache warm. Optional
+// argument: work directory.
+#include "FileIndex.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <functional>
+#include <malloc.h>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static size_t HeapBytes() {
+    struct mallinfo2 m = mallinfo2();
+    return m.uordblks + m.hblkhd;
+}
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+static double Seconds(Clock::time_point t) { return std::chrono::duration<double>(Clock::now() - t).count(); }
+
+int main(int argc, char** argv) {
+    fs::path base = argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path();
+    TestDir dir((base / "file_index_bench").string());
+    const size_t n = 2000000;
+    std::vector<std::string> paths;
+    paths.reserve(n);
+    {
+        std::mt19937 g(35);
+        const char* tags[] = { "invoice", "2024", "holiday", "report", "draft", "photo", "tax", "contract", "scan", "music" };
+        std::string json = "{\n";
+        for (size_t i = 0; i < n; ++i) {
+            std::string p = "/home/user";
+            for (int d = 0, depth = 2 + g() % 4; d < depth; ++d) p += "/folder" + std::to_string(d) + "_" + std::to_string(g() % 8);
+            p += "/document_" + std::to_string(i) + ".txt";
+            paths.push_back(p);
+            std::string hex;
+            for (int k = 0; k < 40; ++k) hex += "0123456789abcdef"[g() % 16];
+            json += (i ? ",\n  \"" : "  \"") + p + "\" : \n  {\n    \"path\" : \"" + p + "\",\n    \"sha1\" : \"" + hex +
+                    "\",\n    \"size\" : " + std::to_string(g() % 10000000);
+            if (unsigned t = g() % 4) {
+                json += ",\n    \"tags\" : \n    [";
+                for (unsigned k = 0; k < t; ++k) json += std::string(k ? "," : "") + "\n      \"" + tags[g() % 10] + "\"";
+                json += "\n    ]";
+            }
+            json += "\n  }";
+        }
+        json += "\n}\n";
+        WriteFile(dir / "index.json", json);
+    }
+    std::printf("%zu files, index.json %.0f MB\n", n, fs::file_size(dir / "index.json") / 1048576.0);
+
+    {
+        size_t h0 = HeapBytes();
+        auto t = Clock::now();
+        FileIndex idx;
+        idx.Open(dir / "idx");
+        if (!IndexJsonImporter::Import(dir / "index.json", idx)) std::printf("  import failed\n");
+        double tImport = Seconds(t);
+        size_t heap = HeapBytes() - h0;
+        t = Clock::now();
+        idx.Compact();
+        std::printf("  %-22s %7.0f ms   (log overlay %.0f MB heap)\n", "migrate: import", tImport * 1e3, heap / 1048576.0);
+        std::printf("  %-22s %7.0f ms   (index.bin %.0f MB)\n", "migrate: compact", Seconds(t) * 1e3,
+                    fs::file_size(dir / "idx" / "index.bin") / 1048576.0);
+    }
+    malloc_trim(0);
+
+    double tOpen = Best([&]() { FileIndex idx; idx.Open(dir / "idx"); });
+    double tVerify = Best([&]() { FileIndex idx; idx.Open(dir / "idx", true); });
+    size_t h0 = HeapBytes();
+    FileIndex idx;
+    idx.Open(dir / "idx");
+    size_t heap = HeapBytes() - h0;
+    std::printf("  %-22s %7.2f ms   (heap %.1f KB, %zu entries)\n", "open index.bin", tOpen * 1e3, heap / 1024.0, idx.Size());
+    std::printf("  %-22s %7.0f ms\n", "open + verify", tVerify * 1e3);
+
+    std::mt19937 g(1);
+    std::vector<IndexString> probe(200000);
+    for (auto& p : probe) p = fs::path(paths[g() % n]).native();
+    size_t found = 0;
+    double tFind = Best([&]() {
+        FileIndexEntry e;
+        found = 0;
+        for (auto const& p : probe) found += idx.Find(p, e);
+    });
+    std::printf("  %-22s %7.0f ns/find (%zu of %zu found)\n", "Find", tFind / probe.size() * 1e9, found, probe.size());
+    uint64_t total = 0;
+    double tScan = Best([&]() { total = 0; idx.ForEach([&](const FileIndexEntry& e) { total += e.size; }); });
+    std::printf("  %-22s %7.0f ms\n", "ForEach", tScan * 1e3);
+    size_t tagged = 0;
+    double tTag = Best([&]() { tagged = idx.TagCount(fs::path("invoice").native()); });
+    std::printf("  %-22s %7.0f ms   (%zu files)\n", "TagCount(invoice)", tTag * 1e3, tagged);
+    return 0;
+}
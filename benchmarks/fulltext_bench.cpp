@@ -0,0 +1,112 @@
+// Full-text search over 50k generated documents (~150 words each, Zipf-like vocabulary of 20k words):
+// index build time, segments and bytes, then ms per query for words, a phrase, OR, exclusion and a
+// prefix, with the index split into many small segments and again after MergeAll(); a substring
+// scan over the raw texts (what searching inside files costs without an index) as the baseline.
+// Page cache warm. Best of three. Optional argument: work directory.
+#include "FullTextIndex.h"
+#include "TestUtil.h"
+
+#include <chrono>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+struct Query {
+    std::string text;
+    std::vector<std::string> all, any, none;      // the scan: every `all`, one `any` if given, no `none`
+};
+
+int main(int argc, char** argv) {
+    fs::path base = argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path();
+    TestDir dir((base / "fulltext_bench").string());
+
+    // vocabulary: 20k distinct lower-case words, the one of rank r drawn with weight 1/(r+1)
+    std::vector<std::string> vocab(20000);
+    for (size_t r = 0; r < vocab.size(); ++r) {
+        for (size_t v = r + 26 * 26; v; v /= 26) vocab[r] += (char)('a' + v % 26);
+    }
+    std::vector<double> cdf(vocab.size());
+    double sum = 0;
+    for (size_t r = 0; r < vocab.size(); ++r) cdf[r] = sum += 1.0 / (r + 1);
+    std::mt19937 g(43);
+    std::uniform_real_distribution<double> u(0, sum);
+    const size_t docs = 50000;
+    std::vector<std::string> texts(docs);
+    size_t bytes = 0;
+    for (auto& t : texts) {
+        for (int w = 0, n = 100 + g() % 100; w < n; ++w) {
+            if (w) t += ' ';
+            t += vocab[std::lower_bound(cdf.begin(), cdf.end(), u(g)) - cdf.begin()];
+        }
+        bytes += t.size();
+    }
+    const std::string& common = vocab[3], & mid = vocab[40], & rare = vocab[900], & rare2 = vocab[1500];
+
+    FullTextOptions fo;
+    fo.bufferBytes = 4u << 20;                    // many small segments before the merge
+    fo.backgroundMerge = false;
+    FullTextIndex index;
+    CHECK(index.Open(dir / "index", fo));
+    auto t = Clock::now();
+    for (size_t i = 0; i < docs; ++i)
+        index.AddText(fs::path("/corpus/d" + std::to_string(i % 100) + "/doc" + std::to_string(i) + ".txt").native(), texts[i].size(), 1, texts[i]);
+    CHECK(index.Commit());
+    FullTextStats st = index.Stats();
+    std::printf("%zu documents, %.0f MB text; build %.0f ms, %zu segments, %.1f MB\n", docs, bytes / 1e6,
+                std::chrono::duration<double>(Clock::now() - t).count() * 1e3, st.segments, st.bytes / 1e6);
+
+    std::string prefix = rare.substr(0, 2);
+    std::vector<Query> queries = {
+        { mid + " " + rare, { mid, rare }, {}, {} },
+        { common + " " + mid, { common, mid }, {}, {} },
+        { "\"" + common + " " + mid + "\"", { common + " " + mid }, {}, {} },
+        { rare + " OR " + rare2, {}, { rare, rare2 }, {} },
+        { mid + " -" + common, { mid }, {}, { common } },
+        { prefix + "*", { prefix }, {}, {} },
+    };
+
+    std::printf("  %-22s %10s %10s %10s %9s\n", "query", "scan ms", "segments", "merged", "hits");
+    std::vector<double> before(queries.size());
+    std::vector<uint64_t> hits(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        FullTextQueryStats qs;
+        before[i] = Best([&]() { index.Query(fs::path(queries[i].text).native(), FullTextQueryOptions(), &qs); });
+        hits[i] = qs.matches;
+    }
+    t = Clock::now();
+    index.MergeAll();
+    double merge = std::chrono::duration<double>(Clock::now() - t).count();
+    size_t segments = index.Stats().segments;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        auto const& q = queries[i];
+        size_t scanHits = 0;
+        double scan = Best([&]() {
+            scanHits = 0;
+            for (auto const& text : texts) {
+                bool ok = true;
+                for (auto const& w : q.all) ok = ok && text.find(w) != std::string::npos;
+                if (ok && !q.any.empty()) ok = std::any_of(q.any.begin(), q.any.end(), [&](const std::string& w) { return text.find(w) != std::string::npos; });
+                for (auto const& w : q.none) ok = ok && text.find(w) == std::string::npos;
+                scanHits += ok;
+            }
+        });
+        FullTextQueryStats qs;
+        double merged = Best([&]() { index.Query(fs::path(q.text).native(), FullTextQueryOptions(), &qs); });
+        CHECK(qs.matches == hits[i]);
+        // the scan matches substrings ("qic" inside "aqic"), so its count is an upper bound
+        std::printf("  %-22s %10.1f %10.2f %10.2f %9llu (scan %zu)\n", q.text.c_str(), scan * 1e3, before[i] * 1e3, merged * 1e3,
+                    (unsigned long long)hits[i], scanHits);
+    }
+    std::printf("MergeAll %.0f ms: %zu -> %zu segments\n", merge * 1e3, st.segments, segments);
+    return 0;
+}
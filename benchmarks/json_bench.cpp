@@ -0,0 +1,81 @@
+// JsonStream throughput in GB/s for Validate, Minify and Pretty on three 256 MB documents held in
+// memory: string-heavy records, number arrays, and an already pretty-printed file (long whitespace
+// runs). Fed in 1 MB chunks like the editor's worker; the sink only counts bytes. Best of three.
+#include "JsonStream.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <functional>
+
+using Clock = std::chrono::steady_clock;
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+static std::string Records(size_t bytes) {
+    std::string s = "[";
+    std::mt19937 g(1);
+    while (s.size() < bytes) {
+        if (s.size() > 1) s += ",";
+        s += "{\"id\":" + std::to_string(g() % 1000000) + ",\"name\":\"customer " + std::to_string(g()) +
+             "\",\"email\":\"someone" + std::to_string(g() % 9999) + "@example.com\",\"note\":\"" + std::string(20 + g() % 60, 'n') +
+             " \\\"quoted\\\" caf\xC3\xA9\",\"active\":" + (g() % 2 ? "true" : "false") + "}";
+    }
+    return s + "]";
+}
+
+static std::string Numbers(size_t bytes) {
+    std::string s = "[";
+    std::mt19937 g(2);
+    while (s.size() < bytes) {
+        s += s.size() > 1 ? ",[" : "[";
+        for (int i = 0; i < 16; ++i) s += (i ? "," : "") + std::to_string((int)(g() % 2000000) - 1000000) + "." + std::to_string(g() % 1000) + "e-3";
+        s += "]";
+    }
+    return s + "]";
+}
+
+static size_t Feed(const std::string& doc, JsonMode mode) {
+    size_t out = 0;
+    JsonStream js(mode, [&](const char*, size_t n) { out += n; });
+    const size_t chunk = 1 << 20;
+    for (size_t i = 0; i < doc.size(); i += chunk)
+        if (!js.Feed(doc.data() + i, std::min(chunk, doc.size() - i))) break;
+    if (!js.Finish()) std::printf("  invalid at %llu\n", (unsigned long long)js.ErrorOffset());
+    return out;
+}
+
+static void Run(const char* title, const std::string& doc) {
+    std::printf("%s (%.0f MB):\n", title, doc.size() / 1048576.0);
+    for (JsonMode mode : { JsonMode::Validate, JsonMode::Minify, JsonMode::Pretty }) {
+        size_t out = 0;
+        double t = Best([&]() { out = Feed(doc, mode); });
+        const char* name = mode == JsonMode::Validate ? "validate" : mode == JsonMode::Minify ? "minify" : "pretty";
+        std::printf("  %-22s %7.2f GB/s   (%.0f MB out)\n", name, doc.size() / t / 1e9, out / 1048576.0);
+    }
+    std::fflush(stdout);
+}
+
+int main() {
+    const size_t size = 256u << 20;
+    std::string records = Records(size);
+    Run("records", records);
+    Run("numbers", Numbers(size));
+    std::string pretty;
+    {
+        JsonStream js(JsonMode::Pretty, [&](const char* p, size_t n) { pretty.append(p, n); }, 4);
+        js.Feed(records.data(), records.size());
+        js.Finish();
+    }
+    records.clear();
+    records.shrink_to_fit();
+    Run("pretty-printed records", pretty);
+    return 0;
+}
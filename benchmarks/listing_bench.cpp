@@ -0,0 +1,122 @@
+// ListingStore against the former std::vector<FileItem> (name + full path as two std::wstring, a
+// com_ptr slot, size, FILETIME) for one folder of 1M entries and a recursive result of 1M entries in
+// 10000 folders: heap bytes (glibc mallinfo2, mmapped blocks included), fill, filter (copy vs.
+// position list), sort by name, lookup by path (linear search vs. hash index). Best of three; no
+// disk access. wchar_t is 4 bytes here, so the character arena is twice its size on Windows.
+#include "ListingStore.h"
+#include "TestUtil.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <malloc.h>
+
+using Clock = std::chrono::steady_clock;
+
+struct FileItem {
+    std::wstring name;
+    std::wstring fullPath;
+    bool isFolder;
+    uint64_t size;
+    uint64_t modifiedTime;
+    void* icon = nullptr;                     // was winrt::com_ptr
+};
+
+static size_t HeapBytes() {
+    struct mallinfo2 m = mallinfo2();
+    return m.uordblks + m.hblkhd;             // large vectors are mmapped by glibc
+}
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+static void Run(const char* title, const std::vector<std::wstring>& dirs, size_t n) {
+    std::vector<std::wstring> names(n);
+    std::mt19937 g(7);
+    for (size_t i = 0; i < n; ++i) names[i] = L"Document " + std::to_wstring(g() % 1000000) + L" final_v" + std::to_wstring(i) + L".docx";
+    auto dirOf = [&](size_t i) -> const std::wstring& { return dirs[i * dirs.size() / n]; };
+    std::vector<size_t> probes(1000);
+    for (auto& p : probes) p = g() % n;
+    std::printf("%s:\n", title);
+
+    // memory: one filled container, measured on its own
+    size_t h0 = HeapBytes();
+    std::vector<FileItem> items;
+    for (size_t i = 0; i < n; ++i) items.push_back({ names[i], dirOf(i) + names[i], false, i * 17, i });
+    size_t itemsBytes = HeapBytes() - h0;
+    h0 = HeapBytes();
+    ListingStore store;
+    for (size_t i = 0; i < n; ++i) store.Add(store.AddDir(dirOf(i)), names[i], false, i * 17, i);
+    size_t storeBytes = HeapBytes() - h0;
+    std::printf("  %-22s %10s %12s\n", "", "FileItem", "ListingStore");
+    std::printf("  %-22s %7.1f MB %9.1f MB   (MemoryBytes %.1f MB)\n", "heap", itemsBytes / 1048576.0, storeBytes / 1048576.0,
+                store.MemoryBytes() / 1048576.0);
+
+    double fillItems = Best([&]() {
+        std::vector<FileItem> v;
+        for (size_t i = 0; i < n; ++i) v.push_back({ names[i], dirOf(i) + names[i], false, i * 17, i });
+    });
+    double fillStore = Best([&]() {
+        ListingStore s;
+        for (size_t i = 0; i < n; ++i) s.Add(s.AddDir(dirOf(i)), names[i], false, i * 17, i);
+    });
+    std::printf("  %-22s %8.0f ms %9.0f ms\n", "fill", fillItems * 1e3, fillStore * 1e3);
+
+    size_t kept = 0;
+    double filterItems = Best([&]() {
+        std::vector<FileItem> filtered;
+        for (auto const& it : items) if (it.name.find(L"final_v1") != std::wstring::npos) filtered.push_back(it);
+        kept = filtered.size();
+    });
+    double filterStore = Best([&]() {
+        std::vector<uint32_t> view;
+        for (uint32_t i = 0; i < store.Size(); ++i) if (store.Name(i).find(L"final_v1") != std::wstring_view::npos) view.push_back(i);
+        if (view.size() != kept) std::printf("  filter mismatch\n");
+    });
+    std::printf("  %-22s %8.0f ms %9.0f ms   (%zu kept)\n", "filter", filterItems * 1e3, filterStore * 1e3, kept);
+
+    double sortItems = Best([&]() {
+        std::vector<FileItem> v = items;          // the listing was re-sorted from a copy
+        std::sort(v.begin(), v.end(), [](const FileItem& a, const FileItem& b) { return a.name < b.name; });
+    });
+    double sortStore = Best([&]() {
+        std::vector<uint32_t> view(store.Size());
+        for (uint32_t i = 0; i < view.size(); ++i) view[i] = i;
+        std::sort(view.begin(), view.end(), [&](uint32_t a, uint32_t b) { return store.Name(a) < store.Name(b); });
+    });
+    std::printf("  %-22s %8.0f ms %9.0f ms\n", "sort by name", sortItems * 1e3, sortStore * 1e3);
+
+    // lookup: 100 linear searches vs. the hash index (first Find() builds it, timed separately)
+    size_t found = 0;
+    auto t = Clock::now();
+    for (size_t k = 0; k < 100; ++k) {
+        std::wstring path = dirOf(probes[k]) + names[probes[k]];
+        found += std::find_if(items.begin(), items.end(), [&](const FileItem& it) { return it.fullPath == path; }) != items.end();
+    }
+    double linear = std::chrono::duration<double>(Clock::now() - t).count() / 100;
+    t = Clock::now();
+    store.Find(dirOf(0) + names[0]);
+    double build = std::chrono::duration<double>(Clock::now() - t).count();
+    t = Clock::now();
+    for (size_t p : probes) found += store.Find(dirOf(p) + names[p]) == p;
+    double hashed = std::chrono::duration<double>(Clock::now() - t).count() / probes.size();
+    std::printf("  %-22s %8.2f ms %9.2f us   (index built in %.0f ms)%s\n", "lookup by path", linear * 1e3, hashed * 1e6, build * 1e3,
+                found == 100 + probes.size() ? "" : "  MISSING");
+    std::fflush(stdout);
+}
+
+int main() {
+    const size_t n = 1000000;
+    Run("one folder, 1M entries", { L"C:\\Users\\someone\\Documents\\Archive\\" }, n);
+    std::vector<std::wstring> dirs;
+    for (int i = 0; i < 10000; ++i) dirs.push_back(L"C:\\Users\\someone\\Projects\\p" + std::to_wstring(i / 100) + L"\\src\\m" + std::to_wstring(i) + L"\\");
+    Run("search result, 1M entries in 10000 folders", dirs, n);
+    return 0;
+}
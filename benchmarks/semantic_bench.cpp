@@ -0,0 +1,153 @@
+// SemanticIndex on a synthetic collection of 200k files in 40 topics (names, folders and some text
+// drawn from the topic's words, mixed spellings, numbers and stray words from other topics):
+// full build, incremental build after 10k more files, Save(); then ms per query for the exact scan
+// with each dot-product kernel (portable, SSE4.1, AVX2 — HashCpu flags cleared) and for the HNSW
+// graph at several ef, with recall@10 against the exact scan (a graph hit counts if it scores at
+// least the exact 10th, so ties do not matter). Also how many of the top 20 are from the query's
+// topic. Best of three per query set. Optional argument: work directory.
+#include "SemanticIndex.h"
+#include "TestUtil.h"
+
+#include <chrono>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+static double Since(Clock::time_point t) { return std::chrono::duration<double>(Clock::now() - t).count(); }
+
+struct Corpus {
+    std::vector<std::vector<std::string>> topics;
+    std::mt19937 g{ 44 };
+
+    Corpus() {
+        // 40 topics of 30 made-up words each; no word belongs to two topics
+        const char* syll[] = { "ka", "lo", "mi", "nu", "pe", "ra", "si", "to", "ve", "zu", "bar", "den", "gor", "hil", "jun", "mek" };
+        for (int t = 0; t < 40; ++t) {
+            topics.emplace_back();
+            for (int w = 0; w < 30; ++w) {
+                int id = t * 30 + w;
+                std::string word;
+                for (int s = 0; s < 3; ++s, id /= 16) word += syll[id % 16];
+                topics.back().push_back(word);
+            }
+        }
+    }
+    const std::string& Word(int topic) { return topics[topic][std::min<size_t>(g() % 30, g() % 30)]; }   // early words more often
+
+    // a file of `topic`: path and (for text files) content
+    std::pair<std::string, std::string> File(int topic, size_t i) {
+        std::string name;
+        for (int w = 0, n = 1 + g() % 3; w < n; ++w) {
+            std::string word = g() % 8 ? Word(topic) : Word(g() % 40);
+            if (w && g() % 2) word[0] = (char)(word[0] - 32);     // camelCase
+            else if (w) name += "_- "[g() % 3];
+            name += word;
+        }
+        if (g() % 2) name += std::to_string(g() % 2000);
+        static const char* exts[] = { ".txt", ".md", ".pdf", ".jpg", ".docx", ".cpp" };
+        const char* ext = exts[g() % 6];
+        std::string path = "/data/" + Word(topic) + "/" + Word(topic) + std::to_string(i % 50) + "/" + name + ext;
+        std::string text;
+        if (ext[1] == 't' || ext[1] == 'm' || ext[1] == 'c') {
+            for (int w = 0; w < 60; ++w) (text += g() % 5 ? Word(topic) : Word(g() % 40)) += ' ';
+        }
+        return { path, text };
+    }
+};
+
+int main(int argc, char** argv) {
+    fs::path base = argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path();
+    TestDir dir((base / "semantic_bench").string());
+    const size_t files = 200000, more = 10000;
+    Corpus corpus;
+    size_t added = 0;
+    SemanticIndex index;
+    CHECK(index.Open(dir.Path()));
+    auto add = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            int topic = (int)(corpus.g() % 40);
+            auto [path, text] = corpus.File(topic, added++);
+            index.AddText(fs::path(path).native(), text.size(), 1, text);
+        }
+    };
+    add(files);
+    auto t = Clock::now();
+    index.Build();
+    double full = Since(t);
+    add(more);
+    t = Clock::now();
+    index.Build();
+    double incremental = Since(t);
+    t = Clock::now();
+    CHECK(index.Save());
+    double save = Since(t);
+    SemanticStats st = index.Stats();
+    CHECK(st.rows >= st.files && st.graph);   // a repeated path replaces its older file
+    std::printf("%zu files (%llu distinct): build %.1f s, +%zu incremental %.2f s, save %.0f MB in %.2f s\n", files + more,
+                (unsigned long long)st.files, full, more, incremental, fs::file_size(dir / "semantic.bin") / 1e6, save);
+
+    // queries: one to three words of a topic, some with a typo
+    std::vector<std::pair<int, IndexString>> queries;
+    for (int q = 0; q < 200; ++q) {
+        int topic = q % 40;
+        std::string text;
+        for (int w = 0, n = 1 + q % 3; w < n; ++w) (text += w ? " " : "") += corpus.Word(topic);
+        if (q % 4 == 3) text[text.size() / 2] = 'x';
+        queries.emplace_back(topic, fs::path(text).native());
+    }
+    SemanticQueryOptions exact;
+    exact.exact = true;
+    std::vector<std::vector<SemanticHit>> truth;
+    size_t onTopic = 0, shown = 0;
+    for (auto const& [topic, q] : queries) {
+        truth.push_back(index.Query(q, exact));
+        for (auto const& h : truth.back()) {
+            std::string p = fs::path(h.path).string();
+            onTopic += std::find(corpus.topics[topic].begin(), corpus.topics[topic].end(), p.substr(6, p.find('/', 6) - 6)) != corpus.topics[topic].end();
+            ++shown;
+        }
+    }
+    std::printf("exact top %zu: %.1f%% in the query's topic folder\n", exact.topK, 100.0 * onTopic / std::max<size_t>(1, shown));
+
+    std::printf("  %-22s %10s %10s\n", "search", "ms/query", "recall@10");
+    HashCpu& cpu = HashCpu::Get();
+    const HashCpu detected = cpu;
+    struct Kernel { const char* name; bool sse41, avx2; };
+    for (Kernel k : { Kernel{ "exact, portable", false, false }, Kernel{ "exact, SSE4.1", true, false }, Kernel{ "exact, AVX2", true, true } }) {
+        if ((k.sse41 && !detected.sse41) || (k.avx2 && !detected.avx2)) continue;
+        cpu = HashCpu();
+        cpu.sse41 = k.sse41;
+        cpu.avx2 = k.avx2;
+        double tq = Best([&]() { for (auto const& q : queries) index.Query(q.second, exact); });
+        std::printf("  %-22s %10.2f %10s\n", k.name, tq * 1e3 / queries.size(), "1");
+    }
+    cpu = detected;
+    for (size_t ef : { 32u, 64u, 96u, 200u }) {
+        SemanticQueryOptions opt;
+        opt.ef = ef;
+        double tq = Best([&]() { for (auto const& q : queries) index.Query(q.second, opt); });
+        size_t found = 0, wanted = 0;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            auto const& want = truth[i];
+            size_t k = std::min<size_t>(10, want.size());
+            if (!k) continue;
+            auto got = index.Query(queries[i].second, opt);
+            for (size_t j = 0; j < std::min(k, got.size()); ++j) found += got[j].score >= want[k - 1].score - 1e-6f;
+            wanted += k;
+        }
+        char label[32];
+        std::snprintf(label, sizeof(label), "HNSW ef=%zu", ef);
+        std::printf("  %-22s %10.2f %10.3f\n", label, tq * 1e3 / queries.size(), (double)found / std::max<size_t>(1, wanted));
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+// Sorting a view of 1M generated entries (camera / document / source names with numbers, mixed
+// case, 10% folders): the previous comparator (_wcsicmp on the names, two std::filesystem::path
+// objects per comparison for the type, std::sort of the positions over the FileItem vector) against
+// SortKeyTable — key build once, then Sort() at 1/2/4/8 threads — for name, type, size and date,
+// plus multi-key specs with folders first. Also 1M entries arriving in 1000 batches: Insert() per
+// batch against sorting the whole view again after each one. Best of three.
+#include "SortKeys.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <cwchar>
+#include <functional>
+
+using Clock = std::chrono::steady_clock;
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+// The items and the comparator before SortKeyTable, minus the Win32 types (_wcsicmp is wcscasecmp)
+struct FileItem { std::wstring name, fullPath; bool isFolder = false; uint64_t size = 0, modifiedTime = 0; };
+
+static void OldSort(std::vector<uint32_t>& view, const std::vector<FileItem>& src, int sortColumn, bool sortAscending) {
+    std::sort(view.begin(), view.end(), [&](uint32_t ia, uint32_t ib) {
+        const FileItem& a = src[ia];
+        const FileItem& b = src[ib];
+        int comparison = 0;
+        switch (sortColumn) {
+        case 0: comparison = wcscasecmp(a.name.c_str(), b.name.c_str()); break;
+        case 1: {
+            auto extA = std::filesystem::path(a.name).extension().wstring();
+            auto extB = std::filesystem::path(b.name).extension().wstring();
+            comparison = wcscasecmp(extA.c_str(), extB.c_str());
+            if (comparison == 0) comparison = wcscasecmp(a.name.c_str(), b.name.c_str());
+            break;
+        }
+        case 2: comparison = a.size < b.size ? -1 : a.size > b.size; break;
+        case 3: comparison = a.modifiedTime < b.modifiedTime ? -1 : a.modifiedTime > b.modifiedTime; break;
+        }
+        return sortAscending ? (comparison < 0) : (comparison > 0);
+    });
+}
+
+int main() {
+    const size_t n = 1000000;
+    std::mt19937 g(47);
+    const wchar_t* stems[] = { L"IMG_", L"DSC", L"Report ", L"report-", L"Scan ", L"invoice_", L"Track ", L"main", L"test_", L"Overview " };
+    const wchar_t* exts[] = { L".JPG", L".jpg", L".png", L".pdf", L".docx", L".txt", L".cpp", L".h", L".mp3", L".tar.gz" };
+    std::vector<FileItem> items(n);
+    for (auto& it : items) {
+        it.isFolder = g() % 10 == 0;
+        it.name = stems[g() % 10];
+        it.name += std::to_wstring(g() % 20000);
+        if (g() % 3 == 0) it.name += L" (" + std::to_wstring(1 + g() % 9) + L")";
+        if (!it.isFolder) it.name += exts[g() % 10];
+        it.fullPath = L"C:\\Users\\someone\\Pictures\\" + it.name;
+        it.size = it.isFolder ? 0 : g() % (1u << 30);
+        it.modifiedTime = 132000000000000000ull + g() % 10000000000000ull;
+    }
+    std::vector<uint32_t> all(n);
+    for (uint32_t i = 0; i < n; ++i) all[i] = i;
+    std::printf("%zu entries\n", n);
+    std::printf("  %-28s %10s\n", "sort", "ms");
+
+    std::vector<uint32_t> view;
+    const char* columns[] = { "name", "type", "size", "date" };
+    for (int c = 0; c < 4; ++c) {
+        double t = Best([&]() {
+            view = all;
+            OldSort(view, items, c, true);
+        });
+        char label[48];
+        std::snprintf(label, sizeof(label), "old, %s", columns[c]);
+        std::printf("  %-28s %10.0f\n", label, t * 1e3);
+    }
+
+    SortKeyTable table;
+    double t = Best([&]() {
+        table.Clear();
+        for (auto const& it : items) table.Add(it.name, it.isFolder, it.size, it.modifiedTime);
+    });
+    std::printf("  %-28s %10.0f\n", "SortKeyTable, keys", t * 1e3);
+
+    struct Named { const char* label; SortSpec spec; };
+    const Named specs[] = {
+        { "name", { { { SortField::Name, true } }, false } },
+        { "type", { { { SortField::Type, true }, { SortField::Name, true } }, false } },
+        { "size", { { { SortField::Size, true } }, false } },
+        { "date", { { { SortField::Date, true } }, false } },
+        { "folders, name desc", { { { SortField::Name, false } }, true } },
+        { "folders, size desc, name", { { { SortField::Size, false }, { SortField::Name, true } }, true } },
+    };
+    for (unsigned threads : { 1u, 2u, 4u, 8u }) {
+        WorkPool pool(threads);
+        for (auto const& s : specs) {
+            t = Best([&]() {
+                view = all;
+                table.Sort(view, s.spec, threads > 1 ? &pool : nullptr);
+            });
+            char label[48];
+            std::snprintf(label, sizeof(label), "x%u, %s", threads, s.label);
+            std::printf("  %-28s %10.0f\n", label, t * 1e3);
+        }
+    }
+
+    // the enumeration delivers 1000 batches; the view stays sorted by name after each
+    const SortSpec byName{ { { SortField::Name, true } }, true };
+    t = Best([&]() {
+        table.Clear();
+        view.clear();
+        for (size_t b = 0; b < n; b += 1000) {
+            std::vector<uint32_t> fresh;
+            for (size_t i = b; i < b + 1000; ++i) {
+                table.Add(items[i].name, items[i].isFolder, items[i].size, items[i].modifiedTime);
+                fresh.push_back((uint32_t)i);
+            }
+            table.Insert(view, std::move(fresh), byName);
+        }
+    });
+    std::printf("  %-28s %10.0f\n", "1000 batches, Insert", t * 1e3);
+    // sorting everything again after each batch is quadratic; 100 batches of 10k show the trend
+    t = Best([&]() {
+        table.Clear();
+        view.clear();
+        for (size_t b = 0; b < n; b += 10000) {
+            for (size_t i = b; i < b + 10000; ++i) {
+                table.Add(items[i].name, items[i].isFolder, items[i].size, items[i].modifiedTime);
+                view.push_back((uint32_t)i);
+            }
+            table.Sort(view, byName);
+        }
+    });
+    std::printf("  %-28s %10.0f\n", "100 batches, Sort each", t * 1e3);
+    return view.size() != n;
+}
@@ -0,0 +1,118 @@
+// Tag extraction throughput in MB/s and files/s over a generated corpus of 3000 text files (1 KB to
+// 512 KB, Zipf-like words with some German / non-ASCII ones, plus 20 files of 4 MB of which only the
+// first maxBytes are read): TagExtractor::File against a straightforward extractor (whole file into
+// a string, lower-cased words into a std::map, stopwords dropped, everything sorted). Also one 64 MB
+// buffer through TagExtractor::Text, and the extra time per file for idf ranking (df from a hash map).
+// Page cache warm. Best of three. Optional argument: work directory.
+#include "TagExtractor.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <map>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+// words of ASCII letters / digits, the rest separates
+static std::vector<std::string> Naive(const fs::path& path, size_t topN) {
+    std::string text = ReadFile(path);
+    std::map<std::string, uint32_t> counts;
+    std::string word;
+    auto flush = [&]() {
+        if (word.size() >= 3 && word.size() <= TagExtractor::kMaxTermBytes && !TagExtractor::Stopword(word)) ++counts[word];
+        word.clear();
+    };
+    for (char c : text) {
+        if (c >= 'A' && c <= 'Z') word += (char)(c + 32);
+        else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) word += c;
+        else if (!word.empty()) flush();
+    }
+    if (!word.empty()) flush();
+    std::vector<std::pair<uint32_t, std::string>> sorted;
+    for (auto& kv : counts) sorted.emplace_back(kv.second, kv.first);
+    std::sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) { return a.first > b.first; });
+    std::vector<std::string> out;
+    for (size_t i = 0; i < std::min(topN, sorted.size()); ++i) out.push_back(sorted[i].second);
+    return out;
+}
+
+int main(int argc, char** argv) {
+    fs::path base = argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path();
+    TestDir dir((base / "tag_bench").string());
+
+    std::vector<std::string> vocab;
+    std::mt19937 g(48);
+    for (int i = 0; i < 5000; ++i) {
+        std::string w;
+        for (int k = 0, n = 2 + g() % 9; k < n; ++k) w += (char)('a' + g() % 26);
+        if (i % 3 == 0) w[0] = (char)(w[0] - 32);
+        vocab.push_back(w);
+    }
+    for (const char* w : { "the", "and", "der", "die", "und", "Größe", "Straße", "für", "naïve", "Ärger" }) vocab.insert(vocab.begin(), w);
+    std::vector<double> cdf(vocab.size());
+    double sum = 0;
+    for (size_t r = 0; r < vocab.size(); ++r) cdf[r] = sum += 1.0 / (r + 1);
+    std::uniform_real_distribution<double> u(0, sum);
+    auto text = [&](size_t bytes) {
+        std::string s;
+        while (s.size() < bytes) {
+            s += vocab[std::lower_bound(cdf.begin(), cdf.end(), u(g)) - cdf.begin()];
+            s += g() % 12 ? " " : ".\n";
+        }
+        return s;
+    };
+    std::vector<fs::path> files;
+    uint64_t onDisk = 0, prefix = 0;
+    const uint64_t maxBytes = TagOptions().maxBytes;
+    for (int i = 0; i < 3020; ++i) {
+        size_t bytes = i < 3000 ? (size_t)std::exp(std::log(1024.0) + (std::log(512 * 1024.0) - std::log(1024.0)) * (g() % 1000) / 1000.0) : 4u << 20;
+        files.push_back(dir / ("d" + std::to_string(i % 30)) / ("file" + std::to_string(i) + (i % 2 ? ".txt" : ".md")));
+        std::string s = text(bytes);
+        WriteFile(files.back(), s);
+        onDisk += s.size();
+        prefix += std::min<uint64_t>(s.size(), maxBytes);
+    }
+    std::printf("%zu files, %.0f MB on disk, %.0f MB within maxBytes\n", files.size(), onDisk / 1e6, prefix / 1e6);
+    std::printf("  %-30s %10s %10s\n", "extractor", "MB/s", "files/s");
+
+    TagExtractor x;
+    size_t sink = 0;
+    double t = Best([&]() { for (auto const& f : files) sink += x.File(f, 5).size(); });
+    std::printf("  %-30s %10.0f %10.0f\n", "TagExtractor::File", prefix / 1e6 / t, files.size() / t);
+    t = Best([&]() { for (auto const& f : files) sink += Naive(f, 5).size(); });
+    std::printf("  %-30s %10.0f %10.0f\n", "naive (map + sort, whole file)", onDisk / 1e6 / t, files.size() / t);
+
+    std::string big = text(64u << 20);
+    t = Best([&]() { sink += x.Text(big, 5).size(); });
+    std::printf("  %-30s %10.0f\n", "TagExtractor::Text, 64 MB", big.size() / 1e6 / t);
+
+    // idf: document frequencies of every word, as the full-text index would give them
+    std::unordered_map<std::string, uint32_t> df;
+    for (auto const& w : vocab) {
+        std::string lower = w;
+        for (auto& c : lower) if (c >= 'A' && c <= 'Z') c += 32;
+        df[lower] = 1 + g() % (uint32_t)files.size();
+    }
+    TagCorpusFn corpus = [&](const std::vector<std::string_view>& terms, uint32_t* out) {
+        for (size_t i = 0; i < terms.size(); ++i) {
+            auto it = df.find(std::string(terms[i]));
+            out[i] = it == df.end() ? 0 : it->second;
+        }
+        return (uint64_t)files.size();
+    };
+    double tf = Best([&]() { for (auto const& f : files) sink += x.File(f, 5).size(); });
+    double idf = Best([&]() { for (auto const& f : files) sink += x.File(f, 5, corpus).size(); });
+    std::printf("idf ranking: +%.1f us per file\n", (idf - tf) / files.size() * 1e6);
+    return sink == 0;
+}
@@ -0,0 +1,105 @@
+// ThumbnailCache hit latency and throughput: ThumbnailKey, the memory LRU (200k thumbnails, hits and
+// misses at a budget holding a quarter of them) against the old unbounded unordered_map keyed by the path
+// string, and the disk store: puts in MB/s, open from the saved index and from a blob scan, and random
+// gets of 8 KB encoded thumbnails from the page cache. Best of three. Optional argument: work directory.
+#include "ThumbnailCache.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <functional>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+struct Bitmap { uint32_t w = 96, h = 96; };   // stands in for the decoded image; cost is w*h*4
+
+int main(int argc, char** argv) {
+    fs::path base = argc > 1 ? fs::path(argv[1]) : fs::temp_directory_path();
+    TestDir dir((base / "thumbnail_bench").string());
+
+    const size_t n = 200000;
+    std::vector<fs::path> paths(n);
+    for (size_t i = 0; i < n; ++i) paths[i] = "/home/user/Pictures/2024/Holiday " + std::to_string(i / 500) + "/IMG_" + std::to_string(100000 + i) + ".jpg";
+    std::vector<uint64_t> keys(n);
+    double tKey = Best([&]() { for (size_t i = 0; i < n; ++i) keys[i] = ThumbnailKey(paths[i], 2000000 + i, 1700000000 + i, 96); });
+    std::printf("%zu thumbnails:\n", n);
+    std::printf("  %-22s %7.0f ns/key\n", "ThumbnailKey", tKey / n * 1e9);
+
+    // lookups follow a skewed pattern: 80% of them hit the first fifth of the folder
+    std::mt19937 g(3);
+    std::vector<uint32_t> order(2000000);
+    for (auto& o : order) o = g() % 5 ? g() % (n / 5) : g() % n;
+
+    std::unordered_map<std::wstring, Bitmap> old;
+    std::vector<std::wstring> wpaths(n);
+    for (size_t i = 0; i < n; ++i) wpaths[i] = paths[i].wstring();
+    for (size_t i = 0; i < n; ++i) old[wpaths[i]] = Bitmap{};
+    size_t oldHits = 0;
+    double tOld = Best([&]() {
+        oldHits = 0;
+        for (uint32_t o : order) oldHits += old.count(wpaths[o]);
+    });
+
+    const size_t cost = 96 * 96 * 4;
+    ThumbnailLru<Bitmap> lru(n / 4 * cost);
+    for (size_t i = 0; i < n; ++i) lru.Put(keys[i], Bitmap{}, cost);
+    size_t hits = 0;
+    double tLru = Best([&]() {
+        hits = 0;
+        Bitmap b;
+        for (uint32_t o : order) {
+            if (lru.Get(keys[o], b)) ++hits;
+            else lru.Put(keys[o], b, cost);                        // decoded again on a miss
+        }
+    });
+    double tLruKeyed = Best([&]() {
+        Bitmap b;
+        for (uint32_t o : order) {
+            uint64_t k = ThumbnailKey(paths[o], 2000000 + o, 1700000000 + o, 96);
+            if (!lru.Get(k, b)) lru.Put(k, b, cost);
+        }
+    });
+    std::printf("  %-22s %7.0f ns/get   (unbounded: %zu of %zu hit, %.0f MB of bitmaps)\n", "old map by path", tOld / order.size() * 1e9,
+                oldHits, order.size(), old.size() * cost / 1048576.0);
+    std::printf("  %-22s %7.0f ns/get   (budget %.0f MB, %.0f%% hits)\n", "ThumbnailLru", tLru / order.size() * 1e9,
+                n / 4 * cost / 1048576.0, 100.0 * hits / order.size());
+    std::printf("  %-22s %7.0f ns/get\n", "ThumbnailLru + key", tLruKeyed / order.size() * 1e9);
+
+    // disk store: 8 KB encoded thumbnails, budget large enough to keep all of them
+    const size_t dn = 50000, bytes = 8192;
+    std::vector<uint8_t> blob(bytes);
+    for (size_t i = 0; i < bytes; ++i) blob[i] = (uint8_t)(i * 13);
+    fs::path store = dir / "thumbs";
+    double tPut = Best([&]() {
+        ThumbnailDiskStore s;
+        s.Open(store, 1ull << 34);
+        s.Clear();
+        for (size_t i = 0; i < dn; ++i) s.Put(keys[i], blob.data(), blob.size());
+    });
+    std::printf("%zu disk thumbnails of %zu KB (%.0f MB):\n", dn, bytes / 1024, dn * bytes / 1048576.0);
+    std::printf("  %-22s %7.0f ms   %7.0f MB/s\n", "put", tPut * 1e3, dn * bytes / tPut / 1048576.0);
+    double tOpen = Best([&]() { ThumbnailDiskStore s; s.Open(store, 1ull << 34); });
+    double tScan = Best([&]() { fs::remove(store / "thumbs.idx"); ThumbnailDiskStore s; s.Open(store, 1ull << 34); });
+    std::printf("  %-22s %7.1f ms\n", "open (saved index)", tOpen * 1e3);
+    std::printf("  %-22s %7.1f ms\n", "open (blob scan)", tScan * 1e3);
+    ThumbnailDiskStore s;
+    s.Open(store, 1ull << 34);
+    std::vector<uint8_t> out;
+    size_t found = 0;
+    double tGet = Best([&]() {
+        found = 0;
+        for (size_t i = 0; i < 200000; ++i) found += s.Get(keys[order[i] % dn], out);
+    });
+    std::printf("  %-22s %7.1f us/get   (%zu found)\n", "get (page cache)", tGet / 200000 * 1e6, found);
+    return 0;
+}
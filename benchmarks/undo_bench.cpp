@@ -0,0 +1,129 @@
+// Undo memory per 1M keystrokes of simulated editing on a 1 MB document (words and spaces, a line
+// break every ~60 characters, 5% backspace, the caret moved elsewhere every ~300 keys): UndoHistory
+// (merged steps in a chunk arena, older chunks deflated) against a plain history of one step per
+// keystroke (position + removed / inserted std::wstring). Reports steps, arena and packed bytes,
+// and the time to record every keystroke and to undo / redo all of it. Then a 100 MB paste (bytes
+// of wchar_t; 4 per character here, 2 on Windows): record and undo time. Best of three.
+#include "UndoHistory.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <functional>
+
+using Clock = std::chrono::steady_clock;
+
+static double Best(const std::function<void()>& fn) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        auto t = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return best;
+}
+
+struct Key { size_t pos; bool back; bool jump; wchar_t c; };   // c: typed, or removed by backspace
+
+// The keystrokes on a gap buffer (text before the caret, text after it reversed)
+static std::vector<Key> Keystrokes(const std::wstring& start, size_t n) {
+    std::mt19937 g(30);
+    std::wstring before = start.substr(0, start.size() / 2), after(start.rbegin(), start.rend() - start.size() / 2);
+    std::vector<Key> keys;
+    keys.reserve(n);
+    for (size_t i = 0, line = 0; i < n; ++i) {
+        Key k{ 0, false, false, 0 };
+        if (g() % 300 == 0) {
+            size_t to = g() % (before.size() + after.size());
+            for (; before.size() > to; before.pop_back()) after.push_back(before.back());
+            for (; before.size() < to; after.pop_back()) before.push_back(after.back());
+            k.jump = true;
+        }
+        if (g() % 20 == 0 && !before.empty()) {
+            k.back = true;
+            k.c = before.back();
+            before.pop_back();
+            k.pos = before.size();
+        }
+        else {
+            k.pos = before.size();
+            k.c = ++line % 60 == 0 ? L'\n' : g() % 6 == 0 ? L' ' : (wchar_t)(L'a' + g() % 26);
+            before.push_back(k.c);
+        }
+        keys.push_back(k);
+    }
+    return keys;
+}
+
+// One step per keystroke, nothing merged or compressed
+struct PlainStep { size_t pos; std::wstring removed, inserted; };
+
+static size_t HeapBytes(const std::wstring& s) {
+    return s.capacity() > std::wstring().capacity() ? (s.capacity() + 1) * sizeof(wchar_t) : 0;
+}
+
+int main() {
+    const size_t n = 1000000;
+    std::wstring start(1 << 20, L' ');
+    std::mt19937 g(31);
+    for (auto& c : start) c = g() % 7 ? (wchar_t)(L'a' + g() % 26) : L' ';
+    std::vector<Key> keys = Keystrokes(start, n);
+    size_t typed = 0;
+    for (auto const& k : keys) typed += !k.back;
+    std::printf("%zu keystrokes (%zu backspaces) on a %zu character document\n", n, n - typed, start.size());
+
+    std::vector<PlainStep> plain;
+    double tPlain = Best([&]() {
+        plain.clear();
+        plain.shrink_to_fit();
+        for (auto const& k : keys) {
+            if (k.back) plain.push_back({ k.pos, std::wstring(1, k.c), std::wstring() });
+            else plain.push_back({ k.pos, std::wstring(), std::wstring(1, k.c) });
+        }
+    });
+    size_t plainBytes = plain.capacity() * sizeof(PlainStep);
+    for (auto const& s : plain) plainBytes += HeapBytes(s.removed) + HeapBytes(s.inserted);
+
+    UndoHistory history(1u << 30);
+    double tRecord = Best([&]() {
+        history.Clear();
+        for (auto const& k : keys) {
+            if (k.jump) history.BreakMerge();
+            if (k.back) history.Record(k.pos, &k.c, 1, nullptr, 0, UndoKind::Delete);
+            else history.Record(k.pos, nullptr, 0, &k.c, 1, UndoKind::Typing);
+        }
+    });
+
+    std::printf("  %-24s %10s %12s %12s %12s %10s\n", "history", "steps", "arena", "packed", "total", "ns/key");
+    std::printf("  %-24s %10zu %12s %12s %12zu %10.0f\n", "one step per keystroke", plain.size(), "-", "-", plainBytes, tPlain / n * 1e9);
+    std::printf("  %-24s %10zu %12zu %12zu %12zu %10.0f\n", "UndoHistory", history.StepCount(), history.ArenaBytes(), history.PackedBytes(),
+                history.MemoryUsed(), tRecord / n * 1e9);
+
+    // undo everything, then redo it; every typed and every removed character comes back once
+    UndoEdit e;
+    size_t steps = history.StepCount(), undoIns = 0, undoRem = 0, redoIns = 0, redoRem = 0;
+    auto t0 = Clock::now();
+    while (history.Undo(e)) { undoIns += e.inserted.size(); undoRem += e.removed.size(); }
+    double tUndo = std::chrono::duration<double>(Clock::now() - t0).count();
+    t0 = Clock::now();
+    while (history.Redo(e)) { redoIns += e.inserted.size(); redoRem += e.removed.size(); }
+    double tRedo = std::chrono::duration<double>(Clock::now() - t0).count();
+    bool complete = undoIns == typed && redoIns == typed && undoRem == n - typed && redoRem == n - typed;
+    std::printf("undo all: %.0f ms (%.2f us per step), redo all: %.0f ms; %s\n", tUndo * 1e3, tUndo / steps * 1e6, tRedo * 1e3,
+                complete ? "all keystrokes restored" : "KEYSTROKES MISSING");
+
+    // a 100 MB paste with the default cap
+    std::wstring paste((100u << 20) / sizeof(wchar_t), L'x');
+    for (size_t i = 0; i < paste.size(); i += 61) paste[i] = L'\n';
+    UndoHistory capped;
+    double tPaste = Best([&]() {
+        capped.Clear();
+        capped.Record(1000, nullptr, 0, paste.data(), paste.size(), UndoKind::Other);
+    });
+    double tPasteUndo = Best([&]() {
+        capped.Undo(e);
+        capped.Redo(e);
+    });
+    std::printf("100 MB paste: record %.0f ms, undo + redo %.0f ms, %zu MB held with a %zu MB cap\n", tPaste * 1e3, tPasteUndo * 1e3,
+                capped.MemoryUsed() >> 20, capped.MemoryCap() >> 20);
+    return complete ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+// WorkPool thread scaling against the previous design (same deques, but every Submit and every task
+// start took the pool-wide mutex to count queued tasks), at 1/2/4/8/16 threads: a recursive fan-out
+// of 2M tiny tasks (tree-walk shape), 1M tiny tasks submitted from outside, and 20k tasks of ~50 us
+// of work (where both should scale with the cores). Tasks/s, best of three.
+#include "WorkPool.h"
+
+#include <chrono>
+#include <cstdio>
+
+using Clock = std::chrono::steady_clock;
+
+// The pool before per-worker counting, kept for comparison
+class MutexPool {
+public:
+    using Task = std::function<void()>;
+    explicit MutexPool(unsigned threads) {
+        for (unsigned i = 0; i < threads; ++i) m_queues.push_back(std::make_unique<Queue>());
+        for (unsigned i = 0; i < threads; ++i) m_threads.emplace_back([this, i]() { Run(i); });
+    }
+    ~MutexPool() {
+        { std::lock_guard<std::mutex> lg(m_mutex); m_stop = true; }
+        m_wake.notify_all();
+        for (auto& t : m_threads) t.join();
+    }
+    void Submit(Task task) {
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        size_t q = Current().pool == this ? Current().index : m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+        { std::lock_guard<std::mutex> lg(m_queues[q]->mutex); m_queues[q]->tasks.push_back(std::move(task)); }
+        { std::lock_guard<std::mutex> lg(m_mutex); m_queued++; }
+        m_wake.notify_one();
+    }
+    void WaitIdle() {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_idle.wait(lk, [this]() { return m_pending.load() == 0; });
+    }
+
+private:
+    struct Queue { std::mutex mutex; std::deque<Task> tasks; };
+    struct WorkerId { MutexPool* pool; size_t index; };
+    static WorkerId& Current() { static thread_local WorkerId id{ nullptr, 0 }; return id; }
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake, m_idle;
+    size_t m_queued = 0;
+    std::atomic<size_t> m_pending{ 0 }, m_next{ 0 };
+    bool m_stop = false;
+
+    bool Take(size_t self, Task& out) {
+        {
+            Queue& q = *m_queues[self];
+            std::lock_guard<std::mutex> lg(q.mutex);
+            if (!q.tasks.empty()) { out = std::move(q.tasks.back()); q.tasks.pop_back(); return true; }
+        }
+        for (size_t i = 1; i < m_queues.size(); ++i) {
+            Queue& q = *m_queues[(self + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lg(q.mutex);
+            if (!q.tasks.empty()) { out = std::move(q.tasks.front()); q.tasks.pop_front(); return true; }
+        }
+        return false;
+    }
+    void Run(size_t self) {
+        Current() = WorkerId{ this, self };
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                m_wake.wait(lk, [this]() { return m_stop || m_queued > 0; });
+                if (m_stop) return;
+                m_queued--;
+            }
+            Task task;
+            while (!Take(self, task)) std::this_thread::yield();
+            task();
+            task = nullptr;
+            if (m_pending.fetch_sub(1) == 1) { std::lock_guard<std::mutex> lg(m_mutex); m_idle.notify_all(); }
+        }
+    }
+};
+
+static uint64_t Spin(uint64_t n) {
+    uint64_t x = n;
+    for (uint64_t i = 0; i < n; ++i) x = x * 6364136223846793005ull + 1442695040888963407ull;
+    return x;
+}
+
+// Tasks per second of one workload on a fresh pool, best of three
+template <class Pool, class F> static double Rate(unsigned threads, size_t tasks, F&& workload) {
+    double best = 1e9;
+    for (int i = 0; i < 3; ++i) {
+        Pool pool(threads);
+        auto t = Clock::now();
+        workload(pool);
+        pool.WaitIdle();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    return tasks / best;
+}
+
+template <class Pool> static void FanOut(Pool& pool, std::atomic<uint64_t>& sink, int depth) {
+    sink.fetch_add(1, std::memory_order_relaxed);
+    if (depth == 0) return;
+    pool.Submit([&pool, &sink, depth]() { FanOut(pool, sink, depth - 1); });
+    pool.Submit([&pool, &sink, depth]() { FanOut(pool, sink, depth - 1); });
+}
+
+int main() {
+    std::atomic<uint64_t> sink{ 0 };
+    const int depth = 20;                                  // 2^21 - 1 tasks
+    const size_t fanTasks = (2u << depth) - 1, flatTasks = 1000000, heavyTasks = 20000;
+    std::printf("%u hardware threads; million tasks/s (heavy: thousand tasks/s)\n", std::thread::hardware_concurrency());
+    std::printf("  %-8s %12s %12s %12s %12s %12s %12s\n", "threads", "fan mutex", "fan", "flat mutex", "flat", "heavy mutex", "heavy");
+    for (unsigned threads : { 1u, 2u, 4u, 8u, 16u }) {
+        auto fan = [&](auto& pool) { pool.Submit([&]() { FanOut(pool, sink, depth); }); };
+        auto flat = [&](auto& pool) { for (size_t i = 0; i < flatTasks; ++i) pool.Submit([&sink]() { sink.fetch_add(1, std::memory_order_relaxed); }); };
+        auto heavy = [&](auto& pool) { for (size_t i = 0; i < heavyTasks; ++i) pool.Submit([&sink]() { sink.fetch_add(Spin(20000), std::memory_order_relaxed); }); };
+        std::printf("  %-8u %12.2f %12.2f %12.2f %12.2f %12.1f %12.1f\n", threads,
+                    Rate<MutexPool>(threads, fanTasks, fan) / 1e6, Rate<WorkPool>(threads, fanTasks, fan) / 1e6,
+                    Rate<MutexPool>(threads, flatTasks, flat) / 1e6, Rate<WorkPool>(threads, flatTasks, flat) / 1e6,
+                    Rate<MutexPool>(threads, heavyTasks, heavy) / 1e3, Rate<WorkPool>(threads, heavyTasks, heavy) / 1e3);
+        std::fflush(stdout);
+    }
+    return sink.load() == 0;
+}
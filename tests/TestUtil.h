@@ -0,0 +1,54 @@
+// TestUtil.h — minimal helpers for the portable tests (no framework)
+// - CHECK(x): prints file:line and the expression, exits with 1
+// - TestDir: fresh directory below the system temp dir, removed again on success
+// - WriteFile / ReadFile: whole-file helpers; WriteRandom fills a file from a seeded generator
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#define CHECK(x) do { if (!(x)) { std::printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #x); std::exit(1); } } while (0)
+
+class TestDir {
+public:
+    explicit TestDir(const std::string& name) {
+        m_path = std::filesystem::temp_directory_path() / (name + "-" + std::to_string(getpid()));
+        std::filesystem::remove_all(m_path);
+        std::filesystem::create_directories(m_path);
+    }
+    ~TestDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(m_path, ec);
+    }
+    const std::filesystem::path& Path() const { return m_path; }
+    std::filesystem::path operator/(const std::filesystem::path& p) const { return m_path / p; }
+
+private:
+    std::filesystem::path m_path;
+};
+
+inline void WriteFile(const std::filesystem::path& p, const std::string& s) {
+    std::filesystem::create_directories(p.parent_path());
+    std::ofstream(p, std::ios::binary) << s;
+}
+
+inline void WriteRandom(const std::filesystem::path& p, size_t n, unsigned seed) {
+    std::filesystem::create_directories(p.parent_path());
+    std::vector<char> b(n);
+    std::mt19937 g(seed);
+    for (auto& c : b) c = (char)g();
+    std::ofstream(p, std::ios::binary).write(b.data(), (std::streamsize)n);
+}
+
+inline std::string ReadFile(const std::filesystem::path& p) {
+    std::ifstream f(p, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(f), {});
+}
@@ -0,0 +1,86 @@
+// Codec: gzip round trip (also as concatenated members), truncated and corrupt input report Failed(),
+// and CodecWriter only replaces the target after Finish() succeeded.
+#include "Codec.h"
+#include "TestUtil.h"
+
+namespace fs = std::filesystem;
+
+static bool Save(const fs::path& p, Compression kind, const std::string& s) {
+    CodecWriter w;
+    if (!w.Open(p, kind)) return false;
+    for (size_t i = 0; i < s.size(); i += 70000)                      // EM_STREAMOUT sized pieces
+        if (!w.Write((const unsigned char*)s.data() + i, std::min<size_t>(70000, s.size() - i))) return false;
+    return w.Finish();
+}
+
+// Decoded text; failed = the reader reported an error
+static std::string Load(const fs::path& p, bool& failed) {
+    CodecReader r;
+    std::string s;
+    failed = !r.Open(p);
+    unsigned char buf[4096];
+    for (size_t n; !failed && (n = r.Read(buf, sizeof buf)) > 0;) s.append((const char*)buf, n);
+    failed = failed || r.Failed();
+    return s;
+}
+
+static std::string Text() {
+    std::string s;
+    for (int i = 0; i < 100000; ++i) s += "line " + std::to_string(i) + ";value=" + std::to_string(i * 7919 % 10007) + "\n";
+    return s;
+}
+
+static void TestGzip(const TestDir& d) {
+    if (!CompressionAvailable(Compression::Gzip)) { std::printf("gzip not compiled in, skipped\n"); return; }
+    std::string text = Text();
+    fs::path gz = d / "a.log.gz";
+    CHECK(Save(gz, Compression::Gzip, text));
+    CHECK(!fs::exists(d / "a.log.gz.tmp") && SniffCompression(gz) == Compression::Gzip && fs::file_size(gz) < text.size() / 3);
+    bool failed;
+    CHECK(Load(gz, failed) == text && !failed);
+
+    // appended members decode as one stream
+    std::string data = ReadFile(gz);
+    WriteFile(d / "twice.gz", data + data);
+    CHECK(Load(d / "twice.gz", failed) == text + text && !failed);
+
+    // a truncated or damaged file is reported, not shown as if complete
+    WriteFile(d / "cut.gz", data.substr(0, data.size() / 2));
+    std::string part = Load(d / "cut.gz", failed);
+    CHECK(failed && part.size() < text.size());
+    std::string bad = data;
+    for (size_t i = 100; i < 200; ++i) bad[i] = (char)(bad[i] ^ 0x5A);
+    WriteFile(d / "bad.gz", bad);
+    Load(d / "bad.gz", failed);
+    CHECK(failed);
+}
+
+static void TestReplace(const TestDir& d) {
+    fs::path p = d / "keep.txt";
+    WriteFile(p, "old content");
+    {
+        CodecWriter w;                                                   // abandoned save
+        CHECK(w.Open(p, Compression::None));
+        CHECK(w.Write((const unsigned char*)"new", 3));
+        CHECK(fs::exists(d / "keep.txt.tmp") && ReadFile(p) == "old content");
+    }
+    CHECK(ReadFile(p) == "old content" && !fs::exists(d / "keep.txt.tmp"));
+
+    // the target cannot be replaced: the old one stays, the temporary file goes
+    fs::path dir = d / "dir";
+    WriteFile(dir / "inside", "x");
+    CodecWriter w;
+    CHECK(w.Open(dir, Compression::None));
+    CHECK(w.Write((const unsigned char*)"abc", 3));
+    CHECK(!w.Finish() && w.Failed() && fs::is_directory(dir) && !fs::exists(d / "dir.tmp"));
+
+    CHECK(Save(p, Compression::None, "new content") && ReadFile(p) == "new content");
+}
+
+int main() {
+    TestDir d("codec_test");
+    TestGzip(d);
+    TestReplace(d);
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,268 @@
+// CopyEngine: conflicts, pause / cancel, Stop() + resume from the journal, a killed process + resume,
+// merging into existing folders, and a torn journal.
+#include "CopyEngine.h"
+#include "TestUtil.h"
+
+#include <csignal>
+#include <sys/wait.h>
+
+namespace fs = std::filesystem;
+
+static CopyResult RunJob(CopyEngine& e, CopyJob job) {
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = false;
+    CopyResult res;
+    job.onDone = [&](const CopyResult& r) {
+        std::lock_guard<std::mutex> lg(m);
+        res = r;
+        done = true;
+        cv.notify_all();
+    };
+    e.Enqueue(std::move(job));
+    std::unique_lock<std::mutex> lk(m);
+    cv.wait(lk, [&]() { return done; });
+    return res;
+}
+
+static fs::path TreeFile(int i) { return fs::path("tree") / ("d" + std::to_string(i % 5)) / ("f" + std::to_string(i) + ".txt"); }
+
+// 50 small files in 5 folders, one large file, a symlink, and a single file next to the tree
+static void MakeSources(const fs::path& src) {
+    for (int i = 0; i < 50; ++i) WriteRandom(src / TreeFile(i), 1000 + i * 37, i);
+    WriteRandom(src / "tree" / "big.bin", 40 << 20, 99);
+    WriteRandom(src / "single.txt", 12345, 7);
+    fs::create_symlink("single.txt", src / "tree" / "link");
+}
+
+static bool SameTree(const fs::path& a, const fs::path& b) {
+    for (int i = 0; i < 50; ++i) if (ReadFile(a / TreeFile(i)) != ReadFile(b / TreeFile(i))) return false;
+    return ReadFile(a / "tree" / "big.bin") == ReadFile(b / "tree" / "big.bin");
+}
+
+static void TestCopyAndConflicts(const TestDir& root, const fs::path& src) {
+    fs::path dst = root / "dst";
+    fs::create_directories(dst);
+    CopyEngine e;
+    e.SetJournalDir(root / "journal");
+    CopyJob j;
+    j.sources = { src / "tree", src / "single.txt" };
+    j.target = dst;
+    j.options.verify = true;
+    CopyResult r = RunJob(e, j);
+    CHECK(!r.cancelled && r.failures.empty() && r.totals.filesDone == 53 && r.totals.bytesDone == r.totals.bytes);
+    CHECK(SameTree(src, dst));
+    CHECK(fs::is_symlink(dst / "tree" / "link"));
+    CHECK(fs::last_write_time(dst / "single.txt") == fs::last_write_time(src / "single.txt"));
+    CHECK(!fs::exists(dst / "single.txt.partial"));
+    CHECK(fs::is_empty(root / "journal"));
+
+    // keep both: the second copy gets numbered names
+    r = RunJob(e, j);
+    CHECK(r.failures.empty());
+    CHECK(fs::exists(dst / "tree (2)" / "big.bin") && ReadFile(dst / "single (2).txt") == ReadFile(src / "single.txt"));
+
+    j.sources = { src / "single.txt" };
+    j.options.conflict = CopyConflict::Skip;
+    r = RunJob(e, j);
+    CHECK(r.totals.skipped == 1 && r.totals.filesDone == 0);
+    j.options.conflict = CopyConflict::Fail;
+    r = RunJob(e, j);
+    CHECK(r.totals.failed == 1 && r.failures.size() == 1);
+    WriteFile(dst / "single.txt", "old");
+    fs::last_write_time(dst / "single.txt", fs::last_write_time(src / "single.txt") - std::chrono::hours(1));
+    j.options.conflict = CopyConflict::OverwriteOlder;
+    r = RunJob(e, j);
+    CHECK(r.totals.filesDone == 1 && ReadFile(dst / "single.txt") == ReadFile(src / "single.txt"));
+    r = RunJob(e, j);
+    CHECK(r.totals.skipped == 1);
+
+    // never onto itself, never into itself
+    j.options.conflict = CopyConflict::Overwrite;
+    j.target = src;
+    r = RunJob(e, j);
+    CHECK(r.totals.skipped == 1 && ReadFile(src / "single.txt").size() == 12345);
+    j.sources = { src / "tree" };
+    j.target = src / "tree" / "d1";
+    r = RunJob(e, j);
+    CHECK(r.failures.size() == 1);
+}
+
+// An existing folder is merged into under Skip / Fail; the policy applies per file
+static void TestMerge(const TestDir& root, const fs::path& src) {
+    fs::path dst = root / "merge";
+    WriteFile(dst / TreeFile(3), "mine");
+    CopyEngine e;
+    CopyJob j;
+    j.sources = { src / "tree" };
+    j.target = dst;
+    j.options.conflict = CopyConflict::Skip;
+    CopyResult r = RunJob(e, j);
+    CHECK(r.failures.empty() && r.totals.skipped == 1 && r.totals.filesDone == 51);
+    CHECK(ReadFile(dst / TreeFile(3)) == "mine" && ReadFile(dst / TreeFile(4)) == ReadFile(src / TreeFile(4)));
+    CHECK(!fs::exists(dst / "tree (2)"));
+
+    fs::remove_all(dst);
+    WriteFile(dst / TreeFile(3), "mine");
+    j.options.conflict = CopyConflict::Fail;
+    r = RunJob(e, j);
+    CHECK(r.failures.size() == 1 && r.failures[0].target == dst / TreeFile(3) && r.totals.filesDone == 51);
+    CHECK(ReadFile(dst / TreeFile(3)) == "mine");
+}
+
+static void TestCancel(const TestDir& root, const fs::path& src) {
+    CopyEngine e;
+    e.SetJournalDir(root / "journal");
+    CopyJob j;
+    j.sources = { src / "tree" };
+    j.target = root / "cancel";
+    fs::create_directories(j.target);
+    j.options.bufferSize = 1 << 20;
+    j.options.fastPath = false;
+    j.options.progressInterval = std::chrono::milliseconds(1);
+
+    // cancel in the middle of the large file: no .partial, no journal
+    std::atomic<uint64_t> id{ 0 };
+    j.onProgress = [&](const CopyProgress& p) { if (p.bytesDone > (5 << 20)) e.Cancel(id.load()); };
+    e.Pause();
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = false;
+    CopyResult res;
+    j.onDone = [&](const CopyResult& x) {
+        std::lock_guard<std::mutex> lg(m);
+        res = x;
+        done = true;
+        cv.notify_all();
+    };
+    id = e.Enqueue(j);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    CHECK(e.Paused());
+    e.Resume();
+    {
+        std::unique_lock<std::mutex> lk(m);
+        cv.wait(lk, [&]() { return done; });
+    }
+    CHECK(res.cancelled && res.totals.bytesDone < res.totals.bytes);
+    CHECK(!fs::exists(j.target / "tree" / "big.bin.partial"));
+    CHECK(fs::is_empty(root / "journal"));
+
+    // cancel while paused
+    j.onProgress = nullptr;
+    e.Pause();
+    done = false;
+    uint64_t paused = e.Enqueue(j);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    e.Cancel(paused);
+    {
+        std::unique_lock<std::mutex> lk(m);
+        cv.wait(lk, [&]() { return done; });
+    }
+    e.Resume();
+    CHECK(res.cancelled && res.totals.filesDone == 0);
+    CHECK(fs::is_empty(root / "journal"));
+}
+
+// Stop() in the middle of the large file keeps journal and .partial; the next engine continues
+static void TestStopResume(const TestDir& root, const fs::path& src) {
+    CopyJob j;
+    j.sources = { src / "tree" };
+    j.target = root / "stopped";
+    fs::create_directories(j.target);
+    j.options.bufferSize = 1 << 20;
+    j.options.fastPath = false;
+    fs::path part = j.target / "tree" / "big.bin.partial";
+    {
+        CopyEngine e;
+        e.SetJournalDir(root / "journal");
+        e.Enqueue(j);
+        for (int i = 0; i < 20000 && !(fs::exists(part) && fs::file_size(part) >= (3u << 20)); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        e.Stop();
+    }
+    CHECK(!fs::is_empty(root / "journal"));
+    CopyEngine e;
+    e.SetJournalDir(root / "journal");
+    std::vector<CopyJob> jobs = e.Interrupted();
+    CHECK(jobs.size() == 1 && jobs[0].target == j.target && !jobs[0].options.fastPath);
+    CopyResult r = RunJob(e, jobs[0]);
+    CHECK(r.failures.empty() && r.totals.filesDone + r.totals.skipped == 52);
+    CHECK(!fs::exists(j.target / "tree (2)") && !fs::exists(part));
+    CHECK(SameTree(src, j.target));
+    CHECK(fs::is_empty(root / "journal"));
+}
+
+// A process killed mid-copy leaves no truncated file under a target name; the resumed job (Skip,
+// the policy that used to keep such files) completes the tree
+static void TestKilledResume(const TestDir& root) {
+    fs::path src = root / "many", dst = root / "killed", journal = root / "journal";
+    const int n = 3000;
+    for (int i = 0; i < n; ++i) WriteRandom(src / ("d" + std::to_string(i % 20)) / ("f" + std::to_string(i)), 2000 + i % 7000, i);
+    fs::create_directories(dst);
+    CopyJob j;
+    j.sources = { src };
+    j.target = dst;
+    j.options.conflict = CopyConflict::Skip;
+    j.options.fastPath = false;
+    j.options.ioThreads = 1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        CopyEngine e;
+        e.SetJournalDir(journal);
+        RunJob(e, j);
+        _exit(0);
+    }
+    for (size_t copied = 0; copied < n / 4;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        std::error_code ec;
+        copied = 0;
+        for (auto it = fs::recursive_directory_iterator(dst, ec); it != fs::recursive_directory_iterator(); it.increment(ec))
+            copied += it->is_regular_file(ec);
+    }
+    kill(pid, SIGKILL);
+    int status;
+    waitpid(pid, &status, 0);
+
+    size_t complete = 0;
+    for (auto const& e : fs::recursive_directory_iterator(dst)) {
+        if (!e.is_regular_file() || e.path().extension() == ".partial") continue;
+        CHECK(ReadFile(e.path()) == ReadFile(src / fs::relative(e.path(), dst / "many")));
+        complete++;
+    }
+    CHECK(complete > 0 && complete < (size_t)n);
+
+    CopyEngine e;
+    e.SetJournalDir(journal);
+    std::vector<CopyJob> jobs = e.Interrupted();
+    CHECK(jobs.size() == 1);
+    CopyResult r = RunJob(e, jobs[0]);
+    CHECK(r.failures.empty() && r.totals.files == (uint64_t)n);
+    for (int i = 0; i < n; ++i) {
+        fs::path rel = fs::path("d" + std::to_string(i % 20)) / ("f" + std::to_string(i));
+        CHECK(ReadFile(dst / "many" / rel) == ReadFile(src / rel));
+    }
+    CHECK(!fs::exists(dst / "many (2)"));
+    CHECK(fs::is_empty(journal));
+}
+
+static void TestTornJournal(const TestDir& root) {
+    WriteFile(root / "journal" / "x.copyjob", "garbage");
+    CopyEngine e;
+    e.SetJournalDir(root / "journal");
+    CHECK(e.Interrupted().empty());
+    CHECK(fs::is_empty(root / "journal"));
+}
+
+int main() {
+    TestDir root("copy_engine_test");
+    fs::path src = root / "src";
+    MakeSources(src);
+    TestKilledResume(root);   // first: fork() before any engine thread exists
+    TestCopyAndConflicts(root, src);
+    TestMerge(root, src);
+    TestCancel(root, src);
+    TestStopResume(root, src);
+    TestTornJournal(root);
+    std::printf("OK\n");
+    return 0;
+}
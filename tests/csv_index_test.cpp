@@ -0,0 +1,75 @@
+// CsvTable on a generated 200000-row file: row index across quoted newlines, SortedView against a
+// reference sort (unescaped text with "" escapes, numbers before text, descending, stable ties) and
+// FilteredView order. Large enough to take the chunked paths on the chunk pool.
+#include "CsvIndex.h"
+#include "TestUtil.h"
+
+#include <numeric>
+
+namespace fs = std::filesystem;
+
+struct Row {
+    std::string name;                         // unescaped
+    std::string value;                        // as written
+};
+
+static std::string Quote(const std::string& s) {
+    std::string q = "\"";
+    for (char c : s) { q += c; if (c == '"') q += '"'; }
+    return q + "\"";
+}
+
+static void Check(const std::vector<uint32_t>& got, std::vector<uint32_t> rows, const std::function<int(uint32_t, uint32_t)>& cmp) {
+    std::stable_sort(rows.begin(), rows.end(), [&](uint32_t a, uint32_t b) { return cmp(a, b) < 0; });
+    CHECK(got == rows);
+}
+
+int main() {
+    TestDir d("csv_index_test");
+    const int n = 200000;
+    std::mt19937 g(3);
+    std::vector<Row> rows(n + 1);
+    std::string file = "id,name,value,note\n";
+    const char alphabet[] = "ab\"# ";
+    for (int i = 1; i <= n; ++i) {
+        Row& r = rows[i];
+        for (int k = 1 + g() % 12; k > 0; --k) r.name += alphabet[g() % 5];
+        if (g() % 50 == 0) r.value = "n/a";
+        else r.value = std::to_string((int)(g() % 20000) - 10000) + (g() % 2 ? ".5" : "");
+        bool quote = r.name.find_first_of("\" ") != std::string::npos || g() % 4 == 0;
+        file += std::to_string(i) + "," + (quote ? Quote(r.name) : r.name) + "," + r.value + ",";
+        file += i % 1000 == 0 ? "\"two\nlines\"\n" : "x\n";
+    }
+    WriteFile(d / "t.csv", file);
+
+    CsvTable t;
+    CHECK(t.Open(d / "t.csv") && t.Delimiter() == ',');
+    CHECK(t.BuildIndex() && t.Complete() && t.RowCount() == (uint64_t)n + 1 && t.ColumnCount() == 4);
+    std::vector<CsvField> f;
+    t.ParseRow(4000, f);
+    CHECK(f.size() == 4 && t.FieldText(f[0]) == "4000" && t.FieldText(f[1]) == rows[4000].name && t.FieldText(f[3]) == "two\nlines");
+
+    std::vector<uint32_t> all = t.IdentityView();
+    CHECK(all.size() == (size_t)n);
+    auto byName = [&](uint32_t a, uint32_t b) { return rows[a].name.compare(rows[b].name); };
+    Check(t.SortedView(all, 1, true), all, byName);
+    Check(t.SortedView(all, 1, false), all, [&](uint32_t a, uint32_t b) { return -byName(a, b); });
+
+    // numbers ascending before text
+    auto number = [&](uint32_t r, double& v) { char* e; v = strtod(rows[r].value.c_str(), &e); return *e == 0; };
+    Check(t.SortedView(all, 2, true), all, [&](uint32_t a, uint32_t b) {
+        double va, vb;
+        bool na = number(a, va), nb = number(b, vb);
+        if (na != nb) return na ? -1 : 1;
+        if (na) return va < vb ? -1 : va > vb ? 1 : 0;
+        return rows[a].value.compare(rows[b].value);
+    });
+
+    // a filter keeps the order of the view it narrows
+    std::vector<uint32_t> sorted = t.SortedView(all, 1, true), expect;
+    for (uint32_t r : sorted) if (std::to_string(r).find("77") != std::string::npos) expect.push_back(r);
+    CHECK(t.FilteredView(sorted, 0, "77") == expect);
+    CHECK(t.FilteredView(all, SIZE_MAX, "two").size() == (size_t)n / 1000);
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,259 @@
+// DiskUsage against a serial walk with lstat: every node's own and subtree totals (bytes, bytes on
+// disk, files, folders), children largest first, links counted as entries and not followed, the
+// largest files, progress calls that never overlap and end with the final totals. The cache: a
+// repeat run lists nothing and gives the same tree; a folder whose mtime changed is listed again
+// (and only that one); a file that grew in place is seen with useCache = false. Cancel and bad
+// roots give nullptr. DiskUsageTreemap: rectangles tile their parent with areas proportional to the
+// bytes, do not overlap, respect maxDepth / minSide, and reproduce the example of the squarified
+// treemap paper.
+#include "DiskUsage.h"
+#include "TestUtil.h"
+
+#include <cmath>
+#include <map>
+
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+struct RefDir { DiskUsageTotals own, total; };
+using Ref = std::map<DirString, RefDir>;       // by path
+
+static DiskUsageTotals RefWalk(const fs::path& dir, Ref& ref, std::vector<std::pair<uint64_t, DirString>>& files) {
+    RefDir& r = ref[dir.native()];
+    DiskUsageTotals total;
+    for (auto const& e : fs::directory_iterator(dir)) {
+        struct stat st;
+        CHECK(lstat(e.path().c_str(), &st) == 0);
+        if (S_ISDIR(st.st_mode)) {
+            r.own.dirs++;
+            total.Add(RefWalk(e.path(), ref, files));
+            continue;
+        }
+        r.own.files++;
+        r.own.bytes += (uint64_t)st.st_size;
+        r.own.allocated += (uint64_t)st.st_blocks * 512;
+        files.emplace_back((uint64_t)st.st_size, e.path().native());
+    }
+    total.Add(r.own);
+    ref[dir.native()].total = total;
+    return total;
+}
+
+static bool Same(const DiskUsageTotals& a, const DiskUsageTotals& b) {
+    return a.bytes == b.bytes && a.allocated == b.allocated && a.files == b.files && a.dirs == b.dirs && a.errors == b.errors;
+}
+
+// every node against the reference; returns the number of nodes
+static size_t Compare(const DiskUsageDir& d, Ref& ref) {
+    auto it = ref.find(d.Path().native());
+    CHECK(it != ref.end() && Same(d.own, it->second.own) && Same(d.total, it->second.total) && !d.error);
+    CHECK(d.children.size() == d.own.dirs);
+    size_t n = 1;
+    for (size_t i = 0; i < d.children.size(); ++i) {
+        CHECK(d.children[i]->parent == &d);
+        if (i) CHECK(d.children[i - 1]->total.bytes >= d.children[i]->total.bytes);
+        n += Compare(*d.children[i], ref);
+    }
+    return n;
+}
+
+struct Result {
+    std::unique_ptr<DiskUsageDir> tree;
+    std::vector<DiskUsageFile> largest;
+    DiskUsageProgress last;
+    size_t reports = 0;
+};
+
+static Result Run(const fs::path& root, DiskUsageOptions opt, DiskUsageCache* cache) {
+    Result r;
+    std::atomic<int> inside{ 0 };
+    bool doneSeen = false;
+    DiskUsage du;
+    r.tree = du.Run(root, opt, [&](const DiskUsageProgress& p) {
+        CHECK(inside.fetch_add(1) == 0 && !doneSeen);
+        doneSeen = p.done;
+        r.last = p;
+        r.reports++;
+        inside.fetch_sub(1);
+    }, cache);
+    if (r.tree) CHECK(doneSeen);
+    r.largest = du.Largest();
+    return r;
+}
+
+static void Check(const fs::path& root, const Result& r, size_t largestFiles) {
+    Ref ref;
+    std::vector<std::pair<uint64_t, DirString>> files;
+    RefWalk(root, ref, files);
+    CHECK(r.tree && Compare(*r.tree, ref) == ref.size());
+    // the final report: the tree's totals, per subfolder of the root its subtree's bytes
+    CHECK(Same(r.last.totals, r.tree->total) && r.last.top.size() == r.tree->children.size());
+    for (auto const& [name, bytes] : r.last.top) CHECK(ref[(root / name).native()].total.bytes == bytes);
+    // largest files: the same sizes as the reference's, paths that have them
+    std::sort(files.begin(), files.end(), [](auto const& a, auto const& b) { return a.first > b.first; });
+    CHECK(r.largest.size() == std::min(largestFiles, files.size()));
+    for (size_t i = 0; i < r.largest.size(); ++i) {
+        CHECK(r.largest[i].size == files[i].first);
+        struct stat st;
+        CHECK(lstat(r.largest[i].path.c_str(), &st) == 0 && (uint64_t)st.st_size == r.largest[i].size);
+    }
+}
+
+static void TestWalkAndCache() {
+    TestDir dir("disk_usage_test");
+    fs::path root = dir / "root";
+    std::mt19937 g(46);
+    for (int a = 0; a < 5; ++a)
+        for (int b = 0; b < 4; ++b)
+            for (int f = 0; f < 3 + a * 2; ++f)
+                WriteRandom(root / ("a" + std::to_string(a)) / ("b" + std::to_string(b)) / ("f" + std::to_string(f)), g() % 20000, g());
+    for (int f = 0; f < 50; ++f) WriteFile(root / "many" / ("same" + std::to_string(f)), std::string(50000 + f, 'x'));  // one folder with most of the largest
+    WriteFile(root / "top.bin", std::string(123456, 'y'));
+    WriteFile(root / ".hidden" / "h", std::string(777, 'h'));
+    fs::create_directories(root / "empty" / "deeper");
+    fs::create_directory_symlink(root / "a0", root / "a1" / "link");       // an entry, not followed
+    std::ofstream(root / "a2" / "zero");
+
+    DiskUsageOptions opt;
+    opt.threads = 4;
+    opt.largestFiles = 40;
+    opt.progressInterval = std::chrono::milliseconds(0);
+    Result plain = Run(root, opt, nullptr);
+    Check(root, plain, opt.largestFiles);
+    CHECK(plain.reports > 1 && plain.last.cachedDirs == 0);
+
+    DiskUsageCache cache;
+    Result first = Run(root, opt, &cache);
+    Check(root, first, opt.largestFiles);
+    size_t dirs = first.tree->total.dirs + 1;
+    CHECK(cache.Size() == dirs && first.last.cachedDirs == 0);
+    Result again = Run(root, opt, &cache);
+    Check(root, again, opt.largestFiles);
+    CHECK(again.last.cachedDirs == dirs && again.tree->cached);
+
+    // a new file changes its folder's mtime: that folder is listed again, nothing else
+    WriteFile(root / "a3" / "b1" / "new", std::string(999999, 'n'));
+    fs::remove_all(root / "a4" / "b2");
+    Result changed = Run(root, opt, &cache);
+    Check(root, changed, opt.largestFiles);
+    CHECK(changed.last.cachedDirs == dirs - 1 - 2 && changed.largest[0].size == 999999);
+
+    // growing a file in place does not touch its folder: only a run without the cache sees it
+    { std::ofstream(root / "a0" / "b0" / "f0", std::ios::app) << std::string(5000, 'z'); }
+    Result stale = Run(root, opt, &cache);
+    CHECK(stale.tree->total.bytes == changed.tree->total.bytes);
+    opt.useCache = false;
+    Result fresh = Run(root, opt, &cache);
+    Check(root, fresh, opt.largestFiles);
+    CHECK(fresh.tree->total.bytes == changed.tree->total.bytes + 5000 && fresh.last.cachedDirs == 0);
+    opt.useCache = true;
+    Check(root, Run(root, opt, &cache), opt.largestFiles);               // the refreshed cache
+
+    // a run that wants more largest files than the cache kept per folder
+    opt.largestFiles = 60;
+    Check(root, Run(root, opt, &cache), opt.largestFiles);
+    opt.largestFiles = 0;
+    CHECK(Run(root, opt, &cache).largest.empty());
+
+    // cancelled or nothing to analyse
+    {
+        DiskUsage du;
+        du.Cancel();
+        CHECK(!du.Run(root, opt) && du.Cancelled());
+        DiskUsage mid;
+        CHECK(!mid.Run(root, opt, [&](const DiskUsageProgress&) { mid.Cancel(); }));
+        CHECK(!DiskUsage().Run(root / "missing", opt) && !DiskUsage().Run(root / "top.bin", opt));
+    }
+}
+
+static DiskUsageDir* Node(DiskUsageDir& parent, const char* name, uint64_t bytes) {
+    auto c = std::make_unique<DiskUsageDir>();
+    c->name = fs::path(name).native();
+    c->parent = &parent;
+    c->total.bytes = c->own.bytes = bytes;
+    parent.children.push_back(std::move(c));
+    return parent.children.back().get();
+}
+
+static bool Inside(const DiskUsageRect& r, double x, double y, double w, double h) {
+    const double e = 1e-9;
+    return r.x >= x - e && r.y >= y - e && r.x + r.w <= x + w + e && r.y + r.h <= y + h + e;
+}
+
+static bool Overlap(const DiskUsageRect& a, const DiskUsageRect& b) {
+    const double e = 1e-9;
+    return a.x + e < b.x + b.w && b.x + e < a.x + a.w && a.y + e < b.y + b.h && b.y + e < a.y + a.h;
+}
+
+// the rectangles of node (at depth) tile x/y/w/h in proportion to the bytes; recurses into the
+// subdivided ones
+static void CheckTiling(const DiskUsageDir& node, double x, double y, double w, double h, const std::vector<DiskUsageRect>& all,
+                        int depth, int maxDepth, double minSide) {
+    std::vector<const DiskUsageRect*> level;
+    for (auto const& r : all)
+        if (r.depth == depth && Inside(r, x, y, w, h) && (r.ownFiles ? r.dir == &node : r.dir->parent == &node)) level.push_back(&r);
+    double area = 0;
+    for (size_t i = 0; i < level.size(); ++i) {
+        const DiskUsageRect& r = *level[i];
+        double bytes = (double)(r.ownFiles ? r.dir->own.bytes : r.dir->total.bytes);
+        CHECK(std::fabs(r.w * r.h - w * h * bytes / node.total.bytes) < 1e-6 * w * h);
+        area += r.w * r.h;
+        for (size_t k = 0; k < i; ++k) CHECK(!Overlap(r, *level[k]));
+        bool nested = false;
+        for (auto const& s : all) nested |= s.depth == depth + 1 && !r.ownFiles && (s.ownFiles ? s.dir == r.dir : s.dir->parent == r.dir);
+        bool split = !r.ownFiles && depth + 1 < maxDepth && std::min(r.w, r.h) >= minSide && r.dir->total.bytes > 0;
+        CHECK(nested == split);
+        if (split) CheckTiling(*r.dir, r.x, r.y, r.w, r.h, all, depth + 1, maxDepth, minSide);
+    }
+    CHECK(std::fabs(area - w * h) < 1e-6 * w * h);
+}
+
+static void TestTreemap() {
+    // Bruls et al., figure 4: areas 6 6 4 3 2 2 1 in a 6 x 4 rectangle
+    DiskUsageDir paper;
+    for (uint64_t a : { 6, 6, 4, 3, 2, 2, 1 }) Node(paper, "x", a);
+    paper.total.bytes = 24;
+    std::vector<DiskUsageRect> out;
+    DiskUsageTreemap(paper, 0, 0, 6, 4, 1, 0, out);
+    struct Want { double x, y, w, h; };
+    const Want want[] = { { 0, 0, 3, 2 }, { 0, 2, 3, 2 },                                      // 6 6: a column
+                          { 3, 0, 12.0 / 7, 7.0 / 3 }, { 3 + 12.0 / 7, 0, 9.0 / 7, 7.0 / 3 },  // 4 3: a row on top
+                          { 3, 7.0 / 3, 1.2, 5.0 / 3 }, { 4.2, 7.0 / 3, 1.2, 5.0 / 3 }, { 5.4, 7.0 / 3, 0.6, 5.0 / 3 } };
+    CHECK(out.size() == 7);
+    for (size_t i = 0; i < out.size(); ++i)
+        CHECK(std::fabs(out[i].x - want[i].x) < 1e-9 && std::fabs(out[i].y - want[i].y) < 1e-9 && std::fabs(out[i].w - want[i].w) < 1e-9 &&
+              std::fabs(out[i].h - want[i].h) < 1e-9 && out[i].depth == 0 && !out[i].ownFiles);
+    CheckTiling(paper, 0, 0, 6, 4, out, 0, 1, 0);
+
+    // a deeper tree with own files at several levels and an empty folder
+    DiskUsageDir root;
+    std::mt19937 g(47);
+    std::function<uint64_t(DiskUsageDir&, int)> grow = [&](DiskUsageDir& d, int level) {
+        d.own.bytes = g() % 3 ? g() % 5000 : 0;
+        d.total.bytes = d.own.bytes;
+        if (level < 4)
+            for (int i = 0, n = (int)(g() % 6); i < n; ++i) d.total.bytes += grow(*Node(d, "d", 0), level + 1);
+        return d.total.bytes;
+    };
+    grow(root, 0);
+    Node(root, "empty", 0);                                   // no rectangle
+    for (int maxDepth : { 1, 2, 5 })
+        for (double minSide : { 0.0, 20.0 }) {
+            out.clear();
+            DiskUsageTreemap(root, 10, 20, 800, 300, maxDepth, minSide, out);
+            for (auto const& r : out) CHECK(r.depth < maxDepth && Inside(r, 10, 20, 800, 300) && r.dir->total.bytes > 0);
+            CheckTiling(root, 10, 20, 800, 300, out, 0, maxDepth, minSide);
+        }
+    out.clear();
+    DiskUsageDir none;
+    DiskUsageTreemap(none, 0, 0, 100, 100, 3, 0, out);
+    CHECK(out.empty());
+}
+
+int main() {
+    TestWalkAndCache();
+    TestTreemap();
+    std::printf("OK\n");
+    return 0;
+}
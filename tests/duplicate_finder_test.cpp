@@ -0,0 +1,143 @@
+// DuplicateFinder against grouping by full content: each stage drops what it should (unique sizes are
+// never read, a differing head or tail drops out at the sample, a differing middle only at the full
+// hash, small files are decided by the sample alone), cached digests replace reads, byte verification
+// splits a full-hash collision, symlinks / minSize / hard links, and Cancel().
+#include "DuplicateFinder.h"
+#include "TestUtil.h"
+
+#include <map>
+#include <set>
+
+namespace fs = std::filesystem;
+
+using Groups = std::set<std::vector<IndexString>>;
+
+static std::string Content(size_t n, unsigned seed) {
+    std::string s(n, '\0');
+    std::mt19937 g(seed);
+    for (auto& c : s) c = (char)g();
+    return s;
+}
+
+// groups of >= 2 regular files (no symlinks) with equal content and size >= minSize
+static Groups Reference(const fs::path& root, uint64_t minSize) {
+    std::map<std::string, std::vector<IndexString>> byContent;
+    for (auto const& e : fs::recursive_directory_iterator(root)) {
+        if (e.is_symlink() || !e.is_regular_file() || e.file_size() < minSize) continue;
+        byContent[ReadFile(e.path())].push_back(e.path().native());
+    }
+    Groups out;
+    for (auto& kv : byContent) {
+        if (kv.second.size() < 2) continue;
+        std::sort(kv.second.begin(), kv.second.end());
+        out.insert(kv.second);
+    }
+    return out;
+}
+
+static Groups Run(DuplicateFinder& f, const fs::path& root, const DupOptions& opt, DupStages stages, DupProgress& last) {
+    Groups got;
+    stages.onGroup = [&](DupGroup&& g) {
+        CHECK(g.paths.size() >= 2 && std::is_sorted(g.paths.begin(), g.paths.end()) && g.Wasted() == g.size * (g.paths.size() - 1));
+        CHECK(got.insert(g.paths).second);
+    };
+    stages.onProgress = [&](const DupProgress& p) { last = p; };
+    CHECK(f.Run({ root }, opt, stages));
+    return got;
+}
+
+int main() {
+    TestDir d("duplicate_finder_test");
+    fs::path root = d / "tree";
+    const size_t sample = 4096, big = 100000;
+    // unique sizes: never read
+    for (int i = 0; i < 20; ++i) WriteFile(root / "unique" / ("u" + std::to_string(i)), Content(50000 + i, i));
+    // same size, different head: dropped by the sample
+    WriteFile(root / "head" / "a", Content(big, 1));
+    WriteFile(root / "head" / "b", Content(big, 2));
+    // same size, same head and tail, different middle: dropped only by the full hash
+    std::string mid = Content(big, 3), mid2 = mid;
+    mid2[big / 2] ^= 1;
+    WriteFile(root / "mid" / "a", mid);
+    WriteFile(root / "mid" / "b", mid2);
+    // real duplicates: large (sample, then full hash) in three places, small (sample only)
+    std::string dup = Content(big + 7, 4);
+    WriteFile(root / "dup" / "a", dup);
+    WriteFile(root / "dup" / "sub" / "b", dup);
+    WriteFile(root / "other" / "deep" / "deeper" / "c", dup);
+    WriteFile(root / "small" / "x", "same small content");
+    WriteFile(root / "small" / "y", "same small content");
+    WriteFile(root / "small" / "z", "diff small content");
+    std::string edge = Content(2 * sample, 5);                  // exactly two samples: still sample-only
+    WriteFile(root / "edge" / "a", edge);
+    WriteFile(root / "edge" / "b", edge);
+    // ignored: empty files (minSize 1), symlinks; a hard link is a duplicate like any other
+    WriteFile(root / "empty" / "a", "");
+    WriteFile(root / "empty" / "b", "");
+    fs::create_symlink(root / "dup" / "a", root / "link");
+    WriteFile(root / "hard" / "a", Content(3000, 6));
+    fs::create_hard_link(root / "hard" / "a", root / "hard" / "b");
+
+    DupOptions opt;
+    opt.sampleBytes = sample;
+    opt.ioThreads = 3;
+    opt.walkThreads = 2;
+    std::atomic<int> fullCalls{ 0 };
+    DupStages stages;
+    stages.fullHash = [&](const DupFile& f, HashDigest& out, const std::atomic<bool>& cancel) {
+        fullCalls++;
+        CHECK(f.size > 2 * sample);
+        return HashFile(f.path, HashAlgo::Fast128, out, &cancel);
+    };
+    DuplicateFinder finder;
+    DupProgress p;
+    Groups want = Reference(root, 1);
+    CHECK(want.size() == 4);
+    CHECK(Run(finder, root, opt, stages, p) == want);
+    CHECK(p.walkDone && p.files == 20 + 2 + 2 + 3 + 3 + 2 + 2);
+    CHECK(p.sizeCandidates == 4 + 3 + 3 + 2 + 2);               // head + mid share a size, so does "diff small content"
+    CHECK(p.sampled == p.sizeCandidates);
+    CHECK(p.fullCandidates == 2 + 3 && fullCalls == 5 && p.fullHashed == 5 && p.cachedDigests == 0);
+    CHECK(p.groups == 4 && p.wastedBytes == 2 * (big + 7) + 18 + 2 * sample + 3000);
+    uint64_t sampledBytes = (4 + 3) * 2 * sample + 3 * 18 + 2 * 2 * sample + 2 * 3000;
+    CHECK(p.bytesRead == sampledBytes + 2 * big + 3 * (big + 7));
+
+    // minSize drops the small files and the hard links before anything is read
+    DupOptions bigOnly = opt;
+    bigOnly.minSize = 5000;
+    CHECK(Run(finder, root, bigOnly, stages, p) == Reference(root, 5000) && p.groups == 2 && p.files == 20 + 2 + 2 + 3 + 2);
+
+    // cached digests (trusted for two of the three large duplicates) replace their reads
+    fullCalls = 0;
+    DupStages cached = stages;
+    cached.cachedHash = [&](const DupFile& f, HashDigest& out) {
+        if (fs::path(f.path).filename() == "c" || fs::path(f.path).filename() == "b") return false;
+        return HashFile(f.path, HashAlgo::Fast128, out);
+    };
+    CHECK(Run(finder, root, opt, cached, p) == want);
+    CHECK(p.cachedDigests == 2 && fullCalls == 3 && p.fullHashed == 3);
+
+    // a full hash that collides for everything: equal samples would merge mid/a and mid/b ...
+    DupStages colliding = stages;
+    colliding.fullHash = [](const DupFile&, HashDigest& out, const std::atomic<bool>&) { out = HashDigest(); out.len = 16; return true; };
+    Groups merged = want;
+    merged.insert({ (root / "mid" / "a").native(), (root / "mid" / "b").native() });
+    CHECK(Run(finder, root, opt, colliding, p) == merged);
+    // ... unless the bytes are compared, which also splits a group into its real classes
+    DupOptions verify = opt;
+    verify.verifyBytes = true;
+    CHECK(Run(finder, root, verify, colliding, p) == want);
+    WriteFile(root / "mid" / "c", mid);
+    WriteFile(root / "mid" / "d", mid2);
+    CHECK(Run(finder, root, verify, colliding, p) == Reference(root, 1) && p.groups == 6);
+
+    // Cancel from a stage: Run reports it; the large groups behind the full hash never arrive
+    DupStages cancelling = stages;
+    size_t largeGroups = 0;
+    cancelling.fullHash = [&](const DupFile&, HashDigest&, const std::atomic<bool>&) { finder.Cancel(); return false; };
+    cancelling.onGroup = [&](DupGroup&& g) { if (g.size > 2 * sample) largeGroups++; };
+    CHECK(!finder.Run({ root }, opt, cancelling) && finder.Cancelled() && largeGroups == 0);
+    CHECK(Run(finder, root, opt, stages, p) == Reference(root, 1));   // the next Run starts afresh
+    std::printf("OK\n");
+    return 0;
+}
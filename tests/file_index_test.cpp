@@ -0,0 +1,219 @@
+// FileIndex against a std::map reference: snapshot round trip (columns, interned directories, tags and
+// postings, path hash table) with section checksums verified, the log overlay on top of a snapshot
+// (update, add, remove, replay after reopen, torn tail cut off), damaged snapshots ignored, Compact and
+// Clear, and the index.json migration (escapes, surrogate pairs, unknown members, malformed input).
+#include "FileIndex.h"
+#include "TestUtil.h"
+
+#include <map>
+
+namespace fs = std::filesystem;
+
+using Ref = std::map<IndexString, FileIndexEntry>;
+
+static bool Same(const FileIndexEntry& a, const FileIndexEntry& b) {
+    return a.path == b.path && a.size == b.size && a.mtime == b.mtime && a.hashLen == b.hashLen &&
+           memcmp(a.hash, b.hash, 32) == 0 && a.tags == b.tags;
+}
+
+static IndexString S(const std::string& s) { return fs::path(s).native(); }
+
+static void CheckAgainst(const FileIndex& idx, const Ref& ref) {
+    CHECK(idx.Size() == ref.size());
+    FileIndexEntry e;
+    for (auto const& kv : ref) CHECK(idx.Find(kv.first, e) && Same(e, kv.second) && idx.Contains(kv.first));
+    CHECK(!idx.Find(S("/nope/x"), e) && !idx.Contains(S("/data")) && !idx.Contains(S("")));
+    size_t seen = 0;
+    idx.ForEach([&](const FileIndexEntry& x) { auto it = ref.find(x.path); CHECK(it != ref.end() && Same(x, it->second)); seen++; });
+    CHECK(seen == ref.size());
+    seen = 0;
+    idx.ForEachPath([&](IndexStringView p) { CHECK(ref.count(IndexString(p))); seen++; });
+    CHECK(seen == ref.size());
+    std::map<IndexString, size_t> df;
+    for (auto const& kv : ref) {
+        std::vector<IndexString> t = kv.second.tags;
+        std::sort(t.begin(), t.end());
+        t.erase(std::unique(t.begin(), t.end()), t.end());
+        for (auto const& x : t) df[x]++;
+    }
+    for (auto const& kv : df) CHECK(idx.TagCount(kv.first) == kv.second);
+    CHECK(idx.TagCount(S("no-such-tag")) == 0);
+}
+
+static FileIndexEntry RandomEntry(std::mt19937& g, const IndexString& path) {
+    static const char* tags[] = { "invoice", "2024", "holiday", "r\xC3\xA9sum\xC3\xA9", "draft", "photo", "tax", "x" };
+    FileIndexEntry e;
+    e.path = path;
+    e.size = g() % 3 ? g() % 100000 : (uint64_t)g() << 20;
+    e.mtime = 133000000000000000ull + g();
+    e.hashLen = (uint8_t)(g() % 3 == 0 ? 0 : g() % 2 ? 20 : 32);
+    for (uint8_t i = 0; i < e.hashLen; ++i) e.hash[i] = (uint8_t)g();
+    for (unsigned n = g() % 4; n > 0; --n) e.tags.push_back(S(tags[g() % 8]));   // repeats allowed
+    return e;
+}
+
+static std::string RandomPath(std::mt19937& g) {
+    std::string p;
+    int depth = g() % 6;
+    for (int d = 0; d < depth; ++d) p += "/d" + std::to_string(d) + "_" + std::to_string(g() % (d + 3));
+    return p + "/f" + std::to_string(g() % 100000) + (g() % 2 ? ".txt" : "");
+}
+
+static void TestSnapshotAndLog(const TestDir& d) {
+    fs::path dir = d / "idx";
+    std::mt19937 g(35);
+    Ref ref;
+    uint64_t gen;
+    {
+        FileIndex idx;
+        CHECK(idx.Open(dir) && !idx.HasSnapshot() && idx.Size() == 0);
+        for (int i = 0; i < 20000; ++i) {
+            FileIndexEntry e = RandomEntry(g, S(RandomPath(g)));
+            ref[e.path] = e;
+            idx.Put(e);
+        }
+        FileIndexEntry top = RandomEntry(g, S("toplevel.txt"));  // no directory at all
+        ref[top.path] = top;
+        idx.Put(top);
+        CheckAgainst(idx, ref);                                 // overlay only
+        CHECK(idx.NeedsCompaction() && idx.Compact() && idx.HasSnapshot());
+        CHECK(fs::file_size(dir / "index.log") == 0);
+        CheckAgainst(idx, ref);
+    }
+    {
+        FileIndex idx;
+        CHECK(idx.Open(dir, true) && idx.HasSnapshot());        // all section checksums verified
+        CheckAgainst(idx, ref);
+
+        // log on top of the snapshot: updates keep the path generation, adds and removes bump it
+        gen = idx.PathGeneration();
+        auto it = ref.begin();
+        for (int i = 0; i < 300; ++i, ++it) {
+            FileIndexEntry e = RandomEntry(g, it->first);
+            idx.Put(e);
+            it->second = e;
+        }
+        CHECK(idx.PathGeneration() == gen);
+        for (int i = 0; i < 200; ++i, it = ref.erase(it)) idx.Remove(it->first);
+        idx.Remove(S("/not/there"));
+        for (int i = 0; i < 500; ++i) {
+            FileIndexEntry e = RandomEntry(g, S("/new" + RandomPath(g)));
+            if (!ref.count(e.path)) { ref[e.path] = e; idx.Put(e); }
+        }
+        FileIndexEntry back = ref.begin()->second;              // removed, then put again
+        idx.Remove(back.path);
+        idx.Put(back);
+        CHECK(idx.PathGeneration() > gen);
+        CheckAgainst(idx, ref);
+    }
+    {
+        FileIndex idx;                                          // log replayed at open
+        CHECK(idx.Open(dir) && idx.HasSnapshot());
+        CheckAgainst(idx, ref);
+    }
+    uint64_t logSize = fs::file_size(dir / "index.log");
+    CHECK(logSize > 0);
+    {
+        std::ofstream(dir / "index.log", std::ios::binary | std::ios::app) << std::string("XPLG\x40\0\0\0checksumtorn", 20);
+        FileIndex idx;
+        CHECK(idx.Open(dir));
+        CheckAgainst(idx, ref);
+        CHECK(fs::file_size(dir / "index.log") == logSize);
+        CHECK(idx.Compact() && fs::file_size(dir / "index.log") == 0);
+        CheckAgainst(idx, ref);
+    }
+
+    // damage: header byte -> snapshot ignored; section byte -> only caught with verify
+    std::string bin = ReadFile(dir / "index.bin");
+    {
+        std::string bad = bin;
+        bad[20] ^= 1;
+        WriteFile(dir / "index.bin", bad);
+        FileIndex idx;
+        CHECK(idx.Open(dir) && !idx.HasSnapshot() && idx.Size() == 0);
+    }
+    {
+        std::string bad = bin;
+        bad[bad.size() - 5] ^= 1;
+        WriteFile(dir / "index.bin", bad);
+        FileIndex idx;
+        CHECK(idx.Open(dir, true) && !idx.HasSnapshot());
+        CHECK(idx.Open(dir, false) && idx.HasSnapshot());
+    }
+    WriteFile(dir / "index.bin", bin);
+    {
+        FileIndex idx;
+        CHECK(idx.Open(dir, true));
+        CheckAgainst(idx, ref);
+        idx.Clear();                                            // full rebuild: empty, then compacted
+        CHECK(idx.Size() == 0 && idx.NeedsCompaction());
+        FileIndexEntry e = RandomEntry(g, S("/only/one"));
+        idx.Put(e);
+        CHECK(idx.Compact());
+        CheckAgainst(idx, Ref{ { e.path, e } });
+    }
+    {
+        FileIndex idx;
+        CHECK(idx.Open(dir) && idx.Size() == 1);
+    }
+}
+
+static void TestJsonMigration(const TestDir& d) {
+    // layout and escaping as JsonCpp's StreamWriter wrote it (indentation "  ", non-ASCII as \u)
+    WriteFile(d / "index.json",
+        "{\n"
+        "  \"/home/a/caf\\u00e9 \\\"quoted\\\".txt\" : \n  {\n"
+        "    \"path\" : \"/home/a/caf\\u00e9 \\\"quoted\\\".txt\",\n"
+        "    \"sha1\" : \"a9993e364706816aba3e25717850c26c9cd0d89d\",\n"
+        "    \"size\" : 12345,\n"
+        "    \"tags\" : \n    [\n      \"r\\u00e9sum\\u00e9\",\n      \"tax\"\n    ]\n  },\n"
+        "  \"/home/a/\\ud83d\\ude00\\\\back\\/slash\" : \n  {\n"
+        "    \"extra\" : { \"nested\" : [ 1, 2.5e3, true, null, { } ] },\n"
+        "    \"size\" : 7\n  },\n"
+        "  \"/home/a/empty\" : {},\n"
+        "  \"/home/a/null\" : null,\n"
+        "  \"/home/a/badhash\" : { \"sha1\" : \"xyz\", \"tags\" : [] }\n"
+        "}\n");
+    Ref ref;
+    FileIndexEntry e;
+    e.path = S("/home/a/caf\xC3\xA9 \"quoted\".txt");
+    e.size = 12345;
+    e.SetHashHex("a9993e364706816aba3e25717850c26c9cd0d89d");
+    CHECK(e.hashLen == 20);
+    e.tags = { S("r\xC3\xA9sum\xC3\xA9"), S("tax") };
+    ref[e.path] = e;
+    e = FileIndexEntry();
+    e.path = S("/home/a/\xF0\x9F\x98\x80\\back/slash");
+    e.size = 7;
+    ref[e.path] = e;
+    for (const char* p : { "/home/a/empty", "/home/a/null", "/home/a/badhash" }) { e = FileIndexEntry(); e.path = S(p); ref[e.path] = e; }
+
+    FileIndex idx;
+    CHECK(idx.Open(d / "mig"));
+    CHECK(IndexJsonImporter::Import(d / "index.json", idx));
+    CheckAgainst(idx, ref);
+    CHECK(idx.Compact());
+    CheckAgainst(idx, ref);
+
+    // malformed or missing: nothing imported
+    const char* bad[] = { "", "[]", "{\"a\":{\"size\":1},}", "{\"a\":{\"size\":1}", "{\"a\":{\"size\":1}} x",
+                          "{\"\\ud83d\":{}}", "{\"a\":{\"tags\":[1]}}", "{\"a\\q\":{}}", "{\"a\":{\"size\":\"1\"}}", "{\"a\nb\":{}}" };
+    for (const char* b : bad) {
+        WriteFile(d / "bad.json", b);
+        FileIndex x;
+        CHECK(x.Open(d / "bad"));
+        CHECK(!IndexJsonImporter::Import(d / "bad.json", x) && x.Size() == 0);
+    }
+    FileIndex x;
+    CHECK(x.Open(d / "bad") && !IndexJsonImporter::Import(d / "missing.json", x));
+    WriteFile(d / "empty.json", "\xEF\xBB\xBF { }\n");
+    CHECK(IndexJsonImporter::Import(d / "empty.json", x) && x.Size() == 0);
+}
+
+int main() {
+    TestDir d("file_index_test");
+    TestSnapshotAndLog(d);
+    TestJsonMigration(d);
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,273 @@
+// FullTextIndex: varints and posting lists round-trip (with skips, Advance() against a sorted
+// reference), the tokenizer, and queries against a model that scans every document's tokens —
+// words, "phrases", OR, -exclusion, prefix*, scope — over several segments, after merging, after
+// replacing and removing documents and after reopening. AddFile: extension filter, binary files,
+// UTF-16 with surrogate pairs.
+#include "FullTextIndex.h"
+#include "TestUtil.h"
+
+#include <map>
+#include <set>
+
+namespace fs = std::filesystem;
+
+static void TestPostings() {
+    std::mt19937 g(43);
+    for (uint32_t v : { 0u, 1u, 127u, 128u, 16383u, 16384u, (1u << 21) - 1, 1u << 21, (1u << 28) - 1, 1u << 28, UINT32_MAX }) {
+        std::vector<uint8_t> b;
+        FullTextPutVarint(b, v);
+        const uint8_t* p = b.data();
+        CHECK(FullTextGetVarint(p) == v && p == b.data() + b.size());
+    }
+    // one list: doc gaps from 1 to millions, up to 300 positions per doc
+    struct Posting { uint32_t doc; std::vector<uint32_t> pos; };
+    std::vector<Posting> ref;
+    FullTextPostingWriter w;
+    for (uint32_t doc = (uint32_t)(g() % 3); ref.size() < 3000; doc += 1 + (g() % 8 == 0 ? g() % 5000000 : g() % 20)) {
+        Posting p{ doc, {} };
+        for (uint32_t at = g() % 1000, n = 1 + (g() % 50 == 0 ? g() % 300 : g() % 4); p.pos.size() < n; at += 1 + g() % (g() % 2 ? 3 : 100000))
+            p.pos.push_back(at);
+        w.Add(doc, p.pos.data(), (uint32_t)p.pos.size());
+        ref.push_back(std::move(p));
+    }
+    CHECK(w.Df() == ref.size() && w.Length() == w.bytes.size() && w.skips.size() == (ref.size() - 1) / FullTextPostingWriter::kSkipInterval);
+    FullTextCursor c;
+    c.Init(w.bytes.data(), w.bytes.size(), w.skips.data(), (uint32_t)w.skips.size());
+    std::vector<uint32_t> pos;
+    for (auto const& p : ref) {
+        CHECK(c.Next() && c.doc == p.doc && c.tf == p.pos.size());
+        c.Positions(pos);
+        CHECK(pos == p.pos);
+    }
+    CHECK(!c.Next());
+    // Advance: first doc >= target, jumping with the skips, for ascending targets of any spacing
+    for (int round = 0; round < 200; ++round) {
+        c.Init(w.bytes.data(), w.bytes.size(), w.skips.data(), (uint32_t)w.skips.size());
+        for (uint32_t target = 0;;) {
+            auto it = std::lower_bound(ref.begin(), ref.end(), target, [](const Posting& p, uint32_t t) { return p.doc < t; });
+            bool ok = c.Advance(target);
+            CHECK(ok == (it != ref.end()));
+            if (!ok) break;
+            CHECK(c.doc == it->doc && c.tf == it->pos.size());
+            c.Positions(pos);
+            CHECK(pos == it->pos);
+            target = c.doc + (round % 2 ? g() % 50 : g() % 20000000);    // the same doc again, the next ones, far ahead
+        }
+    }
+}
+
+static std::vector<std::pair<std::string, uint32_t>> Tokens(std::string_view text) {
+    std::vector<std::pair<std::string, uint32_t>> out;
+    FullTextTokenizer t;
+    auto add = [&](std::string_view tok, uint32_t pos) { out.emplace_back(tok, pos); };
+    t.Feed(text.data(), text.size(), add);
+    t.Finish(add);
+    return out;
+}
+
+static void TestTokenizer() {
+    auto t = Tokens("Hello, WORLD! foo_bar 123abc Grüße  x" + std::string(65, 'y') + " end");
+    std::vector<std::pair<std::string, uint32_t>> want = { { "hello", 0 }, { "world", 1 }, { "foo", 2 }, { "bar", 3 },
+                                                           { "123abc", 4 }, { "grüße", 5 }, { "end", 7 } };  // 6: too long
+    CHECK(t == want);
+    // a token split across Feed calls
+    FullTextTokenizer tok;
+    std::vector<std::string> got;
+    auto add = [&](std::string_view s, uint32_t) { got.emplace_back(s); };
+    tok.Feed("inv", 3, add);
+    tok.Feed("oice two", 8, add);
+    tok.Finish(add);
+    CHECK(got == std::vector<std::string>({ "invoice", "two" }) && tok.Count() == 2);
+    auto groups = FullTextParse("alpha \"Beta gamma\" -delta eps* OR zeta");
+    CHECK(groups.size() == 2 && groups[0].size() == 4 && groups[1].size() == 1);
+    CHECK(groups[0][1].tokens == std::vector<std::string>({ "beta", "gamma" }) && groups[0][2].negated && groups[0][3].prefix);
+}
+
+// ---- queries against a model ----
+
+using Model = std::map<std::string, std::vector<std::string>>;   // path -> tokens
+
+// occurrences of one clause in a document (phrase: consecutive, prefix: any token starting with it)
+static uint32_t Occurrences(const std::vector<std::string>& doc, const FullTextClause& c) {
+    uint32_t n = 0;
+    for (size_t i = 0; i + c.tokens.size() <= doc.size(); ++i) {
+        if (c.prefix) { n += doc[i].compare(0, c.tokens[0].size(), c.tokens[0]) == 0; continue; }
+        bool ok = true;
+        for (size_t k = 0; k < c.tokens.size() && ok; ++k) ok = doc[i + k] == c.tokens[k];
+        n += ok;
+    }
+    return n;
+}
+
+static std::set<std::string> Expected(const Model& model, const std::string& query, const std::string& scope) {
+    std::set<std::string> out;
+    auto groups = FullTextParse(query);
+    for (auto const& [path, doc] : model) {
+        if (!scope.empty() && path.compare(0, scope.size() + 1, scope + "/") != 0) continue;
+        for (auto const& g : groups) {
+            bool ok = false;
+            for (auto const& c : g) {
+                uint32_t n = Occurrences(doc, c);
+                if (c.negated && n) { ok = false; break; }
+                if (!c.negated) { if (!n) { ok = false; break; } ok = true; }
+            }
+            if (ok) { out.insert(path); break; }
+        }
+    }
+    return out;
+}
+
+static void CheckQueries(FullTextIndex& index, const Model& model) {
+    static const char* queries[] = { "alpha", "Alpha beta", "\"alpha beta\"", "\"beta alpha gamma\"", "gamma -delta", "kappa OR lambda",
+                                     "\"alpha alpha\" OR mu -nu", "al*", "ze* eta", "omega", "nosuchword", "alpha nosuchword", "-alpha",
+                                     "rare17", "rare1*" };
+    for (const char* q : queries) {
+        for (std::string scope : { "", "/docs/a" }) {
+            FullTextQueryOptions opt;
+            opt.topK = model.size();
+            opt.batchSize = 7;
+            opt.scope = FullTextNative(scope);
+            FullTextQueryStats st;
+            size_t batches = 0;
+            std::vector<FullTextHit> hits;
+            CHECK(index.Query(FullTextNative(q), opt, [&](std::vector<FullTextHit>&& b) {
+                CHECK(!b.empty() && b.size() <= 7);
+                batches++;
+                hits.insert(hits.end(), b.begin(), b.end());
+            }, &st));
+            std::set<std::string> got;
+            for (size_t i = 0; i < hits.size(); ++i) {
+                CHECK(got.insert(FullTextUtf8(hits[i].path)).second);
+                if (i) CHECK(hits[i - 1].score >= hits[i].score);
+            }
+            CHECK(got == Expected(model, q, scope) && st.matches == got.size() && batches == (hits.size() + 6) / 7);
+            // single group: matches = the clause occurrences (prefix: summed over the expansions)
+            auto groups = FullTextParse(q);
+            if (groups.size() == 1)
+                for (auto const& h : hits) {
+                    uint32_t n = 0;
+                    for (auto const& c : groups[0]) if (!c.negated) n += Occurrences(model.at(FullTextUtf8(h.path)), c);
+                    CHECK(h.matches == n);
+                }
+            // top-k: the best of the full ranking
+            opt.topK = 5;
+            auto top = index.Query(FullTextNative(q), opt);
+            CHECK(top.size() == std::min<size_t>(5, hits.size()));
+            for (size_t i = 0; i < top.size(); ++i) CHECK(top[i].score == hits[i].score);
+        }
+    }
+}
+
+static std::vector<std::string> RandomDoc(std::mt19937& g) {
+    static const char* words[] = { "alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta", "kappa", "lambda", "mu", "nu",
+                                   "xi", "omicron", "pi", "rho", "sigma", "tau", "upsilon", "phi", "chi", "psi", "omega", "alphabet" };
+    std::vector<std::string> doc(1 + g() % 60);
+    for (auto& w : doc) {
+        uint32_t r = g() % 100;
+        w = r < 3 ? "rare" + std::to_string(g() % 40) : words[r % 7 == 0 ? g() % 24 : g() % 6];   // a few common words
+    }
+    return doc;
+}
+
+static std::string Text(std::mt19937& g, const std::vector<std::string>& doc) {
+    static const char* seps[] = { " ", ", ", ".\n", " - ", "\t(", ") " };
+    std::string s;
+    for (auto const& w : doc) {
+        std::string word = w;
+        if (g() % 5 == 0) for (auto& c : word) c = (char)toupper(c);
+        s += word + seps[g() % 6];
+    }
+    return s;
+}
+
+static void TestIndex(const TestDir& dir) {
+    std::mt19937 g(44);
+    FullTextOptions fo;
+    fo.bufferBytes = 48 << 10;                                  // several segments from the first batch
+    fo.backgroundMerge = false;
+    Model model;
+    std::map<std::string, uint64_t> sizes;
+    FullTextIndex index;
+    CHECK(index.Open(dir / "ft", fo));
+    auto add = [&](const std::string& path, uint64_t mtime) {
+        auto doc = RandomDoc(g);
+        std::string text = Text(g, doc);
+        index.AddText(FullTextNative(path), text.size(), mtime, text);
+        model[path] = doc;
+        sizes[path] = text.size();
+    };
+    for (int i = 0; i < 3000; ++i) add(std::string(i % 3 == 0 ? "/docs/a/" : i % 3 == 1 ? "/docs/ab/" : "/docs/a/sub/") + "f" + std::to_string(i) + ".txt", 1);
+    CHECK(index.Commit());
+    FullTextStats s = index.Stats();
+    CHECK(s.segments >= 4 && s.documents == 3000 && s.bufferedDocs == 0);
+    CheckQueries(index, model);
+
+    // merged segments answer the same
+    index.MergeAll();
+    CHECK(index.Stats().segments < s.segments && index.Stats().documents == 3000);
+    CheckQueries(index, model);
+
+    // replace a third (the old versions are hidden), remove some, add new ones; still the same answers
+    for (int i = 0; i < 3000; i += 3) add("/docs/a/f" + std::to_string(i) + ".txt", 2);
+    for (int i = 1; i < 3000; i += 10) { index.Remove(FullTextNative("/docs/ab/f" + std::to_string(i) + ".txt")); model.erase("/docs/ab/f" + std::to_string(i) + ".txt"); }
+    index.RemoveIf([](IndexStringView p) { return FullTextUtf8(p).find("/sub/f2") != std::string::npos; });
+    for (auto it = model.begin(); it != model.end();) it = it->first.find("/sub/f2") != std::string::npos ? model.erase(it) : std::next(it);
+    CHECK(index.Contains(FullTextNative("/docs/a/f0.txt"), sizes["/docs/a/f0.txt"], 2));
+    CHECK(!index.Contains(FullTextNative("/docs/a/f0.txt"), sizes["/docs/a/f0.txt"], 1) && !index.Contains(FullTextNative("/docs/ab/f1.txt"), 0, 1));
+    for (int i = 0; i < 200; ++i) add("/docs/ab/new" + std::to_string(i) + ".txt", 3);
+    CHECK(index.Commit());
+    CHECK(index.Stats().documents == model.size());
+    CheckQueries(index, model);
+    index.MergeAll();
+    CheckQueries(index, model);
+
+    // reopen: segments, deletions and the manifest come back
+    size_t before = index.Stats().segments;
+    index.Close();
+    FullTextIndex again;
+    CHECK(again.Open(dir / "ft", fo));
+    CHECK(again.Stats().segments == before && again.Stats().documents == model.size());
+    CheckQueries(again, model);
+    CHECK(again.Contains(FullTextNative("/docs/ab/new7.txt"), sizes["/docs/ab/new7.txt"], 3));
+    std::atomic<bool> cancel{ true };
+    CHECK(!again.Query(FullTextNative("alpha"), FullTextQueryOptions(), [](std::vector<FullTextHit>&&) { CHECK(false); }, nullptr, &cancel));
+}
+
+static void TestFiles(const TestDir& dir) {
+    FullTextOptions fo;
+    fo.backgroundMerge = false;
+    FullTextIndex index;
+    CHECK(index.Open(dir / "ft2", fo));
+    WriteFile(dir / "files" / "plain.TXT", "Quarterly invoice for ACME");
+    WriteFile(dir / "files" / "image.png", "invoice in a png");
+    WriteFile(dir / "files" / "binary.txt", std::string("invoice\0binary", 14));
+    // UTF-16LE with BOM: "Grüße invoice 😀x" (the emoji as a surrogate pair, glued to x)
+    std::u16string u = u"Grüße invoice \U0001F600x";
+    std::string utf16 = "\xFF\xFE";
+    for (char16_t c : u) { utf16 += (char)(c & 0xFF); utf16 += (char)(c >> 8); }
+    WriteFile(dir / "files" / "wide.txt", utf16);
+    for (auto const& e : fs::directory_iterator(dir / "files")) CHECK(index.AddFile(e.path(), fs::file_size(e.path()), 5));
+    CHECK(!index.AddFile(dir / "files" / "missing.txt", 0, 0));
+    CHECK(index.Commit());
+    auto paths = [&](const char* q) {
+        std::set<std::string> out;
+        for (auto const& h : index.Query(FullTextNative(q))) out.insert(fs::path(h.path).filename().string());
+        return out;
+    };
+    CHECK(paths("invoice") == std::set<std::string>({ "plain.TXT", "wide.txt" }));
+    CHECK(paths("grüße") == std::set<std::string>({ "wide.txt" }) && paths("\U0001F600x") == std::set<std::string>({ "wide.txt" }));
+    CHECK(paths("acme quarterly") == std::set<std::string>({ "plain.TXT" }));
+    // skipped files are still recorded, so they are not read again
+    CHECK(index.Contains((dir / "files" / "image.png").native(), fs::file_size(dir / "files" / "image.png"), 5));
+    CHECK(index.Contains((dir / "files" / "binary.txt").native(), 14, 5));
+}
+
+int main() {
+    TestDir dir("full_text_index_test");
+    TestPostings();
+    TestTokenizer();
+    TestIndex(dir);
+    TestFiles(dir);
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,167 @@
+// FuzzySearch against a textbook dynamic program: Levenshtein distance and best-match-anywhere
+// (Distance / Search / SearchBackward) on random strings one to four 64-bit blocks long, with
+// case differences and non-ASCII characters; NameMatcher against the DP and a plain substring search;
+// FuzzyIndex::Query against brute force over every name (all tiers, top-k order, match spans, scope,
+// the parallel scan).
+#include "FuzzySearch.h"
+#include "TestUtil.h"
+
+#include <map>
+
+template <class Ch> using Str = std::basic_string<Ch>;
+
+// D[i][j]: pattern[0, i) against text[0, j); anywhere = the match may start at any text position
+template <class Ch>
+static int Reference(const Str<Ch>& pattern, const Str<Ch>& text, bool anywhere, size_t* end = nullptr) {
+    size_t m = pattern.size(), n = text.size();
+    std::vector<int> prev(n + 1), cur(n + 1);
+    for (size_t j = 0; j <= n; ++j) prev[j] = anywhere ? 0 : (int)j;
+    for (size_t i = 1; i <= m; ++i) {
+        cur[0] = (int)i;
+        for (size_t j = 1; j <= n; ++j) {
+            int sub = prev[j - 1] + (FuzzyFold(pattern[i - 1]) != FuzzyFold(text[j - 1]));
+            cur[j] = std::min({ sub, prev[j] + 1, cur[j - 1] + 1 });
+        }
+        std::swap(prev, cur);
+    }
+    if (!anywhere) return prev[n];
+    size_t best = 0;
+    for (size_t j = 1; j <= n; ++j) if (prev[j] < prev[best]) best = j;   // the first end with the fewest edits
+    if (end) *end = best;
+    return prev[best];
+}
+
+// Random strings over a small alphabet (so that matches are common), some characters upper case
+template <class Ch>
+static Str<Ch> Random(std::mt19937& g, size_t n, bool wide) {
+    static const char letters[] = "abcdeABCDE._ 1";
+    Str<Ch> s(n, Ch());
+    for (auto& c : s) c = (wide && g() % 8 == 0) ? (Ch)(0x4E00 + g() % 3) : (Ch)letters[g() % (sizeof(letters) - 1)];
+    return s;
+}
+
+template <class Ch>
+static void TestKernel(bool wide) {
+    std::mt19937 g(40);
+    for (int round = 0; round < 3000; ++round) {
+        size_t m = round < 2000 ? g() % 70 : g() % 200;             // one block, then up to four
+        size_t n = g() % 220;
+        Str<Ch> a = Random<Ch>(g, m, wide), b = Random<Ch>(g, n, wide);
+        if (round % 3 == 0 && n > m && m) b.replace(g() % (n - m), m, a);   // plant the pattern
+        FuzzyPattern<Ch> p(std::basic_string_view<Ch>(a.data(), a.size()));
+        CHECK(p.Distance(b.data(), b.size()) == Reference(a, b, false));
+        CHECK(FuzzyLevenshtein<Ch>(a, b) == Reference(a, b, false) && FuzzyLevenshtein<Ch>(b, a) == Reference(a, b, false));
+        size_t end = 0, refEnd = 0;
+        int d = p.Search(b.data(), b.size(), &end);
+        CHECK(d == Reference(a, b, true, &refEnd) && end == refEnd);
+        Str<Ch> folded(b);
+        for (auto& c : folded) c = FuzzyFold(c);
+        CHECK(p.template Search<true>(folded.data(), folded.size()) == d);
+        // the reversed pattern over the text before `end` finds where a best match starts
+        Str<Ch> rev(a.rbegin(), a.rend());
+        FuzzyPattern<Ch> bwd(std::basic_string_view<Ch>(rev.data(), rev.size()));
+        size_t start = 0;
+        CHECK(bwd.SearchBackward(b.data(), end, &start) == d && start <= end);
+        CHECK(Reference(a, b.substr(start, end - start), false) == d);
+    }
+}
+
+static void TestNameMatcher() {
+    std::mt19937 g(41);
+    for (int round = 0; round < 5000; ++round) {
+        std::string needle = Random<char>(g, g() % 12, false), name = Random<char>(g, g() % 30, false);
+        if (round % 2 && name.size() > needle.size()) name.replace(g() % (name.size() - needle.size()), needle.size(), needle);
+        if (round % 4 == 1 && !needle.empty()) needle[g() % needle.size()] = 'x';
+        int maxDistance = (int)(g() % 4);
+        int d = 0;
+        bool fuzzy = NameMatcher<char>(needle, true, false, maxDistance).Matches(name, &d);
+        int allowed = std::min(maxDistance, (int)needle.size() / 3), ref = Reference(needle, name, true);
+        CHECK(fuzzy == (needle.empty() || ref <= allowed));
+        if (fuzzy && !needle.empty()) CHECK(d == ref);
+        std::string lowName = name, lowNeedle = needle;
+        for (auto& c : lowName) c = FuzzyFold(c);
+        for (auto& c : lowNeedle) c = FuzzyFold(c);
+        CHECK(NameMatcher<char>(needle, false, false, 0).Matches(name) == (lowName.find(lowNeedle) != std::string::npos));
+        CHECK(NameMatcher<char>(needle, false, true, 0).Matches(name) == (name.find(needle) != std::string::npos));
+    }
+}
+
+static IndexString Native(const std::string& s) { return std::filesystem::path(s).native(); }
+
+static void TestIndex() {
+    // names from words, so that queries with typos have matches at several distances
+    const char* words[] = { "invoice", "report", "holiday", "photo", "summary", "budget", "contract", "resume", "logo", "draft" };
+    const char* exts[] = { ".pdf", ".png", ".txt", ".docx" };
+    const char* dirs[] = { "/data/a", "/data/a/sub", "/data/b", "/home/x", "/data/ab" };
+    std::mt19937 g(42);
+    FuzzyIndex index;
+    std::vector<std::string> names, paths;
+    const size_t n = 150000;                                    // more than two scan slices
+    for (size_t i = 0; i < n; ++i) {
+        std::string name;
+        for (int w = 0, count = 1 + g() % 3; w < count; ++w) {
+            if (w) name += "_- "[g() % 3];
+            std::string word = words[g() % 10];
+            if (g() % 5 == 0) word[g() % word.size()] = "aeiouxyz"[g() % 8];  // typos in the data too
+            if (g() % 4 == 0) word[0] = (char)(word[0] - 32);
+            name += word;
+        }
+        if (g() % 2) name += std::to_string(g() % 3000);
+        name += exts[g() % 4];
+        names.push_back(name);
+        paths.push_back(std::string(dirs[g() % 5]) + "/" + name);
+        CHECK(index.Add(Native(paths.back())) == i);
+    }
+    index.Build();
+    CHECK(index.Size() == n && index.Path(7) == Native(paths[7]) && index.Name(7) == Native(names[7]));
+
+    WorkPool pool(3);
+    for (const char* query : { "invoice", "invioce", "ph", "rsume", "logo.png", "budgte_2", "HOLIDAY", "contrct", "x", "summary_report" }) {
+        std::string qs = query;
+        int kMax = std::min(2, (int)qs.size() / 3);
+        for (const char* scope : { "", "/data/a" }) {
+            // brute force: every name with its best distance
+            std::map<uint32_t, int> want;
+            for (uint32_t id = 0; id < n; ++id) {
+                if (*scope && paths[id].compare(0, 8, "/data/a/") != 0) continue;          // not /data/ab
+                int d = Reference(qs, names[id], true);
+                if (d <= kMax) want[id] = d;
+            }
+            FuzzyQueryOptions opt;
+            opt.topK = n;
+            opt.scope = Native(scope);
+            FuzzyQueryStats st;
+            auto all = index.Query(Native(qs), opt, &st);
+            CHECK(all.size() == want.size() && st.matches == want.size() && st.tiers == kMax + 1);
+            for (size_t i = 0; i < all.size(); ++i) {
+                auto const& h = all[i];
+                CHECK(want.count(h.id) && want[h.id] == h.distance);
+                std::string span = names[h.id].substr(h.matchStart, h.matchEnd - h.matchStart);
+                CHECK(Reference(qs, span, false) == h.distance);
+                if (i) CHECK(all[i - 1].score > h.score || (all[i - 1].score == h.score && all[i - 1].id < h.id));
+                if (i) CHECK(all[i - 1].distance <= h.distance);
+            }
+            // top-k is the head of the full ranking, with or without the pool
+            opt.topK = 25;
+            auto top = index.Query(Native(qs), opt);
+            CHECK(top.size() == std::min<size_t>(25, all.size()));
+            for (size_t i = 0; i < top.size(); ++i) CHECK(top[i].id == all[i].id && top[i].score == all[i].score);
+            auto par = index.Query(Native(qs), opt, nullptr, &pool);
+            CHECK(par.size() == top.size());
+            for (size_t i = 0; i < top.size(); ++i) CHECK(par[i].id == top[i].id && par[i].matchEnd == top[i].matchEnd);
+        }
+    }
+    FuzzyQueryOptions opt;
+    CHECK(index.Query(IndexString(), opt).empty());
+    opt.maxDistance = 0;
+    for (auto const& h : index.Query(Native("photo"), opt)) CHECK(h.distance == 0);
+}
+
+int main() {
+    TestKernel<char>(false);
+    TestKernel<wchar_t>(true);
+    TestNameMatcher();
+    TestIndex();
+    std::printf("OK\n");
+    return 0;
+}
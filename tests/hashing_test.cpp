@@ -0,0 +1,136 @@
+// Hashing against known answers: SHA-1 / SHA-256 (FIPS 180 examples plus lengths around the padding
+// boundary), the official BLAKE3 test vectors (input byte i = i % 251) up to multi-level trees, and
+// pinned FastHash128 / FastHash64 values (the digests are stored in caches, so they must not drift).
+// Each vector is hashed in one call and fed in odd-sized pieces, with the detected CPU paths, with AVX2
+// off (BLAKE3 on SSE4.1) and with every flag cleared (the portable code). HashFile: sequential and
+// parallel BLAKE3, bytes read, cancel, missing file.
+#include "Hashing.h"
+#include "TestUtil.h"
+
+namespace fs = std::filesystem;
+
+struct Vector { HashAlgo algo; size_t len; const char* hex; };
+
+static const Vector kVectors[] = {
+    { HashAlgo::Sha1, 0, "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+    { HashAlgo::Sha1, 3, "0c7a623fd2bbc05b06423be359e4021d36e721ad" },
+    { HashAlgo::Sha1, 55, "8ae2d46729cfe68ff927af5eec9c7d1b66d65ac2" },
+    { HashAlgo::Sha1, 56, "636e2ec698dac903498e648bd2f3af641d3c88cb" },
+    { HashAlgo::Sha1, 63, "6d942da0c4392b123528f2905c713a3ce28364bd" },
+    { HashAlgo::Sha1, 64, "c6138d514ffa2135bfce0ed0b8fac65669917ec7" },
+    { HashAlgo::Sha1, 65, "69bd728ad6e13cd76ff19751fde427b00e395746" },
+    { HashAlgo::Sha1, 119, "41c89d06001bab4ab78736b44efe7ce18ce6ae08" },
+    { HashAlgo::Sha1, 1000, "c9c960a0b925474fab83942cc27d504fc24ac37b" },
+    { HashAlgo::Sha1, 1000000, "1f7cafedffb2797c60013e6f95d7763bbc57c1ee" },
+    { HashAlgo::Sha256, 0, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+    { HashAlgo::Sha256, 3, "ae4b3280e56e2faf83f414a6e3dabe9d5fbe18976544c05fed121accb85b53fc" },
+    { HashAlgo::Sha256, 55, "463eb28e72f82e0a96c0a4cc53690c571281131f672aa229e0d45ae59b598b59" },
+    { HashAlgo::Sha256, 56, "da2ae4d6b36748f2a318f23e7ab1dfdf45acdc9d049bd80e59de82a60895f562" },
+    { HashAlgo::Sha256, 63, "29af2686fd53374a36b0846694cc342177e428d1647515f078784d69cdb9e488" },
+    { HashAlgo::Sha256, 64, "fdeab9acf3710362bd2658cdc9a29e8f9c757fcf9811603a8c447cd1d9151108" },
+    { HashAlgo::Sha256, 65, "4bfd2c8b6f1eec7a2afeb48b934ee4b2694182027e6d0fc075074f2fabb31781" },
+    { HashAlgo::Sha256, 119, "da18797ed7c3a777f0847f429724a2d8cd5138e6ed2895c3fa1a6d39d18f7ec6" },
+    { HashAlgo::Sha256, 1000, "4e4c294b331f7a2099a379bec34b9f9fc03dc46ab465d998f4d683da53487e6d" },
+    { HashAlgo::Sha256, 1000000, "2c030d49ec131bfbbb446ad21e7a2f12cdb4f2f4f3fda3ac709dd2e68a4646c7" },
+    { HashAlgo::Blake3, 0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262" },
+    { HashAlgo::Blake3, 1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213" },
+    { HashAlgo::Blake3, 1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11" },
+    { HashAlgo::Blake3, 1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7" },
+    { HashAlgo::Blake3, 1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444" },
+    { HashAlgo::Blake3, 2048, "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a" },
+    { HashAlgo::Blake3, 2049, "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030" },
+    { HashAlgo::Blake3, 3072, "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2" },
+    { HashAlgo::Blake3, 3073, "7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd3" },
+    { HashAlgo::Blake3, 4096, "015094013f57a5277b59d8475c0501042c0b642e531b0a1c8f58d2163229e969" },
+    { HashAlgo::Blake3, 4097, "9b4052b38f1c5fc8b1f9ff7ac7b27cd242487b3d890d15c96a1c25b8aa0fb995" },
+    { HashAlgo::Blake3, 5120, "9cadc15fed8b5d854562b26a9536d9707cadeda9b143978f319ab34230535833" },
+    { HashAlgo::Blake3, 5121, "628bd2cb2004694adaab7bbd778a25df25c47b9d4155a55f8fbd79f2fe154cff" },
+    { HashAlgo::Blake3, 6144, "3e2e5b74e048f3add6d21faab3f83aa44d3b2278afb83b80b3c35164ebeca205" },
+    { HashAlgo::Blake3, 6145, "f1323a8631446cc50536a9f705ee5cb619424d46887f3c376c695b70e0f0507f" },
+    { HashAlgo::Blake3, 7168, "61da957ec2499a95d6b8023e2b0e604ec7f6b50e80a9678b89d2628e99ada77a" },
+    { HashAlgo::Blake3, 7169, "a003fc7a51754a9b3c7fae0367ab3d782dccf28855a03d435f8cfe74605e7817" },
+    { HashAlgo::Blake3, 8192, "aae792484c8efe4f19e2ca7d371d8c467ffb10748d8a5a1ae579948f718a2a63" },
+    { HashAlgo::Blake3, 8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b" },
+    { HashAlgo::Blake3, 16384, "f875d6646de28985646f34ee13be9a576fd515f76b5b0a26bb324735041ddde4" },
+    { HashAlgo::Blake3, 31744, "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47" },
+    { HashAlgo::Blake3, 102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085" },
+    { HashAlgo::Blake3, 1048577, "2f053cd7472cf0cd2f9adaf45c1180255b91b9a865404a63671a0ee5f792ed33" },
+    { HashAlgo::Fast128, 0, "99e9d85137db46ef9e8822af4363d819" },
+    { HashAlgo::Fast128, 1, "682705db4aa834e9e1ab22ead2ba66c3" },
+    { HashAlgo::Fast128, 31, "41b95b2cc761621c333e45e97cf04694" },
+    { HashAlgo::Fast128, 32, "b432ff16519cf5cbdde26e5e7b2b5b74" },
+    { HashAlgo::Fast128, 33, "ad8efbca1a5d530c2e9d79d2b9918efe" },
+    { HashAlgo::Fast128, 1000, "d3548ba84af006f347261615e27d001c" },
+    { HashAlgo::Fast128, 1048576, "314a46c49903ac8957c2a37a7db4f057" },
+};
+
+static std::string Pattern(size_t n) {
+    std::string s(n, '\0');
+    for (size_t i = 0; i < n; ++i) s[i] = (char)(i % 251);
+    return s;
+}
+
+static void CheckVectors() {
+    for (auto const& v : kVectors) {
+        std::string data = Pattern(v.len);
+        CHECK(HashBytes(v.algo, data.data(), data.size()).Hex() == v.hex);
+        Hasher h(v.algo);
+        static const size_t pieces[] = { 1, 7, 63, 64, 65, 1000, 1024, 1025, 16383, 70000 };
+        for (size_t off = 0, i = 0; off < data.size(); ++i) {
+            size_t n = std::min(pieces[i % 10], data.size() - off);
+            h.Update(data.data() + off, n);
+            off += n;
+        }
+        CHECK(h.Final().Hex() == v.hex);
+    }
+    CHECK(FastHash64(nullptr, 0, 0x9E3779B97F4A7C15ull) == 0xc4349fc93c010000ull);
+    std::string data = Pattern(1000);
+    CHECK(FastHash64(data.data(), 1, 0x9E3779B97F4A7C15ull) == 0x126bb57a12364aa5ull);
+    CHECK(FastHash64(data.data(), 1000, 0x9E3779B97F4A7C15ull) == 0xd9b7af87dd48f5b4ull);
+}
+
+static void CheckFiles(const TestDir& dir) {
+    const size_t n = 3 * (1 << 20) + 12345;
+    std::string data = Pattern(n);
+    WriteFile(dir / "data", data);
+    HashFileOptions opt;
+    opt.readSize = 65536;
+    for (HashAlgo algo : { HashAlgo::Sha1, HashAlgo::Sha256, HashAlgo::Blake3, HashAlgo::Fast128 }) {
+        HashDigest d;
+        uint64_t read = 0;
+        CHECK(HashFile(dir / "data", algo, d, nullptr, opt, &read) && read == n && d == HashBytes(algo, data.data(), n));
+    }
+    // BLAKE3 split into subtrees hashed by several threads: the same digest, every byte read once
+    HashDigest d;
+    uint64_t read = 0;
+    for (unsigned threads : { 2u, 3u, 8u }) {
+        HashFileOptions par = opt;
+        par.threads = threads;
+        par.parallelMin = 1;
+        read = 0;
+        CHECK(HashFile(dir / "data", HashAlgo::Blake3, d, nullptr, par, &read) && read == n);
+        CHECK(d.Hex() == "ce1148523b8586723c3fd8b1fe92fe16394888a360c96965bf3b1900421f3e19");
+    }
+    std::atomic<bool> cancel{ true };
+    CHECK(!HashFile(dir / "data", HashAlgo::Sha256, d, &cancel));
+    CHECK(!HashFile(dir / "missing", HashAlgo::Sha256, d));
+    WriteFile(dir / "empty", "");
+    CHECK(HashFile(dir / "empty", HashAlgo::Blake3, d) && d.Hex() == "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262");
+}
+
+int main() {
+    TestDir dir("hashing_test");
+    HashCpu& cpu = HashCpu::Get();
+    const HashCpu detected = cpu;
+    std::printf("detected:%s%s%s\n", cpu.sse41 ? " sse4.1" : "", cpu.avx2 ? " avx2" : "", cpu.shaNi ? " sha-ni" : "");
+    CheckVectors();
+    CheckFiles(dir);
+    cpu.avx2 = false;                                   // BLAKE3 four lanes at a time
+    CheckVectors();
+    cpu = HashCpu();                                    // portable code only
+    CheckVectors();
+    CheckFiles(dir);
+    cpu = detected;
+    std::printf("OK\n");
+    return 0;
+}
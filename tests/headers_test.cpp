@@ -0,0 +1,33 @@
+// Every portable header on its own include line: they must compile together, warning-free, on Linux.
+// (VirtualItemSource.h needs C++/WinRT and is left out.)
+#include "CopyEngine.h"
+#include "DirEnum.h"
+#include "DiskUsage.h"
+#include "DuplicateFinder.h"
+#include "FileIndex.h"
+#include "FsWatcher.h"
+#include "FullTextIndex.h"
+#include "FuzzySearch.h"
+#include "Hashing.h"
+#include "IndexPipeline.h"
+#include "IndexSync.h"
+#include "ListingStore.h"
+#include "ParallelSearch.h"
+#include "RenamePlanner.h"
+#include "SearchSession.h"
+#include "SemanticIndex.h"
+#include "SortKeys.h"
+#include "TagExtractor.h"
+#include "ThumbnailCache.h"
+#include "ThumbnailScheduler.h"
+#include "WorkPool.h"
+
+#include "Codec.h"
+#include "CsvIndex.h"
+#include "HexDocument.h"
+#include "JsonStream.h"
+#include "MappedFile.h"
+#include "Simd.h"
+#include "UndoHistory.h"
+
+int main() { return 0; }
@@ -0,0 +1,132 @@
+// HexDocument against a plain byte vector: patch overlay reads, Find() for matches straddling the
+// 1 MB search windows and made of patched bytes (with and without wrap), SaveInPlace writing only the
+// patches, SaveAs, SniffBinary and ParsePattern.
+#include "HexDocument.h"
+#include "TestUtil.h"
+
+namespace fs = std::filesystem;
+
+static const uint64_t kWin = 1 << 20;
+
+// First match at or after from, wrapping once; UINT64_MAX if none
+static uint64_t RefFind(const std::vector<uint8_t>& hay, const std::vector<uint8_t>& pat, uint64_t from, bool wrap) {
+    auto at = [&](uint64_t b, uint64_t e) -> uint64_t {
+        for (uint64_t i = b; i < e && i + pat.size() <= hay.size(); ++i)
+            if (memcmp(hay.data() + i, pat.data(), pat.size()) == 0) return i;
+        return UINT64_MAX;
+    };
+    uint64_t hit = at(from, hay.size());
+    if (hit == UINT64_MAX && wrap && from > 0) hit = at(0, from);
+    return hit;
+}
+
+static void TestOverlayAndFind(const TestDir& d) {
+    // low-entropy content: many first/last-byte candidates for the SIMD filter to reject
+    std::vector<uint8_t> ref(3 * kWin + 12345);
+    std::mt19937 g(6);
+    for (auto& b : ref) b = (uint8_t)("ACGT"[g() % 4]);
+    std::ofstream(d / "a.bin", std::ios::binary).write((const char*)ref.data(), (std::streamsize)ref.size());
+
+    HexDocument doc;
+    CHECK(doc.Open(d / "a.bin") && doc.Size() == ref.size() && !doc.Modified());
+    for (int i = 0; i < 2000; ++i) {
+        uint64_t off = g() % ref.size();
+        uint8_t v = (uint8_t)g();
+        doc.SetByte(off, v);
+        ref[off] = v;
+    }
+    doc.SetByte(ref.size(), 1);                                   // past the end: ignored
+    // setting a byte back to the file's value drops the patch
+    size_t patches = doc.PatchCount();
+    uint64_t p0 = 777;
+    while (doc.IsPatched(p0)) ++p0;
+    uint8_t orig = doc.ByteAt(p0);
+    doc.SetByte(p0, (uint8_t)(orig ^ 0xFF));
+    CHECK(doc.PatchCount() == patches + 1 && doc.IsPatched(p0));
+    doc.SetByte(p0, orig);
+    CHECK(doc.PatchCount() == patches && !doc.IsPatched(p0));
+
+    std::vector<uint8_t> buf(70000);
+    for (int i = 0; i < 200; ++i) {
+        uint64_t off = g() % (ref.size() + 10);
+        size_t n = doc.Read(off, buf.data(), buf.size());
+        CHECK(n == (off >= ref.size() ? 0 : std::min<uint64_t>(buf.size(), ref.size() - off)));
+        CHECK(memcmp(buf.data(), ref.data() + std::min<uint64_t>(off, ref.size()), n) == 0);
+    }
+
+    // a pattern planted through patches across each window boundary
+    std::vector<uint8_t> pat = { 0x00, 0xDE, 0xAD, 0x01, 0xBE, 0xEF, 0x00 };
+    for (uint64_t w = 1; w <= 3; ++w) {
+        uint64_t at = w * kWin - 3;
+        for (size_t k = 0; k < pat.size(); ++k) { doc.SetByte(at + k, pat[k]); ref[at + k] = pat[k]; }
+    }
+    CHECK(doc.Find(pat, 0) == kWin - 3);
+    CHECK(doc.Find(pat, kWin - 2) == 2 * kWin - 3);
+    CHECK(doc.Find(pat, 3 * kWin - 2) == kWin - 3);               // wraps to the first one
+    CHECK(doc.Find(pat, 3 * kWin - 2, false) == UINT64_MAX);
+    CHECK(doc.Find(pat, 3 * kWin - 3, false) == 3 * kWin - 3);
+    std::vector<uint8_t> tail(ref.end() - 9, ref.end());
+    CHECK(doc.Find(tail, 0) == RefFind(ref, tail, 0, true));      // match ending at the last byte
+
+    // patterns cut from the content at random places, 1..40 bytes, against the reference search
+    for (int i = 0; i < 300; ++i) {
+        size_t m = 1 + g() % 40;
+        uint64_t src = g() % (ref.size() - m);
+        if (i % 3 == 0) src = (1 + g() % 3) * kWin - g() % m;      // around a window boundary
+        std::vector<uint8_t> p(ref.begin() + src, ref.begin() + src + m);
+        uint64_t from = g() % ref.size();
+        CHECK(doc.Find(p, from) == RefFind(ref, p, from, true));
+        CHECK(doc.Find(p, from, false) == RefFind(ref, p, from, false));
+    }
+    std::vector<uint8_t> none = { 'A', 'C', 'G', 'T', 'X', 'A' };
+    CHECK(doc.Find(none, 0) == RefFind(ref, none, 0, true));
+    CHECK(doc.Find(std::vector<uint8_t>(ref.size() + 1, 'A'), 0) == UINT64_MAX);
+
+    // SaveAs writes the patched content and continues on the copy; the original stays untouched
+    std::string before = ReadFile(d / "a.bin");
+    CHECK(doc.SaveAs(d / "b.bin") && !doc.Modified() && doc.Path() == d / "b.bin");
+    CHECK(ReadFile(d / "b.bin") == std::string(ref.begin(), ref.end()));
+    CHECK(ReadFile(d / "a.bin") == before);
+
+    // SaveInPlace: only the patched runs are written, the mapping sees them
+    doc.SetByte(5, 'x');
+    doc.SetByte(6, 'y');
+    doc.SetByte(ref.size() - 1, 'z');
+    ref[5] = 'x'; ref[6] = 'y'; ref[ref.size() - 1] = 'z';
+    CHECK(doc.Modified() && doc.SaveInPlace() && !doc.Modified());
+    CHECK(fs::file_size(d / "b.bin") == ref.size());
+    CHECK(ReadFile(d / "b.bin") == std::string(ref.begin(), ref.end()));
+    CHECK(doc.ByteAt(5) == 'x' && doc.ByteAt(ref.size() - 1) == 'z');
+    HexDocument again;
+    CHECK(again.Open(d / "b.bin") && again.ByteAt(6) == 'y');
+    CHECK(doc.SaveInPlace());                                     // nothing to do
+
+    doc.SetByte(10, (uint8_t)~doc.ByteAt(10));
+    doc.RevertAll();
+    CHECK(!doc.Modified() && doc.ByteAt(10) == ref[10]);
+}
+
+static void TestHelpers(const TestDir& d) {
+    WriteFile(d / "text.txt", std::string(10000, 'a'));
+    WriteFile(d / "nul.bin", std::string(9000, 'a') + std::string(1, '\0'));
+    WriteFile(d / "early.bin", std::string("MZ\0\0", 4) + std::string(100, 'x'));
+    WriteFile(d / "utf16.txt", std::string("\xFF\xFEh\0i\0", 6));
+    CHECK(!HexDocument::SniffBinary(d / "text.txt"));
+    CHECK(!HexDocument::SniffBinary(d / "nul.bin"));              // NUL after the 8 KB sample
+    CHECK(HexDocument::SniffBinary(d / "early.bin"));
+    CHECK(!HexDocument::SniffBinary(d / "utf16.txt"));
+    CHECK(!HexDocument::SniffBinary(d / "missing"));
+
+    std::vector<uint8_t> p;
+    CHECK(HexDocument::ParsePattern("DE AD be,ef", p) && (p == std::vector<uint8_t>{ 0xDE, 0xAD, 0xBE, 0xEF }));
+    CHECK(HexDocument::ParsePattern("\"PK\"", p) && (p == std::vector<uint8_t>{ 'P', 'K' }));
+    CHECK(!HexDocument::ParsePattern("ABC", p) && !HexDocument::ParsePattern("zz", p) && !HexDocument::ParsePattern("", p));
+}
+
+int main() {
+    TestDir d("hex_document_test");
+    TestOverlayAndFind(d);
+    TestHelpers(d);
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,151 @@
+// IndexSync on a temp tree: a rescan re-reads only new / changed files (also after Compact + reopen),
+// drops what is gone but keeps what lies below an unreadable folder; Apply() handles file / folder
+// renames without re-hashing, removals and Overflow; with FsWatcher running the index converges to
+// the tree after a burst of changes.
+#include "IndexSync.h"
+#include "TestUtil.h"
+
+#include <map>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+struct Sync {
+    FileIndex index;
+    std::mutex mutex;
+    IndexSync sync{ index, mutex };
+    IndexPipeline pipeline;
+    IndexPipelineOptions opt;
+    std::atomic<int> hashed{ 0 };
+
+    explicit Sync(const fs::path& dir) {
+        CHECK(index.Open(dir));
+        IndexPipelineStages st;
+        st.hash = [this](FileIndexEntry& e) {
+            HashDigest d;
+            if (!HashFile(e.path, HashAlgo::Fast128, d)) return;
+            memcpy(e.hash, d.bytes, d.len);
+            e.hashLen = d.len;
+            hashed++;
+        };
+        sync.SetStages(st);
+        opt.walkThreads = opt.tagThreads = 2;
+    }
+    int Rescan(const fs::path& root) {
+        hashed = 0;
+        CHECK(sync.Rescan(root, opt, pipeline));
+        return hashed.load();
+    }
+    bool Has(const fs::path& p) {
+        std::lock_guard<std::mutex> lg(mutex);
+        return index.Contains(p.native());
+    }
+};
+
+static fs::path TreeFile(int i) { return fs::path("d" + std::to_string(i % 10)) / ("f" + std::to_string(i)); }
+
+// index == files on disk below root, each with its current size and content hash
+static bool Converged(Sync& s, const fs::path& root) {
+    std::map<IndexString, uint64_t> disk;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(root, ec); it != fs::recursive_directory_iterator(); it.increment(ec))
+        if (it->is_regular_file(ec)) disk[it->path().native()] = it->file_size(ec);
+    std::lock_guard<std::mutex> lg(s.mutex);
+    if (s.index.Size() != disk.size()) return false;
+    for (auto const& [path, size] : disk) {
+        FileIndexEntry e;
+        HashDigest d;
+        if (!s.index.Find(path, e) || e.size != size || !HashFile(path, HashAlgo::Fast128, d)) return false;
+        if (e.hashLen != d.len || memcmp(e.hash, d.bytes, d.len) != 0) return false;
+    }
+    return true;
+}
+
+static void TestRescan(const TestDir& d) {
+    fs::path root = d / "tree";
+    for (int i = 0; i < 300; ++i) WriteRandom(root / TreeFile(i), 100 + i, i);
+    {
+        Sync s(d / "index");
+        CHECK(s.Rescan(root) == 300 && Converged(s, root));
+        CHECK(s.Rescan(root) == 0);
+        CHECK(s.index.Compact());
+    }
+    Sync s(d / "index");                                // snapshot + empty log
+    CHECK(s.index.HasSnapshot() && s.index.Size() == 300);
+    CHECK(s.Rescan(root) == 0);
+
+    WriteRandom(root / TreeFile(1), 5000, 1000);        // changed
+    WriteRandom(root / "new" / "n", 10, 1001);          // added
+    fs::remove(root / TreeFile(2));                     // removed
+    fs::remove_all(root / "d3");                        // removed with its folder
+    fs::rename(root / TreeFile(4), root / "d5" / "moved"); // a full rescan sees remove + add
+    CHECK(s.Rescan(root) == 3 && Converged(s, root));
+    CHECK(!s.Has(root / TreeFile(13)) && s.Has(root / "d5" / "moved"));
+
+    // files below a folder that cannot be read are unknown, not gone (root reads anything)
+    if (geteuid() != 0) {
+        size_t before = s.index.Size();
+        fs::permissions(root / "d6", fs::perms::none);
+        CHECK(s.Rescan(root) == 0 && s.index.Size() == before && s.Has(root / TreeFile(6)));
+        fs::permissions(root / "d6", fs::perms::owner_all);
+    }
+}
+
+static void TestApply(const TestDir& d) {
+    fs::path root = d / "apply";
+    for (int i = 0; i < 50; ++i) WriteRandom(root / TreeFile(i), 100 + i, i);
+    Sync s(d / "apply-index");
+    s.Rescan(root);
+
+    s.hashed = 0;
+    fs::rename(root / TreeFile(0), root / "d0" / "renamed");
+    fs::rename(root / "d1", root / "d1b");
+    WriteRandom(root / "d2" / "added", 77, 77);
+    fs::remove_all(root / "d3");
+    s.sync.Apply({ { FsChange::Renamed, root / "d0" / "renamed", root / TreeFile(0), false },
+                   { FsChange::Renamed, root / "d1b", root / "d1", true },
+                   { FsChange::Added, root / "d2" / "added", {}, false },
+                   { FsChange::Removed, root / "d3", {}, true } }, root, s.opt);
+    CHECK(s.hashed == 1 && Converged(s, root));        // only the added file was read
+    CHECK(s.Has(root / "d1b" / "f11") && !s.Has(root / TreeFile(11)));
+
+    // Overflow: events were lost, the whole tree is compared
+    WriteRandom(root / "d4" / "unseen", 5, 5);
+    fs::remove(root / TreeFile(5));
+    s.sync.Apply({ { FsChange::Modified, root / "d9" / "nothing", {}, false }, { FsChange::Overflow, {}, {}, false } }, root, s.opt);
+    CHECK(s.hashed == 2 && Converged(s, root));
+}
+
+static void TestWatcher(const TestDir& d) {
+    fs::path root = d / "watched";
+    for (int i = 0; i < 100; ++i) WriteRandom(root / TreeFile(i), 100 + i, i);
+    Sync s(d / "watched-index");
+    s.Rescan(root);
+    FsWatcher w;
+    if (!w.Start(root, [&](std::vector<FsEvent>&& events) { s.sync.Apply(events, root, s.opt); },
+                 std::chrono::milliseconds(50), std::chrono::milliseconds(500))) {
+        std::printf("FsWatcher not supported here, skipped\n");
+        return;
+    }
+    WriteRandom(root / TreeFile(1), 4000, 500);
+    fs::remove(root / TreeFile(2));
+    fs::rename(root / TreeFile(3), root / "d0" / "three");
+    fs::rename(root / "d4", root / "d4b");
+    WriteRandom(root / "d4b" / "inside-moved", 10, 501);
+    fs::remove_all(root / "d5");
+    for (int i = 0; i < 20; ++i) WriteRandom(root / "fresh" / "sub" / ("n" + std::to_string(i)), 50, 600 + i);
+    fs::rename(root / "d6", d / "outside");               // moved out of the watched tree
+    bool ok = false;
+    for (int i = 0; i < 200 && !(ok = Converged(s, root)); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    w.Stop();
+    CHECK(ok);
+}
+
+int main() {
+    TestDir d("index_sync_test");
+    TestRescan(d);
+    TestApply(d);
+    TestWatcher(d);
+    std::printf("OK\n");
+    return 0;
+}
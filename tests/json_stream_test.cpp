@@ -0,0 +1,127 @@
+// JsonStream: valid documents validate, pretty-print and minify to the expected text in any chunking;
+// each kind of invalid input reports its error with the right offset / line / column, also when
+// the input is fed one byte at a time.
+#include "JsonStream.h"
+#include "TestUtil.h"
+
+struct Result {
+    bool ok;
+    std::string out;
+    JsonError error;
+    uint64_t offset, line, column;
+};
+
+// Feed s in pieces of the given size (0 = all at once)
+static Result Run(const std::string& s, JsonMode mode, size_t piece = 0) {
+    Result r;
+    JsonStream js(mode, [&](const char* p, size_t n) { r.out.append(p, n); });
+    bool ok = true;
+    size_t step = piece ? piece : std::max<size_t>(s.size(), 1);
+    for (size_t i = 0; ok && i < s.size(); i += step) ok = js.Feed(s.data() + i, std::min(step, s.size() - i));
+    r.ok = ok && js.Finish();
+    r.error = js.Error();
+    r.offset = js.ErrorOffset();
+    r.line = js.ErrorLine();
+    r.column = js.ErrorColumn();
+    return r;
+}
+
+static void TestValid() {
+    const std::string doc = "{ \"name\" : \"Gr\xC3\xBC\xC3\x9F" "e \\\"x\\\" \\u00e9\",\n"
+                            "  \"list\": [1, -0.5e+3, 0, true, false, null, [], {}],\n"
+                            "  \"emoji\": \"\xF0\x9F\x98\x80\", \"nested\": {\"a\": [{\"b\": 2}]}\t}\r\n";
+    const std::string minified = "{\"name\":\"Gr\xC3\xBC\xC3\x9F" "e \\\"x\\\" \\u00e9\",\"list\":[1,-0.5e+3,0,true,false,null,[],{}],"
+                                 "\"emoji\":\"\xF0\x9F\x98\x80\",\"nested\":{\"a\":[{\"b\":2}]}}";
+    const std::string pretty = "{\n"
+                               "  \"name\": \"Gr\xC3\xBC\xC3\x9F" "e \\\"x\\\" \\u00e9\",\n"
+                               "  \"list\": [\n    1,\n    -0.5e+3,\n    0,\n    true,\n    false,\n    null,\n    [],\n    {}\n  ],\n"
+                               "  \"emoji\": \"\xF0\x9F\x98\x80\",\n"
+                               "  \"nested\": {\n    \"a\": [\n      {\n        \"b\": 2\n      }\n    ]\n  }\n"
+                               "}\n";
+    for (size_t piece : { 0, 1, 2, 3, 7, 16, 17, 64 }) {
+        Result v = Run(doc, JsonMode::Validate, piece);
+        CHECK(v.ok && v.error == JsonError::None && v.out.empty());
+        Result m = Run(doc, JsonMode::Minify, piece);
+        CHECK(m.ok && m.out == minified);
+        Result p = Run(doc, JsonMode::Pretty, piece);
+        CHECK(p.ok && p.out == pretty);
+    }
+    CHECK(Run(pretty, JsonMode::Minify).out == minified);
+    CHECK(Run(minified, JsonMode::Pretty).out == pretty);
+
+    // scalars as the top-level value, a number ending at the end of input
+    for (const char* s : { "42", " -1.25E-7 ", "\"\"", "true", "null", "[[[[]]]]" }) CHECK(Run(s, JsonMode::Validate, 1).ok);
+}
+
+struct Bad {
+    const char* text;
+    JsonError error;
+    uint64_t offset, line, column;
+};
+
+static void TestInvalid() {
+    const Bad cases[] = {
+        { "{\"a\": 1,}", JsonError::UnexpectedChar, 8, 1, 9 },
+        { "[1, 2", JsonError::UnexpectedEnd, 5, 1, 6 },
+        { "", JsonError::UnexpectedEnd, 0, 1, 1 },
+        { "\"a\\x\"", JsonError::BadEscape, 3, 1, 4 },
+        { "\"\\u12g4\"", JsonError::BadUnicodeEscape, 5, 1, 6 },
+        { "[\"a\tb\"]", JsonError::ControlChar, 3, 1, 4 },
+        { "[01]", JsonError::UnexpectedChar, 2, 1, 3 },                 // "0" ends, then "1" is no separator
+        { "[1.]", JsonError::BadNumber, 3, 1, 4 },
+        { "-", JsonError::BadNumber, 1, 1, 2 },
+        { "[tru]", JsonError::BadLiteral, 4, 1, 5 },
+        { "\"\xC3\x28\"", JsonError::BadUtf8, 2, 1, 3 },
+        { "\"\xED\xA0\x80\"", JsonError::BadUtf8, 2, 1, 3 },              // UTF-16 surrogate
+        { "\"\xC0\xAF\"", JsonError::BadUtf8, 1, 1, 2 },                  // overlong
+        { "{} {}", JsonError::TrailingData, 3, 1, 4 },
+        { "{\n  \"a\": 1,\n  \"b\" 2\n}", JsonError::UnexpectedChar, 18, 3, 7 },
+        { "[\r\n\r\n   x]", JsonError::UnexpectedChar, 8, 3, 4 },
+    };
+    for (auto const& c : cases) {
+        for (size_t piece : { 0, 1, 3 }) {
+            Result r = Run(c.text, JsonMode::Pretty, piece);
+            if (r.ok || r.error != c.error || r.offset != c.offset || r.line != c.line || r.column != c.column)
+                std::printf("case \"%s\" piece %zu: error %d at %llu (%llu:%llu)\n", c.text, piece, (int)r.error,
+                            (unsigned long long)r.offset, (unsigned long long)r.line, (unsigned long long)r.column);
+            CHECK(!r.ok && r.error == c.error && r.offset == c.offset && r.line == c.line && r.column == c.column);
+        }
+    }
+
+    // nesting limit
+    JsonStream js(JsonMode::Validate, JsonStream::Sink(), 2, 64);
+    std::string deep(65, '[');
+    CHECK(!js.Feed(deep.data(), deep.size()) && js.Error() == JsonError::TooDeep && js.ErrorOffset() == 64);
+    CHECK(!js.Feed("]", 1));                                           // stays failed
+}
+
+// A long document split at random sizes: the sink output does not depend on the chunking
+static void TestRandomChunks() {
+    std::string doc = "[";
+    std::mt19937 g(5);
+    for (int i = 0; i < 20000; ++i) {
+        if (i) doc += ",   \n\t";
+        doc += "{\"id\": " + std::to_string(g() % 100000) + ", \"t\": \"text \xE2\x82\xAC " + std::string(g() % 40, 'x') + "\", \"v\": [1.5, -2e3, null]}";
+    }
+    doc += "]";
+    std::string expect = Run(doc, JsonMode::Pretty).out;
+    CHECK(!expect.empty());
+    for (int round = 0; round < 20; ++round) {
+        std::string out;
+        JsonStream js(JsonMode::Pretty, [&](const char* p, size_t n) { out.append(p, n); });
+        for (size_t i = 0; i < doc.size();) {
+            size_t n = std::min<size_t>(doc.size() - i, 1 + g() % 300);
+            CHECK(js.Feed(doc.data() + i, n));
+            i += n;
+        }
+        CHECK(js.Finish() && out == expect && js.BytesConsumed() == doc.size());
+    }
+}
+
+int main() {
+    TestValid();
+    TestInvalid();
+    TestRandomChunks();
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,164 @@
+// ParallelSearch against a serial walk with std::filesystem: the same hits (paths, distances, sizes)
+// for substring, case-sensitive and fuzzy needles, hidden entries, directories as hits or not,
+// excluded names (any case) and paths pruned with their subtrees, links not followed; maxResults
+// delivers exactly that many, Cancel() from the receiver or before Run stops further batches, and
+// batches never overlap.
+#include "ParallelSearch.h"
+#include "TestUtil.h"
+
+#include <map>
+
+namespace fs = std::filesystem;
+
+struct Ref {
+    std::map<DirString, int> hits;            // path -> distance
+    uint64_t dirs = 0, entries = 0, excluded = 0;
+};
+
+static DirString Folded(DirString s) {
+    for (auto& c : s) c = FuzzyFold(c);
+    return s;
+}
+
+static void RefWalk(const fs::path& dir, const NameMatcher<DirString::value_type>& matcher, const ParallelSearchOptions& opt, Ref& ref) {
+    ref.dirs++;
+    for (auto const& e : fs::directory_iterator(dir)) {
+        DirString name = e.path().filename().native();
+        if (name[0] == '.' && !opt.includeHidden) continue;
+        ref.entries++;
+        if (e.is_directory() && !e.is_symlink()) {
+            bool excluded = false;
+            for (auto const& n : opt.excludeNames) excluded |= Folded(n) == Folded(name);
+            for (auto const& p : opt.excludePaths) {
+                fs::path n = fs::path(p).lexically_normal();
+                excluded |= Folded((n.has_filename() ? n : n.parent_path()).native()) == Folded(e.path().native());
+            }
+            if (excluded) { ref.excluded++; continue; }
+            RefWalk(e.path(), matcher, opt, ref);
+            if (!opt.matchDirectories) continue;
+        }
+        int d = 0;
+        if (matcher.Matches(name, &d)) ref.hits[e.path().native()] = d;
+    }
+}
+
+struct Collected {
+    std::map<DirString, SearchHit> hits;
+    size_t batches = 0;
+    std::atomic<int> inside{ 0 };
+};
+
+static bool Search(const fs::path& root, const DirString& needle, const ParallelSearchOptions& opt, Collected& out,
+                   ParallelSearchStats& st, ParallelSearch* search = nullptr, const std::function<void()>& onFirst = nullptr) {
+    ParallelSearch local;
+    ParallelSearch& s = search ? *search : local;
+    return s.Run(root, needle, opt, [&](std::vector<SearchHit>&& batch) {
+        CHECK(out.inside.fetch_add(1) == 0);                 // never two receivers at once
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        if (out.batches++ == 0 && onFirst) onFirst();
+        for (auto& h : batch) CHECK(out.hits.emplace(h.path, h).second);
+        out.inside.fetch_sub(1);
+    }, &st);
+}
+
+static void Compare(const fs::path& root, const std::string& needle, const ParallelSearchOptions& opt) {
+    DirString n = fs::path(needle).native();
+    Ref ref;
+    RefWalk(root, NameMatcher<DirString::value_type>(n, opt.fuzzy, opt.matchCase, opt.maxDistance), opt, ref);
+    Collected got;
+    ParallelSearchStats st;
+    CHECK(Search(root, n, opt, got, st));
+    CHECK(got.hits.size() == ref.hits.size() && st.matches == ref.hits.size() && !st.capped && !st.cancelled);
+    CHECK(st.dirs == ref.dirs && st.entries == ref.entries && st.excluded == ref.excluded && st.dirErrors == 0);
+    for (auto const& [path, h] : got.hits) {
+        CHECK(ref.hits.count(path) && ref.hits[path] == h.distance);
+        fs::file_status s = fs::symlink_status(path);
+        CHECK(h.isDir == fs::is_directory(s));
+        if (fs::is_regular_file(s)) CHECK(h.size == fs::file_size(path) && h.mtime != 0);
+    }
+}
+
+int main() {
+    TestDir dir("parallel_search_test");
+    fs::path root = dir / "tree";
+    const char* words[] = { "Report", "invoice", "photo", "summary", "budget" };
+    int made = 0;
+    for (int a = 0; a < 6; ++a)
+        for (int b = 0; b < 6; ++b)
+            for (int f = 0; f < 15; ++f, ++made) {
+                std::string name = std::string(words[made % 5]) + "_" + std::to_string(made) + ".txt";
+                WriteFile(root / ("d" + std::to_string(a)) / ("sub" + std::to_string(b)) / name, std::string(made % 97, 'x'));
+            }
+    fs::create_directories(root / "d2" / "report_dir" / "empty");
+    WriteFile(root / "node_modules" / "pkg" / "report.js", "x");
+    WriteFile(root / ".git" / "objects" / "report", "x");
+    WriteFile(root / "d3" / "BUILD" / "report.o", "x");
+    WriteFile(root / "d1" / "skip" / "report_skipped.txt", "x");
+    WriteFile(root / ".cache" / "report_hidden.txt", "x");
+    WriteFile(root / "d4" / ".report_dotfile", "x");
+    fs::create_directory_symlink(root / "d0", root / "d5" / "report_link");     // a hit, never entered
+
+    ParallelSearchOptions opt;
+    opt.threads = 4;
+    opt.firstBatch = 8;
+    opt.batchSize = 50;
+    Compare(root, "report", opt);
+    Compare(root, "", opt);                                      // everything
+    opt.matchCase = true;
+    Compare(root, "Report", opt);
+    opt.matchCase = false;
+    opt.includeHidden = true;
+    opt.matchDirectories = false;
+    Compare(root, "REPORT", opt);
+    opt.matchDirectories = true;
+    opt.excludeNames = { fs::path("node_modules").native(), fs::path(".GIT").native(), fs::path("build").native() };
+    opt.excludePaths = { (root / "d1" / "skip" / "").native() };
+    Compare(root, "report", opt);
+    opt.fuzzy = true;
+    Compare(root, "repotr", opt);
+    Compare(root, "invioce_1", opt);
+    opt.fuzzy = false;
+
+    // maxResults: exactly that many, all real hits
+    {
+        Ref ref;
+        RefWalk(root, NameMatcher<DirString::value_type>(fs::path("report").native(), false, false, 0), opt, ref);
+        for (size_t cap : { (size_t)1, (size_t)10, (size_t)100 }) {
+            ParallelSearchOptions capped = opt;
+            capped.maxResults = cap;
+            Collected got;
+            ParallelSearchStats st;
+            CHECK(Search(root, fs::path("report").native(), capped, got, st));
+            CHECK(got.hits.size() == cap && st.matches == cap && st.capped && !st.cancelled);
+            for (auto const& h : got.hits) CHECK(ref.hits.count(h.first));
+        }
+    }
+    // Cancel() from the receiver: that batch was the last one
+    {
+        ParallelSearch search;
+        Collected got;
+        ParallelSearchStats st;
+        ParallelSearchOptions small = opt;
+        small.firstBatch = 1;
+        small.batchSize = 1;
+        CHECK(!Search(root, fs::path("").native(), small, got, st, &search, [&]() { search.Cancel(); }));
+        CHECK(got.batches == 1 && st.cancelled && search.Cancelled() && st.matches == got.hits.size());
+    }
+    // ... or before Run: nothing is walked or delivered
+    {
+        ParallelSearch search;
+        search.Cancel();
+        Collected got;
+        ParallelSearchStats st;
+        CHECK(!Search(root, fs::path("").native(), opt, got, st, &search));
+        CHECK(got.batches == 0 && st.dirs == 0 && st.cancelled);
+    }
+    // a missing root is a directory error, not a crash
+    {
+        Collected got;
+        ParallelSearchStats st;
+        CHECK(Search(root / "missing", fs::path("x").native(), opt, got, st) && got.hits.empty() && st.dirErrors == 1);
+    }
+    std::printf("OK\n");
+    return 0;
+}
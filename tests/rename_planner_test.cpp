@@ -0,0 +1,117 @@
+// RenamePlanner: ordering of swaps / rotations / chains, plan problems, rollback on a failure, and
+// journal replay after the executing process was killed (with a torn journal tail).
+#include "RenamePlanner.h"
+#include "TestUtil.h"
+
+#include <csignal>
+#include <sys/wait.h>
+
+namespace fs = std::filesystem;
+
+static void TestOrder(const TestDir& d, RenamePlanner& rp) {
+    for (const char* n : { "a", "b", "x", "y", "z", "c1", "c2", "p" }) WriteFile(d / n, std::string(n) + "!");
+    std::vector<RenameOp> req{ { d / "a", d / "b" }, { d / "b", d / "a" },                       // swap
+                               { d / "x", d / "y" }, { d / "y", d / "z" }, { d / "z", d / "x" }, // rotation
+                               { d / "c1", d / "c2" }, { d / "c2", d / "c3" },                   // chain
+                               { d / "p", d / "q" }, { d / "p2", d / "p2" } };                   // plain, no-op
+    RenamePlan plan = RenamePlanner::Plan(req);
+    CHECK(plan.problems.empty() && plan.ops.size() == 8 && plan.cycles == 2 && plan.units.size() == 4 && plan.steps.size() == 10);
+    RenameResult res = rp.Execute(plan);
+    CHECK(res.ok && res.done == 10);
+    CHECK(ReadFile(d / "a") == "b!" && ReadFile(d / "b") == "a!");
+    CHECK(ReadFile(d / "y") == "x!" && ReadFile(d / "z") == "y!" && ReadFile(d / "x") == "z!");
+    CHECK(ReadFile(d / "c2") == "c1!" && ReadFile(d / "c3") == "c2!" && !fs::exists(d / "c1"));
+    CHECK(ReadFile(d / "q") == "p!");
+    CHECK(fs::is_empty(d / ".journal"));
+
+    // undo = the inverse plan
+    std::vector<RenameOp> inv;
+    for (auto const& o : plan.ops) inv.push_back({ o.to, o.from });
+    res = rp.Execute(RenamePlanner::Plan(inv));
+    CHECK(res.ok);
+    CHECK(ReadFile(d / "a") == "a!" && ReadFile(d / "x") == "x!" && ReadFile(d / "c1") == "c1!" && ReadFile(d / "p") == "p!");
+    CHECK(!fs::exists(d / "c3") && !fs::exists(d / "q"));
+}
+
+static void TestProblems(const TestDir& d) {
+    WriteFile(d / "taken", "t");
+    WriteFile(d / "taken2", "t");
+    WriteFile(d / "dir" / "in", "i");
+    RenamePlan plan = RenamePlanner::Plan({ { d / "a", d / "taken" },                        // TargetExists
+                                            { d / "b", d / "n1" }, { d / "x", d / "n1" },    // DuplicateTarget
+                                            { d / "missing", d / "m" },                      // SourceMissing
+                                            { d / "y", d / "y1" }, { d / "y", d / "y2" },    // DuplicateSource
+                                            { d / "c1", d / "z" }, { d / "z", d / "taken2" }, // Blocked
+                                            { d / "dir", d / "dir2" }, { d / "dir" / "in", d / "dir" / "in2" }, // Nested
+                                            { d / "p", d / "bad/" } });                      // InvalidName
+    CHECK(plan.ops.size() == 1 && plan.ops[0].from == d / "dir");
+    auto has = [&](RenameIssue i) {
+        return std::any_of(plan.problems.begin(), plan.problems.end(), [&](const RenameProblem& p) { return p.issue == i; });
+    };
+    CHECK(has(RenameIssue::TargetExists) && has(RenameIssue::DuplicateTarget) && has(RenameIssue::SourceMissing));
+    CHECK(has(RenameIssue::DuplicateSource) && has(RenameIssue::Blocked) && has(RenameIssue::Nested) && has(RenameIssue::InvalidName));
+}
+
+// A file that appears at a target after planning is not replaced; the steps done so far are undone
+static void TestRollback(const TestDir& d, RenamePlanner& rp) {
+    RenamePlan plan = RenamePlanner::Plan({ { d / "a", d / "a2" }, { d / "b", d / "b2" }, { d / "c1", d / "c12" } });
+    WriteFile(d / "b2", "late");
+    RenameOptions one;
+    one.threads = 1;
+    RenameResult res = rp.Execute(plan, one);
+    CHECK(!res.ok && res.notUndone.empty() && res.failed.from == d / "b");
+    CHECK(ReadFile(d / "a") == "a!" && ReadFile(d / "b") == "b!" && ReadFile(d / "b2") == "late" && ReadFile(d / "c1") == "c1!");
+    CHECK(fs::is_empty(d / ".journal"));
+    fs::remove(d / "b2");
+}
+
+// The child executes one big rotation and is killed half way; Recover() in this process rolls the
+// batch back from the journal, also with garbage appended to it (a torn last record)
+static void TestKilledRecover(const TestDir& d) {
+    fs::path big = d / "big", journal = d / "killed-journal";
+    const int n = 20000;
+    for (int i = 0; i < n; ++i) WriteFile(big / ("f" + std::to_string(i)), std::to_string(i));
+    std::vector<RenameOp> rq;
+    for (int i = 0; i < n; ++i) rq.push_back({ big / ("f" + std::to_string(i)), big / ("f" + std::to_string((i + 1) % n)) });
+    RenamePlan plan = RenamePlanner::Plan(rq);
+    CHECK(plan.units.size() == 1 && plan.steps.size() == (size_t)n + 1);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        RenamePlanner child;
+        child.SetJournalDir(journal);
+        child.Execute(plan);
+        _exit(0);
+    }
+    fs::path middle = big / ("f" + std::to_string(n / 2));
+    while (ReadFile(middle) == std::to_string(n / 2)) usleep(200);
+    kill(pid, SIGKILL);
+    int status;
+    waitpid(pid, &status, 0);
+
+    std::vector<fs::path> journals;
+    for (auto const& e : fs::directory_iterator(journal)) journals.push_back(e.path());
+    CHECK(journals.size() == 1);
+    std::ofstream(journals[0], std::ios::binary | std::ios::app) << "torn";
+
+    RenamePlanner rec;
+    rec.SetJournalDir(journal);
+    std::vector<RenameStep> notUndone;
+    CHECK(rec.Recover(&notUndone) == 1 && notUndone.empty());
+    for (int i = 0; i < n; ++i) CHECK(ReadFile(big / ("f" + std::to_string(i))) == std::to_string(i));
+    CHECK((size_t)std::distance(fs::directory_iterator(big), fs::directory_iterator()) == (size_t)n);
+    CHECK(fs::is_empty(journal));
+    CHECK(rec.Recover() == 0);
+}
+
+int main() {
+    TestDir d("rename_planner_test");
+    TestKilledRecover(d);     // first: fork() before any worker thread exists
+    RenamePlanner rp;
+    rp.SetJournalDir(d / ".journal");
+    TestOrder(d, rp);
+    TestProblems(d);
+    TestRollback(d, rp);
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,186 @@
+// SearchSession: debouncing, stale runs, Full / RefineSource / RefineShown / Unchanged planning,
+// history only from Commit(), Narrows() per mode, and SliceFilter; ends with typing a 10-character
+// query over 500000 names where only the source listing is ever scanned in full.
+#include "SearchSession.h"
+#include "TestUtil.h"
+
+using namespace std::chrono_literals;
+using Clock = SearchSession::Clock;
+
+static SearchRequest Req(std::wstring text, std::wstring scope = L"C:\\data") {
+    SearchRequest r;
+    r.text = std::move(text);
+    r.scope = std::move(scope);
+    r.recursive = true;
+    return r;
+}
+
+static void TestDebounce() {
+    SearchSession s(150ms);
+    auto t = Clock::now();
+    std::wstring typed = L"quarterly";
+    int tickets = 0;
+    for (size_t i = 1; i <= typed.size(); ++i) {
+        auto due = s.Input(Req(typed.substr(0, i)), t);
+        CHECK(due == t + 150ms && s.Pending());
+        t += 40ms;                                     // faster than the debounce
+        if (s.Take(t)) ++tickets;
+    }
+    CHECK(tickets == 0);
+    auto ticket = s.Take(s.DueAt());
+    CHECK(ticket && ticket->request.text == typed && ticket->kind == SearchKind::Full && !s.Pending());
+    CHECK(s.Current(ticket->id));
+    CHECK(!s.Take(s.DueAt() + 1s));                    // handed out once
+
+    // force (e.g. focus lost) does not wait
+    s.Input(Req(L"x"), t);
+    CHECK(s.Take(t, true));
+}
+
+static void TestStale() {
+    SearchSession s(100ms);
+    auto t = Clock::now();
+    SearchTicket first = s.Run(Req(L"ab"));
+    s.Input(Req(L"abc"), t);
+    CHECK(!s.Current(first.id));                       // its batches are dropped
+    s.Completed(first.id, true);                       // ignored: nothing is shown for "ab"
+    auto next = s.Take(t + 100ms);
+    CHECK(next && next->kind == SearchKind::Full && next->id != first.id && s.Current(next->id));
+
+    // Run drops pending input
+    s.Input(Req(L"abcd"), t);
+    SearchTicket run = s.Run(Req(L"zz"));
+    CHECK(!s.Pending() && s.Current(run.id));
+}
+
+static void TestPlanning() {
+    SearchSession s;
+    s.SetSource(Req(L""));                             // finished listing of the folder
+    SearchTicket t = s.Run(Req(L"re"));
+    CHECK(t.kind == SearchKind::RefineSource);
+    s.Completed(t.id, true);
+    t = s.Run(Req(L"rep"));
+    CHECK(t.kind == SearchKind::RefineShown);
+    s.Completed(t.id, true);
+    t = s.Run(Req(L"re"));                             // backspace: wider than shown, narrower than source
+    CHECK(t.kind == SearchKind::RefineSource);
+    s.Completed(t.id, true);
+    t = s.Run(Req(L"re"));
+    CHECK(t.kind == SearchKind::Unchanged);
+
+    // capped results cannot be narrowed, the source still can
+    t = s.Run(Req(L"r"));
+    s.Completed(t.id, false);
+    t = s.Run(Req(L"re"));
+    CHECK(t.kind == SearchKind::RefineSource);
+    s.Completed(t.id, true);
+
+    // other folder: from scratch; its complete result becomes the new source
+    t = s.Run(Req(L"re", L"D:\\"));
+    CHECK(t.kind == SearchKind::Full);
+    s.Completed(t.id, true);
+    t = s.Run(Req(L"rep", L"D:\\"));
+    CHECK(t.kind == SearchKind::RefineShown);
+    s.Completed(t.id, true);
+    t = s.Run(Req(L"re", L"D:\\"));
+    CHECK(t.kind == SearchKind::RefineSource);
+
+    s.Invalidate();                                    // files changed underneath
+    t = s.Run(Req(L"rep", L"D:\\"));
+    CHECK(t.kind == SearchKind::Full);
+}
+
+static void TestHistory() {
+    SearchSession s(0ms, 3);
+    auto t = Clock::now();
+    for (const wchar_t* q : { L"a", L"ab", L"abc" }) { s.Input(Req(q), t); s.Take(t); }
+    CHECK(s.History().empty());                        // typing records nothing
+    for (const wchar_t* q : { L"one", L"two", L"", L"three", L"one", L"four" }) s.Commit(Req(q));
+    CHECK((s.History() == std::vector<std::wstring>{ L"four", L"one", L"three" }));
+}
+
+static void TestNarrows() {
+    SearchRequest a = Req(L"Doc"), b = Req(L"Docs");
+    CHECK(SearchSession::Narrows(a, b) && !SearchSession::Narrows(b, a));
+    b.text = L"docs";
+    CHECK(!SearchSession::Narrows(a, b));              // case-sensitive: "docs" does not contain "Doc"
+    a.matchCase = b.matchCase = false;
+    CHECK(SearchSession::Narrows(a, b));
+    b.recursive = false;
+    CHECK(!SearchSession::Narrows(a, b));
+    b = a;
+    b.text = L"Doc2";
+    b.content = true;
+    CHECK(!SearchSession::Narrows(a, b));
+    CHECK(!SearchSession::Narrows(Req(L"", L"C:\\data"), Req(L"x", L"C:\\other")));
+
+    // fuzzy: a longer needle may allow more edits, then it is not a narrowing
+    SearchRequest f = Req(L"ab"), g = Req(L"abc");
+    f.fuzzy = g.fuzzy = true;
+    f.maxDistance = g.maxDistance = 2;
+    CHECK(!SearchSession::Narrows(f, g));              // distance 0 -> 1
+    f.text = L"abc";
+    g.text = L"abcd";
+    CHECK(SearchSession::Narrows(f, g));               // 1 -> 1
+    g.fuzzy = false;
+    CHECK(!SearchSession::Narrows(f, g));
+}
+
+static void TestSliceFilter() {
+    std::vector<uint32_t> in(100000);
+    for (uint32_t i = 0; i < in.size(); ++i) in[i] = (uint32_t)in.size() - i;
+    SliceFilter f;
+    f.Start(in);
+    size_t steps = 0, looked = 0;
+    auto keep = [&](uint32_t p) { ++looked; return p % 7 == 0; };
+    while (!f.Step(4096, keep)) CHECK(looked == ++steps * 4096);
+    std::vector<uint32_t> out = f.Take(), expect;
+    for (uint32_t p : in) if (p % 7 == 0) expect.push_back(p);
+    CHECK(out == expect && looked == in.size() && f.Done());
+    f.Start({});
+    CHECK(f.Step(10, keep) && f.Take().empty());
+}
+
+// Every keystroke after the first filters the shown positions, a slice at a time
+static void TestTyping() {
+    std::vector<std::wstring> names(500000);
+    for (size_t i = 0; i < names.size(); ++i) names[i] = L"report_" + std::to_wstring(i % 9973) + L"_" + std::to_wstring(i) + L".txt";
+    SearchSession s(100ms);
+    s.SetSource(Req(L""));
+    std::vector<uint32_t> all(names.size()), shown;
+    for (uint32_t i = 0; i < all.size(); ++i) all[i] = i;
+
+    auto t = Clock::now();
+    std::wstring query = L"report_123";
+    size_t fullScans = 0;
+    for (size_t i = 1; i <= query.size(); ++i) {
+        s.Input(Req(query.substr(0, i)), t);
+        t += 150ms;                                    // a slow typist: every prefix runs
+        auto ticket = s.Take(t);
+        CHECK(ticket && ticket->kind != SearchKind::Full);
+        if (ticket->kind == SearchKind::Unchanged) continue;
+        fullScans += ticket->kind == SearchKind::RefineSource;
+        SliceFilter f;
+        f.Start(ticket->kind == SearchKind::RefineShown ? shown : all);
+        auto keep = [&](uint32_t p) { return names[p].find(ticket->request.text) != std::wstring::npos; };
+        while (!f.Step(8192, keep)) CHECK(s.Current(ticket->id));
+        shown = f.Take();
+        s.Completed(ticket->id, true);
+    }
+    size_t expect = 0;
+    for (auto const& n : names) expect += n.find(query) != std::wstring::npos;
+    CHECK(shown.size() == expect && expect > 0);
+    CHECK(fullScans == 1);
+}
+
+int main() {
+    TestDebounce();
+    TestStale();
+    TestPlanning();
+    TestHistory();
+    TestNarrows();
+    TestSliceFilter();
+    TestTyping();
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,225 @@
+// SortKeyTable: the collation order of names (natural numbers, case folded, leading zeros, digits
+// between punctuation and letters) on a fixed list; Sort() against std::stable_sort with a direct
+// comparator (no keys) for every combination of up to three keys, both directions and folders
+// first, on lists with many ties (so that Refine goes deep) and names outside the BMP, serially
+// and on a WorkPool (past kParallelMin); Insert() of batches gives the same order as sorting
+// everything, and the same input always gives the same output.
+#include "SortKeys.h"
+#include "TestUtil.h"
+
+struct Item { std::wstring name; bool folder; uint64_t size, mtime; };
+
+// natural comparison without keys: digit runs by value (length without leading zeros, then
+// digits) and sorted as if they were '0' against other characters, the rest case folded
+static int NaturalCompare(const std::wstring& a, const std::wstring& b) {
+    auto digit = [](wchar_t c) { return c >= L'0' && c <= L'9'; };
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (digit(a[i]) && digit(b[j])) {
+            size_t ei = i, ej = j;
+            while (ei < a.size() && digit(a[ei])) ++ei;
+            while (ej < b.size() && digit(b[ej])) ++ej;
+            while (i + 1 < ei && a[i] == L'0') ++i;
+            while (j + 1 < ej && b[j] == L'0') ++j;
+            if (ei - i != ej - j) return ei - i < ej - j ? -1 : 1;
+            int c = a.compare(i, ei - i, b, j, ej - j);
+            if (c) return c < 0 ? -1 : 1;
+            i = ei;
+            j = ej;
+            continue;
+        }
+        // UTF-16 code units, as on Windows
+        auto unit = [&](const std::wstring& s, size_t k) -> std::pair<uint32_t, uint32_t> {
+            uint32_t c = digit(s[k]) ? L'0' : (uint32_t)FuzzyFold(s[k]);
+            if (c < 0x10000) return { c, 0 };
+            return { 0xD800 + ((c - 0x10000) >> 10), 0xDC00 + ((c - 0x10000) & 0x3FF) };
+        };
+        auto x = unit(a, i), y = unit(b, j);
+        if (x.first != y.first) return x.first < y.first ? -1 : 1;
+        if (x.second != y.second) return x.second < y.second ? -1 : 1;
+        ++i;
+        ++j;
+    }
+    return (i < a.size()) - (j < b.size());
+}
+
+static std::wstring Extension(const std::wstring& name) {
+    size_t dot = name.find_last_of(L'.');
+    std::wstring ext;
+    if (dot != std::wstring::npos && dot > 0)
+        for (wchar_t c : name.substr(dot + 1)) ext.push_back(FuzzyFold(c));
+    return ext;
+}
+
+static bool RefLess(const std::vector<Item>& items, uint32_t a, uint32_t b, const SortSpec& spec) {
+    const Item& x = items[a];
+    const Item& y = items[b];
+    if (spec.foldersFirst && x.folder != y.folder) return x.folder;
+    for (auto const& k : spec.keys) {
+        int c = 0;
+        switch (k.field) {
+        case SortField::Name: c = NaturalCompare(x.name, y.name); break;
+        case SortField::Type: { auto ex = Extension(x.name), ey = Extension(y.name); c = ex < ey ? -1 : ex > ey; break; }
+        case SortField::Size: c = x.size < y.size ? -1 : x.size > y.size; break;
+        case SortField::Date: c = x.mtime < y.mtime ? -1 : x.mtime > y.mtime; break;
+        }
+        if (c) return k.ascending ? c < 0 : c > 0;
+    }
+    return false;                             // stable_sort keeps the input order
+}
+
+static void TestCollation() {
+    // ascending by name; equal keys keep their input order
+    const wchar_t* order[] = { L"", L" x", L"-1", L".hidden", L"0", L"000", L"1", L"01", L"2", L"9", L"10", L"010", L"99", L"100",
+                               L"12345678901234567890", L"_", L"a", L"A", L"a 7", L"a 07x", L"a0", L"a00x", L"a1", L"a1.2.9",
+                               L"a1.2.10", L"a1b", L"a2", L"A10", L"a10b", L"abc", L"ABD", L"file-1", L"file.1", L"file1",
+                               L"File2", L"file10", L"file_1", L"fileA", L"img9.png", L"IMG10.png", L"img010.png", L"z" };
+    SortKeyTable t;
+    std::vector<uint32_t> view;
+    const size_t n = sizeof(order) / sizeof(*order);
+    for (size_t i = 0; i < n; ++i) {                                 // added in reverse, so the order is not the input's
+        t.Add(order[n - 1 - i], false, 0, 0);
+        view.push_back((uint32_t)i);
+    }
+    SortSpec spec{ { { SortField::Name, true } }, false };
+    t.Sort(view, spec);
+    // equal names ("0" / "000", "1" / "01", "10" / "010", "a" / "A", "IMG10" / "img010") come out in
+    // the order they were added, which is reversed here
+    std::vector<std::wstring> got;
+    for (uint32_t p : view) got.push_back(order[n - 1 - p]);
+    const wchar_t* want[] = { L"", L" x", L"-1", L".hidden", L"000", L"0", L"01", L"1", L"2", L"9", L"010", L"10", L"99", L"100",
+                              L"12345678901234567890", L"_", L"A", L"a", L"a 7", L"a 07x", L"a0", L"a00x", L"a1", L"a1.2.9",
+                              L"a1.2.10", L"a1b", L"a2", L"A10", L"a10b", L"abc", L"ABD", L"file-1", L"file.1", L"file1",
+                              L"File2", L"file10", L"file_1", L"fileA", L"img9.png", L"img010.png", L"IMG10.png", L"z" };
+    CHECK(got.size() == sizeof(want) / sizeof(*want));
+    for (size_t i = 0; i < got.size(); ++i) CHECK(got[i] == want[i]);
+    CHECK(t.IsSorted(view, spec));
+
+    // type, then name: extensions alphabetically (folded), no extension first, a leading dot is no extension
+    SortKeyTable types;
+    const wchar_t* names[] = { L"b.TXT", L"a.txt", L"c", L".profile", L"x.png", L"a.PNG", L"z.tar.gz", L"archive.zip" };
+    std::vector<uint32_t> all;
+    for (uint32_t i = 0; i < 8; ++i) { types.Add(names[i], false, 0, 0); all.push_back(i); }
+    types.Sort(all, SortSpec{ { { SortField::Type, true }, { SortField::Name, true } }, false });
+    const wchar_t* byType[] = { L".profile", L"c", L"z.tar.gz", L"a.PNG", L"x.png", L"a.txt", L"b.TXT", L"archive.zip" };
+    for (size_t i = 0; i < all.size(); ++i) CHECK(names[all[i]] == std::wstring(byType[i]));
+}
+
+static std::vector<Item> RandomItems(std::mt19937& g, size_t n) {
+    static const wchar_t alphabet[] = { L'a', L'b', L'A', L'B', L'0', L'0', L'1', L'2', L'9', L'.', L'-', L'_', L' ', 0xE4, 0xC4,
+                                        0xE9, 0x4E00, 0xFFFF, (wchar_t)0x1F600, (wchar_t)0x1F601 };
+    const wchar_t* exts[] = { L".txt", L".TXT", L".png", L"", L".tar.gz", L".Png" };
+    std::vector<std::wstring> stems;                                  // a few stems, so that many names share long prefixes
+    for (int i = 0; i < 40; ++i) {
+        std::wstring s;
+        for (int k = 0, len = (int)(g() % 14); k < len; ++k) s += alphabet[g() % (sizeof(alphabet) / sizeof(*alphabet))];
+        stems.push_back(s);
+    }
+    std::vector<Item> items(n);
+    for (auto& it : items) {
+        it.name = stems[g() % stems.size()];
+        if (g() % 2) it.name += stems[g() % stems.size()];
+        if (g() % 3) it.name += std::to_wstring(g() % 30);
+        it.name += exts[g() % 6];
+        it.folder = g() % 5 == 0;
+        it.size = g() % 4 ? g() % 50 : 1ull << 40 | g() % 3;
+        it.mtime = 1000 + g() % 20;
+    }
+    return items;
+}
+
+static std::vector<SortSpec> Specs() {
+    std::vector<SortSpec> specs;
+    const SortField fields[] = { SortField::Name, SortField::Type, SortField::Size, SortField::Date };
+    std::vector<std::vector<SortField>> lists = { {} };
+    for (SortField a : fields) {
+        lists.push_back({ a });
+        for (SortField b : fields) {
+            if (b == a) continue;
+            lists.push_back({ a, b });
+            for (SortField c : fields) if (c != a && c != b) lists.push_back({ a, b, c });
+        }
+    }
+    for (auto const& l : lists)
+        for (int dirs = 0; dirs < (1 << l.size()); ++dirs)
+            for (bool ff : { false, true }) {
+                SortSpec s;
+                s.foldersFirst = ff;
+                for (size_t k = 0; k < l.size(); ++k) s.keys.push_back(SortOrder{ l[k], ((dirs >> k) & 1) == 0 });
+                specs.push_back(s);
+            }
+    return specs;
+}
+
+static void Compare(const std::vector<Item>& items, SortKeyTable& t, const SortSpec& spec, WorkPool* pool) {
+    std::vector<uint32_t> want(items.size());
+    for (uint32_t i = 0; i < want.size(); ++i) want[i] = i;
+    std::stable_sort(want.begin(), want.end(), [&](uint32_t a, uint32_t b) { return RefLess(items, a, b, spec); });
+    // from a shuffled view: the position, not the view order, breaks ties
+    std::vector<uint32_t> view(items.size());
+    for (uint32_t i = 0; i < view.size(); ++i) view[i] = i;
+    std::shuffle(view.begin(), view.end(), std::mt19937((unsigned)items.size()));
+    t.Sort(view, spec, pool);
+    CHECK(view == want && t.IsSorted(view, spec));
+}
+
+static void TestRandom() {
+    std::mt19937 g(47);
+    std::vector<Item> items = RandomItems(g, 3000);
+    SortKeyTable t;
+    for (auto const& it : items) t.Add(it.name, it.folder, it.size, it.mtime);
+    CHECK(t.Size() == items.size());
+    auto specs = Specs();
+    for (auto const& spec : specs) Compare(items, t, spec, nullptr);
+
+    // past kParallelMin: chunks, merges and refinement on the pool
+    std::vector<Item> large = RandomItems(g, SortKeyTable::kParallelMin * 2 + 123);
+    SortKeyTable big;
+    for (auto const& it : large) big.Add(it.name, it.folder, it.size, it.mtime);
+    WorkPool pool(3);
+    for (size_t i = 0; i < specs.size(); i += 83) Compare(large, big, specs[i], &pool);
+    Compare(large, big, SortSpec{ { { SortField::Name, true } }, false }, &pool);
+    Compare(large, big, SortSpec{ { { SortField::Type, false }, { SortField::Name, false } }, true }, &pool);
+}
+
+static void TestInsert() {
+    std::mt19937 g(48);
+    std::vector<Item> items = RandomItems(g, 5000);
+    SortKeyTable t;
+    for (auto const& spec : { SortSpec{ { { SortField::Name, true } }, true }, SortSpec{ { { SortField::Size, false }, { SortField::Name, true } }, false },
+                              SortSpec{ { { SortField::Type, true } }, false } }) {
+        t.Clear();
+        std::vector<uint32_t> view, all;
+        size_t added = 0;
+        while (added < items.size()) {
+            // a batch of new items, as an enumeration delivers them
+            std::vector<uint32_t> fresh;
+            for (size_t k = 0, n = 1 + g() % 700; k < n && added < items.size(); ++k, ++added) {
+                t.Add(items[added].name, items[added].folder, items[added].size, items[added].mtime);
+                fresh.push_back((uint32_t)added);
+                all.push_back((uint32_t)added);
+            }
+            t.Insert(view, fresh, spec);
+            std::vector<uint32_t> sorted = all;
+            t.Sort(sorted, spec);
+            CHECK(view == sorted);
+        }
+        // a batch that sorts after everything is appended as it is
+        std::vector<uint32_t> before = view;
+        t.Add(std::wstring(40, 0xFFFF), false, 0, 0);
+        if (spec.keys[0].field == SortField::Name) {
+            t.Insert(view, { (uint32_t)items.size() }, spec);
+            before.push_back((uint32_t)items.size());
+            CHECK(view == before);
+        }
+        t.Insert(view, {}, spec);
+    }
+}
+
+int main() {
+    TestCollation();
+    TestRandom();
+    TestInsert();
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,261 @@
+// TagExtractor against counts kept while generating the text: random documents of ASCII and
+// non-ASCII words (mixed case, Greek, Cyrillic, Latin Extended-A, CJK), stopwords in four languages,
+// digit-only, short and over-long tokens, ASCII and Unicode separators; fed whole, in random pieces
+// and in pieces shorter than one SSE2 block (scalar path only). Misra-Gries keeps frequent terms
+// within its error bound, idf re-ranks only with enough documents, and File() gives the same tags
+// for UTF-8 (with or without BOM) and UTF-16 LE / BE files, also with a multi-byte character or a
+// surrogate pair across the chunk boundary (unpaired surrogates separate); binary, filtered and
+// missing files give none.
+#include "TagExtractor.h"
+#include "TestUtil.h"
+
+#include <map>
+
+namespace fs = std::filesystem;
+
+using Counts = std::map<std::string, uint32_t>;
+
+// surface form -> tag (empty: dropped)
+struct Word { std::string surface, tag; };
+
+static bool Counted(const std::string& tag) {
+    size_t chars = 0;
+    bool letter = false;
+    for (unsigned char c : tag) {
+        chars += (c & 0xC0) != 0x80;
+        letter |= !(c >= '0' && c <= '9');
+    }
+    return letter && chars >= 3 && tag.size() <= TagExtractor::kMaxTermBytes && !TagExtractor::Stopword(tag);
+}
+
+static std::vector<Word> Vocabulary() {
+    std::vector<Word> v;
+    for (const char* w : { "invoice", "budget", "report", "kernel", "thread", "mutex", "vector", "buffer", "schema",
+                           "abc123", "x86", "utf8", "ab", "zz", "2024", "1234567", "the", "und", "pour", "para", "however",
+                           "dass", "daß", "über", "für", "même", "también" }) v.push_back({ w, w });
+    for (const char* w : { "naïve", "straße", "größe", "东京都", "日本", "ärger", "москва", "ёлка", "αθηνα", "łódź" }) v.push_back({ w, w });
+    v.push_back({ "ÄRGER", "ärger" });
+    v.push_back({ "Ärger", "ärger" });
+    v.push_back({ "GRÖSSE", "grösse" });
+    v.push_back({ "МОСКВА", "москва" });
+    v.push_back({ "Ёлка", "ёлка" });
+    v.push_back({ "ΑΘΗΝΑ", "αθηνα" });
+    v.push_back({ "ŁÓDŹ", "łódź" });
+    v.push_back({ "THE", "the" });
+    v.push_back({ "Über", "über" });
+    v.push_back({ std::string(32, 'q'), std::string(32, 'q') });   // longest kept
+    v.push_back({ std::string(33, 'q'), std::string(33, 'q') });
+    v.push_back({ std::string(40, 'k') + "1", std::string(40, 'k') + "1" });
+    std::string a16;
+    for (int i = 0; i < 16; ++i) a16 += "ä";
+    v.push_back({ a16, a16 });                                      // 32 bytes
+    v.push_back({ a16 + "ä", a16 + "ä" });                          // 34: too long
+    // more distinct terms, so that the table holds a few hundred
+    std::mt19937 g(45);
+    for (int i = 0; i < 400; ++i) {
+        std::string w;
+        for (int k = 0, n = 3 + g() % 12; k < n; ++k) w += (char)('a' + g() % 26);
+        v.push_back({ w, w });
+    }
+    for (auto& w : v)
+        if (!Counted(w.tag)) w.tag.clear();
+    return v;
+}
+
+static std::string Random(std::mt19937& g, const std::vector<Word>& vocab, size_t words, Counts& want, uint64_t& tokens) {
+    static const char* seps[] = { " ", "  ", ", ", ".\n", "\t", "-", "_", "(", ")", "/", "'", "\"", "\r\n", ": ",
+                                  "—", " ", "«", "»", "😀", "、", "…", "×" };
+    std::string s;
+    for (size_t i = 0; i < words; ++i) {
+        const Word& w = vocab[std::min<size_t>(g() % vocab.size(), g() % vocab.size())];   // early words more often
+        std::string surface = w.surface;
+        if (g() % 4 == 0)
+            for (auto& c : surface) if (c >= 'a' && c <= 'z' && g() % 2) c = (char)(c - 32);
+        if (i) s += seps[g() % (sizeof(seps) / sizeof(*seps))];
+        s += surface;
+        ++tokens;
+        if (!w.tag.empty()) ++want[w.tag];
+    }
+    return s;
+}
+
+static Counts Got(const std::vector<TagTerm>& tags) {
+    Counts c;
+    for (auto const& t : tags) CHECK(c.emplace(t.text, t.count).second);
+    return c;
+}
+
+// ranking without a corpus: count, then longer, then alphabetical
+static void CheckOrder(const std::vector<TagTerm>& tags) {
+    for (size_t i = 1; i < tags.size(); ++i) {
+        auto const& a = tags[i - 1];
+        auto const& b = tags[i];
+        CHECK(a.count > b.count || (a.count == b.count && (a.text.size() > b.text.size() || (a.text.size() == b.text.size() && a.text < b.text))));
+    }
+}
+
+static void TestRandom() {
+    std::vector<Word> vocab = Vocabulary();
+    std::mt19937 g(46);
+    TagExtractor x;
+    for (int round = 0; round < 150; ++round) {
+        Counts want;
+        uint64_t tokens = 0;
+        std::string text = Random(g, vocab, g() % 3000, want, tokens);
+        auto tags = x.Text(text, 100000);
+        CHECK(Got(tags) == want && x.Tokens() == tokens);
+        CheckOrder(tags);
+        // the same text in random pieces (split inside words and UTF-8 sequences)
+        x.Begin();
+        for (size_t i = 0; i < text.size();) {
+            size_t n = std::min<size_t>(text.size() - i, g() % (round % 2 ? 12 : 200));
+            x.Feed(text.data() + i, n);
+            i += n;
+        }
+        CHECK(Got(x.Finish(100000)) == want && x.Tokens() == tokens);
+        // top-N is the head of the full ranking
+        auto top = x.Text(text, 5);
+        CHECK(top.size() == std::min<size_t>(5, tags.size()));
+        for (size_t i = 0; i < top.size(); ++i) CHECK(top[i].text == tags[i].text && top[i].count == tags[i].count);
+    }
+}
+
+static void TestUnicode() {
+    TagExtractor x;
+    Counts want = { { "ärger", 3 }, { "αθηνα", 2 }, { "москва", 2 }, { "ёлка", 2 }, { "łódź", 3 }, { "straße", 1 }, { "東京都", 1 } };
+    CHECK(Got(x.Text("ÄRGER Ärger ärger ΑΘΗΝΑ αθηνα МОСКВА Москва ЁЛКА ёлка ŁÓDŹ Łódź łódź straße 東京都", 100)) == want);
+    want = { { "alpha", 1 }, { "beta", 1 }, { "gamma", 1 }, { "delta", 1 }, { "epsilon", 1 }, { "zeta", 1 }, { "eta", 1 } };
+    CHECK(Got(x.Text("alpha—beta gamma delta «epsilon» zeta😀eta", 100)) == want && x.Tokens() == 7);
+    want = { { "abcd", 1 }, { "xyz1", 1 } };
+    CHECK(Got(x.Text("abcd\xC3xyz1 \xFF", 100)) == want);              // broken UTF-8 separates
+    CHECK(x.Text("the und pour para über ab 12345 äö", 100).empty() && x.Tokens() == 8);
+    CHECK(TagExtractor::Stopword("daß") && TagExtractor::Stopword("für") && !TagExtractor::Stopword("invoice"));
+}
+
+static void TestMisraGries() {
+    // three frequent terms between 20000 that occur once, more than the table holds; bravo and
+    // charlie first appear when it is long full
+    std::string text;
+    uint32_t n = 0;
+    for (int i = 0; i < 20000; ++i) {
+        text += "w" + std::to_string(100000 + i) + " ";
+        if (i % 2 == 0) text += "alpha ";
+        if (i >= 12000) text += "bravo ";
+        if (i >= 14000) text += "charlie ";
+    }
+    Counts truth;
+    for (size_t i = 0, j; i < text.size(); i = j + 1) {
+        j = text.find(' ', i);
+        ++truth[text.substr(i, j - i)];
+        ++n;
+    }
+    TagExtractor x;
+    auto tags = x.Text(text, 3);
+    CHECK(tags.size() == 3 && tags[0].text == "alpha" && tags[1].text == "bravo" && tags[2].text == "charlie");
+    for (auto const& t : tags) CHECK(t.count <= truth[t.text] && truth[t.text] - t.count <= n / (TagExtractor::kMaxTerms + 1));
+    // and the table starts empty for the next text
+    CHECK(Got(x.Text("delta delta", 10)) == Counts({ { "delta", 2 } }));
+}
+
+static void TestIdf() {
+    TagExtractor x;
+    std::string text = "apple apple apple apple banana banana";
+    std::vector<std::string> asked;
+    uint64_t docs = 1000;
+    TagCorpusFn corpus = [&](const std::vector<std::string_view>& terms, uint32_t* df) {
+        for (size_t i = 0; i < terms.size(); ++i) {
+            asked.emplace_back(terms[i]);
+            df[i] = terms[i] == "apple" ? 900 : 3;
+        }
+        return docs;
+    };
+    auto tags = x.Text(text, 10, corpus);
+    CHECK(asked.size() == 2 && tags.size() == 2 && tags[0].text == "banana" && tags[1].text == "apple");
+    float apple = (1.0f + std::log(4.0f)) * (float)std::log(1.0 + (1000 - 900 + 0.5) / 900.5);
+    CHECK(std::fabs(tags[1].score - apple) < 1e-5f && tags[1].count == 4);
+    docs = 10;                                                        // below minCorpusDocs: tf only
+    tags = x.Text(text, 10, corpus);
+    CHECK(tags[0].text == "apple" && std::fabs(tags[0].score - (1.0f + std::log(4.0f))) < 1e-6f);
+}
+
+static std::u16string Utf16(const std::string& s) {
+    std::u16string out;
+    for (size_t i = 0; i < s.size();) {
+        unsigned char c = (unsigned char)s[i];
+        int n = c < 0x80 ? 0 : c < 0xE0 ? 1 : c < 0xF0 ? 2 : 3;
+        uint32_t u = n ? c & (0x3F >> n) : c;
+        for (int k = 1; k <= n; ++k) u = u << 6 | (s[i + k] & 0x3F);
+        i += n + 1;
+        if (u >= 0x10000) { out += (char16_t)(0xD800 + ((u - 0x10000) >> 10)); out += (char16_t)(0xDC00 + ((u - 0x10000) & 0x3FF)); }
+        else out += (char16_t)u;
+    }
+    return out;
+}
+
+static std::string Bytes(const std::u16string& u, bool bigEndian) {
+    std::string s = bigEndian ? "\xFE\xFF" : "\xFF\xFE";
+    for (char16_t c : u) {
+        char lo = (char)(c & 0xFF), hi = (char)(c >> 8);
+        s += bigEndian ? hi : lo;
+        s += bigEndian ? lo : hi;
+    }
+    return s;
+}
+
+static void TestFiles() {
+    TestDir dir("tag_extractor_test");
+    std::vector<Word> vocab = Vocabulary();
+    std::mt19937 g(47);
+    Counts want;
+    uint64_t tokens = 0;
+    std::string text = Random(g, vocab, 40000, want, tokens);          // several chunks, UTF-16 below maxBytes
+    TagExtractor x;
+    auto same = [&](const fs::path& p) { return Got(x.File(p, 100000)) == want; };
+    WriteFile(dir / "plain.txt", text);
+    WriteFile(dir / "bom.md", "\xEF\xBB\xBF" + text);
+    WriteFile(dir / "le.txt", Bytes(Utf16(text), false));
+    WriteFile(dir / "be.txt", Bytes(Utf16(text), true));
+    CHECK(fs::file_size(dir / "le.txt") < TagOptions().maxBytes);
+    CHECK(same(dir / "plain.txt") && x.Tokens() == tokens && same(dir / "bom.md") && same(dir / "le.txt") && same(dir / "be.txt"));
+
+    // a chunk ends inside "ä" (UTF-8) or between the halves of 😀 (UTF-16, after the 2-byte BOM)
+    std::string filler(TagExtractor::kChunk - 6, ' ');
+    want = { { "zeta", 1 }, { "ärger", 1 } };
+    WriteFile(dir / "split8.txt", filler + "zeta ärger");
+    CHECK(Got(x.File(dir / "split8.txt", 10)) == want);
+    filler.assign(TagExtractor::kChunk / 2 - 6, ' ');
+    for (bool be : { false, true }) {
+        WriteFile(dir / "split16.txt", Bytes(Utf16(filler + "zeta😀eta"), be));
+        CHECK(Got(x.File(dir / "split16.txt", 10)) == Counts({ { "zeta", 1 }, { "eta", 1 } }));
+        WriteFile(dir / "split16.txt", Bytes(Utf16(filler + "zeta𠀀eta"), be));       // a letter outside the BMP
+        CHECK(Got(x.File(dir / "split16.txt", 10)) == Counts({ { "zeta𠀀eta", 1 } }));
+        // unpaired surrogates separate
+        WriteFile(dir / "lone16.txt", Bytes(u"foo" + std::u16string(1, 0xD800) + u"bar baz" + std::u16string(1, 0xDC00) + u"qux", be));
+        CHECK(Got(x.File(dir / "lone16.txt", 10)) == Counts({ { "foo", 1 }, { "bar", 1 }, { "baz", 1 }, { "qux", 1 } }));
+    }
+
+    // only the first maxBytes are read
+    TagOptions opt;
+    opt.maxBytes = 96000;                                             // a word boundary
+    TagExtractor capped(opt);
+    std::string head;
+    while (head.size() < 96000) head += "alpha ";
+    WriteFile(dir / "long.txt", head + std::string(1000, ' ') + "omega");
+    CHECK(Got(capped.File(dir / "long.txt", 10)) == Counts({ { "alpha", 16000 } }));
+
+    WriteFile(dir / "binary.txt", std::string("invoice\0invoice", 15));
+    WriteFile(dir / "picture.png", "invoice invoice");
+    CHECK(x.File(dir / "binary.txt", 10).empty() && x.File(dir / "picture.png", 10).empty() && x.File(dir / "missing.txt", 10).empty());
+    opt.extensions.clear();                                           // every extension
+    CHECK(Got(TagExtractor(opt).File(dir / "picture.png", 10)) == Counts({ { "invoice", 2 } }));
+}
+
+int main() {
+    TestRandom();
+    TestUnicode();
+    TestMisraGries();
+    TestIdf();
+    TestFiles();
+    std::printf("OK\n");
+    return 0;
+}
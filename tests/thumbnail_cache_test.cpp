@@ -0,0 +1,145 @@
+// ThumbnailCache: keys change with size / mtime / thumbnail size, the memory LRU against a reference
+// model (byte budget, recency, replacement), and the disk store round trip through a saved index, a
+// missing or stale index, a torn blob tail, budget eviction and compaction.
+#include "ThumbnailCache.h"
+#include "TestUtil.h"
+
+#include <map>
+
+namespace fs = std::filesystem;
+
+static void TestKey() {
+    uint64_t k = ThumbnailKey("/p/a.jpg", 100, 5, 96);
+    CHECK(k == ThumbnailKey("/p/a.jpg", 100, 5, 96));
+    CHECK(k != ThumbnailKey("/p/b.jpg", 100, 5, 96) && k != ThumbnailKey("/p/a.jpg", 101, 5, 96));
+    CHECK(k != ThumbnailKey("/p/a.jpg", 100, 6, 96) && k != ThumbnailKey("/p/a.jpg", 100, 5, 256));
+}
+
+static void TestLru() {
+    ThumbnailLru<int> lru(100);
+    lru.Put(1, 10, 40);
+    lru.Put(2, 20, 40);
+    int v;
+    CHECK(lru.Get(1, v) && v == 10);                  // 1 is now the most recent
+    lru.Put(3, 30, 40);                               // 120 > 100: evicts 2
+    CHECK(!lru.Get(2, v) && lru.Get(1, v) && lru.Get(3, v) && lru.Bytes() == 80);
+    lru.Put(1, 11, 10);                               // replace: cost follows
+    CHECK(lru.Get(1, v) && v == 11 && lru.Bytes() == 50 && lru.Count() == 2);
+    lru.Put(4, 40, 101);                              // larger than the budget: not kept
+    CHECK(!lru.Get(4, v) && lru.Count() == 2);
+    lru.SetBudget(20);                                // only the newest fits
+    CHECK(lru.Count() == 1 && lru.Get(1, v) && lru.Bytes() == 10);
+
+    // random operations against a list-based reference
+    ThumbnailLru<uint64_t> big(10000);
+    std::vector<std::pair<uint64_t, size_t>> ref;     // most recent first: (key, cost)
+    std::mt19937 g(8);
+    for (int i = 0; i < 20000; ++i) {
+        uint64_t key = g() % 300;
+        auto it = std::find_if(ref.begin(), ref.end(), [&](auto const& e) { return e.first == key; });
+        if (g() % 2) {
+            uint64_t got;
+            bool hit = big.Get(key, got);
+            CHECK(hit == (it != ref.end()) && (!hit || got == key * 7));
+            if (hit) { auto e = *it; ref.erase(it); ref.insert(ref.begin(), e); }
+        } else {
+            size_t cost = 1 + g() % 400;
+            big.Put(key, key * 7, cost);
+            if (it != ref.end()) ref.erase(it);
+            ref.insert(ref.begin(), { key, cost });
+            size_t bytes = 0;
+            for (auto const& e : ref) bytes += e.second;
+            while (bytes > 10000) { bytes -= ref.back().second; ref.pop_back(); }
+        }
+        size_t bytes = 0;
+        for (auto const& e : ref) bytes += e.second;
+        CHECK(big.Count() == ref.size() && big.Bytes() == bytes && bytes <= 10000);
+    }
+}
+
+static std::vector<uint8_t> Thumb(uint64_t key, size_t n) {
+    std::vector<uint8_t> b(n);
+    for (size_t i = 0; i < n; ++i) b[i] = (uint8_t)(key * 31 + i);
+    return b;
+}
+
+static void TestDisk(const TestDir& d) {
+    fs::path dir = d / "thumbs";
+    std::map<uint64_t, size_t> stored;
+    {
+        ThumbnailDiskStore s;
+        CHECK(s.Open(dir, 64u << 20));
+        for (uint64_t k = 1; k <= 1000; ++k) {
+            size_t n = 1000 + k % 5000;
+            auto b = Thumb(k, n);
+            s.Put(k, b.data(), b.size());
+            stored[k] = n;
+        }
+        auto b = Thumb(5, 77);                        // overwrite: the old record becomes dead
+        s.Put(5, b.data(), b.size());
+        stored[5] = 77;
+        CHECK(s.Count() == 1000);
+    }
+    auto verify = [&](ThumbnailDiskStore& s) {
+        CHECK(s.Count() == stored.size());
+        std::vector<uint8_t> out;
+        for (auto const& kv : stored) CHECK(s.Get(kv.first, out) && out == Thumb(kv.first, kv.second));
+        CHECK(!s.Get(99999, out));
+    };
+    {
+        ThumbnailDiskStore s;                         // from the saved index
+        CHECK(s.Open(dir, 64u << 20));
+        verify(s);
+    }
+    fs::remove(dir / "thumbs.idx");
+    {
+        ThumbnailDiskStore s;                         // index rebuilt from the blob; the later record for 5 wins
+        CHECK(s.Open(dir, 64u << 20));
+        verify(s);
+    }
+    uint64_t blob = fs::file_size(dir / "thumbs.blob");
+    std::ofstream(dir / "thumbs.blob", std::ios::binary | std::ios::app) << "THB1 torn record";
+    {
+        ThumbnailDiskStore s;                         // stale index (blob size differs), torn tail cut off
+        CHECK(s.Open(dir, 64u << 20));
+        verify(s);
+        CHECK(fs::file_size(dir / "thumbs.blob") == blob);
+    }
+
+    // budget: live bytes stay below it, recently read entries survive, compaction shrinks the file
+    const uint64_t kBudget = 1u << 20;                // below the ~1.5 MB stored above
+    {
+        ThumbnailDiskStore s;
+        CHECK(s.Open(dir, kBudget));                  // over budget at open: evicted and compacted
+        CHECK(s.LiveBytes() <= kBudget && s.FileBytes() == s.LiveBytes());
+        std::vector<uint8_t> out;
+        for (uint64_t k = 2000; k < 6000; ++k) {
+            auto b = Thumb(k, 4000);
+            s.Put(k, b.data(), b.size());
+            if (k % 10 == 0) CHECK(s.Get(2000, out));  // keep 2000 in use
+            CHECK(s.LiveBytes() <= kBudget);
+        }
+        CHECK(s.Get(2000, out) && out == Thumb(2000, 4000));
+        CHECK(!s.Get(2001, out) && s.Get(5999, out));
+        CHECK(s.FileBytes() < kBudget + (4u << 20) + 4096);  // dead records compacted once they outweigh live ones
+        s.Put(1, nullptr, 0);                         // empty / oversized: ignored
+        std::vector<uint8_t> huge(3u << 20);
+        s.Put(2, huge.data(), huge.size());
+        CHECK(!s.Get(2, out));
+        s.Clear();
+        CHECK(s.Count() == 0 && s.FileBytes() == 0);
+    }
+    {
+        ThumbnailDiskStore s;
+        CHECK(s.Open(dir, kBudget) && s.Count() == 0);
+    }
+}
+
+int main() {
+    TestKey();
+    TestLru();
+    TestDir d("thumbnail_cache_test");
+    TestDisk(d);
+    std::printf("OK\n");
+    return 0;
+}
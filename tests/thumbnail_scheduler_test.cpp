@@ -0,0 +1,197 @@
+// ThumbnailScheduler with a fake decoder, no UI: priority order (visible, near, background, FIFO within
+// a priority, re-ranking while queued), de-duplication of one key, cancelling one listener, a queued
+// job, a running decode and everything, a re-submit while the cancelled decode winds down, Stop() with
+// work pending, and a multi-worker run where every surviving listener fires exactly once.
+#include "ThumbnailScheduler.h"
+#include "TestUtil.h"
+
+#include <map>
+#include <set>
+
+// Decoder that records the order of decodes and can hold them until released (polling its cancel flag)
+class FakeDecoder {
+public:
+    ThumbDecodeFn Fn() {
+        return [this](const ThumbRequest& r, const std::atomic<bool>& cancel) {
+            std::unique_lock<std::mutex> lk(m_mutex);
+            m_order.push_back(r.key);
+            m_started.notify_all();
+            while (m_hold && !cancel.load()) m_cv.wait_for(lk, std::chrono::milliseconds(1));
+            if (cancel.load()) m_sawCancel.push_back(r.key);
+            return std::vector<uint8_t>(r.size, (uint8_t)r.key);
+        };
+    }
+    void Hold() { std::lock_guard<std::mutex> lg(m_mutex); m_hold = true; }
+    void Release() { { std::lock_guard<std::mutex> lg(m_mutex); m_hold = false; } m_cv.notify_all(); }
+    void WaitStarted(size_t n) {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_started.wait(lk, [&]() { return m_order.size() >= n; });
+    }
+    std::vector<uint64_t> Order() { std::lock_guard<std::mutex> lg(m_mutex); return m_order; }
+    std::vector<uint64_t> SawCancel() { std::lock_guard<std::mutex> lg(m_mutex); return m_sawCancel; }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv, m_started;
+    std::vector<uint64_t> m_order, m_sawCancel;
+    bool m_hold = false;
+};
+
+// Listener results, filled on the worker threads
+struct Done {
+    std::mutex mutex;
+    std::map<std::string, std::vector<uint8_t>> got;    // listener name -> data
+    ThumbDoneFn Fn(const std::string& name) {
+        return [this, name](uint64_t, const std::vector<uint8_t>& d) {
+            std::lock_guard<std::mutex> lg(mutex);
+            CHECK(!got.count(name));
+            got[name] = d;
+        };
+    }
+    bool Has(const std::string& name) { std::lock_guard<std::mutex> lg(mutex); return got.count(name) > 0; }
+};
+
+static ThumbRequest Req(uint64_t key) { return ThumbRequest{ key, "/img/" + std::to_string(key) + ".jpg", 4 }; }
+
+static void TestPriority() {
+    FakeDecoder dec;
+    dec.Hold();
+    Done done;
+    ThumbnailScheduler s;
+    s.Start(1, dec.Fn());
+    s.Submit(Req(100), ThumbBackground, done.Fn("blocker"));
+    dec.WaitStarted(1);                                   // the only worker is busy: the rest queues up
+    s.Submit(Req(1), ThumbBackground, done.Fn("1"));
+    s.Submit(Req(2), ThumbBackground, done.Fn("2"));
+    uint64_t t3 = s.Submit(Req(3), ThumbBackground, done.Fn("3"));
+    s.Submit(Req(4), ThumbNear, done.Fn("4"));
+    s.Submit(Req(5), ThumbVisible, done.Fn("5"));
+    s.Submit(Req(6), ThumbNear, done.Fn("6"));
+    s.Submit(Req(7), 99, done.Fn("7"));                   // clamped to background
+    s.SetPriority(t3, ThumbVisible);                      // scrolled into view: ahead of 5, submitted earlier
+    s.Submit(Req(2), ThumbNear, done.Fn("2b"));           // duplicate raises 2 to near (keeps its place in line)
+    s.Submit(Req(6), ThumbBackground, done.Fn("6b"));     // duplicate never lowers
+    auto m = s.Metrics();
+    CHECK(m.queued == 7 && m.running == 1 && m.submitted == 10 && m.deduplicated == 2);
+
+    dec.Release();
+    s.WaitIdle();
+    CHECK((dec.Order() == std::vector<uint64_t>{ 100, 3, 5, 2, 4, 6, 1, 7 }));
+    CHECK(done.got.size() == 10 && done.got["2b"] == done.got["2"] && done.got["6b"] == std::vector<uint8_t>(4, 6));
+    m = s.Metrics();
+    CHECK(m.completed == 8 && m.cancelled == 0 && m.queued == 0 && m.running == 0);
+    CHECK(m.waits[ThumbVisible] == 2 && m.waits[ThumbNear] == 3 && m.waits[ThumbBackground] == 3);
+    CHECK(m.maxWaitMs[ThumbBackground] >= m.meanWaitMs[ThumbBackground] && m.meanWaitMs[ThumbVisible] >= 0);
+}
+
+static void TestCancel() {
+    FakeDecoder dec;
+    dec.Hold();
+    Done done;
+    ThumbnailScheduler s;
+    s.Start(1, dec.Fn());
+    uint64_t run = s.Submit(Req(10), ThumbVisible, done.Fn("10"));
+    dec.WaitStarted(1);
+    uint64_t a = s.Submit(Req(11), ThumbVisible, done.Fn("11a"));
+    s.Submit(Req(11), ThumbVisible, done.Fn("11b"));
+    uint64_t q = s.Submit(Req(12), ThumbVisible, done.Fn("12"));
+    s.Submit(Req(13), ThumbNear, done.Fn("13"));
+    s.Cancel(a);                                          // the other listener still wants 11
+    s.Cancel(q);                                          // nobody wants 12: dropped from the queue
+    s.Cancel(q);                                          // unknown tickets are ignored
+    s.Cancel(run);                                        // the running decode sees its cancel flag
+    dec.WaitStarted(2);
+    dec.Release();
+    s.WaitIdle();
+    CHECK((dec.Order() == std::vector<uint64_t>{ 10, 11, 13 }));
+    CHECK((dec.SawCancel() == std::vector<uint64_t>{ 10 }));
+    CHECK(!done.Has("10") && !done.Has("11a") && done.Has("11b") && !done.Has("12") && done.Has("13"));
+    auto m = s.Metrics();
+    CHECK(m.cancelled == 2 && m.completed == 2);
+
+    // CancelAll: the running decode is cancelled, the queue emptied, no listener runs
+    dec.Hold();
+    s.Submit(Req(20), ThumbVisible, done.Fn("20"));
+    dec.WaitStarted(4);
+    for (uint64_t k = 21; k < 30; ++k) s.Submit(Req(k), ThumbBackground, done.Fn(std::to_string(k)));
+    s.CancelAll();
+    s.WaitIdle();
+    CHECK(dec.Order().size() == 4 && dec.SawCancel().back() == 20);
+    for (uint64_t k = 20; k < 30; ++k) CHECK(!done.Has(std::to_string(k)));
+    CHECK(s.Metrics().cancelled == 12);
+
+    // cancelled while decoding, wanted again before the decode returned: decoded again, not lost
+    dec.Hold();
+    uint64_t t = s.Submit(Req(40), ThumbVisible, done.Fn("40"));
+    dec.WaitStarted(5);
+    s.Cancel(t);
+    s.Submit(Req(40), ThumbVisible, done.Fn("40b"));
+    dec.Release();
+    s.WaitIdle();
+    CHECK(!done.Has("40") && done.Has("40b"));
+    CHECK((dec.Order() == std::vector<uint64_t>{ 10, 11, 13, 20, 40, 40 }));
+}
+
+static void TestStop() {
+    FakeDecoder dec;
+    dec.Hold();
+    Done done;
+    ThumbnailScheduler s;
+    s.Start(2, dec.Fn());
+    for (uint64_t k = 1; k <= 50; ++k) s.Submit(Req(k), ThumbBackground, done.Fn(std::to_string(k)));
+    dec.WaitStarted(2);
+    s.Stop();                                             // returns with both held decodes cancelled
+    CHECK(dec.Order().size() == 2 && dec.SawCancel().size() == 2 && done.got.empty());
+    auto m = s.Metrics();
+    CHECK(m.queued == 0 && m.running == 0 && m.cancelled == 50 && m.completed == 0);
+    s.Stop();                                             // twice is fine
+
+    dec.Release();
+    s.Start(1, dec.Fn());                                 // restartable
+    s.Submit(Req(7), ThumbVisible, done.Fn("7"));
+    s.WaitIdle();
+    CHECK(done.Has("7") && done.got["7"] == std::vector<uint8_t>(4, 7));
+}
+
+static void TestStress() {
+    FakeDecoder dec;
+    Done done;
+    ThumbnailScheduler s;
+    s.Start(4, dec.Fn());
+    std::mt19937 g(34);
+    std::vector<std::pair<uint64_t, std::string>> live;   // ticket, listener name
+    std::set<std::string> cancelled;
+    uint64_t submits = 0;
+    for (int i = 0; i < 20000; ++i) {
+        if (g() % 4 == 0 && !live.empty()) {
+            size_t j = g() % live.size();
+            s.Cancel(live[j].first);
+            cancelled.insert(live[j].second);
+            live.erase(live.begin() + (long)j);
+        } else {
+            std::string name = "s" + std::to_string(i);
+            uint64_t key = g() % 500;
+            ++submits;
+            live.push_back({ s.Submit(Req(key), (int)(g() % 3), done.Fn(name)), name });
+            if (g() % 8 == 0) s.SetPriority(live.back().first, (int)(g() % 3));
+        }
+        if (live.size() > 300) live.erase(live.begin(), live.begin() + 200);   // forget old tickets
+    }
+    s.WaitIdle();
+    auto m = s.Metrics();
+    CHECK(m.queued == 0 && m.running == 0 && m.submitted == submits);
+    // a cancelled listener may still run if it raced with completion; every other one ran exactly once
+    size_t ran = done.got.size();
+    CHECK(ran + cancelled.size() >= submits && ran <= submits);
+    for (auto const& kv : done.got) CHECK(kv.second == std::vector<uint8_t>(4, kv.second[0]));
+    CHECK(m.completed <= dec.Order().size() && m.deduplicated > 0 && m.cancelled > 0);
+}
+
+int main() {
+    TestPriority();
+    TestCancel();
+    TestStop();
+    TestStress();
+    std::printf("OK\n");
+    return 0;
+}
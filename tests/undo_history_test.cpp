@@ -0,0 +1,106 @@
+// UndoHistory against a plain std::wstring buffer: random replacements undo / redo to the exact
+// earlier texts (also through deflated chunks), typing merges until a line break, the memory cap
+// evicts the oldest steps, and a single step larger than the cap stays undoable.
+#include "UndoHistory.h"
+#include "TestUtil.h"
+
+struct Editor {
+    std::wstring text;
+    UndoHistory history;
+
+    explicit Editor(size_t cap) : history(cap) {}
+
+    void Replace(size_t pos, size_t len, const std::wstring& with, UndoKind kind = UndoKind::Other) {
+        history.Record(pos, text.data() + pos, len, with.data(), with.size(), kind);
+        text.replace(pos, len, with);
+    }
+    void Apply(const UndoEdit& e, bool undo) {
+        const std::wstring& now = undo ? e.inserted : e.removed;
+        CHECK(text.compare(e.pos, now.size(), now) == 0);
+        text.replace(e.pos, now.size(), undo ? e.removed : e.inserted);
+    }
+    bool Undo() { UndoEdit e; if (!history.Undo(e)) return false; Apply(e, true); return true; }
+    bool Redo() { UndoEdit e; if (!history.Redo(e)) return false; Apply(e, false); return true; }
+};
+
+static std::wstring Random(std::mt19937& g, size_t n) {
+    std::wstring s(n, L' ');
+    for (auto& c : s) c = (wchar_t)(L'a' + g() % 26);
+    return s;
+}
+
+static void TestRandomEdits() {
+    Editor ed(64u << 20);
+    std::mt19937 g(11);
+    const size_t n = 3000;
+    std::vector<std::wstring> checkpoints;             // text after every 97th step
+    for (size_t i = 1; i <= n; ++i) {
+        size_t pos = ed.text.empty() ? 0 : g() % ed.text.size();
+        size_t len = std::min<size_t>(ed.text.size() - pos, g() % 600);
+        ed.Replace(pos, len, Random(g, g() % 600));
+        if (i % 97 == 0) checkpoints.push_back(ed.text);
+    }
+    std::wstring last = ed.text;
+    CHECK(ed.history.StepCount() == n);
+    for (size_t k = n; k > 0; --k) {
+        CHECK(ed.Undo());
+        if ((k - 1) % 97 == 0 && k > 1) CHECK(ed.text == checkpoints[(k - 1) / 97 - 1]);
+    }
+    CHECK(!ed.Undo() && ed.text.empty());
+    while (ed.Redo()) {}
+    CHECK(ed.text == last);
+
+    // a new edit after undo drops the redo steps
+    ed.Undo();
+    ed.Replace(0, 0, L"x");
+    CHECK(!ed.history.CanRedo() && ed.history.StepCount() == n);
+}
+
+static void TestTypingMerge() {
+    Editor ed(1 << 20);
+    for (wchar_t c : std::wstring(L"hello")) ed.Replace(ed.text.size(), 0, std::wstring(1, c), UndoKind::Typing);
+    ed.Replace(ed.text.size(), 0, L"\r", UndoKind::Typing);
+    for (wchar_t c : std::wstring(L"world")) ed.Replace(ed.text.size(), 0, std::wstring(1, c), UndoKind::Typing);
+    ed.Replace(ed.text.size() - 2, 1, L"", UndoKind::Delete);
+    ed.Replace(ed.text.size() - 2, 1, L"", UndoKind::Delete);
+    CHECK(ed.text == L"hello\rwod" && ed.history.StepCount() == 4);   // the line break is a step of its own
+    CHECK(ed.Undo() && ed.text == L"hello\rworld");
+    CHECK(ed.Undo() && ed.text == L"hello\r");
+    CHECK(ed.Undo() && ed.text == L"hello");
+    CHECK(ed.Undo() && ed.text.empty() && !ed.history.CanUndo());
+}
+
+static void TestCap() {
+    const size_t cap = 1 << 20;
+    Editor ed(cap);
+    std::mt19937 g(12);
+    std::vector<std::wstring> states{ std::wstring() };   // text after 0, 1, 2, ... steps
+    for (int i = 0; i < 4000; ++i) {
+        size_t pos = ed.text.empty() ? 0 : g() % ed.text.size();
+        ed.Replace(pos, std::min<size_t>(ed.text.size() - pos, 200), Random(g, 200));
+        states.push_back(ed.text);
+        CHECK(ed.history.MemoryUsed() <= cap + (256u << 10));     // at most one chunk over while it fills
+    }
+    size_t kept = ed.history.StepCount();
+    CHECK(kept > 100 && kept < 4000);
+    for (size_t k = 0; k < kept; ++k) CHECK(ed.Undo());
+    CHECK(!ed.Undo() && ed.text == states[states.size() - 1 - kept]);
+
+    // a paste of cap characters (larger than the cap in bytes): the only step left, still undoable
+    std::wstring before = ed.text;
+    ed.Replace(0, 0, Random(g, cap));
+    CHECK(ed.history.StepCount() == 1 && ed.history.CanUndo());
+    CHECK(ed.Undo() && ed.text == before);
+    CHECK(ed.Redo() && ed.text.size() == before.size() + cap);
+    ed.Replace(0, 1, L"y");                                        // the next edit evicts the paste
+    CHECK(ed.history.StepCount() == 1 && ed.history.MemoryUsed() <= cap);
+    CHECK(ed.Undo() && !ed.history.CanUndo());
+}
+
+int main() {
+    TestRandomEdits();
+    TestTypingMerge();
+    TestCap();
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,55 @@
+// WorkPool: every task runs exactly once and WaitIdle() waits for tasks submitted by tasks (recursive
+// fan-out), outside submits from several threads at once, repeated idle/busy rounds (workers going to
+// sleep and being woken by a single Submit), a pool used from another pool's tasks, and destruction
+// with idle workers.
+#include "WorkPool.h"
+#include "TestUtil.h"
+
+static void FanOut(WorkPool& pool, std::atomic<uint64_t>& count, int depth) {
+    count.fetch_add(1);
+    if (depth == 0) return;
+    for (int i = 0; i < 3; ++i) pool.Submit([&pool, &count, depth]() { FanOut(pool, count, depth - 1); });
+}
+
+int main() {
+    for (unsigned threads : { 1u, 3u, 8u }) {
+        WorkPool pool(threads);
+        CHECK(pool.Size() == threads);
+        std::atomic<uint64_t> count{ 0 };
+        pool.Submit([&]() { FanOut(pool, count, 9); });
+        pool.WaitIdle();
+        CHECK(count.load() == (59049 - 1) / 2);                  // 1 + 3 + ... + 3^9
+
+        // outside submits racing each other; each slot must be hit exactly once
+        std::vector<std::atomic<int>> hits(40000);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 4; ++p)
+            producers.emplace_back([&, p]() { for (size_t i = p; i < hits.size(); i += 4) pool.Submit([&hits, i]() { hits[i].fetch_add(1); }); });
+        for (auto& t : producers) t.join();
+        pool.WaitIdle();
+        for (auto const& h : hits) CHECK(h.load() == 1);
+
+        // one task at a time: the workers are asleep between rounds and must be woken every time
+        for (int round = 0; round < 2000; ++round) {
+            std::atomic<bool> ran{ false };
+            pool.Submit([&]() { ran.store(true); });
+            pool.WaitIdle();
+            CHECK(ran.load());
+            if (round % 500 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        pool.WaitIdle();                                          // idle already: returns at once
+    }
+
+    // tasks of one pool fanning out on another (outside submits from the inner pool's point of view)
+    WorkPool outer(4), inner(3);
+    std::atomic<uint64_t> count{ 0 };
+    for (int i = 0; i < 100; ++i)
+        outer.Submit([&]() { for (int k = 0; k < 100; ++k) inner.Submit([&]() { count.fetch_add(1); }); });
+    outer.WaitIdle();
+    inner.WaitIdle();
+    CHECK(count.load() == 10000);
+
+    for (int i = 0; i < 50; ++i) { WorkPool p(4); }               // start and stop with sleeping workers
+    std::printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,351 @@
+// Codec.h — streaming gzip / zstd decode and encode for opening and saving compressed text
+// - The format is detected by magic bytes (1F 8B gzip, 28 B5 2F FD zstd), not by file extension
+// - CodecReader hands out decoded bytes in caller-sized pieces (the editor's load worker takes 1 MB
+//   at a time) and reads the compressed file in 256 KB chunks, so neither the whole compressed nor
+//   a second copy of the decoded text is ever held in memory
+// - CodecWriter takes pushed bytes (EM_STREAMOUT callback) and writes compressed output as it goes;
+//   zstd compresses on worker threads when the library is built with ZSTD_MULTITHREAD. It writes to
+//   "<path>.tmp" and replaces path only after Finish() succeeded, so a failed save keeps the old file
+// - Concatenated gzip members and zstd frames (rotated / appended logs) decode as one stream
+// Codecs are compiled in when their headers are found (TXT_HAVE_ZLIB / TXT_HAVE_ZSTD); link zlib/zstd.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cwctype>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if __has_include(<zlib.h>)
+#define TXT_HAVE_ZLIB 1
+#include <zlib.h>
+#else
+#define TXT_HAVE_ZLIB 0
+#endif
+
+#if __has_include(<zstd.h>)
+#define TXT_HAVE_ZSTD 1
+#include <zstd.h>
+#else
+#define TXT_HAVE_ZSTD 0
+#endif
+
+enum class Compression { None, Gzip, Zstd };
+
+static inline Compression DetectCompression(const unsigned char* p, size_t n) {
+    if (n >= 2 && p[0] == 0x1F && p[1] == 0x8B) return Compression::Gzip;
+    if (n >= 4 && p[0] == 0x28 && p[1] == 0xB5 && p[2] == 0x2F && p[3] == 0xFD) return Compression::Zstd;
+    return Compression::None;
+}
+
+static inline Compression SniffCompression(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    unsigned char head[4] = {};
+    in.read((char*)head, sizeof(head));
+    return DetectCompression(head, (size_t)in.gcount());
+}
+
+// Target format for "save as": chosen by extension (.gz / .zst), None for anything else.
+static inline Compression CompressionForPath(const std::filesystem::path& path) {
+    std::wstring ext = path.extension().wstring();
+    for (auto& c : ext) c = (wchar_t)towlower(c);
+    if (ext == L".gz" || ext == L".gzip") return Compression::Gzip;
+    if (ext == L".zst" || ext == L".zstd") return Compression::Zstd;
+    return Compression::None;
+}
+
+static inline bool CompressionAvailable(Compression c) {
+    switch (c) {
+    case Compression::Gzip: return TXT_HAVE_ZLIB != 0;
+    case Compression::Zstd: return TXT_HAVE_ZSTD != 0;
+    default: return true;
+    }
+}
+
+class CodecReader {
+public:
+    CodecReader() = default;
+    ~CodecReader() { Close(); }
+    CodecReader(const CodecReader&) = delete;
+    CodecReader& operator=(const CodecReader&) = delete;
+
+    bool Open(const std::filesystem::path& path) {
+        Close();
+        m_in.open(path, std::ios::binary);
+        if (!m_in) return Fail("cannot open file");
+        m_in.seekg(0, std::ios::end); m_total = (uint64_t)m_in.tellg(); m_in.seekg(0);
+        m_inBuf.resize(kChunk);
+        if (!Refill()) { m_end = true; return true; } // empty file
+        m_kind = DetectCompression(m_inBuf.data(), m_inLen);
+        switch (m_kind) {
+        case Compression::Gzip:
+#if TXT_HAVE_ZLIB
+            m_z = z_stream{};
+            if (inflateInit2(&m_z, 15 + 32) != Z_OK) return Fail("inflateInit2 failed");
+            m_zOpen = true;
+            break;
+#else
+            return Fail("gzip support not compiled in");
+#endif
+        case Compression::Zstd:
+#if TXT_HAVE_ZSTD
+            m_zs = ZSTD_createDStream();
+            if (!m_zs) return Fail("ZSTD_createDStream failed");
+            ZSTD_initDStream(m_zs);
+            break;
+#else
+            return Fail("zstd support not compiled in");
+#endif
+        default: break;
+        }
+        return true;
+    }
+
+    void Close() {
+#if TXT_HAVE_ZLIB
+        if (m_zOpen) inflateEnd(&m_z);
+        m_zOpen = false;
+#endif
+#if TXT_HAVE_ZSTD
+        if (m_zs) ZSTD_freeDStream(m_zs);
+        m_zs = nullptr;
+#endif
+        if (m_in.is_open()) m_in.close();
+        m_inPos = m_inLen = 0; m_consumed = m_total = 0;
+        m_end = m_frameOpen = false; m_error.clear(); m_kind = Compression::None;
+    }
+
+    // Decode up to cap bytes into out; returns 0 at the end of the stream or on error (see Failed()).
+    size_t Read(unsigned char* out, size_t cap) {
+        size_t produced = 0;
+        while (produced < cap && !m_end && m_error.empty()) {
+            bool haveInput = Refill();
+            if (m_kind == Compression::None) {
+                if (!haveInput) { m_end = true; break; }
+                size_t n = std::min(cap - produced, m_inLen - m_inPos);
+                memcpy(out + produced, m_inBuf.data() + m_inPos, n);
+                produced += n; m_inPos += n;
+                continue;
+            }
+            size_t before = produced;
+#if TXT_HAVE_ZLIB
+            if (m_kind == Compression::Gzip) {
+                m_z.next_in = m_inBuf.data() + m_inPos; m_z.avail_in = (uInt)(m_inLen - m_inPos);
+                m_z.next_out = out + produced; m_z.avail_out = (uInt)(cap - produced);
+                int rc = inflate(&m_z, Z_NO_FLUSH);
+                produced = cap - m_z.avail_out; m_inPos = m_inLen - m_z.avail_in;
+                if (rc == Z_STREAM_END) {
+                    // another gzip member may follow (pigz / appended logs)
+                    m_frameOpen = false;
+                    if (Refill()) inflateReset(&m_z); else m_end = true;
+                    continue;
+                }
+                if (rc != Z_OK && rc != Z_BUF_ERROR) { Fail(m_z.msg ? m_z.msg : "corrupt gzip data"); break; }
+                m_frameOpen = true;
+            }
+#endif
+#if TXT_HAVE_ZSTD
+            if (m_kind == Compression::Zstd) {
+                ZSTD_inBuffer in{ m_inBuf.data() + m_inPos, m_inLen - m_inPos, 0 };
+                ZSTD_outBuffer o{ out + produced, cap - produced, 0 };
+                size_t rc = ZSTD_decompressStream(m_zs, &o, &in);
+                if (ZSTD_isError(rc)) { Fail(ZSTD_getErrorName(rc)); break; }
+                produced += o.pos; m_inPos += in.pos;
+                m_frameOpen = rc != 0; // 0: a frame has been completely decoded and flushed
+            }
+#endif
+            if (!haveInput && produced == before) {
+                // input exhausted and nothing left to flush
+                if (m_frameOpen) Fail("compressed data is truncated");
+                m_end = true;
+            }
+        }
+        return produced;
+    }
+
+    Compression Kind() const { return m_kind; }
+    uint64_t CompressedSize() const { return m_total; }
+    uint64_t CompressedRead() const { return m_consumed; }
+    bool Failed() const { return !m_error.empty(); }
+    const std::string& Error() const { return m_error; }
+
+private:
+    static const size_t kChunk = 256 * 1024;
+
+    std::ifstream m_in;
+    std::vector<unsigned char> m_inBuf;
+    size_t m_inPos = 0, m_inLen = 0;
+    uint64_t m_consumed = 0, m_total = 0;
+    Compression m_kind = Compression::None;
+    bool m_end = false;
+    bool m_frameOpen = false;
+    std::string m_error;
+#if TXT_HAVE_ZLIB
+    z_stream m_z{};
+    bool m_zOpen = false;
+#endif
+#if TXT_HAVE_ZSTD
+    ZSTD_DStream* m_zs = nullptr;
+#endif
+
+    // Ensure unread input is buffered; false when the file is exhausted.
+    bool Refill() {
+        if (m_inPos < m_inLen) return true;
+        m_in.read((char*)m_inBuf.data(), (std::streamsize)m_inBuf.size());
+        m_inLen = (size_t)m_in.gcount(); m_inPos = 0;
+        m_consumed += m_inLen;
+        return m_inLen > 0;
+    }
+    bool Fail(const char* msg) { m_error = msg; return false; }
+};
+
+class CodecWriter {
+public:
+    CodecWriter() = default;
+    ~CodecWriter() { Abort(); }
+    CodecWriter(const CodecWriter&) = delete;
+    CodecWriter& operator=(const CodecWriter&) = delete;
+
+    // level 0 = codec default (gzip 6, zstd 3; gzip caps at 9), threads 0 = all cores (zstd only)
+    bool Open(const std::filesystem::path& path, Compression kind, int level = 0, int threads = 0) {
+        Abort();
+        (void)threads;
+        m_kind = kind;
+        m_error.clear();
+        m_path = path;
+        m_tmp = path;
+        m_tmp += ".tmp";
+        m_out.open(m_tmp, std::ios::binary | std::ios::trunc);
+        if (!m_out) return Fail("cannot create file");
+        m_outBuf.resize(kChunk);
+        switch (kind) {
+        case Compression::Gzip:
+#if TXT_HAVE_ZLIB
+            m_z = z_stream{};
+            if (deflateInit2(&m_z, level <= 0 ? Z_DEFAULT_COMPRESSION : std::min(level, 9), Z_DEFLATED, 15 + 16, 8,
+                    Z_DEFAULT_STRATEGY) != Z_OK) return Fail("deflateInit2 failed");
+            m_zOpen = true;
+            break;
+#else
+            return Fail("gzip support not compiled in");
+#endif
+        case Compression::Zstd:
+#if TXT_HAVE_ZSTD
+            m_zc = ZSTD_createCCtx();
+            if (!m_zc) return Fail("ZSTD_createCCtx failed");
+            ZSTD_CCtx_setParameter(m_zc, ZSTD_c_compressionLevel, level <= 0 ? 3 : level);
+            ZSTD_CCtx_setParameter(m_zc, ZSTD_c_checksumFlag, 1);
+            // fails harmlessly on single-threaded builds of libzstd
+            ZSTD_CCtx_setParameter(m_zc, ZSTD_c_nbWorkers,
+                threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency()));
+            break;
+#else
+            return Fail("zstd support not compiled in");
+#endif
+        default: break;
+        }
+        return true;
+    }
+
+    bool Write(const unsigned char* data, size_t n) {
+        if (!m_error.empty()) return false;
+        if (m_kind == Compression::None) {
+            m_out.write((const char*)data, (std::streamsize)n);
+            return m_out ? true : Fail("write failed");
+        }
+        return Pump(data, n, false);
+    }
+
+    // Flush the codec trailer, close the temporary file and move it over the target.
+    bool Finish() {
+        if (m_error.empty() && m_kind != Compression::None) Pump(nullptr, 0, true);
+        if (m_out.is_open()) {
+            m_out.close();
+            if (m_out.fail() && m_error.empty()) Fail("write failed");
+        }
+        if (m_error.empty() && !m_tmp.empty()) {
+            std::error_code ec;
+            std::filesystem::rename(m_tmp, m_path, ec);   // replaces the old file in one step
+            if (ec) Fail("cannot replace file");
+            else m_tmp.clear();
+        }
+        Abort();
+        return m_error.empty();
+    }
+
+    bool Failed() const { return !m_error.empty(); }
+    const std::string& Error() const { return m_error; }
+
+private:
+    static const size_t kChunk = 256 * 1024;
+
+    std::ofstream m_out;
+    std::filesystem::path m_path, m_tmp;      // m_tmp is empty once it replaced m_path
+    std::vector<unsigned char> m_outBuf;
+    Compression m_kind = Compression::None;
+    std::string m_error;
+#if TXT_HAVE_ZLIB
+    z_stream m_z{};
+    bool m_zOpen = false;
+#endif
+#if TXT_HAVE_ZSTD
+    ZSTD_CCtx* m_zc = nullptr;
+#endif
+
+    // Release codec state and drop an unfinished temporary file (keeps m_error for the caller).
+    void Abort() {
+#if TXT_HAVE_ZLIB
+        if (m_zOpen) deflateEnd(&m_z);
+        m_zOpen = false;
+#endif
+#if TXT_HAVE_ZSTD
+        if (m_zc) ZSTD_freeCCtx(m_zc);
+        m_zc = nullptr;
+#endif
+        if (m_out.is_open()) m_out.close();
+        if (!m_tmp.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(m_tmp, ec);
+            m_tmp.clear();
+        }
+    }
+
+    bool Pump(const unsigned char* data, size_t n, bool finish) {
+#if TXT_HAVE_ZLIB
+        if (m_kind == Compression::Gzip) {
+            m_z.next_in = (Bytef*)data; m_z.avail_in = (uInt)n;
+            for (;;) {
+                m_z.next_out = m_outBuf.data(); m_z.avail_out = (uInt)m_outBuf.size();
+                int rc = deflate(&m_z, finish ? Z_FINISH : Z_NO_FLUSH);
+                if (rc == Z_STREAM_ERROR) return Fail("deflate failed");
+                if (!Emit(m_outBuf.size() - m_z.avail_out)) return false;
+                if (finish ? rc == Z_STREAM_END : (m_z.avail_in == 0 && m_z.avail_out != 0)) return true;
+            }
+        }
+#endif
+#if TXT_HAVE_ZSTD
+        if (m_kind == Compression::Zstd) {
+            ZSTD_inBuffer in{ data, n, 0 };
+            for (;;) {
+                ZSTD_outBuffer o{ m_outBuf.data(), m_outBuf.size(), 0 };
+                size_t rc = ZSTD_compressStream2(m_zc, &o, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+                if (ZSTD_isError(rc)) return Fail(ZSTD_getErrorName(rc));
+                if (!Emit(o.pos)) return false;
+                if (finish ? rc == 0 : in.pos == in.size) return true;
+            }
+        }
+#endif
+        (void)data; (void)n; (void)finish;
+        return Fail("codec not available");
+    }
+
+    bool Emit(size_t n) {
+        if (n) m_out.write((const char*)m_outBuf.data(), (std::streamsize)n);
+        return m_out ? true : Fail("write failed");
+    }
+    bool Fail(const char* msg) { m_error = msg; return false; }
+};
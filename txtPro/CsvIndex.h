@@ -0,0 +1,434 @@
+// CsvIndex.h — row index + views over a memory-mapped CSV/TSV file
+// - BuildIndex classifies 64-byte blocks (quote / newline masks, prefix-XOR quote parity)
+//   and records row starts as 32-bit deltas per segment (~4 bytes per row)
+// - Rows are published while the build runs, so the table is browsable before it finishes
+// - Fields are parsed on demand for visible rows only; sort/filter build row permutations
+//   on a small chunk pool (CsvPool) without copying cell text
+#pragma once
+
+#include "Simd.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <cstdlib>
+#include <cwctype>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CsvField {
+    uint64_t offset;   // first byte of the cell (after an opening quote)
+    uint32_t length;   // raw length (without surrounding quotes)
+    bool quoted;       // contains "" escapes that FieldText undoes
+};
+
+// Fixed set of workers running flat chunk tasks (one FIFO queue; chunks never submit chunks).
+class CsvChunkPool {
+public:
+    CsvChunkPool() {
+        unsigned n = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < n; ++i) m_threads.emplace_back([this]() { Run(); });
+    }
+    ~CsvChunkPool() {
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& t : m_threads) t.join();
+    }
+    size_t Size() const { return m_threads.size(); }
+    void Submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lg(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        m_wake.notify_one();
+    }
+
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_stop = false;
+
+    void Run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                m_wake.wait(lk, [this]() { return m_stop || !m_tasks.empty(); });
+                if (m_stop) return;
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+// Workers for sort / filter chunks, started on first use and kept for the process lifetime.
+inline CsvChunkPool& CsvPool() {
+    static CsvChunkPool pool;
+    return pool;
+}
+
+// Runs f(begin, end) over [0, n) split across the pool (first chunk on the caller); blocks until all are done.
+// Waits for its own chunks only, so concurrent callers do not wait for each other.
+template <class F>
+static void CsvParallelFor(size_t n, size_t minChunk, F&& f) {
+    CsvChunkPool& pool = CsvPool();
+    size_t chunks = std::min<size_t>(pool.Size(), std::max<size_t>(1, n / std::max<size_t>(1, minChunk)));
+    if (chunks <= 1) { f((size_t)0, n); return; }
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t open = 0;
+    size_t per = (n + chunks - 1) / chunks;
+    for (size_t c = 1; c < chunks; ++c) {
+        size_t b = c * per, e = std::min(n, b + per);
+        if (b >= e) continue;
+        {
+            std::lock_guard<std::mutex> lg(mutex);
+            open++;
+        }
+        pool.Submit([&, b, e]() {
+            f(b, e);
+            std::lock_guard<std::mutex> lg(mutex);
+            if (--open == 0) done.notify_all();
+        });
+    }
+    f((size_t)0, std::min(n, per));
+    std::unique_lock<std::mutex> lk(mutex);
+    done.wait(lk, [&]() { return open == 0; });
+}
+
+class CsvTable {
+public:
+    bool Open(const std::filesystem::path& path) {
+        if (!m_file.Open(path)) return false;
+        std::wstring ext = path.extension().wstring();
+        for (auto& c : ext) c = (wchar_t)towlower(c);
+        m_delim = ext == L".tsv" || ext == L".tab" ? '\t' : SniffDelimiter();
+        return true;
+    }
+
+    char Delimiter() const { return m_delim; }
+    uint64_t FileSize() const { return m_file.Size(); }
+    uint64_t BytesIndexed() const { return m_bytesIndexed.load(std::memory_order_relaxed); }
+    bool Complete() const { return m_complete.load(std::memory_order_acquire); }
+    void Cancel() { m_cancel = true; }
+
+    // Rows published so far (row 0 is the header line).
+    uint64_t RowCount() const { return m_rows.load(std::memory_order_acquire); }
+
+    // Scan the whole file; call on a worker thread. progress(bytesDone, rowsSoFar) is invoked
+    // roughly every 32 MB. Returns false when cancelled.
+    bool BuildIndex(const std::function<void(uint64_t, uint64_t)>& progress = nullptr) {
+        const unsigned char* data = m_file.Data();
+        const uint64_t size = m_file.Size();
+        m_file.AdviseSequential();
+        if (size == 0) { m_complete = true; return true; }
+        AddRowStart(0);
+        uint64_t inside = 0; // carried quote parity (all ones while inside a quoted cell)
+        uint64_t pos = 0, nextReport = kReportBytes;
+        unsigned char tail[64];
+        while (pos < size) {
+            const unsigned char* block = data + pos;
+            size_t avail = (size_t)std::min<uint64_t>(64, size - pos);
+            if (avail < 64) { memset(tail, 0, sizeof(tail)); memcpy(tail, block, avail); block = tail; }
+            uint64_t quotes = SimdEqMask64(block, '"');
+            uint64_t newlines = SimdEqMask64(block, '\n');
+            uint64_t in = SimdPrefixXor(quotes) ^ inside;
+            inside = (uint64_t)((int64_t)in >> 63);
+            uint64_t ends = newlines & ~in;
+            while (ends) {
+                uint64_t next = pos + SimdCtz64(ends) + 1;
+                if (next < size) AddRowStart(next);
+                ends &= ends - 1;
+            }
+            pos += 64;
+            if (pos >= nextReport) {
+                Publish(std::min(pos, size));
+                nextReport += kReportBytes;
+                if (progress) progress(std::min(pos, size), RowCount());
+                if (m_cancel) return false;
+            }
+        }
+        Publish(size);
+        m_complete.store(true, std::memory_order_release);
+        if (progress) progress(size, RowCount());
+        return true;
+    }
+
+    // Byte range of a row without its line terminator.
+    bool RowSpan(uint64_t row, uint64_t& begin, uint64_t& end) const {
+        if (row >= RowCount()) return false;
+        begin = RowStart(row);
+        end = row + 1 < RowCount() ? RowStart(row + 1) : m_file.Size();
+        const unsigned char* d = m_file.Data();
+        if (end > begin && d[end - 1] == '\n') --end;
+        if (end > begin && d[end - 1] == '\r') --end;
+        return true;
+    }
+
+    // Split a row into cells (quote-aware). maxFields limits work when only a prefix is needed.
+    void ParseRow(uint64_t row, std::vector<CsvField>& out, size_t maxFields = SIZE_MAX) const {
+        out.clear();
+        uint64_t b, e;
+        if (!RowSpan(row, b, e)) return;
+        const unsigned char* d = m_file.Data();
+        uint64_t p = b;
+        while (out.size() < maxFields) {
+            CsvField f{ p, 0, false };
+            if (p < e && d[p] == '"') {
+                uint64_t q = ++p;
+                while (q < e) {
+                    if (d[q] == '"') {
+                        if (q + 1 < e && d[q + 1] == '"') { f.quoted = true; q += 2; continue; }
+                        break;
+                    }
+                    ++q;
+                }
+                f.offset = p; f.length = (uint32_t)(q - p);
+                p = q < e ? q + 1 : e;
+                while (p < e && d[p] != (unsigned char)m_delim) ++p; // tolerate junk after closing quote
+            }
+            else {
+                const void* hit = p < e ? memchr(d + p, m_delim, (size_t)(e - p)) : nullptr;
+                uint64_t q = hit ? (uint64_t)((const unsigned char*)hit - d) : e;
+                f.length = (uint32_t)(q - p);
+                p = q;
+            }
+            out.push_back(f);
+            if (p >= e) break;
+            ++p; // skip delimiter
+            if (p == e) { out.push_back(CsvField{ p, 0, false }); break; } // trailing empty cell
+        }
+    }
+
+    // Cell text as UTF-8 with "" unescaped.
+    std::string FieldText(const CsvField& f) const {
+        const char* s = (const char*)m_file.Data() + f.offset;
+        if (!f.quoted) return std::string(s, f.length);
+        std::string out; out.reserve(f.length);
+        for (uint32_t i = 0; i < f.length; ++i) {
+            out.push_back(s[i]);
+            if (s[i] == '"' && i + 1 < f.length && s[i + 1] == '"') ++i;
+        }
+        return out;
+    }
+
+    size_t ColumnCount() const {
+        std::vector<CsvField> hdr;
+        ParseRow(0, hdr);
+        return hdr.size();
+    }
+
+    // Data rows 1..RowCount()-1 in file order.
+    std::vector<uint32_t> IdentityView() const {
+        uint64_t n = RowCount();
+        std::vector<uint32_t> rows(n > 1 ? (size_t)(n - 1) : 0);
+        for (size_t i = 0; i < rows.size(); ++i) rows[i] = (uint32_t)(i + 1);
+        return rows;
+    }
+
+    // Stable sort of a view by one column. Numeric cells sort before text and compare by value;
+    // text compares bytewise. Only a 24-byte key per row is materialised (cell bytes stay in the mapping).
+    std::vector<uint32_t> SortedView(const std::vector<uint32_t>& rows, size_t column, bool ascending) const {
+        struct Key { uint64_t prefix; uint64_t offset; uint32_t row; uint32_t info; }; // info: numeric | quoted | length
+        const uint32_t kNumeric = 0x80000000u, kQuoted = 0x40000000u, kLenMask = 0x3FFFFFFFu;
+        std::vector<Key> keys(rows.size());
+        CsvParallelFor(rows.size(), 1 << 15, [&](size_t b, size_t e) {
+            std::vector<CsvField> fields;
+            for (size_t i = b; i < e; ++i) {
+                ParseRow(rows[i], fields, column + 1);
+                Key k{ 0, 0, rows[i], 0 };
+                if (column < fields.size()) {
+                    const CsvField& f = fields[column];
+                    double v;
+                    k.offset = f.offset;
+                    k.info = std::min(f.length, kLenMask) | (f.quoted ? kQuoted : 0);
+                    if (ParseNumber(f, v)) { k.info |= kNumeric; k.prefix = OrderedBits(v); }
+                    else k.prefix = TextPrefix(f);
+                }
+                keys[i] = k;
+            }
+        });
+        const unsigned char* d = m_file.Data();
+        auto less = [&](const Key& a, const Key& b) {
+            bool an = (a.info & kNumeric) != 0, bn = (b.info & kNumeric) != 0;
+            if (an != bn) return ascending ? an : bn;
+            if (a.prefix != b.prefix) return ascending ? a.prefix < b.prefix : a.prefix > b.prefix;
+            if (!an) {
+                int c;
+                if (!((a.info | b.info) & kQuoted)) {
+                    uint32_t la = a.info & kLenMask, lb = b.info & kLenMask;
+                    c = memcmp(d + a.offset, d + b.offset, std::min(la, lb));
+                    if (c == 0) c = la < lb ? -1 : la > lb ? 1 : 0;
+                }
+                else c = FieldText(CsvField{ a.offset, a.info & kLenMask, (a.info & kQuoted) != 0 })
+                    .compare(FieldText(CsvField{ b.offset, b.info & kLenMask, (b.info & kQuoted) != 0 }));
+                if (c != 0) return ascending ? c < 0 : c > 0;
+            }
+            return a.row < b.row; // stable: file order on ties
+        };
+        ParallelSort(keys, less);
+        std::vector<uint32_t> out(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) out[i] = keys[i].row;
+        return out;
+    }
+
+    // Rows of the view whose cell (or whole line when column == SIZE_MAX) contains needle; keeps order.
+    std::vector<uint32_t> FilteredView(const std::vector<uint32_t>& rows, size_t column, const std::string& needle) const {
+        if (needle.empty()) return rows;
+        size_t threads = CsvPool().Size();
+        std::vector<std::vector<uint32_t>> parts(threads);
+        std::atomic<size_t> slot{ 0 };
+        std::vector<std::pair<size_t, size_t>> ranges(threads);
+        CsvParallelFor(rows.size(), 1 << 15, [&](size_t b, size_t e) {
+            size_t s = slot++;
+            ranges[s] = { b, s };
+            std::vector<CsvField> fields;
+            const char* d = (const char*)m_file.Data();
+            for (size_t i = b; i < e; ++i) {
+                uint64_t rb, re;
+                if (column == SIZE_MAX) { if (!RowSpan(rows[i], rb, re)) continue; }
+                else {
+                    ParseRow(rows[i], fields, column + 1);
+                    if (column >= fields.size()) continue;
+                    rb = fields[column].offset; re = rb + fields[column].length;
+                }
+                if (std::string_view(d + rb, (size_t)(re - rb)).find(needle) != std::string_view::npos) parts[s].push_back(rows[i]);
+            }
+        });
+        // concatenate in range order so the view order is preserved
+        std::vector<std::pair<size_t, size_t>> used(ranges.begin(), ranges.begin() + slot.load());
+        std::sort(used.begin(), used.end());
+        std::vector<uint32_t> out;
+        for (auto const& r : used) out.insert(out.end(), parts[r.second].begin(), parts[r.second].end());
+        return out;
+    }
+
+private:
+    static const uint64_t kReportBytes = 32ull << 20;
+    static const size_t kSegmentRows = 1 << 16;
+
+    // Row starts: per segment a 64-bit base and 32-bit deltas. Segment storage is reserved up front
+    // so readers never observe a reallocation while the builder appends.
+    struct Segment {
+        uint64_t firstRow;
+        uint64_t base;
+        std::vector<uint32_t> deltas;
+    };
+
+    MappedFile m_file;
+    char m_delim = ',';
+    std::vector<std::unique_ptr<Segment>> m_segments;
+    mutable std::mutex m_segMutex;     // guards m_segments (the vector, not segment contents)
+    uint64_t m_rowsBuilt = 0;          // builder-private
+    std::atomic<uint64_t> m_rows{ 0 }; // published
+    std::atomic<uint64_t> m_bytesIndexed{ 0 };
+    std::atomic<bool> m_complete{ false };
+    std::atomic<bool> m_cancel{ false };
+
+    void AddRowStart(uint64_t offset) {
+        Segment* seg = nullptr;
+        {
+            std::lock_guard<std::mutex> lg(m_segMutex);
+            if (!m_segments.empty()) seg = m_segments.back().get();
+            if (!seg || seg->deltas.size() == kSegmentRows || offset - seg->base > UINT32_MAX) {
+                auto ns = std::make_unique<Segment>();
+                ns->firstRow = m_rowsBuilt; ns->base = offset;
+                ns->deltas.reserve(kSegmentRows);
+                seg = ns.get();
+                m_segments.push_back(std::move(ns));
+            }
+        }
+        seg->deltas.push_back((uint32_t)(offset - seg->base));
+        ++m_rowsBuilt;
+    }
+    void Publish(uint64_t bytes) {
+        m_bytesIndexed.store(bytes, std::memory_order_relaxed);
+        m_rows.store(m_rowsBuilt, std::memory_order_release);
+    }
+    uint64_t RowStart(uint64_t row) const {
+        // once the build is complete the segment list is immutable and needs no lock
+        std::unique_lock<std::mutex> lk(m_segMutex, std::defer_lock);
+        if (!m_complete.load(std::memory_order_acquire)) lk.lock();
+        auto it = std::upper_bound(m_segments.begin(), m_segments.end(), row,
+            [](uint64_t r, const std::unique_ptr<Segment>& s) { return r < s->firstRow; });
+        const Segment& s = **(it - 1);
+        return s.base + s.deltas[(size_t)(row - s.firstRow)];
+    }
+
+    char SniffDelimiter() const {
+        const char cands[] = { ',', ';', '\t', '|' };
+        size_t counts[4] = {};
+        const unsigned char* d = m_file.Data();
+        size_t n = (size_t)std::min<uint64_t>(m_file.Size(), 64 * 1024);
+        bool inQ = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (d[i] == '"') inQ = !inQ;
+            else if (!inQ && d[i] == '\n') break;
+            else if (!inQ) for (int k = 0; k < 4; ++k) if (d[i] == (unsigned char)cands[k]) ++counts[k];
+        }
+        int best = 0;
+        for (int k = 1; k < 4; ++k) if (counts[k] > counts[best]) best = k;
+        return cands[best];
+    }
+
+    bool ParseNumber(const CsvField& f, double& v) const {
+        if (f.length == 0 || f.length > 63) return false;
+        char buf[64];
+        memcpy(buf, m_file.Data() + f.offset, f.length); buf[f.length] = 0;
+        char* end = nullptr;
+        v = strtod(buf, &end);
+        return end == buf + f.length && v == v; // reject partial parses and NaN
+    }
+    static uint64_t OrderedBits(double v) {
+        uint64_t u; memcpy(&u, &v, sizeof(u));
+        return (u >> 63) ? ~u : (u | 0x8000000000000000ull);
+    }
+    // First 8 bytes of the unescaped text (zero padded), so prefix order agrees with the FieldText tie-break.
+    uint64_t TextPrefix(const CsvField& f) const {
+        uint64_t k = 0;
+        uint32_t n = 0;
+        const unsigned char* s = m_file.Data() + f.offset;
+        for (uint32_t i = 0; i < f.length && n < 8; ++i, ++n) {
+            k = (k << 8) | s[i];
+            if (f.quoted && s[i] == '"' && i + 1 < f.length && s[i + 1] == '"') ++i;
+        }
+        return n == 0 ? 0 : k << (8 * (8 - n));
+    }
+    // Chunks sorted in parallel, then merged pairwise.
+    template <class T, class Less>
+    static void ParallelSort(std::vector<T>& v, Less less) {
+        size_t threads = CsvPool().Size();
+        if (threads == 1 || v.size() < (1u << 16)) { std::sort(v.begin(), v.end(), less); return; }
+        size_t per = (v.size() + threads - 1) / threads;
+        std::vector<size_t> bounds;
+        for (size_t b = 0; b < v.size(); b += per) bounds.push_back(b);
+        bounds.push_back(v.size());
+        CsvParallelFor(bounds.size() - 1, 1, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) std::sort(v.begin() + bounds[i], v.begin() + bounds[i + 1], less);
+        });
+        while (bounds.size() > 2) {
+            std::vector<size_t> next;
+            size_t pairs = (bounds.size() - 1) / 2;
+            CsvParallelFor(pairs, 1, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i)
+                    std::inplace_merge(v.begin() + bounds[2 * i], v.begin() + bounds[2 * i + 1], v.begin() + bounds[2 * i + 2], less);
+            });
+            for (size_t i = 0; i < bounds.size(); i += 2) next.push_back(bounds[i]);
+            if (next.back() != v.size()) next.push_back(v.size());
+            bounds.swap(next);
+        }
+    }
+};
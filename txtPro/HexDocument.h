@@ -0,0 +1,179 @@
+// HexDocument.h — memory-mapped binary document with an overlay patch list (hex view backend)
+// - The file is never loaded: reads go to the mapping, edits live in a sorted offset -> byte map
+// - Byte-pattern search scans 1 MB windows (patches applied) with an SSE2 first/last-byte filter
+// - Save writes only the patched bytes in place, or streams a patched copy to a new path
+// Edits replace bytes; the file size never changes.
+#pragma once
+
+#include "Simd.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+class HexDocument {
+public:
+    bool Open(const std::filesystem::path& path) {
+        m_patches.clear();
+        m_path = path;
+        return m_file.Open(path);
+    }
+
+    const std::filesystem::path& Path() const { return m_path; }
+    uint64_t Size() const { return m_file.Size(); }
+    bool Modified() const { return !m_patches.empty(); }
+    size_t PatchCount() const { return m_patches.size(); }
+    void RevertAll() { m_patches.clear(); }
+
+    // Copy up to n bytes starting at offset (patches applied); returns the number of bytes copied.
+    size_t Read(uint64_t offset, uint8_t* out, size_t n) const {
+        if (offset >= Size()) return 0;
+        n = (size_t)std::min<uint64_t>(n, Size() - offset);
+        memcpy(out, m_file.Data() + offset, n);
+        for (auto it = m_patches.lower_bound(offset); it != m_patches.end() && it->first < offset + n; ++it)
+            out[it->first - offset] = it->second;
+        return n;
+    }
+
+    uint8_t ByteAt(uint64_t offset) const {
+        auto it = m_patches.find(offset);
+        return it != m_patches.end() ? it->second : m_file.Data()[offset];
+    }
+    bool IsPatched(uint64_t offset) const { return m_patches.count(offset) != 0; }
+
+    void SetByte(uint64_t offset, uint8_t value) {
+        if (offset >= Size()) return;
+        if (m_file.Data()[offset] == value) m_patches.erase(offset); // back to the original byte
+        else m_patches[offset] = value;
+    }
+
+    // Next occurrence of pattern at or after 'from' (wrapping to the start once if requested).
+    // Returns UINT64_MAX when there is none.
+    uint64_t Find(const std::vector<uint8_t>& pattern, uint64_t from, bool wrap = true) const {
+        if (pattern.empty() || pattern.size() > Size()) return UINT64_MAX;
+        uint64_t hit = FindRange(pattern, from, Size());
+        if (hit == UINT64_MAX && wrap && from > 0)
+            hit = FindRange(pattern, 0, from);
+        return hit;
+    }
+
+    // Write the patched bytes into the mapped file itself (views are coherent with file writes).
+    bool SaveInPlace() {
+        if (m_patches.empty()) return true;
+        std::fstream f(m_path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!f) return false;
+        std::vector<char> run;
+        auto it = m_patches.begin();
+        while (it != m_patches.end()) {
+            uint64_t start = it->first;
+            run.clear();
+            while (it != m_patches.end() && it->first == start + run.size()) { run.push_back((char)it->second); ++it; }
+            f.seekp((std::streamoff)start);
+            f.write(run.data(), (std::streamsize)run.size());
+            if (!f) return false;
+        }
+        f.flush();
+        if (!f) return false;
+        m_patches.clear();
+        return true;
+    }
+
+    // Stream the patched content to another file, then continue on that file.
+    bool SaveAs(const std::filesystem::path& path) {
+        std::error_code ec;
+        if (std::filesystem::equivalent(path, m_path, ec)) return SaveInPlace();
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            std::vector<uint8_t> buf(kWindow);
+            for (uint64_t off = 0; off < Size(); off += kWindow) {
+                size_t n = Read(off, buf.data(), buf.size());
+                out.write((const char*)buf.data(), (std::streamsize)n);
+                if (!out) return false;
+            }
+        }
+        return Open(path);
+    }
+
+    // NUL bytes in the first sample bytes mark a binary file (UTF-16 text with BOM excluded).
+    static bool SniffBinary(const std::filesystem::path& path, size_t sample = 8192) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        std::vector<char> buf(sample);
+        in.read(buf.data(), (std::streamsize)buf.size());
+        size_t n = (size_t)in.gcount();
+        if (n >= 2 && (((unsigned char)buf[0] == 0xFF && (unsigned char)buf[1] == 0xFE) ||
+                       ((unsigned char)buf[0] == 0xFE && (unsigned char)buf[1] == 0xFF))) return false;
+        return memchr(buf.data(), 0, n) != nullptr;
+    }
+
+    // "DE AD be ef" / "deadbeef" as hex bytes, or "\"text\"" as raw UTF-8 text.
+    static bool ParsePattern(const std::string& text, std::vector<uint8_t>& out) {
+        out.clear();
+        if (text.size() >= 2 && text.front() == '"' && text.back() == '"') {
+            out.assign(text.begin() + 1, text.end() - 1);
+            return !out.empty();
+        }
+        int hi = -1;
+        for (char c : text) {
+            if (c == ' ' || c == ',' || c == '\t') continue;
+            int v = HexValue(c);
+            if (v < 0) return false;
+            if (hi < 0) hi = v; else { out.push_back((uint8_t)(hi << 4 | v)); hi = -1; }
+        }
+        return hi < 0 && !out.empty();
+    }
+
+    static int HexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+private:
+    static const size_t kWindow = 1 << 20;
+
+    MappedFile m_file;
+    std::filesystem::path m_path;
+    std::map<uint64_t, uint8_t> m_patches;
+
+    // Search matches starting in [from, end) using overlapping windows of constant size.
+    uint64_t FindRange(const std::vector<uint8_t>& pat, uint64_t from, uint64_t end) const {
+        const size_t m = pat.size();
+        std::vector<uint8_t> buf(kWindow + m - 1);
+        for (uint64_t off = from; off < end; off += kWindow) {
+            size_t n = Read(off, buf.data(), buf.size());
+            if (n < m) break;
+            size_t starts = (size_t)std::min<uint64_t>(n - m + 1, std::min<uint64_t>(kWindow, end - off));
+            size_t i = FindInBuffer(buf.data(), starts + m - 1, pat.data(), m);
+            if (i < starts) return off + i;
+        }
+        return UINT64_MAX;
+    }
+
+    // First match of pat (m bytes) in hay (n bytes); returns n when there is none.
+    static size_t FindInBuffer(const uint8_t* hay, size_t n, const uint8_t* pat, size_t m) {
+        if (m > n) return n;
+        size_t i = 0;
+#if TXT_SIMD_SSE2
+        const __m128i first = _mm_set1_epi8((char)pat[0]), last = _mm_set1_epi8((char)pat[m - 1]);
+        for (; i + m - 1 + 16 <= n; i += 16) {
+            __m128i a = _mm_cmpeq_epi8(first, _mm_loadu_si128((const __m128i*)(hay + i)));
+            __m128i b = _mm_cmpeq_epi8(last, _mm_loadu_si128((const __m128i*)(hay + i + m - 1)));
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(a, b));
+            while (mask) {
+                unsigned bit = SimdCtz(mask);
+                if (m <= 2 || memcmp(hay + i + bit + 1, pat + 1, m - 2) == 0) return i + bit;
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; i + m <= n; ++i)
+            if (hay[i] == pat[0] && memcmp(hay + i, pat, m) == 0) return i;
+        return n;
+    }
+};
@@ -0,0 +1,361 @@
+// JsonStream.h — streaming (SAX-style) JSON validator, pretty-printer and minifier
+// - Input is fed in arbitrary chunks; no DOM is built, memory is O(nesting depth)
+// - Validates RFC 8259 syntax incl. UTF-8 in strings and reports the first error (offset/line/column)
+// - Pretty/Minify re-emit the token stream through a buffered sink while validating
+// - SSE2 fast paths for string bodies and whitespace runs (see Simd.h)
+// Portable: no Win32 dependency, usable from the editor worker thread or standalone.
+#pragma once
+
+#include "Simd.h"
+#include <string>
+#include <vector>
+#include <functional>
+
+enum class JsonMode { Validate, Pretty, Minify };
+
+enum class JsonError {
+    None,
+    UnexpectedChar,     // token not allowed at this position
+    UnexpectedEnd,      // input ended inside a value
+    BadEscape,          // unknown \x escape
+    BadUnicodeEscape,   // \u not followed by 4 hex digits
+    ControlChar,        // raw control character inside a string
+    BadNumber,
+    BadLiteral,         // misspelled true/false/null
+    BadUtf8,
+    TooDeep,
+    TrailingData        // non-whitespace after the top-level value
+};
+
+class JsonStream {
+public:
+    using Sink = std::function<void(const char*, size_t)>;
+
+    explicit JsonStream(JsonMode mode = JsonMode::Validate, Sink sink = Sink(), int indent = 2, size_t maxDepth = 100000)
+        : m_mode(mode), m_sink(std::move(sink)), m_indent(indent), m_maxDepth(maxDepth) {
+        if (m_mode != JsonMode::Validate) m_out.reserve(kOutChunk + 256);
+    }
+
+    // Feed the next chunk. Returns false once an error has been detected.
+    bool Feed(const char* data, size_t len);
+    // Signal end of input; validates that exactly one complete value was seen and flushes the sink.
+    bool Finish();
+
+    JsonError Error() const { return m_error; }
+    uint64_t ErrorOffset() const { return m_errOffset; }
+    uint64_t ErrorLine() const { return m_errLine; }      // 1-based
+    uint64_t ErrorColumn() const { return m_errColumn; }  // 1-based, in bytes
+    uint64_t BytesConsumed() const { return m_offset; }
+
+private:
+    enum State : uint8_t {
+        S_Value, S_ValueOrClose, S_KeyOrClose, S_Key, S_Colon, S_CommaOrClose,
+        S_String, S_Escape, S_Unicode, S_Utf8, S_Number, S_Literal, S_Done
+    };
+    enum NumState : uint8_t { N_Minus, N_Zero, N_Int, N_FracStart, N_Frac, N_ExpStart, N_ExpSign, N_Exp };
+    static const size_t kOutChunk = 64 * 1024;
+
+    JsonMode m_mode;
+    Sink m_sink;
+    int m_indent;
+    size_t m_maxDepth;
+
+    State m_state = S_Value;
+    NumState m_num = N_Minus;
+    std::vector<uint8_t> m_stack;      // 'o' object / 'a' array
+    bool m_inKey = false;
+    bool m_pendingBreak = false;       // pretty: container opened or ',' seen, newline not yet written
+    int m_hexLeft = 0;
+    int m_utf8Left = 0;
+    unsigned char m_utf8Lo = 0x80, m_utf8Hi = 0xBF; // allowed range for the next continuation byte
+    const char* m_literal = nullptr;
+    int m_literalPos = 0;
+
+    uint64_t m_offset = 0;             // absolute offset of the current chunk start (after Feed: total bytes)
+    uint64_t m_line = 1;
+    uint64_t m_lineStart = 0;          // absolute offset of the first byte of the current line
+
+    JsonError m_error = JsonError::None;
+    uint64_t m_errOffset = 0, m_errLine = 0, m_errColumn = 0;
+
+    std::string m_out;
+
+    bool Emitting() const { return m_mode != JsonMode::Validate; }
+    void Put(char c) { if (Emitting()) { m_out.push_back(c); if (m_out.size() >= kOutChunk) FlushOut(); } }
+    void Put(const unsigned char* p, size_t n) {
+        if (!Emitting() || !n) return;
+        m_out.append((const char*)p, n);
+        if (m_out.size() >= kOutChunk) FlushOut();
+    }
+    void FlushOut() { if (m_sink && !m_out.empty()) m_sink(m_out.data(), m_out.size()); m_out.clear(); }
+    void NewLine(size_t depth) {
+        if (m_mode != JsonMode::Pretty) return;
+        Put('\n');
+        size_t n = depth * (size_t)m_indent;
+        while (n) { size_t k = n < 32 ? n : 32; Put((const unsigned char*)"                                ", k); n -= k; }
+    }
+    void BreakIfPending() { if (m_pendingBreak) { m_pendingBreak = false; NewLine(m_stack.size()); } }
+
+    bool Fail(JsonError e, uint64_t absOffset) {
+        m_error = e; m_errOffset = absOffset; m_errLine = m_line;
+        m_errColumn = absOffset >= m_lineStart ? absOffset - m_lineStart + 1 : 1;
+        return false;
+    }
+    void ValueDone() { m_state = m_stack.empty() ? S_Done : S_CommaOrClose; }
+    bool BeginValue(unsigned char c, uint64_t at);
+    bool Close(unsigned char c, uint64_t at);
+    bool BeginUtf8(unsigned char c, uint64_t at);
+
+    static bool IsWs(unsigned char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+    static bool IsHex(unsigned char c) { return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f'); }
+
+    // Length of the leading run that needs no special handling inside a string
+    // (stops at '"', '\\', control chars and non-ASCII bytes).
+    static size_t ScanStringRun(const unsigned char* p, size_t n) {
+        size_t i = 0;
+#if TXT_SIMD_SSE2
+        const __m128i quote = _mm_set1_epi8('"'), bslash = _mm_set1_epi8('\\'), ctl = _mm_set1_epi8(0x1F);
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+            __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash));
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(v, ctl), v));
+            uint32_t mask = (uint32_t)(_mm_movemask_epi8(m) | _mm_movemask_epi8(v));
+            if (mask) return i + SimdCtz(mask);
+        }
+#endif
+        for (; i < n; ++i) {
+            unsigned char c = p[i];
+            if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80) break;
+        }
+        return i;
+    }
+
+    // Length of the leading whitespace run; counts '\n' and reports the position after the last one.
+    static size_t SkipWhitespace(const unsigned char* p, size_t n, uint64_t& newlines, size_t& afterLastNl) {
+        size_t i = 0;
+#if TXT_SIMD_SSE2
+        const __m128i sp = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t'), lf = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r');
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+            __m128i nl = _mm_cmpeq_epi8(v, lf);
+            __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)), _mm_or_si128(nl, _mm_cmpeq_epi8(v, cr)));
+            uint32_t nonWs = ~(uint32_t)_mm_movemask_epi8(ws) & 0xFFFF;
+            uint32_t nlMask = (uint32_t)_mm_movemask_epi8(nl);
+            if (nonWs) nlMask &= (1u << SimdCtz(nonWs)) - 1;
+            if (nlMask) {
+                newlines += SimdPopcount(nlMask);
+                afterLastNl = i + SimdBsr(nlMask) + 1;
+            }
+            if (nonWs) return i + SimdCtz(nonWs);
+        }
+#endif
+        for (; i < n && IsWs(p[i]); ++i) {
+            if (p[i] == '\n') { ++newlines; afterLastNl = i + 1; }
+        }
+        return i;
+    }
+};
+
+inline bool JsonStream::BeginValue(unsigned char c, uint64_t at) {
+    switch (c) {
+    case '{': case '[':
+        if (m_stack.size() >= m_maxDepth) return Fail(JsonError::TooDeep, at);
+        BreakIfPending();
+        Put((char)c);
+        m_stack.push_back(c == '{' ? 'o' : 'a');
+        m_state = c == '{' ? S_KeyOrClose : S_ValueOrClose;
+        m_pendingBreak = true;
+        return true;
+    case '"':
+        BreakIfPending(); Put('"');
+        m_inKey = false; m_state = S_String;
+        return true;
+    case 't': case 'f': case 'n':
+        BreakIfPending(); Put((char)c);
+        m_literal = c == 't' ? "true" : c == 'f' ? "false" : "null";
+        m_literalPos = 1; m_state = S_Literal;
+        return true;
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            BreakIfPending(); Put((char)c);
+            m_num = c == '-' ? N_Minus : c == '0' ? N_Zero : N_Int;
+            m_state = S_Number;
+            return true;
+        }
+        return Fail(JsonError::UnexpectedChar, at);
+    }
+}
+
+inline bool JsonStream::Close(unsigned char c, uint64_t at) {
+    uint8_t want = c == '}' ? 'o' : 'a';
+    if (m_stack.empty() || m_stack.back() != want) return Fail(JsonError::UnexpectedChar, at);
+    m_stack.pop_back();
+    if (m_pendingBreak) m_pendingBreak = false;   // empty container stays on one line
+    else NewLine(m_stack.size());
+    Put((char)c);
+    ValueDone();
+    return true;
+}
+
+inline bool JsonStream::BeginUtf8(unsigned char c, uint64_t at) {
+    m_utf8Lo = 0x80; m_utf8Hi = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF) m_utf8Left = 1;
+    else if (c >= 0xE0 && c <= 0xEF) { m_utf8Left = 2; if (c == 0xE0) m_utf8Lo = 0xA0; else if (c == 0xED) m_utf8Hi = 0x9F; }
+    else if (c >= 0xF0 && c <= 0xF4) { m_utf8Left = 3; if (c == 0xF0) m_utf8Lo = 0x90; else if (c == 0xF4) m_utf8Hi = 0x8F; }
+    else return Fail(JsonError::BadUtf8, at);
+    m_state = S_Utf8;
+    return true;
+}
+
+inline bool JsonStream::Feed(const char* data, size_t len) {
+    if (m_error != JsonError::None) return false;
+    const unsigned char* const start = (const unsigned char*)data;
+    const unsigned char* p = start;
+    const unsigned char* const end = start + len;
+    auto at = [&](const unsigned char* q) { return m_offset + (uint64_t)(q - start); };
+
+    while (p < end) {
+        switch (m_state) {
+        case S_String: {
+            size_t run = ScanStringRun(p, (size_t)(end - p));
+            Put(p, run); p += run;
+            if (p == end) break;
+            unsigned char c = *p;
+            if (c == '"') {
+                Put('"'); ++p;
+                if (m_inKey) {
+                    m_state = S_Colon;
+                    if (p < end && *p == ':') { if (m_mode == JsonMode::Pretty) Put((const unsigned char*)": ", 2); else Put(':'); ++p; m_state = S_Value; }
+                }
+                else ValueDone();
+            }
+            else if (c == '\\') { Put('\\'); ++p; m_state = S_Escape; }
+            else if (c < 0x20) return Fail(JsonError::ControlChar, at(p));
+            else { if (!BeginUtf8(c, at(p))) return false; Put((char)c); ++p; }
+            break;
+        }
+        case S_Utf8: {
+            unsigned char c = *p;
+            if (c < m_utf8Lo || c > m_utf8Hi) return Fail(JsonError::BadUtf8, at(p));
+            Put((char)c); ++p;
+            m_utf8Lo = 0x80; m_utf8Hi = 0xBF;
+            if (--m_utf8Left == 0) m_state = S_String;
+            break;
+        }
+        case S_Escape: {
+            unsigned char c = *p;
+            if (c == 'u') { m_hexLeft = 4; m_state = S_Unicode; }
+            else if (c == '"' || c == '\\' || c == '/' || c == 'b' || c == 'f' || c == 'n' || c == 'r' || c == 't') m_state = S_String;
+            else return Fail(JsonError::BadEscape, at(p));
+            Put((char)c); ++p;
+            break;
+        }
+        case S_Unicode: {
+            if (!IsHex(*p)) return Fail(JsonError::BadUnicodeEscape, at(p));
+            Put((char)*p); ++p;
+            if (--m_hexLeft == 0) m_state = S_String;
+            break;
+        }
+        case S_Number: {
+            if (m_num == N_Int || m_num == N_Frac || m_num == N_Exp) {
+                const unsigned char* q = p;
+                while (q < end && *q >= '0' && *q <= '9') ++q;
+                Put(p, (size_t)(q - p)); p = q;
+            }
+            while (p < end) {
+                unsigned char c = *p;
+                bool digit = c >= '0' && c <= '9';
+                bool ok = true;
+                switch (m_num) {
+                case N_Minus:     if (c == '0') m_num = N_Zero; else if (digit) m_num = N_Int; else ok = false; break;
+                case N_Zero:      if (c == '.') m_num = N_FracStart; else if (c == 'e' || c == 'E') m_num = N_ExpStart; else ok = false; break;
+                case N_Int:       if (digit) {} else if (c == '.') m_num = N_FracStart; else if (c == 'e' || c == 'E') m_num = N_ExpStart; else ok = false; break;
+                case N_FracStart: if (digit) m_num = N_Frac; else ok = false; break;
+                case N_Frac:      if (digit) {} else if (c == 'e' || c == 'E') m_num = N_ExpStart; else ok = false; break;
+                case N_ExpStart:  if (digit) m_num = N_Exp; else if (c == '+' || c == '-') m_num = N_ExpSign; else ok = false; break;
+                case N_ExpSign:   if (digit) m_num = N_Exp; else ok = false; break;
+                case N_Exp:       if (!digit) ok = false; break;
+                }
+                if (!ok) {
+                    // a complete number ends at the first foreign byte, which is then re-dispatched
+                    if (m_num == N_Zero || m_num == N_Int || m_num == N_Frac || m_num == N_Exp) { ValueDone(); break; }
+                    return Fail(JsonError::BadNumber, at(p));
+                }
+                Put((char)c); ++p;
+            }
+            break;
+        }
+        case S_Literal: {
+            if ((char)*p != m_literal[m_literalPos]) return Fail(JsonError::BadLiteral, at(p));
+            Put((char)*p); ++p;
+            if (m_literal[++m_literalPos] == '\0') ValueDone();
+            break;
+        }
+        default: {
+            // structural states: skip whitespace first
+            if (IsWs(*p)) {
+                // single separators (", " / ": ") are the common case; only long runs go through SIMD
+                if (*p == ' ' && p + 1 < end && !IsWs(p[1])) ++p;
+                else {
+                uint64_t nl = 0; size_t afterNl = 0;
+                size_t n = SkipWhitespace(p, (size_t)(end - p), nl, afterNl);
+                if (nl) { m_line += nl; m_lineStart = at(p) + afterNl; }
+                p += n;
+                }
+                if (p == end) break;
+            }
+            unsigned char c = *p;
+            uint64_t pos = at(p);
+            switch (m_state) {
+            case S_Value:
+                if (!BeginValue(c, pos)) return false;
+                break;
+            case S_ValueOrClose:
+                if (c == ']') { if (!Close(c, pos)) return false; }
+                else if (!BeginValue(c, pos)) return false;
+                break;
+            case S_KeyOrClose:
+            case S_Key:
+                if (c == '}' && m_state == S_KeyOrClose) { if (!Close(c, pos)) return false; }
+                else if (c == '"') { BreakIfPending(); Put('"'); m_inKey = true; m_state = S_String; }
+                else return Fail(JsonError::UnexpectedChar, pos);
+                break;
+            case S_Colon:
+                if (c != ':') return Fail(JsonError::UnexpectedChar, pos);
+                if (m_mode == JsonMode::Pretty) Put((const unsigned char*)": ", 2); else Put(':');
+                m_state = S_Value;
+                break;
+            case S_CommaOrClose:
+                if (c == ',') {
+                    Put(',');
+                    m_pendingBreak = true;
+                    m_state = m_stack.back() == 'o' ? S_Key : S_Value;
+                }
+                else if (c == '}' || c == ']') { if (!Close(c, pos)) return false; }
+                else return Fail(JsonError::UnexpectedChar, pos);
+                break;
+            case S_Done:
+                return Fail(JsonError::TrailingData, pos);
+            default:
+                break;
+            }
+            ++p;
+            break;
+        }
+        }
+    }
+    m_offset += len;
+    return true;
+}
+
+inline bool JsonStream::Finish() {
+    if (m_error != JsonError::None) return false;
+    if (m_state == S_Number) {
+        if (m_num == N_Zero || m_num == N_Int || m_num == N_Frac || m_num == N_Exp) ValueDone();
+        else return Fail(JsonError::BadNumber, m_offset);
+    }
+    if (m_state != S_Done) return Fail(JsonError::UnexpectedEnd, m_offset);
+    if (m_mode == JsonMode::Pretty) Put('\n');
+    FlushOut();
+    return true;
+}
@@ -0,0 +1,89 @@
+// MappedFile.h — read-only memory mapping of a whole file (Win32 / POSIX)
+// Large files are paged in on demand by the OS, so views over multi-GB files cost no heap memory.
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::filesystem::path& path) {
+        Close();
+#ifdef _WIN32
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER sz{};
+        if (!GetFileSizeEx(m_file, &sz)) { Close(); return false; }
+        m_size = (uint64_t)sz.QuadPart;
+        if (m_size == 0) return true; // empty files cannot be mapped
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping) { Close(); return false; }
+        m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!m_data) { Close(); return false; }
+#else
+        m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (m_fd < 0) return false;
+        struct stat st {};
+        if (fstat(m_fd, &st) != 0) { Close(); return false; }
+        m_size = (uint64_t)st.st_size;
+        if (m_size == 0) return true;
+        void* p = mmap(nullptr, (size_t)m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (p == MAP_FAILED) { Close(); return false; }
+        m_data = (const unsigned char*)p;
+#endif
+        return true;
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_mapping = nullptr; m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data) munmap((void*)m_data, (size_t)m_size);
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+        m_data = nullptr; m_size = 0;
+    }
+
+    // Hint for one-pass scans (index builds); the view itself stays valid either way.
+    void AdviseSequential() const {
+#ifndef _WIN32
+        if (m_data) madvise((void*)m_data, (size_t)m_size, MADV_SEQUENTIAL);
+#endif
+    }
+
+    bool IsOpen() const { return m_data != nullptr || (m_size == 0 && IsHandleOpen()); }
+    const unsigned char* Data() const { return m_data; }
+    uint64_t Size() const { return m_size; }
+
+private:
+    const unsigned char* m_data = nullptr;
+    uint64_t m_size = 0;
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+    bool IsHandleOpen() const { return m_file != INVALID_HANDLE_VALUE; }
+#else
+    int m_fd = -1;
+    bool IsHandleOpen() const { return m_fd >= 0; }
+#endif
+};
@@ -0,0 +1,75 @@
+// Simd.h — small portable helpers shared by the txtPlus scanners (JSON, CSV, Hex)
+// SSE2 is baseline on x64 (MSVC and GCC/Clang); other targets fall back to scalar loops.
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define TXT_SIMD_SSE2 1
+#include <emmintrin.h>
+#else
+#define TXT_SIMD_SSE2 0
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Index of lowest set bit (mask != 0)
+static inline unsigned SimdCtz(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long idx; _BitScanForward(&idx, mask); return (unsigned)idx;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+// Index of highest set bit (mask != 0)
+static inline unsigned SimdBsr(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long idx; _BitScanReverse(&idx, mask); return (unsigned)idx;
+#else
+    return 31u - (unsigned)__builtin_clz(mask);
+#endif
+}
+
+static inline unsigned SimdCtz64(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx; _BitScanForward64(&idx, mask); return (unsigned)idx;
+#elif defined(_MSC_VER)
+    return (uint32_t)mask ? SimdCtz((uint32_t)mask) : 32u + SimdCtz((uint32_t)(mask >> 32));
+#else
+    return (unsigned)__builtin_ctzll(mask);
+#endif
+}
+
+// Inclusive prefix XOR: bit i = xor of bits 0..i (quote parity -> "inside quotes" mask)
+static inline uint64_t SimdPrefixXor(uint64_t x) {
+    x ^= x << 1; x ^= x << 2; x ^= x << 4; x ^= x << 8; x ^= x << 16; x ^= x << 32;
+    return x;
+}
+
+// 64-bit mask of bytes equal to c in p[0..63]
+static inline uint64_t SimdEqMask64(const unsigned char* p, unsigned char c) {
+#if TXT_SIMD_SSE2
+    const __m128i v = _mm_set1_epi8((char)c);
+    uint64_t m0 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), v));
+    uint64_t m1 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 16)), v));
+    uint64_t m2 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 32)), v));
+    uint64_t m3 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 48)), v));
+    return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+#else
+    uint64_t m = 0;
+    for (int i = 0; i < 64; ++i) if (p[i] == c) m |= 1ull << i;
+    return m;
+#endif
+}
+
+static inline unsigned SimdPopcount(uint32_t mask) {
+#ifdef _MSC_VER
+    return (unsigned)__popcnt(mask);
+#else
+    return (unsigned)__builtin_popcount(mask);
+#endif
+}
@@ -0,0 +1,281 @@
+// UndoHistory.h — editor-level undo/redo, independent of the RichEdit control's own history
+// - One step = one replacement: position, removed text, inserted text (UTF-16 as in the control)
+// - Step text lives in an append-only arena of 256 KB chunks; steps only hold chunk references
+// - Consecutive typing (and backspace / delete runs) merge into one step until a line break
+// - Sealed chunks older than the newest two are deflated (zlib, if available) and inflated on demand
+// - A memory cap evicts the oldest steps first; a chunk is released once no step references it.
+//   The newest step is always kept, even when it alone exceeds the cap (a huge paste stays undoable)
+// Undo/redo cost is proportional to the size of the edit (plus at most one chunk inflate).
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#ifndef TXT_HAVE_ZLIB
+#if __has_include(<zlib.h>)
+#define TXT_HAVE_ZLIB 1
+#else
+#define TXT_HAVE_ZLIB 0
+#endif
+#endif
+#if TXT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+enum class UndoKind { Typing, Delete, Other };
+
+// Undo: the range [pos, pos + inserted.size()) currently holds 'inserted' and gets 'removed' back.
+// Redo: the range [pos, pos + removed.size()) holds 'removed' and gets 'inserted' again.
+struct UndoEdit {
+    size_t pos = 0;
+    std::wstring removed;
+    std::wstring inserted;
+};
+
+class UndoHistory {
+public:
+    explicit UndoHistory(size_t memoryCap = 64u << 20) : m_cap(memoryCap) {}
+
+    void SetMemoryCap(size_t bytes) { m_cap = bytes; Enforce(); }
+    size_t MemoryCap() const { return m_cap; }
+
+    // Record that [pos, pos + removedLen) was replaced by inserted. Drops any redo steps.
+    void Record(size_t pos, const wchar_t* removed, size_t removedLen, const wchar_t* inserted, size_t insertedLen, UndoKind kind) {
+        if (removedLen == 0 && insertedLen == 0) return;
+        DropRedo();
+        size_t bytes = (removedLen + insertedLen) * sizeof(wchar_t);
+        if (bytes > UINT32_MAX) { Clear(); return; } // spans are 32-bit; older steps could not be replayed without this one
+        if (TryMerge(pos, removed, removedLen, inserted, insertedLen, kind)) { Enforce(); return; }
+        Step s;
+        s.pos = pos; s.kind = kind;
+        s.removed = Store(removed, removedLen);
+        s.inserted = Store(inserted, insertedLen);
+        m_steps.push_back(s);
+        m_cursor = m_steps.size();
+        m_mergeOpen = (kind == UndoKind::Typing || kind == UndoKind::Delete) && !HasBreak(inserted, insertedLen);
+        Enforce();
+    }
+
+    // Next edit starts a new step (caret moved, focus lost, ...).
+    void BreakMerge() { m_mergeOpen = false; }
+
+    bool CanUndo() const { return m_cursor > 0; }
+    bool CanRedo() const { return m_cursor < m_steps.size(); }
+
+    bool Undo(UndoEdit& out) {
+        if (!CanUndo()) return false;
+        Load(m_steps[--m_cursor], out);
+        m_mergeOpen = false;
+        return true;
+    }
+    bool Redo(UndoEdit& out) {
+        if (!CanRedo()) return false;
+        Load(m_steps[m_cursor++], out);
+        m_mergeOpen = false;
+        return true;
+    }
+
+    void Clear() {
+        m_steps.clear(); m_chunks.clear();
+        m_cursor = 0; m_firstChunk = 0; m_chunkBytes = 0;
+        m_cacheChunk = UINT32_MAX; m_cache.clear(); m_cache.shrink_to_fit();
+        m_mergeOpen = false;
+    }
+
+    size_t StepCount() const { return m_steps.size(); }
+    size_t MemoryUsed() const { return m_chunkBytes + m_cache.capacity() + m_steps.size() * sizeof(Step); }
+    // Arena split of MemoryUsed(): chunks held as they are / deflated (capacity, as counted for the cap)
+    size_t ArenaBytes() const { size_t n = 0; for (auto const& c : m_chunks) n += c.raw.capacity(); return n; }
+    size_t PackedBytes() const { size_t n = 0; for (auto const& c : m_chunks) n += c.packed.capacity(); return n; }
+
+private:
+    static constexpr uint32_t kChunk = 256 * 1024;     // arena chunk size in bytes
+    static constexpr uint32_t kKeepRaw = 2;            // newest sealed chunks kept uncompressed
+    static constexpr uint32_t kMergeLimit = 4096;      // max chars merged into one typing/delete step
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    struct Span { uint32_t chunk = kNone, offset = 0, length = 0; }; // length in bytes
+    struct Step { uint64_t pos = 0; Span removed, inserted; UndoKind kind = UndoKind::Other; };
+    struct Chunk {
+        std::vector<uint8_t> raw;     // live bytes (empty once packed)
+        std::vector<uint8_t> packed;  // deflated raw (sealed, old chunks)
+        uint32_t rawSize = 0;
+        uint32_t refs = 0;            // spans pointing into this chunk
+        bool sealed = false;
+    };
+
+    size_t m_cap;
+    std::deque<Step> m_steps;
+    size_t m_cursor = 0;                  // steps [0, m_cursor) are undoable, the rest redoable
+    std::deque<Chunk> m_chunks;           // m_chunks[i] has id m_firstChunk + i
+    uint32_t m_firstChunk = 0;
+    size_t m_chunkBytes = 0;              // raw + packed capacity of all chunks
+    uint32_t m_cacheChunk = kNone;        // inflated copy of one packed chunk
+    std::vector<uint8_t> m_cache;
+    bool m_mergeOpen = false;
+
+    Chunk& ChunkAt(uint32_t id) { return m_chunks[id - m_firstChunk]; }
+    uint32_t OpenChunkId() const { return m_chunks.empty() || m_chunks.back().sealed ? kNone : m_firstChunk + (uint32_t)m_chunks.size() - 1; }
+
+    static bool HasBreak(const wchar_t* s, size_t n) {
+        for (size_t i = 0; i < n; ++i) if (s[i] == L'\r' || s[i] == L'\n') return true;
+        return false;
+    }
+
+    // True when span is the last allocation of the open chunk (can grow / shrink in place).
+    bool AtTail(const Span& sp) const {
+        if (sp.chunk == kNone || sp.chunk != OpenChunkId()) return false;
+        return sp.offset + sp.length == m_chunks.back().raw.size();
+    }
+
+    Span Store(const wchar_t* text, size_t len) {
+        Span sp;
+        if (len == 0) return sp;
+        uint32_t bytes = (uint32_t)(len * sizeof(wchar_t));
+        uint32_t open = OpenChunkId();
+        if (open == kNone || m_chunks.back().raw.capacity() - m_chunks.back().raw.size() < bytes) {
+            Seal();
+            Chunk c;
+            c.raw.reserve(std::max(kChunk, bytes));
+            m_chunkBytes += c.raw.capacity();
+            m_chunks.push_back(std::move(c));
+        }
+        Chunk& c = m_chunks.back();
+        sp.chunk = m_firstChunk + (uint32_t)m_chunks.size() - 1;
+        sp.offset = (uint32_t)c.raw.size();
+        sp.length = bytes;
+        c.raw.insert(c.raw.end(), (const uint8_t*)text, (const uint8_t*)text + bytes);
+        c.refs++;
+        return sp;
+    }
+
+    void Seal() {
+        if (OpenChunkId() == kNone) return;
+        m_chunks.back().sealed = true;
+        if (m_chunks.size() > kKeepRaw) Pack(m_chunks[m_chunks.size() - 1 - kKeepRaw]);
+    }
+
+    void Pack(Chunk& c) {
+#if TXT_HAVE_ZLIB
+        if (c.raw.empty() || c.refs == 0) return;
+        uLongf packedLen = compressBound((uLong)c.raw.size());
+        std::vector<uint8_t> packed(packedLen);
+        if (compress2(packed.data(), &packedLen, c.raw.data(), (uLong)c.raw.size(), 1) != Z_OK || packedLen >= c.raw.size()) return;
+        packed.resize(packedLen); packed.shrink_to_fit();
+        m_chunkBytes -= c.raw.capacity();
+        c.rawSize = (uint32_t)c.raw.size();
+        std::vector<uint8_t>().swap(c.raw);
+        c.packed = std::move(packed);
+        m_chunkBytes += c.packed.capacity();
+#else
+        (void)c;
+#endif
+    }
+
+    const uint8_t* Bytes(const Span& sp) {
+        Chunk& c = ChunkAt(sp.chunk);
+        if (!c.raw.empty()) return c.raw.data() + sp.offset;
+#if TXT_HAVE_ZLIB
+        if (m_cacheChunk != sp.chunk) {
+            m_cache.resize(c.rawSize);
+            uLongf len = c.rawSize;
+            uncompress(m_cache.data(), &len, c.packed.data(), (uLong)c.packed.size());
+            m_cacheChunk = sp.chunk;
+        }
+#endif
+        return m_cache.data() + sp.offset;
+    }
+
+    std::wstring Text(const Span& sp) {
+        std::wstring s;
+        if (sp.chunk == kNone) return s;
+        s.resize(sp.length / sizeof(wchar_t));
+        memcpy(&s[0], Bytes(sp), sp.length);
+        return s;
+    }
+
+    void Load(const Step& s, UndoEdit& out) {
+        out.pos = (size_t)s.pos;
+        out.removed = Text(s.removed);
+        out.inserted = Text(s.inserted);
+    }
+
+    void Release(const Span& sp) {
+        if (sp.chunk == kNone) return;
+        Chunk& c = ChunkAt(sp.chunk);
+        if (AtTail(sp)) c.raw.resize(sp.offset); // newest allocation: give the space back
+        if (--c.refs == 0) {
+            if (sp.chunk == OpenChunkId()) c.raw.clear();
+            else {
+                m_chunkBytes -= c.raw.capacity() + c.packed.capacity();
+                std::vector<uint8_t>().swap(c.raw); std::vector<uint8_t>().swap(c.packed);
+                if (m_cacheChunk == sp.chunk) m_cacheChunk = kNone;
+            }
+        }
+        while (!m_chunks.empty() && m_chunks.front().refs == 0 && (m_chunks.size() > 1 || m_chunks.front().sealed)) {
+            m_chunkBytes -= m_chunks.front().raw.capacity() + m_chunks.front().packed.capacity();
+            m_chunks.pop_front();
+            m_firstChunk++;
+        }
+    }
+
+    void DropRedo() {
+        while (m_steps.size() > m_cursor) {
+            // newest first, inserted was allocated after removed: tail space is reclaimed in order
+            Release(m_steps.back().inserted);
+            Release(m_steps.back().removed);
+            m_steps.pop_back();
+        }
+    }
+
+    void Enforce() {
+        while (!m_steps.empty() && MemoryUsed() > m_cap) {
+            if (m_cursor > 1) {
+                Release(m_steps.front().removed);
+                Release(m_steps.front().inserted);
+                m_steps.pop_front();
+                m_cursor--;
+            }
+            else if (m_steps.size() > m_cursor) DropRedo();
+            else break; // only the newest undo step is left: it stays even above the cap
+        }
+        if (m_steps.empty()) m_mergeOpen = false;
+    }
+
+    bool TryMerge(size_t pos, const wchar_t* removed, size_t removedLen, const wchar_t* inserted, size_t insertedLen, UndoKind kind) {
+        if (!m_mergeOpen || m_steps.empty() || m_steps.back().kind != kind) return false;
+        Step& p = m_steps.back();
+        const size_t wc = sizeof(wchar_t);
+        if (kind == UndoKind::Typing && removedLen == 0 && !HasBreak(inserted, insertedLen)) {
+            // typing continues right after the previous insertion
+            size_t len = p.inserted.length / wc;
+            if (pos != p.pos + len || len + insertedLen > kMergeLimit) return false;
+            if (len == 0 || !AtTail(p.inserted)) return false;
+            std::vector<uint8_t>& raw = m_chunks.back().raw;
+            if (raw.capacity() - raw.size() < insertedLen * wc) return false;
+            raw.insert(raw.end(), (const uint8_t*)inserted, (const uint8_t*)(inserted + insertedLen));
+            p.inserted.length += (uint32_t)(insertedLen * wc);
+            return true;
+        }
+        if (kind == UndoKind::Delete && insertedLen == 0 && p.inserted.chunk == kNone && removedLen > 0) {
+            size_t len = p.removed.length / wc;
+            bool backspace = pos + removedLen == p.pos, forward = pos == p.pos;
+            if (!(backspace || forward) || len + removedLen > kMergeLimit || !AtTail(p.removed)) return false;
+            std::vector<uint8_t>& raw = m_chunks.back().raw;
+            if (raw.capacity() - raw.size() < removedLen * wc) return false;
+            if (forward) raw.insert(raw.end(), (const uint8_t*)removed, (const uint8_t*)(removed + removedLen));
+            else {
+                // the new text precedes the run: shift the (bounded) run to make room
+                raw.insert(raw.begin() + p.removed.offset, (const uint8_t*)removed, (const uint8_t*)(removed + removedLen));
+                p.pos = pos;
+            }
+            p.removed.length += (uint32_t)(removedLen * wc);
+            return true;
+        }
+        return false;
+    }
+};
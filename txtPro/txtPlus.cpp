@@ -6,7 +6,12 @@
 // - Simple syntax highlighting for .cpp/.h and .html (keywords, strings, comments)
 // - Zoom via Ctrl+MouseWheel, Font selection dialog, Statusbar with line/col
 // - UTF-8 handling for plain text, RTF pass-through for .rtf files
-// Build: Visual Studio (recommended) or g++ with -municode. Link libs as before.
+// - Streaming JSON validate / pretty-print / minify on a worker thread (JsonStream.h)
+// - Table view for .csv/.tsv (virtual ListView over a memory-mapped row index, CsvIndex.h)
+// - Hex view/editor for binary files (NUL bytes in the first 8 KB), mapped + patch overlay (HexDocument.h)
+// - Transparent open/save of gzip/zstd compressed text, decoded on a worker thread (Codec.h)
+// - Own undo/redo history per tab (merged typing, compressed, memory-capped; UndoHistory.h)
+// Build: Visual Studio (recommended) or g++ with -municode. Link libs as before (+ zlib/zstd if available).
 
 #define UNICODE
 #define _UNICODE
@@ -26,6 +31,16 @@
 #include <thread>
 #include <algorithm>   // <-- neu: std::min/std::max
 #include <cwctype>     // <-- neu: iswalpha/iswalnum für Wide-char Tests
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include "JsonStream.h"
+#include "CsvIndex.h"
+#include "HexDocument.h"
+#include "Codec.h"
+#include "UndoHistory.h"
 
 #pragma comment(lib, "comctl32.lib")
 #pragma comment(lib, "comdlg32.lib")
@@ -43,10 +58,14 @@ static const wchar_t* APP_NAME = L"WinNotePlus Pro";
 static const wchar_t* RICH_CLASS = L"RICHEDIT50W"; // use Msftedit
 
 enum IDs {
-    ID_FILE_OPEN = 4001, ID_FILE_SAVE, ID_FILE_SAVEAS, ID_FILE_CLOSE,
+    ID_FILE_OPEN = 4001, ID_FILE_SAVE, ID_FILE_SAVEAS, ID_FILE_CLOSE, ID_FILE_COMPRESSION,
+    ID_EDIT_UNDO = 4101, ID_EDIT_REDO, ID_EDIT_UNDO_LIMIT,
     ID_TABCONTROL = 5000, ID_TREE = 6000,
     ID_TIMER_AUTOSAVE = 7001, ID_TIMER_HIGHLIGHT = 7002,
-    ID_VIEW_FONT = 8001
+    ID_VIEW_FONT = 8001, ID_VIEW_CSV_FILTER, ID_VIEW_HEX_GOTO, ID_VIEW_HEX_FIND, ID_VIEW_HEX_FINDNEXT,
+    ID_JSON_VALIDATE = 8101, ID_JSON_PRETTY, ID_JSON_MINIFY,
+    WM_APP_JSON_PROGRESS = WM_APP + 1, WM_APP_JSON_DONE, WM_APP_CSV_PROGRESS, WM_APP_CSV_VIEW, WM_APP_JSON_OUTPUT,
+    WM_APP_CODEC_PROGRESS, WM_APP_CODEC_OUTPUT, WM_APP_CODEC_DONE
 };
 
 struct Doc {
@@ -55,12 +74,31 @@ struct Doc {
     bool modified = false;    // changed since last save
     int zoom = 100;           // percent
     bool isRtf = false;       // RTF file
+    Compression compression = Compression::None; // gzip/zstd source: saved back the same way
+    bool damaged = false;     // compressed source did not decode to the end: read-only, never saved over it
+    struct CodecJob* loading = nullptr; // compressed source still decoding: read-only until WM_APP_CODEC_DONE
+    std::shared_ptr<struct EditUndo> undo;       // editor-level undo (RichEdit's own is disabled)
     std::chrono::steady_clock::time_point lastEdit;
+    // table view mode (.csv/.tsv): hEdit is a virtual ListView, cells come from the mapped file
+    std::shared_ptr<CsvTable> csv;
+    std::vector<uint32_t> csvRows;   // current filter/sort permutation (only if csvCustomView)
+    bool csvCustomView = false;
+    bool csvColumns = false;         // header columns inserted
+    int csvSortCol = -1; bool csvSortAsc = true;
+    size_t csvFilterCol = SIZE_MAX; std::string csvFilter;
+    unsigned csvViewSeq = 0;         // newest requested view job
+    // hex view mode (binary files): hEdit is a WinNotePlusHex window
+    std::shared_ptr<struct HexView> hex;
 };
 
 static std::vector<Doc> g_docs;
 static int g_current = -1; // index into g_docs
 
+static int FindDocByEdit(HWND h) {
+	for (int i = 0; i < (int)g_docs.size(); ++i) if (g_docs[i].hEdit == h) return i;
+	return -1;
+}
+
 // Utility: UTF-8 <-> wstring
 static std::wstring Utf8ToW(const std::string& s) {
     if (s.empty()) return L"";
@@ -119,6 +157,124 @@ static DWORD CALLBACK RichEdit_StreamOutCallback(DWORD_PTR dwCookie, LPBYTE pbBu
 	return 0;
 }
 
+// Plain text as UTF-8 directly from/to the control (no intermediate wstring copy)
+static const WPARAM SF_UTF8TEXT = SF_TEXT | SF_USECODEPAGE | (CP_UTF8 << 16);
+static bool StreamOutUtf8(HWND hEdit, std::vector<unsigned char>& out) {
+	StreamCookieOut sc{ &out };
+	EDITSTREAM es{}; es.dwCookie = (DWORD_PTR)&sc; es.pfnCallback = RichEdit_StreamOutCallback;
+	SendMessageW(hEdit, EM_STREAMOUT, SF_UTF8TEXT, (LPARAM)&es);
+	return es.dwError == 0;
+}
+static void StreamInUtf8(HWND hEdit, const std::vector<unsigned char>& data) {
+	StreamCookieIn sc{ &data, 0 };
+	EDITSTREAM es{}; es.dwCookie = (DWORD_PTR)&sc; es.pfnCallback = RichEdit_StreamInCallback;
+	SendMessageW(hEdit, EM_STREAMIN, SF_UTF8TEXT, (LPARAM)&es);
+}
+
+// Worker -> UI text: the worker pushes UTF-8 and waits while kTextQueueMax chunks are queued; the UI
+// thread appends what is queued to a RichEdit (EM_STREAMIN) when the posted message arrives. Each
+// EM_STREAMIN converts on its own, so a chunk never ends inside a UTF-8 sequence; the cut bytes are
+// carried over to the next push.
+static const size_t kTextQueueMax = 16;
+struct TextQueue {
+	std::mutex mutex;
+	std::condition_variable cv;             // worker waits here while chunks is full
+	std::deque<std::string> chunks;         // complete UTF-8 sequences only
+	std::string tail;                       // worker: bytes of a sequence cut at the end of a push
+	bool posted = false;                    // a drain message is pending
+	uint64_t bytes = 0;
+	std::atomic<bool> cancel{ false };
+};
+
+static void TextQueueCancel(TextQueue& q) {
+	std::lock_guard<std::mutex> lk(q.mutex);
+	q.cancel = true;
+	q.cv.notify_all();
+}
+
+// Worker side; posts msg (lParam = job) when the UI has nothing pending. last: nothing follows, an
+// incomplete sequence at the end is passed on as it is.
+static void TextQueuePush(TextQueue& q, const char* p, size_t n, UINT msg, LPARAM job, bool last = false) {
+	std::string chunk = std::move(q.tail);
+	chunk.append(p, n);
+	size_t cut = chunk.size(), back = 0;
+	if (!last) {
+		while (cut > 0 && back < 3 && ((unsigned char)chunk[cut - 1] & 0xC0) == 0x80) { --cut; ++back; }
+		if (cut > 0) {
+			unsigned char lead = (unsigned char)chunk[cut - 1];
+			size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+			cut = back + 1 >= need ? chunk.size() : cut - 1;
+		}
+	}
+	q.tail.assign(chunk, cut, std::string::npos);
+	chunk.resize(cut);
+	if (chunk.empty()) return;
+	std::unique_lock<std::mutex> lk(q.mutex);
+	q.cv.wait(lk, [&q]() { return q.chunks.size() < kTextQueueMax || q.cancel; });
+	if (q.cancel) return;
+	q.bytes += chunk.size();
+	q.chunks.push_back(std::move(chunk));
+	if (!q.posted) { q.posted = true; PostMessageW(g_hMain, msg, 0, job); }
+}
+
+// UI side, on the posted message: false if there is nothing to append (or the queue is cancelled)
+static bool TextQueueTake(TextQueue& q) {
+	std::lock_guard<std::mutex> lk(q.mutex);
+	q.posted = false;
+	return !q.cancel && !q.chunks.empty();
+}
+
+struct TextQueueCookie {
+	TextQueue* q;
+	std::string chunk;
+	size_t pos;
+};
+static DWORD CALLBACK TextQueue_StreamInCallback(DWORD_PTR dwCookie, LPBYTE pbBuff, LONG cb, LONG* pcb) {
+	TextQueueCookie* c = (TextQueueCookie*)dwCookie;
+	LONG n = 0;
+	while (n < cb) {
+		if (c->pos == c->chunk.size()) {
+			std::lock_guard<std::mutex> lk(c->q->mutex);
+			if (c->q->chunks.empty()) break;
+			c->chunk = std::move(c->q->chunks.front());
+			c->q->chunks.pop_front();
+			c->pos = 0;
+			c->q->cv.notify_one();
+		}
+		size_t k = std::min<size_t>(c->chunk.size() - c->pos, (size_t)(cb - n));
+		memcpy(pbBuff + n, c->chunk.data() + c->pos, k);
+		c->pos += k; n += (LONG)k;
+	}
+	*pcb = n; // 0 ends this EM_STREAMIN; the next posted message continues
+	return 0;
+}
+
+// UI side: appends every queued chunk at the end of hEdit
+static void TextQueueDrain(TextQueue& q, HWND hEdit) {
+	CHARRANGE end{ -1, -1 };
+	SendMessageW(hEdit, EM_EXSETSEL, 0, (LPARAM)&end);
+	TextQueueCookie c{ &q, std::string(), 0 };
+	EDITSTREAM es{}; es.dwCookie = (DWORD_PTR)&c; es.pfnCallback = TextQueue_StreamInCallback;
+	SendMessageW(hEdit, EM_STREAMIN, SF_UTF8TEXT | SFF_SELECTION, (LPARAM)&es);
+}
+
+// Compressed text: decoded on a worker thread and appended through a TextQueue (CodecWorker below);
+// saving encodes piecewise inside the EM_STREAMOUT callback, so only the control holds the text.
+static int g_compressLevel = 0;   // 0 = codec default; zstd 1..19 (multi-threaded), gzip 1..9
+static DWORD CALLBACK Codec_StreamOutCallback(DWORD_PTR dwCookie, LPBYTE pbBuff, LONG cb, LONG* pcb) {
+	CodecWriter* w = (CodecWriter*)dwCookie;
+	*pcb = cb;
+	return w->Write(pbBuff, (size_t)cb) ? 0 : 1;
+}
+static bool StreamOutCompressed(HWND hEdit, const std::wstring& path, Compression kind) {
+	CodecWriter writer;
+	if (!writer.Open(path, kind, g_compressLevel)) return false;
+	SendMessageW(g_hStatus, SB_SETTEXT, 0, (LPARAM)L"Komprimiere..."); UpdateWindow(g_hStatus);
+	EDITSTREAM es{}; es.dwCookie = (DWORD_PTR)&writer; es.pfnCallback = Codec_StreamOutCallback;
+	SendMessageW(hEdit, EM_STREAMOUT, SF_UTF8TEXT, (LPARAM)&es);
+	return es.dwError == 0 && writer.Finish();
+}
+
 // Helpers to manage Tab captions
 static void UpdateTabCaption(int idx) {
     if (idx < 0 || idx >= (int)g_docs.size()) return;
@@ -134,16 +290,624 @@ static void UpdateAllTabs() {
     for (int i = 0; i < (int)g_docs.size(); ++i) UpdateTabCaption(i);
 }
 
+// Tiny modal input box (the project has no dialog resources)
+static bool PromptText(HWND owner, const wchar_t* title, std::wstring& value) {
+	struct PromptState { HWND hEdit; bool ok; bool done; std::wstring text; };
+	static bool registered = false;
+	if (!registered) {
+		WNDCLASSEXW wc{ sizeof(wc) }; wc.hInstance = g_hInst; wc.lpszClassName = L"WinNotePlusPrompt";
+		wc.hCursor = LoadCursor(NULL, IDC_ARROW); wc.hbrBackground = (HBRUSH)(COLOR_BTNFACE + 1);
+		wc.lpfnWndProc = [](HWND h, UINT msg, WPARAM w, LPARAM l)->LRESULT {
+			PromptState* st = (PromptState*)GetWindowLongPtrW(h, GWLP_USERDATA);
+			if (st && msg == WM_COMMAND && (LOWORD(w) == IDOK || LOWORD(w) == IDCANCEL)) {
+				if (LOWORD(w) == IDOK) {
+					int len = GetWindowTextLengthW(st->hEdit);
+					st->text.resize(len); GetWindowTextW(st->hEdit, &st->text[0], len + 1);
+					st->ok = true;
+				}
+				st->done = true; return 0;
+			}
+			if (st && msg == WM_CLOSE) { st->done = true; return 0; }
+			return DefWindowProcW(h, msg, w, l);
+		};
+		RegisterClassExW(&wc); registered = true;
+	}
+	RECT rc; GetWindowRect(owner, &rc);
+	int w = 380, hgt = 130;
+	HWND dlg = CreateWindowExW(WS_EX_DLGMODALFRAME, L"WinNotePlusPrompt", title, WS_POPUP | WS_CAPTION | WS_SYSMENU,
+		(rc.left + rc.right - w) / 2, (rc.top + rc.bottom - hgt) / 2, w, hgt, owner, nullptr, g_hInst, nullptr);
+	HWND hEdit = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", value.c_str(), WS_CHILD | WS_VISIBLE | WS_TABSTOP | ES_AUTOHSCROLL,
+		10, 10, w - 36, 24, dlg, (HMENU)100, g_hInst, nullptr);
+	CreateWindowExW(0, L"BUTTON", L"OK", WS_CHILD | WS_VISIBLE | WS_TABSTOP | BS_DEFPUSHBUTTON, w - 196, 46, 80, 26, dlg, (HMENU)IDOK, g_hInst, nullptr);
+	CreateWindowExW(0, L"BUTTON", L"Abbrechen", WS_CHILD | WS_VISIBLE | WS_TABSTOP, w - 106, 46, 80, 26, dlg, (HMENU)IDCANCEL, g_hInst, nullptr);
+	PromptState st{ hEdit, false, false };
+	SetWindowLongPtrW(dlg, GWLP_USERDATA, (LONG_PTR)&st);
+	EnableWindow(owner, FALSE); ShowWindow(dlg, SW_SHOW); SetFocus(hEdit);
+	SendMessageW(hEdit, EM_SETSEL, 0, -1);
+	MSG msg; bool quit = false;
+	while (!st.done) {
+		if (GetMessageW(&msg, nullptr, 0, 0) <= 0) { quit = true; break; }
+		if (!IsDialogMessageW(dlg, &msg)) { TranslateMessage(&msg); DispatchMessageW(&msg); }
+	}
+	EnableWindow(owner, TRUE); DestroyWindow(dlg); SetForegroundWindow(owner);
+	if (quit) PostQuitMessage((int)msg.wParam);
+	if (st.ok) value = st.text;
+	return st.ok;
+}
+
+// CSV/TSV table view: the row index is built on a worker thread and published in steps
+// (WM_APP_CSV_PROGRESS); the ListView is LVS_OWNERDATA so only visible cells are parsed.
+static void DoLayout();
+static void UpdateStatus();
+
+static bool IsTablePath(const std::wstring& path) {
+	return !path.empty() && (PathMatchSpecW(path.c_str(), L"*.csv") || PathMatchSpecW(path.c_str(), L"*.tsv"));
+}
+
+static int FindCsvDoc(const CsvTable* t) {
+	for (int i = 0; i < (int)g_docs.size(); ++i) if (g_docs[i].csv.get() == t) return i;
+	return -1;
+}
+
+static uint64_t CsvItemCount(const Doc& d) {
+	if (d.csvCustomView) return d.csvRows.size();
+	uint64_t rows = d.csv->RowCount();
+	return rows > 1 ? rows - 1 : 0; // row 0 is the header
+}
+
+// Add a non-RichEdit document (table/hex view) as new current tab
+static int AttachViewDoc(const Doc& d) {
+	g_docs.push_back(d);
+	int idx = (int)g_docs.size() - 1;
+	wchar_t caption[256]; swprintf_s(caption, L"%s", PathFindFileNameW(d.path.c_str()));
+	TCITEM tie{}; tie.mask = TCIF_TEXT; tie.pszText = caption;
+	TabCtrl_InsertItem(g_hTabs, idx, &tie);
+	TabCtrl_SetCurSel(g_hTabs, idx);
+	for (int i = 0; i < (int)g_docs.size(); ++i) ShowWindow(g_docs[i].hEdit, i == idx ? SW_SHOW : SW_HIDE);
+	g_current = idx;
+	UpdateAllTabs(); DoLayout();
+	return idx;
+}
+
+static int CreateCsvDoc(const std::wstring& path) {
+	auto table = std::make_shared<CsvTable>();
+	if (!table->Open(path)) return -1;
+	HWND hList = CreateWindowExW(0, WC_LISTVIEWW, L"",
+		WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_OWNERDATA | LVS_SHOWSELALWAYS,
+		0, 0, 0, 0, g_hTabs, nullptr, g_hInst, nullptr);
+	ListView_SetExtendedListViewStyle(hList, LVS_EX_FULLROWSELECT | LVS_EX_GRIDLINES | LVS_EX_DOUBLEBUFFER);
+
+	Doc d; d.hEdit = hList; d.path = path; d.csv = table;
+	int idx = AttachViewDoc(d);
+
+	std::thread([table]() {
+		table->BuildIndex([table](uint64_t, uint64_t) { PostMessageW(g_hMain, WM_APP_CSV_PROGRESS, 0, (LPARAM)table.get()); });
+	}).detach();
+	return idx;
+}
+
+static void CsvProgress(const CsvTable* t) {
+	int idx = FindCsvDoc(t);
+	if (idx < 0) return;
+	Doc& d = g_docs[idx];
+	if (!d.csvColumns && t->RowCount() > 0) {
+		std::vector<CsvField> hdr; t->ParseRow(0, hdr);
+		for (int c = 0; c < (int)hdr.size(); ++c) {
+			std::wstring name = Utf8ToW(t->FieldText(hdr[c]));
+			LVCOLUMNW col{}; col.mask = LVCF_TEXT | LVCF_WIDTH; col.cx = 140; col.pszText = (LPWSTR)name.c_str();
+			ListView_InsertColumn(d.hEdit, c, &col);
+		}
+		d.csvColumns = true;
+	}
+	if (!d.csvCustomView) ListView_SetItemCountEx(d.hEdit, (int)std::min<uint64_t>(CsvItemCount(d), INT_MAX), LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+	if (idx == g_current) UpdateStatus();
+}
+
+static void CsvGetDispInfo(const Doc& d, NMLVDISPINFOW* di) {
+	if (!(di->item.mask & LVIF_TEXT) || di->item.cchTextMax <= 0) return;
+	di->item.pszText[0] = 0;
+	if (di->item.iItem < 0 || (uint64_t)di->item.iItem >= CsvItemCount(d)) return;
+	uint64_t row = d.csvCustomView ? d.csvRows[di->item.iItem] : (uint64_t)di->item.iItem + 1;
+	// the ListView asks cell by cell: keep the last parsed row
+	static const CsvTable* cacheTable = nullptr;
+	static uint64_t cacheRow = UINT64_MAX;
+	static std::vector<CsvField> cacheFields;
+	if (cacheTable != d.csv.get() || cacheRow != row) {
+		d.csv->ParseRow(row, cacheFields);
+		cacheTable = d.csv.get(); cacheRow = row;
+	}
+	if ((size_t)di->item.iSubItem >= cacheFields.size()) return;
+	std::wstring w = Utf8ToW(d.csv->FieldText(cacheFields[di->item.iSubItem]));
+	wcsncpy_s(di->item.pszText, di->item.cchTextMax, w.c_str(), _TRUNCATE);
+}
+
+// Filter and sort are recomputed from file order on a worker; stale results are dropped via csvViewSeq.
+struct CsvViewJob {
+	std::shared_ptr<CsvTable> table;
+	unsigned seq = 0;
+	int sortCol = -1; bool ascending = true;
+	size_t filterCol = SIZE_MAX; std::string filter;
+	std::vector<uint32_t> rows;
+};
+
+static void StartCsvView(int idx) {
+	Doc& d = g_docs[idx];
+	if (!d.csv->Complete()) { MessageBeep(MB_ICONWARNING); return; }
+	CsvViewJob* job = new CsvViewJob();
+	job->table = d.csv; job->seq = ++d.csvViewSeq;
+	job->sortCol = d.csvSortCol; job->ascending = d.csvSortAsc;
+	job->filterCol = d.csvFilterCol; job->filter = d.csvFilter;
+	SendMessageW(g_hStatus, SB_SETTEXT, 0, (LPARAM)L"Tabelle wird sortiert/gefiltert...");
+	std::thread([job]() {
+		job->rows = job->table->IdentityView();
+		if (!job->filter.empty()) job->rows = job->table->FilteredView(job->rows, job->filterCol, job->filter);
+		if (job->sortCol >= 0) job->rows = job->table->SortedView(job->rows, (size_t)job->sortCol, job->ascending);
+		PostMessageW(g_hMain, WM_APP_CSV_VIEW, 0, (LPARAM)job);
+	}).detach();
+}
+
+static void FinishCsvView(CsvViewJob* job) {
+	int idx = FindCsvDoc(job->table.get());
+	if (idx >= 0 && g_docs[idx].csvViewSeq == job->seq) {
+		Doc& d = g_docs[idx];
+		d.csvCustomView = job->sortCol >= 0 || !job->filter.empty();
+		d.csvRows.swap(job->rows);
+		if (!d.csvCustomView) std::vector<uint32_t>().swap(d.csvRows);
+		ListView_SetItemCountEx(d.hEdit, (int)std::min<uint64_t>(CsvItemCount(d), INT_MAX), 0);
+		InvalidateRect(d.hEdit, nullptr, FALSE);
+		if (idx == g_current) UpdateStatus();
+	}
+	delete job;
+}
+
+// "Spalte=Text" filters one column (by header name), plain text matches the whole line
+static void CsvFilterPrompt(int idx) {
+	Doc& d = g_docs[idx];
+	std::wstring text = Utf8ToW(d.csvFilter);
+	if (!PromptText(g_hMain, L"Tabelle filtern (Text oder Spalte=Text)", text)) return;
+	d.csvFilterCol = SIZE_MAX; d.csvFilter = WToUtf8(text);
+	size_t eq = text.find(L'=');
+	if (eq != std::wstring::npos) {
+		std::vector<CsvField> hdr; d.csv->ParseRow(0, hdr);
+		std::wstring colName = text.substr(0, eq);
+		for (size_t c = 0; c < hdr.size(); ++c) {
+			if (lstrcmpiW(Utf8ToW(d.csv->FieldText(hdr[c])).c_str(), colName.c_str()) == 0) {
+				d.csvFilterCol = c; d.csvFilter = WToUtf8(text.substr(eq + 1));
+				break;
+			}
+		}
+	}
+	StartCsvView(idx);
+}
+
+// Hex view: custom-painted window over a HexDocument. Only the visible rows are read from the
+// mapping; typed hex digits go into the patch overlay until the document is saved.
+struct HexView {
+	HexDocument doc;
+	uint64_t top = 0;          // first visible row (16 bytes per row)
+	uint64_t caret = 0;        // byte offset
+	bool lowNibble = false;    // next digit edits the low nibble
+	std::vector<uint8_t> lastPattern;
+};
+static HFONT g_hHexFont = nullptr;
+static int g_hexCharW = 8, g_hexLineH = 16;
+static const int HEX_COL = 14, ASCII_COL = 14 + 16 * 3 + 1; // columns (in chars) of the hex and text panes
+
+static uint64_t HexVisibleRows(HWND h) {
+	RECT rc; GetClientRect(h, &rc);
+	return std::max<uint64_t>(1, (uint64_t)(rc.bottom / g_hexLineH));
+}
+static uint64_t HexMaxTop(HWND h, const HexView* hv) {
+	uint64_t rows = (hv->doc.Size() + 15) / 16, vis = HexVisibleRows(h);
+	return rows > vis ? rows - vis : 0;
+}
+// SCROLLINFO is 32-bit: rows are scaled down for very large files
+static uint64_t HexScrollScale(uint64_t maxTop) { return maxTop / 0x40000000 + 1; }
+
+static void HexUpdateScroll(HWND h, HexView* hv) {
+	uint64_t maxTop = HexMaxTop(h, hv);
+	if (hv->top > maxTop) hv->top = maxTop;
+	uint64_t scale = HexScrollScale(maxTop);
+	SCROLLINFO si{ sizeof(si) }; si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+	si.nPage = (UINT)std::max<uint64_t>(1, HexVisibleRows(h) / scale);
+	si.nMax = (int)(maxTop / scale) + (int)si.nPage - 1;
+	si.nPos = (int)(hv->top / scale);
+	SetScrollInfo(h, SB_VERT, &si, TRUE);
+}
+
+static void HexRefresh(HWND h, HexView* hv) {
+	HexUpdateScroll(h, hv);
+	InvalidateRect(h, nullptr, FALSE);
+	for (int i = 0; i < (int)g_docs.size(); ++i) if (g_docs[i].hex.get() == hv) {
+		if (g_docs[i].modified != hv->doc.Modified()) { g_docs[i].modified = hv->doc.Modified(); UpdateTabCaption(i); }
+		if (i == g_current) UpdateStatus();
+		break;
+	}
+}
+
+static void HexSetCaret(HWND h, HexView* hv, int64_t target) {
+	uint64_t size = hv->doc.Size();
+	if (size == 0) return;
+	hv->caret = target < 0 ? 0 : std::min<uint64_t>((uint64_t)target, size - 1);
+	hv->lowNibble = false;
+	uint64_t row = hv->caret / 16, vis = HexVisibleRows(h);
+	if (row < hv->top) hv->top = row;
+	else if (row >= hv->top + vis) hv->top = row - vis + 1;
+	HexRefresh(h, hv);
+}
+
+static void HexFindNext(HWND h, HexView* hv, bool skipCurrent) {
+	if (hv->lastPattern.empty()) return;
+	HCURSOR old = SetCursor(LoadCursor(NULL, IDC_WAIT));
+	uint64_t hit = hv->doc.Find(hv->lastPattern, hv->caret + (skipCurrent ? 1 : 0));
+	SetCursor(old);
+	if (hit == UINT64_MAX) { MessageBeep(MB_ICONWARNING); SendMessageW(g_hStatus, SB_SETTEXT, 0, (LPARAM)L"Bytefolge nicht gefunden"); return; }
+	HexSetCaret(h, hv, (int64_t)hit);
+}
+
+static void HexGotoPrompt(HWND h, HexView* hv) {
+	std::wstring text = L"0x";
+	if (!PromptText(g_hMain, L"Gehe zu Offset (dezimal oder 0x...)", text)) return;
+	bool isHex = text.size() > 2 && text[0] == L'0' && (text[1] == L'x' || text[1] == L'X');
+	HexSetCaret(h, hv, (int64_t)wcstoull(text.c_str() + (isHex ? 2 : 0), nullptr, isHex ? 16 : 10));
+	SetFocus(h);
+}
+
+static void HexFindPrompt(HWND h, HexView* hv) {
+	std::wstring text;
+	if (!PromptText(g_hMain, L"Bytes suchen (z.B. DE AD BE EF oder \"Text\")", text)) return;
+	std::vector<uint8_t> pattern;
+	if (!HexDocument::ParsePattern(WToUtf8(text), pattern)) { MessageBeep(MB_ICONWARNING); return; }
+	hv->lastPattern = pattern;
+	HexFindNext(h, hv, false);
+	SetFocus(h);
+}
+
+static void HexPaint(HWND h, HexView* hv) {
+	PAINTSTRUCT ps; HDC dc = BeginPaint(h, &ps);
+	RECT rc; GetClientRect(h, &rc);
+	FillRect(dc, &rc, (HBRUSH)(COLOR_WINDOW + 1));
+	HFONT oldFont = (HFONT)SelectObject(dc, g_hHexFont);
+	uint64_t vis = HexVisibleRows(h) + 1;
+	std::vector<uint8_t> buf((size_t)vis * 16);
+	size_t n = hv->doc.Read(hv->top * 16, buf.data(), buf.size());
+	wchar_t line[96];
+	for (size_t r = 0; r * 16 < n; ++r) {
+		uint64_t base = (hv->top + r) * 16;
+		size_t cnt = std::min<size_t>(16, n - r * 16);
+		const uint8_t* b = buf.data() + r * 16;
+		int len = swprintf_s(line, L"%012llX  ", (unsigned long long)base);
+		for (size_t i = 0; i < 16; ++i) len += i < cnt ? swprintf_s(line + len, 96 - len, L"%02X ", b[i]) : swprintf_s(line + len, 96 - len, L"   ");
+		line[len++] = L' ';
+		for (size_t i = 0; i < cnt; ++i) line[len++] = (b[i] >= 0x20 && b[i] < 0x7F) ? (wchar_t)b[i] : L'.';
+		int y = (int)r * g_hexLineH;
+		SetTextColor(dc, GetSysColor(COLOR_WINDOWTEXT)); SetBkColor(dc, GetSysColor(COLOR_WINDOW));
+		TextOutW(dc, 2, y, line, len);
+		// patched bytes (red) and the caret cell are drawn over the plain row
+		for (size_t i = 0; i < cnt; ++i) {
+			uint64_t off = base + i;
+			bool isCaret = off == hv->caret, patched = hv->doc.IsPatched(off);
+			if (!isCaret && !patched) continue;
+			wchar_t cell[3]; swprintf_s(cell, L"%02X", b[i]);
+			wchar_t ch = (b[i] >= 0x20 && b[i] < 0x7F) ? (wchar_t)b[i] : L'.';
+			SetTextColor(dc, isCaret ? GetSysColor(COLOR_HIGHLIGHTTEXT) : RGB(200, 0, 0));
+			SetBkColor(dc, isCaret ? GetSysColor(COLOR_HIGHLIGHT) : GetSysColor(COLOR_WINDOW));
+			TextOutW(dc, 2 + (HEX_COL + (int)i * 3) * g_hexCharW, y, cell, 2);
+			TextOutW(dc, 2 + (ASCII_COL + (int)i) * g_hexCharW, y, &ch, 1);
+		}
+	}
+	SelectObject(dc, oldFont);
+	EndPaint(h, &ps);
+}
+
+static LRESULT CALLBACK HexWndProc(HWND h, UINT msg, WPARAM w, LPARAM l) {
+	HexView* hv = (HexView*)GetWindowLongPtrW(h, GWLP_USERDATA);
+	if (!hv) return DefWindowProcW(h, msg, w, l);
+	switch (msg) {
+	case WM_PAINT: HexPaint(h, hv); return 0;
+	case WM_SIZE: HexUpdateScroll(h, hv); return 0;
+	case WM_GETDLGCODE: return DLGC_WANTARROWS | DLGC_WANTCHARS;
+	case WM_LBUTTONDOWN: {
+		SetFocus(h);
+		int col = (GET_X_LPARAM(l) - 2) / g_hexCharW;
+		uint64_t row = hv->top + (uint64_t)(GET_Y_LPARAM(l) / g_hexLineH);
+		int byteInRow = -1;
+		if (col >= HEX_COL && col < HEX_COL + 48) byteInRow = (col - HEX_COL) / 3;
+		else if (col >= ASCII_COL && col < ASCII_COL + 16) byteInRow = col - ASCII_COL;
+		if (byteInRow >= 0) HexSetCaret(h, hv, (int64_t)(row * 16 + byteInRow));
+		return 0;
+	}
+	case WM_MOUSEWHEEL: {
+		int64_t rows = -(int64_t)GET_WHEEL_DELTA_WPARAM(w) / WHEEL_DELTA * 3;
+		int64_t top = (int64_t)hv->top + rows;
+		hv->top = top < 0 ? 0 : std::min<uint64_t>((uint64_t)top, HexMaxTop(h, hv));
+		HexRefresh(h, hv);
+		return 0;
+	}
+	case WM_VSCROLL: {
+		uint64_t vis = HexVisibleRows(h), maxTop = HexMaxTop(h, hv);
+		int64_t top = (int64_t)hv->top;
+		switch (LOWORD(w)) {
+		case SB_LINEUP: top -= 1; break;
+		case SB_LINEDOWN: top += 1; break;
+		case SB_PAGEUP: top -= (int64_t)vis; break;
+		case SB_PAGEDOWN: top += (int64_t)vis; break;
+		case SB_TOP: top = 0; break;
+		case SB_BOTTOM: top = (int64_t)maxTop; break;
+		case SB_THUMBTRACK: case SB_THUMBPOSITION: {
+			SCROLLINFO si{ sizeof(si) }; si.fMask = SIF_TRACKPOS; GetScrollInfo(h, SB_VERT, &si);
+			top = (int64_t)((uint64_t)si.nTrackPos * HexScrollScale(maxTop));
+			break;
+		}
+		}
+		hv->top = top < 0 ? 0 : std::min<uint64_t>((uint64_t)top, maxTop);
+		HexRefresh(h, hv);
+		return 0;
+	}
+	case WM_KEYDOWN: {
+		bool ctrl = (GetKeyState(VK_CONTROL) & 0x8000) != 0;
+		int64_t c = (int64_t)hv->caret, page = (int64_t)HexVisibleRows(h) * 16;
+		switch (w) {
+		case VK_LEFT: HexSetCaret(h, hv, c - 1); break;
+		case VK_RIGHT: HexSetCaret(h, hv, c + 1); break;
+		case VK_UP: HexSetCaret(h, hv, c - 16); break;
+		case VK_DOWN: HexSetCaret(h, hv, c + 16); break;
+		case VK_PRIOR: HexSetCaret(h, hv, c - page); break;
+		case VK_NEXT: HexSetCaret(h, hv, c + page); break;
+		case VK_HOME: HexSetCaret(h, hv, ctrl ? 0 : c - c % 16); break;
+		case VK_END: HexSetCaret(h, hv, ctrl ? (int64_t)hv->doc.Size() - 1 : c - c % 16 + 15); break;
+		case VK_F3: HexFindNext(h, hv, true); break;
+		case 'G': if (ctrl) HexGotoPrompt(h, hv); break;
+		case 'F': if (ctrl) HexFindPrompt(h, hv); break;
+		}
+		return 0;
+	}
+	case WM_CHAR: {
+		int v = w < 0x80 ? HexDocument::HexValue((char)w) : -1;
+		if (v < 0 || hv->doc.Size() == 0 || (GetKeyState(VK_CONTROL) & 0x8000)) return 0;
+		uint8_t b = hv->doc.ByteAt(hv->caret);
+		b = hv->lowNibble ? (uint8_t)((b & 0xF0) | v) : (uint8_t)((b & 0x0F) | (v << 4));
+		hv->doc.SetByte(hv->caret, b);
+		if (hv->lowNibble) HexSetCaret(h, hv, (int64_t)hv->caret + 1);
+		else { hv->lowNibble = true; HexRefresh(h, hv); }
+		return 0;
+	}
+	}
+	return DefWindowProcW(h, msg, w, l);
+}
+
+static int CreateHexDoc(const std::wstring& path) {
+	auto hv = std::make_shared<HexView>();
+	if (!hv->doc.Open(path)) return -1;
+	static bool registered = false;
+	if (!registered) {
+		WNDCLASSEXW wc{ sizeof(wc) }; wc.lpfnWndProc = HexWndProc; wc.hInstance = g_hInst; wc.lpszClassName = L"WinNotePlusHex";
+		wc.hCursor = LoadCursor(NULL, IDC_IBEAM); wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
+		RegisterClassExW(&wc); registered = true;
+		g_hHexFont = CreateFontW(-16, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+			CLEARTYPE_QUALITY, FIXED_PITCH | FF_MODERN, L"Consolas");
+		HDC dc = GetDC(g_hMain); HFONT old = (HFONT)SelectObject(dc, g_hHexFont);
+		TEXTMETRICW tm{}; GetTextMetricsW(dc, &tm); g_hexCharW = tm.tmAveCharWidth; g_hexLineH = tm.tmHeight;
+		SelectObject(dc, old); ReleaseDC(g_hMain, dc);
+	}
+	HWND h = CreateWindowExW(0, L"WinNotePlusHex", L"", WS_CHILD | WS_VISIBLE | WS_VSCROLL, 0, 0, 0, 0, g_hTabs, nullptr, g_hInst, nullptr);
+	SetWindowLongPtrW(h, GWLP_USERDATA, (LONG_PTR)hv.get());
+	Doc d; d.hEdit = h; d.path = path; d.hex = hv;
+	int idx = AttachViewDoc(d);
+	HexUpdateScroll(h, hv.get());
+	return idx;
+}
+
+// Undo/redo: edits reaching the RichEdit through keyboard/clipboard messages are measured around the
+// default handling (selection + length before/after) and recorded as replacements in UndoHistory.
+// Every other text change (drag & drop, IME composition, ...) arrives as EN_CHANGE outside a recorded
+// edit and bumps 'generation'; the history is dropped before it is used on text it no longer matches.
+struct EditUndo {
+	UndoHistory history;
+	uint64_t generation = 0;  // EN_CHANGE count outside recorded edits
+	uint64_t seen = 0;        // generation the history matches
+	bool recording = false;   // inside EditRecorded / EditUndoRedo
+	explicit EditUndo(size_t cap) : history(cap) {}
+};
+static size_t g_undoCapMB = 64;
+
+// Formatting only (highlighting, zoom, font): EN_CHANGE is muted so it does not count as an edit.
+struct EditFormatScope {
+	HWND h; LRESULT mask;
+	explicit EditFormatScope(HWND e) : h(e), mask(SendMessageW(e, EM_SETEVENTMASK, 0, 0)) {}
+	~EditFormatScope() { SendMessageW(h, EM_SETEVENTMASK, 0, mask); }
+};
+
+static LONG EditTextLength(HWND h) {
+	GETTEXTLENGTHEX gl{ GTL_NUMCHARS | GTL_PRECISE, 1200 };
+	return (LONG)SendMessageW(h, EM_GETTEXTLENGTHEX, (WPARAM)&gl, 0);
+}
+static std::wstring EditTextRange(HWND h, LONG a, LONG b) {
+	std::wstring s; s.resize((size_t)(b - a) + 1);
+	TEXTRANGEW tr{ { a, b }, &s[0] };
+	s.resize((size_t)SendMessageW(h, EM_GETTEXTRANGE, 0, (LPARAM)&tr));
+	return s;
+}
+static std::shared_ptr<EditUndo> UndoOf(HWND h) {
+	for (auto& d : g_docs) if (d.hEdit == h) return d.undo;
+	return nullptr;
+}
+
+// Run the default handler for an editing message and record what it replaced.
+static LRESULT EditRecorded(HWND h, UINT msg, WPARAM w, LPARAM l, EditUndo& u, UndoKind kind) {
+	LONG len0 = EditTextLength(h);
+	if (u.seen != u.generation) u.history.Clear(); // text changed behind our back (drag & drop, IME, ...)
+	CHARRANGE sel; SendMessageW(h, EM_EXGETSEL, 0, (LPARAM)&sel);
+	// without a selection, delete keys remove text next to the caret (up to a word with Ctrl)
+	LONG margin = sel.cpMin == sel.cpMax && kind == UndoKind::Delete ? 256 : 0;
+	LONG winA = std::max<LONG>(0, sel.cpMin - margin), winB = std::min<LONG>(len0, sel.cpMax + margin);
+	std::wstring before = EditTextRange(h, winA, winB);
+	u.recording = true;
+	LRESULT r = DefSubclassProc(h, msg, w, l);
+	u.recording = false;
+	LONG len1 = EditTextLength(h);
+	CHARRANGE after; SendMessageW(h, EM_EXGETSEL, 0, (LPARAM)&after);
+	LONG start = std::min(sel.cpMin, after.cpMax);
+	LONG inserted = after.cpMax - start, removed = inserted + len0 - len1;
+	if (removed < 0 || start < winA || start + removed > winB) u.history.Clear();
+	else if (removed || inserted) {
+		std::wstring ins = EditTextRange(h, start, start + inserted);
+		u.history.Record((size_t)start, before.data() + (start - winA), (size_t)removed, ins.data(), ins.size(), kind);
+	}
+	u.seen = u.generation;
+	return r;
+}
+
+static void EditUndoRedo(HWND h, bool redo) {
+	std::shared_ptr<EditUndo> u = UndoOf(h);
+	if (!u) return;
+	if (u->seen != u->generation) u->history.Clear(); // positions no longer match the text
+	UndoEdit e;
+	if (!(redo ? u->history.Redo(e) : u->history.Undo(e))) { MessageBeep(0); return; }
+	const std::wstring& from = redo ? e.removed : e.inserted;
+	const std::wstring& to = redo ? e.inserted : e.removed;
+	CHARRANGE cr{ (LONG)e.pos, (LONG)(e.pos + from.size()) };
+	SendMessageW(h, EM_EXSETSEL, 0, (LPARAM)&cr);
+	u->recording = true;
+	SendMessageW(h, EM_REPLACESEL, FALSE, (LPARAM)to.c_str());
+	u->recording = false;
+	cr.cpMax = (LONG)(e.pos + to.size());
+	SendMessageW(h, EM_EXSETSEL, 0, (LPARAM)&cr);
+	SendMessageW(h, EM_SCROLLCARET, 0, 0);
+	u->seen = u->generation;
+}
+
+// EN_CHANGE from an editor (forwarded by the tab control): count changes the recorder did not make.
+static void EditChanged(HWND h) {
+	std::shared_ptr<EditUndo> u = UndoOf(h);
+	if (u && !u->recording) u->generation++;
+}
+
+// Subclass hook: true if msg was an undo command or an edit that has been recorded.
+static bool EditUndoFilter(HWND h, UINT msg, WPARAM w, LPARAM l, LRESULT& result) {
+	bool ctrl = (GetKeyState(VK_CONTROL) & 0x8000) != 0, shift = (GetKeyState(VK_SHIFT) & 0x8000) != 0;
+	switch (msg) {
+	case WM_UNDO: case EM_UNDO: EditUndoRedo(h, false); result = TRUE; return true;
+	case EM_REDO: EditUndoRedo(h, true); result = TRUE; return true;
+	case EM_CANUNDO: case EM_CANREDO: {
+		std::shared_ptr<EditUndo> u = UndoOf(h);
+		result = u && (msg == EM_CANUNDO ? u->history.CanUndo() : u->history.CanRedo());
+		return true;
+	}
+	case WM_KEYDOWN: {
+		if (ctrl && (w == 'Z' || w == 'Y')) { EditUndoRedo(h, w == 'Y' || shift); result = 0; return true; }
+		bool edit = w == VK_DELETE || w == VK_BACK || (ctrl && (w == 'V' || w == 'X')) || (shift && w == VK_INSERT);
+		if (!edit) return false;
+		break;
+	}
+	case WM_SYSKEYDOWN:
+		if (w == VK_BACK) { EditUndoRedo(h, shift); result = 0; return true; } // Alt+Backspace
+		return false;
+	case WM_CHAR:
+		if (w == 0x1A || w == 0x19) { result = 0; return true; } // Ctrl+Z / Ctrl+Y already handled
+		break;
+	case WM_IME_CHAR: case WM_PASTE: case WM_CUT: case WM_CLEAR: break;
+	default: return false;
+	}
+	std::shared_ptr<EditUndo> u = UndoOf(h);
+	if (!u) return false;
+	UndoKind kind = UndoKind::Other;
+	if (msg == WM_CHAR || msg == WM_IME_CHAR) kind = (w == VK_BACK || w == 0x7F) ? UndoKind::Delete : UndoKind::Typing;
+	else if (msg == WM_KEYDOWN && (w == VK_DELETE || w == VK_BACK) && !shift) kind = UndoKind::Delete;
+	else if (msg == WM_CLEAR) kind = UndoKind::Delete;
+	result = EditRecorded(h, msg, w, l, *u, kind);
+	return true;
+}
+
+// Opening a compressed file: CodecWorker decodes it in 1 MB pieces and queues the UTF-8 for the UI
+// thread (WM_APP_CODEC_OUTPUT), so a large .gz/.zst does not freeze the window. The tab is read-only
+// until WM_APP_CODEC_DONE; a stream that fails to decode leaves it read-only and marked damaged.
+struct CodecJob {
+	std::wstring path;
+	HWND hEdit = nullptr;
+	Compression kind = Compression::None;
+	TextQueue out;
+	std::string error;                      // set by the worker before WM_APP_CODEC_DONE
+};
+
+static void CodecWorker(CodecJob* job) {
+	CodecReader reader;
+	if (!reader.Open(job->path)) job->error = reader.Error();
+	std::vector<unsigned char> buf(1 << 20);
+	bool first = true;
+	int lastPct = -1;
+	while (job->error.empty() && !job->out.cancel) {
+		size_t n = reader.Read(buf.data(), buf.size());
+		if (n == 0) break;
+		size_t bom = first && n >= 3 && buf[0] == 0xEF && buf[1] == 0xBB && buf[2] == 0xBF ? 3 : 0;
+		first = false;
+		TextQueuePush(job->out, (const char*)buf.data() + bom, n - bom, WM_APP_CODEC_OUTPUT, (LPARAM)job);
+		int pct = reader.CompressedSize() ? (int)(reader.CompressedRead() * 100 / reader.CompressedSize()) : 100;
+		if (pct != lastPct) { lastPct = pct; PostMessageW(g_hMain, WM_APP_CODEC_PROGRESS, (WPARAM)pct, 0); }
+	}
+	if (job->error.empty() && reader.Failed()) job->error = reader.Error();
+	TextQueuePush(job->out, "", 0, WM_APP_CODEC_OUTPUT, (LPARAM)job, true);
+	PostMessageW(g_hMain, WM_APP_CODEC_DONE, 0, (LPARAM)job);
+}
+
+static void StartCodecJob(int idx, Compression kind) {
+	CodecJob* job = new CodecJob();
+	job->path = g_docs[idx].path;
+	job->hEdit = g_docs[idx].hEdit;
+	job->kind = kind;
+	g_docs[idx].loading = job;
+	SendMessageW(job->hEdit, EM_SETREADONLY, TRUE, 0);
+	std::thread(CodecWorker, job).detach();
+}
+
+static void DrainCodecOutput(CodecJob* job) {
+	if (!TextQueueTake(job->out)) return;
+	if (FindDocByEdit(job->hEdit) < 0) { TextQueueCancel(job->out); return; } // tab was closed
+	// loading is not an edit (EN_CHANGE muted); the caret stays where the user put it
+	EditFormatScope fmt(job->hEdit);
+	CHARRANGE sel; SendMessageW(job->hEdit, EM_EXGETSEL, 0, (LPARAM)&sel);
+	TextQueueDrain(job->out, job->hEdit);
+	SendMessageW(job->hEdit, EM_EXSETSEL, 0, (LPARAM)&sel);
+}
+
+static void FinishCodecJob(CodecJob* job) {
+	DrainCodecOutput(job);
+	int idx = FindDocByEdit(job->hEdit);
+	if (idx >= 0 && g_docs[idx].loading == job) {
+		g_docs[idx].loading = nullptr;
+		if (!job->error.empty()) {
+			// nur der lesbare Teil ist geladen: Speichern über die Quelle würde den Rest vernichten
+			g_docs[idx].damaged = true;
+			std::wstring msg = L"Datei konnte nicht vollständig entpackt werden:\n" + Utf8ToW(job->error) +
+				L"\n\nDer lesbare Teil ist schreibgeschützt geöffnet; \"Speichern unter\" sichert ihn in eine neue Datei.";
+			MessageBoxW(g_hMain, msg.c_str(), APP_NAME, MB_ICONERROR);
+		}
+		else {
+			SendMessageW(job->hEdit, EM_SETREADONLY, FALSE, 0);
+			g_docs[idx].compression = job->kind;
+			wchar_t buf[128]; swprintf_s(buf, L"Entpackt: %llu Bytes", (unsigned long long)job->out.bytes);
+			SendMessageW(g_hStatus, SB_SETTEXT, 0, (LPARAM)buf);
+		}
+	}
+	delete job;
+}
+
 // Create a new document/tab, optionally loading from path
 static int CreateDoc(const std::wstring& path = L"") {
+    Compression comp = path.empty() ? Compression::None : SniffCompression(path);
+    if (IsTablePath(path)) { int t = CreateCsvDoc(path); if (t >= 0) return t; }
+    else if (comp == Compression::None && !path.empty() && HexDocument::SniffBinary(path)) { int x = CreateHexDoc(path); if (x >= 0) return x; }
     // create RichEdit control
     EnsureMsftEditLoaded();
     HWND hEdit = CreateWindowExW(0, RICH_CLASS, L"",
         WS_CHILD | WS_VISIBLE | ES_MULTILINE | ES_AUTOVSCROLL | ES_AUTOHSCROLL | WS_VSCROLL | WS_HSCROLL,
         0, 0, 0, 0, g_hTabs, nullptr, g_hInst, nullptr);
     SendMessageW(hEdit, EM_SETLIMITTEXT, 0, 0x7FFFFFFF);
+    SendMessageW(hEdit, EM_SETUNDOLIMIT, 0, 0); // history is kept in d.undo instead
+    SendMessageW(hEdit, EM_SETEVENTMASK, 0, SendMessageW(hEdit, EM_GETEVENTMASK, 0, 0) | ENM_CHANGE);
 
     Doc d; d.hEdit = hEdit; d.path = path; d.modified = false; d.zoom = 100; d.isRtf = false;
+    d.undo = std::make_shared<EditUndo>(g_undoCapMB << 20);
     g_docs.push_back(d);
     int idx = (int)g_docs.size() - 1;
 
@@ -159,6 +923,8 @@ static int CreateDoc(const std::wstring& path = L"") {
 
     // hook edit notifications via subclass
     SetWindowSubclass(hEdit, [](HWND h, UINT msg, WPARAM w, LPARAM l, UINT_PTR, DWORD_PTR)->LRESULT {
+        LRESULT undoResult = 0;
+        if (EditUndoFilter(h, msg, w, l, undoResult)) return undoResult;
         if (msg == EN_CHANGE) {
             // find which doc
             for (int i = 0; i < (int)g_docs.size(); ++i) if (g_docs[i].hEdit == h) {
@@ -177,6 +943,7 @@ static int CreateDoc(const std::wstring& path = L"") {
                     z += (delta > 0) ? 10 : -10; if (z < 30) z = 30; if (z > 500) z = 500;
                     // set zoom by changing font size
                     CHARFORMAT2 cf{}; cf.cbSize = sizeof(cf); cf.dwMask = CFM_SIZE; cf.yHeight = z * 20; // approx
+                    EditFormatScope fmt(h);
                     SendMessageW(h, EM_SETCHARFORMAT, SCF_SELECTION | SCF_ALL, (LPARAM)&cf);
                     UpdateTabCaption(i);
                     break;
@@ -188,7 +955,8 @@ static int CreateDoc(const std::wstring& path = L"") {
         }, (UINT_PTR)idx + 1, 0);
 
     // load file if path provided
-    if (!path.empty()) {
+    if (!path.empty() && comp != Compression::None) StartCodecJob(idx, comp);
+    else if (!path.empty()) {
         std::vector<unsigned char> bytes; if (ReadFileAll(path, bytes)) {
             // detect rtf by extension
             wchar_t ext[_MAX_EXT] = {};
@@ -229,6 +997,24 @@ static void EnsureMsftEditLoaded() {
 static bool SaveDoc(int idx, const std::wstring& path) {
 	if (idx < 0 || idx >= (int)g_docs.size()) return false;
 	Doc& d = g_docs[idx];
+	if (d.loading) {
+		MessageBoxW(g_hMain, L"Die Datei wird noch entpackt. Bitte warten, bis sie vollständig geladen ist.", APP_NAME, MB_ICONWARNING);
+		return false;
+	}
+	if (d.damaged && path == d.path) {
+		MessageBoxW(g_hMain, L"Die Quelle ist beschädigt und wird nicht überschrieben. Bitte \"Speichern unter\" verwenden.", APP_NAME, MB_ICONWARNING);
+		return false;
+	}
+	if (d.csv) {
+		// table view is read-only: "save as" copies the source file
+		return path == d.path || CopyFileW(d.path.c_str(), path.c_str(), FALSE) != 0;
+	}
+	if (d.hex) {
+		// in place: only the patched bytes are written; otherwise a patched copy is streamed out
+		bool ok = d.hex->doc.SaveAs(path);
+		InvalidateRect(d.hEdit, nullptr, FALSE);
+		return ok;
+	}
 	if (d.isRtf || (!path.empty() && PathMatchSpecW(path.c_str(), L"*.rtf"))) {
 		// stream out rtf using sicheren Cookie
 		std::vector<unsigned char> out;
@@ -237,7 +1023,16 @@ static bool SaveDoc(int idx, const std::wstring& path) {
 		LRESULT res = SendMessageW(d.hEdit, EM_STREAMOUT, SF_RTF, (LPARAM)&es);
 		if (!res) return false; return WriteFileAll(path, out);
 	}
+	// .gz/.zst target, or saving a compressed source back to its own path
+	Compression comp = CompressionForPath(path);
+	if (comp == Compression::None && path == d.path) comp = d.compression;
+	if (comp != Compression::None) {
+		if (!CompressionAvailable(comp) || !StreamOutCompressed(d.hEdit, path, comp)) return false;
+		d.compression = comp;
+		return true;
+	}
 	else {
+		d.compression = Compression::None;
 		int len = (int)SendMessageW(d.hEdit, WM_GETTEXTLENGTH, 0, 0);
 		std::wstring w; w.resize(len); GetWindowTextW(d.hEdit, &w[0], len + 1);
 		std::string utf = WToUtf8(w);
@@ -251,7 +1046,7 @@ static bool SaveDoc(int idx, const std::wstring& path) {
 // Autosave: save each modified doc to temp as name + .autosave
 static void AutosaveAll() {
 	wchar_t tmpPath[MAX_PATH]; GetTempPathW(MAX_PATH, tmpPath);
-	for (int i = 0; i < (int)g_docs.size(); ++i) if (g_docs[i].modified) {
+	for (int i = 0; i < (int)g_docs.size(); ++i) if (g_docs[i].modified && !g_docs[i].hex) {
 		std::wstring base = g_docs[i].path.empty() ? L"untitled" : PathFindFileNameW(g_docs[i].path.c_str());
 		std::wstring safe = base;
 		for (auto& c : safe) {
@@ -269,14 +1064,147 @@ static void AutosaveAll() {
 	}
 }
 
+static void RefreshTree();
+
+// Close a tab (File > Close, or a JSON output tab whose job failed); keeps at least one document open.
+static void CloseDoc(int idx) {
+	if (idx < 0 || idx >= (int)g_docs.size()) return;
+	if (g_docs[idx].csv) g_docs[idx].csv->Cancel();
+	if (g_docs[idx].loading) TextQueueCancel(g_docs[idx].loading->out); // the job ends on WM_APP_CODEC_DONE
+	DestroyWindow(g_docs[idx].hEdit);
+	g_docs.erase(g_docs.begin() + idx);
+	TabCtrl_DeleteItem(g_hTabs, idx);
+	if (g_docs.empty()) CreateDoc();
+	g_current = std::max(0, (int)g_docs.size() - 1);
+	for (int i = 0; i < (int)g_docs.size(); ++i) ShowWindow(g_docs[i].hEdit, i == g_current ? SW_SHOW : SW_HIDE);
+	UpdateAllTabs(); RefreshTree(); UpdateStatus();
+}
+
+// JSON tools: the document is snapshotted as UTF-8 on the UI thread, the worker streams it
+// through JsonStream in 1 MB chunks and posts progress / the finished job back to g_hMain.
+// Pretty/minified output goes through a TextQueue (chunks of ~64 KB, JsonStream's sink size) that
+// the UI thread appends to the output tab on WM_APP_JSON_OUTPUT.
+struct JsonJob {
+	JsonMode mode = JsonMode::Validate;
+	HWND hSource = nullptr;                 // RichEdit of the source tab (for error caret)
+	HWND hTarget = nullptr;                 // output tab, created with the first chunk
+	std::vector<unsigned char> input;       // UTF-8 snapshot
+	TextQueue out;                          // cancel: also stops the worker
+	JsonError error = JsonError::None;
+	uint64_t errLine = 0, errColumn = 0;
+	LONG errChar = 0;                       // error position as RichEdit character index
+};
+static JsonJob* g_jsonJob = nullptr; // at most one job at a time (owned by UI thread once done)
+
+static const wchar_t* JsonErrorText(JsonError e) {
+	switch (e) {
+	case JsonError::UnexpectedChar: return L"Unerwartetes Zeichen";
+	case JsonError::UnexpectedEnd: return L"Unerwartetes Dateiende";
+	case JsonError::BadEscape: return L"Ungültige Escape-Sequenz";
+	case JsonError::BadUnicodeEscape: return L"Ungültige \\u-Sequenz";
+	case JsonError::ControlChar: return L"Steuerzeichen in String";
+	case JsonError::BadNumber: return L"Ungültige Zahl";
+	case JsonError::BadLiteral: return L"Ungültiges Literal";
+	case JsonError::BadUtf8: return L"Ungültiges UTF-8";
+	case JsonError::TooDeep: return L"Verschachtelung zu tief";
+	case JsonError::TrailingData: return L"Zusätzliche Daten nach dem Wert";
+	default: return L"OK";
+	}
+}
+
+static void JsonWorker(JsonJob* job) {
+	JsonStream js(job->mode, [job](const char* p, size_t n) { TextQueuePush(job->out, p, n, WM_APP_JSON_OUTPUT, (LPARAM)job); });
+	const size_t chunk = 1 << 20;
+	size_t total = job->input.size(), off = 0;
+	int lastPct = -1;
+	bool ok = true;
+	while (ok && off < total && !job->out.cancel) {
+		size_t n = std::min(chunk, total - off);
+		ok = js.Feed((const char*)job->input.data() + off, n);
+		off += n;
+		int pct = (int)(off * 100 / total);
+		if (pct != lastPct) { lastPct = pct; PostMessageW(g_hMain, WM_APP_JSON_PROGRESS, (WPARAM)pct, 0); }
+	}
+	if (ok && !job->out.cancel) js.Finish();
+	job->error = js.Error();
+	if (job->error != JsonError::None) {
+		job->errLine = js.ErrorLine(); job->errColumn = js.ErrorColumn();
+		// byte offset -> UTF-16 index; the control counts a paragraph break (\r\n in the stream) as one char
+		size_t end = (size_t)std::min<uint64_t>(js.ErrorOffset(), total);
+		LONG cp = 0;
+		for (size_t i = 0; i < end; ++i) {
+			unsigned char b = job->input[i];
+			if ((b & 0xC0) != 0x80) ++cp;
+			if (b >= 0xF0) ++cp; // surrogate pair
+			if (b == '\n' && i > 0 && job->input[i - 1] == '\r') --cp;
+		}
+		job->errChar = cp;
+	}
+	std::vector<unsigned char>().swap(job->input);
+	PostMessageW(g_hMain, WM_APP_JSON_DONE, 0, (LPARAM)job);
+}
+
+static void StartJsonJob(JsonMode mode) {
+	if (g_current < 0 || g_current >= (int)g_docs.size()) return;
+	if (g_jsonJob || g_docs[g_current].loading) { MessageBeep(MB_ICONWARNING); return; }
+	JsonJob* job = new JsonJob();
+	job->mode = mode;
+	job->hSource = g_docs[g_current].hEdit;
+	StreamOutUtf8(job->hSource, job->input);
+	g_jsonJob = job;
+	std::thread(JsonWorker, job).detach();
+}
+
+static void DrainJsonOutput(JsonJob* job) {
+	if (!TextQueueTake(job->out)) return;
+	int idx = job->hTarget ? FindDocByEdit(job->hTarget) : CreateDoc();
+	if (idx < 0) { TextQueueCancel(job->out); return; } // output tab was closed
+	job->hTarget = g_docs[idx].hEdit;
+	TextQueueDrain(job->out, job->hTarget);
+}
+
+static void FinishJsonJob(JsonJob* job) {
+	if (job == g_jsonJob) g_jsonJob = nullptr;
+	wchar_t buf[256];
+	if (job->out.cancel) { delete job; return; }
+	if (job->error != JsonError::None) {
+		if (job->hTarget) CloseDoc(FindDocByEdit(job->hTarget)); // partial output
+		swprintf_s(buf, L"JSON-Fehler: %s (Zeile %llu, Spalte %llu)", JsonErrorText(job->error),
+			(unsigned long long)job->errLine, (unsigned long long)job->errColumn);
+		int src = FindDocByEdit(job->hSource);
+		if (src >= 0) {
+			CHARRANGE cr{ job->errChar, job->errChar };
+			SendMessageW(job->hSource, EM_EXSETSEL, 0, (LPARAM)&cr);
+			SendMessageW(job->hSource, EM_SCROLLCARET, 0, 0);
+		}
+	}
+	else if (job->mode == JsonMode::Validate) {
+		swprintf_s(buf, L"JSON gültig");
+	}
+	else {
+		DrainJsonOutput(job);
+		int idx = job->hTarget ? FindDocByEdit(job->hTarget) : CreateDoc(); // empty output: still a tab
+		if (idx >= 0) {
+			CHARRANGE top{ 0, 0 };
+			SendMessageW(g_docs[idx].hEdit, EM_EXSETSEL, 0, (LPARAM)&top);
+			SendMessageW(g_docs[idx].hEdit, EM_SCROLLCARET, 0, 0);
+			g_docs[idx].modified = true; UpdateTabCaption(idx); RefreshTree();
+		}
+		swprintf_s(buf, L"JSON %s (%llu Bytes)", job->mode == JsonMode::Pretty ? L"formatiert" : L"minimiert", (unsigned long long)job->out.bytes);
+	}
+	SendMessageW(g_hStatus, SB_SETTEXT, 0, (LPARAM)buf);
+	delete job;
+}
+
 // Simple syntax highlighting (inefficient but illustrative)
 static std::vector<std::wstring> cppKeywords = { L"int",L"float",L"double",L"char",L"if",L"else",L"for",L"while",L"return",L"void",L"class",L"struct",L"public",L"private",L"protected",L"include",L"using",L"namespace",L"std" };
 static std::vector<std::wstring> htmlKeywords = { L"html",L"head",L"body",L"div",L"span",L"script",L"style",L"a",L"img",L"title" };
 
 // Vollständig überarbeitete Highlight-Funktion (korrekte Parsing-Logik)
 static void ApplyHighlightingToDoc(int idx) {
-	if (idx < 0 || idx >= (int)g_docs.size()) return;
+	if (idx < 0 || idx >= (int)g_docs.size() || g_docs[idx].csv || g_docs[idx].hex) return;
 	HWND h = g_docs[idx].hEdit;
+	EditFormatScope fmt(h);
 	int len = (int)SendMessageW(h, WM_GETTEXTLENGTH, 0, 0);
 	std::wstring text; text.resize(len); GetWindowTextW(h, &text[0], len + 1);
 
@@ -378,10 +1306,27 @@ static HMENU BuildMenu() {
     AppendMenuW(f, MF_STRING, ID_FILE_OPEN, L"&�ffnen...	Ctrl+O");
     AppendMenuW(f, MF_STRING, ID_FILE_SAVE, L"&Speichern	Ctrl+S");
     AppendMenuW(f, MF_STRING, ID_FILE_SAVEAS, L"Speichern &unter...");
+    AppendMenuW(f, MF_STRING, ID_FILE_COMPRESSION, L"&Komprimierungsstufe (.gz/.zst)...");
     AppendMenuW(f, MF_SEPARATOR, 0, nullptr);
     AppendMenuW(f, MF_STRING, ID_FILE_CLOSE, L"&Schlie�en");
     AppendMenuW(m, MF_POPUP, (UINT_PTR)f, L"&Datei");
-    HMENU v = CreatePopupMenu(); AppendMenuW(v, MF_STRING, ID_VIEW_FONT, L"Schriftart..."); AppendMenuW(m, MF_POPUP, (UINT_PTR)v, L"&Ansicht");
+    HMENU e = CreatePopupMenu();
+    AppendMenuW(e, MF_STRING, ID_EDIT_UNDO, L"&Rückgängig	Ctrl+Z");
+    AppendMenuW(e, MF_STRING, ID_EDIT_REDO, L"&Wiederholen	Ctrl+Y");
+    AppendMenuW(e, MF_SEPARATOR, 0, nullptr);
+    AppendMenuW(e, MF_STRING, ID_EDIT_UNDO_LIMIT, L"Speicherlimit für &Verlauf...");
+    AppendMenuW(m, MF_POPUP, (UINT_PTR)e, L"&Bearbeiten");
+    HMENU v = CreatePopupMenu(); AppendMenuW(v, MF_STRING, ID_VIEW_FONT, L"Schriftart..."); AppendMenuW(v, MF_STRING, ID_VIEW_CSV_FILTER, L"Tabelle &filtern...");
+    AppendMenuW(v, MF_SEPARATOR, 0, nullptr);
+    AppendMenuW(v, MF_STRING, ID_VIEW_HEX_GOTO, L"Hex: &Gehe zu Offset...	Ctrl+G");
+    AppendMenuW(v, MF_STRING, ID_VIEW_HEX_FIND, L"Hex: &Bytes suchen...	Ctrl+F");
+    AppendMenuW(v, MF_STRING, ID_VIEW_HEX_FINDNEXT, L"Hex: &Weitersuchen	F3");
+    AppendMenuW(m, MF_POPUP, (UINT_PTR)v, L"&Ansicht");
+    HMENU j = CreatePopupMenu();
+    AppendMenuW(j, MF_STRING, ID_JSON_VALIDATE, L"JSON &prüfen");
+    AppendMenuW(j, MF_STRING, ID_JSON_PRETTY, L"JSON &formatieren");
+    AppendMenuW(j, MF_STRING, ID_JSON_MINIFY, L"JSON &minimieren");
+    AppendMenuW(m, MF_POPUP, (UINT_PTR)j, L"&JSON");
     return m;
 }
 
@@ -408,6 +1353,19 @@ static void RefreshTree() {
 // Status update: line/col
 static void UpdateStatus() {
     if (g_current < 0 || g_current >= (int)g_docs.size()) return;
+    if (const CsvTable* t = g_docs[g_current].csv.get()) {
+        int pct = t->FileSize() ? (int)(t->BytesIndexed() * 100 / t->FileSize()) : 100;
+        wchar_t buf[256]; swprintf_s(buf, L"%s — Zeilen: %llu | Spalten: %zu | Index: %d %%", APP_NAME,
+            (unsigned long long)CsvItemCount(g_docs[g_current]), t->ColumnCount(), pct);
+        SendMessageW(g_hStatus, SB_SETTEXT, 0, (LPARAM)buf);
+        return;
+    }
+    if (const HexView* hv = g_docs[g_current].hex.get()) {
+        wchar_t buf[256]; swprintf_s(buf, L"%s — Offset: 0x%llX (%llu) | Größe: %llu Bytes | Änderungen: %zu", APP_NAME,
+            (unsigned long long)hv->caret, (unsigned long long)hv->caret, (unsigned long long)hv->doc.Size(), hv->doc.PatchCount());
+        SendMessageW(g_hStatus, SB_SETTEXT, 0, (LPARAM)buf);
+        return;
+    }
     HWND h = g_docs[g_current].hEdit; int len = (int)SendMessageW(h, WM_GETTEXTLENGTH, 0, 0);
     DWORD cp = (DWORD)SendMessageW(h, EM_GETSEL, 0, 0);
     DWORD line = (DWORD)SendMessageW(h, EM_LINEFROMCHAR, cp, 0);
@@ -429,6 +1387,12 @@ static LRESULT CALLBACK MainWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM l
             // Tab control (we'll fake the tab headers above the editors by reserving header area)
             g_hTabs = CreateWindowExW(0, WC_TABCONTROLW, L"",
                 WS_CHILD | WS_VISIBLE | TCS_TABS, 0, 0, 0, 0, hWnd, (HMENU)ID_TABCONTROL, g_hInst, nullptr);
+            // tab pages (editors, table views) are children of the tab control: forward their notifications
+            SetWindowSubclass(g_hTabs, [](HWND h, UINT msg, WPARAM w, LPARAM l, UINT_PTR, DWORD_PTR)->LRESULT {
+                if (msg == WM_NOTIFY && ((LPNMHDR)l)->hwndFrom != h) return SendMessageW(GetParent(h), msg, w, l);
+                if (msg == WM_COMMAND && HIWORD(w) == EN_CHANGE) { EditChanged((HWND)l); return 0; }
+                return DefSubclassProc(h, msg, w, l);
+                }, 1, 0);
             // create initial doc
             CreateDoc(); RefreshTree();
             SetTimer(hWnd, ID_TIMER_AUTOSAVE, 60000, NULL); // 60s auto save
@@ -461,33 +1425,74 @@ static LRESULT CALLBACK MainWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM l
                 }
                 break;
             }
-            case ID_FILE_CLOSE: {
-                if (g_current >= 0) {
-                    // close tab
-                    DestroyWindow(g_docs[g_current].hEdit);
-                    g_docs.erase(g_docs.begin() + g_current);
-                    TabCtrl_DeleteItem(g_hTabs, g_current);
-                    if (g_docs.empty()) CreateDoc();
-                    g_current = std::max(0, (int)g_docs.size() - 1);
-                    for (int i = 0; i < (int)g_docs.size(); ++i) ShowWindow(g_docs[i].hEdit, i == g_current ? SW_SHOW : SW_HIDE);
-                    UpdateAllTabs(); RefreshTree(); UpdateStatus();
+            case ID_EDIT_UNDO: case ID_EDIT_REDO:
+                if (g_current >= 0 && g_current < (int)g_docs.size() && g_docs[g_current].undo)
+                    EditUndoRedo(g_docs[g_current].hEdit, LOWORD(wParam) == ID_EDIT_REDO);
+                break;
+            case ID_EDIT_UNDO_LIMIT: {
+                std::wstring text = std::to_wstring(g_undoCapMB);
+                if (PromptText(hWnd, L"Speicherlimit je Tab in MB", text)) {
+                    g_undoCapMB = (size_t)std::max(1, _wtoi(text.c_str()));
+                    for (auto& d : g_docs) if (d.undo) d.undo->history.SetMemoryCap(g_undoCapMB << 20);
                 }
                 break;
             }
+            case ID_FILE_COMPRESSION: {
+                std::wstring text = std::to_wstring(g_compressLevel);
+                if (PromptText(hWnd, L"Stufe (0 = Standard, zstd 1-19, gzip 1-9)", text))
+                    g_compressLevel = std::max(0, std::min(19, _wtoi(text.c_str())));
+                break;
+            }
+            case ID_FILE_CLOSE: {
+                if (g_current >= 0) CloseDoc(g_current);
+                break;
+            }
             case ID_VIEW_FONT: {
                 if (g_current >= 0) {
                     CHOOSEFONTW cf{}; LOGFONTW lf{}; GetObjectW((HFONT)GetStockObject(DEFAULT_GUI_FONT), sizeof(lf), &lf);
                     cf.lStructSize = sizeof(cf); cf.hwndOwner = hWnd; cf.lpLogFont = &lf; cf.Flags = CF_SCREENFONTS | CF_EFFECTS;
                     if (ChooseFontW(&cf)) {
                         CHARFORMAT2 chf{}; chf.cbSize = sizeof(chf); chf.dwMask = CFM_FACE | CFM_SIZE; wcscpy_s(chf.szFaceName, lf.lfFaceName); chf.yHeight = abs(lf.lfHeight) * 20;
+                        EditFormatScope fmt(g_docs[g_current].hEdit);
                         SendMessageW(g_docs[g_current].hEdit, EM_SETCHARFORMAT, SCF_ALL, (LPARAM)&chf);
                     }
                 }
                 break;
             }
+            case ID_VIEW_CSV_FILTER: {
+                if (g_current >= 0 && g_current < (int)g_docs.size() && g_docs[g_current].csv) CsvFilterPrompt(g_current);
+                break;
+            }
+            case ID_VIEW_HEX_GOTO: case ID_VIEW_HEX_FIND: case ID_VIEW_HEX_FINDNEXT: {
+                if (g_current < 0 || g_current >= (int)g_docs.size() || !g_docs[g_current].hex) break;
+                HWND hh = g_docs[g_current].hEdit; HexView* hv = g_docs[g_current].hex.get();
+                if (LOWORD(wParam) == ID_VIEW_HEX_GOTO) HexGotoPrompt(hh, hv);
+                else if (LOWORD(wParam) == ID_VIEW_HEX_FIND) HexFindPrompt(hh, hv);
+                else HexFindNext(hh, hv, true);
+                break;
+            }
+            case ID_JSON_VALIDATE: StartJsonJob(JsonMode::Validate); break;
+            case ID_JSON_PRETTY: StartJsonJob(JsonMode::Pretty); break;
+            case ID_JSON_MINIFY: StartJsonJob(JsonMode::Minify); break;
             }
             break;
         }
+        case WM_APP_JSON_PROGRESS: {
+            wchar_t buf[64]; swprintf_s(buf, L"JSON: %d %%", (int)wParam);
+            SendMessageW(g_hStatus, SB_SETTEXT, 0, (LPARAM)buf);
+            return 0;
+        }
+        case WM_APP_JSON_OUTPUT: DrainJsonOutput((JsonJob*)lParam); return 0;
+        case WM_APP_JSON_DONE: FinishJsonJob((JsonJob*)lParam); return 0;
+        case WM_APP_CSV_PROGRESS: CsvProgress((const CsvTable*)lParam); return 0;
+        case WM_APP_CSV_VIEW: FinishCsvView((CsvViewJob*)lParam); return 0;
+        case WM_APP_CODEC_PROGRESS: {
+            wchar_t buf[64]; swprintf_s(buf, L"Entpacke... %d %%", (int)wParam);
+            SendMessageW(g_hStatus, SB_SETTEXT, 0, (LPARAM)buf);
+            return 0;
+        }
+        case WM_APP_CODEC_OUTPUT: DrainCodecOutput((CodecJob*)lParam); return 0;
+        case WM_APP_CODEC_DONE: FinishCodecJob((CodecJob*)lParam); return 0;
         case WM_NOTIFY: {
             if (((LPNMHDR)lParam)->hwndFrom == g_hTabs) {
                 if (((LPNMHDR)lParam)->code == TCN_SELCHANGE) {
@@ -505,6 +1510,19 @@ static LRESULT CALLBACK MainWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM l
                     if (idx >= 0 && idx < (int)g_docs.size()) { TabCtrl_SetCurSel(g_hTabs, idx); SendMessageW(hWnd, WM_NOTIFY, 0, 0); }
                 }
             }
+            else {
+                // table views
+                for (int i = 0; i < (int)g_docs.size(); ++i) if (g_docs[i].csv && g_docs[i].hEdit == ((LPNMHDR)lParam)->hwndFrom) {
+                    if (((LPNMHDR)lParam)->code == LVN_GETDISPINFOW) CsvGetDispInfo(g_docs[i], (NMLVDISPINFOW*)lParam);
+                    else if (((LPNMHDR)lParam)->code == LVN_COLUMNCLICK) {
+                        int col = ((NMLISTVIEW*)lParam)->iSubItem;
+                        g_docs[i].csvSortAsc = g_docs[i].csvSortCol == col ? !g_docs[i].csvSortAsc : true;
+                        g_docs[i].csvSortCol = col;
+                        StartCsvView(i);
+                    }
+                    break;
+                }
+            }
             break;
         }
         case WM_TIMER: {
@@ -519,7 +1537,10 @@ static LRESULT CALLBACK MainWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM l
             }
             break;
         }
-        case WM_DESTROY: PostQuitMessage(0); return 0;
+        case WM_DESTROY:
+            if (g_jsonJob) TextQueueCancel(g_jsonJob->out);
+            for (auto& d : g_docs) if (d.loading) TextQueueCancel(d.loading->out);
+            PostQuitMessage(0); return 0;
         case WM_SETFOCUS: SetFocus(g_hTabs); return 0;
         case WM_MOUSEACTIVATE: return MA_ACTIVATE;
         }